@@ -28,6 +28,19 @@ typedef enum _GPU_CSC_FORMULA{          /* different formula to choose */
     GPU_CSC_FORMULA_FORCE_UINT  =   0xFFFFFFFF
 }GPU_CSC_FORMULA;
 
+/*
+    Conversion context: a formula and its coefficient tables, filled once by
+    gpu_csc_InitContext. The _ex entry points only read it, so threads may
+    convert with their own contexts (and formulas) at the same time.
+    The layout is shared with the NEON code, do not reorder the fields.
+*/
+typedef struct _GPU_CSC_CONTEXT{
+    GPU_CSC_FORMULA formula;
+    int             rgbYuv[5];          /* fixed-point coefficients, Q16                  */
+    short           rgbYuvQ10[6];       /* fixed-point coefficients, Q10, 1 entry padding */
+    short           rgbYuvGC[12];       /* integer approximated coefficients              */
+}GPU_CSC_CONTEXT;
+
 /*check if the compiler is of C++*/
 #ifdef __cplusplus
 extern "C" {
@@ -55,8 +68,80 @@ void gpu_csc_RGBToNV12(const unsigned char* pSrc, GCUint srcStride,
                        unsigned char* pDst[2], GCUint dstStride[2],
                        GCUint width, GCUint height);
 
+/* selects the formula of the default context used by the functions above */
 void gpu_csc_ChooseFormula(GPU_CSC_FORMULA formula);
 
+/* returns GCU_FALSE and leaves pCtx untouched for an unknown formula */
+GCUbool gpu_csc_InitContext(GPU_CSC_CONTEXT* pCtx, GPU_CSC_FORMULA formula);
+
+void gpu_csc_ARGBToI420_ex(const unsigned char* pSrc, GCUint srcStride,
+                           unsigned char* pDst[3], GCUint dstStride[3],
+                           GCUint width, GCUint height, const GPU_CSC_CONTEXT* pCtx);
+
+void gpu_csc_ARGBToUYVY_ex(const unsigned char* pSrc, GCUint srcStride,
+                           unsigned char* pDst, GCUint dstStride,
+                           GCUint width, GCUint height, const GPU_CSC_CONTEXT* pCtx);
+
+void gpu_csc_ARGBToNV21_ex(const unsigned char* pSrc, GCUint srcStride,
+                           unsigned char* pDst[2], GCUint dstStride[2],
+                           GCUint width, GCUint height, const GPU_CSC_CONTEXT* pCtx);
+
+void gpu_csc_ARGBToNV12_ex(const unsigned char* pSrc, GCUint srcStride,
+                           unsigned char* pDst[2], GCUint dstStride[2],
+                           GCUint width, GCUint height, const GPU_CSC_CONTEXT* pCtx);
+
+void gpu_csc_RGBToNV12_ex(const unsigned char* pSrc, GCUint srcStride,
+                          unsigned char* pDst[2], GCUint dstStride[2],
+                          GCUint width, GCUint height, const GPU_CSC_CONTEXT* pCtx);
+
+/*
+    Band parallel versions of the conversions above: the frame is split into
+    horizontal bands starting on even rows and converted on a persistent
+    worker pool, the call returns when all bands are done.
+*/
+void gpu_csc_SetBandCount(GCUint count);    /* 0 (default) means one band per online CPU */
+GCUint gpu_csc_GetBandCount(void);
+
+void gpu_csc_ARGBToI420_MT(const unsigned char* pSrc, GCUint srcStride,
+                           unsigned char* pDst[3], GCUint dstStride[3],
+                           GCUint width, GCUint height);
+
+void gpu_csc_ARGBToUYVY_MT(const unsigned char* pSrc, GCUint srcStride,
+                           unsigned char* pDst, GCUint dstStride,
+                           GCUint width, GCUint height);
+
+void gpu_csc_ARGBToNV21_MT(const unsigned char* pSrc, GCUint srcStride,
+                           unsigned char* pDst[2], GCUint dstStride[2],
+                           GCUint width, GCUint height);
+
+void gpu_csc_ARGBToNV12_MT(const unsigned char* pSrc, GCUint srcStride,
+                           unsigned char* pDst[2], GCUint dstStride[2],
+                           GCUint width, GCUint height);
+
+void gpu_csc_RGBToNV12_MT(const unsigned char* pSrc, GCUint srcStride,
+                          unsigned char* pDst[2], GCUint dstStride[2],
+                          GCUint width, GCUint height);
+
+void gpu_csc_ARGBToI420_MT_ex(const unsigned char* pSrc, GCUint srcStride,
+                              unsigned char* pDst[3], GCUint dstStride[3],
+                              GCUint width, GCUint height, const GPU_CSC_CONTEXT* pCtx);
+
+void gpu_csc_ARGBToUYVY_MT_ex(const unsigned char* pSrc, GCUint srcStride,
+                              unsigned char* pDst, GCUint dstStride,
+                              GCUint width, GCUint height, const GPU_CSC_CONTEXT* pCtx);
+
+void gpu_csc_ARGBToNV21_MT_ex(const unsigned char* pSrc, GCUint srcStride,
+                              unsigned char* pDst[2], GCUint dstStride[2],
+                              GCUint width, GCUint height, const GPU_CSC_CONTEXT* pCtx);
+
+void gpu_csc_ARGBToNV12_MT_ex(const unsigned char* pSrc, GCUint srcStride,
+                              unsigned char* pDst[2], GCUint dstStride[2],
+                              GCUint width, GCUint height, const GPU_CSC_CONTEXT* pCtx);
+
+void gpu_csc_RGBToNV12_MT_ex(const unsigned char* pSrc, GCUint srcStride,
+                             unsigned char* pDst[2], GCUint dstStride[2],
+                             GCUint width, GCUint height, const GPU_CSC_CONTEXT* pCtx);
+
 /*check if the compiler is of C++*/
 #ifdef __cplusplus
 }
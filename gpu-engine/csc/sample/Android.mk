@@ -93,3 +93,50 @@ LOCAL_MODULE := sample_ARGBToYUV4
 LOCAL_MODULE_TAGS := samples
 include $(BUILD_EXECUTABLE)
 
+
+include $(CLEAR_VARS)
+LOCAL_C_INCLUDES := \
+    $(LOCAL_PATH)/../include \
+	vendor/marvell/generic/graphics/user/include \
+	vendor/marvell/generic/graphics/include \
+	vendor/marvell/generic/graphics \
+	vendor/marvell/generic/graphics/user
+
+LOCAL_SRC_FILES := \
+	sample_ARGBToYUV_MT.c
+
+LOCAL_SHARED_LIBRARIES := \
+	libgpucsc	\
+	libgcu  \
+	libcutils	\
+
+LOCAL_MODULE_PATH := $(LOCAL_PATH)
+LOCAL_MODULE := sample_ARGBToYUV_MT
+LOCAL_MODULE_TAGS := samples
+include $(BUILD_EXECUTABLE)
+
+ifneq ($(filter x86 x86_64,$(TARGET_ARCH)),)
+include $(CLEAR_VARS)
+LOCAL_C_INCLUDES := \
+    $(LOCAL_PATH)/../include \
+    $(LOCAL_PATH)/../source \
+	vendor/marvell/generic/graphics/user/include \
+	vendor/marvell/generic/graphics/include \
+	vendor/marvell/generic/graphics \
+	vendor/marvell/generic/graphics/user
+
+LOCAL_SRC_FILES := \
+	test_ARGBToYUV_x86.c
+
+LOCAL_CFLAGS += -DGPU_CSC_X86_SIMD
+
+LOCAL_SHARED_LIBRARIES := \
+	libgpucsc	\
+	libgcu  \
+	libcutils	\
+
+LOCAL_MODULE_PATH := $(LOCAL_PATH)
+LOCAL_MODULE := test_ARGBToYUV_x86
+LOCAL_MODULE_TAGS := samples
+include $(BUILD_EXECUTABLE)
+endif
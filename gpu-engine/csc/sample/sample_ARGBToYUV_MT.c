@@ -0,0 +1,144 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "gpu_csc.h"
+
+typedef unsigned long long  MVU64;
+MVU64 GetTickCountMicroSec()
+{
+    struct timeval g_tv;
+    struct timezone g_tz;
+    gettimeofday(&g_tv, &g_tz);
+    return g_tv.tv_sec * 1000000 + g_tv.tv_usec;
+}
+int PERF_LOOP = 50;
+
+//This case measures the scaling of the band parallel csc:
+//ARGB8888 -> NV12 and ARGB8888 -> I420 with 1/2/4/8 bands at 720p/1080p/4K,
+//and checks every band count gives the same output as the single-threaded call
+
+static const int sizes[][2] = {
+    {1280,  720},
+    {1920, 1080},
+    {3840, 2160}
+};
+
+static const int bandCounts[] = {1, 2, 4, 8};
+
+int main(int argc, char** argv)
+{
+    int s, b, p;
+    int errors = 0;
+
+    if(argc > 1)
+    {
+        PERF_LOOP = atoi(argv[1]);
+    }
+
+    for(s = 0;  s < (int)(sizeof(sizes) / sizeof(sizes[0]));  s++)
+    {
+        int width  = sizes[s][0];
+        int height = sizes[s][1];
+        unsigned char* pSrc = (unsigned char*)malloc(width * height * 4);
+        unsigned char* pRef = (unsigned char*)malloc(width * height * 3 / 2);
+        unsigned char* pOut = (unsigned char*)malloc(width * height * 3 / 2);
+        unsigned char* pDst[3];
+        GCUint dstStride[3];
+        MVU64 base = 0;
+        int i;
+
+        if(pSrc == NULL || pRef == NULL || pOut == NULL)
+        {
+            printf("not enough memory for %dx%d\n", width, height);
+            free(pSrc);
+            free(pRef);
+            free(pOut);
+            continue;
+        }
+        for(i = 0;  i < width * height * 4;  i++)
+        {
+            pSrc[i] = (unsigned char)rand();
+        }
+
+        pDst[0]      = pRef;
+        pDst[1]      = pRef + width * height;
+        dstStride[0] = width;
+        dstStride[1] = width;
+        gpu_csc_ARGBToNV12(pSrc, width * 4, pDst, dstStride, width, height);
+
+        for(b = 0;  b < (int)(sizeof(bandCounts) / sizeof(bandCounts[0]));  b++)
+        {
+            MVU64 start, end;
+
+            gpu_csc_SetBandCount(bandCounts[b]);
+            pDst[0] = pOut;
+            pDst[1] = pOut + width * height;
+            memset(pOut, 0, width * height * 3 / 2);
+
+            start = GetTickCountMicroSec();
+            for(p = 0;  p < PERF_LOOP;  p++)
+            {
+                gpu_csc_ARGBToNV12_MT(pSrc, width * 4, pDst, dstStride, width, height);
+            }
+            end = GetTickCountMicroSec();
+            if(b == 0)
+            {
+                base = end - start;
+            }
+
+            if(memcmp(pRef, pOut, width * height * 3 / 2))
+            {
+                printf(" # NV12 %dx%d %d bands: output differs from single-threaded csc\n", width, height, bandCounts[b]);
+                errors++;
+            }
+            printf(" # NV12 %4dx%4d %d bands: \t %.2f ms/frame \t x%.2f\n", width, height, bandCounts[b],
+                   (float)(end - start) / PERF_LOOP / 1000, (float)base / (end - start));
+        }
+
+        pDst[0]      = pRef;
+        pDst[1]      = pRef + width * height;
+        pDst[2]      = pRef + width * height * 5 / 4;
+        dstStride[1] = width / 2;
+        dstStride[2] = width / 2;
+        gpu_csc_ARGBToI420(pSrc, width * 4, pDst, dstStride, width, height);
+
+        for(b = 0;  b < (int)(sizeof(bandCounts) / sizeof(bandCounts[0]));  b++)
+        {
+            MVU64 start, end;
+
+            gpu_csc_SetBandCount(bandCounts[b]);
+            pDst[0] = pOut;
+            pDst[1] = pOut + width * height;
+            pDst[2] = pOut + width * height * 5 / 4;
+            memset(pOut, 0, width * height * 3 / 2);
+
+            start = GetTickCountMicroSec();
+            for(p = 0;  p < PERF_LOOP;  p++)
+            {
+                gpu_csc_ARGBToI420_MT(pSrc, width * 4, pDst, dstStride, width, height);
+            }
+            end = GetTickCountMicroSec();
+            if(b == 0)
+            {
+                base = end - start;
+            }
+
+            if(memcmp(pRef, pOut, width * height * 3 / 2))
+            {
+                printf(" # I420 %dx%d %d bands: output differs from single-threaded csc\n", width, height, bandCounts[b]);
+                errors++;
+            }
+            printf(" # I420 %4dx%4d %d bands: \t %.2f ms/frame \t x%.2f\n", width, height, bandCounts[b],
+                   (float)(end - start) / PERF_LOOP / 1000, (float)base / (end - start));
+        }
+
+        free(pSrc);
+        free(pRef);
+        free(pOut);
+    }
+    gpu_csc_SetBandCount(0);
+
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,168 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ARGB8888ToYUV.h"
+
+//This case checks the x86 SSE4.1/AVX2 backends against the C path:
+//random images, odd widths/heights and padded strides, every formula,
+//all 5 entry points, the outputs must be bit-exact.
+
+#define MAX_WIDTH   161
+#define MAX_HEIGHT  67
+#define PAD         37
+#define LOOPS       200
+
+typedef enum{
+    CASE_I420,
+    CASE_UYVY,
+    CASE_NV21,
+    CASE_NV12,
+    CASE_RGB565_NV12,
+    CASE_NUM
+}TEST_CASE;
+
+static const char* caseName[CASE_NUM] = {"ARGBToI420", "ARGBToUYVY", "ARGBToNV21", "ARGBToNV12", "RGBToNV12"};
+
+static const GPU_CSC_FORMULA formulas[] = {
+    GPU_CSC_FORMULA_BT601_GC,
+    GPU_CSC_FORMULA_BT709_GC,
+    GPU_CSC_FORMULA_BT601,
+    GPU_CSC_FORMULA_BT709,
+    GPU_CSC_FORMULA_TRADITIONAL
+};
+
+typedef struct{
+    Ipp8u* plane[3];
+    int    step[3];
+}TEST_DST;
+
+static Ipp8u srcBuf[(MAX_WIDTH * 4 + PAD) * MAX_HEIGHT];
+static Ipp8u dstBuf[3][3][((MAX_WIDTH + 1) * 2 + PAD) * MAX_HEIGHT];
+
+static void setupDst(TEST_DST* dst, TEST_CASE c, int width)
+{
+    memset(dst, 0, sizeof(*dst));
+    dst->step[0] = (c == CASE_UYVY ? ((width + 1) & ~1) * 2 : width) + rand() % PAD;
+    if(c == CASE_I420)
+    {
+        dst->step[1] = (width + 1) / 2 + rand() % PAD;
+        dst->step[2] = dst->step[1];
+    }
+    else if(c != CASE_UYVY)
+    {
+        dst->step[1] = ((width + 1) & ~1) + rand() % PAD;
+    }
+}
+
+static void runCase(TEST_CASE c, int backend, const Ipp8u* src, int srcStep,
+                    TEST_DST* dst, int width, int height, const GPU_CSC_CONTEXT* ctx)
+{
+    switch(c)
+    {
+        case CASE_I420:
+            if(backend == 0) gpu_csc_ARGBToI420_C(src, srcStep, dst->plane, dst->step, width, height, ctx);
+            if(backend == 1) gpu_csc_ARGBToI420_SSE41(src, srcStep, dst->plane, dst->step, width, height, ctx);
+            if(backend == 2) gpu_csc_ARGBToI420_AVX2(src, srcStep, dst->plane, dst->step, width, height, ctx);
+            break;
+        case CASE_UYVY:
+            if(backend == 0) gpu_csc_ARGBToUYVY_C(src, srcStep, dst->plane[0], dst->step[0], width, height, ctx);
+            if(backend == 1) gpu_csc_ARGBToUYVY_SSE41(src, srcStep, dst->plane[0], dst->step[0], width, height, ctx);
+            if(backend == 2) gpu_csc_ARGBToUYVY_AVX2(src, srcStep, dst->plane[0], dst->step[0], width, height, ctx);
+            break;
+        case CASE_NV21:
+            if(backend == 0) gpu_csc_ARGBToNV21_C(src, srcStep, dst->plane, dst->step, width, height, ctx);
+            if(backend == 1) gpu_csc_ARGBToNV21_SSE41(src, srcStep, dst->plane, dst->step, width, height, ctx);
+            if(backend == 2) gpu_csc_ARGBToNV21_AVX2(src, srcStep, dst->plane, dst->step, width, height, ctx);
+            break;
+        case CASE_NV12:
+            if(backend == 0) gpu_csc_ARGBToNV12_C(src, srcStep, dst->plane, dst->step, width, height, ctx);
+            if(backend == 1) gpu_csc_ARGBToNV12_SSE41(src, srcStep, dst->plane, dst->step, width, height, ctx);
+            if(backend == 2) gpu_csc_ARGBToNV12_AVX2(src, srcStep, dst->plane, dst->step, width, height, ctx);
+            break;
+        case CASE_RGB565_NV12:
+            if(backend == 0) gpu_csc_RGBToNV12_C(src, srcStep, dst->plane, dst->step, width, height, ctx);
+            if(backend == 1) gpu_csc_RGBToNV12_SSE41(src, srcStep, dst->plane, dst->step, width, height, ctx);
+            if(backend == 2) gpu_csc_RGBToNV12_AVX2(src, srcStep, dst->plane, dst->step, width, height, ctx);
+            break;
+        default:
+            break;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    static const char* backendName[3] = {"C", "SSE4.1", "AVX2"};
+    Ipp32u features = gpu_csc_GetX86Features();
+    int enabled[3];
+    int failures = 0;
+    int checks = 0;
+    int f, c, loop, b, i;
+
+    enabled[0] = 1;
+    enabled[1] = (features & GPU_CSC_X86_SSE41) != 0;
+    enabled[2] = (features & GPU_CSC_X86_AVX2) != 0;
+    printf("SSE4.1: %s, AVX2: %s\n", enabled[1] ? "yes" : "no", enabled[2] ? "yes" : "no");
+
+    srand(argc > 1 ? atoi(argv[1]) : 1);
+    for(i = 0;  i < (int)sizeof(srcBuf);  i++)
+    {
+        srcBuf[i] = (Ipp8u)rand();
+    }
+
+    for(f = 0;  f < (int)(sizeof(formulas) / sizeof(formulas[0]));  f++)
+    {
+        GPU_CSC_CONTEXT ctx;
+
+        gpu_csc_InitContext(&ctx, formulas[f]);
+        for(c = 0;  c < CASE_NUM;  c++)
+        {
+            for(loop = 0;  loop < LOOPS;  loop++)
+            {
+                int width   = 1 + rand() % MAX_WIDTH;
+                int height  = 1 + rand() % MAX_HEIGHT;
+                int bpp     = (c == CASE_RGB565_NV12) ? 2 : 4;
+                int srcStep = (width * bpp + rand() % PAD) & ~(bpp - 1);
+                TEST_DST dst[3];
+
+                setupDst(&dst[0], (TEST_CASE)c, width);
+                for(b = 0;  b < 3;  b++)
+                {
+                    /* same strides for every backend, poisoned padding */
+                    dst[b] = dst[0];
+                    for(i = 0;  i < 3;  i++)
+                    {
+                        dst[b].plane[i] = dstBuf[b][i];
+                        memset(dst[b].plane[i], 0xA5, sizeof(dstBuf[b][i]));
+                    }
+                    if(enabled[b])
+                    {
+                        runCase((TEST_CASE)c, b, srcBuf, srcStep, &dst[b], width, height, &ctx);
+                    }
+                }
+
+                for(b = 1;  b < 3;  b++)
+                {
+                    if(!enabled[b])
+                    {
+                        continue;
+                    }
+                    checks++;
+                    for(i = 0;  i < 3;  i++)
+                    {
+                        if(memcmp(dst[0].plane[i], dst[b].plane[i], sizeof(dstBuf[0][i])))
+                        {
+                            printf("FAIL: %s %s formula 0x%x %dx%d plane %d\n",
+                                   caseName[c], backendName[b], formulas[f], width, height, i);
+                            failures++;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    printf("%d checks, %d failures\n", checks, failures);
+    return failures ? 1 : 0;
+}
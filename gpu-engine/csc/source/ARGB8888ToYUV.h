@@ -37,4 +37,62 @@ typedef unsigned int    Ipp32u;
 
 #include "gpu_csc.h"
 
+/* context of the entry points without one, changed by gpu_csc_ChooseFormula */
+const GPU_CSC_CONTEXT* gpu_csc_GetDefaultContext(void);
+
+#ifdef GPU_CSC_X86_SIMD
+/*
+// x86 backends, the public gpu_csc_* entry points pick one of them
+// at first use according to cpuid, see ARGB8888ToYUV_x86.c
+*/
+#define GPU_CSC_X86_SSE41       (1 << 0)
+#define GPU_CSC_X86_AVX2        (1 << 1)
+
+Ipp32u gpu_csc_GetX86Features(void);
+
+/* chroma layout of the 4:2:0 row kernels */
+#define GPU_CSC_LAYOUT_PLANAR   0   /* dstA = U plane, dstB = V plane */
+#define GPU_CSC_LAYOUT_UV       1   /* dstA = interleaved UV plane    */
+#define GPU_CSC_LAYOUT_VU       2   /* dstA = interleaved VU plane    */
+
+/*
+// Row kernels: convert a row pair (4:2:0) or a single row (UYVY) of
+// width pixels, width must be a multiple of the kernel vector width.
+// k points to the context rgbYuv (fixed point) or rgbYuvGC widened to 32 bits.
+*/
+typedef void (*GPU_CSC_ROW420)(const Ipp8u* src0, const Ipp8u* src1,
+                               Ipp8u* dsty0, Ipp8u* dsty1,
+                               Ipp8u* dstA, Ipp8u* dstB,
+                               int width, int layout, const Ipp32s* k);
+
+typedef void (*GPU_CSC_ROW422)(const Ipp8u* src, Ipp8u* dst,
+                               int width, const Ipp32s* k);
+
+#define GPU_CSC_SSE41_PIXELS    8
+void rowARGBToYUV420_Fixed_SSE41(const Ipp8u* src0, const Ipp8u* src1, Ipp8u* dsty0, Ipp8u* dsty1, Ipp8u* dstA, Ipp8u* dstB, int width, int layout, const Ipp32s* k);
+void rowARGBToYUV420_Int_SSE41(const Ipp8u* src0, const Ipp8u* src1, Ipp8u* dsty0, Ipp8u* dsty1, Ipp8u* dstA, Ipp8u* dstB, int width, int layout, const Ipp32s* k);
+void rowRGB565ToYUV420_Fixed_SSE41(const Ipp8u* src0, const Ipp8u* src1, Ipp8u* dsty0, Ipp8u* dsty1, Ipp8u* dstA, Ipp8u* dstB, int width, int layout, const Ipp32s* k);
+void rowARGBToUYVY_Fixed_SSE41(const Ipp8u* src, Ipp8u* dst, int width, const Ipp32s* k);
+void rowARGBToUYVY_Int_SSE41(const Ipp8u* src, Ipp8u* dst, int width, const Ipp32s* k);
+
+#define GPU_CSC_AVX2_PIXELS     16
+void rowARGBToYUV420_Fixed_AVX2(const Ipp8u* src0, const Ipp8u* src1, Ipp8u* dsty0, Ipp8u* dsty1, Ipp8u* dstA, Ipp8u* dstB, int width, int layout, const Ipp32s* k);
+void rowARGBToYUV420_Int_AVX2(const Ipp8u* src0, const Ipp8u* src1, Ipp8u* dsty0, Ipp8u* dsty1, Ipp8u* dstA, Ipp8u* dstB, int width, int layout, const Ipp32s* k);
+void rowRGB565ToYUV420_Fixed_AVX2(const Ipp8u* src0, const Ipp8u* src1, Ipp8u* dsty0, Ipp8u* dsty1, Ipp8u* dstA, Ipp8u* dstB, int width, int layout, const Ipp32s* k);
+void rowARGBToUYVY_Fixed_AVX2(const Ipp8u* src, Ipp8u* dst, int width, const Ipp32s* k);
+void rowARGBToUYVY_Int_AVX2(const Ipp8u* src, Ipp8u* dst, int width, const Ipp32s* k);
+
+/* frame converters of every backend, same arguments as the public _ex API */
+#define GPU_CSC_DECLARE_BACKEND(suffix) \
+void gpu_csc_ARGBToI420_##suffix(const Ipp8u* pSrc, int srcStep, Ipp8u* pDst[3], int dstStep[3], int width, int height, const GPU_CSC_CONTEXT* pCtx); \
+void gpu_csc_ARGBToUYVY_##suffix(const Ipp8u* pSrc, int srcStep, Ipp8u* pDst, int dstStep, int width, int height, const GPU_CSC_CONTEXT* pCtx); \
+void gpu_csc_ARGBToNV21_##suffix(const Ipp8u* pSrc, int srcStep, Ipp8u* pDst[2], int dstStep[2], int width, int height, const GPU_CSC_CONTEXT* pCtx); \
+void gpu_csc_ARGBToNV12_##suffix(const Ipp8u* pSrc, int srcStep, Ipp8u* pDst[2], int dstStep[2], int width, int height, const GPU_CSC_CONTEXT* pCtx); \
+void gpu_csc_RGBToNV12_##suffix(const Ipp8u* pSrc, int srcStep, Ipp8u* pDst[2], int dstStep[2], int width, int height, const GPU_CSC_CONTEXT* pCtx);
+
+GPU_CSC_DECLARE_BACKEND(C)
+GPU_CSC_DECLARE_BACKEND(SSE41)
+GPU_CSC_DECLARE_BACKEND(AVX2)
+#endif /* GPU_CSC_X86_SIMD */
+
 #endif /* __ARGB8888TOYUV_H__ */
@@ -0,0 +1,352 @@
+/***********************************************************************************
+ *
+ *    Copyright (c) 2012 - 2013 by Marvell International Ltd. and its affiliates.
+ *    All rights reserved.
+ *
+ *    This software file (the "File") is owned and distributed by Marvell
+ *    International Ltd. and/or its affiliates ("Marvell") under Marvell Commercial
+ *    License.
+ *
+ *    If you received this File from Marvell and you have entered into a commercial
+ *    license agreement (a "Commercial License") with Marvell, the File is licensed
+ *    to you under the terms of the applicable Commercial License.
+ *
+ ***********************************************************************************/
+
+#include <immintrin.h>
+#include "ARGB8888ToYUV.h"
+
+/*
+// AVX2 row kernels, 16 pixels per step, same arithmetic as the SSE4.1 ones.
+// _mm256_hadd_epi32 works per 128-bit lane, so pixel pair sums of pixels
+// 0-7 and 8-15 come out as pairs [0 1 4 5 | 2 3 6 7]; everything after
+// it is lane-wise and the chroma is put back in order just before storing.
+*/
+#define CSC_AVX2 __attribute__((target("avx2")))
+
+#define CSC_PAIR_ORDER  _MM_SHUFFLE(3, 1, 2, 0)
+
+static CSC_AVX2 inline void unpackARGB(__m256i px, __m256i* r, __m256i* g, __m256i* b)
+{
+    const __m256i mask = _mm256_set1_epi32(0xff);
+
+    *b = _mm256_and_si256(px, mask);
+    *g = _mm256_and_si256(_mm256_srli_epi32(px, 8), mask);
+    *r = _mm256_and_si256(_mm256_srli_epi32(px, 16), mask);
+}
+
+static CSC_AVX2 inline void unpackRGB565(__m256i px, __m256i* r, __m256i* g, __m256i* b)
+{
+    const __m256i mask5 = _mm256_set1_epi32(0x1f);
+    const __m256i mask6 = _mm256_set1_epi32(0x3f);
+    __m256i c;
+
+    c  = _mm256_srli_epi32(px, 11);
+    *r = _mm256_or_si256(_mm256_slli_epi32(c, 3), _mm256_srli_epi32(c, 2));
+    c  = _mm256_and_si256(_mm256_srli_epi32(px, 5), mask6);
+    *g = _mm256_or_si256(_mm256_slli_epi32(c, 2), _mm256_srli_epi32(c, 4));
+    c  = _mm256_and_si256(px, mask5);
+    *b = _mm256_or_si256(_mm256_slli_epi32(c, 3), _mm256_srli_epi32(c, 2));
+}
+
+static CSC_AVX2 inline __m256i dot3(__m256i r, __m256i g, __m256i b, __m256i k0, __m256i k1, __m256i k2)
+{
+    return _mm256_add_epi32(_mm256_add_epi32(_mm256_mullo_epi32(k0, r), _mm256_mullo_epi32(k1, g)), _mm256_mullo_epi32(k2, b));
+}
+
+/* 8 lanes in order to 8 words */
+static CSC_AVX2 inline __m128i pack8(__m256i x)
+{
+    return _mm_packus_epi32(_mm256_castsi256_si128(x), _mm256_extracti128_si256(x, 1));
+}
+
+static CSC_AVX2 inline void storeY16(Ipp8u* dst, __m256i y0, __m256i y1)
+{
+    const __m256i mask = _mm256_set1_epi32(0xff);
+
+    _mm_storeu_si128((__m128i*)dst, _mm_packus_epi16(pack8(_mm256_and_si256(y0, mask)),
+                                                     pack8(_mm256_and_si256(y1, mask))));
+}
+
+/* u and v hold 8 chroma samples in [0, 255], still in hadd pair order */
+static CSC_AVX2 inline void storeUV8(Ipp8u* dstA, Ipp8u* dstB, __m256i u, __m256i v, int layout)
+{
+    __m128i c;
+
+    if(layout == GPU_CSC_LAYOUT_PLANAR)
+    {
+        c = pack8(_mm256_permute4x64_epi64(u, CSC_PAIR_ORDER));
+        _mm_storel_epi64((__m128i*)dstA, _mm_packus_epi16(c, c));
+        c = pack8(_mm256_permute4x64_epi64(v, CSC_PAIR_ORDER));
+        _mm_storel_epi64((__m128i*)dstB, _mm_packus_epi16(c, c));
+    }
+    else
+    {
+        __m256i uv;
+
+        if(layout == GPU_CSC_LAYOUT_UV)
+        {
+            uv = _mm256_or_si256(u, _mm256_slli_epi32(v, 8));
+        }
+        else
+        {
+            uv = _mm256_or_si256(v, _mm256_slli_epi32(u, 8));
+        }
+        _mm_storeu_si128((__m128i*)dstA, pack8(_mm256_permute4x64_epi64(uv, CSC_PAIR_ORDER)));
+    }
+}
+
+static CSC_AVX2 inline void chroma420Fixed(__m256i R, __m256i B, __m256i ysum,
+                                           __m256i k3, __m256i k4, __m256i* u, __m256i* v)
+{
+    const __m256i round = _mm256_set1_epi32(0x20000);
+    const __m256i bias  = _mm256_set1_epi32(128);
+    const __m256i mask  = _mm256_set1_epi32(0xff);
+    __m256i t;
+
+    t  = _mm256_srai_epi32(_mm256_add_epi32(_mm256_sub_epi32(_mm256_slli_epi32(B, 16), ysum), round), 16);
+    t  = _mm256_add_epi32(_mm256_srai_epi32(_mm256_mullo_epi32(k3, t), 18), bias);
+    *u = _mm256_and_si256(t, mask);
+
+    t  = _mm256_srai_epi32(_mm256_add_epi32(_mm256_sub_epi32(_mm256_slli_epi32(R, 16), ysum), round), 16);
+    t  = _mm256_add_epi32(_mm256_srai_epi32(_mm256_mullo_epi32(k4, t), 18), bias);
+    *v = _mm256_min_epi32(_mm256_max_epi32(t, _mm256_setzero_si256()), mask);
+}
+
+/* r/g/b[0..1] are pixels 0-7/8-15 of row 0, r/g/b[2..3] the same of row 1 */
+static CSC_AVX2 inline void block420Fixed(__m256i* r, __m256i* g, __m256i* b,
+                                          Ipp8u* dsty0, Ipp8u* dsty1, Ipp8u* dstA, Ipp8u* dstB,
+                                          int layout, const Ipp32s* k)
+{
+    __m256i k0 = _mm256_set1_epi32(k[0]);
+    __m256i k1 = _mm256_set1_epi32(k[1]);
+    __m256i k2 = _mm256_set1_epi32(k[2]);
+    __m256i y[4], R, B, ysum, u, v;
+    int i;
+
+    for(i = 0;  i < 4;  i++)
+    {
+        y[i] = dot3(r[i], g[i], b[i], k0, k1, k2);
+    }
+    storeY16(dsty0, _mm256_srai_epi32(y[0], 16), _mm256_srai_epi32(y[1], 16));
+    storeY16(dsty1, _mm256_srai_epi32(y[2], 16), _mm256_srai_epi32(y[3], 16));
+
+    R    = _mm256_add_epi32(_mm256_hadd_epi32(r[0], r[1]), _mm256_hadd_epi32(r[2], r[3]));
+    B    = _mm256_add_epi32(_mm256_hadd_epi32(b[0], b[1]), _mm256_hadd_epi32(b[2], b[3]));
+    ysum = _mm256_add_epi32(_mm256_hadd_epi32(y[0], y[1]), _mm256_hadd_epi32(y[2], y[3]));
+    chroma420Fixed(R, B, ysum, _mm256_set1_epi32(k[3]), _mm256_set1_epi32(k[4]), &u, &v);
+    storeUV8(dstA, dstB, u, v, layout);
+}
+
+CSC_AVX2 void rowARGBToYUV420_Fixed_AVX2(const Ipp8u* src0, const Ipp8u* src1,
+                                         Ipp8u* dsty0, Ipp8u* dsty1,
+                                         Ipp8u* dstA, Ipp8u* dstB,
+                                         int width, int layout, const Ipp32s* k)
+{
+    int step = (layout == GPU_CSC_LAYOUT_PLANAR) ? 8 : 16;
+    int w;
+
+    for(w = 0;  w < width;  w += 16)
+    {
+        __m256i r[4], g[4], b[4];
+
+        unpackARGB(_mm256_loadu_si256((const __m256i*)(src0 +  0)), &r[0], &g[0], &b[0]);
+        unpackARGB(_mm256_loadu_si256((const __m256i*)(src0 + 32)), &r[1], &g[1], &b[1]);
+        unpackARGB(_mm256_loadu_si256((const __m256i*)(src1 +  0)), &r[2], &g[2], &b[2]);
+        unpackARGB(_mm256_loadu_si256((const __m256i*)(src1 + 32)), &r[3], &g[3], &b[3]);
+        block420Fixed(r, g, b, dsty0, dsty1, dstA, dstB, layout, k);
+
+        src0  += 64;
+        src1  += 64;
+        dsty0 += 16;
+        dsty1 += 16;
+        dstA  += step;
+        dstB  += 8;
+    }
+}
+
+CSC_AVX2 void rowRGB565ToYUV420_Fixed_AVX2(const Ipp8u* src0, const Ipp8u* src1,
+                                           Ipp8u* dsty0, Ipp8u* dsty1,
+                                           Ipp8u* dstA, Ipp8u* dstB,
+                                           int width, int layout, const Ipp32s* k)
+{
+    int step = (layout == GPU_CSC_LAYOUT_PLANAR) ? 8 : 16;
+    int w;
+
+    for(w = 0;  w < width;  w += 16)
+    {
+        __m256i r[4], g[4], b[4];
+
+        unpackRGB565(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(src0 +  0))), &r[0], &g[0], &b[0]);
+        unpackRGB565(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(src0 + 16))), &r[1], &g[1], &b[1]);
+        unpackRGB565(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(src1 +  0))), &r[2], &g[2], &b[2]);
+        unpackRGB565(_mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(src1 + 16))), &r[3], &g[3], &b[3]);
+        block420Fixed(r, g, b, dsty0, dsty1, dstA, dstB, layout, k);
+
+        src0  += 32;
+        src1  += 32;
+        dsty0 += 16;
+        dsty1 += 16;
+        dstA  += step;
+        dstB  += 8;
+    }
+}
+
+CSC_AVX2 void rowARGBToYUV420_Int_AVX2(const Ipp8u* src0, const Ipp8u* src1,
+                                       Ipp8u* dsty0, Ipp8u* dsty1,
+                                       Ipp8u* dstA, Ipp8u* dstB,
+                                       int width, int layout, const Ipp32s* k)
+{
+    const __m256i mask = _mm256_set1_epi32(0xff);
+    __m256i k0  = _mm256_set1_epi32(k[0]);
+    __m256i k1  = _mm256_set1_epi32(k[1]);
+    __m256i k2  = _mm256_set1_epi32(k[2]);
+    __m256i k3  = _mm256_set1_epi32(k[3]);
+    __m256i k4  = _mm256_set1_epi32(k[4]);
+    __m256i k5  = _mm256_set1_epi32(k[5]);
+    __m256i k6  = _mm256_set1_epi32(k[6]);
+    __m256i k7  = _mm256_set1_epi32(k[7]);
+    __m256i k8  = _mm256_set1_epi32(k[8]);
+    __m256i k9  = _mm256_set1_epi32(k[9]);
+    __m256i k10 = _mm256_set1_epi32(k[10]);
+    __m256i k11 = _mm256_set1_epi32(k[11]);
+    __m256i yround = _mm256_set1_epi32(128);
+    __m256i cround = _mm256_set1_epi32(512);
+    int step = (layout == GPU_CSC_LAYOUT_PLANAR) ? 8 : 16;
+    int w;
+
+    for(w = 0;  w < width;  w += 16)
+    {
+        __m256i r[4], g[4], b[4], y[4];
+        __m256i R, G, B, u, v;
+        int i;
+
+        unpackARGB(_mm256_loadu_si256((const __m256i*)(src0 +  0)), &r[0], &g[0], &b[0]);
+        unpackARGB(_mm256_loadu_si256((const __m256i*)(src0 + 32)), &r[1], &g[1], &b[1]);
+        unpackARGB(_mm256_loadu_si256((const __m256i*)(src1 +  0)), &r[2], &g[2], &b[2]);
+        unpackARGB(_mm256_loadu_si256((const __m256i*)(src1 + 32)), &r[3], &g[3], &b[3]);
+
+        for(i = 0;  i < 4;  i++)
+        {
+            y[i] = _mm256_add_epi32(dot3(r[i], g[i], b[i], k0, k1, k2), yround);
+            y[i] = _mm256_add_epi32(_mm256_srai_epi32(y[i], 8), k3);
+        }
+        storeY16(dsty0, y[0], y[1]);
+        storeY16(dsty1, y[2], y[3]);
+
+        R = _mm256_add_epi32(_mm256_hadd_epi32(r[0], r[1]), _mm256_hadd_epi32(r[2], r[3]));
+        G = _mm256_add_epi32(_mm256_hadd_epi32(g[0], g[1]), _mm256_hadd_epi32(g[2], g[3]));
+        B = _mm256_add_epi32(_mm256_hadd_epi32(b[0], b[1]), _mm256_hadd_epi32(b[2], b[3]));
+
+        u = _mm256_add_epi32(dot3(R, G, B, k4, k5, k6), cround);
+        u = _mm256_and_si256(_mm256_add_epi32(_mm256_srai_epi32(u, 10), k7), mask);
+        v = _mm256_add_epi32(dot3(R, G, B, k8, k9, k10), cround);
+        v = _mm256_and_si256(_mm256_add_epi32(_mm256_srai_epi32(v, 10), k11), mask);
+        storeUV8(dstA, dstB, u, v, layout);
+
+        src0  += 64;
+        src1  += 64;
+        dsty0 += 16;
+        dsty1 += 16;
+        dstA  += step;
+        dstB  += 8;
+    }
+}
+
+/* one UYVY word per pixel pair: U | Y0 << 8 | V << 16 | Y1 << 24, stored in order */
+static CSC_AVX2 inline void storeUYVY(Ipp8u* dst, __m256i ya, __m256i yb, __m256i u, __m256i v)
+{
+    const __m256i mask = _mm256_set1_epi32(0xff);
+    __m256i y0 = _mm256_castps_si256(_mm256_shuffle_ps(_mm256_castsi256_ps(ya), _mm256_castsi256_ps(yb), _MM_SHUFFLE(2, 0, 2, 0)));
+    __m256i y1 = _mm256_castps_si256(_mm256_shuffle_ps(_mm256_castsi256_ps(ya), _mm256_castsi256_ps(yb), _MM_SHUFFLE(3, 1, 3, 1)));
+    __m256i c;
+
+    y0 = _mm256_slli_epi32(_mm256_and_si256(y0, mask), 8);
+    y1 = _mm256_slli_epi32(y1, 24);
+    v  = _mm256_slli_epi32(v, 16);
+    c  = _mm256_or_si256(_mm256_or_si256(u, y0), _mm256_or_si256(v, y1));
+    _mm256_storeu_si256((__m256i*)dst, _mm256_permute4x64_epi64(c, CSC_PAIR_ORDER));
+}
+
+CSC_AVX2 void rowARGBToUYVY_Fixed_AVX2(const Ipp8u* src, Ipp8u* dst, int width, const Ipp32s* k)
+{
+    const __m256i round = _mm256_set1_epi32(0xffff);
+    const __m256i bias  = _mm256_set1_epi32(128);
+    const __m256i mask  = _mm256_set1_epi32(0xff);
+    __m256i k0 = _mm256_set1_epi32(k[0]);
+    __m256i k1 = _mm256_set1_epi32(k[1]);
+    __m256i k2 = _mm256_set1_epi32(k[2]);
+    __m256i k3 = _mm256_set1_epi32(k[3]);
+    __m256i k4 = _mm256_set1_epi32(k[4]);
+    int w;
+
+    for(w = 0;  w < width;  w += 16)
+    {
+        __m256i ra, ga, ba, rb, gb, bb;
+        __m256i ya, yb, ysum, R, B, u, v;
+
+        unpackARGB(_mm256_loadu_si256((const __m256i*)(src +  0)), &ra, &ga, &ba);
+        unpackARGB(_mm256_loadu_si256((const __m256i*)(src + 32)), &rb, &gb, &bb);
+        ya   = dot3(ra, ga, ba, k0, k1, k2);
+        yb   = dot3(rb, gb, bb, k0, k1, k2);
+        ysum = _mm256_hadd_epi32(ya, yb);
+        R    = _mm256_hadd_epi32(ra, rb);
+        B    = _mm256_hadd_epi32(ba, bb);
+
+        u = _mm256_srai_epi32(_mm256_add_epi32(_mm256_sub_epi32(_mm256_slli_epi32(B, 16), ysum), round), 16);
+        u = _mm256_add_epi32(_mm256_srai_epi32(_mm256_mullo_epi32(k3, u), 17), bias);
+        u = _mm256_and_si256(u, mask);
+        v = _mm256_srai_epi32(_mm256_add_epi32(_mm256_sub_epi32(_mm256_slli_epi32(R, 16), ysum), round), 16);
+        v = _mm256_add_epi32(_mm256_srai_epi32(_mm256_mullo_epi32(k4, v), 17), bias);
+        v = _mm256_min_epi32(_mm256_max_epi32(v, _mm256_setzero_si256()), mask);
+
+        storeUYVY(dst, _mm256_srai_epi32(ya, 16), _mm256_srai_epi32(yb, 16), u, v);
+        src += 64;
+        dst += 32;
+    }
+}
+
+CSC_AVX2 void rowARGBToUYVY_Int_AVX2(const Ipp8u* src, Ipp8u* dst, int width, const Ipp32s* k)
+{
+    const __m256i mask = _mm256_set1_epi32(0xff);
+    __m256i k0  = _mm256_set1_epi32(k[0]);
+    __m256i k1  = _mm256_set1_epi32(k[1]);
+    __m256i k2  = _mm256_set1_epi32(k[2]);
+    __m256i k3  = _mm256_set1_epi32(k[3]);
+    __m256i k4  = _mm256_set1_epi32(k[4]);
+    __m256i k5  = _mm256_set1_epi32(k[5]);
+    __m256i k6  = _mm256_set1_epi32(k[6]);
+    __m256i k7  = _mm256_set1_epi32(k[7]);
+    __m256i k8  = _mm256_set1_epi32(k[8]);
+    __m256i k9  = _mm256_set1_epi32(k[9]);
+    __m256i k10 = _mm256_set1_epi32(k[10]);
+    __m256i k11 = _mm256_set1_epi32(k[11]);
+    __m256i yround = _mm256_set1_epi32(128);
+    __m256i cround = _mm256_set1_epi32(256);
+    int w;
+
+    for(w = 0;  w < width;  w += 16)
+    {
+        __m256i ra, ga, ba, rb, gb, bb;
+        __m256i ya, yb, R, G, B, u, v;
+
+        unpackARGB(_mm256_loadu_si256((const __m256i*)(src +  0)), &ra, &ga, &ba);
+        unpackARGB(_mm256_loadu_si256((const __m256i*)(src + 32)), &rb, &gb, &bb);
+        ya = _mm256_add_epi32(dot3(ra, ga, ba, k0, k1, k2), yround);
+        ya = _mm256_add_epi32(_mm256_srai_epi32(ya, 8), k3);
+        yb = _mm256_add_epi32(dot3(rb, gb, bb, k0, k1, k2), yround);
+        yb = _mm256_add_epi32(_mm256_srai_epi32(yb, 8), k3);
+        R  = _mm256_hadd_epi32(ra, rb);
+        G  = _mm256_hadd_epi32(ga, gb);
+        B  = _mm256_hadd_epi32(ba, bb);
+
+        u = _mm256_add_epi32(dot3(R, G, B, k4, k5, k6), cround);
+        u = _mm256_and_si256(_mm256_add_epi32(_mm256_srai_epi32(u, 9), k7), mask);
+        v = _mm256_add_epi32(dot3(R, G, B, k8, k9, k10), cround);
+        v = _mm256_and_si256(_mm256_add_epi32(_mm256_srai_epi32(v, 9), k11), mask);
+
+        storeUYVY(dst, ya, yb, u, v);
+        src += 64;
+        dst += 32;
+    }
+}
@@ -14,6 +14,23 @@
  ***********************************************************************************/
 
 #include "ARGB8888ToYUV.h"
+#include "ARGB8888ToYUV_coef.h"
+
+#ifdef GPU_CSC_X86_SIMD
+/* scalar reference, the public names dispatch in ARGB8888ToYUV_x86.c */
+#define gpu_csc_ARGBToI420_ex   gpu_csc_ARGBToI420_C
+#define gpu_csc_ARGBToUYVY_ex   gpu_csc_ARGBToUYVY_C
+#define gpu_csc_ARGBToNV21_ex   gpu_csc_ARGBToNV21_C
+#define gpu_csc_ARGBToNV12_ex   gpu_csc_ARGBToNV12_C
+#define gpu_csc_RGBToNV12_ex    gpu_csc_RGBToNV12_C
+#endif
+
+/*
+// The kernels below take the coefficient tables as arguments and are
+// always inlined, each formula gets its own copy with the tables folded
+// in as constants and the fixed-point/integer choice made at compile time.
+*/
+#define CSC_INLINE  static __inline__ __attribute__((always_inline))
 
 /*
 // Color Conversion:
@@ -25,11 +42,6 @@
 //    U  = -0.147*R' - 0.289*G' + 0.436*B' = 0.492*(B' - Y' )
 //    V  =  0.615*R' - 0.515*G' - 0.100*B' = 0.877*(R' - Y' )
 */
-extern GPU_CSC_FORMULA g_Formula;
-extern Ipp32s RGB_YUV[];
-extern Ipp16s RGB_YUV_Q10[];
-extern Ipp16s RGB_YUV_GC[];
-
 /*
 // Saturate table for depth 8u
 // saturated value range is [-376..751]
@@ -190,9 +202,10 @@ Ipp8u* SAT_DK = saturTable + saturTableStartOffset;
 //  Lib = S1
 //  Lib = S2
 */
-void gpu_csc_ARGBToI420(const Ipp8u* pSrc, int srcStep,
-                        Ipp8u* pDst[3], int dstStep[3],
-                        int width, int height)
+CSC_INLINE void cscARGBToI420(const Ipp32s* RGB_YUV, const Ipp16s* RGB_YUV_GC, int fixed,
+                              const Ipp8u* pSrc, int srcStep,
+                              Ipp8u* pDst[3], int dstStep[3],
+                              int width, int height)
 {
     int dstStepY  = dstStep[0];
     int dstStepU  = dstStep[1];
@@ -211,7 +224,7 @@ void gpu_csc_ARGBToI420(const Ipp8u* pSrc, int srcStep,
     dstStepY *= 2;
 
     /* if we use fixed point formula */
-    if(g_Formula & GPU_CSC_FORMULA_BT601)
+    if(fixed)
     {
         for(h = height & ~1;  h > 0;  h -= 2)
         {
@@ -465,7 +478,7 @@ void gpu_csc_ARGBToI420(const Ipp8u* pSrc, int srcStep,
     }
 }
 
-static void lineRGBToYUV422_Fixed(const Ipp8u* src, Ipp8u* dst, int width)
+CSC_INLINE void lineRGBToYUV422_Fixed(const Ipp32s* RGB_YUV, const Ipp8u* src, Ipp8u* dst, int width)
 {
     int    w;
     Ipp32s r, b, y0, y1;
@@ -498,7 +511,7 @@ static void lineRGBToYUV422_Fixed(const Ipp8u* src, Ipp8u* dst, int width)
     }
 }
 
-static void lineRGBToYUV422_Int(const Ipp8u* src, Ipp8u* dst, int width)
+CSC_INLINE void lineRGBToYUV422_Int(const Ipp16s* RGB_YUV_GC, const Ipp8u* src, Ipp8u* dst, int width)
 {
     int    w;
     Ipp32s r, g, b, y0, y1;
@@ -534,17 +547,18 @@ static void lineRGBToYUV422_Int(const Ipp8u* src, Ipp8u* dst, int width)
     }
 }
 
-void gpu_csc_ARGBToUYVY(const Ipp8u* pSrc, int srcStep,
-                        Ipp8u* pDst, int dstStep,
-                        int width, int height)
+CSC_INLINE void cscARGBToUYVY(const Ipp32s* RGB_YUV, const Ipp16s* RGB_YUV_GC, int fixed,
+                              const Ipp8u* pSrc, int srcStep,
+                              Ipp8u* pDst, int dstStep,
+                              int width, int height)
 {
     int h;
     /* if we use fixed point formula */
-    if(g_Formula & GPU_CSC_FORMULA_BT601)
+    if(fixed)
     {
         for(h = height;  h > 0;  --h)
         {
-            lineRGBToYUV422_Fixed(pSrc, pDst, width);
+            lineRGBToYUV422_Fixed(RGB_YUV, pSrc, pDst, width);
             pSrc += srcStep;
             pDst += dstStep;
         }
@@ -553,16 +567,17 @@ void gpu_csc_ARGBToUYVY(const Ipp8u* pSrc, int srcStep,
     {
         for(h = height;  h > 0;  --h)
         {
-            lineRGBToYUV422_Int(pSrc, pDst, width);
+            lineRGBToYUV422_Int(RGB_YUV_GC, pSrc, pDst, width);
             pSrc += srcStep;
             pDst += dstStep;
         }
     }
 }
 
-void gpu_csc_ARGBToNV21(const Ipp8u* pSrc, int srcStep,
-                        Ipp8u* pDst[2], int dstStep[2],
-                        int width, int height)
+CSC_INLINE void cscARGBToNV21(const Ipp32s* RGB_YUV, const Ipp16s* RGB_YUV_GC, int fixed,
+                              const Ipp8u* pSrc, int srcStep,
+                              Ipp8u* pDst[2], int dstStep[2],
+                              int width, int height)
 {
     int dstStepY  = dstStep[0];
     int dstStepVU = dstStep[1];
@@ -580,7 +595,7 @@ void gpu_csc_ARGBToNV21(const Ipp8u* pSrc, int srcStep,
     srcStep  *= 2;
     dstStepY *= 2;
     /* if we use fixed point formula */
-    if(g_Formula & GPU_CSC_FORMULA_BT601)
+    if(fixed)
     {
         for(h = height & ~1;  h > 0;  h -= 2)
         {
@@ -829,9 +844,10 @@ void gpu_csc_ARGBToNV21(const Ipp8u* pSrc, int srcStep,
     }
 }
 
-void gpu_csc_ARGBToNV12(const Ipp8u* pSrc, int srcStep,
-                        Ipp8u* pDst[2], int dstStep[2],
-                        int width, int height)
+CSC_INLINE void cscARGBToNV12(const Ipp32s* RGB_YUV, const Ipp16s* RGB_YUV_GC, int fixed,
+                              const Ipp8u* pSrc, int srcStep,
+                              Ipp8u* pDst[2], int dstStep[2],
+                              int width, int height)
 {
     int dstStepY  = dstStep[0];
     int dstStepVU = dstStep[1];
@@ -849,7 +865,7 @@ void gpu_csc_ARGBToNV12(const Ipp8u* pSrc, int srcStep,
     srcStep  *= 2;
     dstStepY *= 2;
     /* if we use fixed point formula */
-    if(g_Formula & GPU_CSC_FORMULA_BT601)
+    if(fixed)
     {
         for(h = height & ~1;  h > 0;  h -= 2)
         {
@@ -1098,9 +1114,10 @@ void gpu_csc_ARGBToNV12(const Ipp8u* pSrc, int srcStep,
     }
 }
 
-void gpu_csc_RGBToNV12(const Ipp8u* pSrc, int srcStep,
-                       Ipp8u* pDst[2], int dstStep[2],
-                       int width, int height)
+CSC_INLINE void cscRGBToNV12(const Ipp32s* RGB_YUV, const Ipp16s* RGB_YUV_GC, int fixed,
+                             const Ipp8u* pSrc, int srcStep,
+                             Ipp8u* pDst[2], int dstStep[2],
+                             int width, int height)
 {
     int dstStepY  = dstStep[0];
     int dstStepUV = dstStep[1];
@@ -1309,3 +1326,65 @@ void gpu_csc_RGBToNV12(const Ipp8u* pSrc, int srcStep,
     }
 }
 
+/*
+// Formula dispatch: one specialized copy of the kernel per formula, a
+// context holding some other value goes through the copy reading its tables.
+*/
+#define CSC_DISPATCH(kernel, pCtx, ...)                                                                     \
+    switch((pCtx)->formula)                                                                                 \
+    {                                                                                                       \
+        case GPU_CSC_FORMULA_BT601_GC:                                                                      \
+            kernel(RGB_YUV_BT601, RGB_YUV_BT601_GC, 0, __VA_ARGS__);                                        \
+            break;                                                                                          \
+        case GPU_CSC_FORMULA_BT709_GC:                                                                      \
+            kernel(RGB_YUV_BT709, RGB_YUV_BT709_GC, 0, __VA_ARGS__);                                        \
+            break;                                                                                          \
+        case GPU_CSC_FORMULA_BT601:                                                                         \
+            kernel(RGB_YUV_BT601, RGB_YUV_BT601_GC, 1, __VA_ARGS__);                                        \
+            break;                                                                                          \
+        case GPU_CSC_FORMULA_BT709:                                                                         \
+            kernel(RGB_YUV_BT709, RGB_YUV_BT709_GC, 1, __VA_ARGS__);                                        \
+            break;                                                                                          \
+        case GPU_CSC_FORMULA_TRADITIONAL:                                                                   \
+            kernel(RGB_YUV_TRADITIONAL, RGB_YUV_BT601_GC, 1, __VA_ARGS__);                                  \
+            break;                                                                                          \
+        default:                                                                                            \
+            kernel((pCtx)->rgbYuv, (pCtx)->rgbYuvGC,                                                        \
+                   ((pCtx)->formula & GPU_CSC_FORMULA_BT601) != 0, __VA_ARGS__);                            \
+            break;                                                                                          \
+    }
+
+void gpu_csc_ARGBToI420_ex(const Ipp8u* pSrc, int srcStep,
+                           Ipp8u* pDst[3], int dstStep[3],
+                           int width, int height, const GPU_CSC_CONTEXT* pCtx)
+{
+    CSC_DISPATCH(cscARGBToI420, pCtx, pSrc, srcStep, pDst, dstStep, width, height);
+}
+
+void gpu_csc_ARGBToUYVY_ex(const Ipp8u* pSrc, int srcStep,
+                           Ipp8u* pDst, int dstStep,
+                           int width, int height, const GPU_CSC_CONTEXT* pCtx)
+{
+    CSC_DISPATCH(cscARGBToUYVY, pCtx, pSrc, srcStep, pDst, dstStep, width, height);
+}
+
+void gpu_csc_ARGBToNV21_ex(const Ipp8u* pSrc, int srcStep,
+                           Ipp8u* pDst[2], int dstStep[2],
+                           int width, int height, const GPU_CSC_CONTEXT* pCtx)
+{
+    CSC_DISPATCH(cscARGBToNV21, pCtx, pSrc, srcStep, pDst, dstStep, width, height);
+}
+
+void gpu_csc_ARGBToNV12_ex(const Ipp8u* pSrc, int srcStep,
+                           Ipp8u* pDst[2], int dstStep[2],
+                           int width, int height, const GPU_CSC_CONTEXT* pCtx)
+{
+    CSC_DISPATCH(cscARGBToNV12, pCtx, pSrc, srcStep, pDst, dstStep, width, height);
+}
+
+void gpu_csc_RGBToNV12_ex(const Ipp8u* pSrc, int srcStep,
+                          Ipp8u* pDst[2], int dstStep[2],
+                          int width, int height, const GPU_CSC_CONTEXT* pCtx)
+{
+    CSC_DISPATCH(cscRGBToNV12, pCtx, pSrc, srcStep, pDst, dstStep, width, height);
+}
@@ -25,23 +25,25 @@
     WORDSIZE  = 4  @ sizeof(Ipp32s)
     HWORDSIZE = 2  @ sizeof(Ipp16u)
 
-    .extern RGB_YUV_Q10  @ Import RGB->YUV coefficients
-    .extern RGB_YUV_GC
-    .extern g_Formula
-    .global gpu_csc_ARGBToI420
-    .global gpu_csc_ARGBToNV21
-    .global gpu_csc_ARGBToNV12
-    .global gpu_csc_ARGBToUYVY
-    .global gpu_csc_RGBToNV12
+    @@ GPU_CSC_CONTEXT layout, checked in ARGB8888ToYUV_data.c
+    CSC_CTX_FORMULA     = 0
+    CSC_CTX_RGB_YUV_Q10 = 24
+    CSC_CTX_RGB_YUV_GC  = 36
+
+    .global gpu_csc_ARGBToI420_ex
+    .global gpu_csc_ARGBToNV21_ex
+    .global gpu_csc_ARGBToNV12_ex
+    .global gpu_csc_ARGBToUYVY_ex
+    .global gpu_csc_RGBToNV12_ex
 
     .align 5
 @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
 @ Purpose:    interlived ARGB -> planed YUV
 @
-@ void ARGB8888_I420(
+@ void gpu_csc_ARGBToI420_ex(
 @          const Ipp8u* pSrc, int srcSL,
 @          Ipp8u* pDst[3], int dstSL[3],
-@          int width, int height)
+@          int width, int height, const GPU_CSC_CONTEXT* pCtx)
 @
 @   ARM Registers Assignment:
 @       r0          :   pSrc, pSrcLine 1
@@ -78,14 +80,14 @@
 @
 @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
 
-gpu_csc_ARGBToI420:
-    LDR         r12,  =g_Formula
+gpu_csc_ARGBToI420_ex:
     STMDB       sp!,  {r4 - r11, lr}                    @ push registers
-    LDR         r12,  [r12]
-    TST         r12,  #0x10
+    LDR         r12,  [sp,  #44]                        @ pCtx
+    LDR         lr,   [r12, #CSC_CTX_FORMULA]
+    TST         lr,   #0x10
     BEQ         gpu_csc_ARGBToI420_GC
 
-    LDR         lr,   =RGB_YUV_Q10                      @ lr = k[]
+    ADD         lr,   r12,  #CSC_CTX_RGB_YUV_Q10        @ lr = k[]
     LDR         r6,   [sp,  #36]                        @ roi width
     LDR         r7,   [sp,  #40]                        @ roi height
                                                         @ prepare some constants:
@@ -474,7 +476,7 @@ gpu_csc_ARGBToI420_GC_table_2:
 
     .align 5
 gpu_csc_ARGBToI420_GC:
-    LDR         lr,   =RGB_YUV_GC                       @ lr = k[]
+    ADD         lr,   r12,  #CSC_CTX_RGB_YUV_GC         @ lr = k[], r12 = pCtx
     LDR         r6,   [sp,  #36]                        @ roi width
     LDR         r7,   [sp,  #40]                        @ roi height
                                                         @ prepare some constants:
@@ -826,10 +828,10 @@ ARGB8888_I420_GC_line_tail:
 @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
 @ Purpose:    interlived ARGB -> NV21
 @
-@ void gpu_csc_ARGBToNV21(
+@ void gpu_csc_ARGBToNV21_ex(
 @          const Ipp8u* pSrc, int srcSL,
 @          Ipp8u* pDst[2], int dstSL[2],
-@          int width, int height)
+@          int width, int height, const GPU_CSC_CONTEXT* pCtx)
 @
 @   ARM Registers Assignment:
 @       r0          :   pSrc, pSrcLine 1
@@ -866,14 +868,14 @@ ARGB8888_I420_GC_line_tail:
 @
 @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
 
-gpu_csc_ARGBToNV21:
-    LDR         r12,  =g_Formula
+gpu_csc_ARGBToNV21_ex:
     STMDB       sp!,  {r4 - r11, lr}                    @ push registers
-    LDR         r12,  [r12]
-    TST         r12,  #0x10
+    LDR         r12,  [sp,  #44]                        @ pCtx
+    LDR         lr,   [r12, #CSC_CTX_FORMULA]
+    TST         lr,   #0x10
     BEQ         gpu_csc_ARGBToNV21_GC
 
-    LDR         lr,   =RGB_YUV_Q10                      @ lr = k[]
+    ADD         lr,   r12,  #CSC_CTX_RGB_YUV_Q10        @ lr = k[]
     LDR         r6,   [sp,  #36]                        @ roi width
     LDR         r7,   [sp,  #40]                        @ roi height
                                                         @ prepare some constants:
@@ -1261,7 +1263,7 @@ gpu_csc_ARGBToNV21_GC_table_2:
 
     .align 5
 gpu_csc_ARGBToNV21_GC:
-    LDR         lr,   =RGB_YUV_GC                       @ lr = k[]
+    ADD         lr,   r12,  #CSC_CTX_RGB_YUV_GC         @ lr = k[], r12 = pCtx
     LDR         r6,   [sp,  #36]                        @ roi width
     LDR         r7,   [sp,  #40]                        @ roi height
                                                         @ prepare some constants:
@@ -1601,10 +1603,10 @@ ARGB8888_NV21_GC_line_tail:
 @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
 @ Purpose:    interlived ARGB -> NV12
 @
-@ void gpu_csc_ARGBToNV12(
+@ void gpu_csc_ARGBToNV12_ex(
 @          const Ipp8u* pSrc, int srcSL,
 @          Ipp8u* pDst[2], int dstSL[2],
-@          int width, int height)
+@          int width, int height, const GPU_CSC_CONTEXT* pCtx)
 @
 @   ARM Registers Assignment:
 @       r0          :   pSrc, pSrcLine 1
@@ -1641,14 +1643,14 @@ ARGB8888_NV21_GC_line_tail:
 @
 @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
 
-gpu_csc_ARGBToNV12:
-    LDR         r12,  =g_Formula
+gpu_csc_ARGBToNV12_ex:
     STMDB       sp!,  {r4 - r11, lr}                    @ push registers
-    LDR         r12,  [r12]
-    TST         r12,  #0x10
+    LDR         r12,  [sp,  #44]                        @ pCtx
+    LDR         lr,   [r12, #CSC_CTX_FORMULA]
+    TST         lr,   #0x10
     BEQ         gpu_csc_ARGBToNV12_GC
 
-    LDR         lr,   =RGB_YUV_Q10                      @ lr = k[]
+    ADD         lr,   r12,  #CSC_CTX_RGB_YUV_Q10        @ lr = k[]
     LDR         r6,   [sp,  #36]                        @ roi width
     LDR         r7,   [sp,  #40]                        @ roi height
                                                         @ prepare some constants:
@@ -2035,7 +2037,7 @@ gpu_csc_ARGBToNV12_GC_table_2:
 
     .align 5
 gpu_csc_ARGBToNV12_GC:
-    LDR         lr,   =RGB_YUV_GC                       @ lr = k[]
+    ADD         lr,   r12,  #CSC_CTX_RGB_YUV_GC         @ lr = k[], r12 = pCtx
     LDR         r6,   [sp,  #36]                        @ roi width
     LDR         r7,   [sp,  #40]                        @ roi height
                                                         @ prepare some constants:
@@ -2375,10 +2377,10 @@ ARGB8888_NV12_GC_line_tail:
 @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
 @ Purpose:    interlived ARGB -> UYVY
 @
-@ void gpu_csc_ARGBToUYVY(
+@ void gpu_csc_ARGBToUYVY_ex(
 @          const Ipp8u* pSrc, int srcSL,
 @          Ipp8u* pDst, int dstSL,
-@          int width, int height)
+@          int width, int height, const GPU_CSC_CONTEXT* pCtx)
 @
 @   ARM Registers Assignment:
 @       r0          :   pSrc, pSrcLine 1
@@ -2415,14 +2417,14 @@ ARGB8888_NV12_GC_line_tail:
 @
 @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
 
-gpu_csc_ARGBToUYVY:
-    LDR         r12,  =g_Formula
+gpu_csc_ARGBToUYVY_ex:
     STMDB       sp!,  {r4 - r11, lr}                    @ push registers
-    LDR         r12,  [r12]
-    TST         r12,  #0x10
+    LDR         r12,  [sp,  #44]                        @ pCtx
+    LDR         lr,   [r12, #CSC_CTX_FORMULA]
+    TST         lr,   #0x10
     BEQ         gpu_csc_ARGBToUYVY_GC
 
-    LDR         lr,   =RGB_YUV_Q10                      @ lr = k[]
+    ADD         lr,   r12,  #CSC_CTX_RGB_YUV_Q10        @ lr = k[]
     LDR         r6,   [sp,  #36]                        @ roi width
     LDR         r7,   [sp,  #40]                        @ roi height
                                                         @ prepare some constants:
@@ -2612,7 +2614,7 @@ gpu_csc_ARGBToUYVY_GC_table_2:
 
     .align 5
 gpu_csc_ARGBToUYVY_GC:
-    LDR         lr,   =RGB_YUV_GC                       @ lr = k[]
+    ADD         lr,   r12,  #CSC_CTX_RGB_YUV_GC         @ lr = k[], r12 = pCtx
     LDR         r6,   [sp,  #36]                        @ roi width
     LDR         r7,   [sp,  #40]                        @ roi height
                                                         @ prepare some constants:
@@ -2786,10 +2788,10 @@ ARGB8888_UYVY_GC_line_tail:
 @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
 @ Purpose:    RGB565 -> NV12
 @
-@ void gpu_csc_RGBToNV12(
+@ void gpu_csc_RGBToNV12_ex(
 @          const Ipp16u* pSrc, int srcSL,
 @          Ipp8u* pDst[2], int dstSL[2],
-@          int width, int height)
+@          int width, int height, const GPU_CSC_CONTEXT* pCtx)
 @
 @   ARM Registers Assignment:
 @       r0          :   pSrc, pSrcLine 1
@@ -2826,10 +2828,11 @@ ARGB8888_UYVY_GC_line_tail:
 @
 @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
 
-gpu_csc_RGBToNV12:
+gpu_csc_RGBToNV12_ex:
     STMDB       sp!,  {r4 - r11, lr}                    @ push registers
     VSTMDB      sp!,  {d8 - d11}
-    LDR         lr,   =RGB_YUV_Q10                      @ lr = k[]
+    LDR         lr,   [sp,  #76]                        @ pCtx
+    ADD         lr,   lr,   #CSC_CTX_RGB_YUV_Q10        @ lr = k[]
     LDR         r6,   [sp,  #68]                        @ roi width
     LDR         r7,   [sp,  #72]                        @ roi height
                                                         @ prepare some constants:
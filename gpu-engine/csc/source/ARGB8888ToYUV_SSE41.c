@@ -0,0 +1,347 @@
+/***********************************************************************************
+ *
+ *    Copyright (c) 2012 - 2013 by Marvell International Ltd. and its affiliates.
+ *    All rights reserved.
+ *
+ *    This software file (the "File") is owned and distributed by Marvell
+ *    International Ltd. and/or its affiliates ("Marvell") under Marvell Commercial
+ *    License.
+ *
+ *    If you received this File from Marvell and you have entered into a commercial
+ *    license agreement (a "Commercial License") with Marvell, the File is licensed
+ *    to you under the terms of the applicable Commercial License.
+ *
+ ***********************************************************************************/
+
+#include <smmintrin.h>
+#include "ARGB8888ToYUV.h"
+
+/*
+// SSE4.1 row kernels, 8 pixels per step.
+// All arithmetic stays in 32-bit lanes with the same shifts and rounding
+// constants as ARGB8888ToYUV_C.c, so the output is bit-exact with it:
+// (Ipp8u) casts become a 0xff mask, SAT_DK lookups a clamp to [0, 255].
+*/
+#define CSC_SSE41 __attribute__((target("sse4.1")))
+
+static CSC_SSE41 inline void unpackARGB(__m128i px, __m128i* r, __m128i* g, __m128i* b)
+{
+    const __m128i mask = _mm_set1_epi32(0xff);
+
+    *b = _mm_and_si128(px, mask);
+    *g = _mm_and_si128(_mm_srli_epi32(px, 8), mask);
+    *r = _mm_and_si128(_mm_srli_epi32(px, 16), mask);
+}
+
+static CSC_SSE41 inline void unpackRGB565(__m128i px, __m128i* r, __m128i* g, __m128i* b)
+{
+    const __m128i mask5 = _mm_set1_epi32(0x1f);
+    const __m128i mask6 = _mm_set1_epi32(0x3f);
+    __m128i c;
+
+    c  = _mm_srli_epi32(px, 11);
+    *r = _mm_or_si128(_mm_slli_epi32(c, 3), _mm_srli_epi32(c, 2));
+    c  = _mm_and_si128(_mm_srli_epi32(px, 5), mask6);
+    *g = _mm_or_si128(_mm_slli_epi32(c, 2), _mm_srli_epi32(c, 4));
+    c  = _mm_and_si128(px, mask5);
+    *b = _mm_or_si128(_mm_slli_epi32(c, 3), _mm_srli_epi32(c, 2));
+}
+
+static CSC_SSE41 inline __m128i dot3(__m128i r, __m128i g, __m128i b, __m128i k0, __m128i k1, __m128i k2)
+{
+    return _mm_add_epi32(_mm_add_epi32(_mm_mullo_epi32(k0, r), _mm_mullo_epi32(k1, g)), _mm_mullo_epi32(k2, b));
+}
+
+/* store 8 lanes of two vectors as bytes, keeping only the low 8 bits like the C cast */
+static CSC_SSE41 inline void storeY8(Ipp8u* dst, __m128i y0, __m128i y1)
+{
+    const __m128i mask = _mm_set1_epi32(0xff);
+    __m128i y = _mm_packus_epi32(_mm_and_si128(y0, mask), _mm_and_si128(y1, mask));
+
+    _mm_storel_epi64((__m128i*)dst, _mm_packus_epi16(y, y));
+}
+
+/* u and v hold 4 chroma samples already in [0, 255] */
+static CSC_SSE41 inline void storeUV4(Ipp8u* dstA, Ipp8u* dstB, __m128i u, __m128i v, int layout)
+{
+    __m128i c;
+
+    if(layout == GPU_CSC_LAYOUT_PLANAR)
+    {
+        c = _mm_packus_epi32(u, v);
+        c = _mm_packus_epi16(c, c);
+        *(int*)dstA = _mm_cvtsi128_si32(c);
+        *(int*)dstB = _mm_extract_epi32(c, 1);
+    }
+    else
+    {
+        if(layout == GPU_CSC_LAYOUT_UV)
+        {
+            c = _mm_or_si128(u, _mm_slli_epi32(v, 8));
+        }
+        else
+        {
+            c = _mm_or_si128(v, _mm_slli_epi32(u, 8));
+        }
+        _mm_storel_epi64((__m128i*)dstA, _mm_packus_epi32(c, c));
+    }
+}
+
+/*
+// Fixed point chroma of 2x2 blocks:
+// sums of R and B and of the 4 unshifted luma values per lane
+*/
+static CSC_SSE41 inline void chroma420Fixed(__m128i R, __m128i B, __m128i ysum,
+                                            __m128i k3, __m128i k4, __m128i* u, __m128i* v)
+{
+    const __m128i round = _mm_set1_epi32(0x20000);
+    const __m128i bias  = _mm_set1_epi32(128);
+    const __m128i mask  = _mm_set1_epi32(0xff);
+    __m128i t;
+
+    t  = _mm_srai_epi32(_mm_add_epi32(_mm_sub_epi32(_mm_slli_epi32(B, 16), ysum), round), 16);
+    t  = _mm_add_epi32(_mm_srai_epi32(_mm_mullo_epi32(k3, t), 18), bias);
+    *u = _mm_and_si128(t, mask);
+
+    t  = _mm_srai_epi32(_mm_add_epi32(_mm_sub_epi32(_mm_slli_epi32(R, 16), ysum), round), 16);
+    t  = _mm_add_epi32(_mm_srai_epi32(_mm_mullo_epi32(k4, t), 18), bias);
+    *v = _mm_min_epi32(_mm_max_epi32(t, _mm_setzero_si128()), mask);
+}
+
+/* r/g/b[0..1] are pixels 0-3/4-7 of row 0, r/g/b[2..3] the same of row 1 */
+static CSC_SSE41 inline void block420Fixed(__m128i* r, __m128i* g, __m128i* b,
+                                           Ipp8u* dsty0, Ipp8u* dsty1, Ipp8u* dstA, Ipp8u* dstB,
+                                           int layout, const Ipp32s* k)
+{
+    __m128i k0 = _mm_set1_epi32(k[0]);
+    __m128i k1 = _mm_set1_epi32(k[1]);
+    __m128i k2 = _mm_set1_epi32(k[2]);
+    __m128i y[4], R, B, ysum, u, v;
+    int i;
+
+    for(i = 0;  i < 4;  i++)
+    {
+        y[i] = dot3(r[i], g[i], b[i], k0, k1, k2);
+    }
+    storeY8(dsty0, _mm_srai_epi32(y[0], 16), _mm_srai_epi32(y[1], 16));
+    storeY8(dsty1, _mm_srai_epi32(y[2], 16), _mm_srai_epi32(y[3], 16));
+
+    R    = _mm_add_epi32(_mm_hadd_epi32(r[0], r[1]), _mm_hadd_epi32(r[2], r[3]));
+    B    = _mm_add_epi32(_mm_hadd_epi32(b[0], b[1]), _mm_hadd_epi32(b[2], b[3]));
+    ysum = _mm_add_epi32(_mm_hadd_epi32(y[0], y[1]), _mm_hadd_epi32(y[2], y[3]));
+    chroma420Fixed(R, B, ysum, _mm_set1_epi32(k[3]), _mm_set1_epi32(k[4]), &u, &v);
+    storeUV4(dstA, dstB, u, v, layout);
+}
+
+CSC_SSE41 void rowARGBToYUV420_Fixed_SSE41(const Ipp8u* src0, const Ipp8u* src1,
+                                           Ipp8u* dsty0, Ipp8u* dsty1,
+                                           Ipp8u* dstA, Ipp8u* dstB,
+                                           int width, int layout, const Ipp32s* k)
+{
+    int step = (layout == GPU_CSC_LAYOUT_PLANAR) ? 4 : 8;
+    int w;
+
+    for(w = 0;  w < width;  w += 8)
+    {
+        __m128i r[4], g[4], b[4];
+
+        unpackARGB(_mm_loadu_si128((const __m128i*)(src0 +  0)), &r[0], &g[0], &b[0]);
+        unpackARGB(_mm_loadu_si128((const __m128i*)(src0 + 16)), &r[1], &g[1], &b[1]);
+        unpackARGB(_mm_loadu_si128((const __m128i*)(src1 +  0)), &r[2], &g[2], &b[2]);
+        unpackARGB(_mm_loadu_si128((const __m128i*)(src1 + 16)), &r[3], &g[3], &b[3]);
+        block420Fixed(r, g, b, dsty0, dsty1, dstA, dstB, layout, k);
+
+        src0  += 32;
+        src1  += 32;
+        dsty0 += 8;
+        dsty1 += 8;
+        dstA  += step;
+        dstB  += 4;
+    }
+}
+
+CSC_SSE41 void rowRGB565ToYUV420_Fixed_SSE41(const Ipp8u* src0, const Ipp8u* src1,
+                                             Ipp8u* dsty0, Ipp8u* dsty1,
+                                             Ipp8u* dstA, Ipp8u* dstB,
+                                             int width, int layout, const Ipp32s* k)
+{
+    int step = (layout == GPU_CSC_LAYOUT_PLANAR) ? 4 : 8;
+    int w;
+
+    for(w = 0;  w < width;  w += 8)
+    {
+        __m128i r[4], g[4], b[4];
+        __m128i p0 = _mm_loadu_si128((const __m128i*)src0);
+        __m128i p1 = _mm_loadu_si128((const __m128i*)src1);
+
+        unpackRGB565(_mm_cvtepu16_epi32(p0), &r[0], &g[0], &b[0]);
+        unpackRGB565(_mm_cvtepu16_epi32(_mm_srli_si128(p0, 8)), &r[1], &g[1], &b[1]);
+        unpackRGB565(_mm_cvtepu16_epi32(p1), &r[2], &g[2], &b[2]);
+        unpackRGB565(_mm_cvtepu16_epi32(_mm_srli_si128(p1, 8)), &r[3], &g[3], &b[3]);
+        block420Fixed(r, g, b, dsty0, dsty1, dstA, dstB, layout, k);
+
+        src0  += 16;
+        src1  += 16;
+        dsty0 += 8;
+        dsty1 += 8;
+        dstA  += step;
+        dstB  += 4;
+    }
+}
+
+CSC_SSE41 void rowARGBToYUV420_Int_SSE41(const Ipp8u* src0, const Ipp8u* src1,
+                                         Ipp8u* dsty0, Ipp8u* dsty1,
+                                         Ipp8u* dstA, Ipp8u* dstB,
+                                         int width, int layout, const Ipp32s* k)
+{
+    const __m128i mask = _mm_set1_epi32(0xff);
+    __m128i k0  = _mm_set1_epi32(k[0]);
+    __m128i k1  = _mm_set1_epi32(k[1]);
+    __m128i k2  = _mm_set1_epi32(k[2]);
+    __m128i k3  = _mm_set1_epi32(k[3]);
+    __m128i k4  = _mm_set1_epi32(k[4]);
+    __m128i k5  = _mm_set1_epi32(k[5]);
+    __m128i k6  = _mm_set1_epi32(k[6]);
+    __m128i k7  = _mm_set1_epi32(k[7]);
+    __m128i k8  = _mm_set1_epi32(k[8]);
+    __m128i k9  = _mm_set1_epi32(k[9]);
+    __m128i k10 = _mm_set1_epi32(k[10]);
+    __m128i k11 = _mm_set1_epi32(k[11]);
+    __m128i yround = _mm_set1_epi32(128);
+    __m128i cround = _mm_set1_epi32(512);
+    int step = (layout == GPU_CSC_LAYOUT_PLANAR) ? 4 : 8;
+    int w;
+
+    for(w = 0;  w < width;  w += 8)
+    {
+        __m128i r[4], g[4], b[4], y[4];
+        __m128i R, G, B, u, v;
+        int i;
+
+        unpackARGB(_mm_loadu_si128((const __m128i*)(src0 +  0)), &r[0], &g[0], &b[0]);
+        unpackARGB(_mm_loadu_si128((const __m128i*)(src0 + 16)), &r[1], &g[1], &b[1]);
+        unpackARGB(_mm_loadu_si128((const __m128i*)(src1 +  0)), &r[2], &g[2], &b[2]);
+        unpackARGB(_mm_loadu_si128((const __m128i*)(src1 + 16)), &r[3], &g[3], &b[3]);
+
+        for(i = 0;  i < 4;  i++)
+        {
+            y[i] = _mm_add_epi32(dot3(r[i], g[i], b[i], k0, k1, k2), yround);
+            y[i] = _mm_add_epi32(_mm_srai_epi32(y[i], 8), k3);
+        }
+        storeY8(dsty0, y[0], y[1]);
+        storeY8(dsty1, y[2], y[3]);
+
+        R = _mm_add_epi32(_mm_hadd_epi32(r[0], r[1]), _mm_hadd_epi32(r[2], r[3]));
+        G = _mm_add_epi32(_mm_hadd_epi32(g[0], g[1]), _mm_hadd_epi32(g[2], g[3]));
+        B = _mm_add_epi32(_mm_hadd_epi32(b[0], b[1]), _mm_hadd_epi32(b[2], b[3]));
+
+        u = _mm_add_epi32(dot3(R, G, B, k4, k5, k6), cround);
+        u = _mm_and_si128(_mm_add_epi32(_mm_srai_epi32(u, 10), k7), mask);
+        v = _mm_add_epi32(dot3(R, G, B, k8, k9, k10), cround);
+        v = _mm_and_si128(_mm_add_epi32(_mm_srai_epi32(v, 10), k11), mask);
+        storeUV4(dstA, dstB, u, v, layout);
+
+        src0  += 32;
+        src1  += 32;
+        dsty0 += 8;
+        dsty1 += 8;
+        dstA  += step;
+        dstB  += 4;
+    }
+}
+
+/* one UYVY word per pixel pair: U | Y0 << 8 | V << 16 | Y1 << 24 */
+static CSC_SSE41 inline __m128i packUYVY(__m128i ya, __m128i yb, __m128i u, __m128i v)
+{
+    const __m128i mask = _mm_set1_epi32(0xff);
+    __m128i y0 = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(ya), _mm_castsi128_ps(yb), _MM_SHUFFLE(2, 0, 2, 0)));
+    __m128i y1 = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(ya), _mm_castsi128_ps(yb), _MM_SHUFFLE(3, 1, 3, 1)));
+
+    y0 = _mm_slli_epi32(_mm_and_si128(y0, mask), 8);
+    y1 = _mm_slli_epi32(y1, 24);
+    v  = _mm_slli_epi32(v, 16);
+    return _mm_or_si128(_mm_or_si128(u, y0), _mm_or_si128(v, y1));
+}
+
+CSC_SSE41 void rowARGBToUYVY_Fixed_SSE41(const Ipp8u* src, Ipp8u* dst, int width, const Ipp32s* k)
+{
+    const __m128i round = _mm_set1_epi32(0xffff);
+    const __m128i bias  = _mm_set1_epi32(128);
+    const __m128i mask  = _mm_set1_epi32(0xff);
+    __m128i k0 = _mm_set1_epi32(k[0]);
+    __m128i k1 = _mm_set1_epi32(k[1]);
+    __m128i k2 = _mm_set1_epi32(k[2]);
+    __m128i k3 = _mm_set1_epi32(k[3]);
+    __m128i k4 = _mm_set1_epi32(k[4]);
+    int w;
+
+    for(w = 0;  w < width;  w += 8)
+    {
+        __m128i ra, ga, ba, rb, gb, bb;
+        __m128i ya, yb, ysum, R, B, u, v;
+
+        unpackARGB(_mm_loadu_si128((const __m128i*)(src +  0)), &ra, &ga, &ba);
+        unpackARGB(_mm_loadu_si128((const __m128i*)(src + 16)), &rb, &gb, &bb);
+        ya   = dot3(ra, ga, ba, k0, k1, k2);
+        yb   = dot3(rb, gb, bb, k0, k1, k2);
+        ysum = _mm_hadd_epi32(ya, yb);
+        R    = _mm_hadd_epi32(ra, rb);
+        B    = _mm_hadd_epi32(ba, bb);
+
+        u = _mm_srai_epi32(_mm_add_epi32(_mm_sub_epi32(_mm_slli_epi32(B, 16), ysum), round), 16);
+        u = _mm_add_epi32(_mm_srai_epi32(_mm_mullo_epi32(k3, u), 17), bias);
+        u = _mm_and_si128(u, mask);
+        v = _mm_srai_epi32(_mm_add_epi32(_mm_sub_epi32(_mm_slli_epi32(R, 16), ysum), round), 16);
+        v = _mm_add_epi32(_mm_srai_epi32(_mm_mullo_epi32(k4, v), 17), bias);
+        v = _mm_min_epi32(_mm_max_epi32(v, _mm_setzero_si128()), mask);
+
+        _mm_storeu_si128((__m128i*)dst, packUYVY(_mm_srai_epi32(ya, 16), _mm_srai_epi32(yb, 16), u, v));
+        src += 32;
+        dst += 16;
+    }
+}
+
+CSC_SSE41 void rowARGBToUYVY_Int_SSE41(const Ipp8u* src, Ipp8u* dst, int width, const Ipp32s* k)
+{
+    const __m128i mask = _mm_set1_epi32(0xff);
+    __m128i k0  = _mm_set1_epi32(k[0]);
+    __m128i k1  = _mm_set1_epi32(k[1]);
+    __m128i k2  = _mm_set1_epi32(k[2]);
+    __m128i k3  = _mm_set1_epi32(k[3]);
+    __m128i k4  = _mm_set1_epi32(k[4]);
+    __m128i k5  = _mm_set1_epi32(k[5]);
+    __m128i k6  = _mm_set1_epi32(k[6]);
+    __m128i k7  = _mm_set1_epi32(k[7]);
+    __m128i k8  = _mm_set1_epi32(k[8]);
+    __m128i k9  = _mm_set1_epi32(k[9]);
+    __m128i k10 = _mm_set1_epi32(k[10]);
+    __m128i k11 = _mm_set1_epi32(k[11]);
+    __m128i yround = _mm_set1_epi32(128);
+    __m128i cround = _mm_set1_epi32(256);
+    int w;
+
+    for(w = 0;  w < width;  w += 8)
+    {
+        __m128i ra, ga, ba, rb, gb, bb;
+        __m128i ya, yb, R, G, B, u, v;
+
+        unpackARGB(_mm_loadu_si128((const __m128i*)(src +  0)), &ra, &ga, &ba);
+        unpackARGB(_mm_loadu_si128((const __m128i*)(src + 16)), &rb, &gb, &bb);
+        ya = _mm_add_epi32(dot3(ra, ga, ba, k0, k1, k2), yround);
+        ya = _mm_add_epi32(_mm_srai_epi32(ya, 8), k3);
+        yb = _mm_add_epi32(dot3(rb, gb, bb, k0, k1, k2), yround);
+        yb = _mm_add_epi32(_mm_srai_epi32(yb, 8), k3);
+        R  = _mm_hadd_epi32(ra, rb);
+        G  = _mm_hadd_epi32(ga, gb);
+        B  = _mm_hadd_epi32(ba, bb);
+
+        u = _mm_add_epi32(dot3(R, G, B, k4, k5, k6), cround);
+        u = _mm_and_si128(_mm_add_epi32(_mm_srai_epi32(u, 9), k7), mask);
+        v = _mm_add_epi32(dot3(R, G, B, k8, k9, k10), cround);
+        v = _mm_and_si128(_mm_add_epi32(_mm_srai_epi32(v, 9), k11), mask);
+
+        _mm_storeu_si128((__m128i*)dst, packUYVY(ya, yb, u, v));
+        src += 32;
+        dst += 16;
+    }
+}
@@ -0,0 +1,308 @@
+/***********************************************************************************
+ *
+ *    Copyright (c) 2012 - 2013 by Marvell International Ltd. and its affiliates.
+ *    All rights reserved.
+ *
+ *    This software file (the "File") is owned and distributed by Marvell
+ *    International Ltd. and/or its affiliates ("Marvell") under Marvell Commercial
+ *    License.
+ *
+ *    If you received this File from Marvell and you have entered into a commercial
+ *    license agreement (a "Commercial License") with Marvell, the File is licensed
+ *    to you under the terms of the applicable Commercial License.
+ *
+ ***********************************************************************************/
+
+#include <pthread.h>
+#include "ARGB8888ToYUV.h"
+
+/*
+// The SIMD row kernels cover the largest vector aligned block of even rows,
+// the scalar path converts the rest: the columns right of that block and
+// the last row of an odd height. Both write whole 2x2 chroma blocks, so
+// splitting the frame this way gives the same output as the scalar path.
+*/
+typedef void (*GPU_CSC_RECT420)(const Ipp8u* pSrc, int srcStep,
+                                Ipp8u** pDst, int* dstStep,
+                                int width, int height, const GPU_CSC_CONTEXT* pCtx);
+
+static void csc420Offset(Ipp8u** pDst, int* dstStep, int layout,
+                         int x, int y, Ipp8u* pOut[3])
+{
+    pOut[0] = pDst[0] + y * dstStep[0] + x;
+    if(layout == GPU_CSC_LAYOUT_PLANAR)
+    {
+        pOut[1] = pDst[1] + (y >> 1) * dstStep[1] + (x >> 1);
+        pOut[2] = pDst[2] + (y >> 1) * dstStep[2] + (x >> 1);
+    }
+    else
+    {
+        pOut[1] = pDst[1] + (y >> 1) * dstStep[1] + x;
+        pOut[2] = NULL;
+    }
+}
+
+static void csc420Frame(const Ipp8u* pSrc, int srcStep, int bpp,
+                        Ipp8u** pDst, int* dstStep,
+                        int width, int height, int layout,
+                        int pixels, GPU_CSC_ROW420 row, const Ipp32s* k,
+                        GPU_CSC_RECT420 edge, const GPU_CSC_CONTEXT* pCtx)
+{
+    int widthV  = width & ~(pixels - 1);
+    int heightV = height & ~1;
+    Ipp8u* pOut[3];
+    int h;
+
+    if(widthV > 0)
+    {
+        for(h = 0;  h < heightV;  h += 2)
+        {
+            const Ipp8u* src0 = pSrc + h * srcStep;
+
+            csc420Offset(pDst, dstStep, layout, 0, h, pOut);
+            row(src0, src0 + srcStep, pOut[0], pOut[0] + dstStep[0],
+                pOut[1], pOut[2], widthV, layout, k);
+        }
+        if(height & 1)
+        {
+            csc420Offset(pDst, dstStep, layout, 0, heightV, pOut);
+            edge(pSrc + heightV * srcStep, srcStep, pOut, dstStep, widthV, 1, pCtx);
+        }
+    }
+    if(widthV < width)
+    {
+        csc420Offset(pDst, dstStep, layout, widthV, 0, pOut);
+        edge(pSrc + widthV * bpp, srcStep, pOut, dstStep, width - widthV, height, pCtx);
+    }
+}
+
+static void csc422Frame(const Ipp8u* pSrc, int srcStep,
+                        Ipp8u* pDst, int dstStep,
+                        int width, int height,
+                        int pixels, GPU_CSC_ROW422 row, const Ipp32s* k,
+                        const GPU_CSC_CONTEXT* pCtx)
+{
+    int widthV = width & ~(pixels - 1);
+    int h;
+
+    if(widthV > 0)
+    {
+        for(h = 0;  h < height;  h++)
+        {
+            row(pSrc + h * srcStep, pDst + h * dstStep, widthV, k);
+        }
+    }
+    if(widthV < width)
+    {
+        gpu_csc_ARGBToUYVY_C(pSrc + widthV * 4, srcStep, pDst + widthV * 2, dstStep,
+                             width - widthV, height, pCtx);
+    }
+}
+
+/* GC coefficients widened to the 32-bit lanes the kernels use */
+static void cscIntCoef(const GPU_CSC_CONTEXT* pCtx, Ipp32s k[12])
+{
+    int i;
+
+    for(i = 0;  i < 12;  i++)
+    {
+        k[i] = pCtx->rgbYuvGC[i];
+    }
+}
+
+#define GPU_CSC_DEFINE_BACKEND(suffix, pixels)                                                      \
+void gpu_csc_ARGBToI420_##suffix(const Ipp8u* pSrc, int srcStep,                                    \
+                                 Ipp8u* pDst[3], int dstStep[3], int width, int height,             \
+                                 const GPU_CSC_CONTEXT* pCtx)                                       \
+{                                                                                                   \
+    Ipp32s k[12];                                                                                   \
+    if(pCtx->formula & GPU_CSC_FORMULA_BT601)                                                       \
+    {                                                                                               \
+        csc420Frame(pSrc, srcStep, 4, pDst, dstStep, width, height, GPU_CSC_LAYOUT_PLANAR,          \
+                    pixels, rowARGBToYUV420_Fixed_##suffix, pCtx->rgbYuv, gpu_csc_ARGBToI420_C,     \
+                    pCtx);                                                                          \
+    }                                                                                               \
+    else                                                                                            \
+    {                                                                                               \
+        cscIntCoef(pCtx, k);                                                                        \
+        csc420Frame(pSrc, srcStep, 4, pDst, dstStep, width, height, GPU_CSC_LAYOUT_PLANAR,          \
+                    pixels, rowARGBToYUV420_Int_##suffix, k, gpu_csc_ARGBToI420_C, pCtx);           \
+    }                                                                                               \
+}                                                                                                   \
+                                                                                                    \
+void gpu_csc_ARGBToNV21_##suffix(const Ipp8u* pSrc, int srcStep,                                    \
+                                 Ipp8u* pDst[2], int dstStep[2], int width, int height,             \
+                                 const GPU_CSC_CONTEXT* pCtx)                                       \
+{                                                                                                   \
+    Ipp32s k[12];                                                                                   \
+    if(pCtx->formula & GPU_CSC_FORMULA_BT601)                                                       \
+    {                                                                                               \
+        csc420Frame(pSrc, srcStep, 4, pDst, dstStep, width, height, GPU_CSC_LAYOUT_VU,              \
+                    pixels, rowARGBToYUV420_Fixed_##suffix, pCtx->rgbYuv, gpu_csc_ARGBToNV21_C,     \
+                    pCtx);                                                                          \
+    }                                                                                               \
+    else                                                                                            \
+    {                                                                                               \
+        cscIntCoef(pCtx, k);                                                                        \
+        csc420Frame(pSrc, srcStep, 4, pDst, dstStep, width, height, GPU_CSC_LAYOUT_VU,              \
+                    pixels, rowARGBToYUV420_Int_##suffix, k, gpu_csc_ARGBToNV21_C, pCtx);           \
+    }                                                                                               \
+}                                                                                                   \
+                                                                                                    \
+void gpu_csc_ARGBToNV12_##suffix(const Ipp8u* pSrc, int srcStep,                                    \
+                                 Ipp8u* pDst[2], int dstStep[2], int width, int height,             \
+                                 const GPU_CSC_CONTEXT* pCtx)                                       \
+{                                                                                                   \
+    Ipp32s k[12];                                                                                   \
+    if(pCtx->formula & GPU_CSC_FORMULA_BT601)                                                       \
+    {                                                                                               \
+        csc420Frame(pSrc, srcStep, 4, pDst, dstStep, width, height, GPU_CSC_LAYOUT_UV,              \
+                    pixels, rowARGBToYUV420_Fixed_##suffix, pCtx->rgbYuv, gpu_csc_ARGBToNV12_C,     \
+                    pCtx);                                                                          \
+    }                                                                                               \
+    else                                                                                            \
+    {                                                                                               \
+        cscIntCoef(pCtx, k);                                                                        \
+        csc420Frame(pSrc, srcStep, 4, pDst, dstStep, width, height, GPU_CSC_LAYOUT_UV,              \
+                    pixels, rowARGBToYUV420_Int_##suffix, k, gpu_csc_ARGBToNV12_C, pCtx);           \
+    }                                                                                               \
+}                                                                                                   \
+                                                                                                    \
+void gpu_csc_RGBToNV12_##suffix(const Ipp8u* pSrc, int srcStep,                                     \
+                                Ipp8u* pDst[2], int dstStep[2], int width, int height,              \
+                                const GPU_CSC_CONTEXT* pCtx)                                        \
+{                                                                                                   \
+    csc420Frame(pSrc, srcStep, 2, pDst, dstStep, width, height, GPU_CSC_LAYOUT_UV,                  \
+                pixels, rowRGB565ToYUV420_Fixed_##suffix, pCtx->rgbYuv, gpu_csc_RGBToNV12_C,        \
+                pCtx);                                                                              \
+}                                                                                                   \
+                                                                                                    \
+void gpu_csc_ARGBToUYVY_##suffix(const Ipp8u* pSrc, int srcStep,                                    \
+                                 Ipp8u* pDst, int dstStep, int width, int height,                   \
+                                 const GPU_CSC_CONTEXT* pCtx)                                       \
+{                                                                                                   \
+    Ipp32s k[12];                                                                                   \
+    if(pCtx->formula & GPU_CSC_FORMULA_BT601)                                                       \
+    {                                                                                               \
+        csc422Frame(pSrc, srcStep, pDst, dstStep, width, height,                                    \
+                    pixels, rowARGBToUYVY_Fixed_##suffix, pCtx->rgbYuv, pCtx);                      \
+    }                                                                                               \
+    else                                                                                            \
+    {                                                                                               \
+        cscIntCoef(pCtx, k);                                                                        \
+        csc422Frame(pSrc, srcStep, pDst, dstStep, width, height,                                    \
+                    pixels, rowARGBToUYVY_Int_##suffix, k, pCtx);                                   \
+    }                                                                                               \
+}
+
+GPU_CSC_DEFINE_BACKEND(SSE41, GPU_CSC_SSE41_PIXELS)
+GPU_CSC_DEFINE_BACKEND(AVX2, GPU_CSC_AVX2_PIXELS)
+
+/*
+// Runtime dispatch
+*/
+typedef struct _GPU_CSC_BACKEND{
+    void (*ARGBToI420)(const Ipp8u*, int, Ipp8u**, int*, int, int, const GPU_CSC_CONTEXT*);
+    void (*ARGBToUYVY)(const Ipp8u*, int, Ipp8u*, int, int, int, const GPU_CSC_CONTEXT*);
+    void (*ARGBToNV21)(const Ipp8u*, int, Ipp8u**, int*, int, int, const GPU_CSC_CONTEXT*);
+    void (*ARGBToNV12)(const Ipp8u*, int, Ipp8u**, int*, int, int, const GPU_CSC_CONTEXT*);
+    void (*RGBToNV12)(const Ipp8u*, int, Ipp8u**, int*, int, int, const GPU_CSC_CONTEXT*);
+}GPU_CSC_BACKEND;
+
+static const GPU_CSC_BACKEND g_BackendC = {
+    gpu_csc_ARGBToI420_C,
+    gpu_csc_ARGBToUYVY_C,
+    gpu_csc_ARGBToNV21_C,
+    gpu_csc_ARGBToNV12_C,
+    gpu_csc_RGBToNV12_C
+};
+
+static const GPU_CSC_BACKEND g_BackendSSE41 = {
+    gpu_csc_ARGBToI420_SSE41,
+    gpu_csc_ARGBToUYVY_SSE41,
+    gpu_csc_ARGBToNV21_SSE41,
+    gpu_csc_ARGBToNV12_SSE41,
+    gpu_csc_RGBToNV12_SSE41
+};
+
+static const GPU_CSC_BACKEND g_BackendAVX2 = {
+    gpu_csc_ARGBToI420_AVX2,
+    gpu_csc_ARGBToUYVY_AVX2,
+    gpu_csc_ARGBToNV21_AVX2,
+    gpu_csc_ARGBToNV12_AVX2,
+    gpu_csc_RGBToNV12_AVX2
+};
+
+static const GPU_CSC_BACKEND* g_pBackend = &g_BackendC;
+static pthread_once_t g_BackendOnce = PTHREAD_ONCE_INIT;
+
+Ipp32u gpu_csc_GetX86Features(void)
+{
+    Ipp32u features = 0;
+
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("sse4.1"))
+    {
+        features |= GPU_CSC_X86_SSE41;
+    }
+    if(__builtin_cpu_supports("avx2"))
+    {
+        features |= GPU_CSC_X86_AVX2;
+    }
+    return features;
+}
+
+static void gpu_csc_InitBackend(void)
+{
+    Ipp32u features = gpu_csc_GetX86Features();
+
+    if(features & GPU_CSC_X86_AVX2)
+    {
+        g_pBackend = &g_BackendAVX2;
+    }
+    else if(features & GPU_CSC_X86_SSE41)
+    {
+        g_pBackend = &g_BackendSSE41;
+    }
+}
+
+static const GPU_CSC_BACKEND* gpu_csc_GetBackend(void)
+{
+    pthread_once(&g_BackendOnce, gpu_csc_InitBackend);
+    return g_pBackend;
+}
+
+void gpu_csc_ARGBToI420_ex(const unsigned char* pSrc, GCUint srcStride,
+                           unsigned char* pDst[3], GCUint dstStride[3],
+                           GCUint width, GCUint height, const GPU_CSC_CONTEXT* pCtx)
+{
+    gpu_csc_GetBackend()->ARGBToI420(pSrc, srcStride, pDst, dstStride, width, height, pCtx);
+}
+
+void gpu_csc_ARGBToUYVY_ex(const unsigned char* pSrc, GCUint srcStride,
+                           unsigned char* pDst, GCUint dstStride,
+                           GCUint width, GCUint height, const GPU_CSC_CONTEXT* pCtx)
+{
+    gpu_csc_GetBackend()->ARGBToUYVY(pSrc, srcStride, pDst, dstStride, width, height, pCtx);
+}
+
+void gpu_csc_ARGBToNV21_ex(const unsigned char* pSrc, GCUint srcStride,
+                           unsigned char* pDst[2], GCUint dstStride[2],
+                           GCUint width, GCUint height, const GPU_CSC_CONTEXT* pCtx)
+{
+    gpu_csc_GetBackend()->ARGBToNV21(pSrc, srcStride, pDst, dstStride, width, height, pCtx);
+}
+
+void gpu_csc_ARGBToNV12_ex(const unsigned char* pSrc, GCUint srcStride,
+                           unsigned char* pDst[2], GCUint dstStride[2],
+                           GCUint width, GCUint height, const GPU_CSC_CONTEXT* pCtx)
+{
+    gpu_csc_GetBackend()->ARGBToNV12(pSrc, srcStride, pDst, dstStride, width, height, pCtx);
+}
+
+void gpu_csc_RGBToNV12_ex(const unsigned char* pSrc, GCUint srcStride,
+                          unsigned char* pDst[2], GCUint dstStride[2],
+                          GCUint width, GCUint height, const GPU_CSC_CONTEXT* pCtx)
+{
+    gpu_csc_GetBackend()->RGBToNV12(pSrc, srcStride, pDst, dstStride, width, height, pCtx);
+}
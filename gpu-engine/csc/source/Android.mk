@@ -3,7 +3,7 @@ LOCAL_PATH := $(call my-dir)
 
 include $(CLEAR_VARS)
 
-LOCAL_SRC_FILES := gpu_csc.cpp ARGB8888ToYUV_data.c
+LOCAL_SRC_FILES := gpu_csc.cpp gpu_csc_mt.c ARGB8888ToYUV_data.c
 
 LOCAL_SHARED_LIBRARIES := libgcu libcutils
 
@@ -11,6 +11,10 @@ ifeq ($(ARCH_ARM_HAVE_NEON),true)
     LOCAL_SRC_FILES += ARGB8888ToYUV_NEON.s
 else
     LOCAL_SRC_FILES += ARGB8888ToYUV_C.c
+ifneq ($(filter x86 x86_64,$(TARGET_ARCH)),)
+    LOCAL_SRC_FILES += ARGB8888ToYUV_x86.c ARGB8888ToYUV_SSE41.c ARGB8888ToYUV_AVX2.c
+    LOCAL_CFLAGS += -DGPU_CSC_X86_SIMD
+endif
 endif
 
 LOCAL_LDFLAGS += -Wl,--no-warn-shared-textrel
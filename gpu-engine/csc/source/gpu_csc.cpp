@@ -78,7 +78,7 @@ GCUbool _gcuConvertARGB2YUV(GCUContext pContext, GCUSurface pARGBSurface, GCUSur
                 {
                     pDst[0]     = (unsigned char*)allocDstInfos[0].virtualAddr;
                     dstStep[0]  = allocDstInfos[0].stride;
-                    gpu_csc_ARGBToUYVY((unsigned char*)allocSrcInfos.virtualAddr, allocSrcInfos.stride, pDst[0], dstStep[0], allocSrcInfos.width, allocSrcInfos.height);
+                    gpu_csc_ARGBToUYVY_MT((unsigned char*)allocSrcInfos.virtualAddr, allocSrcInfos.stride, pDst[0], dstStep[0], allocSrcInfos.width, allocSrcInfos.height);
                     break;
                 }
 
@@ -88,7 +88,7 @@ GCUbool _gcuConvertARGB2YUV(GCUContext pContext, GCUSurface pARGBSurface, GCUSur
                     pDst[1]     = (unsigned char*)allocDstInfos[1].virtualAddr;
                     dstStep[0]  = allocDstInfos[0].stride;
                     dstStep[1]  = allocDstInfos[1].stride;
-                    gpu_csc_ARGBToNV21((unsigned char*)allocSrcInfos.virtualAddr, allocSrcInfos.stride, pDst, dstStep, allocSrcInfos.width, allocSrcInfos.height);
+                    gpu_csc_ARGBToNV21_MT((unsigned char*)allocSrcInfos.virtualAddr, allocSrcInfos.stride, pDst, dstStep, allocSrcInfos.width, allocSrcInfos.height);
                     break;
                 }
 
@@ -101,7 +101,7 @@ GCUbool _gcuConvertARGB2YUV(GCUContext pContext, GCUSurface pARGBSurface, GCUSur
                     dstStep[0]  = allocDstInfos[0].stride;
                     dstStep[1]  = allocDstInfos[1].stride;
                     dstStep[2]  = allocDstInfos[2].stride;
-                    gpu_csc_ARGBToI420((unsigned char*)allocSrcInfos.virtualAddr, allocSrcInfos.stride, pDst, dstStep, allocSrcInfos.width, allocSrcInfos.height);
+                    gpu_csc_ARGBToI420_MT((unsigned char*)allocSrcInfos.virtualAddr, allocSrcInfos.stride, pDst, dstStep, allocSrcInfos.width, allocSrcInfos.height);
                     break;
                 }
 
@@ -113,7 +113,7 @@ GCUbool _gcuConvertARGB2YUV(GCUContext pContext, GCUSurface pARGBSurface, GCUSur
                         pDst[1]     = (unsigned char*) allocDstInfos[1].virtualAddr;
                         dstStep[0]  = allocDstInfos[0].stride;
                         dstStep[1]  = allocDstInfos[1].stride;
-                        gpu_csc_RGBToNV12((unsigned char*)allocSrcInfos.virtualAddr, allocSrcInfos.stride, pDst, dstStep, allocSrcInfos.width, allocSrcInfos.height);
+                        gpu_csc_RGBToNV12_MT((unsigned char*)allocSrcInfos.virtualAddr, allocSrcInfos.stride, pDst, dstStep, allocSrcInfos.width, allocSrcInfos.height);
                     }
                     else
                     {
@@ -121,7 +121,7 @@ GCUbool _gcuConvertARGB2YUV(GCUContext pContext, GCUSurface pARGBSurface, GCUSur
                         pDst[1]     = (unsigned char*)allocDstInfos[1].virtualAddr;
                         dstStep[0]  = allocDstInfos[0].stride;
                         dstStep[1]  = allocDstInfos[1].stride;
-                        gpu_csc_ARGBToNV12((unsigned char*)allocSrcInfos.virtualAddr, allocSrcInfos.stride, pDst, dstStep, allocSrcInfos.width, allocSrcInfos.height);
+                        gpu_csc_ARGBToNV12_MT((unsigned char*)allocSrcInfos.virtualAddr, allocSrcInfos.stride, pDst, dstStep, allocSrcInfos.width, allocSrcInfos.height);
                     }
                     break;
                 }
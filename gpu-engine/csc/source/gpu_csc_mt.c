@@ -0,0 +1,345 @@
+/***********************************************************************************
+ *
+ *    Copyright (c) 2012 - 2013 by Marvell International Ltd. and its affiliates.
+ *    All rights reserved.
+ *
+ *    This software file (the "File") is owned and distributed by Marvell
+ *    International Ltd. and/or its affiliates ("Marvell") under Marvell Commercial
+ *    License.
+ *
+ *    If you received this File from Marvell and you have entered into a commercial
+ *    license agreement (a "Commercial License") with Marvell, the File is licensed
+ *    to you under the terms of the applicable Commercial License.
+ *
+ ***********************************************************************************/
+
+#include <pthread.h>
+#include <unistd.h>
+#include "ARGB8888ToYUV.h"
+
+/*
+// Band parallel colour conversion.
+// A frame is cut into horizontal bands starting on even rows, so no 2x2
+// chroma block straddles two bands, and each band is converted by the
+// single-threaded entry points with the context of the call. The caller
+// converts bands too and returns once every band is done. Worker threads
+// are created on first use and then kept, one conversion runs on the pool
+// at a time.
+*/
+#define GPU_CSC_MAX_BANDS       16
+#define GPU_CSC_MIN_BAND_ROWS   16
+
+typedef enum _GPU_CSC_JOB_TYPE{
+    GPU_CSC_JOB_I420,
+    GPU_CSC_JOB_UYVY,
+    GPU_CSC_JOB_NV21,
+    GPU_CSC_JOB_NV12,
+    GPU_CSC_JOB_RGB_NV12
+}GPU_CSC_JOB_TYPE;
+
+typedef struct _GPU_CSC_JOB{
+    GPU_CSC_JOB_TYPE        type;
+    const unsigned char*    pSrc;
+    GCUint                  srcStride;
+    unsigned char*          pDst[3];
+    GCUint                  dstStride[3];
+    GCUint                  width;
+    GCUint                  height;
+    int                     bands;
+    const GPU_CSC_CONTEXT*  pCtx;
+}GPU_CSC_JOB;
+
+typedef struct _GPU_CSC_POOL{
+    pthread_mutex_t         callLock;       /* one job on the pool at a time */
+    pthread_mutex_t         mutex;          /* protects the fields below     */
+    pthread_cond_t          startCond;
+    pthread_cond_t          doneCond;
+    int                     threadCount;
+    unsigned int            generation;
+    GPU_CSC_JOB*            pJob;
+    int                     nextBand;
+    int                     pending;
+}GPU_CSC_POOL;
+
+static GPU_CSC_POOL g_Pool = {
+    PTHREAD_MUTEX_INITIALIZER,
+    PTHREAD_MUTEX_INITIALIZER,
+    PTHREAD_COND_INITIALIZER,
+    PTHREAD_COND_INITIALIZER,
+    0, 0, NULL, 0, 0
+};
+
+static volatile int g_BandCount = 0;
+
+void gpu_csc_SetBandCount(GCUint count)
+{
+    g_BandCount = (count > GPU_CSC_MAX_BANDS) ? GPU_CSC_MAX_BANDS : count;
+}
+
+GCUint gpu_csc_GetBandCount(void)
+{
+    long cpus;
+
+    if(g_BandCount > 0)
+    {
+        return g_BandCount;
+    }
+    cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if(cpus < 1)
+    {
+        return 1;
+    }
+    return (cpus > GPU_CSC_MAX_BANDS) ? GPU_CSC_MAX_BANDS : (GCUint)cpus;
+}
+
+static void cscRunBand(const GPU_CSC_JOB* pJob, int band)
+{
+    GCUint pairs = pJob->height >> 1;
+    GCUint top   = ((pairs * band) / pJob->bands) << 1;
+    GCUint rows  = (band == pJob->bands - 1) ? pJob->height - top
+                                              : (((pairs * (band + 1)) / pJob->bands) << 1) - top;
+    const unsigned char* pSrc = pJob->pSrc + top * pJob->srcStride;
+    unsigned char* pDst[3];
+
+    if(rows == 0)
+    {
+        return;
+    }
+
+    pDst[0] = pJob->pDst[0] + top * pJob->dstStride[0];
+    switch(pJob->type)
+    {
+        case GPU_CSC_JOB_I420:
+            pDst[1] = pJob->pDst[1] + (top >> 1) * pJob->dstStride[1];
+            pDst[2] = pJob->pDst[2] + (top >> 1) * pJob->dstStride[2];
+            gpu_csc_ARGBToI420_ex(pSrc, pJob->srcStride, pDst, (GCUint*)pJob->dstStride, pJob->width, rows,
+                                  pJob->pCtx);
+            break;
+
+        case GPU_CSC_JOB_UYVY:
+            gpu_csc_ARGBToUYVY_ex(pSrc, pJob->srcStride, pDst[0], pJob->dstStride[0], pJob->width, rows,
+                                  pJob->pCtx);
+            break;
+
+        case GPU_CSC_JOB_NV21:
+            pDst[1] = pJob->pDst[1] + (top >> 1) * pJob->dstStride[1];
+            gpu_csc_ARGBToNV21_ex(pSrc, pJob->srcStride, pDst, (GCUint*)pJob->dstStride, pJob->width, rows,
+                                  pJob->pCtx);
+            break;
+
+        case GPU_CSC_JOB_NV12:
+            pDst[1] = pJob->pDst[1] + (top >> 1) * pJob->dstStride[1];
+            gpu_csc_ARGBToNV12_ex(pSrc, pJob->srcStride, pDst, (GCUint*)pJob->dstStride, pJob->width, rows,
+                                  pJob->pCtx);
+            break;
+
+        case GPU_CSC_JOB_RGB_NV12:
+            pDst[1] = pJob->pDst[1] + (top >> 1) * pJob->dstStride[1];
+            gpu_csc_RGBToNV12_ex(pSrc, pJob->srcStride, pDst, (GCUint*)pJob->dstStride, pJob->width, rows,
+                                 pJob->pCtx);
+            break;
+    }
+}
+
+/* must hold g_Pool.mutex, returns with it held */
+static void cscDrainBands(GPU_CSC_POOL* pPool)
+{
+    while(pPool->pJob && pPool->nextBand < pPool->pJob->bands)
+    {
+        GPU_CSC_JOB* pJob = pPool->pJob;
+        int band = pPool->nextBand++;
+
+        pthread_mutex_unlock(&pPool->mutex);
+        cscRunBand(pJob, band);
+        pthread_mutex_lock(&pPool->mutex);
+
+        if(--pPool->pending == 0)
+        {
+            pthread_cond_signal(&pPool->doneCond);
+        }
+    }
+}
+
+static void* cscWorker(void* arg)
+{
+    GPU_CSC_POOL* pPool = (GPU_CSC_POOL*)arg;
+    unsigned int seen;
+
+    pthread_mutex_lock(&pPool->mutex);
+    seen = pPool->generation;
+    for(;;)
+    {
+        while(pPool->generation == seen)
+        {
+            pthread_cond_wait(&pPool->startCond, &pPool->mutex);
+        }
+        seen = pPool->generation;
+        cscDrainBands(pPool);
+    }
+    return NULL;
+}
+
+/* must hold g_Pool.mutex */
+static void cscGrowPool(GPU_CSC_POOL* pPool, int threads)
+{
+    while(pPool->threadCount < threads)
+    {
+        pthread_attr_t attr;
+        pthread_t thread;
+        int ret;
+
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        ret = pthread_create(&thread, &attr, cscWorker, pPool);
+        pthread_attr_destroy(&attr);
+        if(ret != 0)
+        {
+            /* fewer workers only means the caller converts more bands */
+            break;
+        }
+        pPool->threadCount++;
+    }
+}
+
+static void cscRunJob(GPU_CSC_JOB* pJob)
+{
+    GPU_CSC_POOL* pPool = &g_Pool;
+    int bands = gpu_csc_GetBandCount();
+    int maxBands = pJob->height / GPU_CSC_MIN_BAND_ROWS;
+
+    if(bands > maxBands)
+    {
+        bands = maxBands;
+    }
+    if(bands <= 1)
+    {
+        pJob->bands = 1;
+        cscRunBand(pJob, 0);
+        return;
+    }
+    pJob->bands = bands;
+
+    pthread_mutex_lock(&pPool->callLock);
+    pthread_mutex_lock(&pPool->mutex);
+    cscGrowPool(pPool, bands - 1);
+    pPool->pJob     = pJob;
+    pPool->nextBand = 0;
+    pPool->pending  = bands;
+    pPool->generation++;
+    pthread_cond_broadcast(&pPool->startCond);
+
+    cscDrainBands(pPool);
+    while(pPool->pending > 0)
+    {
+        pthread_cond_wait(&pPool->doneCond, &pPool->mutex);
+    }
+    pPool->pJob = NULL;
+    pthread_mutex_unlock(&pPool->mutex);
+    pthread_mutex_unlock(&pPool->callLock);
+}
+
+static void cscSetupJob(GPU_CSC_JOB* pJob, GPU_CSC_JOB_TYPE type,
+                        const unsigned char* pSrc, GCUint srcStride,
+                        unsigned char** pDst, GCUint* dstStride, int planes,
+                        GCUint width, GCUint height, const GPU_CSC_CONTEXT* pCtx)
+{
+    int i;
+
+    pJob->type      = type;
+    pJob->pSrc      = pSrc;
+    pJob->srcStride = srcStride;
+    for(i = 0;  i < 3;  i++)
+    {
+        pJob->pDst[i]      = (i < planes) ? pDst[i] : NULL;
+        pJob->dstStride[i] = (i < planes) ? dstStride[i] : 0;
+    }
+    pJob->width  = width;
+    pJob->height = height;
+    pJob->bands  = 1;
+    pJob->pCtx   = pCtx;
+}
+
+void gpu_csc_ARGBToI420_MT_ex(const unsigned char* pSrc, GCUint srcStride,
+                              unsigned char* pDst[3], GCUint dstStride[3],
+                              GCUint width, GCUint height, const GPU_CSC_CONTEXT* pCtx)
+{
+    GPU_CSC_JOB job;
+
+    cscSetupJob(&job, GPU_CSC_JOB_I420, pSrc, srcStride, pDst, dstStride, 3, width, height, pCtx);
+    cscRunJob(&job);
+}
+
+void gpu_csc_ARGBToUYVY_MT_ex(const unsigned char* pSrc, GCUint srcStride,
+                              unsigned char* pDst, GCUint dstStride,
+                              GCUint width, GCUint height, const GPU_CSC_CONTEXT* pCtx)
+{
+    GPU_CSC_JOB job;
+
+    cscSetupJob(&job, GPU_CSC_JOB_UYVY, pSrc, srcStride, &pDst, &dstStride, 1, width, height, pCtx);
+    cscRunJob(&job);
+}
+
+void gpu_csc_ARGBToNV21_MT_ex(const unsigned char* pSrc, GCUint srcStride,
+                              unsigned char* pDst[2], GCUint dstStride[2],
+                              GCUint width, GCUint height, const GPU_CSC_CONTEXT* pCtx)
+{
+    GPU_CSC_JOB job;
+
+    cscSetupJob(&job, GPU_CSC_JOB_NV21, pSrc, srcStride, pDst, dstStride, 2, width, height, pCtx);
+    cscRunJob(&job);
+}
+
+void gpu_csc_ARGBToNV12_MT_ex(const unsigned char* pSrc, GCUint srcStride,
+                              unsigned char* pDst[2], GCUint dstStride[2],
+                              GCUint width, GCUint height, const GPU_CSC_CONTEXT* pCtx)
+{
+    GPU_CSC_JOB job;
+
+    cscSetupJob(&job, GPU_CSC_JOB_NV12, pSrc, srcStride, pDst, dstStride, 2, width, height, pCtx);
+    cscRunJob(&job);
+}
+
+void gpu_csc_RGBToNV12_MT_ex(const unsigned char* pSrc, GCUint srcStride,
+                             unsigned char* pDst[2], GCUint dstStride[2],
+                             GCUint width, GCUint height, const GPU_CSC_CONTEXT* pCtx)
+{
+    GPU_CSC_JOB job;
+
+    cscSetupJob(&job, GPU_CSC_JOB_RGB_NV12, pSrc, srcStride, pDst, dstStride, 2, width, height, pCtx);
+    cscRunJob(&job);
+}
+
+void gpu_csc_ARGBToI420_MT(const unsigned char* pSrc, GCUint srcStride,
+                           unsigned char* pDst[3], GCUint dstStride[3],
+                           GCUint width, GCUint height)
+{
+    gpu_csc_ARGBToI420_MT_ex(pSrc, srcStride, pDst, dstStride, width, height, gpu_csc_GetDefaultContext());
+}
+
+void gpu_csc_ARGBToUYVY_MT(const unsigned char* pSrc, GCUint srcStride,
+                           unsigned char* pDst, GCUint dstStride,
+                           GCUint width, GCUint height)
+{
+    gpu_csc_ARGBToUYVY_MT_ex(pSrc, srcStride, pDst, dstStride, width, height, gpu_csc_GetDefaultContext());
+}
+
+void gpu_csc_ARGBToNV21_MT(const unsigned char* pSrc, GCUint srcStride,
+                           unsigned char* pDst[2], GCUint dstStride[2],
+                           GCUint width, GCUint height)
+{
+    gpu_csc_ARGBToNV21_MT_ex(pSrc, srcStride, pDst, dstStride, width, height, gpu_csc_GetDefaultContext());
+}
+
+void gpu_csc_ARGBToNV12_MT(const unsigned char* pSrc, GCUint srcStride,
+                           unsigned char* pDst[2], GCUint dstStride[2],
+                           GCUint width, GCUint height)
+{
+    gpu_csc_ARGBToNV12_MT_ex(pSrc, srcStride, pDst, dstStride, width, height, gpu_csc_GetDefaultContext());
+}
+
+void gpu_csc_RGBToNV12_MT(const unsigned char* pSrc, GCUint srcStride,
+                          unsigned char* pDst[2], GCUint dstStride[2],
+                          GCUint width, GCUint height)
+{
+    gpu_csc_RGBToNV12_MT_ex(pSrc, srcStride, pDst, dstStride, width, height, gpu_csc_GetDefaultContext());
+}
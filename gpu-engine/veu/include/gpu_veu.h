@@ -55,6 +55,10 @@ typedef unsigned int            VEUPhysicalAddr;
 #endif
 
 #define VEU_MAX_UINT32          0xffffffff
+#define VEU_INFINITE            0xffffffff
+
+/* Number of asynchronous effect or transition calls that can be in flight */
+#define VEU_INFLIGHT_MAX        4
 
 typedef enum _VEU_FORMAT{
     /* YUV series */
@@ -185,6 +189,60 @@ VEUbool veuFadeBlackProc(VEUvoid*       userData,
                          VEUSurface     pDstSurface,
                          VEUvoid*       pProgress,
                          VEUulong       uiTransitionKind);
+
+/*
+ *  VEU Asynchronous Effect and Transition API
+ *
+ *  Each call records the same work as its synchronous counterpart, submits it and returns a fence
+ *  without waiting for the GPU, or VEU_NULL on failure. The destination surface must not be read
+ *  by the CPU until the fence is waited. At most VEU_INFLIGHT_MAX calls are in flight : the next
+ *  call first waits for the oldest one, and then reuses its fence. So a fence must be waited before
+ *  VEU_INFLIGHT_MAX further asynchronous calls are made, else the wait also covers the newer work.
+ *  Like the rest of VEU, which shares one GCU context, these calls, veuWaitFence, veuDestroySurface,
+ *  veuUpdatePreAllocSurface and veuTerminate must all be made from the same thread.
+ */
+VEUFence veuEffectProcAsync(VEUvoid*       pFunctionContext,
+                            VEUSurface     pSrc,
+                            VEUSurface     pDst,
+                            VEUvoid*       pProgress,
+                            VEUulong       uiEffectKind);
+
+VEUFence veuTransitionProcAsync(VEUvoid*       userData,
+                                VEUSurface     pSrc1,
+                                VEUSurface     pSrc2,
+                                VEUSurface     pDst,
+                                VEUvoid*       pProgress,
+                                VEUulong       uiTransitionKind);
+
+VEUFence veuEffectColorProcAsync(VEUvoid*       pFunctionContext,
+                                 VEUSurface     pSrcSurface,
+                                 VEUSurface     pDstSurface,
+                                 VEUvoid*       pProgress,
+                                 VEUulong       uiEffectKind);
+
+VEUFence veuEffectZoomProcAsync(VEUvoid*       pFunctionContext,
+                                VEUSurface     pSrcSurface,
+                                VEUSurface     pDstSurface,
+                                VEUvoid*       pProgress,
+                                VEUulong       uiEffectKind);
+
+VEUFence veuSlideTransitionProcAsync(VEUvoid*       userData,
+                                     VEUSurface     pSrcSurface1,
+                                     VEUSurface     pSrcSurface2,
+                                     VEUSurface     pDstSurface,
+                                     VEUvoid*       pProgress,
+                                     VEUulong       uiTransitionKind);
+
+VEUFence veuFadeBlackProcAsync(VEUvoid*       userData,
+                               VEUSurface     pSrcSurface1,
+                               VEUSurface     pSrcSurface2,
+                               VEUSurface     pDstSurface,
+                               VEUvoid*       pProgress,
+                               VEUulong       uiTransitionKind);
+
+/* Wait the work of an asynchronous call, waitTimeMs can be VEU_INFINITE. Return VEU_FALSE on timeout */
+VEUbool veuWaitFence(VEUFence pFence, VEUuint waitTimeMs);
+
 /*
  * Misc API
  */
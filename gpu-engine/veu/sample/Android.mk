@@ -111,3 +111,26 @@ LOCAL_MODULE := sample_fadeblack
 LOCAL_MODULE_TAGS := samples
 include $(BUILD_EXECUTABLE)
 
+
+include $(CLEAR_VARS)
+LOCAL_C_INCLUDES += \
+    $(LOCAL_PATH)/../include \
+    vendor/marvell/generic/graphics/user/include \
+    vendor/marvell/generic/graphics/include \
+    frameworks/av/libvideoeditor/vss/common/inc \
+    frameworks/av/libvideoeditor/vss/mcs/inc \
+    frameworks/av/libvideoeditor/vss/inc \
+    frameworks/av/libvideoeditor/osal/inc \
+
+LOCAL_SRC_FILES := \
+    sample_throughput.c
+
+LOCAL_SHARED_LIBRARIES := \
+    libveu \
+    libgcu \
+    libcutils \
+
+LOCAL_MODULE_PATH := $(LOCAL_PATH)
+LOCAL_MODULE := sample_throughput
+LOCAL_MODULE_TAGS := samples
+include $(BUILD_EXECUTABLE)
@@ -0,0 +1,265 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef WINCE
+#include <windows.h>
+#else
+#include <sys/time.h>
+#endif
+
+#include "veu.h"
+#include "gcu.h"
+
+#include "M4VSS3GPP_API.h"
+#include "M4xVSS_API.h"
+#include "M4xVSS_Internal.h"
+
+/*
+ * Throughput of the effect and transition procs on test.yuv, run once with the synchronous
+ * procs and once with the asynchronous ones keeping up to VEU_INFLIGHT_MAX frames in flight.
+ * Every output frame is read back by the CPU, as an encoder would, and the checksums of both
+ * runs must match.
+ *
+ * usage: sample_throughput [frames]
+ */
+
+#define FRAME_COUNT     120
+#define DST_COUNT       VEU_INFLIGHT_MAX
+
+enum {
+    TEST_SEPIA,
+    TEST_NEGATIVE,
+    TEST_ZOOMIN,
+    TEST_SLIDE,
+    TEST_FADEBLACK,
+    TEST_COUNT
+};
+
+static const char* s_testNames[TEST_COUNT] = {
+    "sepia", "negative", "zoomin", "slide", "fadeblack"
+};
+
+static VEUSurface s_pSrcSurface1 = NULL;
+static VEUSurface s_pSrcSurface2 = NULL;
+
+static double _getTimeMs()
+{
+#ifdef WINCE
+    return (double)GetTickCount();
+#else
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+#endif
+}
+
+static VEUFence _runAsync(int test, VEUSurface pDstSurface, M4VSS3GPP_ExternalProgress* pProcess)
+{
+    M4xVSS_ColorStruct                      colorData;
+    M4xVSS_internal_SlideTransitionSettings slideData;
+
+    memset(&colorData, 0, sizeof(colorData));
+    memset(&slideData, 0, sizeof(slideData));
+    switch(test)
+    {
+        case TEST_SEPIA:
+            colorData.colorEffectType = M4xVSS_kVideoEffectType_Sepia;
+            return veuEffectColorProcAsync(&colorData, s_pSrcSurface1, pDstSurface, pProcess, 0);
+        case TEST_NEGATIVE:
+            colorData.colorEffectType = M4xVSS_kVideoEffectType_Negative;
+            return veuEffectColorProcAsync(&colorData, s_pSrcSurface1, pDstSurface, pProcess, 0);
+        case TEST_ZOOMIN:
+            return veuEffectZoomProcAsync((VEUvoid *)M4xVSS_kVideoEffectType_ZoomIn, s_pSrcSurface1, pDstSurface, pProcess, 0);
+        case TEST_SLIDE:
+            slideData.direction = M4xVSS_SlideTransition_RightOutLeftIn;
+            return veuSlideTransitionProcAsync(&slideData, s_pSrcSurface1, s_pSrcSurface2, pDstSurface, pProcess, 0);
+        case TEST_FADEBLACK:
+            return veuFadeBlackProcAsync(VEU_NULL, s_pSrcSurface1, s_pSrcSurface2, pDstSurface, pProcess, 0);
+        default:
+            return VEU_NULL;
+    }
+}
+
+static VEUbool _runSync(int test, VEUSurface pDstSurface, M4VSS3GPP_ExternalProgress* pProcess)
+{
+    M4xVSS_ColorStruct                      colorData;
+    M4xVSS_internal_SlideTransitionSettings slideData;
+
+    memset(&colorData, 0, sizeof(colorData));
+    memset(&slideData, 0, sizeof(slideData));
+    switch(test)
+    {
+        case TEST_SEPIA:
+            colorData.colorEffectType = M4xVSS_kVideoEffectType_Sepia;
+            return veuEffectColorProc(&colorData, s_pSrcSurface1, pDstSurface, pProcess, 0);
+        case TEST_NEGATIVE:
+            colorData.colorEffectType = M4xVSS_kVideoEffectType_Negative;
+            return veuEffectColorProc(&colorData, s_pSrcSurface1, pDstSurface, pProcess, 0);
+        case TEST_ZOOMIN:
+            return veuEffectZoomProc((VEUvoid *)M4xVSS_kVideoEffectType_ZoomIn, s_pSrcSurface1, pDstSurface, pProcess, 0);
+        case TEST_SLIDE:
+            slideData.direction = M4xVSS_SlideTransition_RightOutLeftIn;
+            return veuSlideTransitionProc(&slideData, s_pSrcSurface1, s_pSrcSurface2, pDstSurface, pProcess, 0);
+        case TEST_FADEBLACK:
+            return veuFadeBlackProc(VEU_NULL, s_pSrcSurface1, s_pSrcSurface2, pDstSurface, pProcess, 0);
+        default:
+            return VEU_FALSE;
+    }
+}
+
+/* Read back the luma of a finished frame */
+static unsigned int _consume(VEUSurface pSurface)
+{
+    GCU_SURFACE_LOCK_DATA   lockData;
+    GCU_ALLOC_INFO          allocInfos[3];
+    VEUContext              pContext = _veuGetContext();
+    unsigned int            sum      = 0;
+    unsigned int            x, y;
+
+    memset(allocInfos, 0, sizeof(allocInfos));
+    memset(&lockData, 0, sizeof(lockData));
+    lockData.pSurface           = pSurface;
+    lockData.flag.bits.preserve = 1;
+    lockData.arraySize          = 3;
+    lockData.pAllocInfos        = allocInfos;
+    if(gcuLockSurface(pContext, &lockData))
+    {
+        for(y = 0; y < allocInfos[0].height; y++)
+        {
+            const unsigned char* pRow = (const unsigned char*)allocInfos[0].virtualAddr + y * allocInfos[0].stride;
+            for(x = 0; x < allocInfos[0].width; x++)
+            {
+                sum = sum * 31 + pRow[x];
+            }
+        }
+        gcuUnlockSurface(pContext, pSurface);
+    }
+    return sum;
+}
+
+static void _setProgress(M4VSS3GPP_ExternalProgress* pProcess, int frame, int frames)
+{
+    memset(pProcess, 0, sizeof(*pProcess));
+    pProcess->uiProgress = (frames > 1) ? (frame * 1000) / (frames - 1) : 0;
+}
+
+#ifdef WINCE
+int WINAPI WinMain (
+    HINSTANCE   hInstance,
+    HINSTANCE   hPrevInstance,
+    LPTSTR      lpCmdLine,
+    int         nCmdShow)
+#else
+int main(int argc, char** argv)
+#endif
+{
+    VEUSurface                  pDstSurfaces[DST_COUNT];
+    VEUFence                    pFences[DST_COUNT];
+    VEU_INIT_DATA               initData;
+    M4VSS3GPP_ExternalProgress  process;
+
+    unsigned int   width  = 640;
+    unsigned int   height = 480;
+    int            frames = FRAME_COUNT;
+    int            bOk    = 1;
+    int            test, f, i;
+
+#ifndef WINCE
+    if(argc > 1 && atoi(argv[1]) > 0)
+    {
+        frames = atoi(argv[1]);
+    }
+#endif
+
+    memset(&initData, 0, sizeof(initData));
+    memset(pDstSurfaces, 0, sizeof(pDstSurfaces));
+    veuInitialize(&initData);
+
+    s_pSrcSurface1 = _veuLoadSurface("test.yuv", VEU_FORMAT_I420, width, height);
+    s_pSrcSurface2 = _veuLoadSurface("test.yuv", VEU_FORMAT_I420, width, height);
+    for(i = 0; i < DST_COUNT; i++)
+    {
+        pDstSurfaces[i] = veuCreateSurface(width, height, VEU_FORMAT_I420);
+        bOk = bOk && pDstSurfaces[i];
+    }
+
+    if(s_pSrcSurface1 && s_pSrcSurface2 && bOk)
+    {
+        printf("%d frames of %ux%u, %d in flight\n", frames, width, height, DST_COUNT);
+        for(test = 0; test < TEST_COUNT; test++)
+        {
+            unsigned int syncSum  = 0;
+            unsigned int asyncSum = 0;
+            double       syncMs, asyncMs, start;
+
+            /* synchronous: every proc waits for its frame */
+            start = _getTimeMs();
+            for(f = 0; f < frames; f++)
+            {
+                _setProgress(&process, f, frames);
+                if(!_runSync(test, pDstSurfaces[f % DST_COUNT], &process))
+                {
+                    printf("%s: sync proc failed at frame %d\n", s_testNames[test], f);
+                    bOk = 0;
+                    break;
+                }
+                syncSum += _consume(pDstSurfaces[f % DST_COUNT]);
+            }
+            syncMs = _getTimeMs() - start;
+
+            /* asynchronous: read back frame f - (DST_COUNT - 1) while the later ones render */
+            start = _getTimeMs();
+            for(f = 0; f < frames + DST_COUNT - 1; f++)
+            {
+                int done = f - (DST_COUNT - 1);
+
+                if(f < frames)
+                {
+                    _setProgress(&process, f, frames);
+                    pFences[f % DST_COUNT] = _runAsync(test, pDstSurfaces[f % DST_COUNT], &process);
+                    if(!pFences[f % DST_COUNT])
+                    {
+                        printf("%s: async proc failed at frame %d\n", s_testNames[test], f);
+                        bOk = 0;
+                        break;
+                    }
+                }
+                if(done >= 0)
+                {
+                    veuWaitFence(pFences[done % DST_COUNT], VEU_INFINITE);
+                    asyncSum += _consume(pDstSurfaces[done % DST_COUNT]);
+                }
+            }
+            asyncMs = _getTimeMs() - start;
+
+            printf("%-10s sync %8.1f fps   async %8.1f fps   %s\n",
+                   s_testNames[test],
+                   syncMs  > 0 ? frames * 1000.0 / syncMs  : 0.0,
+                   asyncMs > 0 ? frames * 1000.0 / asyncMs : 0.0,
+                   syncSum == asyncSum ? "match" : "MISMATCH");
+            if(syncSum != asyncSum)
+            {
+                bOk = 0;
+            }
+        }
+    }
+
+    for(i = 0; i < DST_COUNT; i++)
+    {
+        if(pDstSurfaces[i])
+        {
+            veuDestroySurface(pDstSurfaces[i]);
+        }
+    }
+    if(s_pSrcSurface1)
+    {
+        veuDestroySurface(s_pSrcSurface1);
+    }
+    if(s_pSrcSurface2)
+    {
+        veuDestroySurface(s_pSrcSurface2);
+    }
+    veuTerminate();
+
+    return bOk ? 0 : 1;
+}
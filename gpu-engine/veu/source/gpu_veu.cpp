@@ -134,6 +134,7 @@ VEUvoid veuTerminate()
 {
     if(g_pContext)
     {
+        _veuInflightTerminate(g_pContext);
         if(g_pSurface)
         {
             _gcuDestroyBuffer(g_pContext, g_pSurface);
@@ -500,6 +501,9 @@ VEUbool veuUpdatePreAllocSurface(VEUSurface          pSurface,
 
             surfaceUpdate.pAllocInfos = preAllocInfos;
 
+            /* pending work and cached plane views still point to the old buffers */
+            _veuInflightReleaseSurface(pContext, pSurface);
+
             return gcuUpdateSurface(pContext, &surfaceUpdate);
         }
     }
@@ -513,6 +517,7 @@ VEUvoid veuDestroySurface(VEUSurface pSurface)
     if(pContext)
     {
         VEU_ASSERT(pSurface);
+        _veuInflightReleaseSurface(pContext, pSurface);
         _gcuDestroyBuffer(pContext, pSurface);
     }
 }
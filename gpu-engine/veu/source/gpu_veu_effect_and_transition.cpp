@@ -181,6 +181,189 @@ VEUvoid _veuBlit(VEUContext pContext, VEUSurface pDstSurface, VEUSurface pSrcSur
     gcuBlit(pContext, &blitData);
 }
 
+/*
+ * In-flight ring
+ *
+ * Every asynchronous call takes the next slot of the ring. A slot holds the fence sent after the
+ * work of the call and the Y/U/V plane views of the surfaces it used, so a caller rotating through
+ * up to VEU_INFLIGHT_MAX surfaces gets the views back without locking the surfaces again.
+ * The ring has no lock : VEU is driven from a single thread (see gpu_veu.h).
+ */
+#define VEU_INFLIGHT_DST        0
+#define VEU_INFLIGHT_SRC1       1
+#define VEU_INFLIGHT_SRC2       2
+#define VEU_INFLIGHT_SURFACES   3
+
+typedef struct _VEU_YUV_VIEW{
+    VEUSurface      pParent;        /* surface used by the slot, VEU_NULL if none */
+    VEUSurface      pYSurface;      /* plane views, VEU_NULL until first needed   */
+    VEUSurface      pUSurface;
+    VEUSurface      pVSurface;
+}VEU_YUV_VIEW;
+
+typedef struct _VEU_INFLIGHT_SLOT{
+    VEUFence        pFence;
+    VEUbool         bPending;
+    VEU_YUV_VIEW    views[VEU_INFLIGHT_SURFACES];
+}VEU_INFLIGHT_SLOT;
+
+static VEU_INFLIGHT_SLOT g_inflight[VEU_INFLIGHT_MAX];
+static VEUuint           g_inflightNext = 0;
+
+static VEUvoid _veuInflightWait(VEUContext pContext, VEU_INFLIGHT_SLOT* pSlot)
+{
+    if(pSlot->bPending)
+    {
+        gcuWaitFence(pContext, pSlot->pFence, GCU_INFINITE);
+        pSlot->bPending = VEU_FALSE;
+    }
+}
+
+static VEUvoid _veuInflightDropView(VEUContext pContext, VEU_YUV_VIEW* pView)
+{
+    if(pView->pYSurface)
+    {
+        _veuReleaseYUVSurface(pContext, pView->pParent, pView->pYSurface, pView->pUSurface, pView->pVSurface);
+    }
+    memset(pView, 0, sizeof(*pView));
+}
+
+/* Take the next slot, once the work it was last used for has completed */
+static VEU_INFLIGHT_SLOT* _veuInflightAcquire(VEUContext pContext)
+{
+    VEU_INFLIGHT_SLOT* pSlot = &g_inflight[g_inflightNext];
+
+    if(!pSlot->pFence)
+    {
+        pSlot->pFence = gcuCreateFence(pContext);
+        if(!pSlot->pFence)
+        {
+            _veuDebugf("%s(%d) : failed to create fence\n", __FUNCTION__, __LINE__);
+            return VEU_NULL;
+        }
+    }
+    _veuInflightWait(pContext, pSlot);
+
+    g_inflightNext = (g_inflightNext + 1) % VEU_INFLIGHT_MAX;
+    return pSlot;
+}
+
+/* Record that the slot work uses pSurface as a whole */
+static VEUvoid _veuInflightUse(VEUContext pContext, VEU_INFLIGHT_SLOT* pSlot, VEUuint index, VEUSurface pSurface)
+{
+    VEU_YUV_VIEW* pView = &pSlot->views[index];
+
+    if(pView->pParent != pSurface)
+    {
+        _veuInflightDropView(pContext, pView);
+        pView->pParent = pSurface;
+    }
+}
+
+/* Record that the slot work uses the planes of pSurface, and return their views */
+static VEUbool _veuInflightGetYUV(VEUContext pContext,
+                                  VEU_INFLIGHT_SLOT* pSlot,
+                                  VEUuint index,
+                                  VEUSurface pSurface,
+                                  VEUSurface* ppYSurface,
+                                  VEUSurface* ppUSurface,
+                                  VEUSurface* ppVSurface)
+{
+    VEU_YUV_VIEW* pView = &pSlot->views[index];
+
+    _veuInflightUse(pContext, pSlot, index, pSurface);
+    if(!pView->pYSurface)
+    {
+        if(!_veuGetYUVSurface(pContext, pSurface, &pView->pYSurface, &pView->pUSurface, &pView->pVSurface))
+        {
+            return VEU_FALSE;
+        }
+    }
+    *ppYSurface = pView->pYSurface;
+    *ppUSurface = pView->pUSurface;
+    *ppVSurface = pView->pVSurface;
+    return VEU_TRUE;
+}
+
+/* Send the slot fence after the recorded work and kick it off */
+static VEUFence _veuInflightSubmit(VEUContext pContext, VEU_INFLIGHT_SLOT* pSlot)
+{
+    if(!gcuSendFence(pContext, pSlot->pFence))
+    {
+        _veuDebugf("%s(%d) : failed to send fence\n", __FUNCTION__, __LINE__);
+        _veuFinish(pContext);
+        return VEU_NULL;
+    }
+    pSlot->bPending = VEU_TRUE;
+    _veuFlush(pContext);
+    return pSlot->pFence;
+}
+
+VEUvoid _veuInflightReleaseSurface(VEUContext pContext, VEUSurface pSurface)
+{
+    VEUuint i, j;
+
+    for(i = 0; i < VEU_INFLIGHT_MAX; i++)
+    {
+        for(j = 0; j < VEU_INFLIGHT_SURFACES; j++)
+        {
+            if(g_inflight[i].views[j].pParent == pSurface)
+            {
+                _veuInflightWait(pContext, &g_inflight[i]);
+                _veuInflightDropView(pContext, &g_inflight[i].views[j]);
+            }
+        }
+    }
+}
+
+VEUvoid _veuInflightTerminate(VEUContext pContext)
+{
+    VEUuint i, j;
+
+    for(i = 0; i < VEU_INFLIGHT_MAX; i++)
+    {
+        _veuInflightWait(pContext, &g_inflight[i]);
+        for(j = 0; j < VEU_INFLIGHT_SURFACES; j++)
+        {
+            _veuInflightDropView(pContext, &g_inflight[i].views[j]);
+        }
+        if(g_inflight[i].pFence)
+        {
+            gcuDestroyFence(pContext, g_inflight[i].pFence);
+        }
+    }
+    memset(g_inflight, 0, sizeof(g_inflight));
+    g_inflightNext = 0;
+}
+
+VEUbool veuWaitFence(VEUFence pFence, VEUuint waitTimeMs)
+{
+    VEUContext  pContext = _veuGetContext();
+    VEUuint     i;
+
+    if(!pContext || !pFence)
+    {
+        return VEU_FALSE;
+    }
+    for(i = 0; i < VEU_INFLIGHT_MAX; i++)
+    {
+        if(g_inflight[i].pFence == pFence)
+        {
+            if(g_inflight[i].bPending)
+            {
+                if(!gcuWaitFence(pContext, pFence, waitTimeMs))
+                {
+                    return VEU_FALSE;
+                }
+                g_inflight[i].bPending = VEU_FALSE;
+            }
+            return VEU_TRUE;
+        }
+    }
+    _veuDebugf("%s(%d) : unknown fence %p\n", __FUNCTION__, __LINE__, pFence);
+    return VEU_FALSE;
+}
+
 VEUvoid _veuResizeBilinear(VEUContext pContext, VEUSurface pDstSurface, VEUSurface pSrcSurface, GCU_RECT *pRect)
 {
     GCU_BLT_DATA blitData;
@@ -194,17 +377,19 @@ VEUvoid _veuResizeBilinear(VEUContext pContext, VEUSurface pDstSurface, VEUSurfa
     blitData.pDstSurface = pDstSurface;
     blitData.pSrcRect    = pRect;
     blitData.pDstRect    = VEU_NULL;
+    /* gcuBlit turns the context quality into filter commands as it records the blit,
+       so it can be reset before the fence of the slot signals */
     gcuSet(pContext, GCU_QUALITY, GCU_QUALITY_HIGH);
     gcuBlit(pContext, &blitData);
-    _veuFinish(pContext);
     gcuSet(pContext, GCU_QUALITY, GCU_QUALITY_NORMAL);
 }
 
-VEUvoid _veumodifyLumaWithScale(VEUContext pContext, VEUSurface pDstSurface, VEUSurface pSrcSurface, VEUuint luma)
+VEUbool _veumodifyLumaWithScale(VEUContext pContext, VEU_INFLIGHT_SLOT* pSlot, VEUSurface pDstSurface, VEUSurface pSrcSurface, VEUuint luma)
 {
     GCU_BLEND_DATA blendData;
 
     VEU_ASSERT(pContext);
+    VEU_ASSERT(pSlot);
     VEU_ASSERT(pDstSurface);
     VEU_ASSERT(pSrcSurface);
 
@@ -218,8 +403,8 @@ VEUvoid _veumodifyLumaWithScale(VEUContext pContext, VEUSurface pDstSurface, VEU
     VEUSurface pDstUSurface = VEU_NULL;
     VEUSurface pDstVSurface = VEU_NULL;
 
-    bSrcOk = _veuGetYUVSurface(pContext, pSrcSurface, &pSrcYSurface, &pSrcUSurface, &pSrcVSurface);
-    bDstOk = _veuGetYUVSurface(pContext, pDstSurface, &pDstYSurface, &pDstUSurface, &pDstVSurface);
+    bSrcOk = _veuInflightGetYUV(pContext, pSlot, VEU_INFLIGHT_SRC1, pSrcSurface, &pSrcYSurface, &pSrcUSurface, &pSrcVSurface);
+    bDstOk = _veuInflightGetYUV(pContext, pSlot, VEU_INFLIGHT_DST, pDstSurface, &pDstYSurface, &pDstUSurface, &pDstVSurface);
 
     if(bSrcOk && bDstOk)
     {
@@ -267,30 +452,23 @@ VEUvoid _veumodifyLumaWithScale(VEUContext pContext, VEUSurface pDstSurface, VEU
             blendData.blendMode      = GCU_BLEND_PLUS;
             gcuBlend(pContext, &blendData);
         }
-        _veuFinish(pContext);
-    }
-    if(bSrcOk)
-    {
-        _veuReleaseYUVSurface(pContext, pSrcSurface, pSrcYSurface, pSrcUSurface, pSrcVSurface);
-    }
-
-    if(bDstOk)
-    {
-        _veuReleaseYUVSurface(pContext, pDstSurface, pDstYSurface, pDstUSurface, pDstVSurface);
     }
 
+    return bSrcOk && bDstOk;
 }
 
-VEUbool veuEffectColorProc(VEUvoid*     pFunctionContext,
-                           VEUSurface     pSrcSurface,
-                           VEUSurface     pDstSurface,
-                           VEUvoid*       pProgress,
-                           VEUulong       uiEffectKind)
+VEUFence veuEffectColorProcAsync(VEUvoid*       pFunctionContext,
+                                 VEUSurface     pSrcSurface,
+                                 VEUSurface     pDstSurface,
+                                 VEUvoid*       pProgress,
+                                 VEUulong       uiEffectKind)
 {
     M4xVSS_ColorStruct* ColorContext = (M4xVSS_ColorStruct*)pFunctionContext;
-    VEUbool     ret      = VEU_FALSE;
-    VEUContext  pContext = _veuGetContext();
-    if(pContext)
+    VEUFence            pFence   = VEU_NULL;
+    VEUbool             ret      = VEU_FALSE;
+    VEUContext          pContext = _veuGetContext();
+    VEU_INFLIGHT_SLOT*  pSlot    = pContext ? _veuInflightAcquire(pContext) : VEU_NULL;
+    if(pSlot)
     {
         VEUbool    bSrcOk = VEU_FALSE;
         VEUbool    bDstOk = VEU_FALSE;
@@ -305,8 +483,8 @@ VEUbool veuEffectColorProc(VEUvoid*     pFunctionContext,
         VEU_ASSERT(pSrcSurface);
         VEU_ASSERT(pDstSurface);
 
-        bSrcOk = _veuGetYUVSurface(pContext, pSrcSurface, &pSrcYSurface, &pSrcUSurface, &pSrcVSurface);
-        bDstOk = _veuGetYUVSurface(pContext, pDstSurface, &pDstYSurface, &pDstUSurface, &pDstVSurface);
+        bSrcOk = _veuInflightGetYUV(pContext, pSlot, VEU_INFLIGHT_SRC1, pSrcSurface, &pSrcYSurface, &pSrcUSurface, &pSrcVSurface);
+        bDstOk = _veuInflightGetYUV(pContext, pSlot, VEU_INFLIGHT_DST, pDstSurface, &pDstYSurface, &pDstUSurface, &pDstVSurface);
 
         if(bSrcOk && bDstOk)
         {
@@ -317,7 +495,6 @@ VEUbool veuEffectColorProc(VEUvoid*     pFunctionContext,
                         _veuBlit(pContext, pDstYSurface, pSrcYSurface, VEU_NULL, VEU_NULL);
                         _veuFill(pContext, pDstUSurface, 128, VEU_NULL);
                         _veuFill(pContext, pDstVSurface, 128, VEU_NULL);
-                        _veuFinish(pContext);
                         ret = VEU_TRUE;
                     }
                     break;
@@ -327,7 +504,6 @@ VEUbool veuEffectColorProc(VEUvoid*     pFunctionContext,
                         _veuBlit(pContext, pDstYSurface, pSrcYSurface, VEU_NULL, VEU_NULL);
                         _veuFill(pContext, pDstUSurface, 255, VEU_NULL);
                         _veuFill(pContext, pDstVSurface, 255, VEU_NULL);
-                        _veuFinish(pContext);
                         ret = VEU_TRUE;
                     }
                     break;
@@ -337,7 +513,6 @@ VEUbool veuEffectColorProc(VEUvoid*     pFunctionContext,
                         _veuBlit(pContext, pDstYSurface, pSrcYSurface, VEU_NULL, VEU_NULL);
                         _veuFill(pContext, pDstUSurface, 0, VEU_NULL);
                         _veuFill(pContext, pDstVSurface, 0, VEU_NULL);
-                        _veuFinish(pContext);
                         ret = VEU_TRUE;
                     }
                     break;
@@ -347,7 +522,6 @@ VEUbool veuEffectColorProc(VEUvoid*     pFunctionContext,
                         _veuBlit(pContext, pDstYSurface, pSrcYSurface, VEU_NULL, VEU_NULL);
                         _veuFill(pContext, pDstUSurface, 117, VEU_NULL);
                         _veuFill(pContext, pDstVSurface, 139, VEU_NULL);
-                        _veuFinish(pContext);
                         ret = VEU_TRUE;
                     }
                     break;
@@ -405,7 +579,6 @@ VEUbool veuEffectColorProc(VEUvoid*     pFunctionContext,
                         /* copy Y surface */
                         _veuBlit(pContext, pDstYSurface, pSrcYSurface, VEU_NULL, VEU_NULL);
 
-                        _veuFinish(pContext);
                         ret = VEU_TRUE;
                     }
                     break;
@@ -434,7 +607,6 @@ VEUbool veuEffectColorProc(VEUvoid*     pFunctionContext,
                         v = _veuV16(r, g, b);
                         _veuFill(pContext, pDstVSurface, v, VEU_NULL);
 
-                        _veuFinish(pContext);
                         ret = VEU_TRUE;
                     }
                     break;
@@ -451,8 +623,6 @@ VEUbool veuEffectColorProc(VEUvoid*     pFunctionContext,
                         ropData.pDstSurface = pDstYSurface;
                         ropData.rop         = 0x33;
                         gcuRop(pContext, &ropData);
-
-                        _veuFinish(pContext);
                         ret = VEU_TRUE;
                     }
                     break;
@@ -463,30 +633,26 @@ VEUbool veuEffectColorProc(VEUvoid*     pFunctionContext,
             }
         }
 
-        if(bSrcOk)
-        {
-            _veuReleaseYUVSurface(pContext, pSrcSurface, pSrcYSurface, pSrcUSurface, pSrcVSurface);
-        }
-
-        if(bDstOk)
+        if(ret)
         {
-            _veuReleaseYUVSurface(pContext, pDstSurface, pDstYSurface, pDstUSurface, pDstVSurface);
+            pFence = _veuInflightSubmit(pContext, pSlot);
         }
     }
 
-    return ret;
+    return pFence;
 }
 
-VEUbool veuEffectZoomProc(VEUvoid*       pFunctionContext,
-                          VEUSurface     pSrcSurface,
-                          VEUSurface     pDstSurface,
-                          VEUvoid*       pProgress,
-                          VEUulong       uiEffectKind)
+VEUFence veuEffectZoomProcAsync(VEUvoid*       pFunctionContext,
+                                VEUSurface     pSrcSurface,
+                                VEUSurface     pDstSurface,
+                                VEUvoid*       pProgress,
+                                VEUulong       uiEffectKind)
 {
-    VEUbool     ret      = VEU_FALSE;
-    VEUContext  pContext = _veuGetContext();
+    VEUFence            pFence   = VEU_NULL;
+    VEUContext          pContext = _veuGetContext();
+    VEU_INFLIGHT_SLOT*  pSlot    = pContext ? _veuInflightAcquire(pContext) : VEU_NULL;
     M4VSS3GPP_ExternalProgress* pProcessData = (M4VSS3GPP_ExternalProgress*) pProgress;
-    if(pContext)
+    if(pSlot)
     {
         VEU_ASSERT(pSrcSurface);
         VEU_ASSERT(pDstSurface);
@@ -525,26 +691,28 @@ VEUbool veuEffectZoomProc(VEUvoid*       pFunctionContext,
         rect.right  = rect.left + width;
         rect.bottom = rect.top + height;
 
+        _veuInflightUse(pContext, pSlot, VEU_INFLIGHT_SRC1, pSrcSurface);
+        _veuInflightUse(pContext, pSlot, VEU_INFLIGHT_DST, pDstSurface);
         _veuResizeBilinear(pContext, pDstSurface, pSrcSurface, &rect);
 
-        ret = VEU_TRUE;
-
+        pFence = _veuInflightSubmit(pContext, pSlot);
     }
-    return ret;
+    return pFence;
 }
 
-VEUbool veuSlideTransitionProc(VEUvoid*       userData,
-                               VEUSurface     pSrcSurface1,
-                               VEUSurface     pSrcSurface2,
-                               VEUSurface     pDstSurface,
-                               VEUvoid*       pProgress,
-                               VEUulong       uiTransitionKind)
+VEUFence veuSlideTransitionProcAsync(VEUvoid*       userData,
+                                     VEUSurface     pSrcSurface1,
+                                     VEUSurface     pSrcSurface2,
+                                     VEUSurface     pDstSurface,
+                                     VEUvoid*       pProgress,
+                                     VEUulong       uiTransitionKind)
 {
     M4xVSS_internal_SlideTransitionSettings* settings = (M4xVSS_internal_SlideTransitionSettings*) userData;
     M4VSS3GPP_ExternalProgress* pProcessData    = (M4VSS3GPP_ExternalProgress*) pProgress;
-    VEUbool     ret      = VEU_FALSE;
-    VEUContext  pContext = _veuGetContext();
-    if(pContext)
+    VEUFence            pFence   = VEU_NULL;
+    VEUContext          pContext = _veuGetContext();
+    VEU_INFLIGHT_SLOT*  pSlot    = pContext ? _veuInflightAcquire(pContext) : VEU_NULL;
+    if(pSlot)
     {
         VEU_ASSERT(pSrcSurface1);
         VEU_ASSERT(pSrcSurface2);
@@ -561,6 +729,10 @@ VEUbool veuSlideTransitionProc(VEUvoid*       userData,
         VEUSurface       pSrc1Surfacetemp;
         VEUSurface       pSrc2Surfacetemp;
 
+        _veuInflightUse(pContext, pSlot, VEU_INFLIGHT_SRC1, pSrcSurface1);
+        _veuInflightUse(pContext, pSlot, VEU_INFLIGHT_SRC2, pSrcSurface2);
+        _veuInflightUse(pContext, pSlot, VEU_INFLIGHT_DST, pDstSurface);
+
         memset(&infoData, 0, sizeof(infoData));
         gcuQuerySurfaceInfo(pContext, pDstSurface, &infoData);
         width    = infoData.width;
@@ -677,23 +849,24 @@ VEUbool veuSlideTransitionProc(VEUvoid*       userData,
                 _veuBlit(pContext, pDstSurface, pSrc2Surfacetemp, &dstRect2, &srcRect2);
             }
         }
-        _veuFinish(pContext);
-        ret = VEU_TRUE;
+        pFence = _veuInflightSubmit(pContext, pSlot);
     }
-    return ret;
+    return pFence;
 }
 
-VEUbool veuFadeBlackProc(VEUvoid*       userData,
-                         VEUSurface     pSrcSurface1,
-                         VEUSurface     pSrcSurface2,
-                         VEUSurface     pDstSurface,
-                         VEUvoid*       pProgress,
-                         VEUulong       uiTransitionKind)
+VEUFence veuFadeBlackProcAsync(VEUvoid*       userData,
+                               VEUSurface     pSrcSurface1,
+                               VEUSurface     pSrcSurface2,
+                               VEUSurface     pDstSurface,
+                               VEUvoid*       pProgress,
+                               VEUulong       uiTransitionKind)
 {
-    VEUbool     ret      = VEU_FALSE;
-    VEUContext  pContext = _veuGetContext();
+    VEUFence            pFence   = VEU_NULL;
+    VEUbool             ret      = VEU_FALSE;
+    VEUContext          pContext = _veuGetContext();
+    VEU_INFLIGHT_SLOT*  pSlot    = pContext ? _veuInflightAcquire(pContext) : VEU_NULL;
     M4VSS3GPP_ExternalProgress* pProcessData = (M4VSS3GPP_ExternalProgress*) pProgress;
-    if(pContext)
+    if(pSlot)
     {
         VEU_ASSERT(pSrcSurface1);
         VEU_ASSERT(pSrcSurface2);
@@ -708,8 +881,7 @@ VEUbool veuFadeBlackProc(VEUvoid*       userData,
 
             /**
              * Apply the darkening effect */
-            _veumodifyLumaWithScale(pContext, pDstSurface, pSrcSurface1, tmp);
-            ret = VEU_TRUE;
+            ret = _veumodifyLumaWithScale(pContext, pSlot, pDstSurface, pSrcSurface1, tmp);
 
         }
         else
@@ -720,20 +892,24 @@ VEUbool veuFadeBlackProc(VEUvoid*       userData,
 
             /**
              * Apply the darkening effect */
-            _veumodifyLumaWithScale(pContext, pDstSurface, pSrcSurface2, tmp);
-            ret = VEU_TRUE;
+            ret = _veumodifyLumaWithScale(pContext, pSlot, pDstSurface, pSrcSurface2, tmp);
+        }
+
+        if(ret)
+        {
+            pFence = _veuInflightSubmit(pContext, pSlot);
         }
     }
-    return ret;
+    return pFence;
 }
 
-VEUbool veuEffectProc(VEUvoid*       pFunctionContext,
-                      VEUSurface     pSrc,
-                      VEUSurface     pDst,
-                      VEUvoid*       pProgress,
-                      VEUulong       uiEffectKind)
+VEUFence veuEffectProcAsync(VEUvoid*       pFunctionContext,
+                            VEUSurface     pSrc,
+                            VEUSurface     pDst,
+                            VEUvoid*       pProgress,
+                            VEUulong       uiEffectKind)
 {
-    VEUbool     ret      = VEU_FALSE;
+    VEUFence    ret      = VEU_NULL;
     switch(uiEffectKind + M4VSS3GPP_kVideoTransitionType_External)
     {
         case M4xVSS_kVideoEffectType_BlackAndWhite :
@@ -743,37 +919,102 @@ VEUbool veuEffectProc(VEUvoid*       pFunctionContext,
         case M4xVSS_kVideoEffectType_Negative :
         case M4xVSS_kVideoEffectType_ColorRGB16 :
         case M4xVSS_kVideoEffectType_Gradient :
-            ret = veuEffectColorProc(pFunctionContext, pSrc, pDst, pProgress, uiEffectKind);
+            ret = veuEffectColorProcAsync(pFunctionContext, pSrc, pDst, pProgress, uiEffectKind);
             return ret;
        case M4xVSS_kVideoEffectType_ZoomIn:
        case M4xVSS_kVideoEffectType_ZoomOut:
-            ret = veuEffectZoomProc(pFunctionContext, pSrc, pDst, pProgress, uiEffectKind);
+            ret = veuEffectZoomProcAsync(pFunctionContext, pSrc, pDst, pProgress, uiEffectKind);
             return ret;
         default:
             _veuDebugf("%s(%d) : unsupported EffectKind: %d.\n", __func__, __LINE__, (VEUuint)uiEffectKind);
-            return VEU_FALSE;
+            return VEU_NULL;
     }
 }
 
-VEUbool veuTransitionProc(VEUvoid*       userData,
-                          VEUSurface     pSrc1,
-                          VEUSurface     pSrc2,
-                          VEUSurface     pDst,
-                          VEUvoid*       pProgress,
-                          VEUulong       uiTransitionKind)
+VEUFence veuTransitionProcAsync(VEUvoid*       userData,
+                                VEUSurface     pSrc1,
+                                VEUSurface     pSrc2,
+                                VEUSurface     pDst,
+                                VEUvoid*       pProgress,
+                                VEUulong       uiTransitionKind)
 {
-    VEUbool     ret      = VEU_FALSE;
+    VEUFence    ret      = VEU_NULL;
     switch(uiTransitionKind + M4VSS3GPP_kVideoTransitionType_External)
     {
         case M4xVSS_kVideoTransitionType_SlideTransition :
-            ret = veuSlideTransitionProc(userData, pSrc1, pSrc2, pDst, pProgress, uiTransitionKind);
+            ret = veuSlideTransitionProcAsync(userData, pSrc1, pSrc2, pDst, pProgress, uiTransitionKind);
             return ret;
        case M4xVSS_kVideoTransitionType_FadeBlack :
-            ret = veuFadeBlackProc(userData, pSrc1, pSrc2, pDst, pProgress, uiTransitionKind);
+            ret = veuFadeBlackProcAsync(userData, pSrc1, pSrc2, pDst, pProgress, uiTransitionKind);
             return ret;
         default:
             _veuDebugf("%s(%d) : unsupported TransitionKind: %d.\n", __func__, __LINE__, (VEUuint)uiTransitionKind);
-            return VEU_FALSE;
+            return VEU_NULL;
     }
 
 }
+
+
+/*
+ *  Synchronous variants, wait the work of the asynchronous call
+ */
+VEUbool veuEffectColorProc(VEUvoid*       pFunctionContext,
+                           VEUSurface     pSrcSurface,
+                           VEUSurface     pDstSurface,
+                           VEUvoid*       pProgress,
+                           VEUulong       uiEffectKind)
+{
+    return veuWaitFence(veuEffectColorProcAsync(pFunctionContext, pSrcSurface, pDstSurface, pProgress, uiEffectKind),
+                        VEU_INFINITE);
+}
+
+VEUbool veuEffectZoomProc(VEUvoid*       pFunctionContext,
+                          VEUSurface     pSrcSurface,
+                          VEUSurface     pDstSurface,
+                          VEUvoid*       pProgress,
+                          VEUulong       uiEffectKind)
+{
+    return veuWaitFence(veuEffectZoomProcAsync(pFunctionContext, pSrcSurface, pDstSurface, pProgress, uiEffectKind),
+                        VEU_INFINITE);
+}
+
+VEUbool veuSlideTransitionProc(VEUvoid*       userData,
+                               VEUSurface     pSrcSurface1,
+                               VEUSurface     pSrcSurface2,
+                               VEUSurface     pDstSurface,
+                               VEUvoid*       pProgress,
+                               VEUulong       uiTransitionKind)
+{
+    return veuWaitFence(veuSlideTransitionProcAsync(userData, pSrcSurface1, pSrcSurface2, pDstSurface, pProgress, uiTransitionKind),
+                        VEU_INFINITE);
+}
+
+VEUbool veuFadeBlackProc(VEUvoid*       userData,
+                         VEUSurface     pSrcSurface1,
+                         VEUSurface     pSrcSurface2,
+                         VEUSurface     pDstSurface,
+                         VEUvoid*       pProgress,
+                         VEUulong       uiTransitionKind)
+{
+    return veuWaitFence(veuFadeBlackProcAsync(userData, pSrcSurface1, pSrcSurface2, pDstSurface, pProgress, uiTransitionKind),
+                        VEU_INFINITE);
+}
+
+VEUbool veuEffectProc(VEUvoid*       pFunctionContext,
+                      VEUSurface     pSrc,
+                      VEUSurface     pDst,
+                      VEUvoid*       pProgress,
+                      VEUulong       uiEffectKind)
+{
+    return veuWaitFence(veuEffectProcAsync(pFunctionContext, pSrc, pDst, pProgress, uiEffectKind), VEU_INFINITE);
+}
+
+VEUbool veuTransitionProc(VEUvoid*       userData,
+                          VEUSurface     pSrc1,
+                          VEUSurface     pSrc2,
+                          VEUSurface     pDst,
+                          VEUvoid*       pProgress,
+                          VEUulong       uiTransitionKind)
+{
+    return veuWaitFence(veuTransitionProcAsync(userData, pSrc1, pSrc2, pDst, pProgress, uiTransitionKind), VEU_INFINITE);
+}
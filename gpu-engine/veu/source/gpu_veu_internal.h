@@ -77,6 +77,12 @@ VEUvoid _veuFinish(VEUContext pContext);
 
 VEUSurface _veuGetGradient();
 
+/* Wait the in-flight work using a surface and drop the plane views cached for it */
+VEUvoid _veuInflightReleaseSurface(VEUContext pContext, VEUSurface pSurface);
+
+/* Wait all in-flight work and free the in-flight ring */
+VEUvoid _veuInflightTerminate(VEUContext pContext);
+
 /* print log */
 void _veuDebugf(const char format[], ...);
 /*check if the compiler is of C++*/
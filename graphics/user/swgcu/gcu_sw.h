@@ -0,0 +1,233 @@
+/***********************************************************************************
+ *
+ *    Copyright (c) 2009 - 2013 by Marvell International Ltd. and its affiliates.
+ *    All rights reserved.
+ *
+ *    This software file (the "File") is owned and distributed by Marvell
+ *    International Ltd. and/or its affiliates ("Marvell") under Marvell Commercial
+ *    License.
+ *
+ *    If you received this File from Marvell and you have entered into a commercial
+ *    license agreement (a "Commercial License") with Marvell, the File is licensed
+ *    to you under the terms of the applicable Commercial License.
+ *
+ *
+ ***********************************************************************************/
+
+/*!
+ ******************************************************************************
+ *  \file gcu_sw.h
+ *  \brief
+ *      Internal declarations of the software GCU, the reference implementation
+ *      of gcu.h for hosts without a GC GPU.
+ ******************************************************************************/
+
+#ifndef __GCU_SW_H__
+#define __GCU_SW_H__
+
+#include <stdint.h>
+#include <pthread.h>
+
+#include "gcu.h"
+
+#define SW_SURFACE_MAGIC        0x53555246      /* 'SURF' */
+#define SW_CONTEXT_MAGIC        0x43545854      /* 'CTXT' */
+#define SW_FENCE_MAGIC          0x46454e43      /* 'FENC' */
+
+#define SW_MAX_PLANES           3
+#define SW_MAX_THREADS          16
+#define SW_FILTER_TAPS          9
+#define SW_FILTER_SHIFT         12              /* filter coefficients are 4.12 fixed point */
+#define SW_BAND_ROWS            16              /* rows per job band, even for 4:2:0 pairs */
+#define SW_AUTO_FLUSH           64              /* queued commands that force a flush */
+
+#define SW_ALIGN(x, a)          (((x) + (a) - 1) & ~((a) - 1))
+#define SW_MIN(a, b)            ((a) < (b) ? (a) : (b))
+#define SW_MAX(a, b)            ((a) > (b) ? (a) : (b))
+
+/*
+ * Pixel formats
+ */
+typedef struct _SW_FORMAT_INFO{
+    GCU_FORMAT      format;
+    const char*     name;
+    GCUuint         bpp;            /* bytes per pixel of plane 0                        */
+    GCUuint         planes;         /* 1 packed, 2 semi-planar, 3 planar                 */
+    GCUuint         hShift;         /* chroma subsampling, log2                          */
+    GCUuint         vShift;
+    GCUbool         bYUV;
+    GCUbool         bAlpha;         /* format stores alpha, else alpha reads as 255     */
+
+    /* packed RGB: channel widths and positions in the pixel word */
+    GCUuint         aBits, aShift;
+    GCUuint         rBits, rShift;
+    GCUuint         gBits, gShift;
+    GCUuint         bBits, bShift;
+    GCUuint         xMask;          /* padding bits, written as ones                     */
+
+    /* packed YUV: byte offsets inside a 2 pixel group; semi-planar: V before U */
+    GCUuint         y0, y1, u, v;
+    GCUbool         bVFirst;
+}SW_FORMAT_INFO;
+
+const SW_FORMAT_INFO* _swGetFormatInfo(GCU_FORMAT format);
+
+/*
+ * Surfaces
+ */
+typedef struct _SW_PLANE{
+    unsigned char*  pBase;
+    GCUint          stride;         /* bytes per row                                     */
+    GCUuint         width;          /* allocated width in pixels                         */
+    GCUuint         height;         /* allocated height in rows                          */
+    GCUPhysicalAddr physicalAddr;
+}SW_PLANE;
+
+typedef struct _SW_SURFACE{
+    GCUuint                 magic;
+    const SW_FORMAT_INFO*   pInfo;
+    GCU_SURFACE_LOCATION    location;
+    GCU_TILE_TYPE           tileType;
+    GCUuint                 width;
+    GCUuint                 height;
+    GCUuint                 planeCount;
+    SW_PLANE                planes[SW_MAX_PLANES];
+    GCUbool                 bPreAllocVirtual;
+    GCUbool                 bPreAllocPhysical;
+    GCUbool                 bMappedPhysical;
+    void*                   pMemory;        /* owned allocation, NULL when pre-allocated */
+    GCUuint                 size;
+}SW_SURFACE;
+
+/* 32 bit ARGB image, the working format of all rendering */
+typedef struct _SW_IMAGE{
+    uint32_t*       pPixels;
+    GCUint          stride;         /* in pixels */
+    GCUint          width;
+    GCUint          height;
+    void*           pOwned;
+}SW_IMAGE;
+
+GCUbool _swSurfaceAlloc(SW_SURFACE* pSurface);
+GCUbool _swSurfaceSetPlanes(SW_SURFACE* pSurface, GCU_ALLOC_INFO* pInfos, GCUuint count);
+void    _swSurfaceAlignment(GCU_TILE_TYPE tileType, GCUuint* pAlignW, GCUuint* pAlignH);
+
+/* byte offset of pixel (x, y) in plane 0 of a tiled or linear surface */
+GCUuint _swTileOffset(const SW_SURFACE* pSurface, GCUuint x, GCUuint y);
+
+/* rows of a surface to and from 32 bit ARGB */
+void    _swFetchRow(const SW_SURFACE* pSurface, GCUint x, GCUint y, GCUint count, uint32_t* pOut);
+void    _swStoreRows(SW_SURFACE* pSurface, GCUint x, GCUint y, GCUint count,
+                     GCUint rows, const uint32_t* const* ppIn, GCUbool bDither);
+
+uint32_t _swYUVToARGB(GCUint y, GCUint u, GCUint v);
+void     _swARGBToYUV(uint32_t argb, GCUint* pY, GCUint* pU, GCUint* pV);
+
+/*
+ * Span kernels, SIMD where the target has it
+ */
+void    _swSpanFill32(uint32_t* pDst, uint32_t value, GCUint count);
+void    _swSpanFill16(uint16_t* pDst, uint16_t value, GCUint count);
+void    _swSpanBlend(uint32_t* pDst, const uint32_t* pSrc, GCUint count,
+                     GCU_BLEND_MODE mode, GCUuint srcGlobalAlpha, GCUuint dstGlobalAlpha);
+const char* _swSpanKernelName(void);
+
+/*
+ * Commands
+ */
+typedef enum _SW_COMMAND_TYPE{
+    SW_CMD_FILL,
+    SW_CMD_BLIT,
+    SW_CMD_BLEND,
+    SW_CMD_ROP,
+    SW_CMD_FILTER,
+    SW_CMD_COMPOSE
+}SW_COMMAND_TYPE;
+
+typedef struct _SW_LAYER{
+    SW_SURFACE*     pSrc;
+    GCU_RECT        srcRect;
+    GCU_RECT        dstRect;        /* may reach outside the destination */
+    GCU_ROTATION    rotation;
+    GCU_BLEND_MODE  blendMode;
+    GCUuint         srcGlobalAlpha;
+    GCUuint         dstGlobalAlpha;
+}SW_LAYER;
+
+typedef struct _SW_COMMAND{
+    struct _SW_COMMAND* pNext;
+    SW_COMMAND_TYPE     type;
+    SW_SURFACE*         pDst;
+    GCU_RECT            clipRect;       /* already inside the destination */
+    GCU_QUALITY_TYPE    quality;
+    GCUbool             bDither;
+
+    /* fill */
+    GCUuint             color;
+    SW_SURFACE*         pPattern;
+    GCU_RECT            fillRect;
+
+    /* blit, blend, rop, filter and compose */
+    GCUuint             layerCount;
+    SW_LAYER*           pLayers;
+    GCUuint             rop;
+    GCU_FILTER_TYPE     filterType;
+    GCUint              coef[2][SW_FILTER_TAPS];
+
+    SW_LAYER            layer;          /* storage when there is a single layer */
+}SW_COMMAND;
+
+void    _swExecute(SW_COMMAND* pCommand);
+
+/*
+ * Contexts and the deferred command queue
+ */
+typedef struct _SW_CONTEXT{
+    GCUuint             magic;
+    pthread_mutex_t     lock;
+    pthread_cond_t      workCond;
+    pthread_cond_t      doneCond;
+    pthread_t           thread;
+    GCUbool             bThread;
+    GCUbool             bQuit;
+
+    SW_COMMAND*         pHead;
+    SW_COMMAND*         pTail;
+    uint64_t            recorded;       /* commands queued so far      */
+    uint64_t            submitted;      /* commands handed to the drain */
+    uint64_t            completed;      /* commands executed           */
+
+    GCU_QUALITY_TYPE    quality;
+    GCUbool             bDither;
+    GCUbool             bClip;
+    GCUint              coef[2][SW_FILTER_TAPS];    /* H and V user filters */
+}SW_CONTEXT;
+
+typedef struct _SW_FENCE{
+    GCUuint             magic;
+    SW_CONTEXT*         pContext;
+    uint64_t            seq;
+    GCUbool             bSent;
+}SW_FENCE;
+
+GCUbool _swQueueStart(SW_CONTEXT* pContext);
+void    _swQueueStop(SW_CONTEXT* pContext);
+void    _swQueueRecord(SW_CONTEXT* pContext, SW_COMMAND* pCommand);
+void    _swQueueFlush(SW_CONTEXT* pContext);
+GCUbool _swQueueWait(SW_CONTEXT* pContext, uint64_t seq, GCUuint timeoutMs);
+
+/* worker pool shared by all contexts: runs func(pArg, band) for every band */
+typedef void (*SW_JOB_FUNC)(void* pArg, GCUuint band);
+
+GCUbool _swPoolStart(void);
+void    _swPoolStop(void);
+void    _swPoolRun(SW_JOB_FUNC func, void* pArg, GCUuint bandCount);
+GCUuint _swPoolThreads(void);
+
+/*
+ * Errors
+ */
+void    _swSetError(GCUenum error, const char* func);
+GCUbool _swDebug(void);
+
+#endif /* __GCU_SW_H__ */
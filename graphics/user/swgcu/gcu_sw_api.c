@@ -0,0 +1,1122 @@
+/***********************************************************************************
+ *
+ *    Copyright (c) 2009 - 2013 by Marvell International Ltd. and its affiliates.
+ *    All rights reserved.
+ *
+ *    This software file (the "File") is owned and distributed by Marvell
+ *    International Ltd. and/or its affiliates ("Marvell") under Marvell Commercial
+ *    License.
+ *
+ *    If you received this File from Marvell and you have entered into a commercial
+ *    license agreement (a "Commercial License") with Marvell, the File is licensed
+ *    to you under the terms of the applicable Commercial License.
+ *
+ *
+ ***********************************************************************************/
+
+/*!
+ ******************************************************************************
+ *  \file gcu_sw_api.c
+ *  \brief
+ *      gcu.h entry points of the software GCU: argument checking, surface
+ *      objects, and recording of the rendering calls in the context queue.
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gcu_sw.h"
+
+#define SW_VERSION_STRING       "GCU 2.0 software reference"
+#define SW_VENDOR_STRING        "Marvell Technology Group Ltd"
+#define SW_RENDERER_STRING      "Software GCU"
+
+static pthread_mutex_t  s_initLock = PTHREAD_MUTEX_INITIALIZER;
+static GCUuint          s_initCount;
+static GCUbool          s_bDebug;
+static GCUenum          s_error = GCU_NO_ERROR;
+
+/*
+ * Errors
+ */
+void _swSetError(GCUenum error, const char* func)
+{
+    s_error = error;
+    if(s_bDebug)
+    {
+        fprintf(stderr, "GCU: %s failed: %s\n", func, gcuGetErrorString(error));
+    }
+}
+
+GCUbool _swDebug(void)
+{
+    return s_bDebug;
+}
+
+GCUenum gcuGetError()
+{
+    GCUenum error = s_error;
+
+    s_error = GCU_NO_ERROR;
+    return error;
+}
+
+const char* gcuGetErrorString(GCUenum error)
+{
+    switch(error)
+    {
+    case GCU_NO_ERROR:
+        return "GCU_NO_ERROR";
+    case GCU_NOT_INITIALIZED:
+        return "GCU_NOT_INITIALIZED";
+    case GCU_INVALID_PARAMETER:
+        return "GCU_INVALID_PARAMETER";
+    case GCU_INVALID_OPERATION:
+        return "GCU_INVALID_OPERATION";
+    case GCU_OUT_OF_MEMORY:
+        return "GCU_OUT_OF_MEMORY";
+    default:
+        return "GCU_UNKNOWN_ERROR";
+    }
+}
+
+const char* gcuGetString(GCUenum name)
+{
+    switch(name)
+    {
+    case GCU_VERSION:
+        return SW_VERSION_STRING;
+    case GCU_VENDOR:
+        return SW_VENDOR_STRING;
+    case GCU_RENDERER:
+        return SW_RENDERER_STRING;
+    case GCU_ERROR:
+        return gcuGetErrorString(s_error);
+    default:
+        _swSetError(GCU_INVALID_PARAMETER, __FUNCTION__);
+        return GCU_NULL;
+    }
+}
+
+/*
+ * Object checks
+ */
+static SW_CONTEXT* _swContext(GCUContext pContext, const char* func)
+{
+    SW_CONTEXT* pCtx = (SW_CONTEXT*)pContext;
+
+    if(s_initCount == 0)
+    {
+        _swSetError(GCU_NOT_INITIALIZED, func);
+        return GCU_NULL;
+    }
+    if(pCtx == GCU_NULL || pCtx->magic != SW_CONTEXT_MAGIC)
+    {
+        _swSetError(GCU_INVALID_PARAMETER, func);
+        return GCU_NULL;
+    }
+    return pCtx;
+}
+
+static SW_SURFACE* _swSurface(GCUSurface pSurface, const char* func)
+{
+    SW_SURFACE* pSurf = (SW_SURFACE*)pSurface;
+
+    if(pSurf == GCU_NULL || pSurf->magic != SW_SURFACE_MAGIC)
+    {
+        _swSetError(GCU_INVALID_PARAMETER, func);
+        return GCU_NULL;
+    }
+    return pSurf;
+}
+
+static void _swFinish(SW_CONTEXT* pCtx)
+{
+    _swQueueWait(pCtx, pCtx->recorded, GCU_INFINITE);
+}
+
+/*
+ * Initialization and termination
+ */
+GCUbool gcuInitialize(GCU_INIT_DATA* pData)
+{
+    pthread_mutex_lock(&s_initLock);
+    if(s_initCount++ == 0)
+    {
+        s_bDebug = pData ? pData->debug : GCU_FALSE;
+        _swPoolStart();
+        if(s_bDebug)
+        {
+            fprintf(stderr, "GCU: %s, %u threads, %s spans\n",
+                    SW_RENDERER_STRING, _swPoolThreads(), _swSpanKernelName());
+        }
+    }
+    pthread_mutex_unlock(&s_initLock);
+
+    if(pData)
+    {
+        pData->version = GCU_VERSION_2_0;
+    }
+    return GCU_TRUE;
+}
+
+GCUvoid gcuTerminate()
+{
+    pthread_mutex_lock(&s_initLock);
+    if(s_initCount && --s_initCount == 0)
+    {
+        _swPoolStop();
+    }
+    pthread_mutex_unlock(&s_initLock);
+}
+
+/*
+ * Contexts
+ */
+GCUContext gcuCreateContext(GCU_CONTEXT_DATA* pData)
+{
+    SW_CONTEXT* pCtx;
+
+    (void)pData;
+    if(s_initCount == 0)
+    {
+        _swSetError(GCU_NOT_INITIALIZED, __FUNCTION__);
+        return GCU_NULL;
+    }
+
+    pCtx = (SW_CONTEXT*)calloc(1, sizeof(SW_CONTEXT));
+    if(pCtx == GCU_NULL)
+    {
+        _swSetError(GCU_OUT_OF_MEMORY, __FUNCTION__);
+        return GCU_NULL;
+    }
+    pCtx->quality = GCU_QUALITY_NORMAL;
+    pCtx->bDither = GCU_FALSE;
+    pCtx->bClip = GCU_TRUE;
+    pCtx->coef[0][SW_FILTER_TAPS / 2] = 1 << SW_FILTER_SHIFT;
+    pCtx->coef[1][SW_FILTER_TAPS / 2] = 1 << SW_FILTER_SHIFT;
+
+    if(!_swQueueStart(pCtx))
+    {
+        free(pCtx);
+        _swSetError(GCU_OUT_OF_MEMORY, __FUNCTION__);
+        return GCU_NULL;
+    }
+    pCtx->magic = SW_CONTEXT_MAGIC;
+    return pCtx;
+}
+
+GCUvoid gcuDestroyContext(GCUContext pContext)
+{
+    SW_CONTEXT* pCtx = _swContext(pContext, __FUNCTION__);
+
+    if(pCtx == GCU_NULL)
+    {
+        return;
+    }
+    _swQueueStop(pCtx);
+    pCtx->magic = 0;
+    free(pCtx);
+}
+
+GCUbool gcuSet(GCUContext pContext, GCU_STATE_TYPE state, GCUint value)
+{
+    SW_CONTEXT* pCtx = _swContext(pContext, __FUNCTION__);
+
+    if(pCtx == GCU_NULL)
+    {
+        return GCU_FALSE;
+    }
+    switch(state)
+    {
+    case GCU_QUALITY:
+        if(value < GCU_QUALITY_NORMAL || value > GCU_QUALITY_BEST)
+        {
+            break;
+        }
+        pCtx->quality = (GCU_QUALITY_TYPE)value;
+        return GCU_TRUE;
+    case GCU_DITHER:
+        pCtx->bDither = value ? GCU_TRUE : GCU_FALSE;
+        return GCU_TRUE;
+    case GCU_CLIP_RECT:
+        pCtx->bClip = value ? GCU_TRUE : GCU_FALSE;
+        return GCU_TRUE;
+    default:
+        break;
+    }
+    _swSetError(GCU_INVALID_PARAMETER, __FUNCTION__);
+    return GCU_FALSE;
+}
+
+GCUvoid gcuSetFilter(GCUContext pContext, GCU_FILTER_TYPE filterType, GCUint filterSize, GCUfloat* pCoef)
+{
+    SW_CONTEXT* pCtx = _swContext(pContext, __FUNCTION__);
+    GCUint* pDst;
+    GCUint i;
+
+    if(pCtx == GCU_NULL)
+    {
+        return;
+    }
+    if(filterSize != SW_FILTER_TAPS || pCoef == GCU_NULL ||
+       (filterType != GCU_H_USER_FILTER && filterType != GCU_V_USER_FILTER))
+    {
+        _swSetError(GCU_INVALID_PARAMETER, __FUNCTION__);
+        return;
+    }
+
+    /* the coefficients apply to commands recorded from now on */
+    pDst = pCtx->coef[filterType == GCU_H_USER_FILTER ? 0 : 1];
+    for(i = 0; i < SW_FILTER_TAPS; i++)
+    {
+        GCUfloat c = pCoef[i] * (1 << SW_FILTER_SHIFT);
+
+        pDst[i] = c >= 0 ? (GCUint)(c + 0.5f) : -(GCUint)(-c + 0.5f);
+    }
+}
+
+/*
+ * Surfaces
+ */
+static SW_SURFACE* _swNewSurface(GCU_FORMAT format, GCUuint width, GCUuint height,
+                                 GCU_TILE_TYPE tileType, const char* func)
+{
+    const SW_FORMAT_INFO* pInfo = _swGetFormatInfo(format);
+    SW_SURFACE* pSurface;
+
+    if(pInfo == GCU_NULL || width == 0 || height == 0 || tileType > GCU_MULTI_SUPER_TILED ||
+       (pInfo->bYUV && tileType != GCU_LINEAR) ||
+       (width & ((1 << pInfo->hShift) - 1)) || (height & ((1 << pInfo->vShift) - 1)))
+    {
+        _swSetError(GCU_INVALID_PARAMETER, func);
+        return GCU_NULL;
+    }
+
+    pSurface = (SW_SURFACE*)calloc(1, sizeof(SW_SURFACE));
+    if(pSurface == GCU_NULL)
+    {
+        _swSetError(GCU_OUT_OF_MEMORY, func);
+        return GCU_NULL;
+    }
+    pSurface->pInfo = pInfo;
+    pSurface->tileType = tileType;
+    pSurface->width = width;
+    pSurface->height = height;
+    return pSurface;
+}
+
+static GCUSurface _swCreate(SW_CONTEXT* pCtx, GCU_SURFACE_DATA* pData, const char* func)
+{
+    SW_SURFACE* pSurface;
+
+    (void)pCtx;
+    if(pData->flag.bits.preAllocPhysical && !pData->flag.bits.preAllocVirtual)
+    {
+        _swSetError(GCU_INVALID_PARAMETER, func);
+        return GCU_NULL;
+    }
+    if(pData->flag.bits.preAllocVirtual && (pData->pPreAllocInfos == GCU_NULL || pData->arraySize == 0))
+    {
+        _swSetError(GCU_INVALID_PARAMETER, func);
+        return GCU_NULL;
+    }
+
+    pSurface = _swNewSurface(pData->format, pData->width, pData->height,
+                             (GCU_TILE_TYPE)pData->flag.bits.tileType, func);
+    if(pSurface == GCU_NULL)
+    {
+        return GCU_NULL;
+    }
+    pSurface->location = pData->location;
+    pSurface->bPreAllocVirtual = pData->flag.bits.preAllocVirtual;
+    pSurface->bPreAllocPhysical = pData->flag.bits.preAllocPhysical;
+
+    if(pSurface->bPreAllocVirtual)
+    {
+        if(!_swSurfaceSetPlanes(pSurface, pData->pPreAllocInfos, pData->arraySize))
+        {
+            free(pSurface);
+            _swSetError(GCU_INVALID_PARAMETER, func);
+            return GCU_NULL;
+        }
+        if(!pSurface->bPreAllocPhysical)
+        {
+            GCUuint i;
+
+            for(i = 0; i < pSurface->planeCount; i++)
+            {
+                pSurface->planes[i].physicalAddr = 0;
+            }
+        }
+    }
+    else if(!_swSurfaceAlloc(pSurface))
+    {
+        free(pSurface);
+        _swSetError(GCU_OUT_OF_MEMORY, func);
+        return GCU_NULL;
+    }
+
+    pSurface->magic = SW_SURFACE_MAGIC;
+    return pSurface;
+}
+
+GCUSurface gcuCreateSurface(GCUContext pContext, GCU_SURFACE_DATA* pData)
+{
+    SW_CONTEXT* pCtx = _swContext(pContext, __FUNCTION__);
+
+    if(pCtx == GCU_NULL)
+    {
+        return GCU_NULL;
+    }
+    if(pData == GCU_NULL || pData->dimention != GCU_SURFACE_2D)
+    {
+        _swSetError(GCU_INVALID_PARAMETER, __FUNCTION__);
+        return GCU_NULL;
+    }
+    return _swCreate(pCtx, pData, __FUNCTION__);
+}
+
+GCUvoid gcuDestroySurface(GCUContext pContext, GCUSurface pSurface)
+{
+    SW_CONTEXT* pCtx = _swContext(pContext, __FUNCTION__);
+    SW_SURFACE* pSurf = _swSurface(pSurface, __FUNCTION__);
+
+    if(pCtx == GCU_NULL || pSurf == GCU_NULL)
+    {
+        return;
+    }
+
+    /* queued commands may still read or write it */
+    _swFinish(pCtx);
+    pSurf->magic = 0;
+    free(pSurf->pMemory);
+    free(pSurf);
+}
+
+GCUbool gcuQuerySurfaceInfo(GCUContext pContext, GCUSurface pSurface, GCU_SURFACE_DATA* pData)
+{
+    SW_CONTEXT* pCtx = _swContext(pContext, __FUNCTION__);
+    SW_SURFACE* pSurf = _swSurface(pSurface, __FUNCTION__);
+
+    if(pCtx == GCU_NULL || pSurf == GCU_NULL)
+    {
+        return GCU_FALSE;
+    }
+    if(pData == GCU_NULL)
+    {
+        _swSetError(GCU_INVALID_PARAMETER, __FUNCTION__);
+        return GCU_FALSE;
+    }
+
+    memset(pData, 0, sizeof(*pData));
+    pData->location = pSurf->location;
+    pData->dimention = GCU_SURFACE_2D;
+    pData->flag.bits.preAllocVirtual = pSurf->bPreAllocVirtual;
+    pData->flag.bits.preAllocPhysical = pSurf->bPreAllocPhysical;
+    pData->flag.bits.tileType = pSurf->tileType;
+    pData->format = pSurf->pInfo->format;
+    pData->width = pSurf->width;
+    pData->height = pSurf->height;
+    pData->arraySize = pSurf->planeCount;
+    return GCU_TRUE;
+}
+
+GCUbool gcuLockSurface(GCUContext pContext, GCU_SURFACE_LOCK_DATA* pData)
+{
+    SW_CONTEXT* pCtx = _swContext(pContext, __FUNCTION__);
+    SW_SURFACE* pSurf;
+    GCUuint i;
+
+    if(pCtx == GCU_NULL)
+    {
+        return GCU_FALSE;
+    }
+    if(pData == GCU_NULL || pData->pAllocInfos == GCU_NULL || pData->arraySize == 0)
+    {
+        _swSetError(GCU_INVALID_PARAMETER, __FUNCTION__);
+        return GCU_FALSE;
+    }
+    pSurf = _swSurface(pData->pSurface, __FUNCTION__);
+    if(pSurf == GCU_NULL)
+    {
+        return GCU_FALSE;
+    }
+
+    /* contents are always preserved: the CPU sees the memory the commands wrote */
+    _swFinish(pCtx);
+    for(i = 0; i < pData->arraySize && i < pSurf->planeCount; i++)
+    {
+        GCU_ALLOC_INFO* pInfo = &pData->pAllocInfos[i];
+
+        memset(pInfo, 0, sizeof(*pInfo));
+        pInfo->width = pSurf->planes[i].width;
+        pInfo->height = pSurf->planes[i].height;
+        pInfo->stride = pSurf->planes[i].stride;
+        pInfo->virtualAddr = pSurf->planes[i].pBase;
+        pInfo->physicalAddr = pSurf->planes[i].physicalAddr;
+        pInfo->bMappedPhysical = pSurf->bMappedPhysical;
+    }
+    return GCU_TRUE;
+}
+
+GCUvoid gcuUnlockSurface(GCUContext pContext, GCUSurface pSurface)
+{
+    if(_swContext(pContext, __FUNCTION__) == GCU_NULL)
+    {
+        return;
+    }
+    _swSurface(pSurface, __FUNCTION__);
+}
+
+static GCUbool _swUpdate(SW_CONTEXT* pCtx, SW_SURFACE* pSurf, GCUbool bVirtual, GCUbool bPhysical,
+                         GCU_ALLOC_INFO* pInfos, GCUuint count, const char* func)
+{
+    SW_SURFACE updated;
+
+    if(!pSurf->bPreAllocVirtual ||
+       bVirtual != pSurf->bPreAllocVirtual || bPhysical != pSurf->bPreAllocPhysical)
+    {
+        _swSetError(GCU_INVALID_OPERATION, func);
+        return GCU_FALSE;
+    }
+
+    _swFinish(pCtx);
+    updated = *pSurf;
+    if(!_swSurfaceSetPlanes(&updated, pInfos, count))
+    {
+        _swSetError(GCU_INVALID_PARAMETER, func);
+        return GCU_FALSE;
+    }
+    *pSurf = updated;
+    return GCU_TRUE;
+}
+
+GCUbool gcuUpdateSurface(GCUContext pContext, GCU_SURFACE_UPDATE_DATA* pData)
+{
+    SW_CONTEXT* pCtx = _swContext(pContext, __FUNCTION__);
+    SW_SURFACE* pSurf;
+
+    if(pCtx == GCU_NULL)
+    {
+        return GCU_FALSE;
+    }
+    if(pData == GCU_NULL || pData->pAllocInfos == GCU_NULL || pData->arraySize == 0)
+    {
+        _swSetError(GCU_INVALID_PARAMETER, __FUNCTION__);
+        return GCU_FALSE;
+    }
+    pSurf = _swSurface(pData->pSurface, __FUNCTION__);
+    if(pSurf == GCU_NULL)
+    {
+        return GCU_FALSE;
+    }
+    return _swUpdate(pCtx, pSurf, pData->flag.bits.preAllocVirtual, pData->flag.bits.preAllocPhysical,
+                     pData->pAllocInfos, pData->arraySize, __FUNCTION__);
+}
+
+/*
+ * Rendering
+ */
+static void _swFullRect(const SW_SURFACE* pSurface, GCU_RECT* pRect)
+{
+    pRect->left = 0;
+    pRect->top = 0;
+    pRect->right = pSurface->width;
+    pRect->bottom = pSurface->height;
+}
+
+static SW_COMMAND* _swNewCommand(SW_CONTEXT* pCtx, SW_COMMAND_TYPE type, SW_SURFACE* pDst,
+                                 const GCU_RECT* pClipRect, const char* func)
+{
+    SW_COMMAND* pCommand = (SW_COMMAND*)calloc(1, sizeof(SW_COMMAND));
+
+    if(pCommand == GCU_NULL)
+    {
+        _swSetError(GCU_OUT_OF_MEMORY, func);
+        return GCU_NULL;
+    }
+    pCommand->type = type;
+    pCommand->pDst = pDst;
+    pCommand->quality = pCtx->quality;
+    pCommand->bDither = pCtx->bDither;
+    pCommand->layerCount = 1;
+    pCommand->pLayers = &pCommand->layer;
+
+    _swFullRect(pDst, &pCommand->clipRect);
+    if(pClipRect && pCtx->bClip)
+    {
+        pCommand->clipRect.left = SW_MAX(pCommand->clipRect.left, pClipRect->left);
+        pCommand->clipRect.top = SW_MAX(pCommand->clipRect.top, pClipRect->top);
+        pCommand->clipRect.right = SW_MIN(pCommand->clipRect.right, pClipRect->right);
+        pCommand->clipRect.bottom = SW_MIN(pCommand->clipRect.bottom, pClipRect->bottom);
+    }
+    return pCommand;
+}
+
+static GCUbool _swSetLayer(SW_LAYER* pLayer, GCUSurface pSrcSurface, const GCU_RECT* pSrcRect,
+                           const GCU_RECT* pDstRect, const SW_SURFACE* pDst, GCU_ROTATION rotation,
+                           const char* func)
+{
+    SW_SURFACE* pSrc = _swSurface(pSrcSurface, func);
+
+    if(pSrc == GCU_NULL)
+    {
+        return GCU_FALSE;
+    }
+    if(rotation > GCU_ROTATION_270)
+    {
+        _swSetError(GCU_INVALID_PARAMETER, func);
+        return GCU_FALSE;
+    }
+
+    pLayer->pSrc = pSrc;
+    pLayer->rotation = rotation;
+    pLayer->blendMode = GCU_BLEND_SRC;
+    pLayer->srcGlobalAlpha = 255;
+    pLayer->dstGlobalAlpha = 255;
+    if(pSrcRect)
+    {
+        pLayer->srcRect = *pSrcRect;
+    }
+    else
+    {
+        _swFullRect(pSrc, &pLayer->srcRect);
+    }
+    if(pDstRect)
+    {
+        pLayer->dstRect = *pDstRect;
+    }
+    else
+    {
+        _swFullRect(pDst, &pLayer->dstRect);
+    }
+
+    /* the source is read inside the surface only, the destination is clipped */
+    if(pLayer->srcRect.left < 0 || pLayer->srcRect.top < 0 ||
+       pLayer->srcRect.right > (GCUint)pSrc->width || pLayer->srcRect.bottom > (GCUint)pSrc->height ||
+       pLayer->srcRect.left >= pLayer->srcRect.right || pLayer->srcRect.top >= pLayer->srcRect.bottom ||
+       pLayer->dstRect.left >= pLayer->dstRect.right || pLayer->dstRect.top >= pLayer->dstRect.bottom)
+    {
+        _swSetError(GCU_INVALID_PARAMETER, func);
+        return GCU_FALSE;
+    }
+    return GCU_TRUE;
+}
+
+static GCUbool _swCheckBlend(GCU_BLEND_MODE mode, GCUuint srcGlobalAlpha, GCUuint dstGlobalAlpha, const char* func)
+{
+    if(mode > GCU_BLEND_PLUS || srcGlobalAlpha > 255 || dstGlobalAlpha > 255)
+    {
+        _swSetError(GCU_INVALID_PARAMETER, func);
+        return GCU_FALSE;
+    }
+    return GCU_TRUE;
+}
+
+GCUvoid gcuFill(GCUContext pContext, GCU_FILL_DATA* pData)
+{
+    SW_CONTEXT* pCtx = _swContext(pContext, __FUNCTION__);
+    SW_SURFACE* pDst;
+    SW_COMMAND* pCommand;
+
+    if(pCtx == GCU_NULL)
+    {
+        return;
+    }
+    if(pData == GCU_NULL)
+    {
+        _swSetError(GCU_INVALID_PARAMETER, __FUNCTION__);
+        return;
+    }
+    pDst = _swSurface(pData->pSurface, __FUNCTION__);
+    if(pDst == GCU_NULL || (!pData->bSolidColor && _swSurface(pData->pPattern, __FUNCTION__) == GCU_NULL))
+    {
+        return;
+    }
+
+    pCommand = _swNewCommand(pCtx, SW_CMD_FILL, pDst, pData->pRect, __FUNCTION__);
+    if(pCommand == GCU_NULL)
+    {
+        return;
+    }
+    pCommand->layerCount = 0;
+    pCommand->color = pData->color;
+    pCommand->pPattern = pData->bSolidColor ? GCU_NULL : (SW_SURFACE*)pData->pPattern;
+    if(pData->pRect)
+    {
+        pCommand->fillRect = *pData->pRect;
+        pCommand->clipRect.left = SW_MAX(0, pData->pRect->left);
+        pCommand->clipRect.top = SW_MAX(0, pData->pRect->top);
+        pCommand->clipRect.right = SW_MIN((GCUint)pDst->width, pData->pRect->right);
+        pCommand->clipRect.bottom = SW_MIN((GCUint)pDst->height, pData->pRect->bottom);
+    }
+    else
+    {
+        _swFullRect(pDst, &pCommand->fillRect);
+    }
+    _swQueueRecord(pCtx, pCommand);
+}
+
+GCUvoid gcuBlit(GCUContext pContext, GCU_BLT_DATA* pData)
+{
+    SW_CONTEXT* pCtx = _swContext(pContext, __FUNCTION__);
+    SW_SURFACE* pDst;
+    SW_COMMAND* pCommand;
+
+    if(pCtx == GCU_NULL)
+    {
+        return;
+    }
+    if(pData == GCU_NULL)
+    {
+        _swSetError(GCU_INVALID_PARAMETER, __FUNCTION__);
+        return;
+    }
+    pDst = _swSurface(pData->pDstSurface, __FUNCTION__);
+    if(pDst == GCU_NULL)
+    {
+        return;
+    }
+
+    pCommand = _swNewCommand(pCtx, SW_CMD_BLIT, pDst, pData->pClipRect, __FUNCTION__);
+    if(pCommand == GCU_NULL)
+    {
+        return;
+    }
+    if(!_swSetLayer(&pCommand->layer, pData->pSrcSurface, pData->pSrcRect, pData->pDstRect,
+                    pDst, pData->rotation, __FUNCTION__))
+    {
+        free(pCommand);
+        return;
+    }
+    _swQueueRecord(pCtx, pCommand);
+}
+
+GCUvoid gcuRop(GCUContext pContext, GCU_ROP_DATA* pData)
+{
+    SW_CONTEXT* pCtx = _swContext(pContext, __FUNCTION__);
+    SW_SURFACE* pDst;
+    SW_COMMAND* pCommand;
+
+    if(pCtx == GCU_NULL)
+    {
+        return;
+    }
+    if(pData == GCU_NULL || pData->rop > 0xff)
+    {
+        _swSetError(GCU_INVALID_PARAMETER, __FUNCTION__);
+        return;
+    }
+    pDst = _swSurface(pData->pDstSurface, __FUNCTION__);
+    if(pDst == GCU_NULL)
+    {
+        return;
+    }
+
+    /* the pattern is ignored, as documented in gcu.h; it reads as zero */
+    pCommand = _swNewCommand(pCtx, SW_CMD_ROP, pDst, pData->pClipRect, __FUNCTION__);
+    if(pCommand == GCU_NULL)
+    {
+        return;
+    }
+    if(!_swSetLayer(&pCommand->layer, pData->pSrcSurface, pData->pSrcRect, pData->pDstRect,
+                    pDst, pData->rotation, __FUNCTION__))
+    {
+        free(pCommand);
+        return;
+    }
+    pCommand->rop = pData->rop;
+    _swQueueRecord(pCtx, pCommand);
+}
+
+GCUvoid gcuBlend(GCUContext pContext, GCU_BLEND_DATA* pData)
+{
+    SW_CONTEXT* pCtx = _swContext(pContext, __FUNCTION__);
+    SW_SURFACE* pDst;
+    SW_COMMAND* pCommand;
+
+    if(pCtx == GCU_NULL)
+    {
+        return;
+    }
+    if(pData == GCU_NULL)
+    {
+        _swSetError(GCU_INVALID_PARAMETER, __FUNCTION__);
+        return;
+    }
+    if(!_swCheckBlend(pData->blendMode, pData->srcGlobalAlpha, pData->dstGlobalAlpha, __FUNCTION__))
+    {
+        return;
+    }
+    pDst = _swSurface(pData->pDstSurface, __FUNCTION__);
+    if(pDst == GCU_NULL)
+    {
+        return;
+    }
+    if(pDst->pInfo->bYUV)
+    {
+        _swSetError(GCU_INVALID_OPERATION, __FUNCTION__);
+        return;
+    }
+
+    pCommand = _swNewCommand(pCtx, SW_CMD_BLEND, pDst, pData->pClipRect, __FUNCTION__);
+    if(pCommand == GCU_NULL)
+    {
+        return;
+    }
+    if(!_swSetLayer(&pCommand->layer, pData->pSrcSurface, pData->pSrcRect, pData->pDstRect,
+                    pDst, pData->rotation, __FUNCTION__))
+    {
+        free(pCommand);
+        return;
+    }
+    pCommand->layer.blendMode = pData->blendMode;
+    pCommand->layer.srcGlobalAlpha = pData->srcGlobalAlpha;
+    pCommand->layer.dstGlobalAlpha = pData->dstGlobalAlpha;
+    _swQueueRecord(pCtx, pCommand);
+}
+
+GCUvoid gcuCompose(GCUContext pContext, GCU_COMPOSE_DATA* pData)
+{
+    SW_CONTEXT* pCtx = _swContext(pContext, __FUNCTION__);
+    SW_SURFACE* pDst;
+    SW_COMMAND* pCommand;
+    GCUuint i;
+
+    if(pCtx == GCU_NULL)
+    {
+        return;
+    }
+    if(pData == GCU_NULL || pData->pSrcLayers == GCU_NULL || pData->srcLayerCount == 0)
+    {
+        _swSetError(GCU_INVALID_PARAMETER, __FUNCTION__);
+        return;
+    }
+    pDst = _swSurface(pData->pDstSurface, __FUNCTION__);
+    if(pDst == GCU_NULL)
+    {
+        return;
+    }
+    if(pDst->pInfo->bYUV)
+    {
+        _swSetError(GCU_INVALID_OPERATION, __FUNCTION__);
+        return;
+    }
+
+    pCommand = _swNewCommand(pCtx, SW_CMD_COMPOSE, pDst, pData->pClipRect, __FUNCTION__);
+    if(pCommand == GCU_NULL)
+    {
+        return;
+    }
+    pCommand->pLayers = (SW_LAYER*)calloc(pData->srcLayerCount, sizeof(SW_LAYER));
+    if(pCommand->pLayers == GCU_NULL)
+    {
+        free(pCommand);
+        _swSetError(GCU_OUT_OF_MEMORY, __FUNCTION__);
+        return;
+    }
+    pCommand->layerCount = pData->srcLayerCount;
+
+    for(i = 0; i < pData->srcLayerCount; i++)
+    {
+        GCUComposeLayer* pLayer = &pData->pSrcLayers[i];
+
+        if(!_swCheckBlend(pLayer->blendMode, pLayer->srcGlobalAlpha, pLayer->dstGlobalAlpha, __FUNCTION__) ||
+           !_swSetLayer(&pCommand->pLayers[i], pLayer->pSrcSurface, pLayer->pSrcRect, pLayer->pDstRect,
+                        pDst, pLayer->rotation, __FUNCTION__))
+        {
+            free(pCommand->pLayers);
+            free(pCommand);
+            return;
+        }
+        pCommand->pLayers[i].blendMode = pLayer->blendMode;
+        pCommand->pLayers[i].srcGlobalAlpha = pLayer->srcGlobalAlpha;
+        pCommand->pLayers[i].dstGlobalAlpha = pLayer->dstGlobalAlpha;
+    }
+    _swQueueRecord(pCtx, pCommand);
+}
+
+GCUvoid gcuFilterBlit(GCUContext pContext, GCU_FILTER_BLT_DATA* pData)
+{
+    SW_CONTEXT* pCtx = _swContext(pContext, __FUNCTION__);
+    SW_SURFACE* pDst;
+    SW_COMMAND* pCommand;
+
+    if(pCtx == GCU_NULL)
+    {
+        return;
+    }
+    if(pData == GCU_NULL ||
+       (pData->filterType != GCU_H_USER_FILTER && pData->filterType != GCU_V_USER_FILTER &&
+        pData->filterType != GCU_BLUR_FILTER))
+    {
+        _swSetError(GCU_INVALID_PARAMETER, __FUNCTION__);
+        return;
+    }
+    pDst = _swSurface(pData->pDstSurface, __FUNCTION__);
+    if(pDst == GCU_NULL)
+    {
+        return;
+    }
+
+    pCommand = _swNewCommand(pCtx, SW_CMD_FILTER, pDst, GCU_NULL, __FUNCTION__);
+    if(pCommand == GCU_NULL)
+    {
+        return;
+    }
+    if(!_swSetLayer(&pCommand->layer, pData->pSrcSurface, pData->pSrcRect, pData->pDstRect,
+                    pDst, pData->rotation, __FUNCTION__))
+    {
+        free(pCommand);
+        return;
+    }
+    pCommand->filterType = pData->filterType;
+    memcpy(pCommand->coef, pCtx->coef, sizeof(pCommand->coef));
+    _swQueueRecord(pCtx, pCommand);
+}
+
+GCUvoid gcuFlush(GCUContext pContext)
+{
+    SW_CONTEXT* pCtx = _swContext(pContext, __FUNCTION__);
+
+    if(pCtx)
+    {
+        _swQueueFlush(pCtx);
+    }
+}
+
+GCUvoid gcuFinish(GCUContext pContext)
+{
+    SW_CONTEXT* pCtx = _swContext(pContext, __FUNCTION__);
+
+    if(pCtx)
+    {
+        _swFinish(pCtx);
+    }
+}
+
+/*
+ * Fences
+ */
+GCUFence gcuCreateFence(GCUContext pContext)
+{
+    SW_CONTEXT* pCtx = _swContext(pContext, __FUNCTION__);
+    SW_FENCE* pFence;
+
+    if(pCtx == GCU_NULL)
+    {
+        return GCU_NULL;
+    }
+    pFence = (SW_FENCE*)calloc(1, sizeof(SW_FENCE));
+    if(pFence == GCU_NULL)
+    {
+        _swSetError(GCU_OUT_OF_MEMORY, __FUNCTION__);
+        return GCU_NULL;
+    }
+    pFence->magic = SW_FENCE_MAGIC;
+    pFence->pContext = pCtx;
+    return pFence;
+}
+
+static SW_FENCE* _swFence(SW_CONTEXT* pCtx, GCUFence pFence, const char* func)
+{
+    SW_FENCE* pF = (SW_FENCE*)pFence;
+
+    if(pF == GCU_NULL || pF->magic != SW_FENCE_MAGIC || pF->pContext != pCtx)
+    {
+        _swSetError(GCU_INVALID_PARAMETER, func);
+        return GCU_NULL;
+    }
+    return pF;
+}
+
+GCUvoid gcuDestroyFence(GCUContext pContext, GCUFence pFence)
+{
+    SW_CONTEXT* pCtx = _swContext(pContext, __FUNCTION__);
+    SW_FENCE* pF;
+
+    if(pCtx == GCU_NULL || (pF = _swFence(pCtx, pFence, __FUNCTION__)) == GCU_NULL)
+    {
+        return;
+    }
+    pF->magic = 0;
+    free(pF);
+}
+
+GCUbool gcuSendFence(GCUContext pContext, GCUFence pFence)
+{
+    SW_CONTEXT* pCtx = _swContext(pContext, __FUNCTION__);
+    SW_FENCE* pF;
+
+    if(pCtx == GCU_NULL || (pF = _swFence(pCtx, pFence, __FUNCTION__)) == GCU_NULL)
+    {
+        return GCU_FALSE;
+    }
+
+    /* the fence signals once every command recorded so far has executed */
+    pF->seq = pCtx->recorded;
+    pF->bSent = GCU_TRUE;
+    return GCU_TRUE;
+}
+
+GCUbool gcuWaitFence(GCUContext pContext, GCUFence pFence, GCUuint wait_time_ms)
+{
+    SW_CONTEXT* pCtx = _swContext(pContext, __FUNCTION__);
+    SW_FENCE* pF;
+
+    if(pCtx == GCU_NULL || (pF = _swFence(pCtx, pFence, __FUNCTION__)) == GCU_NULL)
+    {
+        return GCU_FALSE;
+    }
+    if(!pF->bSent)
+    {
+        _swSetError(GCU_INVALID_OPERATION, __FUNCTION__);
+        return GCU_FALSE;
+    }
+    return _swQueueWait(pCtx, pF->seq, wait_time_ms);
+}
+
+/*
+ * Helpers
+ */
+GCUSurface _gcuCreateBuffer(GCUContext          pContext,
+                            GCUuint             width,
+                            GCUuint             height,
+                            GCU_FORMAT          format,
+                            GCUVirtualAddr*     pVirtAddr,
+                            GCUPhysicalAddr*    pPhysicalAddr)
+{
+    SW_CONTEXT* pCtx = _swContext(pContext, __FUNCTION__);
+    GCU_SURFACE_DATA data;
+    SW_SURFACE* pSurface;
+
+    if(pCtx == GCU_NULL)
+    {
+        return GCU_NULL;
+    }
+    memset(&data, 0, sizeof(data));
+    data.location = GCU_SURFACE_LOCATION_VIDEO;
+    data.dimention = GCU_SURFACE_2D;
+    data.format = format;
+    data.width = width;
+    data.height = height;
+    data.arraySize = 1;
+
+    pSurface = (SW_SURFACE*)_swCreate(pCtx, &data, __FUNCTION__);
+    if(pSurface)
+    {
+        if(pVirtAddr)
+        {
+            *pVirtAddr = pSurface->planes[0].pBase;
+        }
+        if(pPhysicalAddr)
+        {
+            *pPhysicalAddr = pSurface->planes[0].physicalAddr;
+        }
+    }
+    return pSurface;
+}
+
+GCUSurface _gcuCreatePreAllocBufferEx(GCUContext          pContext,
+                                      GCUuint             width,
+                                      GCUuint             height,
+                                      GCU_FORMAT          format,
+                                      GCUbool             bPreAllocVirtual,
+                                      GCUVirtualAddr      virtualAddr,
+                                      GCUbool             bPreAllocPhysical,
+                                      GCUPhysicalAddr     physicalAddr,
+                                      GCUbool             bMappedPhysical)
+{
+    SW_CONTEXT* pCtx = _swContext(pContext, __FUNCTION__);
+    GCU_SURFACE_DATA data;
+    GCU_ALLOC_INFO info;
+
+    if(pCtx == GCU_NULL)
+    {
+        return GCU_NULL;
+    }
+    memset(&info, 0, sizeof(info));
+    info.width = width;
+    info.height = height;
+    info.virtualAddr = virtualAddr;
+    info.physicalAddr = physicalAddr;
+    info.bMappedPhysical = bMappedPhysical;
+
+    memset(&data, 0, sizeof(data));
+    data.location = GCU_SURFACE_LOCATION_VIDEO;
+    data.dimention = GCU_SURFACE_2D;
+    data.flag.bits.preAllocVirtual = bPreAllocVirtual ? 1 : 0;
+    data.flag.bits.preAllocPhysical = bPreAllocPhysical ? 1 : 0;
+    data.format = format;
+    data.width = width;
+    data.height = height;
+    data.arraySize = 1;
+    data.pPreAllocInfos = bPreAllocVirtual ? &info : GCU_NULL;
+    return _swCreate(pCtx, &data, __FUNCTION__);
+}
+
+GCUSurface _gcuCreatePreAllocBuffer(GCUContext          pContext,
+                                    GCUuint             width,
+                                    GCUuint             height,
+                                    GCU_FORMAT          format,
+                                    GCUbool             bPreAllocVirtual,
+                                    GCUVirtualAddr      virtualAddr,
+                                    GCUbool             bPreAllocPhysical,
+                                    GCUPhysicalAddr     physicalAddr)
+{
+    return _gcuCreatePreAllocBufferEx(pContext, width, height, format, bPreAllocVirtual, virtualAddr,
+                                      bPreAllocPhysical, physicalAddr, GCU_FALSE);
+}
+
+GCUbool _gcuUpdatePreAllocBufferEx(GCUContext          pContext,
+                                   GCUSurface          pSurface,
+                                   GCUbool             bPreAllocVirtual,
+                                   GCUVirtualAddr      virtualAddr,
+                                   GCUbool             bPreAllocPhysical,
+                                   GCUPhysicalAddr     physicalAddr,
+                                   GCUbool             bMappedPhysical)
+{
+    SW_CONTEXT* pCtx = _swContext(pContext, __FUNCTION__);
+    SW_SURFACE* pSurf = _swSurface(pSurface, __FUNCTION__);
+    GCU_ALLOC_INFO info;
+
+    if(pCtx == GCU_NULL || pSurf == GCU_NULL)
+    {
+        return GCU_FALSE;
+    }
+    memset(&info, 0, sizeof(info));
+    info.width = pSurf->planes[0].width;
+    info.height = pSurf->planes[0].height;
+    info.virtualAddr = virtualAddr;
+    info.physicalAddr = bPreAllocPhysical ? physicalAddr : 0;
+    info.bMappedPhysical = bMappedPhysical;
+    return _swUpdate(pCtx, pSurf, bPreAllocVirtual ? GCU_TRUE : GCU_FALSE,
+                     bPreAllocPhysical ? GCU_TRUE : GCU_FALSE, &info, 1, __FUNCTION__);
+}
+
+GCUbool _gcuUpdatePreAllocBuffer(GCUContext          pContext,
+                                 GCUSurface          pSurface,
+                                 GCUbool             bPreAllocVirtual,
+                                 GCUVirtualAddr      virtualAddr,
+                                 GCUbool             bPreAllocPhysical,
+                                 GCUPhysicalAddr     physicalAddr)
+{
+    return _gcuUpdatePreAllocBufferEx(pContext, pSurface, bPreAllocVirtual, virtualAddr,
+                                      bPreAllocPhysical, physicalAddr, GCU_FALSE);
+}
+
+GCUvoid _gcuDestroyBuffer(GCUContext pContext, GCUSurface pSurface)
+{
+    gcuDestroySurface(pContext, pSurface);
+}
+
+GCUvoid _gcuFlushCache(GCUContext pContext, GCUVirtualAddr virtualAddr, GCUuint size, GCU_FLUSH_CACHE_OP op)
+{
+    /* the CPU does the rendering: memory is always coherent */
+    (void)virtualAddr;
+    (void)size;
+    (void)op;
+    _swContext(pContext, __FUNCTION__);
+}
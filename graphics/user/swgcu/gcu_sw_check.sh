@@ -0,0 +1,78 @@
+#!/bin/sh
+#
+# Runs the gcu samples built against the software GCU and compares the md5
+# of every surface they dump with a golden list.
+#
+#   gcu_sw_check.sh <sample bin dir> <sample source dir> <golden file> [update]
+#
+
+BIN=$(cd "$1" && pwd)
+SRC=$(cd "$2" && pwd)
+GOLDEN=$(cd "$(dirname "$3")" && pwd)/$(basename "$3")
+WORK=$(mktemp -d)
+
+trap 'rm -rf "$WORK"' EXIT
+
+# keep malloc off mmap so heap pointers fit the samples' 32 bit casts
+GLIBC_TUNABLES=glibc.malloc.mmap_threshold=33554432
+export GLIBC_TUNABLES
+
+# sample and arguments, one run per line
+RUNS="sample_blend_global
+sample_blend_pixel
+sample_blit
+sample_bmm
+sample_cliprect
+sample_compose 0 3 8 -10 11 13 14 16 19
+sample_filter_blit
+sample_flip_rotate
+sample_multi-super-tile 0
+sample_multi-super-tile 2
+sample_multi-tile 0
+sample_multi-tile 2
+sample_multimap
+sample_rotate
+sample_scale
+sample_scale_quality
+sample_sub_rect
+sample_super-tile 0
+sample_super-tile 2
+sample_tile 0
+sample_tile 2
+sample_tile_blend
+sample_tile_fill
+sample_yuv2rgb
+simple_sample"
+
+RESULT="$WORK/result.md5"
+: > "$RESULT"
+FAILED=0
+
+echo "$RUNS" | while read -r NAME ARGS; do
+    RUN="$WORK/$(echo "$NAME $ARGS" | sed 's/ *$//' | tr ' ' '_')"
+    mkdir -p "$RUN"
+    cp "$SRC"/*.bmp "$SRC"/*.yuv "$SRC"/*.uyvy "$RUN"/
+    ( cd "$RUN" && "$BIN/$NAME" $ARGS > log.txt 2>&1 ) || echo "$NAME $ARGS: exit $?" >> "$WORK/errors"
+    ( cd "$RUN" && ls -1 | grep -v '^log.txt$' | sort | while read -r F; do
+        [ -f "$SRC/$F" ] && continue
+        echo "$(md5sum < "$F" | cut -d' ' -f1)  $(basename "$RUN")/$F"
+    done ) >> "$RESULT"
+done
+
+if [ -f "$WORK/errors" ]; then
+    cat "$WORK/errors"
+    FAILED=1
+fi
+
+if [ "$4" = "update" ]; then
+    cp "$RESULT" "$GOLDEN"
+    echo "$(wc -l < "$GOLDEN") dumps written to $GOLDEN"
+    exit $FAILED
+fi
+
+if diff -u "$GOLDEN" "$RESULT"; then
+    echo "$(wc -l < "$RESULT") dumps match"
+else
+    FAILED=1
+fi
+exit $FAILED
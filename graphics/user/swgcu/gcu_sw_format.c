@@ -0,0 +1,475 @@
+/***********************************************************************************
+ *
+ *    Copyright (c) 2009 - 2013 by Marvell International Ltd. and its affiliates.
+ *    All rights reserved.
+ *
+ *    This software file (the "File") is owned and distributed by Marvell
+ *    International Ltd. and/or its affiliates ("Marvell") under Marvell Commercial
+ *    License.
+ *
+ *    If you received this File from Marvell and you have entered into a commercial
+ *    license agreement (a "Commercial License") with Marvell, the File is licensed
+ *    to you under the terms of the applicable Commercial License.
+ *
+ *
+ ***********************************************************************************/
+
+/*!
+ ******************************************************************************
+ *  \file gcu_sw_format.c
+ *  \brief
+ *      Pixel formats of the software GCU: rows of any surface format to and
+ *      from 32 bit ARGB, YUV conversion and dithering.
+ ******************************************************************************/
+
+#include <string.h>
+
+#include "gcu_sw.h"
+
+/*
+ * Channel layouts follow the format names, most significant channel first
+ * in the pixel word: GCU_FORMAT_ABGR8888 is R, G, B, A in memory.
+ */
+static const SW_FORMAT_INFO s_formats[] = {
+/*    format                 name        bpp pl h  v  YUV alpha  a       r        g        b        xMask       y0 y1 u  v  VFirst */
+    { GCU_FORMAT_ARGB8888,  "ARGB8888",  4,  1, 0, 0, 0, 1,      8, 24,  8, 16,   8,  8,   8,  0,   0,          0, 0, 0, 0, 0 },
+    { GCU_FORMAT_XRGB8888,  "XRGB8888",  4,  1, 0, 0, 0, 0,      0,  0,  8, 16,   8,  8,   8,  0,   0xff000000, 0, 0, 0, 0, 0 },
+    { GCU_FORMAT_ARGB1555,  "ARGB1555",  2,  1, 0, 0, 0, 1,      1, 15,  5, 10,   5,  5,   5,  0,   0,          0, 0, 0, 0, 0 },
+    { GCU_FORMAT_XRGB1555,  "XRGB1555",  2,  1, 0, 0, 0, 0,      0,  0,  5, 10,   5,  5,   5,  0,   0x8000,     0, 0, 0, 0, 0 },
+    { GCU_FORMAT_RGB565,    "RGB565",    2,  1, 0, 0, 0, 0,      0,  0,  5, 11,   6,  5,   5,  0,   0,          0, 0, 0, 0, 0 },
+    { GCU_FORMAT_ARGB4444,  "ARGB4444",  2,  1, 0, 0, 0, 1,      4, 12,  4,  8,   4,  4,   4,  0,   0,          0, 0, 0, 0, 0 },
+    { GCU_FORMAT_XRGB4444,  "XRGB4444",  2,  1, 0, 0, 0, 0,      0,  0,  4,  8,   4,  4,   4,  0,   0xf000,     0, 0, 0, 0, 0 },
+    { GCU_FORMAT_RGBA8888,  "RGBA8888",  4,  1, 0, 0, 0, 1,      8,  0,  8, 24,   8, 16,   8,  8,   0,          0, 0, 0, 0, 0 },
+    { GCU_FORMAT_ABGR8888,  "ABGR8888",  4,  1, 0, 0, 0, 1,      8, 24,  8,  0,   8,  8,   8, 16,   0,          0, 0, 0, 0, 0 },
+    { GCU_FORMAT_BGRA8888,  "BGRA8888",  4,  1, 0, 0, 0, 1,      8,  0,  8,  8,   8, 16,   8, 24,   0,          0, 0, 0, 0, 0 },
+    { GCU_FORMAT_XBGR8888,  "XBGR8888",  4,  1, 0, 0, 0, 0,      0,  0,  8,  0,   8,  8,   8, 16,   0xff000000, 0, 0, 0, 0, 0 },
+    { GCU_FORMAT_ABGR1555,  "ABGR1555",  2,  1, 0, 0, 0, 1,      1, 15,  5,  0,   5,  5,   5, 10,   0,          0, 0, 0, 0, 0 },
+    { GCU_FORMAT_XBGR1555,  "XBGR1555",  2,  1, 0, 0, 0, 0,      0,  0,  5,  0,   5,  5,   5, 10,   0x8000,     0, 0, 0, 0, 0 },
+    { GCU_FORMAT_ABGR4444,  "ABGR4444",  2,  1, 0, 0, 0, 1,      4, 12,  4,  0,   4,  4,   4,  8,   0,          0, 0, 0, 0, 0 },
+    { GCU_FORMAT_XBGR4444,  "XBGR4444",  2,  1, 0, 0, 0, 0,      0,  0,  4,  0,   4,  4,   4,  8,   0xf000,     0, 0, 0, 0, 0 },
+    { GCU_FORMAT_RGBA5551,  "RGBA5551",  2,  1, 0, 0, 0, 1,      1,  0,  5, 11,   5,  6,   5,  1,   0,          0, 0, 0, 0, 0 },
+    { GCU_FORMAT_RGBA4444,  "RGBA4444",  2,  1, 0, 0, 0, 1,      4,  0,  4, 12,   4,  8,   4,  4,   0,          0, 0, 0, 0, 0 },
+    { GCU_FORMAT_A8,        "A8",        1,  1, 0, 0, 0, 1,      8,  0,  0,  0,   0,  0,   0,  0,   0,          0, 0, 0, 0, 0 },
+    { GCU_FORMAT_RG16,      "RG16",      2,  1, 0, 0, 0, 0,      0,  0,  8,  8,   8,  0,   0,  0,   0,          0, 0, 0, 0, 0 },
+    { GCU_FORMAT_UYVY,      "UYVY",      2,  1, 1, 0, 1, 0,      0,  0,  0,  0,   0,  0,   0,  0,   0,          1, 3, 0, 2, 0 },
+    { GCU_FORMAT_YUY2,      "YUY2",      2,  1, 1, 0, 1, 0,      0,  0,  0,  0,   0,  0,   0,  0,   0,          0, 2, 1, 3, 0 },
+    { GCU_FORMAT_YV12,      "YV12",      1,  3, 1, 1, 1, 0,      0,  0,  0,  0,   0,  0,   0,  0,   0,          0, 0, 0, 0, 1 },
+    { GCU_FORMAT_NV12,      "NV12",      1,  2, 1, 1, 1, 0,      0,  0,  0,  0,   0,  0,   0,  0,   0,          0, 0, 0, 0, 0 },
+    { GCU_FORMAT_I420,      "I420",      1,  3, 1, 1, 1, 0,      0,  0,  0,  0,   0,  0,   0,  0,   0,          0, 0, 0, 0, 0 },
+    { GCU_FORMAT_NV16,      "NV16",      1,  2, 1, 0, 1, 0,      0,  0,  0,  0,   0,  0,   0,  0,   0,          0, 0, 0, 0, 0 },
+    { GCU_FORMAT_NV21,      "NV21",      1,  2, 1, 1, 1, 0,      0,  0,  0,  0,   0,  0,   0,  0,   0,          0, 0, 0, 0, 1 },
+    { GCU_FORMAT_NV61,      "NV61",      1,  2, 1, 0, 1, 0,      0,  0,  0,  0,   0,  0,   0,  0,   0,          0, 0, 0, 0, 1 },
+};
+
+/* 4x4 ordered dither thresholds */
+static const unsigned char s_bayer[4][4] = {
+    {  0,  8,  2, 10 },
+    { 12,  4, 14,  6 },
+    {  3, 11,  1,  9 },
+    { 15,  7, 13,  5 },
+};
+
+const SW_FORMAT_INFO* _swGetFormatInfo(GCU_FORMAT format)
+{
+    GCUuint i;
+
+    for(i = 0; i < sizeof(s_formats) / sizeof(s_formats[0]); i++)
+    {
+        if(s_formats[i].format == format)
+        {
+            return &s_formats[i];
+        }
+    }
+    return GCU_NULL;
+}
+
+static inline GCUuint _swClamp255(GCUint v)
+{
+    return v < 0 ? 0 : (v > 255 ? 255 : (GCUuint)v);
+}
+
+/* BT.601, video range */
+uint32_t _swYUVToARGB(GCUint y, GCUint u, GCUint v)
+{
+    GCUint c = 298 * (y - 16);
+    GCUint d = u - 128;
+    GCUint e = v - 128;
+    GCUuint r = _swClamp255((c + 409 * e + 128) >> 8);
+    GCUuint g = _swClamp255((c - 100 * d - 208 * e + 128) >> 8);
+    GCUuint b = _swClamp255((c + 516 * d + 128) >> 8);
+
+    return 0xff000000 | (r << 16) | (g << 8) | b;
+}
+
+void _swARGBToYUV(uint32_t argb, GCUint* pY, GCUint* pU, GCUint* pV)
+{
+    GCUint r = (argb >> 16) & 0xff;
+    GCUint g = (argb >> 8) & 0xff;
+    GCUint b = argb & 0xff;
+
+    *pY = ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16;
+    *pU = ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128;
+    *pV = ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128;
+}
+
+static inline GCUuint _swExpand(GCUuint value, GCUuint bits, GCUuint shift, GCUuint missing)
+{
+    GCUuint c;
+
+    if(bits == 0)
+    {
+        return missing;
+    }
+    c = (value >> shift) & ((1u << bits) - 1);
+    switch(bits)
+    {
+    case 8:  return c;
+    case 6:  return (c << 2) | (c >> 4);
+    case 5:  return (c << 3) | (c >> 2);
+    case 4:  return c * 17;
+    case 1:  return c ? 255 : 0;
+    default: return c * 255 / ((1u << bits) - 1);
+    }
+}
+
+static inline uint32_t _swUnpack(const SW_FORMAT_INFO* pInfo, GCUuint value)
+{
+    return (_swExpand(value, pInfo->aBits, pInfo->aShift, 255) << 24) |
+           (_swExpand(value, pInfo->rBits, pInfo->rShift, 0) << 16) |
+           (_swExpand(value, pInfo->gBits, pInfo->gShift, 0) << 8) |
+            _swExpand(value, pInfo->bBits, pInfo->bShift, 0);
+}
+
+static inline GCUuint _swPackChannel(GCUuint c, GCUuint bits, GCUuint shift, GCUuint threshold)
+{
+    if(bits == 0)
+    {
+        return 0;
+    }
+    if(bits < 8 && threshold)
+    {
+        c += (threshold << (8 - bits)) >> 4;
+        if(c > 255)
+        {
+            c = 255;
+        }
+    }
+    return (c >> (8 - bits)) << shift;
+}
+
+static inline GCUuint _swPack(const SW_FORMAT_INFO* pInfo, uint32_t argb, GCUuint threshold)
+{
+    return pInfo->xMask |
+           _swPackChannel(argb >> 24, pInfo->aBits, pInfo->aShift, 0) |
+           _swPackChannel((argb >> 16) & 0xff, pInfo->rBits, pInfo->rShift, threshold) |
+           _swPackChannel((argb >> 8) & 0xff, pInfo->gBits, pInfo->gShift, threshold) |
+           _swPackChannel(argb & 0xff, pInfo->bBits, pInfo->bShift, threshold);
+}
+
+static inline unsigned char* _swPixel(const SW_SURFACE* pSurface, GCUuint x, GCUuint y)
+{
+    const SW_PLANE* pPlane = &pSurface->planes[0];
+
+    if(pSurface->tileType == GCU_LINEAR)
+    {
+        return pPlane->pBase + y * pPlane->stride + x * pSurface->pInfo->bpp;
+    }
+    return pPlane->pBase + _swTileOffset(pSurface, x, y);
+}
+
+static inline GCUuint _swRead(const unsigned char* p, GCUuint bpp)
+{
+    switch(bpp)
+    {
+    case 4:  return *(const uint32_t*)p;
+    case 2:  return *(const uint16_t*)p;
+    default: return *p;
+    }
+}
+
+static inline void _swWrite(unsigned char* p, GCUuint bpp, GCUuint value)
+{
+    switch(bpp)
+    {
+    case 4:  *(uint32_t*)p = value; break;
+    case 2:  *(uint16_t*)p = (uint16_t)value; break;
+    default: *p = (unsigned char)value; break;
+    }
+}
+
+/* chroma sample (u, v) of plane 1 or 2 at chroma position (cx, cy) */
+static inline void _swChromaAddr(const SW_SURFACE* pSurface, GCUuint cx, GCUuint cy,
+                                 unsigned char** ppU, unsigned char** ppV)
+{
+    const SW_FORMAT_INFO* pInfo = pSurface->pInfo;
+    const SW_PLANE* p1 = &pSurface->planes[1];
+
+    if(pInfo->planes == 3)
+    {
+        const SW_PLANE* p2 = &pSurface->planes[2];
+        unsigned char* a = p1->pBase + cy * p1->stride + cx;
+        unsigned char* b = p2->pBase + cy * p2->stride + cx;
+
+        *ppU = pInfo->bVFirst ? b : a;
+        *ppV = pInfo->bVFirst ? a : b;
+    }
+    else
+    {
+        unsigned char* a = p1->pBase + cy * p1->stride + cx * 2;
+
+        *ppU = pInfo->bVFirst ? a + 1 : a;
+        *ppV = pInfo->bVFirst ? a : a + 1;
+    }
+}
+
+void _swFetchRow(const SW_SURFACE* pSurface, GCUint x, GCUint y, GCUint count, uint32_t* pOut)
+{
+    const SW_FORMAT_INFO* pInfo = pSurface->pInfo;
+    GCUint i;
+
+    if(pInfo->bYUV && pInfo->planes == 1)
+    {
+        for(i = 0; i < count; i++)
+        {
+            GCUuint px = x + i;
+            const unsigned char* g = _swPixel(pSurface, px & ~1u, y);
+
+            pOut[i] = _swYUVToARGB(g[(px & 1) ? pInfo->y1 : pInfo->y0], g[pInfo->u], g[pInfo->v]);
+        }
+    }
+    else if(pInfo->bYUV)
+    {
+        const unsigned char* pY = pSurface->planes[0].pBase + y * pSurface->planes[0].stride;
+        GCUuint cy = y >> pInfo->vShift;
+
+        for(i = 0; i < count; i++)
+        {
+            GCUuint px = x + i;
+            unsigned char *pU, *pV;
+
+            _swChromaAddr(pSurface, px >> pInfo->hShift, cy, &pU, &pV);
+            pOut[i] = _swYUVToARGB(pY[px], *pU, *pV);
+        }
+    }
+    else if(pSurface->tileType == GCU_LINEAR)
+    {
+        const unsigned char* p = _swPixel(pSurface, x, y);
+
+        if(pInfo->format == GCU_FORMAT_ARGB8888)
+        {
+            memcpy(pOut, p, count * 4);
+        }
+        else if(pInfo->format == GCU_FORMAT_XRGB8888)
+        {
+            const uint32_t* s = (const uint32_t*)p;
+
+            for(i = 0; i < count; i++)
+            {
+                pOut[i] = s[i] | 0xff000000;
+            }
+        }
+        else if(pInfo->format == GCU_FORMAT_RGB565)
+        {
+            const uint16_t* s = (const uint16_t*)p;
+
+            for(i = 0; i < count; i++)
+            {
+                GCUuint v = s[i];
+                GCUuint r = v >> 11, g = (v >> 5) & 0x3f, b = v & 0x1f;
+
+                pOut[i] = 0xff000000 | (((r << 3) | (r >> 2)) << 16) |
+                          (((g << 2) | (g >> 4)) << 8) | ((b << 3) | (b >> 2));
+            }
+        }
+        else
+        {
+            for(i = 0; i < count; i++, p += pInfo->bpp)
+            {
+                pOut[i] = _swUnpack(pInfo, _swRead(p, pInfo->bpp));
+            }
+        }
+    }
+    else
+    {
+        for(i = 0; i < count; i++)
+        {
+            pOut[i] = _swUnpack(pInfo, _swRead(_swPixel(pSurface, x + i, y), pInfo->bpp));
+        }
+    }
+}
+
+static void _swStoreRGB(SW_SURFACE* pSurface, GCUint x, GCUint y, GCUint count,
+                        const uint32_t* pIn, GCUbool bDither)
+{
+    const SW_FORMAT_INFO* pInfo = pSurface->pInfo;
+    const unsigned char* pBayer = s_bayer[y & 3];
+    GCUint i;
+
+    bDither = bDither && pInfo->bpp == 2 && pInfo->format != GCU_FORMAT_RG16;
+
+    if(pSurface->tileType == GCU_LINEAR && !bDither)
+    {
+        unsigned char* p = _swPixel(pSurface, x, y);
+
+        if(pInfo->format == GCU_FORMAT_ARGB8888)
+        {
+            memcpy(p, pIn, count * 4);
+            return;
+        }
+        if(pInfo->format == GCU_FORMAT_RGB565)
+        {
+            uint16_t* d = (uint16_t*)p;
+
+            for(i = 0; i < count; i++)
+            {
+                uint32_t c = pIn[i];
+
+                d[i] = (uint16_t)(((c >> 8) & 0xf800) | ((c >> 5) & 0x07e0) | ((c >> 3) & 0x001f));
+            }
+            return;
+        }
+        for(i = 0; i < count; i++, p += pInfo->bpp)
+        {
+            _swWrite(p, pInfo->bpp, _swPack(pInfo, pIn[i], 0));
+        }
+        return;
+    }
+
+    for(i = 0; i < count; i++)
+    {
+        GCUuint px = x + i;
+
+        _swWrite(_swPixel(pSurface, px, y), pInfo->bpp,
+                 _swPack(pInfo, pIn[i], bDither ? pBayer[px & 3] : 0));
+    }
+}
+
+static void _swStorePackedYUV(SW_SURFACE* pSurface, GCUint x, GCUint y, GCUint count, const uint32_t* pIn)
+{
+    const SW_FORMAT_INFO* pInfo = pSurface->pInfo;
+    GCUint end = x + count, px;
+
+    for(px = x & ~1; px < end; px += 2)
+    {
+        unsigned char* g = _swPixel(pSurface, px, y);
+        GCUint y0, u0, v0, y1, u1, v1;
+        GCUbool b0 = px >= x, b1 = px + 1 < end;
+
+        if(b0)
+        {
+            _swARGBToYUV(pIn[px - x], &y0, &u0, &v0);
+            g[pInfo->y0] = (unsigned char)y0;
+        }
+        if(b1)
+        {
+            _swARGBToYUV(pIn[px + 1 - x], &y1, &u1, &v1);
+            g[pInfo->y1] = (unsigned char)y1;
+        }
+        if(b0 && b1)
+        {
+            g[pInfo->u] = (unsigned char)((u0 + u1 + 1) >> 1);
+            g[pInfo->v] = (unsigned char)((v0 + v1 + 1) >> 1);
+        }
+        else
+        {
+            g[pInfo->u] = (unsigned char)(b0 ? u0 : u1);
+            g[pInfo->v] = (unsigned char)(b0 ? v0 : v1);
+        }
+    }
+}
+
+/*
+ * Planar and semi-planar YUV. All rows sharing a chroma row should come in
+ * the same call, the chroma is the average of the pixels written.
+ */
+static void _swStorePlanarYUV(SW_SURFACE* pSurface, GCUint x, GCUint y, GCUint count,
+                              GCUint rows, const uint32_t* const* ppIn)
+{
+    const SW_FORMAT_INFO* pInfo = pSurface->pInfo;
+    SW_PLANE* p0 = &pSurface->planes[0];
+    GCUint r, i, cy, cx;
+    GCUint cx0 = x >> pInfo->hShift;
+    GCUint cx1 = (x + count - 1) >> pInfo->hShift;
+
+    for(r = 0; r < rows; r++)
+    {
+        unsigned char* pY = p0->pBase + (y + r) * p0->stride;
+        GCUint yy, u, v;
+
+        if(ppIn[r] == GCU_NULL)
+        {
+            continue;
+        }
+        for(i = 0; i < count; i++)
+        {
+            _swARGBToYUV(ppIn[r][i], &yy, &u, &v);
+            pY[x + i] = (unsigned char)yy;
+        }
+    }
+
+    for(cy = y >> pInfo->vShift; cy <= (GCUuint)(y + rows - 1) >> pInfo->vShift; cy++)
+    {
+        for(cx = cx0; cx <= cx1; cx++)
+        {
+            GCUint su = 0, sv = 0, n = 0, yy, u, v, px, py;
+            unsigned char *pU, *pV;
+
+            for(py = cy << pInfo->vShift; py < (GCUint)((cy + 1) << pInfo->vShift); py++)
+            {
+                if(py < y || py >= y + rows || ppIn[py - y] == GCU_NULL)
+                {
+                    continue;
+                }
+                for(px = cx << pInfo->hShift; px < (GCUint)((cx + 1) << pInfo->hShift); px++)
+                {
+                    if(px < x || px >= x + count)
+                    {
+                        continue;
+                    }
+                    _swARGBToYUV(ppIn[py - y][px - x], &yy, &u, &v);
+                    su += u;
+                    sv += v;
+                    n++;
+                }
+            }
+            if(n)
+            {
+                _swChromaAddr(pSurface, cx, cy, &pU, &pV);
+                *pU = (unsigned char)((su + n / 2) / n);
+                *pV = (unsigned char)((sv + n / 2) / n);
+            }
+        }
+    }
+}
+
+void _swStoreRows(SW_SURFACE* pSurface, GCUint x, GCUint y, GCUint count,
+                  GCUint rows, const uint32_t* const* ppIn, GCUbool bDither)
+{
+    const SW_FORMAT_INFO* pInfo = pSurface->pInfo;
+    GCUint r;
+
+    if(count <= 0)
+    {
+        return;
+    }
+    if(pInfo->bYUV && pInfo->planes > 1)
+    {
+        _swStorePlanarYUV(pSurface, x, y, count, rows, ppIn);
+        return;
+    }
+    for(r = 0; r < rows; r++)
+    {
+        if(ppIn[r] == GCU_NULL)
+        {
+            continue;
+        }
+        if(pInfo->bYUV)
+        {
+            _swStorePackedYUV(pSurface, x, y + r, count, ppIn[r]);
+        }
+        else
+        {
+            _swStoreRGB(pSurface, x, y + r, count, ppIn[r], bDither);
+        }
+    }
+}
@@ -0,0 +1,345 @@
+/***********************************************************************************
+ *
+ *    Copyright (c) 2009 - 2013 by Marvell International Ltd. and its affiliates.
+ *    All rights reserved.
+ *
+ *    This software file (the "File") is owned and distributed by Marvell
+ *    International Ltd. and/or its affiliates ("Marvell") under Marvell Commercial
+ *    License.
+ *
+ *    If you received this File from Marvell and you have entered into a commercial
+ *    license agreement (a "Commercial License") with Marvell, the File is licensed
+ *    to you under the terms of the applicable Commercial License.
+ *
+ *
+ ***********************************************************************************/
+
+/*!
+ ******************************************************************************
+ *  \file gcu_sw_queue.c
+ *  \brief
+ *      Deferred execution of the software GCU. Rendering calls record a
+ *      command in the context queue; gcuFlush hands the recorded commands to
+ *      the context drain thread, which stands in for the GPU front end. The
+ *      drain thread splits each command in bands of rows and runs them on a
+ *      worker pool shared by all contexts.
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "gcu_sw.h"
+
+/*
+ * Worker pool
+ */
+typedef struct _SW_POOL{
+    pthread_mutex_t     runLock;        /* one job at a time       */
+    pthread_mutex_t     lock;
+    pthread_cond_t      startCond;
+    pthread_cond_t      doneCond;
+    pthread_t           threads[SW_MAX_THREADS];
+    GCUuint             workerCount;    /* threads besides the caller */
+    GCUuint             generation;     /* bumped for every job       */
+    GCUuint             busy;           /* workers still in the job   */
+    GCUbool             bQuit;
+
+    SW_JOB_FUNC         func;
+    void*               pArg;
+    GCUuint             bandCount;
+    volatile GCUuint    nextBand;
+}SW_POOL;
+
+static SW_POOL s_pool = {
+    PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER,
+    PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER,
+};
+
+static void _swPoolBands(void)
+{
+    GCUuint band;
+
+    while((band = __sync_fetch_and_add(&s_pool.nextBand, 1)) < s_pool.bandCount)
+    {
+        s_pool.func(s_pool.pArg, band);
+    }
+}
+
+static void* _swPoolWorker(void* pArg)
+{
+    GCUuint seen = 0;
+
+    (void)pArg;
+    pthread_mutex_lock(&s_pool.lock);
+    for(;;)
+    {
+        while(!s_pool.bQuit && s_pool.generation == seen)
+        {
+            pthread_cond_wait(&s_pool.startCond, &s_pool.lock);
+        }
+        if(s_pool.bQuit)
+        {
+            break;
+        }
+        seen = s_pool.generation;
+        pthread_mutex_unlock(&s_pool.lock);
+
+        _swPoolBands();
+
+        pthread_mutex_lock(&s_pool.lock);
+        if(--s_pool.busy == 0)
+        {
+            pthread_cond_signal(&s_pool.doneCond);
+        }
+    }
+    pthread_mutex_unlock(&s_pool.lock);
+    return GCU_NULL;
+}
+
+GCUbool _swPoolStart(void)
+{
+    const char* pEnv = getenv("GCU_SW_THREADS");
+    long threads = pEnv ? strtol(pEnv, GCU_NULL, 10) : sysconf(_SC_NPROCESSORS_ONLN);
+    GCUuint i;
+
+    threads = threads < 1 ? 1 : (threads > SW_MAX_THREADS ? SW_MAX_THREADS : threads);
+
+    s_pool.bQuit = GCU_FALSE;
+    s_pool.workerCount = 0;
+    for(i = 0; i + 1 < (GCUuint)threads; i++)
+    {
+        if(pthread_create(&s_pool.threads[i], GCU_NULL, _swPoolWorker, GCU_NULL) != 0)
+        {
+            break;
+        }
+        s_pool.workerCount++;
+    }
+    return GCU_TRUE;
+}
+
+void _swPoolStop(void)
+{
+    GCUuint i;
+
+    pthread_mutex_lock(&s_pool.lock);
+    s_pool.bQuit = GCU_TRUE;
+    pthread_cond_broadcast(&s_pool.startCond);
+    pthread_mutex_unlock(&s_pool.lock);
+
+    for(i = 0; i < s_pool.workerCount; i++)
+    {
+        pthread_join(s_pool.threads[i], GCU_NULL);
+    }
+    s_pool.workerCount = 0;
+}
+
+GCUuint _swPoolThreads(void)
+{
+    return s_pool.workerCount + 1;
+}
+
+void _swPoolRun(SW_JOB_FUNC func, void* pArg, GCUuint bandCount)
+{
+    GCUuint i;
+
+    if(bandCount == 0)
+    {
+        return;
+    }
+    if(bandCount == 1 || s_pool.workerCount == 0)
+    {
+        for(i = 0; i < bandCount; i++)
+        {
+            func(pArg, i);
+        }
+        return;
+    }
+
+    pthread_mutex_lock(&s_pool.runLock);
+
+    pthread_mutex_lock(&s_pool.lock);
+    s_pool.func = func;
+    s_pool.pArg = pArg;
+    s_pool.bandCount = bandCount;
+    s_pool.nextBand = 0;
+    s_pool.busy = s_pool.workerCount;
+    s_pool.generation++;
+    pthread_cond_broadcast(&s_pool.startCond);
+    pthread_mutex_unlock(&s_pool.lock);
+
+    /* the caller takes bands too */
+    _swPoolBands();
+
+    pthread_mutex_lock(&s_pool.lock);
+    while(s_pool.busy)
+    {
+        pthread_cond_wait(&s_pool.doneCond, &s_pool.lock);
+    }
+    pthread_mutex_unlock(&s_pool.lock);
+
+    pthread_mutex_unlock(&s_pool.runLock);
+}
+
+/*
+ * Context queue
+ */
+static void _swFreeCommand(SW_COMMAND* pCommand)
+{
+    if(pCommand->pLayers != &pCommand->layer)
+    {
+        free(pCommand->pLayers);
+    }
+    free(pCommand);
+}
+
+static void* _swDrainThread(void* pArg)
+{
+    SW_CONTEXT* pContext = (SW_CONTEXT*)pArg;
+
+    pthread_mutex_lock(&pContext->lock);
+    for(;;)
+    {
+        SW_COMMAND* pCommand;
+
+        while(!pContext->bQuit && pContext->completed == pContext->submitted)
+        {
+            pthread_cond_wait(&pContext->workCond, &pContext->lock);
+        }
+        if(pContext->completed == pContext->submitted)
+        {
+            break;
+        }
+
+        pCommand = pContext->pHead;
+        pContext->pHead = pCommand->pNext;
+        if(pContext->pHead == GCU_NULL)
+        {
+            pContext->pTail = GCU_NULL;
+        }
+        pthread_mutex_unlock(&pContext->lock);
+
+        _swExecute(pCommand);
+        _swFreeCommand(pCommand);
+
+        pthread_mutex_lock(&pContext->lock);
+        pContext->completed++;
+        pthread_cond_broadcast(&pContext->doneCond);
+    }
+    pthread_mutex_unlock(&pContext->lock);
+    return GCU_NULL;
+}
+
+GCUbool _swQueueStart(SW_CONTEXT* pContext)
+{
+    pthread_mutex_init(&pContext->lock, GCU_NULL);
+    pthread_cond_init(&pContext->workCond, GCU_NULL);
+    pthread_cond_init(&pContext->doneCond, GCU_NULL);
+    pContext->pHead = pContext->pTail = GCU_NULL;
+    pContext->recorded = pContext->submitted = pContext->completed = 0;
+    pContext->bQuit = GCU_FALSE;
+
+    pContext->bThread = pthread_create(&pContext->thread, GCU_NULL, _swDrainThread, pContext) == 0;
+    if(!pContext->bThread)
+    {
+        pthread_cond_destroy(&pContext->doneCond);
+        pthread_cond_destroy(&pContext->workCond);
+        pthread_mutex_destroy(&pContext->lock);
+    }
+    return pContext->bThread;
+}
+
+void _swQueueStop(SW_CONTEXT* pContext)
+{
+    /* everything recorded is executed before the drain thread leaves */
+    pthread_mutex_lock(&pContext->lock);
+    pContext->submitted = pContext->recorded;
+    pContext->bQuit = GCU_TRUE;
+    pthread_cond_signal(&pContext->workCond);
+    pthread_mutex_unlock(&pContext->lock);
+
+    if(pContext->bThread)
+    {
+        pthread_join(pContext->thread, GCU_NULL);
+        pContext->bThread = GCU_FALSE;
+    }
+    pthread_cond_destroy(&pContext->doneCond);
+    pthread_cond_destroy(&pContext->workCond);
+    pthread_mutex_destroy(&pContext->lock);
+}
+
+void _swQueueRecord(SW_CONTEXT* pContext, SW_COMMAND* pCommand)
+{
+    pCommand->pNext = GCU_NULL;
+
+    pthread_mutex_lock(&pContext->lock);
+    if(pContext->pTail)
+    {
+        pContext->pTail->pNext = pCommand;
+    }
+    else
+    {
+        pContext->pHead = pCommand;
+    }
+    pContext->pTail = pCommand;
+    pContext->recorded++;
+
+    /* bound the memory held by an application that never flushes */
+    if(pContext->recorded - pContext->submitted >= SW_AUTO_FLUSH)
+    {
+        pContext->submitted = pContext->recorded;
+        pthread_cond_signal(&pContext->workCond);
+    }
+    pthread_mutex_unlock(&pContext->lock);
+}
+
+void _swQueueFlush(SW_CONTEXT* pContext)
+{
+    pthread_mutex_lock(&pContext->lock);
+    if(pContext->submitted != pContext->recorded)
+    {
+        pContext->submitted = pContext->recorded;
+        pthread_cond_signal(&pContext->workCond);
+    }
+    pthread_mutex_unlock(&pContext->lock);
+}
+
+GCUbool _swQueueWait(SW_CONTEXT* pContext, uint64_t seq, GCUuint timeoutMs)
+{
+    struct timespec deadline;
+    GCUbool bDone;
+
+    if(timeoutMs != GCU_INFINITE)
+    {
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += timeoutMs / 1000;
+        deadline.tv_nsec += (long)(timeoutMs % 1000) * 1000000;
+        if(deadline.tv_nsec >= 1000000000)
+        {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
+        }
+    }
+
+    pthread_mutex_lock(&pContext->lock);
+    if(pContext->submitted < seq)
+    {
+        pContext->submitted = pContext->recorded;
+        pthread_cond_signal(&pContext->workCond);
+    }
+    while(pContext->completed < seq)
+    {
+        if(timeoutMs == GCU_INFINITE)
+        {
+            pthread_cond_wait(&pContext->doneCond, &pContext->lock);
+        }
+        else if(pthread_cond_timedwait(&pContext->doneCond, &pContext->lock, &deadline) == ETIMEDOUT)
+        {
+            break;
+        }
+    }
+    bDone = pContext->completed >= seq;
+    pthread_mutex_unlock(&pContext->lock);
+    return bDone;
+}
@@ -0,0 +1,755 @@
+/***********************************************************************************
+ *
+ *    Copyright (c) 2009 - 2013 by Marvell International Ltd. and its affiliates.
+ *    All rights reserved.
+ *
+ *    This software file (the "File") is owned and distributed by Marvell
+ *    International Ltd. and/or its affiliates ("Marvell") under Marvell Commercial
+ *    License.
+ *
+ *    If you received this File from Marvell and you have entered into a commercial
+ *    license agreement (a "Commercial License") with Marvell, the File is licensed
+ *    to you under the terms of the applicable Commercial License.
+ *
+ *
+ ***********************************************************************************/
+
+/*!
+ ******************************************************************************
+ *  \file gcu_sw_render.c
+ *  \brief
+ *      Execution of queued commands. A command runs in two passes over the
+ *      worker pool: the source rectangles are converted to 32 bit ARGB, then
+ *      the destination is produced in bands of rows, each row sampled (with
+ *      rotation and scaling), combined with the destination and stored.
+ *
+ *      Every pixel depends only on the inputs and its own position, so the
+ *      output is the same whatever the number of threads.
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "gcu_sw.h"
+
+/* a layer ready to sample */
+typedef struct _SW_SOURCE{
+    const SW_LAYER*     pLayer;
+    SW_IMAGE            image;          /* the source rectangle, (0, 0) at its top left */
+    GCUint              sw, sh;         /* source rectangle size                         */
+    GCUint              rw, rh;         /* source size once rotated                      */
+    GCUint              dw, dh;         /* destination rectangle size                    */
+}SW_SOURCE;
+
+typedef struct _SW_JOB{
+    SW_COMMAND*         pCommand;
+    SW_SOURCE*          pSources;
+    GCU_RECT            region;         /* destination rows and columns touched */
+    GCUint              groupRows;      /* rows stored together, 2 for 4:2:0    */
+    GCUint              filter[SW_FILTER_TAPS];
+    GCUint              filterDir;      /* 0 horizontal, 1 vertical             */
+    SW_IMAGE*           pFilterIn;
+    SW_IMAGE*           pFilterOut;
+}SW_JOB;
+
+/* 9 tap binomial kernel of GCU_BLUR_FILTER, in SW_FILTER_SHIFT fixed point */
+static const GCUint s_blur[SW_FILTER_TAPS] = { 16, 128, 448, 896, 1120, 896, 448, 128, 16 };
+
+static inline GCUint _swClampInt(GCUint v, GCUint lo, GCUint hi)
+{
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+static GCUbool _swImageAlloc(SW_IMAGE* pImage, GCUint width, GCUint height)
+{
+    pImage->pOwned = malloc((size_t)width * height * 4 + 16);
+    pImage->pPixels = (uint32_t*)pImage->pOwned;
+    pImage->stride = width;
+    pImage->width = width;
+    pImage->height = height;
+    return pImage->pOwned != GCU_NULL;
+}
+
+static void _swImageFree(SW_IMAGE* pImage)
+{
+    free(pImage->pOwned);
+    pImage->pOwned = GCU_NULL;
+    pImage->pPixels = GCU_NULL;
+}
+
+/*
+ * Pass 1: sources to ARGB
+ */
+static void _swConvertBand(void* pArg, GCUuint band)
+{
+    SW_SOURCE* pSource = (SW_SOURCE*)pArg;
+    const SW_LAYER* pLayer = pSource->pLayer;
+    GCUint r = band * SW_BAND_ROWS;
+    GCUint end = SW_MIN(r + SW_BAND_ROWS, pSource->sh);
+
+    for(; r < end; r++)
+    {
+        _swFetchRow(pLayer->pSrc, pLayer->srcRect.left, pLayer->srcRect.top + r, pSource->sw,
+                    pSource->image.pPixels + r * pSource->image.stride);
+    }
+}
+
+static GCUbool _swPrepareSource(SW_SOURCE* pSource, const SW_LAYER* pLayer)
+{
+    const SW_SURFACE* pSrc = pLayer->pSrc;
+
+    pSource->pLayer = pLayer;
+    pSource->sw = pLayer->srcRect.right - pLayer->srcRect.left;
+    pSource->sh = pLayer->srcRect.bottom - pLayer->srcRect.top;
+    pSource->rw = (pLayer->rotation & GCU_ROTATION_90) ? pSource->sh : pSource->sw;
+    pSource->rh = (pLayer->rotation & GCU_ROTATION_90) ? pSource->sw : pSource->sh;
+    pSource->dw = pLayer->dstRect.right - pLayer->dstRect.left;
+    pSource->dh = pLayer->dstRect.bottom - pLayer->dstRect.top;
+    memset(&pSource->image, 0, sizeof(pSource->image));
+
+    /* linear ARGB8888 is sampled in place */
+    if(pSrc->pInfo->format == GCU_FORMAT_ARGB8888 && pSrc->tileType == GCU_LINEAR)
+    {
+        pSource->image.stride = pSrc->planes[0].stride / 4;
+        pSource->image.pPixels = (uint32_t*)pSrc->planes[0].pBase +
+                                 pLayer->srcRect.top * pSource->image.stride + pLayer->srcRect.left;
+        pSource->image.width = pSource->sw;
+        pSource->image.height = pSource->sh;
+        return GCU_TRUE;
+    }
+    if(!_swImageAlloc(&pSource->image, pSource->sw, pSource->sh))
+    {
+        return GCU_FALSE;
+    }
+    _swPoolRun(_swConvertBand, pSource, (pSource->sh + SW_BAND_ROWS - 1) / SW_BAND_ROWS);
+    return GCU_TRUE;
+}
+
+/*
+ * Filter blit: a 9 tap filter along source rows or columns
+ */
+static void _swFilterBand(void* pArg, GCUuint band)
+{
+    SW_JOB* pJob = (SW_JOB*)pArg;
+    const SW_IMAGE* pIn = pJob->pFilterIn;
+    SW_IMAGE* pOut = pJob->pFilterOut;
+    GCUint r = band * SW_BAND_ROWS;
+    GCUint end = SW_MIN(r + SW_BAND_ROWS, pIn->height);
+
+    for(; r < end; r++)
+    {
+        uint32_t* pDst = pOut->pPixels + r * pOut->stride;
+        GCUint c, k, shift;
+
+        for(c = 0; c < pIn->width; c++)
+        {
+            uint32_t out = 0;
+
+            for(shift = 0; shift < 32; shift += 8)
+            {
+                GCUint sum = 1 << (SW_FILTER_SHIFT - 1);
+
+                for(k = 0; k < SW_FILTER_TAPS; k++)
+                {
+                    GCUint x = c, y = r;
+
+                    if(pJob->filterDir == 0)
+                    {
+                        x = _swClampInt(c + k - SW_FILTER_TAPS / 2, 0, pIn->width - 1);
+                    }
+                    else
+                    {
+                        y = _swClampInt(r + k - SW_FILTER_TAPS / 2, 0, pIn->height - 1);
+                    }
+                    sum += pJob->filter[k] * (GCUint)((pIn->pPixels[y * pIn->stride + x] >> shift) & 0xff);
+                }
+                out |= (uint32_t)_swClampInt(sum >> SW_FILTER_SHIFT, 0, 255) << shift;
+            }
+            pDst[c] = out;
+        }
+    }
+}
+
+static GCUbool _swFilterPass(SW_JOB* pJob, SW_SOURCE* pSource, const GCUint* pCoef, GCUint dir)
+{
+    SW_IMAGE out;
+
+    if(!_swImageAlloc(&out, pSource->sw, pSource->sh))
+    {
+        return GCU_FALSE;
+    }
+    memcpy(pJob->filter, pCoef, sizeof(pJob->filter));
+    pJob->filterDir = dir;
+    pJob->pFilterIn = &pSource->image;
+    pJob->pFilterOut = &out;
+    _swPoolRun(_swFilterBand, pJob, (pSource->sh + SW_BAND_ROWS - 1) / SW_BAND_ROWS);
+
+    _swImageFree(&pSource->image);
+    pSource->image = out;
+    return GCU_TRUE;
+}
+
+/*
+ * Sampling. Positions are 16.16 fixed point in the rotated source, pixel
+ * centres mapped onto pixel centres; the position along the row advances
+ * by an exact rational step.
+ */
+static inline uint32_t _swBilinear(const SW_IMAGE* pImage, GCUint a, GCUint b)
+{
+    GCUint x0 = a >> 16, y0 = b >> 16;
+    GCUint fx = (a >> 8) & 0xff, fy = (b >> 8) & 0xff;
+    GCUint x1 = _swClampInt(x0 + 1, 0, pImage->width - 1);
+    GCUint y1 = _swClampInt(y0 + 1, 0, pImage->height - 1);
+    const uint32_t* r0;
+    const uint32_t* r1;
+    uint32_t out = 0;
+    GCUint shift;
+
+    x0 = _swClampInt(x0, 0, pImage->width - 1);
+    y0 = _swClampInt(y0, 0, pImage->height - 1);
+    r0 = pImage->pPixels + y0 * pImage->stride;
+    r1 = pImage->pPixels + y1 * pImage->stride;
+
+    for(shift = 0; shift < 32; shift += 8)
+    {
+        GCUint top = ((r0[x0] >> shift) & 0xff) * (256 - fx) + ((r0[x1] >> shift) & 0xff) * fx;
+        GCUint bot = ((r1[x0] >> shift) & 0xff) * (256 - fx) + ((r1[x1] >> shift) & 0xff) * fx;
+
+        out |= (uint32_t)((top * (256 - fy) + bot * fy + 32768) >> 16) << shift;
+    }
+    return out;
+}
+
+/* Catmull-Rom weights for a 8 bit fraction, summing to 4096 */
+static void _swCubicWeights(GCUint f, GCUint w[4])
+{
+    int64_t t = f, t2 = t * t, t3 = t2 * t;
+
+    /* with t in 1/256 units, 2 * 256^3 / 4096 = 8192 */
+    w[0] = (GCUint)((-t3 + 512 * t2 - 65536 * t) / 8192);
+    w[2] = (GCUint)((-3 * t3 + 1024 * t2 + 65536 * t) / 8192);
+    w[3] = (GCUint)((t3 - 256 * t2) / 8192);
+    w[1] = 4096 - w[0] - w[2] - w[3];
+}
+
+static inline uint32_t _swBicubic(const SW_IMAGE* pImage, GCUint a, GCUint b)
+{
+    GCUint wx[4], wy[4], xs[4], i, j, shift;
+    GCUint x0 = (a >> 16) - 1, y0 = (b >> 16) - 1;
+    uint32_t out = 0;
+
+    _swCubicWeights((a >> 8) & 0xff, wx);
+    _swCubicWeights((b >> 8) & 0xff, wy);
+    for(i = 0; i < 4; i++)
+    {
+        xs[i] = _swClampInt(x0 + i, 0, pImage->width - 1);
+    }
+    for(shift = 0; shift < 32; shift += 8)
+    {
+        int64_t sum = 0;
+
+        for(j = 0; j < 4; j++)
+        {
+            const uint32_t* pRow = pImage->pPixels +
+                                   _swClampInt(y0 + j, 0, pImage->height - 1) * pImage->stride;
+            GCUint h = 0;
+
+            for(i = 0; i < 4; i++)
+            {
+                h += wx[i] * (GCUint)((pRow[xs[i]] >> shift) & 0xff);
+            }
+            sum += (int64_t)wy[j] * h;
+        }
+        out |= (uint32_t)_swClampInt((GCUint)((sum + (1 << 23)) >> 24), 0, 255) << shift;
+    }
+    return out;
+}
+
+/* 16.16 position of the centre of pixel i of n along a source of size s, minus a half */
+static inline int64_t _swCentre(GCUint i, GCUint s, GCUint n)
+{
+    return ((int64_t)(2 * i + 1) * s * 65536) / (2 * n) - 32768;
+}
+
+static void _swSample(const SW_SOURCE* pSource, GCU_QUALITY_TYPE quality,
+                      GCUint x, GCUint y, GCUint count, uint32_t* pOut)
+{
+    const SW_LAYER* pLayer = pSource->pLayer;
+    const SW_IMAGE* pImage = &pSource->image;
+    GCUint i = x - pLayer->dstRect.left;
+    GCUint j = y - pLayer->dstRect.top;
+    GCUint rot = pLayer->rotation;
+    GCUbool bScaled = pSource->rw != pSource->dw || pSource->rh != pSource->dh;
+    GCUint maxA = (pSource->sw - 1) << 16, maxB = (pSource->sh - 1) << 16;
+    GCUint k, across, a0, b0, ax, bx;
+    int64_t num, den;
+    GCUint q, rem, stepQ, stepR;
+
+    /* straight copy */
+    if(rot == GCU_ROTATION_0 && !bScaled)
+    {
+        memcpy(pOut, pImage->pPixels + j * pImage->stride + i, count * 4);
+        return;
+    }
+
+    /* position across the rows, and the start and step along them */
+    across = (GCUint)_swCentre(j, pSource->rh, pSource->dh);
+    den = 2 * (int64_t)pSource->dw;
+    num = (int64_t)(2 * i + 1) * pSource->rw * 65536 - den * 32768;
+    q = (GCUint)(num >= 0 ? num / den : -((-num + den - 1) / den));
+    rem = (GCUint)(num - (int64_t)q * den);
+    stepQ = (GCUint)(((int64_t)2 * pSource->rw * 65536) / den);
+    stepR = (GCUint)(((int64_t)2 * pSource->rw * 65536) % den);
+
+    /* rotated (u, v) to source (a, b): a = a0 + ax * u, b = b0 + bx * u */
+    if(rot & GCU_ROTATION_90)
+    {
+        a0 = across;            ax = 0;
+        b0 = maxB;              bx = -1;
+    }
+    else
+    {
+        a0 = 0;                 ax = 1;
+        b0 = across;            bx = 0;
+    }
+    if(rot & GCU_ROTATION_FLIP_H)
+    {
+        a0 = maxA - a0;         ax = -ax;
+    }
+    if(rot & GCU_ROTATION_FLIP_V)
+    {
+        b0 = maxB - b0;         bx = -bx;
+    }
+
+    for(k = 0; k < count; k++)
+    {
+        GCUint a = a0 + ax * q;
+        GCUint b = b0 + bx * q;
+
+        if(quality == GCU_QUALITY_NORMAL || !bScaled)
+        {
+            GCUint px = _swClampInt((a + 32768) >> 16, 0, pSource->sw - 1);
+            GCUint py = _swClampInt((b + 32768) >> 16, 0, pSource->sh - 1);
+
+            pOut[k] = pImage->pPixels[py * pImage->stride + px];
+        }
+        else if(quality == GCU_QUALITY_HIGH)
+        {
+            pOut[k] = _swBilinear(pImage, a, b);
+        }
+        else
+        {
+            pOut[k] = _swBicubic(pImage, a, b);
+        }
+
+        q += stepQ;
+        rem += stepR;
+        if(rem >= den)
+        {
+            q++;
+            rem -= (GCUint)den;
+        }
+    }
+}
+
+/* raster operation with the pattern reading as zero */
+static inline uint32_t _swRop(GCUuint rop, uint32_t s, uint32_t d)
+{
+    uint32_t r = 0;
+
+    if(rop & 0x01) r |= ~s & ~d;
+    if(rop & 0x02) r |= ~s & d;
+    if(rop & 0x04) r |= s & ~d;
+    if(rop & 0x08) r |= s & d;
+    return r;
+}
+
+/* columns of row y covered by a layer, inside the region */
+static GCUbool _swLayerSpan(const SW_JOB* pJob, const SW_LAYER* pLayer, GCUint y, GCUint* pX0, GCUint* pX1)
+{
+    if(y < pLayer->dstRect.top || y >= pLayer->dstRect.bottom)
+    {
+        return GCU_FALSE;
+    }
+    *pX0 = SW_MAX(pLayer->dstRect.left, pJob->region.left);
+    *pX1 = SW_MIN(pLayer->dstRect.right, pJob->region.right);
+    return *pX0 < *pX1;
+}
+
+/*
+ * Pass 2: one band of destination rows
+ */
+static void _swRenderBand(void* pArg, GCUuint band)
+{
+    SW_JOB* pJob = (SW_JOB*)pArg;
+    SW_COMMAND* pCommand = pJob->pCommand;
+    GCU_RECT* pRegion = &pJob->region;
+    GCUint width = pRegion->right - pRegion->left;
+    GCUint base = pRegion->top & ~1;
+    GCUint start = base + band * SW_BAND_ROWS;
+    GCUint end = SW_MIN(start + SW_BAND_ROWS, pRegion->bottom);
+    GCUint g = pJob->groupRows;
+    uint32_t* pRows = (uint32_t*)malloc((size_t)width * 4 * (g + 1));
+    unsigned char* pCover = (unsigned char*)malloc(width);
+    uint32_t* pTmp;
+    GCUint gy;
+
+    if(pRows == GCU_NULL || pCover == GCU_NULL)
+    {
+        free(pRows);
+        free(pCover);
+        return;
+    }
+    pTmp = pRows + width * g;
+
+    for(gy = start; gy < end; gy += g)
+    {
+        const uint32_t* ppRows[2] = { GCU_NULL, GCU_NULL };
+        GCUint spanX0 = pRegion->right, spanX1 = pRegion->left;
+        GCUint r;
+
+        for(r = 0; r < g; r++)
+        {
+            GCUint y = gy + r;
+            uint32_t* pRow = pRows + r * width - pRegion->left;    /* indexed by x */
+            GCUint l, x0, x1;
+            GCUbool bAny = GCU_FALSE;
+
+            if(y < pRegion->top || y >= pRegion->bottom)
+            {
+                continue;
+            }
+
+            if(pCommand->type == SW_CMD_COMPOSE)
+            {
+                memset(pCover, 0, width);
+            }
+            for(l = 0; l < pCommand->layerCount; l++)
+            {
+                const SW_LAYER* pLayer = &pCommand->pLayers[l];
+
+                if(!_swLayerSpan(pJob, pLayer, y, &x0, &x1))
+                {
+                    continue;
+                }
+                if(pCommand->type == SW_CMD_BLIT || pCommand->type == SW_CMD_FILTER)
+                {
+                    _swSample(&pJob->pSources[l], pCommand->quality, x0, y, x1 - x0, pRow + x0);
+                }
+                else
+                {
+                    if(pCommand->type != SW_CMD_COMPOSE || !bAny)
+                    {
+                        /* the destination is read once per row */
+                        if(pCommand->type == SW_CMD_COMPOSE)
+                        {
+                            _swFetchRow(pCommand->pDst, pRegion->left, y, width, pRow + pRegion->left);
+                        }
+                        else
+                        {
+                            _swFetchRow(pCommand->pDst, x0, y, x1 - x0, pRow + x0);
+                        }
+                    }
+                    _swSample(&pJob->pSources[l], pCommand->quality, x0, y, x1 - x0, pTmp);
+                    if(pCommand->type == SW_CMD_ROP)
+                    {
+                        GCUint k;
+
+                        for(k = 0; k < x1 - x0; k++)
+                        {
+                            pRow[x0 + k] = _swRop(pCommand->rop, pTmp[k], pRow[x0 + k]);
+                        }
+                    }
+                    else
+                    {
+                        _swSpanBlend(pRow + x0, pTmp, x1 - x0, pLayer->blendMode,
+                                     pLayer->srcGlobalAlpha, pLayer->dstGlobalAlpha);
+                    }
+                    if(pCommand->type == SW_CMD_COMPOSE)
+                    {
+                        memset(pCover + x0 - pRegion->left, 1, x1 - x0);
+                    }
+                }
+                bAny = GCU_TRUE;
+                spanX0 = SW_MIN(spanX0, x0);
+                spanX1 = SW_MAX(spanX1, x1);
+            }
+            if(!bAny)
+            {
+                continue;
+            }
+
+            if(pCommand->type == SW_CMD_COMPOSE)
+            {
+                /* store the covered runs only, so untouched pixels are not dithered again */
+                GCUint x = 0;
+
+                while(x < width)
+                {
+                    GCUint run;
+                    const uint32_t* pRun;
+
+                    if(!pCover[x])
+                    {
+                        x++;
+                        continue;
+                    }
+                    for(run = x; run < width && pCover[run]; run++)
+                        ;
+                    pRun = pRow + pRegion->left + x;
+                    _swStoreRows(pCommand->pDst, pRegion->left + x, y, run - x, 1, &pRun, pCommand->bDither);
+                    x = run;
+                }
+                continue;
+            }
+            ppRows[r] = pRows + r * width;
+        }
+
+        if(spanX0 < spanX1 && pCommand->type != SW_CMD_COMPOSE)
+        {
+            /* a single layer covers the same columns on every row of the group */
+            if(ppRows[0])
+            {
+                ppRows[0] += spanX0 - pRegion->left;
+            }
+            if(ppRows[1])
+            {
+                ppRows[1] += spanX0 - pRegion->left;
+            }
+            _swStoreRows(pCommand->pDst, spanX0, gy, spanX1 - spanX0, g, ppRows, pCommand->bDither);
+        }
+    }
+
+    free(pRows);
+    free(pCover);
+}
+
+static void _swExecuteLayers(SW_COMMAND* pCommand)
+{
+    const SW_FORMAT_INFO* pDstInfo = pCommand->pDst->pInfo;
+    SW_JOB job;
+    GCUint l, rows;
+
+    memset(&job, 0, sizeof(job));
+    job.pCommand = pCommand;
+    job.groupRows = (pDstInfo->bYUV && pDstInfo->vShift) ? 2 : 1;
+    job.pSources = (SW_SOURCE*)calloc(pCommand->layerCount, sizeof(SW_SOURCE));
+    if(job.pSources == GCU_NULL)
+    {
+        return;
+    }
+
+    /* rows and columns any layer reaches */
+    job.region.left = pCommand->clipRect.right;
+    job.region.top = pCommand->clipRect.bottom;
+    job.region.right = pCommand->clipRect.left;
+    job.region.bottom = pCommand->clipRect.top;
+    for(l = 0; l < pCommand->layerCount; l++)
+    {
+        const GCU_RECT* pRect = &pCommand->pLayers[l].dstRect;
+
+        job.region.left = SW_MIN(job.region.left, SW_MAX(pRect->left, pCommand->clipRect.left));
+        job.region.top = SW_MIN(job.region.top, SW_MAX(pRect->top, pCommand->clipRect.top));
+        job.region.right = SW_MAX(job.region.right, SW_MIN(pRect->right, pCommand->clipRect.right));
+        job.region.bottom = SW_MAX(job.region.bottom, SW_MIN(pRect->bottom, pCommand->clipRect.bottom));
+    }
+
+    for(l = 0; l < pCommand->layerCount; l++)
+    {
+        if(!_swPrepareSource(&job.pSources[l], &pCommand->pLayers[l]))
+        {
+            goto OnExit;
+        }
+    }
+
+    if(pCommand->type == SW_CMD_FILTER)
+    {
+        SW_SOURCE* pSource = &job.pSources[0];
+
+        if(pSource->image.pOwned == GCU_NULL)
+        {
+            /* filtered into a copy, never in place */
+            SW_IMAGE copy;
+            GCUint r;
+
+            if(!_swImageAlloc(&copy, pSource->sw, pSource->sh))
+            {
+                goto OnExit;
+            }
+            for(r = 0; r < pSource->sh; r++)
+            {
+                memcpy(copy.pPixels + r * copy.stride, pSource->image.pPixels + r * pSource->image.stride,
+                       pSource->sw * 4);
+            }
+            pSource->image = copy;
+        }
+        if(pCommand->filterType == GCU_H_USER_FILTER)
+        {
+            _swFilterPass(&job, pSource, pCommand->coef[0], 0);
+        }
+        else if(pCommand->filterType == GCU_V_USER_FILTER)
+        {
+            _swFilterPass(&job, pSource, pCommand->coef[1], 1);
+        }
+        else
+        {
+            _swFilterPass(&job, pSource, s_blur, 0);
+            _swFilterPass(&job, pSource, s_blur, 1);
+        }
+    }
+
+    if(job.region.left < job.region.right && job.region.top < job.region.bottom)
+    {
+        rows = job.region.bottom - (job.region.top & ~1);
+        _swPoolRun(_swRenderBand, &job, (rows + SW_BAND_ROWS - 1) / SW_BAND_ROWS);
+    }
+
+OnExit:
+    for(l = 0; l < pCommand->layerCount; l++)
+    {
+        _swImageFree(&job.pSources[l].image);
+    }
+    free(job.pSources);
+}
+
+/*
+ * Fill
+ */
+typedef struct _SW_FILL_JOB{
+    SW_COMMAND*     pCommand;
+    SW_IMAGE        pattern;
+    GCUint          groupRows;
+    GCUuint         packed;         /* solid color in the destination format */
+    GCUbool         bSpan;          /* linear 16 or 32 bit destination       */
+}SW_FILL_JOB;
+
+static void _swFillBand(void* pArg, GCUuint band)
+{
+    SW_FILL_JOB* pJob = (SW_FILL_JOB*)pArg;
+    SW_COMMAND* pCommand = pJob->pCommand;
+    SW_SURFACE* pDst = pCommand->pDst;
+    GCU_RECT* pRect = &pCommand->clipRect;
+    GCUint width = pRect->right - pRect->left;
+    GCUint start = (pRect->top & ~1) + band * SW_BAND_ROWS;
+    GCUint end = SW_MIN(start + SW_BAND_ROWS, pRect->bottom);
+    GCUint g = pJob->groupRows, gy, r, x;
+    uint32_t* pRow;
+
+    if(pJob->bSpan)
+    {
+        for(gy = SW_MAX(start, pRect->top); gy < end; gy++)
+        {
+            unsigned char* p = pDst->planes[0].pBase + gy * pDst->planes[0].stride +
+                               pRect->left * pDst->pInfo->bpp;
+
+            if(pDst->pInfo->bpp == 4)
+            {
+                _swSpanFill32((uint32_t*)p, pJob->packed, width);
+            }
+            else
+            {
+                _swSpanFill16((uint16_t*)p, (uint16_t)pJob->packed, width);
+            }
+        }
+        return;
+    }
+
+    pRow = (uint32_t*)malloc((size_t)width * 4 * g);
+    if(pRow == GCU_NULL)
+    {
+        return;
+    }
+    for(gy = start; gy < end; gy += g)
+    {
+        const uint32_t* ppRows[2] = { GCU_NULL, GCU_NULL };
+
+        for(r = 0; r < g; r++)
+        {
+            GCUint y = gy + r;
+            uint32_t* p = pRow + r * width;
+
+            if(y < pRect->top || y >= pRect->bottom)
+            {
+                continue;
+            }
+            if(pJob->pattern.pPixels)
+            {
+                const uint32_t* pPat = pJob->pattern.pPixels +
+                                       ((y - pCommand->fillRect.top) % pJob->pattern.height) * pJob->pattern.stride;
+
+                for(x = 0; x < width; x++)
+                {
+                    p[x] = pPat[(pRect->left + x - pCommand->fillRect.left) % pJob->pattern.width];
+                }
+            }
+            else
+            {
+                _swSpanFill32(p, pCommand->color, width);
+            }
+            ppRows[r] = p;
+        }
+        _swStoreRows(pDst, pRect->left, gy, width, g, ppRows, GCU_FALSE);
+    }
+    free(pRow);
+}
+
+static void _swExecuteFill(SW_COMMAND* pCommand)
+{
+    SW_SURFACE* pDst = pCommand->pDst;
+    const SW_FORMAT_INFO* pInfo = pDst->pInfo;
+    GCU_RECT* pRect = &pCommand->clipRect;
+    SW_FILL_JOB job;
+    SW_SOURCE pattern;
+    SW_LAYER patternLayer;
+    GCUint rows;
+
+    if(pRect->left >= pRect->right || pRect->top >= pRect->bottom)
+    {
+        return;
+    }
+    memset(&job, 0, sizeof(job));
+    job.pCommand = pCommand;
+    job.groupRows = (pInfo->bYUV && pInfo->vShift) ? 2 : 1;
+
+    if(pCommand->pPattern)
+    {
+        memset(&patternLayer, 0, sizeof(patternLayer));
+        patternLayer.pSrc = pCommand->pPattern;
+        patternLayer.srcRect.right = pCommand->pPattern->width;
+        patternLayer.srcRect.bottom = pCommand->pPattern->height;
+        patternLayer.dstRect = patternLayer.srcRect;
+        if(!_swPrepareSource(&pattern, &patternLayer))
+        {
+            return;
+        }
+        job.pattern = pattern.image;
+    }
+    else if(!pInfo->bYUV && pDst->tileType == GCU_LINEAR && (pInfo->bpp == 4 || pInfo->bpp == 2))
+    {
+        /* pack the color once, through the same path as any other store */
+        SW_SURFACE one = *pDst;
+        uint32_t packed = 0;
+        const uint32_t* pColor = &pCommand->color;
+
+        one.planes[0].pBase = (unsigned char*)&packed;
+        _swStoreRows(&one, 0, 0, 1, 1, &pColor, GCU_FALSE);
+        job.packed = packed;
+        job.bSpan = GCU_TRUE;
+    }
+
+    rows = pRect->bottom - (pRect->top & ~1);
+    _swPoolRun(_swFillBand, &job, (rows + SW_BAND_ROWS - 1) / SW_BAND_ROWS);
+    _swImageFree(&job.pattern);
+}
+
+void _swExecute(SW_COMMAND* pCommand)
+{
+    if(pCommand->type == SW_CMD_FILL)
+    {
+        _swExecuteFill(pCommand);
+    }
+    else
+    {
+        _swExecuteLayers(pCommand);
+    }
+}
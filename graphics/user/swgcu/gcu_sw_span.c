@@ -0,0 +1,290 @@
+/***********************************************************************************
+ *
+ *    Copyright (c) 2009 - 2013 by Marvell International Ltd. and its affiliates.
+ *    All rights reserved.
+ *
+ *    This software file (the "File") is owned and distributed by Marvell
+ *    International Ltd. and/or its affiliates ("Marvell") under Marvell Commercial
+ *    License.
+ *
+ *    If you received this File from Marvell and you have entered into a commercial
+ *    license agreement (a "Commercial License") with Marvell, the File is licensed
+ *    to you under the terms of the applicable Commercial License.
+ *
+ *
+ ***********************************************************************************/
+
+/*!
+ ******************************************************************************
+ *  \file gcu_sw_span.c
+ *  \brief
+ *      Inner loops of the software GCU: solid fills and blending of ARGB
+ *      spans, in SSE2 or NEON when the target has them. The vector and C
+ *      paths use the same integer arithmetic and give identical pixels.
+ ******************************************************************************/
+
+#include "gcu_sw.h"
+
+#if defined(GCU_SW_NO_SIMD)
+/* plain C, to check the vector paths against */
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SW_SPAN_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SW_SPAN_NEON
+#endif
+
+/* a * b / 255, rounded, exact for 8 bit a and b */
+static inline GCUuint _swMul255(GCUuint a, GCUuint b)
+{
+    GCUuint t = a * b + 128;
+
+    return (t + (t >> 8)) >> 8;
+}
+
+static inline uint32_t _swBlendPixel(uint32_t d, uint32_t s, GCU_BLEND_MODE mode, GCUuint sga, GCUuint dga)
+{
+    GCUuint as = _swMul255(s >> 24, sga);
+    uint32_t out = 0;
+    GCUuint shift;
+
+    for(shift = 0; shift < 32; shift += 8)
+    {
+        GCUuint sc = _swMul255((s >> shift) & 0xff, sga);
+        GCUuint dc = _swMul255((d >> shift) & 0xff, dga);
+        GCUuint c;
+
+        switch(mode)
+        {
+        case GCU_BLEND_SRC:
+            c = sc;
+            break;
+        case GCU_BLEND_PLUS:
+            c = sc + dc;
+            break;
+        default:
+            c = sc + _swMul255(dc, 255 - as);
+            break;
+        }
+        out |= (c > 255 ? 255 : c) << shift;
+    }
+    return out;
+}
+
+#if defined(SW_SPAN_SSE2)
+
+static inline __m128i _swMul255x8(__m128i a, __m128i b)
+{
+    __m128i t = _mm_add_epi16(_mm_mullo_epi16(a, b), _mm_set1_epi16(128));
+
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+static inline __m128i _swAlphax8(__m128i p)
+{
+    p = _mm_shufflelo_epi16(p, _MM_SHUFFLE(3, 3, 3, 3));
+    return _mm_shufflehi_epi16(p, _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+/* two pixels in 16 bit lanes */
+static inline __m128i _swBlendx2(__m128i d, __m128i s, GCU_BLEND_MODE mode, __m128i sga, __m128i dga)
+{
+    __m128i sc = _swMul255x8(s, sga);
+    __m128i dc = _swMul255x8(d, dga);
+
+    switch(mode)
+    {
+    case GCU_BLEND_SRC:
+        return sc;
+    case GCU_BLEND_PLUS:
+        return _mm_adds_epu16(sc, dc);
+    default:
+        return _mm_adds_epu16(sc, _swMul255x8(dc, _mm_sub_epi16(_mm_set1_epi16(255), _swAlphax8(sc))));
+    }
+}
+
+void _swSpanBlend(uint32_t* pDst, const uint32_t* pSrc, GCUint count,
+                  GCU_BLEND_MODE mode, GCUuint srcGlobalAlpha, GCUuint dstGlobalAlpha)
+{
+    __m128i zero = _mm_setzero_si128();
+    __m128i sga = _mm_set1_epi16((short)srcGlobalAlpha);
+    __m128i dga = _mm_set1_epi16((short)dstGlobalAlpha);
+    GCUint i = 0;
+
+    for(; i + 4 <= count; i += 4)
+    {
+        __m128i s = _mm_loadu_si128((const __m128i*)(pSrc + i));
+        __m128i d = _mm_loadu_si128((const __m128i*)(pDst + i));
+        __m128i lo = _swBlendx2(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(s, zero), mode, sga, dga);
+        __m128i hi = _swBlendx2(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(s, zero), mode, sga, dga);
+
+        _mm_storeu_si128((__m128i*)(pDst + i), _mm_packus_epi16(lo, hi));
+    }
+    for(; i < count; i++)
+    {
+        pDst[i] = _swBlendPixel(pDst[i], pSrc[i], mode, srcGlobalAlpha, dstGlobalAlpha);
+    }
+}
+
+void _swSpanFill32(uint32_t* pDst, uint32_t value, GCUint count)
+{
+    __m128i v = _mm_set1_epi32((int)value);
+    GCUint i = 0;
+
+    for(; i + 8 <= count; i += 8)
+    {
+        _mm_storeu_si128((__m128i*)(pDst + i), v);
+        _mm_storeu_si128((__m128i*)(pDst + i + 4), v);
+    }
+    for(; i < count; i++)
+    {
+        pDst[i] = value;
+    }
+}
+
+void _swSpanFill16(uint16_t* pDst, uint16_t value, GCUint count)
+{
+    __m128i v = _mm_set1_epi16((short)value);
+    GCUint i = 0;
+
+    for(; i + 8 <= count; i += 8)
+    {
+        _mm_storeu_si128((__m128i*)(pDst + i), v);
+    }
+    for(; i < count; i++)
+    {
+        pDst[i] = value;
+    }
+}
+
+const char* _swSpanKernelName(void)
+{
+    return "sse2";
+}
+
+#elif defined(SW_SPAN_NEON)
+
+static inline uint16x8_t _swMul255x8(uint16x8_t a, uint16x8_t b)
+{
+    uint16x8_t t = vmlaq_u16(vdupq_n_u16(128), a, b);
+
+    return vshrq_n_u16(vsraq_n_u16(t, t, 8), 8);
+}
+
+void _swSpanBlend(uint32_t* pDst, const uint32_t* pSrc, GCUint count,
+                  GCU_BLEND_MODE mode, GCUuint srcGlobalAlpha, GCUuint dstGlobalAlpha)
+{
+    static const uint8_t alphaIndex[8] = { 3, 3, 3, 3, 7, 7, 7, 7 };
+    uint8x8_t index = vld1_u8(alphaIndex);
+    uint16x8_t sga = vdupq_n_u16((uint16_t)srcGlobalAlpha);
+    uint16x8_t dga = vdupq_n_u16((uint16_t)dstGlobalAlpha);
+    uint16x8_t full = vdupq_n_u16(255);
+    GCUint i = 0;
+
+    for(; i + 2 <= count; i += 2)
+    {
+        uint8x8_t s8 = vld1_u8((const uint8_t*)(pSrc + i));
+        uint8x8_t d8 = vld1_u8((const uint8_t*)(pDst + i));
+        uint16x8_t sc = _swMul255x8(vmovl_u8(s8), sga);
+        uint16x8_t dc = _swMul255x8(vmovl_u8(d8), dga);
+        uint16x8_t c;
+
+        switch(mode)
+        {
+        case GCU_BLEND_SRC:
+            c = sc;
+            break;
+        case GCU_BLEND_PLUS:
+            c = vqaddq_u16(sc, dc);
+            break;
+        default:
+            {
+                uint16x8_t as = _swMul255x8(vmovl_u8(vtbl1_u8(s8, index)), sga);
+
+                c = vqaddq_u16(sc, _swMul255x8(dc, vsubq_u16(full, as)));
+            }
+            break;
+        }
+        vst1_u8((uint8_t*)(pDst + i), vqmovn_u16(c));
+    }
+    for(; i < count; i++)
+    {
+        pDst[i] = _swBlendPixel(pDst[i], pSrc[i], mode, srcGlobalAlpha, dstGlobalAlpha);
+    }
+}
+
+void _swSpanFill32(uint32_t* pDst, uint32_t value, GCUint count)
+{
+    uint32x4_t v = vdupq_n_u32(value);
+    GCUint i = 0;
+
+    for(; i + 4 <= count; i += 4)
+    {
+        vst1q_u32(pDst + i, v);
+    }
+    for(; i < count; i++)
+    {
+        pDst[i] = value;
+    }
+}
+
+void _swSpanFill16(uint16_t* pDst, uint16_t value, GCUint count)
+{
+    uint16x8_t v = vdupq_n_u16(value);
+    GCUint i = 0;
+
+    for(; i + 8 <= count; i += 8)
+    {
+        vst1q_u16(pDst + i, v);
+    }
+    for(; i < count; i++)
+    {
+        pDst[i] = value;
+    }
+}
+
+const char* _swSpanKernelName(void)
+{
+    return "neon";
+}
+
+#else
+
+void _swSpanBlend(uint32_t* pDst, const uint32_t* pSrc, GCUint count,
+                  GCU_BLEND_MODE mode, GCUuint srcGlobalAlpha, GCUuint dstGlobalAlpha)
+{
+    GCUint i;
+
+    for(i = 0; i < count; i++)
+    {
+        pDst[i] = _swBlendPixel(pDst[i], pSrc[i], mode, srcGlobalAlpha, dstGlobalAlpha);
+    }
+}
+
+void _swSpanFill32(uint32_t* pDst, uint32_t value, GCUint count)
+{
+    GCUint i;
+
+    for(i = 0; i < count; i++)
+    {
+        pDst[i] = value;
+    }
+}
+
+void _swSpanFill16(uint16_t* pDst, uint16_t value, GCUint count)
+{
+    GCUint i;
+
+    for(i = 0; i < count; i++)
+    {
+        pDst[i] = value;
+    }
+}
+
+const char* _swSpanKernelName(void)
+{
+    return "c";
+}
+
+#endif
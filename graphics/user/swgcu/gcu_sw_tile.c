@@ -0,0 +1,215 @@
+/***********************************************************************************
+ *
+ *    Copyright (c) 2009 - 2013 by Marvell International Ltd. and its affiliates.
+ *    All rights reserved.
+ *
+ *    This software file (the "File") is owned and distributed by Marvell
+ *    International Ltd. and/or its affiliates ("Marvell") under Marvell Commercial
+ *    License.
+ *
+ *    If you received this File from Marvell and you have entered into a commercial
+ *    license agreement (a "Commercial License") with Marvell, the File is licensed
+ *    to you under the terms of the applicable Commercial License.
+ *
+ *
+ ***********************************************************************************/
+
+/*!
+ ******************************************************************************
+ *  \file gcu_sw_tile.c
+ *  \brief
+ *      Surface memory of the software GCU: allocation, plane layout and the
+ *      tiled addressing of the GC 2D engine.
+ *
+ *      TILED             4x4 pixel tiles, left to right, one tile row takes
+ *                        4 rows of the stride.
+ *      SUPER_TILED       64x64 pixel super tiles of 16x16 tiles, the tiles
+ *                        of a super tile in Morton order (x bit first).
+ *      MULTI_*           the surface split over two banks for the two pixel
+ *                        pipes: the bank is (tile x / 2) ^ (tile y) & 1, each
+ *                        bank holds every other tile row with the tile pairs
+ *                        of bank 1 swapped, the bank laid out as above.
+ *
+ *      The layouts match the pre-tiled ARGB8888-*tiled*.bmp sample inputs.
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "gcu_sw.h"
+
+#define SW_FAKE_PHYSICAL_BASE   0x10000000
+
+/* physical addresses handed out for allocations, there is no GPU to use them */
+static GCUPhysicalAddr s_nextPhysical = SW_FAKE_PHYSICAL_BASE;
+
+/* spreads the 4 bits of a tile coordinate to the even bits of a byte */
+static const unsigned char s_morton[16] = {
+    0x00, 0x01, 0x04, 0x05, 0x10, 0x11, 0x14, 0x15,
+    0x40, 0x41, 0x44, 0x45, 0x50, 0x51, 0x54, 0x55,
+};
+
+void _swSurfaceAlignment(GCU_TILE_TYPE tileType, GCUuint* pAlignW, GCUuint* pAlignH)
+{
+    switch(tileType)
+    {
+    case GCU_TILED:
+        *pAlignW = 16;
+        *pAlignH = 4;
+        break;
+    case GCU_MULTI_TILED:
+        *pAlignW = 16;
+        *pAlignH = 8;
+        break;
+    case GCU_SUPER_TILED:
+        *pAlignW = 64;
+        *pAlignH = 64;
+        break;
+    case GCU_MULTI_SUPER_TILED:
+        *pAlignW = 64;
+        *pAlignH = 128;
+        break;
+    default:
+        *pAlignW = 16;
+        *pAlignH = 4;
+        break;
+    }
+}
+
+static inline GCUuint _swTiled(GCUuint x, GCUuint y, GCUuint stride, GCUuint bpp)
+{
+    return (y >> 2) * stride * 4 + ((x >> 2) * 16 + (y & 3) * 4 + (x & 3)) * bpp;
+}
+
+static inline GCUuint _swSuperTiled(GCUuint x, GCUuint y, GCUuint stride, GCUuint bpp)
+{
+    GCUuint tile = s_morton[(x >> 2) & 15] | (s_morton[(y >> 2) & 15] << 1);
+
+    return (y >> 6) * stride * 64 + ((x >> 6) * 4096 + tile * 16 + (y & 3) * 4 + (x & 3)) * bpp;
+}
+
+GCUuint _swTileOffset(const SW_SURFACE* pSurface, GCUuint x, GCUuint y)
+{
+    const SW_PLANE* pPlane = &pSurface->planes[0];
+    GCUuint bpp = pSurface->pInfo->bpp;
+    GCUuint bank;
+
+    switch(pSurface->tileType)
+    {
+    case GCU_TILED:
+        return _swTiled(x, y, pPlane->stride, bpp);
+    case GCU_SUPER_TILED:
+        return _swSuperTiled(x, y, pPlane->stride, bpp);
+    case GCU_MULTI_TILED:
+    case GCU_MULTI_SUPER_TILED:
+        bank = ((x >> 3) ^ (y >> 2)) & 1;
+        x ^= bank << 3;
+        y = ((y >> 3) << 2) | (y & 3);
+        return bank * (pPlane->stride * pPlane->height / 2) +
+               (pSurface->tileType == GCU_MULTI_TILED ?
+                _swTiled(x, y, pPlane->stride, bpp) : _swSuperTiled(x, y, pPlane->stride, bpp));
+    default:
+        return y * pPlane->stride + x * bpp;
+    }
+}
+
+/* plane sizes of a surface laid out contiguously from plane 0 */
+static GCUuint _swLayoutPlanes(SW_SURFACE* pSurface, GCUuint width, GCUuint height, GCUint stride)
+{
+    const SW_FORMAT_INFO* pInfo = pSurface->pInfo;
+    GCUuint size, i;
+
+    pSurface->planeCount = pInfo->planes;
+    pSurface->planes[0].width = width;
+    pSurface->planes[0].height = height;
+    pSurface->planes[0].stride = stride ? stride : (GCUint)(width * pInfo->bpp);
+    size = pSurface->planes[0].stride * height;
+
+    for(i = 1; i < pInfo->planes; i++)
+    {
+        SW_PLANE* pPlane = &pSurface->planes[i];
+
+        pPlane->width = width >> pInfo->hShift;
+        pPlane->height = height >> pInfo->vShift;
+        pPlane->stride = (pSurface->planes[0].stride >> pInfo->hShift) * (pInfo->planes == 2 ? 2 : 1);
+        size += pPlane->stride * pPlane->height;
+    }
+    return size;
+}
+
+static void _swPlaneAddresses(SW_SURFACE* pSurface, unsigned char* pBase, GCUPhysicalAddr physical)
+{
+    GCUuint i, offset = 0;
+
+    for(i = 0; i < pSurface->planeCount; i++)
+    {
+        pSurface->planes[i].pBase = pBase + offset;
+        pSurface->planes[i].physicalAddr = physical ? physical + offset : 0;
+        offset += pSurface->planes[i].stride * pSurface->planes[i].height;
+    }
+}
+
+GCUbool _swSurfaceAlloc(SW_SURFACE* pSurface)
+{
+    GCUuint alignW, alignH, size;
+    void* pMemory = GCU_NULL;
+
+    _swSurfaceAlignment(pSurface->tileType, &alignW, &alignH);
+    size = _swLayoutPlanes(pSurface, SW_ALIGN(pSurface->width, alignW),
+                           SW_ALIGN(pSurface->height, alignH), 0);
+
+    /* one spare row: callers writing through the mapping tend to overrun by a pixel */
+    if(posix_memalign(&pMemory, 64, size + pSurface->planes[0].stride + 64) != 0)
+    {
+        return GCU_FALSE;
+    }
+    memset(pMemory, 0, size + pSurface->planes[0].stride + 64);
+
+    pSurface->pMemory = pMemory;
+    pSurface->size = size;
+    _swPlaneAddresses(pSurface, (unsigned char*)pMemory,
+                      __sync_fetch_and_add(&s_nextPhysical, SW_ALIGN(size, 4096)));
+    return GCU_TRUE;
+}
+
+GCUbool _swSurfaceSetPlanes(SW_SURFACE* pSurface, GCU_ALLOC_INFO* pInfos, GCUuint count)
+{
+    const SW_FORMAT_INFO* pInfo = pSurface->pInfo;
+    GCUuint alignW, alignH, i;
+    GCUuint width = pInfos[0].width, height = pInfos[0].height;
+
+    _swSurfaceAlignment(pSurface->tileType, &alignW, &alignH);
+    if(width < pSurface->width)
+    {
+        width = SW_ALIGN(pSurface->width, alignW);
+    }
+    if(height < pSurface->height)
+    {
+        height = SW_ALIGN(pSurface->height, alignH);
+    }
+    if(pInfos[0].virtualAddr == GCU_NULL ||
+       (pInfos[0].stride != 0 && pInfos[0].stride < (GCUint)(pSurface->width * pInfo->bpp)))
+    {
+        return GCU_FALSE;
+    }
+
+    pSurface->size = _swLayoutPlanes(pSurface, width, height, pInfos[0].stride);
+    _swPlaneAddresses(pSurface, (unsigned char*)pInfos[0].virtualAddr, pInfos[0].physicalAddr);
+
+    /* planes given one by one */
+    for(i = 1; i < count && i < pSurface->planeCount; i++)
+    {
+        if(pInfos[i].virtualAddr == GCU_NULL)
+        {
+            return GCU_FALSE;
+        }
+        pSurface->planes[i].pBase = (unsigned char*)pInfos[i].virtualAddr;
+        pSurface->planes[i].physicalAddr = pInfos[i].physicalAddr;
+        if(pInfos[i].stride)
+        {
+            pSurface->planes[i].stride = pInfos[i].stride;
+        }
+    }
+    pSurface->bMappedPhysical = pInfos[0].bMappedPhysical;
+    return GCU_TRUE;
+}
@@ -0,0 +1,326 @@
+/***********************************************************************************
+ *
+ *    Copyright (c) 2009 - 2013 by Marvell International Ltd. and its affiliates.
+ *    All rights reserved.
+ *
+ *    This software file (the "File") is owned and distributed by Marvell
+ *    International Ltd. and/or its affiliates ("Marvell") under Marvell Commercial
+ *    License.
+ *
+ *    If you received this File from Marvell and you have entered into a commercial
+ *    license agreement (a "Commercial License") with Marvell, the File is licensed
+ *    to you under the terms of the applicable Commercial License.
+ *
+ *
+ ***********************************************************************************/
+
+/*!
+ ******************************************************************************
+ *  \file gcu_sw_util.c
+ *  \brief
+ *      File helpers of the software GCU: loading surfaces from bmp and raw
+ *      yuv files, and dumping surfaces for inspection or golden comparison.
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gcu_sw.h"
+
+#define SW_DUMP_PREFIXES        64
+
+typedef struct _SW_DUMP_COUNTER{
+    char        prefix[128];
+    GCUuint     count;
+}SW_DUMP_COUNTER;
+
+static pthread_mutex_t  s_dumpLock = PTHREAD_MUTEX_INITIALIZER;
+static SW_DUMP_COUNTER  s_dumpCounters[SW_DUMP_PREFIXES];
+
+static GCUuint _swRead16(const unsigned char* p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static GCUuint _swRead32(const unsigned char* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((GCUuint)p[3] << 24);
+}
+
+static void _swWrite16(unsigned char* p, GCUuint v)
+{
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+}
+
+static void _swWrite32(unsigned char* p, GCUuint v)
+{
+    _swWrite16(p, v);
+    _swWrite16(p + 2, v >> 16);
+}
+
+/* bytes per row and rows of each plane in a tightly packed yuv file */
+static void _swPackedPlaneSize(const SW_SURFACE* pSurface, GCUuint plane, GCUuint* pRowBytes, GCUuint* pRows)
+{
+    const SW_FORMAT_INFO* pInfo = pSurface->pInfo;
+
+    if(plane == 0)
+    {
+        *pRowBytes = pSurface->width * pInfo->bpp;
+        *pRows = pSurface->height;
+    }
+    else
+    {
+        *pRowBytes = (pSurface->width >> pInfo->hShift) * (pInfo->planes == 2 ? 2 : 1);
+        *pRows = pSurface->height >> pInfo->vShift;
+    }
+}
+
+GCUSurface _gcuLoadRGBSurfaceFromFile(GCUContext pContext, const char* filename)
+{
+    unsigned char header[54];
+    unsigned char* pRow = GCU_NULL;
+    SW_SURFACE* pSurface = GCU_NULL;
+    GCUVirtualAddr virtualAddr;
+    GCUPhysicalAddr physicalAddr;
+    GCUint width, height, bits, rowBytes, y, x;
+    GCUbool bTopDown;
+    FILE* fp;
+
+    if(filename == GCU_NULL || (fp = fopen(filename, "rb")) == GCU_NULL)
+    {
+        _swSetError(GCU_INVALID_PARAMETER, __FUNCTION__);
+        return GCU_NULL;
+    }
+    if(fread(header, 1, sizeof(header), fp) != sizeof(header) || header[0] != 'B' || header[1] != 'M')
+    {
+        goto OnError;
+    }
+
+    width = (GCUint)_swRead32(header + 18);
+    height = (GCUint)_swRead32(header + 22);
+    bits = _swRead16(header + 28);
+    bTopDown = height < 0;
+    height = bTopDown ? -height : height;
+    if(width <= 0 || height == 0 || (bits != 24 && bits != 32) || _swRead32(header + 30) != 0)
+    {
+        goto OnError;
+    }
+
+    pSurface = (SW_SURFACE*)_gcuCreateBuffer(pContext, width, height, GCU_FORMAT_ARGB8888,
+                                             &virtualAddr, &physicalAddr);
+    if(pSurface == GCU_NULL)
+    {
+        fclose(fp);
+        return GCU_NULL;
+    }
+
+    rowBytes = SW_ALIGN(width * bits / 8, 4);
+    pRow = (unsigned char*)malloc(rowBytes);
+    if(pRow == GCU_NULL || fseek(fp, _swRead32(header + 10), SEEK_SET) != 0)
+    {
+        goto OnError;
+    }
+    for(y = 0; y < height; y++)
+    {
+        uint32_t* pDst = (uint32_t*)(pSurface->planes[0].pBase +
+                                     (bTopDown ? y : height - 1 - y) * pSurface->planes[0].stride);
+
+        if(fread(pRow, 1, rowBytes, fp) != (size_t)rowBytes)
+        {
+            goto OnError;
+        }
+        for(x = 0; x < width; x++)
+        {
+            const unsigned char* p = pRow + x * bits / 8;
+
+            pDst[x] = p[0] | (p[1] << 8) | (p[2] << 16) | (bits == 32 ? (uint32_t)p[3] << 24 : 0xff000000);
+        }
+    }
+
+    free(pRow);
+    fclose(fp);
+    return pSurface;
+
+OnError:
+    free(pRow);
+    fclose(fp);
+    if(pSurface)
+    {
+        _gcuDestroyBuffer(pContext, pSurface);
+    }
+    _swSetError(GCU_INVALID_PARAMETER, __FUNCTION__);
+    return GCU_NULL;
+}
+
+GCUSurface _gcuLoadYUVSurfaceFromFile(GCUContext    pContext,
+                                      const char*   filename,
+                                      GCU_FORMAT    format,
+                                      GCUuint       width,
+                                      GCUuint       height)
+{
+    const SW_FORMAT_INFO* pInfo = _swGetFormatInfo(format);
+    SW_SURFACE* pSurface;
+    GCUVirtualAddr virtualAddr;
+    GCUPhysicalAddr physicalAddr;
+    GCUuint plane, y, rowBytes, rows;
+    FILE* fp;
+
+    if(filename == GCU_NULL || pInfo == GCU_NULL || !pInfo->bYUV)
+    {
+        _swSetError(GCU_INVALID_PARAMETER, __FUNCTION__);
+        return GCU_NULL;
+    }
+    if((fp = fopen(filename, "rb")) == GCU_NULL)
+    {
+        _swSetError(GCU_INVALID_PARAMETER, __FUNCTION__);
+        return GCU_NULL;
+    }
+
+    pSurface = (SW_SURFACE*)_gcuCreateBuffer(pContext, width, height, format, &virtualAddr, &physicalAddr);
+    if(pSurface == GCU_NULL)
+    {
+        fclose(fp);
+        return GCU_NULL;
+    }
+
+    /* the file has no row padding, the surface rows are aligned */
+    for(plane = 0; plane < pSurface->planeCount; plane++)
+    {
+        _swPackedPlaneSize(pSurface, plane, &rowBytes, &rows);
+        for(y = 0; y < rows; y++)
+        {
+            if(fread(pSurface->planes[plane].pBase + y * pSurface->planes[plane].stride, 1, rowBytes, fp) != rowBytes)
+            {
+                fclose(fp);
+                _gcuDestroyBuffer(pContext, pSurface);
+                _swSetError(GCU_INVALID_PARAMETER, __FUNCTION__);
+                return GCU_NULL;
+            }
+        }
+    }
+    fclose(fp);
+    return pSurface;
+}
+
+static GCUuint _swDumpIndex(const char* prefix)
+{
+    GCUuint i, index = 0;
+
+    pthread_mutex_lock(&s_dumpLock);
+    for(i = 0; i < SW_DUMP_PREFIXES; i++)
+    {
+        SW_DUMP_COUNTER* pCounter = &s_dumpCounters[i];
+
+        if(pCounter->prefix[0] == '\0')
+        {
+            strncpy(pCounter->prefix, prefix, sizeof(pCounter->prefix) - 1);
+        }
+        if(strncmp(pCounter->prefix, prefix, sizeof(pCounter->prefix) - 1) == 0)
+        {
+            index = pCounter->count++;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&s_dumpLock);
+    return index;
+}
+
+static GCUbool _swDumpBMP(SW_SURFACE* pSurface, FILE* fp)
+{
+    unsigned char header[54];
+    uint32_t* pRow;
+    GCUuint y, x, size = pSurface->width * pSurface->height * 4;
+    GCUbool bOk = GCU_TRUE;
+
+    memset(header, 0, sizeof(header));
+    header[0] = 'B';
+    header[1] = 'M';
+    _swWrite32(header + 2, sizeof(header) + size);
+    _swWrite32(header + 10, sizeof(header));
+    _swWrite32(header + 14, 40);
+    _swWrite32(header + 18, pSurface->width);
+    _swWrite32(header + 22, pSurface->height);
+    _swWrite16(header + 26, 1);
+    _swWrite16(header + 28, 32);
+    _swWrite32(header + 34, size);
+    if(fwrite(header, 1, sizeof(header), fp) != sizeof(header))
+    {
+        return GCU_FALSE;
+    }
+
+    pRow = (uint32_t*)malloc(pSurface->width * 4);
+    if(pRow == GCU_NULL)
+    {
+        return GCU_FALSE;
+    }
+    for(y = pSurface->height; y-- > 0 && bOk;)
+    {
+        unsigned char* p = (unsigned char*)pRow;
+
+        _swFetchRow(pSurface, 0, y, pSurface->width, pRow);
+        for(x = 0; x < pSurface->width; x++, p += 4)
+        {
+            _swWrite32(p, pRow[x]);
+        }
+        bOk = fwrite(pRow, 4, pSurface->width, fp) == pSurface->width;
+    }
+    free(pRow);
+    return bOk;
+}
+
+static GCUbool _swDumpYUV(SW_SURFACE* pSurface, FILE* fp)
+{
+    GCUuint plane, y, rowBytes, rows;
+
+    for(plane = 0; plane < pSurface->planeCount; plane++)
+    {
+        _swPackedPlaneSize(pSurface, plane, &rowBytes, &rows);
+        for(y = 0; y < rows; y++)
+        {
+            if(fwrite(pSurface->planes[plane].pBase + y * pSurface->planes[plane].stride, 1, rowBytes, fp) != rowBytes)
+            {
+                return GCU_FALSE;
+            }
+        }
+    }
+    return GCU_TRUE;
+}
+
+GCUbool _gcuDumpSurface(GCUContext pContext, GCUSurface pSurface, const char* prefix)
+{
+    SW_CONTEXT* pCtx = (SW_CONTEXT*)pContext;
+    SW_SURFACE* pSurf = (SW_SURFACE*)pSurface;
+    char filename[256];
+    GCUbool bOk;
+    FILE* fp;
+
+    if(pCtx == GCU_NULL || pCtx->magic != SW_CONTEXT_MAGIC ||
+       pSurf == GCU_NULL || pSurf->magic != SW_SURFACE_MAGIC || prefix == GCU_NULL)
+    {
+        _swSetError(GCU_INVALID_PARAMETER, __FUNCTION__);
+        return GCU_FALSE;
+    }
+
+    gcuFinish(pContext);
+    snprintf(filename, sizeof(filename), "%s_%u.%s", prefix, _swDumpIndex(prefix),
+             pSurf->pInfo->bYUV ? "yuv" : "bmp");
+    if((fp = fopen(filename, "wb")) == GCU_NULL)
+    {
+        _swSetError(GCU_INVALID_OPERATION, __FUNCTION__);
+        return GCU_FALSE;
+    }
+    bOk = pSurf->pInfo->bYUV ? _swDumpYUV(pSurf, fp) : _swDumpBMP(pSurf, fp);
+    fclose(fp);
+
+    if(!bOk)
+    {
+        _swSetError(GCU_INVALID_OPERATION, __FUNCTION__);
+    }
+    else if(_swDebug())
+    {
+        fprintf(stderr, "GCU: dumped %s\n", filename);
+    }
+    return bOk;
+}
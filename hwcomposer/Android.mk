@@ -46,6 +46,10 @@ ifeq ($(BOARD_ENABLE_WFD_OPTIMIZATION), true)
 LOCAL_SRC_FILES += \
     HWVirtualComposer.cpp \
     GcuEngine.cpp
+ifneq ($(BOARD_ENABLE_OVERLAY), true)
+LOCAL_SRC_FILES += \
+    HWCFenceManager.cpp
+endif
 endif
 
 LOCAL_C_INCLUDES := \
@@ -60,7 +64,10 @@ endif
 
 ifeq ($(BOARD_ENABLE_WFD_OPTIMIZATION), true)
 LOCAL_C_INCLUDES += \
-    frameworks/native/services 
+    frameworks/native/services \
+    vendor/marvell/generic/graphics/user/user/hal/inc \
+    vendor/marvell/generic/graphics/user/user/hal/user \
+    vendor/marvell/generic/graphics/user/user/hal/os/linux/user
 endif
 
 LOCAL_PRELINK_MODULE := false
@@ -77,6 +84,9 @@ LOCAL_SHARED_LIBRARIES := \
         libhardware_legacy
 
 ifeq ($(BOARD_ENABLE_OVERLAY), true)
+LOCAL_SHARED_LIBRARIES += libbinder \
+                          libsync
+else ifeq ($(BOARD_ENABLE_WFD_OPTIMIZATION), true)
 LOCAL_SHARED_LIBRARIES += libbinder \
                           libsync
 endif
@@ -91,6 +101,8 @@ endif
 
 ifeq ($(BOARD_ENABLE_WFD_OPTIMIZATION), true)
 LOCAL_CFLAGS += -DENABLE_WFD_OPTIMIZATION
+# gc_gralloc_priv.h pulls in the GC HAL headers.
+LOCAL_CFLAGS += -DLINUX
 endif
 
 ifeq ($(ENABLE_HWC_GC_PATH), true)
@@ -135,3 +147,45 @@ LOCAL_CFLAGS += -DPLATFORM_SDK_VERSION=$(PLATFORM_SDK_VERSION)
 LOCAL_MODULE_TAGS := optional
 
 # include $(BUILD_EXECUTABLE)
+
+# GcuEngine surface cache test, libgcu is mocked by the test itself.
+ifeq ($(BOARD_ENABLE_WFD_OPTIMIZATION), true)
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES := \
+    GcuEngineTest.cpp \
+    GcuEngine.cpp
+
+LOCAL_C_INCLUDES := \
+    hardware/libhardware/include \
+    frameworks/native/services \
+    vendor/marvell/generic/graphics/user/include
+
+LOCAL_CFLAGS += -g -DLOG_TAG=\"GcuEngineTest\"
+
+LOCAL_SHARED_LIBRARIES := liblog libcutils libutils libui
+LOCAL_MODULE := GcuEngineTest
+LOCAL_MODULE_TAGS := tests
+
+include $(BUILD_EXECUTABLE)
+
+# blocking against fenced GcuEngine submission, on a timed libgcu mock.
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES := \
+    GcuEngineBench.cpp \
+    GcuEngine.cpp
+
+LOCAL_C_INCLUDES := \
+    hardware/libhardware/include \
+    frameworks/native/services \
+    vendor/marvell/generic/graphics/user/include
+
+LOCAL_CFLAGS += -g -DLOG_TAG=\"GcuEngineBench\"
+
+LOCAL_SHARED_LIBRARIES := liblog libcutils libutils libui
+LOCAL_MODULE := GcuEngineBench
+LOCAL_MODULE_TAGS := tests
+
+include $(BUILD_EXECUTABLE)
+endif
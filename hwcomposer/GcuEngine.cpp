@@ -28,6 +28,8 @@
 #include <utils/SortedVector.h>
 #include <utils/String8.h>
 #include <utils/Mutex.h>
+#include <utils/Timers.h>
+#include <unistd.h>
 #include <hardware/hardware.h>
 #include <hardware/hwcomposer.h>
 #include <surfaceflinger/Transform.h>
@@ -37,9 +39,17 @@ using namespace android;
 
 GcuEngine::GcuEngine() : mGCUContextPtr(NULL)
                        , mFlushAtEnd(false)
+                       , mDeferred(false)
+                       , mPendingBlits(0)
                        , mAndPatternPtr(NULL)
                        , mOrPatternPtr(NULL)
+                       , mCacheStamp(0)
+                       , mCacheHits(0)
+                       , mCacheMisses(0)
+                       , mCacheEvictions(0)
 {
+    memset(mSurfaceCache, 0, sizeof(mSurfaceCache));
+
     if(!Init()) {
         LOGE("GcuEngine initialization failed!");
     }
@@ -47,6 +57,13 @@ GcuEngine::GcuEngine() : mGCUContextPtr(NULL)
 
 GcuEngine::~GcuEngine()
 {
+    if(mPendingBlits > 0){
+        gcuFinish(mGCUContextPtr);
+        mPendingBlits = 0;
+    }
+
+    InvalidateAllSurfaces();
+
     if (NULL != mAndPatternPtr){
         gcuDestroySurface(mGCUContextPtr, mAndPatternPtr);
     }
@@ -158,6 +175,7 @@ bool GcuEngine::Blit(PBlitDataDesc blitDesc)
 {
     blitDesc->dump();
 
+    Mutex::Autolock lock(mContextLock);
     bool result = false;
 #if HARDWARE_ENGINE_SWITCH
     gceHARDWARE_TYPE hardware_type;
@@ -215,7 +233,9 @@ bool GcuEngine::RopBlit(PBlitDataDesc blitDesc)
     GCU_RECT srcRect, dstRect, patRect;
     //getRects(blitDesc, srcRect, dstRect);
     GCUSurface pSrcSurface = NULL, pDstSurface = NULL;
-    getSurfaces(blitDesc, pSrcSurface, pDstSurface);
+    if(!getSurfaces(blitDesc, pSrcSurface, pDstSurface)){
+        return false;
+    }
 
     srcRect.left   = 0;
     srcRect.right  = 1;
@@ -245,11 +265,9 @@ bool GcuEngine::RopBlit(PBlitDataDesc blitDesc)
 
     gcuSet(mGCUContextPtr, GCU_QUALITY, GCU_QUALITY_NORMAL);
     gcuRop(mGCUContextPtr, &bltData);
-    gcuFinish(mGCUContextPtr);
+    finishBlit();
 
     gcuSet(mGCUContextPtr, GCU_QUALITY, GCU_QUALITY_HIGH);
-    gcuDestroySurface(mGCUContextPtr, pSrcSurface);
-    gcuDestroySurface(mGCUContextPtr, pDstSurface);
 
     return true;
 }
@@ -260,7 +278,9 @@ bool GcuEngine::FilterBlit(PBlitDataDesc blitDesc)
     GCU_RECT srcRect, dstRect;
     getRects(blitDesc, srcRect, dstRect);
     GCUSurface pSrcSurface = NULL, pDstSurface = NULL;
-    getSurfaces(blitDesc, pSrcSurface, pDstSurface);
+    if(!getSurfaces(blitDesc, pSrcSurface, pDstSurface)){
+        return false;
+    }
 
     memset(&bltData, 0, sizeof(bltData));
     bltData.pSrcSurface = pSrcSurface;
@@ -269,11 +289,8 @@ bool GcuEngine::FilterBlit(PBlitDataDesc blitDesc)
     bltData.pDstRect = &dstRect;
     bltData.rotation = getGCURotation(blitDesc->mRotationDegree);
 
-    gcuBlit(mGCUContextPtr, &bltData);
-    gcuFinish(mGCUContextPtr);
-
-    gcuDestroySurface(mGCUContextPtr, pSrcSurface);
-    gcuDestroySurface(mGCUContextPtr, pDstSurface);
+    blitSubRects(bltData, blitDesc);
+    finishBlit();
 
     return true;
 }
@@ -285,7 +302,9 @@ bool GcuEngine::SrcBlit(PBlitDataDesc blitDesc)
     getRects(blitDesc, srcRect, dstRect);
 
     GCUSurface pSrcSurface = NULL, pDstSurface = NULL;
-    getSurfaces(blitDesc, pSrcSurface, pDstSurface);
+    if(!getSurfaces(blitDesc, pSrcSurface, pDstSurface)){
+        return false;
+    }
 
     memset(&bltData, 0, sizeof(bltData));
     bltData.pSrcSurface = pSrcSurface;
@@ -295,11 +314,8 @@ bool GcuEngine::SrcBlit(PBlitDataDesc blitDesc)
     bltData.pDstRect = &dstRect;
     bltData.rotation = getGCURotation(blitDesc->mRotationDegree);
 
-    gcuBlit(mGCUContextPtr, &bltData);
-    gcuFinish(mGCUContextPtr);
-
-    gcuDestroySurface(mGCUContextPtr, pSrcSurface);
-    gcuDestroySurface(mGCUContextPtr, pDstSurface);
+    blitSubRects(bltData, blitDesc);
+    finishBlit();
 
     return true;
 }
@@ -315,14 +331,14 @@ bool GcuEngine::FillBlit(PBlitDataDesc blitDesc)
     dstRect.bottom = blitDesc->mDstRect->b;
 
 
-    GCUSurface pDstSurface = _gcuCreatePreAllocBuffer(mGCUContextPtr,
-                                                      blitDesc->mDstWidth,
-                                                      blitDesc->mDstHeight,
-                                                      getGCUFormat(blitDesc->mDstFormat),
-                                                      GCU_TRUE,
-                                                      (void*)0x1000, //fakeVirtualAddr,
-                                                      GCU_TRUE,
-                                                      blitDesc->mDstAddr);
+    GCUSurface pDstSurface = getCachedSurface(blitDesc->mDstAddr,
+                                              blitDesc->mDstWidth,
+                                              blitDesc->mDstHeight,
+                                              getGCUFormat(blitDesc->mDstFormat));
+    if(NULL == pDstSurface){
+        return false;
+    }
+
     memset(&fillData, 0, sizeof(fillData));
     if (blitDesc->mIsSolidFill) {
         fillData.bSolidColor = GCU_TRUE;
@@ -338,12 +354,104 @@ bool GcuEngine::FillBlit(PBlitDataDesc blitDesc)
     }
 
     gcuFill(mGCUContextPtr, &fillData);
-    gcuFinish(mGCUContextPtr);
-    gcuDestroySurface(mGCUContextPtr, pDstSurface);
+    finishBlit();
 
     return true;
 }
 
+void GcuEngine::blitSubRects(GCU_BLT_DATA &bltData, PBlitDataDesc blitDesc)
+{
+    if(NULL == blitDesc->mDstSubRect || 0 == blitDesc->mRectCount){
+        gcuBlit(mGCUContextPtr, &bltData);
+        return;
+    }
+
+    ///< src/dst rects stay the same so the scale factor does not change, only clip differs.
+    GCU_RECT clipRect;
+    for(uint32_t i = 0; i < blitDesc->mRectCount; ++i){
+        clipRect.left   = blitDesc->mDstSubRect[i].l;
+        clipRect.right  = blitDesc->mDstSubRect[i].r;
+        clipRect.top    = blitDesc->mDstSubRect[i].t;
+        clipRect.bottom = blitDesc->mDstSubRect[i].b;
+
+        if(clipRect.left >= clipRect.right || clipRect.top >= clipRect.bottom){
+            continue;
+        }
+
+        bltData.pClipRect = &clipRect;
+        gcuBlit(mGCUContextPtr, &bltData);
+    }
+    bltData.pClipRect = NULL;
+}
+
+void GcuEngine::finishBlit()
+{
+    if(mDeferred){
+        ///< leave it in the command buffer, Submit() will kick it off.
+        ++mPendingBlits;
+        return;
+    }
+
+    gcuFinish(mGCUContextPtr);
+}
+
+void GcuEngine::SetDeferred(bool bDeferred)
+{
+    Mutex::Autolock lock(mContextLock);
+    if(mDeferred == bDeferred){
+        return;
+    }
+
+    if(mPendingBlits > 0){
+        gcuFinish(mGCUContextPtr);
+        mPendingBlits = 0;
+    }
+
+    mDeferred = bDeferred;
+}
+
+GCUFence GcuEngine::Submit()
+{
+    Mutex::Autolock lock(mContextLock);
+    if(0 == mPendingBlits){
+        return NULL;
+    }
+
+    mPendingBlits = 0;
+
+    GCUFence pFence = gcuCreateFence(mGCUContextPtr);
+    if(NULL == pFence || !gcuSendFence(mGCUContextPtr, pFence)){
+        LOGE("ERROR: GCU send fence failed, wait for idle instead!");
+        if(NULL != pFence){
+            gcuDestroyFence(mGCUContextPtr, pFence);
+        }
+        gcuFinish(mGCUContextPtr);
+        return NULL;
+    }
+
+    gcuFlush(mGCUContextPtr);
+    return pFence;
+}
+
+bool GcuEngine::WaitFence(GCUFence pFence, uint32_t timeoutMs)
+{
+    if(NULL == pFence){
+        return true;
+    }
+
+    ///< a blit queued meanwhile only waits while the GPU is still behind on this fence.
+    Mutex::Autolock lock(mContextLock);
+    bool bSignaled = (GCU_TRUE == gcuWaitFence(mGCUContextPtr, pFence, timeoutMs));
+    if(!bSignaled){
+        ///< the caller hands the buffers back next, they must not be written any more.
+        LOGE("ERROR: GCU fence %p not signaled in %d ms, wait for idle!", pFence, timeoutMs);
+        gcuFinish(mGCUContextPtr);
+    }
+
+    gcuDestroyFence(mGCUContextPtr, pFence);
+    return bSignaled;
+}
+
 void GcuEngine::getRects(PBlitDataDesc blitDesc, GCU_RECT &srcRect, GCU_RECT &dstRect)
 {
     srcRect.left   = blitDesc->mSrcRect->l;
@@ -360,31 +468,131 @@ void GcuEngine::getRects(PBlitDataDesc blitDesc, GCU_RECT &srcRect, GCU_RECT &ds
 
 bool GcuEngine::getSurfaces(PBlitDataDesc blitDesc, GCUSurface &pSrcSurface, GCUSurface &pDstSurface)
 {
-    GCUuint srcWidth  = blitDesc->mSrcWidth;
-    GCUuint srcHeight = blitDesc->mSrcHeight;
-    GCUuint dstWidth  = blitDesc->mDstWidth;
-    GCUuint dstHeight = blitDesc->mDstHeight;
+    pSrcSurface = getCachedSurface(blitDesc->mSrcAddr,
+                                   blitDesc->mSrcWidth,
+                                   blitDesc->mSrcHeight,
+                                   getGCUFormat(blitDesc->mSrcFormat));
+
+    pDstSurface = getCachedSurface(blitDesc->mDstAddr,
+                                   blitDesc->mDstWidth,
+                                   blitDesc->mDstHeight,
+                                   getGCUFormat(blitDesc->mDstFormat));
+
+    return (NULL != pSrcSurface) && (NULL != pDstSurface);
+}
+
+GCUSurface GcuEngine::getCachedSurface(uint32_t physAddr, uint32_t width, uint32_t height, GCU_FORMAT format)
+{
+    SurfaceCacheEntry* pVictim = &mSurfaceCache[0];
+
+    ++mCacheStamp;
+    for(uint32_t i = 0; i < MAX_CACHED_SURFACES; ++i){
+        SurfaceCacheEntry* pEntry = &mSurfaceCache[i];
+        if(NULL != pEntry->surface
+           && pEntry->physAddr == physAddr
+           && pEntry->width == width
+           && pEntry->height == height
+           && pEntry->format == format){
+            pEntry->lastUsed = mCacheStamp;
+            ++mCacheHits;
+            return pEntry->surface;
+        }
+
+        ///< prefer an empty slot, otherwise the least recently used one.
+        if(NULL != pVictim->surface
+           && (NULL == pEntry->surface || pEntry->lastUsed < pVictim->lastUsed)){
+            pVictim = pEntry;
+        }
+    }
+
+    ++mCacheMisses;
+    if(NULL != pVictim->surface){
+        if(mDeferred){
+            ///< the victim may still be referenced by in-flight commands.
+            gcuFinish(mGCUContextPtr);
+        }
+        gcuDestroySurface(mGCUContextPtr, pVictim->surface);
+        pVictim->surface = NULL;
+        ++mCacheEvictions;
+    }
 
     void *fakeVirtualAddr = (void *)0x1000;
+    GCUSurface pSurface = _gcuCreatePreAllocBuffer(mGCUContextPtr,
+                                                   width,
+                                                   height,
+                                                   format,
+                                                   GCU_TRUE,
+                                                   fakeVirtualAddr,
+                                                   GCU_TRUE,
+                                                   physAddr);
+    if(NULL == pSurface){
+        LOGE("ERROR: wrap physAddr 0x%x (%dx%d, fmt %d) failed!", physAddr, width, height, format);
+        return NULL;
+    }
 
-    pSrcSurface = _gcuCreatePreAllocBuffer(mGCUContextPtr,
-                                           srcWidth,
-                                           srcHeight,
-                                           getGCUFormat(blitDesc->mSrcFormat),
-                                           GCU_TRUE,
-                                           fakeVirtualAddr,
-                                           GCU_TRUE,
-                                           blitDesc->mSrcAddr);
-
-    pDstSurface = _gcuCreatePreAllocBuffer(mGCUContextPtr,
-                                           dstWidth,
-                                           dstHeight,
-                                           getGCUFormat(blitDesc->mDstFormat),
-                                           GCU_TRUE,
-                                           fakeVirtualAddr,
-                                           GCU_TRUE,
-                                           blitDesc->mDstAddr);
-    return true;
+    pVictim->physAddr = physAddr;
+    pVictim->width    = width;
+    pVictim->height   = height;
+    pVictim->format   = format;
+    pVictim->surface  = pSurface;
+    pVictim->lastUsed = mCacheStamp;
+
+    return pSurface;
+}
+
+void GcuEngine::InvalidateSurface(uint32_t physAddr)
+{
+    Mutex::Autolock lock(mContextLock);
+    if(mDeferred){
+        gcuFinish(mGCUContextPtr);
+    }
+
+    for(uint32_t i = 0; i < MAX_CACHED_SURFACES; ++i){
+        SurfaceCacheEntry* pEntry = &mSurfaceCache[i];
+        if(NULL != pEntry->surface && pEntry->physAddr == physAddr){
+            gcuDestroySurface(mGCUContextPtr, pEntry->surface);
+            memset(pEntry, 0, sizeof(SurfaceCacheEntry));
+        }
+    }
+}
+
+void GcuEngine::InvalidateAllSurfaces()
+{
+    Mutex::Autolock lock(mContextLock);
+    if(mDeferred){
+        gcuFinish(mGCUContextPtr);
+    }
+
+    for(uint32_t i = 0; i < MAX_CACHED_SURFACES; ++i){
+        SurfaceCacheEntry* pEntry = &mSurfaceCache[i];
+        if(NULL != pEntry->surface){
+            gcuDestroySurface(mGCUContextPtr, pEntry->surface);
+        }
+        memset(pEntry, 0, sizeof(SurfaceCacheEntry));
+    }
+}
+
+void GcuEngine::dump(String8& result, char* buffer, int size)
+{
+    Mutex::Autolock lock(mContextLock);
+    uint32_t nCached = 0;
+    for(uint32_t i = 0; i < MAX_CACHED_SURFACES; ++i){
+        if(NULL != mSurfaceCache[i].surface)
+            ++nCached;
+    }
+
+    snprintf(buffer, size, "    [GCU Surface Cache] : [%d/%d] entries, hit %u, miss %u, evict %u.\n",
+             nCached, MAX_CACHED_SURFACES, mCacheHits, mCacheMisses, mCacheEvictions);
+    result.append(buffer);
+
+    for(uint32_t i = 0; i < MAX_CACHED_SURFACES; ++i){
+        SurfaceCacheEntry* pEntry = &mSurfaceCache[i];
+        if(NULL != pEntry->surface){
+            snprintf(buffer, size, "        [%d] physAddr 0x%08x, %dx%d, fmt %d\n",
+                     i, pEntry->physAddr, pEntry->width, pEntry->height, pEntry->format);
+            result.append(buffer);
+        }
+    }
 }
 
 GCU_ROTATION GcuEngine::getGCURotation(uint32_t rotationDegree)
@@ -456,6 +664,7 @@ bool GcuEngine::LoadHintPic(uint32_t id, const char* fileName)
         return false;
     }
 
+    Mutex::Autolock lock(mContextLock);
     GCUSurface pSuface = _gcuLoadRGBSurfaceFromFile(mGCUContextPtr, fileName);
     if(NULL != pSuface){
         mHintSurface[id] = pSuface;
@@ -468,6 +677,7 @@ bool GcuEngine::LoadHintPic(uint32_t id, const char* fileName)
 
 bool GcuEngine::BlitHintPic(uint32_t id, PBlitDataDesc blitDesc)
 {
+    Mutex::Autolock lock(mContextLock);
     if(id >= MAX_HINT_PICS || NULL == mHintSurface[id]){
         LOGE("ERROR: HINT id(%d), mHintSurface[%d] = %p.", id, id, mHintSurface[id]);
         return false;
@@ -477,10 +687,15 @@ bool GcuEngine::BlitHintPic(uint32_t id, PBlitDataDesc blitDesc)
     GCU_RECT srcRect, dstRect;
     getRects(blitDesc, srcRect, dstRect);
 
-    GCUSurface pSrcSurface = NULL, pDstSurface = NULL;
-    getSurfaces(blitDesc, pSrcSurface, pDstSurface);
+    GCUSurface pSrcSurface = mHintSurface[id];
+    GCUSurface pDstSurface = getCachedSurface(blitDesc->mDstAddr,
+                                              blitDesc->mDstWidth,
+                                              blitDesc->mDstHeight,
+                                              getGCUFormat(blitDesc->mDstFormat));
+    if(NULL == pDstSurface){
+        return false;
+    }
 
-    pSrcSurface = mHintSurface[id];
     GCU_SURFACE_DATA surfaceData;
     gcuQuerySurfaceInfo(mGCUContextPtr, pSrcSurface, &surfaceData);
 
@@ -503,9 +718,7 @@ bool GcuEngine::BlitHintPic(uint32_t id, PBlitDataDesc blitDesc)
     bltData.rotation = getGCURotation(blitDesc->mRotationDegree);
 
     gcuBlit(mGCUContextPtr, &bltData);
-    gcuFinish(mGCUContextPtr);
-
-    gcuDestroySurface(mGCUContextPtr, pDstSurface);
+    finishBlit();
 
     return true;
 }
@@ -48,6 +48,10 @@ extern "C" {
 
 #define MAX_HINT_PICS       1
 
+///< wrapped GCU surfaces kept alive across blits, enough for FB target
+///< double buffering plus the WFD output buffer queue.
+#define MAX_CACHED_SURFACES 8
+
 /*
  * Refer to Surface.java(frameworks/base/core/java/android/view/).
  * Use the same definitions in Surface.java because DisplayDevice uses
@@ -259,10 +263,30 @@ public:
 
     void    Flush();
 
+    ///< in deferred mode blits are only queued, call Submit() to kick them off.
+    void    SetDeferred(bool bDeferred);
+
+    bool    IsDeferred() const { return mDeferred; }
+
+    ///< flush queued blits, return a fence sent behind them (NULL if nothing queued or on error).
+    GCUFence Submit();
+
+    ///< wait for a fence returned by Submit() and destroy it, may be called from another thread.
+    ///< on timeout it waits for the GCU to go idle before returning false.
+    bool    WaitFence(GCUFence pFence, uint32_t timeoutMs);
+
     bool    LoadHintPic(uint32_t id, const char* fileName);
 
     bool    BlitHintPic(uint32_t id, PBlitDataDesc blitDesc);
 
+    ///< drop cached surface(s) wrapping the given physical address.
+    void    InvalidateSurface(uint32_t physAddr);
+
+    ///< drop all cached surfaces.
+    void    InvalidateAllSurfaces();
+
+    void    dump(String8& result, char* buffer, int size);
+
 protected:
     bool    FilterBlit(PBlitDataDesc blitDesc);
     bool    SrcBlit(PBlitDataDesc blitDesc);
@@ -281,18 +305,48 @@ private:
                                GCU_RECT &srcRect,
                                GCU_RECT &dstRect);
 
+    ///< issue the blit once per dst sub rect (clipped), or once if none given.
+    void           blitSubRects(GCU_BLT_DATA &bltData, PBlitDataDesc blitDesc);
+
+    ///< wait for the blit unless in deferred mode.
+    void           finishBlit();
+
     ///< create a tiny buffer to do ROP.
     void           preparePatternSurfaces();
 
+    ///< look up (or wrap and insert) a pre-allocated surface.
+    GCUSurface     getCachedSurface(uint32_t physAddr,
+                                    uint32_t width,
+                                    uint32_t height,
+                                    GCU_FORMAT format);
+
 private:
+    typedef struct _SurfaceCacheEntry
+    {
+        uint32_t    physAddr;
+        uint32_t    width;
+        uint32_t    height;
+        GCU_FORMAT  format;
+        GCUSurface  surface;
+        uint32_t    lastUsed;
+    }SurfaceCacheEntry;
 
     GCUContext     mGCUContextPtr;
+    ///< every public entry touching mGCUContextPtr holds it, the context is not thread safe.
+    Mutex          mContextLock;
     bool           mFlushAtEnd;
+    bool           mDeferred;
+    uint32_t       mPendingBlits;
     GCUSurface     mAndPatternPtr;
     GCUSurface     mOrPatternPtr;
 
     GCUSurface     mHintSurface[MAX_HINT_PICS];
 
+    SurfaceCacheEntry mSurfaceCache[MAX_CACHED_SURFACES];
+    uint32_t       mCacheStamp;
+    uint32_t       mCacheHits;
+    uint32_t       mCacheMisses;
+    uint32_t       mCacheEvictions;
 };
 
 #ifdef __cplusplus
@@ -0,0 +1,385 @@
+/*
+* (C) Copyright 2010 Marvell International Ltd.
+* All Rights Reserved
+*
+* MARVELL CONFIDENTIAL
+* Copyright 2008 ~ 2010 Marvell International Ltd All Rights Reserved.
+* The source code contained or described herein and all documents related to
+* the source code ("Material") are owned by Marvell International Ltd or its
+* suppliers or licensors. Title to the Material remains with Marvell International Ltd
+* or its suppliers and licensors. The Material contains trade secrets and
+* proprietary and confidential information of Marvell or its suppliers and
+* licensors. The Material is protected by worldwide copyright and trade secret
+* laws and treaty provisions. No part of the Material may be used, copied,
+* reproduced, modified, published, uploaded, posted, transmitted, distributed,
+* or disclosed in any way without Marvell's prior express written permission.
+*
+* No license under any patent, copyright, trade secret or other intellectual
+* property right is granted to or conferred upon you by disclosure or delivery
+* of the Materials, either expressly, by implication, inducement, estoppel or
+* otherwise. Any license under such intellectual property rights must be
+* express and approved by Marvell in writing.
+*
+*/
+
+/*
+ * Latency of a WFD frame blit, blocking against fenced submission.
+ *
+ * libgcu is replaced by the mock below: the GPU is a timeline that runs the
+ * flushed blits one after the other, each taking the given time, and a fence
+ * signals when the timeline reaches it. Every frame period the composer
+ * thread blits one frame:
+ *  - blocking: Blit() waits for gcuFinish(), as before the release fence.
+ *  - fenced: Blit() only queues, Submit() sends a fence and a worker thread
+ *    waits for it, as GcuFenceWorker does.
+ * For each mode it prints how long the composer thread was held per frame
+ * (compose) and when the frame was done on the GPU (release), p50 and p99.
+ *
+ * Usage: GcuEngineBench [-n frames] [-g gpu us per frame] [-p period us]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "GcuEngine.h"
+
+using namespace android;
+
+#define BENCH_MAX_FRAMES    10000
+#define BENCH_QUEUE_SIZE    16
+
+static struct
+{
+    pthread_mutex_t lock;
+    nsecs_t         busyUntil;          ///< when the GPU is done with what was flushed
+    nsecs_t         queuedNs;           ///< blits queued but not flushed yet
+    nsecs_t         blitNs;             ///< GPU time of one blit
+}g_gpu = {PTHREAD_MUTEX_INITIALIZER, 0, 0, 0};
+
+typedef struct _MockFence
+{
+    nsecs_t         doneAt;
+}MockFence;
+
+static void sleep_until(nsecs_t when)
+{
+    nsecs_t now = systemTime();
+    if(when > now){
+        usleep((useconds_t)((when - now) / 1000));
+    }
+}
+
+///< start what is queued behind what the GPU already has.
+static nsecs_t gpu_flush()
+{
+    pthread_mutex_lock(&g_gpu.lock);
+    nsecs_t now = systemTime();
+    if(g_gpu.queuedNs > 0){
+        g_gpu.busyUntil = ((g_gpu.busyUntil > now) ? g_gpu.busyUntil : now) + g_gpu.queuedNs;
+        g_gpu.queuedNs = 0;
+    }
+    nsecs_t doneAt = g_gpu.busyUntil;
+    pthread_mutex_unlock(&g_gpu.lock);
+    return doneAt;
+}
+
+static void gpu_queue(nsecs_t ns)
+{
+    pthread_mutex_lock(&g_gpu.lock);
+    g_gpu.queuedNs += ns;
+    pthread_mutex_unlock(&g_gpu.lock);
+}
+
+/*
+ * the subset of gcu.h GcuEngine uses.
+ */
+GCUbool gcuInitialize(GCU_INIT_DATA* pData)
+{
+    return GCU_TRUE;
+}
+
+GCUvoid gcuTerminate()
+{
+}
+
+GCUContext gcuCreateContext(GCU_CONTEXT_DATA* pData)
+{
+    return (GCUContext)&g_gpu;
+}
+
+GCUvoid gcuDestroyContext(GCUContext pContext)
+{
+}
+
+GCUenum gcuGetError()
+{
+    return GCU_NO_ERROR;
+}
+
+GCUbool gcuSet(GCUContext pContext, GCU_STATE_TYPE state, GCUint value)
+{
+    return GCU_TRUE;
+}
+
+GCUSurface _gcuCreateBuffer(GCUContext pContext, GCUuint width, GCUuint height,
+                            GCU_FORMAT format, GCUVirtualAddr* pVirtAddr,
+                            GCUPhysicalAddr* pPhysicalAddr)
+{
+    *pVirtAddr = NULL;
+    *pPhysicalAddr = 0;
+    return (GCUSurface)malloc(1);
+}
+
+GCUSurface _gcuCreatePreAllocBuffer(GCUContext pContext, GCUuint width, GCUuint height,
+                                    GCU_FORMAT format, GCUbool bPreAllocVirtual,
+                                    GCUVirtualAddr virtualAddr, GCUbool bPreAllocPhysical,
+                                    GCUPhysicalAddr physicalAddr)
+{
+    return (GCUSurface)malloc(1);
+}
+
+GCUSurface _gcuLoadRGBSurfaceFromFile(GCUContext pContext, const char* filename)
+{
+    return NULL;
+}
+
+GCUbool gcuQuerySurfaceInfo(GCUContext pContext, GCUSurface pSurface, GCU_SURFACE_DATA* pData)
+{
+    memset(pData, 0, sizeof(*pData));
+    return GCU_TRUE;
+}
+
+GCUvoid gcuDestroySurface(GCUContext pContext, GCUSurface pSurface)
+{
+    free(pSurface);
+}
+
+GCUvoid gcuFill(GCUContext pContext, GCU_FILL_DATA* pData)
+{
+}
+
+GCUvoid gcuBlit(GCUContext pContext, GCU_BLT_DATA* pData)
+{
+    gpu_queue(g_gpu.blitNs);
+}
+
+GCUvoid gcuRop(GCUContext pContext, GCU_ROP_DATA* pData)
+{
+    gpu_queue(g_gpu.blitNs);
+}
+
+GCUvoid gcuFlush(GCUContext pContext)
+{
+    gpu_flush();
+}
+
+GCUvoid gcuFinish(GCUContext pContext)
+{
+    sleep_until(gpu_flush());
+}
+
+GCUFence gcuCreateFence(GCUContext pContext)
+{
+    return (GCUFence)calloc(1, sizeof(MockFence));
+}
+
+GCUvoid gcuDestroyFence(GCUContext pContext, GCUFence pFence)
+{
+    free(pFence);
+}
+
+GCUbool gcuSendFence(GCUContext pContext, GCUFence pFence)
+{
+    ((MockFence*)pFence)->doneAt = gpu_flush();
+    return GCU_TRUE;
+}
+
+GCUbool gcuWaitFence(GCUContext pContext, GCUFence pFence, GCUuint wait_time_ms)
+{
+    nsecs_t doneAt = ((MockFence*)pFence)->doneAt;
+    nsecs_t deadline = systemTime() + milliseconds_to_nanoseconds(wait_time_ms);
+    sleep_until((doneAt < deadline) ? doneAt : deadline);
+    return (systemTime() >= doneAt) ? GCU_TRUE : GCU_FALSE;
+}
+
+/*
+ * the fence worker: waits for the fences in order and stamps the frames.
+ */
+static struct
+{
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    GCUFence        fences[BENCH_QUEUE_SIZE];
+    int             frames[BENCH_QUEUE_SIZE];
+    int             head;
+    int             count;
+    bool            exit;
+    GcuEngine*      pEngine;
+    nsecs_t*        pReleased;
+    int             timeouts;
+}g_worker;
+
+static void* worker_loop(void* arg)
+{
+    pthread_mutex_lock(&g_worker.lock);
+    for(;;){
+        while(0 == g_worker.count && !g_worker.exit){
+            pthread_cond_wait(&g_worker.cond, &g_worker.lock);
+        }
+        if(0 == g_worker.count){
+            break;
+        }
+        GCUFence pFence = g_worker.fences[g_worker.head];
+        int frame = g_worker.frames[g_worker.head];
+        pthread_mutex_unlock(&g_worker.lock);
+
+        if(!g_worker.pEngine->WaitFence(pFence, 1000)){
+            ++g_worker.timeouts;
+        }
+        g_worker.pReleased[frame] = systemTime();
+
+        pthread_mutex_lock(&g_worker.lock);
+        g_worker.head = (g_worker.head + 1) % BENCH_QUEUE_SIZE;
+        --g_worker.count;
+        pthread_cond_broadcast(&g_worker.cond);
+    }
+    pthread_mutex_unlock(&g_worker.lock);
+    return NULL;
+}
+
+static void worker_queue(GCUFence pFence, int frame)
+{
+    pthread_mutex_lock(&g_worker.lock);
+    while(BENCH_QUEUE_SIZE == g_worker.count){
+        pthread_cond_wait(&g_worker.cond, &g_worker.lock);
+    }
+    int tail = (g_worker.head + g_worker.count) % BENCH_QUEUE_SIZE;
+    g_worker.fences[tail] = pFence;
+    g_worker.frames[tail] = frame;
+    ++g_worker.count;
+    pthread_cond_broadcast(&g_worker.cond);
+    pthread_mutex_unlock(&g_worker.lock);
+}
+
+static int compare_ns(const void* a, const void* b)
+{
+    nsecs_t x = *(const nsecs_t*)a;
+    nsecs_t y = *(const nsecs_t*)b;
+    return (x < y) ? -1 : (x > y);
+}
+
+static void report(const char* name, const char* what, nsecs_t* pNs, int frames)
+{
+    qsort(pNs, frames, sizeof(nsecs_t), compare_ns);
+    printf("%-9s %-8s p50 %8.1f us, p99 %8.1f us\n", name, what,
+           pNs[frames / 2] / 1000.0, pNs[(frames * 99) / 100] / 1000.0);
+}
+
+static DISP_RECT g_rect = {0, 0, 1280, 720};
+
+static void run(const char* name, bool bFenced, int frames, nsecs_t periodNs)
+{
+    static nsecs_t start[BENCH_MAX_FRAMES];
+    static nsecs_t composed[BENCH_MAX_FRAMES];
+    static nsecs_t released[BENCH_MAX_FRAMES];
+    pthread_t worker;
+
+    GcuEngine engine;
+    engine.SetDeferred(bFenced);
+
+    memset(&g_worker.fences, 0, sizeof(g_worker.fences));
+    g_worker.head = g_worker.count = g_worker.timeouts = 0;
+    g_worker.exit = false;
+    g_worker.pEngine = &engine;
+    g_worker.pReleased = released;
+    if(bFenced){
+        pthread_create(&worker, NULL, worker_loop, NULL);
+    }
+
+    BlitDataDescription desc;
+    desc.mBlitType  = GPU_BLIT_SRC;
+    desc.mSrcAddr   = 0x10000000;
+    desc.mSrcWidth  = 1280;
+    desc.mSrcHeight = 720;
+    desc.mSrcFormat = HAL_PIXEL_FORMAT_RGBA_8888;
+    desc.mDstAddr   = 0x20000000;
+    desc.mDstWidth  = 1280;
+    desc.mDstHeight = 720;
+    desc.mDstFormat = HAL_PIXEL_FORMAT_YCbCr_420_P;
+    desc.mSrcRect   = &g_rect;
+    desc.mDstRect   = &g_rect;
+
+    nsecs_t vsync = systemTime();
+    for(int i = 0; i < frames; ++i){
+        sleep_until(vsync);
+        start[i] = systemTime();
+        engine.Blit(&desc);
+        if(bFenced){
+            worker_queue(engine.Submit(), i);
+        }
+        composed[i] = systemTime();
+        if(!bFenced){
+            released[i] = composed[i];
+        }
+        vsync += periodNs;
+    }
+
+    if(bFenced){
+        pthread_mutex_lock(&g_worker.lock);
+        g_worker.exit = true;
+        pthread_cond_broadcast(&g_worker.cond);
+        pthread_mutex_unlock(&g_worker.lock);
+        pthread_join(worker, NULL);
+    }
+
+    for(int i = 0; i < frames; ++i){
+        released[i] -= start[i];
+        composed[i] -= start[i];
+    }
+    report(name, "compose", composed, frames);
+    report(name, "release", released, frames);
+    if(g_worker.timeouts){
+        printf("ERROR: %d fence(s) timed out\n", g_worker.timeouts);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int frames = 300;
+    int gpuUs = 4000;
+    int periodUs = 16667;
+    int opt;
+
+    while((opt = getopt(argc, argv, "n:g:p:")) != -1){
+        switch(opt){
+        case 'n':
+            frames = atoi(optarg);
+            break;
+        case 'g':
+            gpuUs = atoi(optarg);
+            break;
+        case 'p':
+            periodUs = atoi(optarg);
+            break;
+        default:
+            printf("usage: %s [-n frames] [-g gpu us per frame] [-p period us]\n", argv[0]);
+            return -1;
+        }
+    }
+    if(frames <= 0 || frames > BENCH_MAX_FRAMES){
+        frames = (frames <= 0) ? 1 : BENCH_MAX_FRAMES;
+    }
+
+    pthread_mutex_init(&g_worker.lock, NULL);
+    pthread_cond_init(&g_worker.cond, NULL);
+    g_gpu.blitNs = (nsecs_t)gpuUs * 1000;
+
+    printf("%d frames, %d us of GPU work every %d us\n", frames, gpuUs, periodUs);
+    run("blocking", false, frames, (nsecs_t)periodUs * 1000);
+    run("fenced", true, frames, (nsecs_t)periodUs * 1000);
+    return 0;
+}
@@ -0,0 +1,551 @@
+/*
+* (C) Copyright 2010 Marvell International Ltd.
+* All Rights Reserved
+*
+* MARVELL CONFIDENTIAL
+* Copyright 2008 ~ 2010 Marvell International Ltd All Rights Reserved.
+* The source code contained or described herein and all documents related to
+* the source code ("Material") are owned by Marvell International Ltd or its
+* suppliers or licensors. Title to the Material remains with Marvell International Ltd
+* or its suppliers and licensors. The Material contains trade secrets and
+* proprietary and confidential information of Marvell or its suppliers and
+* licensors. The Material is protected by worldwide copyright and trade secret
+* laws and treaty provisions. No part of the Material may be used, copied,
+* reproduced, modified, published, uploaded, posted, transmitted, distributed,
+* or disclosed in any way without Marvell's prior express written permission.
+*
+* No license under any patent, copyright, trade secret or other intellectual
+* property right is granted to or conferred upon you by disclosure or delivery
+* of the Materials, either expressly, by implication, inducement, estoppel or
+* otherwise. Any license under such intellectual property rights must be
+* express and approved by Marvell in writing.
+*
+*/
+
+/*
+ * Unit test of the GcuEngine surface cache and fences. libgcu is replaced by the mock
+ * below, which keeps track of every surface and of the commands queued
+ * since the last gcuFinish(), so the test can tell how often buffers were
+ * wrapped, which ones were destroyed, and whether a surface was destroyed
+ * or used while the GPU could still reference it.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "GcuEngine.h"
+
+using namespace android;
+
+#define MOCK_MAX_SURFACES   64
+#define MOCK_MAX_QUEUED     64
+
+typedef struct _MockSurface
+{
+    bool            live;
+    bool            wrapped;
+    uint32_t        physAddr;
+    uint32_t        width;
+    uint32_t        height;
+    GCU_FORMAT      format;
+}MockSurface;
+
+static struct
+{
+    MockSurface     surfaces[MOCK_MAX_SURFACES];
+    MockSurface*    queued[MOCK_MAX_QUEUED];   ///< referenced until gcuFinish()
+    uint32_t        queuedCount;
+    uint32_t        wraps;
+    uint32_t        destroys;
+    uint32_t        finishes;
+    uint32_t        failWraps;          ///< fail this many wraps from now on
+    bool            hangFences;         ///< fences never signal, as on a hung GCU
+    uint32_t        errors;             ///< destroyed in flight or used after destroy
+    MockSurface*    lastSrc;
+    MockSurface*    lastDst;
+    bool            contextLive;
+}g_mock;
+
+static int g_failed = 0;
+
+#define CHECK(cond) \
+    do { \
+        if(!(cond)){ \
+            printf("ERROR: %s:%d: %s\n", __FUNCTION__, __LINE__, #cond); \
+            ++g_failed; \
+        } \
+    } while(0)
+
+static void mock_reset()
+{
+    memset(&g_mock, 0, sizeof(g_mock));
+}
+
+static MockSurface* mock_alloc()
+{
+    for(uint32_t i = 0; i < MOCK_MAX_SURFACES; ++i){
+        if(!g_mock.surfaces[i].live){
+            memset(&g_mock.surfaces[i], 0, sizeof(MockSurface));
+            g_mock.surfaces[i].live = true;
+            return &g_mock.surfaces[i];
+        }
+    }
+    printf("ERROR: mock GCU out of surfaces\n");
+    ++g_mock.errors;
+    return NULL;
+}
+
+static void mock_use(GCUSurface pSurface)
+{
+    MockSurface* pMock = (MockSurface*)pSurface;
+    if(NULL == pMock || !pMock->live){
+        printf("ERROR: mock GCU surface %p used after destroy\n", pSurface);
+        ++g_mock.errors;
+        return;
+    }
+    if(g_mock.queuedCount < MOCK_MAX_QUEUED){
+        g_mock.queued[g_mock.queuedCount++] = pMock;
+    }
+}
+
+static uint32_t mock_live_wrapped()
+{
+    uint32_t n = 0;
+    for(uint32_t i = 0; i < MOCK_MAX_SURFACES; ++i){
+        if(g_mock.surfaces[i].live && g_mock.surfaces[i].wrapped)
+            ++n;
+    }
+    return n;
+}
+
+static bool mock_is_wrapped(uint32_t physAddr)
+{
+    for(uint32_t i = 0; i < MOCK_MAX_SURFACES; ++i){
+        if(g_mock.surfaces[i].live && g_mock.surfaces[i].wrapped
+           && g_mock.surfaces[i].physAddr == physAddr)
+            return true;
+    }
+    return false;
+}
+
+/*
+ * the subset of gcu.h GcuEngine uses.
+ */
+GCUbool gcuInitialize(GCU_INIT_DATA* pData)
+{
+    return GCU_TRUE;
+}
+
+GCUvoid gcuTerminate()
+{
+}
+
+GCUContext gcuCreateContext(GCU_CONTEXT_DATA* pData)
+{
+    g_mock.contextLive = true;
+    return (GCUContext)&g_mock;
+}
+
+GCUvoid gcuDestroyContext(GCUContext pContext)
+{
+    g_mock.contextLive = false;
+}
+
+GCUenum gcuGetError()
+{
+    return GCU_NO_ERROR;
+}
+
+GCUbool gcuSet(GCUContext pContext, GCU_STATE_TYPE state, GCUint value)
+{
+    return GCU_TRUE;
+}
+
+GCUSurface _gcuCreateBuffer(GCUContext pContext, GCUuint width, GCUuint height,
+                            GCU_FORMAT format, GCUVirtualAddr* pVirtAddr,
+                            GCUPhysicalAddr* pPhysicalAddr)
+{
+    MockSurface* pMock = mock_alloc();
+    if(NULL != pMock){
+        pMock->width = width;
+        pMock->height = height;
+        pMock->format = format;
+    }
+    *pVirtAddr = NULL;
+    *pPhysicalAddr = 0;
+    return (GCUSurface)pMock;
+}
+
+GCUSurface _gcuCreatePreAllocBuffer(GCUContext pContext, GCUuint width, GCUuint height,
+                                    GCU_FORMAT format, GCUbool bPreAllocVirtual,
+                                    GCUVirtualAddr virtualAddr, GCUbool bPreAllocPhysical,
+                                    GCUPhysicalAddr physicalAddr)
+{
+    if(g_mock.failWraps > 0){
+        --g_mock.failWraps;
+        return NULL;
+    }
+
+    MockSurface* pMock = mock_alloc();
+    if(NULL != pMock){
+        pMock->wrapped = true;
+        pMock->physAddr = physicalAddr;
+        pMock->width = width;
+        pMock->height = height;
+        pMock->format = format;
+        ++g_mock.wraps;
+    }
+    return (GCUSurface)pMock;
+}
+
+GCUSurface _gcuLoadRGBSurfaceFromFile(GCUContext pContext, const char* filename)
+{
+    return NULL;
+}
+
+GCUbool gcuQuerySurfaceInfo(GCUContext pContext, GCUSurface pSurface, GCU_SURFACE_DATA* pData)
+{
+    MockSurface* pMock = (MockSurface*)pSurface;
+    memset(pData, 0, sizeof(*pData));
+    pData->width = pMock->width;
+    pData->height = pMock->height;
+    pData->format = pMock->format;
+    return GCU_TRUE;
+}
+
+GCUvoid gcuDestroySurface(GCUContext pContext, GCUSurface pSurface)
+{
+    MockSurface* pMock = (MockSurface*)pSurface;
+    if(NULL == pMock || !pMock->live){
+        printf("ERROR: mock GCU surface %p destroyed twice\n", pSurface);
+        ++g_mock.errors;
+        return;
+    }
+
+    for(uint32_t i = 0; i < g_mock.queuedCount; ++i){
+        if(g_mock.queued[i] == pMock){
+            printf("ERROR: mock GCU surface 0x%08x destroyed while in flight\n", pMock->physAddr);
+            ++g_mock.errors;
+            break;
+        }
+    }
+
+    pMock->live = false;
+    ++g_mock.destroys;
+}
+
+GCUvoid gcuFill(GCUContext pContext, GCU_FILL_DATA* pData)
+{
+    mock_use(pData->pSurface);
+    g_mock.lastSrc = NULL;
+    g_mock.lastDst = (MockSurface*)pData->pSurface;
+}
+
+GCUvoid gcuBlit(GCUContext pContext, GCU_BLT_DATA* pData)
+{
+    mock_use(pData->pSrcSurface);
+    mock_use(pData->pDstSurface);
+    g_mock.lastSrc = (MockSurface*)pData->pSrcSurface;
+    g_mock.lastDst = (MockSurface*)pData->pDstSurface;
+}
+
+GCUvoid gcuRop(GCUContext pContext, GCU_ROP_DATA* pData)
+{
+    mock_use(pData->pSrcSurface);
+    mock_use(pData->pDstSurface);
+}
+
+GCUvoid gcuFlush(GCUContext pContext)
+{
+}
+
+GCUvoid gcuFinish(GCUContext pContext)
+{
+    g_mock.queuedCount = 0;
+    ++g_mock.finishes;
+}
+
+GCUFence gcuCreateFence(GCUContext pContext)
+{
+    return (GCUFence)&g_mock;
+}
+
+GCUvoid gcuDestroyFence(GCUContext pContext, GCUFence pFence)
+{
+}
+
+GCUbool gcuSendFence(GCUContext pContext, GCUFence pFence)
+{
+    return GCU_TRUE;
+}
+
+GCUbool gcuWaitFence(GCUContext pContext, GCUFence pFence, GCUuint wait_time_ms)
+{
+    if(g_mock.hangFences){
+        return GCU_FALSE;
+    }
+    g_mock.queuedCount = 0;
+    return GCU_TRUE;
+}
+
+/*
+ * blit helpers: every buffer is identified by its physical address.
+ */
+static DISP_RECT g_rect = {0, 0, 64, 64};
+
+static bool src_blit(GcuEngine& engine, uint32_t src, uint32_t dst,
+                     uint32_t width = 640, uint32_t height = 480,
+                     uint32_t format = HAL_PIXEL_FORMAT_RGBA_8888)
+{
+    BlitDataDescription desc;
+    desc.mBlitType  = GPU_BLIT_SRC;
+    desc.mSrcAddr   = src;
+    desc.mSrcWidth  = width;
+    desc.mSrcHeight = height;
+    desc.mSrcFormat = format;
+    desc.mDstAddr   = dst;
+    desc.mDstWidth  = 1280;
+    desc.mDstHeight = 720;
+    desc.mDstFormat = HAL_PIXEL_FORMAT_RGB_565;
+    desc.mSrcRect   = &g_rect;
+    desc.mDstRect   = &g_rect;
+    return engine.Blit(&desc);
+}
+
+static bool fill(GcuEngine& engine, uint32_t dst)
+{
+    BlitDataDescription desc;
+    desc.mBlitType  = GPU_BLIT_FILL;
+    desc.mDstAddr   = dst;
+    desc.mDstWidth  = 1280;
+    desc.mDstHeight = 720;
+    desc.mDstFormat = HAL_PIXEL_FORMAT_RGB_565;
+    desc.mDstRect   = &g_rect;
+    desc.mFillColor = 0xff000000;
+    return engine.Blit(&desc);
+}
+
+static bool dump_has(GcuEngine& engine, const char* text)
+{
+    String8 result;
+    char buffer[1024];
+    engine.dump(result, buffer, sizeof(buffer));
+    if(NULL == strstr(result.string(), text)){
+        printf("dump: %s", result.string());
+        return false;
+    }
+    return true;
+}
+
+/*
+ * the same src and dst are wrapped once, whatever the number of blits.
+ */
+static void test_reuse()
+{
+    mock_reset();
+    {
+        GcuEngine engine;
+        for(int i = 0; i < 100; ++i){
+            CHECK(src_blit(engine, 0x10000000, 0x20000000));
+        }
+        CHECK(g_mock.wraps == 2);
+        CHECK(mock_live_wrapped() == 2);
+        CHECK(g_mock.lastSrc->physAddr == 0x10000000);
+        CHECK(g_mock.lastDst->physAddr == 0x20000000);
+        CHECK(dump_has(engine, "[2/8] entries, hit 198, miss 2, evict 0."));
+    }
+    CHECK(g_mock.errors == 0);
+}
+
+/*
+ * an entry is only reused for the same address, size and format.
+ */
+static void test_key()
+{
+    mock_reset();
+    {
+        GcuEngine engine;
+        CHECK(src_blit(engine, 0x10000000, 0x20000000, 640, 480));
+        CHECK(src_blit(engine, 0x10000000, 0x20000000, 320, 480));
+        CHECK(g_mock.lastSrc->width == 320);
+        CHECK(src_blit(engine, 0x10000000, 0x20000000, 320, 240));
+        CHECK(g_mock.lastSrc->height == 240);
+        CHECK(src_blit(engine, 0x10000000, 0x20000000, 320, 240, HAL_PIXEL_FORMAT_BGRA_8888));
+        CHECK(g_mock.lastSrc->format == GCU_FORMAT_ARGB8888);
+        CHECK(g_mock.wraps == 5);
+
+        ///< every variant is still cached.
+        CHECK(src_blit(engine, 0x10000000, 0x20000000, 640, 480));
+        CHECK(g_mock.wraps == 5);
+        CHECK(g_mock.lastSrc->width == 640 && g_mock.lastSrc->height == 480);
+    }
+    CHECK(g_mock.errors == 0);
+}
+
+/*
+ * a full cache evicts the least recently used entry.
+ */
+static void test_lru()
+{
+    mock_reset();
+    {
+        GcuEngine engine;
+        for(uint32_t i = 0; i < MAX_CACHED_SURFACES; ++i){
+            CHECK(fill(engine, 0x30000000 + i * 0x100000));
+        }
+        CHECK(g_mock.wraps == MAX_CACHED_SURFACES);
+
+        ///< touch the oldest, the second oldest becomes the victim.
+        CHECK(fill(engine, 0x30000000));
+        CHECK(fill(engine, 0x40000000));
+        CHECK(g_mock.wraps == MAX_CACHED_SURFACES + 1);
+        CHECK(mock_live_wrapped() == MAX_CACHED_SURFACES);
+        CHECK(mock_is_wrapped(0x30000000));
+        CHECK(!mock_is_wrapped(0x30100000));
+        CHECK(mock_is_wrapped(0x40000000));
+
+        CHECK(fill(engine, 0x30000000));
+        CHECK(g_mock.wraps == MAX_CACHED_SURFACES + 1);
+        CHECK(dump_has(engine, "evict 1."));
+    }
+    CHECK(g_mock.errors == 0);
+}
+
+/*
+ * deferred blits still reference their surfaces: eviction and invalidation
+ * must wait for them first.
+ */
+static void test_deferred()
+{
+    mock_reset();
+    {
+        GcuEngine engine;
+        engine.SetDeferred(true);
+        for(uint32_t i = 0; i <= MAX_CACHED_SURFACES; ++i){
+            CHECK(fill(engine, 0x30000000 + i * 0x100000));
+        }
+        CHECK(g_mock.destroys == 1);
+
+        CHECK(src_blit(engine, 0x10000000, 0x20000000));
+        engine.InvalidateSurface(0x10000000);
+        CHECK(!mock_is_wrapped(0x10000000));
+
+        CHECK(fill(engine, 0x50000000));
+        engine.InvalidateAllSurfaces();
+        CHECK(mock_live_wrapped() == 0);
+
+        CHECK(src_blit(engine, 0x10000000, 0x20000000));
+        GCUFence pFence = engine.Submit();
+        CHECK(NULL != pFence);
+        CHECK(engine.WaitFence(pFence, 100));
+    }
+    CHECK(g_mock.errors == 0);
+}
+
+/*
+ * a fence that times out still leaves the GCU idle before WaitFence returns.
+ */
+static void test_fence_timeout()
+{
+    mock_reset();
+    {
+        GcuEngine engine;
+        engine.SetDeferred(true);
+
+        CHECK(src_blit(engine, 0x10000000, 0x20000000));
+        uint32_t finishes = g_mock.finishes;
+        CHECK(engine.WaitFence(engine.Submit(), 100));
+        CHECK(g_mock.finishes == finishes);
+
+        CHECK(src_blit(engine, 0x10000000, 0x20000000));
+        g_mock.hangFences = true;
+        CHECK(!engine.WaitFence(engine.Submit(), 10));
+        CHECK(g_mock.finishes == finishes + 1);
+        CHECK(g_mock.queuedCount == 0);
+        g_mock.hangFences = false;
+    }
+    CHECK(g_mock.errors == 0);
+}
+
+/*
+ * invalidation drops the entries, the next blit wraps the buffer again.
+ */
+static void test_invalidate()
+{
+    mock_reset();
+    {
+        GcuEngine engine;
+        CHECK(src_blit(engine, 0x10000000, 0x20000000));
+        CHECK(src_blit(engine, 0x10000000, 0x20000000, 320, 240));
+
+        engine.InvalidateSurface(0x10000000);
+        CHECK(!mock_is_wrapped(0x10000000));
+        CHECK(mock_is_wrapped(0x20000000));
+        CHECK(mock_live_wrapped() == 1);
+
+        CHECK(src_blit(engine, 0x10000000, 0x20000000));
+        CHECK(g_mock.wraps == 4);
+
+        engine.InvalidateAllSurfaces();
+        CHECK(mock_live_wrapped() == 0);
+        CHECK(dump_has(engine, "[0/8] entries"));
+
+        CHECK(src_blit(engine, 0x10000000, 0x20000000));
+        CHECK(g_mock.wraps == 6);
+    }
+    CHECK(g_mock.errors == 0);
+}
+
+/*
+ * a failed wrap fails the blit and caches nothing.
+ */
+static void test_wrap_failure()
+{
+    mock_reset();
+    {
+        GcuEngine engine;
+        g_mock.failWraps = 1;
+        CHECK(!src_blit(engine, 0x10000000, 0x20000000));
+        CHECK(!mock_is_wrapped(0x10000000));
+        CHECK(src_blit(engine, 0x10000000, 0x20000000));
+        CHECK(mock_live_wrapped() == 2);
+        CHECK(g_mock.wraps == 2);
+    }
+    CHECK(g_mock.errors == 0);
+}
+
+/*
+ * the engine leaves no surface or context behind.
+ */
+static void test_teardown()
+{
+    mock_reset();
+    {
+        GcuEngine engine;
+        for(uint32_t i = 0; i < MAX_CACHED_SURFACES / 2; ++i){
+            CHECK(src_blit(engine, 0x10000000 + i * 0x100000, 0x20000000 + i * 0x100000));
+        }
+        CHECK(mock_live_wrapped() == MAX_CACHED_SURFACES);
+    }
+    for(uint32_t i = 0; i < MOCK_MAX_SURFACES; ++i){
+        CHECK(!g_mock.surfaces[i].live);
+    }
+    CHECK(!g_mock.contextLive);
+    CHECK(g_mock.errors == 0);
+}
+
+int main(int argc, char** argv)
+{
+    test_reuse();
+    test_key();
+    test_lru();
+    test_deferred();
+    test_fence_timeout();
+    test_invalidate();
+    test_wrap_failure();
+    test_teardown();
+
+    printf("GcuEngine surface cache: %s\n", g_failed ? "FAILED" : "PASSED");
+    return g_failed ? 1 : 0;
+}
@@ -30,9 +30,6 @@
 #include <hardware_legacy/uevent.h>
 #include "HWCDisplayEventMonitor.h"
 
-#define VSYNC_CTRL_PATH "/sys/class/graphics/fb0/device/vsync"
-#define VSYNC_TIMESTAMP_PATH "/sys/class/graphics/fb0/device/vsync_ts"
-
 using namespace android;
 
 HWCDisplayEventMonitor::HWCDisplayEventMonitor(hwc_procs_t * procs)
@@ -26,6 +26,10 @@
 #define __HWC_DISPLAY_EVENT_MONITOR_H
 #include <utils/Thread.h>
 #include <hardware/hwcomposer.h>
+
+#define VSYNC_CTRL_PATH "/sys/class/graphics/fb0/device/vsync"
+#define VSYNC_TIMESTAMP_PATH "/sys/class/graphics/fb0/device/vsync_ts"
+
 namespace android {
 
 class HWCDisplayEventMonitor : public Thread {
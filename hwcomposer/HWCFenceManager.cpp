@@ -42,24 +42,35 @@
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
+#include <stdlib.h>
+#include <sys/poll.h>
+#include <sys/stat.h>
 
 #include <sync/sw_sync.h>
 #include "HWCFenceManager.h"
 
 namespace android{
-HWCFenceManager::HWCFenceManager() : m_bRunning(true)
-                                   , m_pEventThread(NULL)
+HWCFenceManager::HWCFenceManager(const char* pVsyncPath) : m_bRunning(true)
+                                                         , m_bVsyncRunning(false)
+                                                         , m_pEventThread(NULL)
 {
-    m_pEventThread = new HWCFenceTimerThread();
-#if 0
-    if(NO_ERROR == m_pEventThread->run("HWCFenceTimerThread", PRIORITY_URGENT_DISPLAY)){
-        m_bRunning = true;
+    m_pEventThread = new HWCFenceTimerThread(pVsyncPath);
+
+    // without a usable vsync source, only explicit fences are available and
+    // createRetireFence() returns -1, frames retire the old way on the next set.
+    if(NULL != pVsyncPath
+       && m_pEventThread->openVsync()
+       && NO_ERROR == m_pEventThread->run("HWCFenceTimerThread", PRIORITY_URGENT_DISPLAY)){
+        m_bVsyncRunning = true;
     }
-#endif
 }
 
 HWCFenceManager::~HWCFenceManager()
 {
+    if(m_bVsyncRunning){
+        m_pEventThread->requestExitAndWait();
+        m_bVsyncRunning = false;
+    }
     m_pEventThread.clear();
     m_bRunning = false;
 }
@@ -77,6 +88,14 @@ void HWCFenceManager::signalFence(int64_t nFenceId)
     return m_pEventThread->signalFence(nFenceId);
 }
 
+int32_t HWCFenceManager::createRetireFence(uint32_t nDisp)
+{
+    if(!m_bVsyncRunning || nDisp >= HWC_FENCE_MAX_DISPLAYS)
+        return -1;
+
+    return m_pEventThread->createRetireFence(nDisp);
+}
+
 void HWCFenceManager::reset()
 {
     m_pEventThread->reset();
@@ -84,24 +103,53 @@ void HWCFenceManager::reset()
 
 void HWCFenceManager::dump(String8& result, char* buffer, int size)
 {
+    Mutex::Autolock lock(m_pEventThread->m_mutexLock);
+
     sprintf(buffer, "Current Fence is %lld.\n", m_pEventThread->m_nCurrentStamp);
     result.append(buffer);
+
+    sprintf(buffer, "Current Vsync Fence is %lld (requested %lld), last vsync at 0x%llx.\n",
+            m_pEventThread->m_nVsyncStamp, m_pEventThread->m_nRequestedVsyncStamp,
+            m_pEventThread->m_nLastVsyncTimestamp);
+    result.append(buffer);
+
+    for(uint32_t i = 0; i < HWC_FENCE_MAX_DISPLAYS; ++i){
+        if(m_pEventThread->m_nRetireStamp[i] > 0){
+            sprintf(buffer, "    Display[%d] Retire Fence is %lld.\n", i, m_pEventThread->m_nRetireStamp[i]);
+            result.append(buffer);
+        }
+    }
 }
 
-HWCFenceTimerThread::HWCFenceTimerThread() : m_nSyncTimeLineFd(-1)
-                                           , m_nCurrentStamp(0)
+HWCFenceTimerThread::HWCFenceTimerThread(const char* pVsyncPath) : m_nSyncTimeLineFd(-1)
+                                                                 , m_nCurrentStamp(0)
+                                                                 , m_nVsyncTimeLineFd(-1)
+                                                                 , m_nVsyncStamp(0)
+                                                                 , m_nRequestedVsyncStamp(0)
+                                                                 , m_nLastVsyncTimestamp(0)
+                                                                 , m_sVsyncPath((NULL != pVsyncPath) ? pVsyncPath : "")
+                                                                 , m_nVsyncFd(-1)
+                                                                 , m_bPollable(true)
 {
     //open("/dev/sw_sync", O_RDWR);
+    memset(m_nRetireStamp, 0, sizeof(m_nRetireStamp));
     reset();
 }
 
 HWCFenceTimerThread::~HWCFenceTimerThread()
 {
     close(m_nSyncTimeLineFd);
+
+    if(m_nVsyncTimeLineFd >= 0)
+        close(m_nVsyncTimeLineFd);
+
+    if(m_nVsyncFd >= 0)
+        close(m_nVsyncFd);
 }
 
 int32_t HWCFenceTimerThread::createFence(int64_t nFenceId)
 {
+    Mutex::Autolock lock(m_mutexLock);
     if(m_nSyncTimeLineFd < 0){
         return -1;
     }
@@ -113,6 +161,7 @@ int32_t HWCFenceTimerThread::createFence(int64_t nFenceId)
 
 void HWCFenceTimerThread::signalFence(int64_t nFenceId)
 {
+    Mutex::Autolock lock(m_mutexLock);
     if(m_nSyncTimeLineFd < 0){
         return;
     }
@@ -133,8 +182,54 @@ void HWCFenceTimerThread::signalFence(int64_t nFenceId)
 
 }
 
+int32_t HWCFenceTimerThread::createRetireFence(uint32_t nDisp)
+{
+    Mutex::Autolock lock(m_mutexLock);
+    if(m_nVsyncTimeLineFd < 0){
+        return -1;
+    }
+
+    // frame committed now is scanned out from the next vsync.
+    int64_t nStamp = m_nVsyncStamp + 1;
+
+    char str[256];
+    sprintf(str, "retire_fence disp %d at vsync %lld", nDisp, nStamp);
+    int32_t nFenceFd = sw_sync_fence_create(m_nVsyncTimeLineFd, str, nStamp);
+    if(nFenceFd < 0){
+        ALOGE("ERROR: can't create retire fence for display %d!", nDisp);
+        return -1;
+    }
+
+    m_nRetireStamp[nDisp] = nStamp;
+    if(nStamp > m_nRequestedVsyncStamp)
+        m_nRequestedVsyncStamp = nStamp;
+
+    return nFenceFd;
+}
+
+void HWCFenceTimerThread::advanceVsync(int64_t nStamp)
+{
+    Mutex::Autolock lock(m_mutexLock);
+    if(m_nVsyncTimeLineFd < 0){
+        return;
+    }
+
+    int32_t nStep = nStamp - m_nVsyncStamp;
+    if(nStep <= 0)
+        return;
+
+    int32_t err = sw_sync_timeline_inc(m_nVsyncTimeLineFd, nStep);
+    if (err < 0) {
+        ALOGE("can't increment vsync sync obj:");
+        return;
+    }
+
+    m_nVsyncStamp += nStep;
+}
+
 void HWCFenceTimerThread::reset()
 {
+    Mutex::Autolock lock(m_mutexLock);
     m_nCurrentStamp = 0;
 
     if(m_nSyncTimeLineFd >= 0)
@@ -144,15 +239,90 @@ void HWCFenceTimerThread::reset()
     if (m_nSyncTimeLineFd < 0) {
         ALOGE("ERROR: can't create sw_sync_timeline:");
     }
+
+    // closing the vsync timeline signals all its pending retire fences.
+    m_nVsyncStamp = 0;
+    m_nRequestedVsyncStamp = 0;
+    memset(m_nRetireStamp, 0, sizeof(m_nRetireStamp));
+
+    if(m_nVsyncTimeLineFd >= 0)
+        close(m_nVsyncTimeLineFd);
+
+    m_nVsyncTimeLineFd = sw_sync_timeline_create();
+    if (m_nVsyncTimeLineFd < 0) {
+        ALOGE("ERROR: can't create vsync sw_sync_timeline:");
+    }
 }
 
-bool HWCFenceTimerThread::threadLoop()
+bool HWCFenceTimerThread::openVsync()
 {
-    /*TODO: 
-     * polling on VSYNC to update fence status.
-     */
+    if(m_nVsyncTimeLineFd < 0){
+        return false;
+    }
+
+    m_nVsyncFd = open(m_sVsyncPath.string(), O_RDONLY);
+    if(m_nVsyncFd < 0){
+        ALOGE("ERROR: open vsync timestamp file %s failed: %s", m_sVsyncPath.string(), strerror(errno));
+        return false;
+    }
+
+    // sysfs notifies by POLLPRI, a plain file (simulated vsync) must be re-read periodically.
+    struct stat st;
+    m_bPollable = !((0 == fstat(m_nVsyncFd, &st)) && S_ISREG(st.st_mode));
+
+    // the current timestamp belongs to a vsync already passed.
+    char buffer[64];
+    memset(buffer, 0, sizeof(buffer));
+    if(read(m_nVsyncFd, buffer, sizeof(buffer) - 1) > 0){
+        m_nLastVsyncTimestamp = strtoull(buffer, NULL, 16);
+    }
+
     return true;
 }
 
+bool HWCFenceTimerThread::threadLoop()
+{
+    const int max_count = 64;
+    char buffer[max_count];
+    struct pollfd ufds;
+
+    ufds.fd = m_nVsyncFd;
+    ufds.events = 0;
+    ufds.revents = 0;
+
+    int32_t res = poll(&ufds, 1, m_bPollable ? HWC_FENCE_VSYNC_TIMEOUT_MS : HWC_FENCE_VSYNC_POLL_MS);
+    if(res < 0){
+        ALOGV("poll return error %d", res);
+        return true;
+    }
+
+    uint64_t timestamp = 0;
+    memset(buffer, 0, max_count);
+    lseek(m_nVsyncFd, 0, SEEK_SET);
+    int32_t len = read(m_nVsyncFd, buffer, max_count - 1);
+    if(len > 0){
+        timestamp = strtoull(buffer, NULL, 16);
+    }
+
+    if(0 != timestamp && timestamp != m_nLastVsyncTimestamp){
+        // a new vsync, frames committed before it are on screen now.
+        m_nLastVsyncTimestamp = timestamp;
+        advanceVsync(m_nVsyncStamp + 1);
+        return true;
+    }
+
+    if(0 == res && m_bPollable){
+        // no vsync for a long time (vsync off or panel blanked),
+        // do not leave SurfaceFlinger waiting on retire fences.
+        int64_t nRequested;
+        {
+            Mutex::Autolock lock(m_mutexLock);
+            nRequested = m_nRequestedVsyncStamp;
+        }
+        advanceVsync(nRequested);
+    }
+
+    return true;
 }
 
+}
@@ -54,32 +54,56 @@
 #include <utils/Vector.h>
 #include <cutils/properties.h>
 #include <hardware/hwcomposer.h>
+#include "HWCDisplayEventMonitor.h"
 
 namespace android{
 
+///< max displays which may ask for retire fences.
+#define HWC_FENCE_MAX_DISPLAYS          (HWC_NUM_DISPLAY_TYPES + 3)
+
+///< if no vsync comes in this time (e.g. vsync disabled), retire pending fences anyway.
+#define HWC_FENCE_VSYNC_TIMEOUT_MS      100
+
+///< polling interval for a vsync source which can not notify (simulated vsync file).
+#define HWC_FENCE_VSYNC_POLL_MS         2
+
 /*
  * Fence Timer Thread
- * Later, we may poll this thread on VSYNC,
- * so that we can update fence status in time.
+ * Polls on VSYNC timestamp and advances a vsync timeline on
+ * each VSYNC, so that retire fences signal on scan-out.
+ * Explicit fences (createFence/signalFence) live on their own timeline.
  */
 class HWCFenceTimerThread : public Thread
 {
     friend class HWCFenceManager;
 private:
-    HWCFenceTimerThread();
+    HWCFenceTimerThread(const char* pVsyncPath);
 
     ~HWCFenceTimerThread();
 
     bool threadLoop();
 
+    ///< check the vsync timeline and open the timestamp file, must succeed before the thread runs.
+    bool openVsync();
+
     int64_t getCurrentStamp() const{
+        Mutex::Autolock lock(m_mutexLock);
         return m_nCurrentStamp;
     }
 
+    int64_t getVsyncStamp() const{
+        Mutex::Autolock lock(m_mutexLock);
+        return m_nVsyncStamp;
+    }
+
     int32_t createFence(int64_t nFenceId);
 
     void signalFence(int64_t nFenceId);
 
+    int32_t createRetireFence(uint32_t nDisp);
+
+    void advanceVsync(int64_t nStamp);
+
     void reset();
 
 private:
@@ -87,13 +111,33 @@ private:
 
     int64_t m_nCurrentStamp;
 
-    Mutex m_mutexLock;
+    ///< vsync timeline, one point per vsync.
+    int32_t m_nVsyncTimeLineFd;
+
+    int64_t m_nVsyncStamp;
+
+    ///< the latest point any retire fence waits on.
+    int64_t m_nRequestedVsyncStamp;
+
+    uint64_t m_nLastVsyncTimestamp;
+
+    ///< per display, the point of the latest retire fence.
+    int64_t m_nRetireStamp[HWC_FENCE_MAX_DISPLAYS];
+
+    String8 m_sVsyncPath;
+
+    int32_t m_nVsyncFd;
+
+    bool m_bPollable;
+
+    mutable Mutex m_mutexLock;
 };
 
 class HWCFenceManager : public RefBase
 {
 public:
-    HWCFenceManager();
+    ///< pVsyncPath: vsync timestamp file driving retire fences, NULL for explicit fences only.
+    HWCFenceManager(const char* pVsyncPath = VSYNC_TIMESTAMP_PATH);
 
     ~HWCFenceManager();
 
@@ -102,10 +146,17 @@ public:
 
     void signalFence(int64_t nFenceId);
 
+    ///< fence signaled on the next vsync, when this frame of nDisp is on screen.
+    int32_t createRetireFence(uint32_t nDisp);
+
     int64_t getCurrentStamp() const{
         return m_pEventThread->getCurrentStamp();
     }
 
+    int64_t getVsyncStamp() const{
+        return m_pEventThread->getVsyncStamp();
+    }
+
     void reset();
 
     void dump(String8& result, char* buffer, int size);
@@ -114,6 +165,9 @@ private:
     ///< status
     bool m_bRunning;
 
+    ///< vsync thread status
+    bool m_bVsyncRunning;
+
     ///< the thread counting the current fence time status.
     sp<HWCFenceTimerThread> m_pEventThread;
 
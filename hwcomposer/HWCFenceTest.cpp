@@ -18,10 +18,125 @@
 #include <cutils/ashmem.h>
 #include <cutils/log.h>
 
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
 #include "HWCFenceManager.h"
 
 using namespace android;
 
+#define SIM_VSYNC_PATH      "/data/local/tmp/hwc_sim_vsync_ts"
+#define SIM_VSYNC_PERIOD_NS 16666667LL
+#define SIM_FRAMES          120
+
+static volatile bool g_bSimRunning = false;
+static volatile int64_t g_nLastVsyncNs = 0;
+
+static int64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/*
+ * write a new hex timestamp into the simulated vsync_ts file every period,
+ * the same format as /sys/class/graphics/fb0/device/vsync_ts.
+ */
+void *vsync_thread(void *data)
+{
+    const char* path = (const char*)data;
+    int64_t next = now_ns();
+
+    while(g_bSimRunning){
+        next += SIM_VSYNC_PERIOD_NS;
+        struct timespec ts;
+        ts.tv_sec = next / 1000000000LL;
+        ts.tv_nsec = next % 1000000000LL;
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+
+        int64_t stamp = now_ns();
+        FILE* fp = fopen(path, "w");
+        if(NULL != fp){
+            fprintf(fp, "%llx\n", stamp);
+            fclose(fp);
+        }
+        g_nLastVsyncNs = stamp;
+    }
+
+    return NULL;
+}
+
+/*
+ * retire fence timing test against a simulated vsync file:
+ * every retire fence must signal after exactly one vsync,
+ * i.e. between 0 and 2 periods after it is created.
+ */
+int vsync_test(const char* path)
+{
+    unlink(path);
+    {
+        // no vsync source: no retire fence, frames retire the old way.
+        HWCFenceManager manager(path);
+        if(manager.createRetireFence(HWC_DISPLAY_PRIMARY) >= 0){
+            printf("ERROR: retire fence created without vsync file %s\n", path);
+            return -1;
+        }
+    }
+
+    FILE* fp = fopen(path, "w");
+    if(NULL == fp){
+        printf("ERROR: can not create simulated vsync file %s\n", path);
+        return -1;
+    }
+    fprintf(fp, "%llx\n", now_ns());
+    fclose(fp);
+
+    g_bSimRunning = true;
+    pthread_t thread;
+    pthread_create(&thread, NULL, vsync_thread, (void*)path);
+
+    int failed = 0;
+    int64_t total = 0;
+    int64_t worst = 0;
+    {
+        HWCFenceManager manager(path);
+
+        for(int i = 0; i < SIM_FRAMES; ++i){
+            int64_t start = now_ns();
+            int64_t vsync = manager.getVsyncStamp();
+            sp<Fence> pFence = new Fence(manager.createRetireFence(HWC_DISPLAY_PRIMARY));
+
+            if(NO_ERROR != pFence->wait(1000)){
+                printf("ERROR: retire fence %d TIMEOUT!\n", i);
+                ++failed;
+                continue;
+            }
+
+            int64_t latency = now_ns() - start;
+            int64_t vsyncs = manager.getVsyncStamp() - vsync;
+            total += latency;
+            if(latency > worst)
+                worst = latency;
+
+            if(latency > 2 * SIM_VSYNC_PERIOD_NS || vsyncs < 1){
+                printf("ERROR: retire fence %d signaled after %lld ns, %lld vsyncs\n", i, latency, vsyncs);
+                ++failed;
+            }
+        }
+    }
+
+    g_bSimRunning = false;
+    pthread_join(thread, NULL);
+    unlink(path);
+
+    printf("retire fence: %d frames, avg %lld us, worst %lld us, %d failed\n",
+           SIM_FRAMES, total / SIM_FRAMES / 1000, worst / 1000, failed);
+    return failed ? -1 : 0;
+}
+
 void *sync_thread(void *data)
 {
     int32_t fd = *((int32_t*)data);
@@ -38,6 +153,10 @@ void *sync_thread(void *data)
 
 int main(int argc, char** argv)
 {
+    if(argc > 1 && 0 == strcmp(argv[1], "vsync")){
+        return vsync_test((argc > 2) ? argv[2] : SIM_VSYNC_PATH);
+    }
+
     HWCFenceManager manager[2];
 
     int32_t fd1 = manager[0].createFence(1);
@@ -32,8 +32,11 @@
 
 #include <hardware/hardware.h>
 #include <hardware/hwcomposer.h>
+#include <sync/sync.h>
+#include <unistd.h>
 
 #include "gralloc_priv.h"
+#include "gc_gralloc_priv.h"
 #include "HWVirtualComposer.h"
 
 #ifdef LOG_TAG
@@ -43,6 +46,9 @@
 #define LOG_TAG "HWVirtualComposer"
 //#define LOG_NDEBUG 0
 
+///< max time to wait a GCU fence before giving up on it.
+#define GCU_FENCE_TIMEOUT_MS 1000
+
 
 using namespace android;
 
@@ -52,13 +58,38 @@ HWVirtualComposer::HWVirtualComposer() : m_bRunning(false)
                                        , m_pGcuEngine(NULL)
                                        , m_pDefaultDisplayInfo(NULL)
                                        , m_previousDisplayMode(DISPLAY_CONTENT_UNKNOWN)
+                                       , m_nFenceStamp(0)
+                                       , m_nFrameCount(0)
+                                       , m_nFullBlits(0)
+                                       , m_nPartialBlits(0)
+                                       , m_nSkippedBlits(0)
 {
     m_pGcuEngine = new GcuEngine;
     m_pGcuEngine->LoadHintPic(0, "/etc/hint.bmp");
+
+    ///< fenced submission: return from set() without waiting for the 2D engine.
+    char value[PROPERTY_VALUE_MAX];
+    property_get("hwc.virtual.gcu.async", value, "1");
+    if(atoi(value) == 1){
+        m_pFenceManager = new HWCFenceManager(NULL);
+        m_pFenceWorker = new GcuFenceWorker(m_pGcuEngine, m_pFenceManager);
+        if(NO_ERROR == m_pFenceWorker->run("GcuFenceWorker", PRIORITY_URGENT_DISPLAY)){
+            m_pGcuEngine->SetDeferred(true);
+        }else{
+            ALOGE("ERROR: GcuFenceWorker run failed, use blocking blit!");
+            m_pFenceWorker.clear();
+            m_pFenceManager.clear();
+        }
+    }
 }
 
 HWVirtualComposer::~HWVirtualComposer()
 {
+    if(NULL != m_pFenceWorker.get()){
+        m_pFenceWorker->stop();
+        m_pFenceWorker.clear();
+    }
+
     if(NULL != m_pGcuEngine){
         delete m_pGcuEngine;
         m_pGcuEngine = NULL;
@@ -154,6 +185,9 @@ uint32_t HWVirtualComposer::prepare(size_t numDisplays, hwc_display_contents_1_t
                         // STOP -> START, we should update the clear status.
                         m_displays.editValueFor(i)->from(destFbLayer, !m_bRunning || m_bClearBuffer);
                         m_bClearBuffer = false;
+
+                        // virtual FB target may be re-allocated, drop stale GCU wrappers.
+                        m_pGcuEngine->InvalidateAllSurfaces();
                     }
 
                     for(uint32_t j = 0; j < list->numHwLayers; ++j){
@@ -175,6 +209,18 @@ uint32_t HWVirtualComposer::prepare(size_t numDisplays, hwc_display_contents_1_t
                 if(NULL != list)
                     list->flags |= HWC_GEOMETRY_CHANGED;
             }
+
+            // primary is not tracked while stopped, contents of WFD buffers get unknown.
+            m_vLayerState.clear();
+            for(size_t i = 0; i < m_displays.size(); ++i){
+                m_displays.editValueAt(i)->resetBufferFrames();
+            }
+
+            // WFD buffers will be freed by gralloc once the session stops.
+            if(NULL != m_pFenceWorker.get()){
+                m_pFenceWorker->drain();
+            }
+            m_pGcuEngine->InvalidateAllSurfaces();
         }
         m_bRunning = false;
         return numDisplays; // give all displays out.
@@ -196,6 +242,7 @@ void HWVirtualComposer::set(size_t numDisplays, hwc_display_contents_1_t** displ
         return;
     }
     m_pPrimaryFbLayer = &(pPrimaryDisplayContents->hwLayers[pPrimaryDisplayContents->numHwLayers - 1]);
+    updateFrameDamage(pPrimaryDisplayContents);
 
     // Loop for all virtual displays.
     for (uint32_t i = HWC_NUM_DISPLAY_TYPES; i < numDisplays; ++i) {
@@ -221,6 +268,26 @@ void HWVirtualComposer::set(size_t numDisplays, hwc_display_contents_1_t** displ
     }
 }
 
+void HWVirtualComposer::dump(String8& result, char* buffer, int size, bool dumpManager)
+{
+    result.append("--------------- HWC Virtual Composer Info ---------------\n");
+    sprintf(buffer, "    [Running] : [%s], [Virtual Displays] : [%d].\n",
+            m_bRunning ? "yes" : "no", m_displays.size());
+    result.append(buffer);
+
+    sprintf(buffer, "    [Frames] : [%u], [Blits] : full %u, partial %u, skipped %u.\n",
+            m_nFrameCount, m_nFullBlits, m_nPartialBlits, m_nSkippedBlits);
+    result.append(buffer);
+
+    sprintf(buffer, "    [Fenced Blit] : [%s], [Fence Stamp] : [%lld].\n",
+            (NULL != m_pFenceWorker.get()) ? "yes" : "no", m_nFenceStamp);
+    result.append(buffer);
+
+    if(NULL != m_pGcuEngine){
+        m_pGcuEngine->dump(result, buffer, size);
+    }
+}
+
 void HWVirtualComposer::setSourceDisplayInfo(const fb_var_screeninfo* info){
     m_pDefaultDisplayInfo = info;
 }
@@ -252,10 +319,17 @@ bool HWVirtualComposer::blit(hwc_layer_1_t* src, sp<HwcDisplayData>& displayData
     buffer_handle_t dstBufferHandle = pNativeBuffer->handle;
     private_handle_t* pDstPrivHandle = private_handle_t::dynamicCast(dstBufferHandle);
 
+    int32_t nFenceFd = -1;
+    DISP_RECT dirtyRects[VIRTUAL_MAX_DIRTY_RECTS];
+    DISP_RECT* pSubRects = &dstRect;
+    uint32_t nSubRects = 1;
+    uint32_t nBufferFrame = 0;
+    bool bPartial = false;
+    Region staleRegion;
     bool bIsSecureContents = false;
     static bool preSecureState = false;
     if(preSecureState != bIsSecureContents){
-        displayData->m_vBuffer.clear();
+        displayData->resetBuffers();
     }
 
     if(NULL == pSrcPrivHandle || NULL == pDstPrivHandle){
@@ -296,13 +370,42 @@ bool HWVirtualComposer::blit(hwc_layer_1_t* src, sp<HwcDisplayData>& displayData
     dstRect.r              = dst->displayFrame.right;
     dstRect.b              = dst->displayFrame.bottom;
 
+    ///< only refresh what changed on primary since this buffer was last composed.
+    bPartial = (DISPLAY_SURFACE_ROTATION_0 == orientation)
+               && displayData->getBufferFrame(pNativeBuffer, &nBufferFrame)
+               && getStaleRegion(nBufferFrame, staleRegion);
+    displayData->clearBufferFrame(pNativeBuffer);
+
+    if(bPartial && staleRegion.isEmpty()){
+        // buffer already holds the current frame.
+        ++m_nSkippedBlits;
+        displayData->setBufferFrame(pNativeBuffer, m_nFrameCount);
+        goto ERROR_OUT;
+    }
+
+    if(bPartial){
+        nSubRects = getDirtyRects(staleRegion, src, dst, dirtyRects);
+        if(nSubRects > 0){
+            pSubRects = dirtyRects;
+        }else{
+            bPartial = false;
+            nSubRects = 1;
+        }
+    }
+
+    if(bPartial){
+        ++m_nPartialBlits;
+    }else{
+        ++m_nFullBlits;
+    }
+
     ConstructBlitDataDescription(blitDesc, GPU_BLIT_FILTER, true, orientation,
                                  width, height,
                                  pSrcPrivHandle->format, &srcRect,
                                  pSrcPrivHandle->physAddr, 0, 0,
                                  width*4, 0, 0,
                                  pDstPrivHandle->width, pDstPrivHandle->height, pDstPrivHandle->format,
-                                 &dstRect, &dstRect, 1,
+                                 &dstRect, pSubRects, nSubRects,
                                  pDstPrivHandle->physAddr, pDstPrivHandle->mem_xstride,
                                  0, 0, 0, NULL, true, 0x0);
 
@@ -311,14 +414,25 @@ bool HWVirtualComposer::blit(hwc_layer_1_t* src, sp<HwcDisplayData>& displayData
         goto ERROR_OUT;
     }
 
+    displayData->setBufferFrame(pNativeBuffer, m_nFrameCount);
+
     /*
     dumpOneFrame((void*)pDstPrivHandle->base, pDstPrivHandle->width,
                  pDstPrivHandle->height, pDstPrivHandle->format);
     */
 
 ERROR_OUT:
-    //queue back to WFD AVstreaming pipeline.
-    ret = pNativeWindow->queueBuffer_DEPRECATED(pNativeWindow, pNativeBuffer);
+    nFenceFd = submitBlits();
+    if(nFenceFd >= 0){
+        ///< FB target can be reused once GCU has read it.
+        mergeReleaseFence(src, nFenceFd);
+
+        //queue back to WFD AVstreaming pipeline, consumer waits the fence.
+        ret = pNativeWindow->queueBuffer(pNativeWindow, pNativeBuffer, nFenceFd);
+    }else{
+        //queue back to WFD AVstreaming pipeline.
+        ret = pNativeWindow->queueBuffer_DEPRECATED(pNativeWindow, pNativeBuffer);
+    }
     if(0 > ret){
         ALOGE("ERROR: Queue buffer failed!");
     }
@@ -326,6 +440,225 @@ ERROR_OUT:
     return (ret >= 0);
 }
 
+/*
+ * Part of a primary layer which changes the FB target, narrowed to the
+ * SW dirty rect gralloc recorded when the buffer is valid and not scaled,
+ * unless the whole layer is asked for.
+ */
+static Rect getLayerDamage(const hwc_layer_1_t* layer, bool bWholeLayer)
+{
+    const hwc_rect_t& frame = layer->displayFrame;
+    const hwc_rect_t& crop = layer->sourceCrop;
+    Rect damage(frame.left, frame.top, frame.right, frame.bottom);
+    Rect narrowed;
+
+    gc_private_handle_t* hnd = NULL;
+    if(!bWholeLayer && NULL != layer->handle
+       && 0 == gc_private_handle_t::validate(layer->handle)){
+        hnd = (gc_private_handle_t*)layer->handle;
+    }
+
+    if(NULL != hnd
+       && 0 == layer->transform
+       && (hnd->lockUsage & GRALLOC_USAGE_SW_WRITE_MASK)
+       && hnd->dirtyWidth > 0 && hnd->dirtyHeight > 0
+       && (crop.right - crop.left) == (frame.right - frame.left)
+       && (crop.bottom - crop.top) == (frame.bottom - frame.top)){
+        Rect dirty(frame.left + hnd->dirtyX - crop.left,
+                   frame.top + hnd->dirtyY - crop.top,
+                   frame.left + hnd->dirtyX - crop.left + hnd->dirtyWidth,
+                   frame.top + hnd->dirtyY - crop.top + hnd->dirtyHeight);
+        dirty.intersect(damage, &narrowed);
+        damage = narrowed;
+    }
+
+    if(layer->visibleRegionScreen.numRects > 0){
+        Region visible;
+        for(size_t i = 0; i < layer->visibleRegionScreen.numRects; ++i){
+            const hwc_rect_t& r = layer->visibleRegionScreen.rects[i];
+            visible.orSelf(Rect(r.left, r.top, r.right, r.bottom));
+        }
+        damage.intersect(visible.getBounds(), &narrowed);
+        damage = narrowed;
+    }
+
+    return damage;
+}
+
+void HWVirtualComposer::updateFrameDamage(hwc_display_contents_1_t* list)
+{
+    uint32_t nLayers = list->numHwLayers - 1; // without FRAMEBUFFER_TARGET.
+    const hwc_rect_t& crop = list->hwLayers[nLayers].sourceCrop;
+    Region damage;
+    bool bFull = (list->flags & HWC_GEOMETRY_CHANGED)
+                 || (m_vLayerState.size() != nLayers);
+
+    for(uint32_t i = 0; !bFull && i < nLayers; ++i){
+        const hwc_layer_1_t* layer = &(list->hwLayers[i]);
+        const LayerState& state = m_vLayerState[i];
+
+        if(state.compositionType != layer->compositionType
+           || state.flags != layer->flags
+           || state.transform != layer->transform
+           || state.blending != layer->blending
+           || 0 != memcmp(&state.sourceCrop, &layer->sourceCrop, sizeof(hwc_rect_t))
+           || 0 != memcmp(&state.displayFrame, &layer->displayFrame, sizeof(hwc_rect_t))){
+            bFull = true;
+            break;
+        }
+
+        // a solid color layer fills the whole display, its handle is the color.
+        if(HWC_BACKGROUND == layer->compositionType){
+            bFull = true;
+            break;
+        }
+
+        // overlay layers are not in FB target.
+        if(HWC_OVERLAY == layer->compositionType){
+            continue;
+        }
+
+        // dim layers have no buffer to tell a change, same buffer means same contents.
+        bool bWholeLayer = (NULL == layer->handle) || (state.planeAlpha != layer->planeAlpha);
+        if(!bWholeLayer && state.handle == layer->handle){
+            continue;
+        }
+
+        damage.orSelf(getLayerDamage(layer, bWholeLayer));
+    }
+
+    m_vLayerState.clear();
+    for(uint32_t i = 0; i < nLayers; ++i){
+        const hwc_layer_1_t* layer = &(list->hwLayers[i]);
+        LayerState state;
+        state.handle = layer->handle;
+        state.compositionType = layer->compositionType;
+        state.flags = layer->flags;
+        state.transform = layer->transform;
+        state.blending = layer->blending;
+        state.planeAlpha = layer->planeAlpha;
+        state.sourceCrop = layer->sourceCrop;
+        state.displayFrame = layer->displayFrame;
+        m_vLayerState.add(state);
+    }
+
+    ++m_nFrameCount;
+    Region& history = m_damageHistory[m_nFrameCount % VIRTUAL_DAMAGE_HISTORY];
+    if(bFull){
+        history.set(Rect(crop.left, crop.top, crop.right, crop.bottom));
+    }else{
+        history = damage;
+    }
+}
+
+bool HWVirtualComposer::getStaleRegion(uint32_t nFrame, Region& region)
+{
+    uint32_t nAge = m_nFrameCount - nFrame;
+    if(nAge >= VIRTUAL_DAMAGE_HISTORY){
+        return false;
+    }
+
+    region.clear();
+    for(uint32_t f = nFrame + 1; f != m_nFrameCount + 1; ++f){
+        region.orSelf(m_damageHistory[f % VIRTUAL_DAMAGE_HISTORY]);
+    }
+    return true;
+}
+
+uint32_t HWVirtualComposer::getDirtyRects(const Region& region, const hwc_layer_1_t* src,
+                                          const hwc_layer_1_t* dst, DISP_RECT* pRects)
+{
+    const hwc_rect_t& crop = src->sourceCrop;
+    const hwc_rect_t& frame = dst->displayFrame;
+    int32_t sw = crop.right - crop.left;
+    int32_t sh = crop.bottom - crop.top;
+    int32_t dw = frame.right - frame.left;
+    int32_t dh = frame.bottom - frame.top;
+    if(sw <= 0 || sh <= 0 || dw <= 0 || dh <= 0){
+        return 0;
+    }
+
+    Rect bounds;
+    const Rect* pRect = region.begin();
+    const Rect* pEnd = region.end();
+    if(pEnd - pRect > VIRTUAL_MAX_DIRTY_RECTS){
+        bounds = region.getBounds();
+        pRect = &bounds;
+        pEnd = pRect + 1;
+    }
+
+    uint32_t nCount = 0;
+    for(; pRect != pEnd; ++pRect){
+        // scale into dst, grow 2 pixels for the filter taps.
+        int32_t l = frame.left + (pRect->left - crop.left) * dw / sw - 2;
+        int32_t t = frame.top + (pRect->top - crop.top) * dh / sh - 2;
+        int32_t r = frame.left + ((pRect->right - crop.left) * dw + sw - 1) / sw + 2;
+        int32_t b = frame.top + ((pRect->bottom - crop.top) * dh + sh - 1) / sh + 2;
+
+        pRects[nCount].l = (l < frame.left) ? frame.left : l;
+        pRects[nCount].t = (t < frame.top) ? frame.top : t;
+        pRects[nCount].r = (r > frame.right) ? frame.right : r;
+        pRects[nCount].b = (b > frame.bottom) ? frame.bottom : b;
+
+        if(pRects[nCount].l < pRects[nCount].r && pRects[nCount].t < pRects[nCount].b){
+            ++nCount;
+        }
+    }
+
+    return nCount;
+}
+
+int32_t HWVirtualComposer::submitBlits()
+{
+    if(!m_pGcuEngine->IsDeferred()){
+        return -1;
+    }
+
+    GCUFence pFence = m_pGcuEngine->Submit();
+    if(NULL == pFence){
+        return -1;
+    }
+
+    int64_t nFenceId = m_nFenceStamp + 1;
+    int32_t nFenceFd = m_pFenceManager->createFence(nFenceId);
+    if(nFenceFd < 0){
+        ALOGE("ERROR: create release fence failed, wait GCU fence instead!");
+        m_pGcuEngine->WaitFence(pFence, GCU_FENCE_TIMEOUT_MS);
+        return -1;
+    }
+
+    m_nFenceStamp = nFenceId;
+    m_pFenceWorker->queue(pFence, nFenceId);
+    return nFenceFd;
+}
+
+void HWVirtualComposer::mergeReleaseFence(hwc_layer_1_t* layer, int32_t nFenceFd)
+{
+    int32_t nDupFd = dup(nFenceFd);
+    if(nDupFd < 0){
+        ALOGE("ERROR: dup release fence failed!");
+        return;
+    }
+
+    if(layer->releaseFenceFd < 0){
+        layer->releaseFenceFd = nDupFd;
+        return;
+    }
+
+    int32_t nMergedFd = sync_merge("HWVirtualComposer", layer->releaseFenceFd, nDupFd);
+    if(nMergedFd < 0){
+        ///< keep the newer one, it signals after the older one on our timeline.
+        ALOGE("ERROR: merge release fence failed!");
+        close(layer->releaseFenceFd);
+        layer->releaseFenceFd = nDupFd;
+        return;
+    }
+
+    close(layer->releaseFenceFd);
+    close(nDupFd);
+    layer->releaseFenceFd = nMergedFd;
+}
+
 DISPLAY_SURFACE_ROTATION HWVirtualComposer::resolveDisplayOrientation(uint32_t orientation)
 {
     switch (orientation){
@@ -351,3 +684,76 @@ void HWVirtualComposer::dumpOneFrame(void* frame, uint32_t w, uint32_t h, uint32
         fclose(fp);
     }
 }
+
+GcuFenceWorker::GcuFenceWorker(GcuEngine* pEngine, const sp<HWCFenceManager>& pFenceManager)
+    : Thread(false)
+    , m_pEngine(pEngine)
+    , m_pFenceManager(pFenceManager)
+    , m_bBusy(false)
+{
+}
+
+GcuFenceWorker::~GcuFenceWorker()
+{
+}
+
+void GcuFenceWorker::queue(GCUFence pFence, int64_t nFenceId)
+{
+    Mutex::Autolock lock(m_mutexLock);
+    PendingFence pending;
+    pending.pFence = pFence;
+    pending.nFenceId = nFenceId;
+    m_vPending.add(pending);
+    m_condition.broadcast();
+}
+
+void GcuFenceWorker::drain()
+{
+    Mutex::Autolock lock(m_mutexLock);
+    while(!m_vPending.isEmpty() || m_bBusy){
+        m_condition.wait(m_mutexLock);
+    }
+}
+
+void GcuFenceWorker::stop()
+{
+    requestExit();
+    {
+        Mutex::Autolock lock(m_mutexLock);
+        m_condition.broadcast();
+    }
+    join();
+}
+
+bool GcuFenceWorker::threadLoop()
+{
+    PendingFence pending;
+    {
+        Mutex::Autolock lock(m_mutexLock);
+        while(m_vPending.isEmpty()){
+            ///< only exit when everything queued has been signaled.
+            if(exitPending()){
+                return false;
+            }
+            m_condition.wait(m_mutexLock);
+        }
+
+        pending = m_vPending[0];
+        m_vPending.removeAt(0);
+        m_bBusy = true;
+    }
+
+    ///< on timeout WaitFence drains the GCU, the buffers are idle either way.
+    if(!m_pEngine->WaitFence(pending.pFence, GCU_FENCE_TIMEOUT_MS)){
+        ALOGE("ERROR: release fence %lld signaled after draining the GCU!", pending.nFenceId);
+    }
+    m_pFenceManager->signalFence(pending.nFenceId);
+
+    {
+        Mutex::Autolock lock(m_mutexLock);
+        m_bBusy = false;
+        m_condition.broadcast();
+    }
+
+    return true;
+}
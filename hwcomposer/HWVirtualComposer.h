@@ -28,9 +28,14 @@
 #include <linux/fb.h>
 #include <utils/RefBase.h>
 #include <utils/Log.h>
+#include <utils/Thread.h>
+#include <utils/Vector.h>
+#include <ui/Rect.h>
+#include <ui/Region.h>
 #include <hardware/hardware.h>
 #include <hardware/hwcomposer.h>
 #include "GcuEngine.h"
+#include "HWCFenceManager.h"
 
 namespace android{
 
@@ -47,6 +52,54 @@ enum DISPLAY_CONTENT_MODE{
 };
 
 
+///< frames of primary damage remembered, older output buffers are fully refreshed.
+#define VIRTUAL_DAMAGE_HISTORY      4
+
+///< max clipped sub blits per frame, more dirty rects are merged into their bounds.
+#define VIRTUAL_MAX_DIRTY_RECTS     8
+
+/*
+ * GCU Fence Worker
+ * Waits GCU fences of submitted blits in order, and signals the
+ * matching point on HWCFenceManager's sw_sync timeline.
+ */
+class GcuFenceWorker : public Thread
+{
+public:
+    GcuFenceWorker(GcuEngine* pEngine, const sp<HWCFenceManager>& pFenceManager);
+
+    ~GcuFenceWorker();
+
+    void queue(GCUFence pFence, int64_t nFenceId);
+
+    ///< block until all queued fences are signaled.
+    void drain();
+
+    void stop();
+
+private:
+    typedef struct _PendingFence
+    {
+        GCUFence    pFence;
+        int64_t     nFenceId;
+    }PendingFence;
+
+    bool threadLoop();
+
+private:
+    GcuEngine* m_pEngine;
+
+    sp<HWCFenceManager> m_pFenceManager;
+
+    Vector<PendingFence> m_vPending;
+
+    bool m_bBusy;
+
+    Mutex m_mutexLock;
+
+    Condition m_condition;
+};
+
 class HWVirtualComposer
 {
 public:
@@ -68,7 +121,7 @@ public:
     /*dump
      *
      */
-    void dump(String8& result, char* buffer, int size, bool dumpManager = true){}
+    void dump(String8& result, char* buffer, int size, bool dumpManager = true);
 
     /*set FB info.
      */
@@ -89,19 +142,21 @@ private:
                                                    , m_hFbHandle(NULL)
                                                    , m_nTransform(-1)
         {
+            memset(&m_displayFrame, 0, sizeof(m_displayFrame));
             if(NULL != m_pLayer) {
                 // save important info. Because m_player is just a saved pointer value.
                 // its contents may changed outside, we need save all relative current info now.
                 m_nDisplayMode = (DISPLAY_CONTENT_MODE)m_pLayer->reserved[1];
                 m_nTransform = m_pLayer->transform;
                 m_hFbHandle = m_pLayer->handle;
+                m_displayFrame = m_pLayer->displayFrame;
             }
         }
 
         ~HwcDisplayData()
         {
             m_pLayer = NULL;
-            m_vBuffer.clear();
+            resetBuffers();
         }
 
     public:
@@ -113,6 +168,34 @@ private:
             m_vBuffer.add(buffer);
         }
 
+        ///< which primary frame a cleared buffer holds, false if unknown.
+        bool getBufferFrame(ANativeWindowBuffer* buffer, uint32_t* pFrame){
+            ssize_t index = m_vBufferFrame.indexOfKey(buffer);
+            if(index < 0 || !isBufferCleared(buffer))
+                return false;
+
+            *pFrame = m_vBufferFrame.valueAt(index);
+            return true;
+        }
+
+        void setBufferFrame(ANativeWindowBuffer* buffer, uint32_t nFrame){
+            m_vBufferFrame.replaceValueFor(buffer, nFrame);
+        }
+
+        void clearBufferFrame(ANativeWindowBuffer* buffer){
+            m_vBufferFrame.removeItem(buffer);
+        }
+
+        ///< forget buffer contents, but keep them cleared.
+        void resetBufferFrames(){
+            m_vBufferFrame.clear();
+        }
+
+        void resetBuffers(){
+            m_vBuffer.clear();
+            m_vBufferFrame.clear();
+        }
+
         bool isEqual(const hwc_layer_1_t* layer) const
         {
             if(NULL != layer && NULL != m_pLayer)
@@ -125,14 +208,16 @@ private:
         {
             if (bResetClearStatus
                 || (m_hFbHandle != layer->handle)
-                || (m_nTransform != layer->transform) ){
+                || (m_nTransform != layer->transform)
+                || (0 != memcmp(&m_displayFrame, &layer->displayFrame, sizeof(m_displayFrame))) ){
                 ///< params change, reset all saved cleared buffers.
-                m_vBuffer.clear();
+                resetBuffers();
             }
 
             m_pLayer = layer;
             m_nTransform = m_pLayer->transform;
             m_hFbHandle = m_pLayer->handle;
+            m_displayFrame = m_pLayer->displayFrame;
         }
 
     public:
@@ -148,16 +233,50 @@ private:
         ///< current transform of fb dest.
         uint32_t m_nTransform;
 
+        ///< current display frame of fb dest.
+        hwc_rect_t m_displayFrame;
+
         ///< cleared buffer list of fb dest.
         SortedVector<ANativeWindowBuffer*> m_vBuffer;
+
+        ///< primary frame number each cleared buffer holds.
+        KeyedVector<ANativeWindowBuffer*, uint32_t> m_vBufferFrame;
     };
 
+    ///< primary layer state of the last composed frame, to find what changed.
+    typedef struct _LayerState
+    {
+        buffer_handle_t handle;
+        int32_t         compositionType;
+        uint32_t        flags;
+        uint32_t        transform;
+        int32_t         blending;
+        uint8_t         planeAlpha;
+        hwc_rect_t      sourceCrop;
+        hwc_rect_t      displayFrame;
+    }LayerState;
+
 private:
 
     bool readyToRun(size_t numDisplays, hwc_display_contents_1_t** displays);
 
     bool blit(hwc_layer_1_t* src, sp<HwcDisplayData>& displayData);
 
+    ///< accumulate what changed on primary since the last composed frame.
+    void updateFrameDamage(hwc_display_contents_1_t* list);
+
+    ///< region of primary a buffer holding nFrame misses, false if fully stale.
+    bool getStaleRegion(uint32_t nFrame, Region& region);
+
+    ///< map primary stale region to dirty rects in virtual display coordinates.
+    uint32_t getDirtyRects(const Region& region, const hwc_layer_1_t* src,
+                           const hwc_layer_1_t* dst, DISP_RECT* pRects);
+
+    ///< kick off queued blits, return a sw_sync fence fd or -1 if already done.
+    int32_t submitBlits();
+
+    void mergeReleaseFence(hwc_layer_1_t* layer, int32_t nFenceFd);
+
     DISPLAY_SURFACE_ROTATION resolveDisplayOrientation(uint32_t orientation);
 
     void dumpOneFrame(void* frame, uint32_t w, uint32_t h, uint32_t format);
@@ -170,6 +289,27 @@ private:
 
     GcuEngine*     m_pGcuEngine;
 
+    ///< release/acquire fences of fenced (non-blocking) blits.
+    sp<HWCFenceManager> m_pFenceManager;
+
+    sp<GcuFenceWorker> m_pFenceWorker;
+
+    int64_t m_nFenceStamp;
+
+    ///< primary frames composed, and what each of the last ones damaged.
+    uint32_t m_nFrameCount;
+
+    Region m_damageHistory[VIRTUAL_DAMAGE_HISTORY];
+
+    Vector<LayerState> m_vLayerState;
+
+    ///< stats
+    uint32_t m_nFullBlits;
+
+    uint32_t m_nPartialBlits;
+
+    uint32_t m_nSkippedBlits;
+
     const fb_var_screeninfo* m_pDefaultDisplayInfo;
 
     DefaultKeyedVector<uint32_t, sp<HwcDisplayData> > m_displays;
@@ -95,7 +95,7 @@ struct hwc_context_t {
     HWBaselayComposer *baseComposer;
 #endif
 
-    HWCFenceManager *pFenceManager;
+    sp<HWCFenceManager> pFenceManager;
 
     hwc_procs_t *procs;
     bool skip;
@@ -226,6 +226,13 @@ static int hwc_set(struct hwc_composer_device_1 *dev,
                 {
                     ctx->fbdev[i]->post(ctx->fbdev[i], displays[i]->hwLayers[displays[i]->numHwLayers - 1].handle);
                 }
+#if defined(ENABLE_OVERLAY) || defined(ENABLE_WFD_OPTIMIZATION)
+                /* Retire this frame on the vsync it is scanned out, so SF can queue one more frame. */
+                if(ctx->pFenceManager.get() && displays[i]->retireFenceFd < 0)
+                {
+                    displays[i]->retireFenceFd = ctx->pFenceManager->createRetireFence(i);
+                }
+#endif
             }
         }
     }
@@ -412,6 +419,13 @@ static void hwc_dump(hwc_composer_device_1_t *dev,
         strncpy(buff, result.string(), buff_len - 1);
     }
 #endif
+#if defined(ENABLE_OVERLAY) || defined(ENABLE_WFD_OPTIMIZATION)
+    if(ctx->pFenceManager.get()){
+        result.append("--------------- HWC Fence Manager Info ---------------\n");
+        ctx->pFenceManager->dump(result, buffer, 1024);
+        strncpy(buff, result.string(), buff_len - 1);
+    }
+#endif
 }
 
 static int hwc_query(hwc_composer_device_1_t *dev,
@@ -477,6 +491,9 @@ static int hwc_device_close(struct hw_device_t *dev)
             delete ctx->baseComposer;
         }
 #endif
+#if defined(ENABLE_OVERLAY) || defined(ENABLE_WFD_OPTIMIZATION)
+        ctx->pFenceManager.clear();
+#endif
 
         for(int i = 0; i <= HWC_NUM_DISPLAY_TYPES; i++)
         {
@@ -548,6 +565,9 @@ static int hwc_device_open(const struct hw_module_t* module, const char* name,
 #ifdef ENABLE_WFD_OPTIMIZATION
         dev->virtualComposer = new HWVirtualComposer();
 #endif
+#if defined(ENABLE_OVERLAY) || defined(ENABLE_WFD_OPTIMIZATION)
+        dev->pFenceManager = new HWCFenceManager();
+#endif
 #ifdef ENABLE_HWC_GC_PATH
         dev->baseComposer = new HWBaselayComposer();
         int st = dev->baseComposer->open(name, NULL);
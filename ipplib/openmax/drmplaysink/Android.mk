@@ -33,3 +33,25 @@ LOCAL_SHARED_LIBRARIES := libmedia libutils libsurfaceflinger_client libcutils l
 LOCAL_MODULE := libdrmplaysink
 LOCAL_MODULE_TAGS := optional
 include $(BUILD_SHARED_LIBRARY)
+
+include $(CLEAR_VARS)
+
+LOCAL_C_INCLUDES += \
+        $(LOCAL_PATH)   \
+        vendor/marvell/generic/libstagefrighthw/renderer \
+        vendor/marvell/generic/ipplib/openmax/include \
+        frameworks/base/include \
+        frameworks/base/include/media/stagefright/openmax \
+        frameworks/base/media/libstagefright/include \
+        hardware/libhardware/include \
+        system/core/include
+
+LOCAL_CFLAGS += -mabi=aapcs-linux
+
+LOCAL_SRC_FILES:= \
+drmplayer_video_render_test.cpp
+
+LOCAL_SHARED_LIBRARIES := libdrmplaysink libutils libui libcutils libsurfaceflinger_client libstagefright libmedia
+LOCAL_MODULE := drmplayer_video_render_test
+LOCAL_MODULE_TAGS := tests
+include $(BUILD_EXECUTABLE)
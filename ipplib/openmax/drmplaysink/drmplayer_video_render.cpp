@@ -7,13 +7,9 @@
 #include <media/stagefright/MediaDefs.h>
 #include <media/stagefright/MetaData.h>
 #include <media/stagefright/foundation/ADebug.h>
-#include <utils/List.h>
 #include <utils/Vector.h>
 #include <utils/RefBase.h>
-#include "AwesomePlayer.h"
-#include "OMX_IVCommon.h"
-#include "IppOmxDrmPlayerExt.h"
-#include "OMX_Core.h"
+#include "drmplayer_video_render.h"
 
 #include <surfaceflinger/ISurface.h>
 #include <surfaceflinger/Surface.h>
@@ -60,116 +56,192 @@ static FILE* fp_dump = NULL;
 
 using namespace android;
 
-enum GraphicBufferStatus {
-    OWNED_BY_RENDER,
-    OWNED_BY_NATIVE_WINDOW,
-    WAIT_FOR_PROVIDE,       // Graphics buffer have been dequeued, wait for provide to OMX
-};
+uint32_t GraphicBufferTable::hash(buffer_handle_t handle){
+    // handles are heap pointers, the low bits carry no information
+    return ((uint32_t)(uintptr_t)handle >> 3) * 2654435761u;
+}
 
-typedef struct AllocatedBufferInfo {
-    sp<GraphicBuffer> mGraphicBuffer;
-    GraphicBufferStatus mStatus;
-}AllocatedBufferInfo;
+void GraphicBufferTable::clear(){
+    for (int i = 0; i < mSize; i++){
+        mSlots[i].mGraphicBuffer.clear();
+    }
+    for (int i = 0; i < GRAPHIC_BUFFER_STATUS_COUNT; i++){
+        mHead[i] = mTail[i] = DRM_GRAPHIC_BUFFER_NONE;
+        mCount[i] = 0;
+    }
+    for (int i = 0; i < DRM_GRAPHIC_BUFFER_HASH; i++){
+        mHashHandle[i] = NULL;
+        mHashSlot[i] = DRM_GRAPHIC_BUFFER_NONE;
+    }
+    mSize = 0;
+}
+
+void GraphicBufferTable::link(int slot){
+    AllocatedBufferInfo &info = mSlots[slot];
 
-struct DrmPlayerNativeWindowRenderer : public AwesomeRenderer {
-    DrmPlayerNativeWindowRenderer(int32_t rotationDegrees){
-        applyRotation(rotationDegrees);
-        mDecodedWidth = 0;
-        mDecodedHeight = 0;
-        mDisplayWidth = 0;
-        mDisplayHeight = 0;
-        mColorFormat = OMX_COLOR_FormatCbYCrY;
-        LOGD("----- 2011.11.17 DrmPlayerNativeWindowRenderer Ver 1.1 -----");
+    info.mPrev = mTail[info.mStatus];
+    info.mNext = DRM_GRAPHIC_BUFFER_NONE;
+    if(info.mPrev != DRM_GRAPHIC_BUFFER_NONE){
+        mSlots[info.mPrev].mNext = slot;
+    }else{
+        mHead[info.mStatus] = slot;
     }
+    mTail[info.mStatus] = slot;
+    mCount[info.mStatus]++;
+}
+
+void GraphicBufferTable::unlink(int slot){
+    AllocatedBufferInfo &info = mSlots[slot];
 
-    virtual void render(MediaBuffer *buffer) {
+    if(info.mPrev != DRM_GRAPHIC_BUFFER_NONE){
+        mSlots[info.mPrev].mNext = info.mNext;
+    }else{
+        mHead[info.mStatus] = info.mNext;
     }
+    if(info.mNext != DRM_GRAPHIC_BUFFER_NONE){
+        mSlots[info.mNext].mPrev = info.mPrev;
+    }else{
+        mTail[info.mStatus] = info.mPrev;
+    }
+    mCount[info.mStatus]--;
+}
 
-    void render(android_native_buffer_t* buffer){
-        if(buffer == NULL){
-            LOGE("render failed: bad parameter!");
-        }
+int GraphicBufferTable::add(const sp<GraphicBuffer> &graphicBuffer, GraphicBufferStatus status){
+    buffer_handle_t handle = graphicBuffer->handle;
+    uint32_t h;
 
-        android_native_buffer_t* buf = buffer;
-        status_t err = mNativeWindow->queueBuffer(mNativeWindow.get(), buf);
+    if(mSize == DRM_GRAPHIC_BUFFER_MAX || find(handle) != DRM_GRAPHIC_BUFFER_NONE){
+        return DRM_GRAPHIC_BUFFER_NONE;
+    }
 
-#ifdef PERF
-        clock_gettime(CLOCK_REALTIME, &t_stop_base);
-        render_interval = ((GET_TIME_INTERVAL_USEC(t_start_base, t_stop_base)));
-        if(frameCount > 0){
-            if((oldDisplayWidth==mDisplayWidth)&&(oldDisplayHeight==mDisplayHeight)){
-                LOGD("----- w = %d, h = %d, render interval = %ld us -----", mDisplayWidth, mDisplayHeight, render_interval);
-            }else{
-                LOGD("----- Resolution changed! w = %d, h = %d, render interval = %ld us -----", mDisplayWidth, mDisplayHeight, render_interval);
-            }
-            time_tot_base += render_interval;
-        }
-        oldDisplayWidth = mDisplayWidth;
-        oldDisplayHeight = mDisplayHeight;
-        t_start_base = t_stop_base;
-        frameCount++;
-#endif
+    int slot = mSize++;
+    AllocatedBufferInfo &info = mSlots[slot];
+    info.mGraphicBuffer = graphicBuffer;
+    info.mStatus = status;
+    info.mHeaderIndex = DRM_GRAPHIC_BUFFER_NONE;
+    link(slot);
 
-        if (err != 0) {
-            LOGE("queueBuffer failed with error %s (%d)", strerror(-err), -err);
-            return;
-        }
+    // the table is never more than half full, a free bucket is always found
+    for (h = hash(handle); mHashSlot[h & (DRM_GRAPHIC_BUFFER_HASH - 1)] != DRM_GRAPHIC_BUFFER_NONE; h++){
+    }
+    mHashHandle[h & (DRM_GRAPHIC_BUFFER_HASH - 1)] = handle;
+    mHashSlot[h & (DRM_GRAPHIC_BUFFER_HASH - 1)] = slot;
+    return slot;
+}
 
-        for (List<AllocatedBufferInfo>::iterator it = mGraphicBuffersAllocated.begin();
-            it != mGraphicBuffersAllocated.end(); ++it){
-            if(((*it).mGraphicBuffer)->handle == buf->handle){
-                (*it).mStatus = OWNED_BY_NATIVE_WINDOW;
-                break;
-            }
+int GraphicBufferTable::find(buffer_handle_t handle) const{
+    uint32_t h;
+
+    for (h = hash(handle); mHashSlot[h & (DRM_GRAPHIC_BUFFER_HASH - 1)] != DRM_GRAPHIC_BUFFER_NONE; h++){
+        if(mHashHandle[h & (DRM_GRAPHIC_BUFFER_HASH - 1)] == handle){
+            return mHashSlot[h & (DRM_GRAPHIC_BUFFER_HASH - 1)];
         }
     }
+    return DRM_GRAPHIC_BUFFER_NONE;
+}
+
+void GraphicBufferTable::setStatus(int slot, GraphicBufferStatus status){
+    if(mSlots[slot].mStatus == status){
+        return;
+    }
+    unlink(slot);
+    mSlots[slot].mStatus = status;
+    link(slot);
+}
 
-    void render(
-        const void *data, size_t size, void *platformPrivate){
-    }
-
-    status_t init();
-    status_t allocateOutputBuffersFromNativeWindow(int &nBfferCount);
-    status_t getGraphicBufferInfo(int nIndex, char ** ppVirAddress, char ** ppPhyAddress, void **pBufferHandle);
-    status_t destroyNativeWindow();
-    status_t reconfigNativeWindow();
-    status_t returnAllGraphicsBuffers(int *pNum);
-    status_t getNewGraphicsBuffer(void** pBufferHandle);
-    status_t getProvideGraphicsBuffer(void** pBufferHandle);
-    status_t configSurface(DRM_CONFIG_SET_SURFACE *pSurfaceSet);
-
-//protected:
-    ~DrmPlayerNativeWindowRenderer() {
-    }
-    int32_t mDecodedWidth, mDecodedHeight;
-    int32_t mDisplayWidth, mDisplayHeight;
-    OMX_COLOR_FORMATTYPE mColorFormat;
-private:
-    sp<SurfaceComposerClient> mSurfCC;
-    sp<SurfaceControl> mSurfCtrl;
-    sp<ANativeWindow> mNativeWindow;
-    List<AllocatedBufferInfo> mGraphicBuffersAllocated;
-
-    void applyRotation(int32_t rotationDegrees) {
-        uint32_t transform;
-        switch (rotationDegrees) {
-            case 0: transform = 0; break;
-            case 90: transform = HAL_TRANSFORM_ROT_90; break;
-            case 180: transform = HAL_TRANSFORM_ROT_180; break;
-            case 270: transform = HAL_TRANSFORM_ROT_270; break;
-            default: transform = 0; break;
+// index of the header of the buffer with this handle in pBufferQ, -1 if none
+static int findHeaderIndex(buffer_handle_t handle, OMX_BUFFERHEADERTYPE **pBufferQ, int bufferCount){
+    for (int i = 0; i < bufferCount; i++){
+        if(pBufferQ[i] == NULL){
+            LOGE(" ACCESS NULL POINTER i=%d ", i);
+            continue;
         }
+        if(((android_native_buffer_t*)(pBufferQ[i]->pAppPrivate))->handle == handle){
+            return i;
+        }
+    }
+    return -1;
+}
+
+OMX_BUFFERHEADERTYPE *GraphicBufferTable::getHeader(int slot, OMX_BUFFERHEADERTYPE **pBufferQ, int bufferCount){
+    buffer_handle_t handle = mSlots[slot].mGraphicBuffer->handle;
+    int i = mSlots[slot].mHeaderIndex;
+
+    // the queue belongs to the decoder, check the header is still there
+    if(i >= 0 && i < bufferCount && pBufferQ[i] != NULL &&
+       ((android_native_buffer_t*)(pBufferQ[i]->pAppPrivate))->handle == handle){
+        return pBufferQ[i];
+    }
 
-        if (transform) {
-            CHECK_EQ(0, native_window_set_buffers_transform(
-                        mNativeWindow.get(), transform));
+    i = findHeaderIndex(handle, pBufferQ, bufferCount);
+    if(i < 0){
+        return NULL;
+    }
+    mSlots[slot].mHeaderIndex = i;
+    return pBufferQ[i];
+}
+
+DrmPlayerNativeWindowRenderer::DrmPlayerNativeWindowRenderer(int32_t rotationDegrees){
+    applyRotation(rotationDegrees);
+    mDecodedWidth = 0;
+    mDecodedHeight = 0;
+    mDisplayWidth = 0;
+    mDisplayHeight = 0;
+    mColorFormat = OMX_COLOR_FormatCbYCrY;
+    LOGD("----- 2011.11.17 DrmPlayerNativeWindowRenderer Ver 1.1 -----");
+}
+
+void DrmPlayerNativeWindowRenderer::render(android_native_buffer_t* buffer){
+    if(buffer == NULL){
+        LOGE("render failed: bad parameter!");
+    }
+
+    android_native_buffer_t* buf = buffer;
+    status_t err = mNativeWindow->queueBuffer(mNativeWindow.get(), buf);
+
+#ifdef PERF
+    clock_gettime(CLOCK_REALTIME, &t_stop_base);
+    render_interval = ((GET_TIME_INTERVAL_USEC(t_start_base, t_stop_base)));
+    if(frameCount > 0){
+        if((oldDisplayWidth==mDisplayWidth)&&(oldDisplayHeight==mDisplayHeight)){
+            LOGD("----- w = %d, h = %d, render interval = %ld us -----", mDisplayWidth, mDisplayHeight, render_interval);
+        }else{
+            LOGD("----- Resolution changed! w = %d, h = %d, render interval = %ld us -----", mDisplayWidth, mDisplayHeight, render_interval);
         }
+        time_tot_base += render_interval;
     }
+    oldDisplayWidth = mDisplayWidth;
+    oldDisplayHeight = mDisplayHeight;
+    t_start_base = t_stop_base;
+    frameCount++;
+#endif
 
-    DrmPlayerNativeWindowRenderer(const DrmPlayerNativeWindowRenderer &);
-    DrmPlayerNativeWindowRenderer &operator=(
-            const DrmPlayerNativeWindowRenderer &);
-};
+    if (err != 0) {
+        LOGE("queueBuffer failed with error %s (%d)", strerror(-err), -err);
+        return;
+    }
+
+    int slot = mGraphicBuffersAllocated.find(buf->handle);
+    if(slot != DRM_GRAPHIC_BUFFER_NONE){
+        mGraphicBuffersAllocated.setStatus(slot, OWNED_BY_NATIVE_WINDOW);
+    }
+}
+
+void DrmPlayerNativeWindowRenderer::applyRotation(int32_t rotationDegrees) {
+    uint32_t transform;
+    switch (rotationDegrees) {
+        case 0: transform = 0; break;
+        case 90: transform = HAL_TRANSFORM_ROT_90; break;
+        case 180: transform = HAL_TRANSFORM_ROT_180; break;
+        case 270: transform = HAL_TRANSFORM_ROT_270; break;
+        default: transform = 0; break;
+    }
+
+    if (transform) {
+        CHECK_EQ(0, native_window_set_buffers_transform(
+                    mNativeWindow.get(), transform));
+    }
+}
 
 status_t DrmPlayerNativeWindowRenderer::init(){
     status_t state;
@@ -234,6 +306,16 @@ status_t DrmPlayerNativeWindowRenderer::init(){
     return OK;
 }
 
+status_t DrmPlayerNativeWindowRenderer::init(const sp<ANativeWindow> &nativeWindow){
+    if(nativeWindow == NULL){
+        LOGE("#%d - no native window", __LINE__);
+        return -1;
+    }
+
+    mNativeWindow = nativeWindow;
+    return OK;
+}
+
 status_t DrmPlayerNativeWindowRenderer::allocateOutputBuffersFromNativeWindow(int &nBufferCount){
     int halFmt = 0;
     status_t err;
@@ -301,6 +383,10 @@ status_t DrmPlayerNativeWindowRenderer::allocateOutputBuffersFromNativeWindow(in
     // buffer counts refer to - how do they account for the renderer holding on
     // to buffers?
     int newBufferCount = nBufferCount + minUndequeuedBufs;
+    if(newBufferCount > DRM_GRAPHIC_BUFFER_MAX){
+        LOGE("%d buffers requested, at most %d can be tracked", newBufferCount, DRM_GRAPHIC_BUFFER_MAX);
+        return NO_MEMORY;
+    }
 
     err = native_window_set_buffer_count(
             mNativeWindow.get(), newBufferCount);
@@ -323,16 +409,17 @@ status_t DrmPlayerNativeWindowRenderer::allocateOutputBuffersFromNativeWindow(in
 
         sp<GraphicBuffer> graphicBuffer(new GraphicBuffer(buf, false));
 
-        AllocatedBufferInfo info;
-        info.mGraphicBuffer = graphicBuffer;
-        info.mStatus = WAIT_FOR_PROVIDE;
-
         // mGraphicBuffersAllocated record the entries of the buffers have been allocated..
-        mGraphicBuffersAllocated.push_back(info);
+        if(mGraphicBuffersAllocated.add(graphicBuffer, WAIT_FOR_PROVIDE) == DRM_GRAPHIC_BUFFER_NONE){
+            LOGE("dequeueBuffer returned a buffer already allocated");
+            mNativeWindow->cancelBuffer(mNativeWindow.get(), buf);
+            err = -1;
+            break;
+        }
     }
 
-    OMX_U32 cancelStart;
-    OMX_U32 cancelEnd;
+    int cancelStart;
+    int cancelEnd;
 
     if (err != 0) {
         // If an error occurred while dequeuing we need to cancel any buffers
@@ -345,85 +432,82 @@ status_t DrmPlayerNativeWindowRenderer::allocateOutputBuffersFromNativeWindow(in
         cancelEnd = newBufferCount;
     }
 
-    unsigned int i=0;
-    for (List<AllocatedBufferInfo>::iterator it = mGraphicBuffersAllocated.begin();
-         it != mGraphicBuffersAllocated.end(); ++it,i++){
-         if(i>=cancelStart && i < cancelEnd){
-            int err = mNativeWindow->cancelBuffer(mNativeWindow.get(), (*it).mGraphicBuffer.get());
-            if (err != 0) {
-                LOGE("cancelBuffer failed w/ error 0x%08x", err);
-                return err;
-            }
-            (*it).mStatus = OWNED_BY_NATIVE_WINDOW;
-         }
+    if(cancelEnd > mGraphicBuffersAllocated.size()){
+        cancelEnd = mGraphicBuffersAllocated.size();
+    }
+    for (int i = cancelStart; i < cancelEnd; i++){
+        int err = mNativeWindow->cancelBuffer(mNativeWindow.get(), mGraphicBuffersAllocated[i].mGraphicBuffer.get());
+        if (err != 0) {
+            LOGE("cancelBuffer failed w/ error 0x%08x", err);
+            return err;
+        }
+        mGraphicBuffersAllocated.setStatus(i, OWNED_BY_NATIVE_WINDOW);
     }
 
     return OK;
 }
 
 status_t DrmPlayerNativeWindowRenderer::getGraphicBufferInfo(int nIndex, char ** ppVirAddress, char ** ppPhyAddress, void **pBufferHandle){
-    int i = 0;
     status_t state;
 
-    for (List<AllocatedBufferInfo>::iterator it = mGraphicBuffersAllocated.begin();
-         it != mGraphicBuffersAllocated.end(); ++it,i++){
-         if(i==nIndex){
-            sp<GraphicBuffer> graphicBuffer = (*it).mGraphicBuffer;
-            void* vaddr;
+    if(nIndex < 0 || nIndex >= mGraphicBuffersAllocated.size()){
+        LOGE("getGraphicBufferInfo failed.");
+        return -1;
+    }
 
-            android_native_buffer_t* bufHandle = graphicBuffer->getNativeBuffer();
-            // return the buffer handle of the graphicBuffer
-            *pBufferHandle = bufHandle;
+    sp<GraphicBuffer> graphicBuffer = mGraphicBuffersAllocated[nIndex].mGraphicBuffer;
+    void* vaddr;
 
-            private_handle_t *priHandle = private_handle_t::dynamicCast(bufHandle->handle);
-            if(priHandle == NULL){
-                LOGE("getGraphicBufferInfo dynamicCast() failed.");
-            }
+    android_native_buffer_t* bufHandle = graphicBuffer->getNativeBuffer();
+    // return the buffer handle of the graphicBuffer
+    *pBufferHandle = bufHandle;
 
-            unsigned long paddr = priHandle->physAddr;
-            unsigned long usage = GRALLOC_USAGE_SW_READ_OFTEN|GRALLOC_USAGE_SW_WRITE_OFTEN;
-            state = graphicBuffer->lock(usage, &vaddr);
-            if(state){
-                LOGE("getGraphicBufferInfo() : lock graphic buffer failed.");
-                return state;
-            }
+    private_handle_t *priHandle = private_handle_t::dynamicCast(bufHandle->handle);
+    if(priHandle == NULL){
+        LOGE("getGraphicBufferInfo dynamicCast() failed.");
+    }
 
-            (*ppPhyAddress) = (char*)paddr;
-            (*ppVirAddress) = (char*)vaddr;
-            return 0;
-         }
+    unsigned long paddr = priHandle->physAddr;
+    unsigned long usage = GRALLOC_USAGE_SW_READ_OFTEN|GRALLOC_USAGE_SW_WRITE_OFTEN;
+    state = graphicBuffer->lock(usage, &vaddr);
+    if(state){
+        LOGE("getGraphicBufferInfo() : lock graphic buffer failed.");
+        return state;
     }
 
-    LOGE("getGraphicBufferInfo failed.");
-    return -1;
+    (*ppPhyAddress) = (char*)paddr;
+    (*ppVirAddress) = (char*)vaddr;
+    return 0;
 }
 
 status_t DrmPlayerNativeWindowRenderer::destroyNativeWindow(){
     int err;
 
-    for (List<AllocatedBufferInfo>::iterator it = mGraphicBuffersAllocated.begin();
-        it != mGraphicBuffersAllocated.end(); ++it){
+    for (int i = 0; i < mGraphicBuffersAllocated.size(); i++){
 
-        sp<GraphicBuffer> graphicBuffer = (*it).mGraphicBuffer;
+        sp<GraphicBuffer> graphicBuffer = mGraphicBuffersAllocated[i].mGraphicBuffer;
         err = graphicBuffer->unlock();
         if(err){
             LOGE("destroyNativeWindow() : unlock graphic buffer failed.");
             return err;
         }
 
-        if(OWNED_BY_RENDER == (*it).mStatus){
+        if(OWNED_BY_RENDER == mGraphicBuffersAllocated[i].mStatus){
             err = mNativeWindow->cancelBuffer(mNativeWindow.get(), graphicBuffer.get());
             if (err != 0) {
                 LOGE("cancelBuffer failed w/ error 0x%08x", err);
                 return err;
             }
-            (*it).mStatus = OWNED_BY_NATIVE_WINDOW;
+            mGraphicBuffersAllocated.setStatus(i, OWNED_BY_NATIVE_WINDOW);
         }
     }
 
     mGraphicBuffersAllocated.clear();
-    mSurfCC->dispose();
-    mSurfCC.clear();
+    // not there when rendering to a native window given to init()
+    if(mSurfCC != NULL){
+        mSurfCC->dispose();
+        mSurfCC.clear();
+    }
     mSurfCtrl.clear();
     mNativeWindow.clear();
 
@@ -433,23 +517,22 @@ status_t DrmPlayerNativeWindowRenderer::destroyNativeWindow(){
 status_t DrmPlayerNativeWindowRenderer::reconfigNativeWindow(){
     int err;
 
-    for (List<AllocatedBufferInfo>::iterator it = mGraphicBuffersAllocated.begin();
-        it != mGraphicBuffersAllocated.end(); ++it){
+    for (int i = 0; i < mGraphicBuffersAllocated.size(); i++){
 
-        sp<GraphicBuffer> graphicBuffer = (*it).mGraphicBuffer;
+        sp<GraphicBuffer> graphicBuffer = mGraphicBuffersAllocated[i].mGraphicBuffer;
         err = graphicBuffer->unlock();
         if(err){
             LOGE("reconfigNativeWindow() : unlock graphic buffer failed.");
             return err;
         }
 
-        if(OWNED_BY_RENDER == (*it).mStatus){
+        if(OWNED_BY_RENDER == mGraphicBuffersAllocated[i].mStatus){
             err = mNativeWindow->cancelBuffer(mNativeWindow.get(), graphicBuffer.get());
             if (err != 0) {
                 LOGE("cancelBuffer failed w/ error 0x%08x", err);
                 return err;
             }
-            (*it).mStatus = OWNED_BY_NATIVE_WINDOW;
+            mGraphicBuffersAllocated.setStatus(i, OWNED_BY_NATIVE_WINDOW);
         }
     }
 
@@ -459,22 +542,20 @@ status_t DrmPlayerNativeWindowRenderer::reconfigNativeWindow(){
 }
 
 status_t DrmPlayerNativeWindowRenderer::returnAllGraphicsBuffers(int *pNum){
-    int err;
     int Count = 0;
+    int slot;
 
-    for (List<AllocatedBufferInfo>::iterator it = mGraphicBuffersAllocated.begin();
-        it != mGraphicBuffersAllocated.end(); ++it){
-        if(OWNED_BY_RENDER == (*it).mStatus){
-            (*it).mStatus = WAIT_FOR_PROVIDE;
-            Count++;
-        }
+    // in the order the decoder got them, so they are provided again in that order
+    while ((slot = mGraphicBuffersAllocated.first(OWNED_BY_RENDER)) != DRM_GRAPHIC_BUFFER_NONE){
+        mGraphicBuffersAllocated.setStatus(slot, WAIT_FOR_PROVIDE);
+        Count++;
     }
     *pNum = Count;
     LOGD("Total %d buffers wait for provide.", Count);
     return OK;
 }
 
-status_t DrmPlayerNativeWindowRenderer::getNewGraphicsBuffer(void** pBufferHandle){
+status_t DrmPlayerNativeWindowRenderer::getNewGraphicsBuffer(void** pBufferHandle, int *pSlot){
     int err;
     android_native_buffer_t* newBuf = NULL;
 
@@ -484,12 +565,9 @@ status_t DrmPlayerNativeWindowRenderer::getNewGraphicsBuffer(void** pBufferHandl
         return err;
     }
 
-    for (List<AllocatedBufferInfo>::iterator it = mGraphicBuffersAllocated.begin();
-         it != mGraphicBuffersAllocated.end(); ++it){
-        if(((*it).mGraphicBuffer)->handle == newBuf->handle){
-            (*it).mStatus = OWNED_BY_RENDER;
-            break;
-        }
+    int slot = mGraphicBuffersAllocated.find(newBuf->handle);
+    if(slot != DRM_GRAPHIC_BUFFER_NONE){
+        mGraphicBuffersAllocated.setStatus(slot, OWNED_BY_RENDER);
     }
 
     err = mNativeWindow->lockBuffer(mNativeWindow.get(), newBuf);
@@ -500,20 +578,18 @@ status_t DrmPlayerNativeWindowRenderer::getNewGraphicsBuffer(void** pBufferHandl
     }
 
     (*pBufferHandle) = newBuf;
+    (*pSlot) = slot;
     return OK;
 }
 
-status_t DrmPlayerNativeWindowRenderer::getProvideGraphicsBuffer(void** pBufferHandle){
+status_t DrmPlayerNativeWindowRenderer::getProvideGraphicsBuffer(void** pBufferHandle, int *pSlot){
     int err;
     android_native_buffer_t* provideBuf = NULL;
 
-    for (List<AllocatedBufferInfo>::iterator it = mGraphicBuffersAllocated.begin();
-         it != mGraphicBuffersAllocated.end(); ++it){
-        if(WAIT_FOR_PROVIDE == (*it).mStatus){
-            (*it).mStatus = OWNED_BY_RENDER;
-            provideBuf = (*it).mGraphicBuffer->getNativeBuffer();
-            break;
-        }
+    int slot = mGraphicBuffersAllocated.first(WAIT_FOR_PROVIDE);
+    if(slot != DRM_GRAPHIC_BUFFER_NONE){
+        mGraphicBuffersAllocated.setStatus(slot, OWNED_BY_RENDER);
+        provideBuf = mGraphicBuffersAllocated[slot].mGraphicBuffer->getNativeBuffer();
     }
 
     if(provideBuf == NULL){
@@ -528,13 +604,29 @@ status_t DrmPlayerNativeWindowRenderer::getProvideGraphicsBuffer(void** pBufferH
     }
 
     (*pBufferHandle) = provideBuf;
+    (*pSlot) = slot;
     return OK;
 }
 
+OMX_BUFFERHEADERTYPE *DrmPlayerNativeWindowRenderer::getBufferHeader(int nSlot, void *pBufferHandle, OMX_BUFFERHEADERTYPE **pBufferQ, int bufferCount){
+    if(nSlot >= 0 && nSlot < mGraphicBuffersAllocated.size()){
+        return mGraphicBuffersAllocated.getHeader(nSlot, pBufferQ, bufferCount);
+    }
+
+    // a buffer the window never gave us at allocation, look for it as before
+    int i = findHeaderIndex(((android_native_buffer_t*)pBufferHandle)->handle, pBufferQ, bufferCount);
+    return i < 0 ? NULL : pBufferQ[i];
+}
+
 
 status_t DrmPlayerNativeWindowRenderer::configSurface(DRM_CONFIG_SET_SURFACE *pSurfaceSet){
     int err = NO_ERROR;
 
+    if(mSurfCC == NULL || mSurfCtrl == NULL){
+        LOGE("configSurface failed, no surface of our own");
+        return NO_INIT;
+    }
+
     err = mSurfCC->openTransaction();
     if (err != NO_ERROR) {
         LOGE("openTransaction failed w/ error 0x%08x", err);
@@ -647,34 +739,26 @@ extern "C" int drmplayer_videorender_getNewGraphicsBuffer(void *pRenderHandle, i
         return -1;
     }
 
-    int i;
+    int slot;
     void * pBufHandle=NULL;
 
     DrmPlayerNativeWindowRenderer *pDrmPlayerRenderHandle = ( DrmPlayerNativeWindowRenderer *)pRenderHandle;
     OMX_BUFFERHEADERTYPE** pBufferQ = (OMX_BUFFERHEADERTYPE**)pVideoDecoderOutBufferQ;
 
     if(pDrmPlayerRenderHandle){
-        int err = pDrmPlayerRenderHandle->getNewGraphicsBuffer(&pBufHandle);
+        int err = pDrmPlayerRenderHandle->getNewGraphicsBuffer(&pBufHandle, &slot);
 
         if(err){
             LOGE("drmplayer_videorender_getNewGraphicsBuffer() : getNewGraphicBuffer() failed!");
             return -1;
         }
 
-        for (i=0; i<bufferCount; i++){
-            if(pBufferQ[i]==NULL){
-                LOGE(" ACCESS NULL POINTER i=%d ", i);
-            }
-            if(((android_native_buffer_t*)(pBufferQ[i]->pAppPrivate))->handle == ((android_native_buffer_t*)pBufHandle)->handle){
-                (*pNewBufferHeader) = pBufferQ[i];
-                break;
-            }
-        }
-
-        if(i == bufferCount){
+        OMX_BUFFERHEADERTYPE *pHeader = pDrmPlayerRenderHandle->getBufferHeader(slot, pBufHandle, pBufferQ, bufferCount);
+        if(pHeader == NULL){
             LOGE("drmplayer_videorender_getNewGraphicsBuffer() : find new buffer header failed!");
             return -1;
         }
+        (*pNewBufferHeader) = pHeader;
     }
 
     return 0;
@@ -686,34 +770,26 @@ extern "C" int drmplayer_videorender_getProvideGraphicsBuffer(void *pRenderHandl
         return -1;
     }
 
-    int i;
+    int slot;
     void * pBufHandle=NULL;
 
     DrmPlayerNativeWindowRenderer *pDrmPlayerRenderHandle = ( DrmPlayerNativeWindowRenderer *)pRenderHandle;
     OMX_BUFFERHEADERTYPE** pBufferQ = (OMX_BUFFERHEADERTYPE**)pVideoDecoderOutBufferQ;
 
     if(pDrmPlayerRenderHandle){
-        int err = pDrmPlayerRenderHandle->getProvideGraphicsBuffer(&pBufHandle);
+        int err = pDrmPlayerRenderHandle->getProvideGraphicsBuffer(&pBufHandle, &slot);
 
         if(err){
             LOGE("drmplayer_videorender_getProvideGraphicsBuffer() : getProvideGraphicsBuffer() failed!");
             return -1;
         }
 
-        for (i=0; i<bufferCount; i++){
-            if(pBufferQ[i]==NULL){
-                LOGE(" ACCESS NULL POINTER i=%d ", i);
-            }
-            if(((android_native_buffer_t*)(pBufferQ[i]->pAppPrivate))->handle == ((android_native_buffer_t*)pBufHandle)->handle){
-                (*pNewBufferHeader) = pBufferQ[i];
-                break;
-            }
-        }
-
-        if(i == bufferCount){
+        OMX_BUFFERHEADERTYPE *pHeader = pDrmPlayerRenderHandle->getBufferHeader(slot, pBufHandle, pBufferQ, bufferCount);
+        if(pHeader == NULL){
             LOGE("drmplayer_videorender_getNewGraphicsBuffer() : find new buffer header failed!");
             return -1;
         }
+        (*pNewBufferHeader) = pHeader;
     }
 
     return 0;
@@ -0,0 +1,137 @@
+#ifndef DRMPLAYER_VIDEO_RENDER_H
+#define DRMPLAYER_VIDEO_RENDER_H
+
+#include <stdint.h>
+#include <utils/RefBase.h>
+#include <utils/Errors.h>
+#include "AwesomePlayer.h"
+#include "OMX_IVCommon.h"
+#include "IppOmxDrmPlayerExt.h"
+#include "OMX_Core.h"
+
+#include <surfaceflinger/SurfaceComposerClient.h>
+#include <ui/android_native_buffer.h>
+#include <ui/GraphicBuffer.h>
+
+namespace android {
+
+#define DRM_GRAPHIC_BUFFER_MAX      32      // native window buffers of one renderer
+#define DRM_GRAPHIC_BUFFER_HASH     64      // handle lookup buckets, power of 2 above twice the max
+#define DRM_GRAPHIC_BUFFER_NONE     (-1)
+
+enum GraphicBufferStatus {
+    OWNED_BY_RENDER,
+    OWNED_BY_NATIVE_WINDOW,
+    WAIT_FOR_PROVIDE,       // Graphics buffer have been dequeued, wait for provide to OMX
+    GRAPHIC_BUFFER_STATUS_COUNT
+};
+
+typedef struct AllocatedBufferInfo {
+    sp<GraphicBuffer> mGraphicBuffer;
+    GraphicBufferStatus mStatus;
+    int mHeaderIndex;       // where its OMX buffer header was last found in the decoder queue
+    int mPrev;              // neighbours in the list of the buffers in mStatus
+    int mNext;
+}AllocatedBufferInfo;
+
+/*
+ * The buffers allocated from the native window, in allocation order. A
+ * buffer keeps its slot until clear(); a handle finds its slot through a
+ * small hash, and the buffers of each status are linked in a list, so the
+ * per frame state changes and lookups do not walk the table.
+ */
+class GraphicBufferTable {
+public:
+    GraphicBufferTable() : mSize(0) { clear(); }
+
+    // slot of the new buffer, DRM_GRAPHIC_BUFFER_NONE when full
+    int add(const sp<GraphicBuffer> &graphicBuffer, GraphicBufferStatus status);
+    // slot of the buffer with this handle, DRM_GRAPHIC_BUFFER_NONE if none
+    int find(buffer_handle_t handle) const;
+    void setStatus(int slot, GraphicBufferStatus status);
+    // the OMX buffer header of the buffer, NULL if it is not in pBufferQ
+    OMX_BUFFERHEADERTYPE *getHeader(int slot, OMX_BUFFERHEADERTYPE **pBufferQ, int bufferCount);
+    void clear();
+
+    int size() const { return mSize; }
+    // the buffer in this status for the longest time, DRM_GRAPHIC_BUFFER_NONE if none
+    int first(GraphicBufferStatus status) const { return mHead[status]; }
+    int next(int slot) const { return mSlots[slot].mNext; }
+    int count(GraphicBufferStatus status) const { return mCount[status]; }
+    AllocatedBufferInfo &operator[](int slot) { return mSlots[slot]; }
+    const AllocatedBufferInfo &operator[](int slot) const { return mSlots[slot]; }
+
+private:
+    static uint32_t hash(buffer_handle_t handle);
+    void link(int slot);
+    void unlink(int slot);
+
+    AllocatedBufferInfo mSlots[DRM_GRAPHIC_BUFFER_MAX];
+    int mSize;
+    int mHead[GRAPHIC_BUFFER_STATUS_COUNT];
+    int mTail[GRAPHIC_BUFFER_STATUS_COUNT];
+    int mCount[GRAPHIC_BUFFER_STATUS_COUNT];
+    buffer_handle_t mHashHandle[DRM_GRAPHIC_BUFFER_HASH];
+    int mHashSlot[DRM_GRAPHIC_BUFFER_HASH];
+};
+
+struct DrmPlayerNativeWindowRenderer : public AwesomeRenderer {
+    DrmPlayerNativeWindowRenderer(int32_t rotationDegrees);
+
+    virtual void render(MediaBuffer *buffer) {
+    }
+
+    void render(android_native_buffer_t* buffer);
+
+    void render(
+        const void *data, size_t size, void *platformPrivate){
+    }
+
+    status_t init();
+    // render to nativeWindow instead of a surface of our own; configSurface needs init()
+    status_t init(const sp<ANativeWindow> &nativeWindow);
+    status_t allocateOutputBuffersFromNativeWindow(int &nBfferCount);
+    status_t getGraphicBufferInfo(int nIndex, char ** ppVirAddress, char ** ppPhyAddress, void **pBufferHandle);
+    status_t destroyNativeWindow();
+    status_t reconfigNativeWindow();
+    status_t returnAllGraphicsBuffers(int *pNum);
+    status_t getNewGraphicsBuffer(void** pBufferHandle, int *pSlot);
+    status_t getProvideGraphicsBuffer(void** pBufferHandle, int *pSlot);
+    // header of the buffer in nSlot, found by its handle when nSlot is DRM_GRAPHIC_BUFFER_NONE
+    OMX_BUFFERHEADERTYPE *getBufferHeader(int nSlot, void *pBufferHandle, OMX_BUFFERHEADERTYPE **pBufferQ, int bufferCount);
+    status_t configSurface(DRM_CONFIG_SET_SURFACE *pSurfaceSet);
+    const GraphicBufferTable &graphicBuffers() const { return mGraphicBuffersAllocated; }
+
+//protected:
+    ~DrmPlayerNativeWindowRenderer() {
+    }
+    int32_t mDecodedWidth, mDecodedHeight;
+    int32_t mDisplayWidth, mDisplayHeight;
+    OMX_COLOR_FORMATTYPE mColorFormat;
+private:
+    sp<SurfaceComposerClient> mSurfCC;
+    sp<SurfaceControl> mSurfCtrl;
+    sp<ANativeWindow> mNativeWindow;
+    GraphicBufferTable mGraphicBuffersAllocated;
+
+    void applyRotation(int32_t rotationDegrees);
+
+    DrmPlayerNativeWindowRenderer(const DrmPlayerNativeWindowRenderer &);
+    DrmPlayerNativeWindowRenderer &operator=(
+            const DrmPlayerNativeWindowRenderer &);
+};
+
+}  // namespace android
+
+extern "C" {
+void *drmplayer_videorender_init(void *pRenderHandle);
+int drmplayer_videorender_allocateGraphicsBuffer(void *pRenderHandle, int nCount, int *pAllocated, OMX_COLOR_FORMATTYPE eColorFormat, size_t decodedWidth, size_t decodedHeight, size_t displayWidth, size_t displayHeight);
+int drmplayer_videorender_getGraphicsBufferInfo(void *pRenderHandle, int nIndex, char ** ppVirAddress, char ** ppPhyAddress, void **pBufferHandle);
+int drmplayer_videorender_getNewGraphicsBuffer(void *pRenderHandle, int bufferCount, void * pVideoDecoderOutBufferQ, void **pNewBufferHeader);
+int drmplayer_videorender_getProvideGraphicsBuffer(void *pRenderHandle, int bufferCount, void * pVideoDecoderOutBufferQ, void **pNewBufferHeader);
+void drmplayer_videorender(void *pRenderHandle, const void *data, size_t size, void *platformPrivate);
+int drmplayer_videorender_returnAllGraphicsBuffers(void *pRenderHandle, int *pNum);
+void drmplayer_videorender_deinit(void *pRenderHandle);
+}
+
+#endif
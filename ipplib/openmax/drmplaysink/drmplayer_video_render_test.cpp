@@ -0,0 +1,364 @@
+/*
+ * Drives DrmPlayerNativeWindowRenderer against a mock ANativeWindow the
+ * way the DRM player component does: allocate, provide every buffer to the
+ * decoder, then render and get a new buffer for each frame, and return all
+ * buffers on seek. Checks the buffer table against what the window saw.
+ * Exits with the number of failed checks.
+ *
+ * usage: drmplayer_video_render_test [frames]
+ */
+
+#define LOG_TAG "DrmVideoRenderTest"
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cutils/native_handle.h>
+#include <hardware/gralloc.h>
+#include <ui/egl/android_natives.h>
+#include <utils/Log.h>
+#include "drmplayer_video_render.h"
+
+using namespace android;
+
+#define TEST_BUFFERS        6       // what the decoder asks for
+#define TEST_UNDEQUEUED     2       // what the window keeps for itself
+#define TEST_SIZE           64
+#define TEST_FRAMES         1000
+
+static int failures;
+
+static void check(bool ok, const char *what){
+    printf("  %-52s %s\n", what, ok ? "ok" : "FAIL");
+    if(!ok){
+        failures++;
+    }
+}
+
+/*
+ * Hands out its buffers in the order they were queued or canceled, as
+ * SurfaceTextureClient does, and remembers who owns each one.
+ */
+class MockNativeWindow : public EGLNativeBase<ANativeWindow, MockNativeWindow, RefBase> {
+public:
+    MockNativeWindow(int count) : mCount(0), mBufferCount(0), mHead(0), mFree(0), mErrors(0) {
+        const_cast<uint32_t&>(ANativeWindow::flags) = 0;
+        const_cast<int&>(ANativeWindow::minSwapInterval) = 0;
+        const_cast<int&>(ANativeWindow::maxSwapInterval) = 1;
+        const_cast<float&>(ANativeWindow::xdpi) = 160;
+        const_cast<float&>(ANativeWindow::ydpi) = 160;
+        ANativeWindow::setSwapInterval = hook_setSwapInterval;
+        ANativeWindow::dequeueBuffer = hook_dequeueBuffer;
+        ANativeWindow::lockBuffer = hook_lockBuffer;
+        ANativeWindow::queueBuffer = hook_queueBuffer;
+        ANativeWindow::query = hook_query;
+        ANativeWindow::perform = hook_perform;
+        ANativeWindow::cancelBuffer = hook_cancelBuffer;
+
+        for (int i = 0; i < count; i++){
+            addBuffer();
+        }
+    }
+
+    ~MockNativeWindow() {
+        for (int i = 0; i < mCount; i++){
+            mBuffers[i].clear();
+            native_handle_delete(mHandles[i]);
+        }
+    }
+
+    // index of the window buffer with this handle, -1 if none
+    int indexOf(buffer_handle_t handle) const {
+        for (int i = 0; i < mCount; i++){
+            if(mBuffers[i]->handle == handle){
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    // a new buffer at the end of the free queue, returns its index
+    int addBuffer() {
+        int i = mCount++;
+        mHandles[i] = native_handle_create(0, 0);
+        mBuffers[i] = new GraphicBuffer(TEST_SIZE, TEST_SIZE, HAL_PIXEL_FORMAT_YCbCr_422_I,
+                GRALLOC_USAGE_SW_READ_OFTEN, TEST_SIZE, mHandles[i], false);
+        mDequeued[i] = false;
+        release(i);
+        return i;
+    }
+
+    android_native_buffer_t *buffer(int i) { return mBuffers[i]->getNativeBuffer(); }
+    int freeCount() const { return mFree; }
+    int bufferCount() const { return mBufferCount; }
+    int errors() const { return mErrors; }
+
+private:
+    static MockNativeWindow *getSelf(ANativeWindow *window) {
+        return static_cast<MockNativeWindow*>(window);
+    }
+    static const MockNativeWindow *getSelf(const ANativeWindow *window) {
+        return static_cast<const MockNativeWindow*>(window);
+    }
+
+    void release(int i) {
+        mQueue[(mHead + mFree) % DRM_GRAPHIC_BUFFER_MAX] = i;
+        mFree++;
+        mDequeued[i] = false;
+    }
+
+    // the dequeued window buffer of buffer, -1 and an error if there is none
+    int owned(android_native_buffer_t *buffer) {
+        int i = buffer ? indexOf(buffer->handle) : -1;
+        if(i < 0 || !mDequeued[i]){
+            mErrors++;
+            return -1;
+        }
+        return i;
+    }
+
+    static int hook_setSwapInterval(ANativeWindow *window, int interval) {
+        return 0;
+    }
+
+    static int hook_dequeueBuffer(ANativeWindow *window, android_native_buffer_t **buffer) {
+        MockNativeWindow *self = getSelf(window);
+        if(self->mFree == 0){
+            return -EBUSY;
+        }
+        int i = self->mQueue[self->mHead];
+        self->mHead = (self->mHead + 1) % DRM_GRAPHIC_BUFFER_MAX;
+        self->mFree--;
+        self->mDequeued[i] = true;
+        *buffer = self->buffer(i);
+        return 0;
+    }
+
+    static int hook_lockBuffer(ANativeWindow *window, android_native_buffer_t *buffer) {
+        return getSelf(window)->owned(buffer) < 0 ? -EINVAL : 0;
+    }
+
+    static int hook_queueBuffer(ANativeWindow *window, android_native_buffer_t *buffer) {
+        MockNativeWindow *self = getSelf(window);
+        int i = self->owned(buffer);
+        if(i < 0){
+            return -EINVAL;
+        }
+        self->release(i);
+        return 0;
+    }
+
+    static int hook_cancelBuffer(ANativeWindow *window, android_native_buffer_t *buffer) {
+        return hook_queueBuffer(window, buffer);
+    }
+
+    static int hook_query(const ANativeWindow *window, int what, int *value) {
+        switch (what) {
+            case NATIVE_WINDOW_QUEUES_TO_WINDOW_COMPOSER: *value = 1; return 0;
+            case NATIVE_WINDOW_MIN_UNDEQUEUED_BUFFERS: *value = TEST_UNDEQUEUED; return 0;
+            default: return -EINVAL;
+        }
+    }
+
+    static int hook_perform(ANativeWindow *window, int operation, ...) {
+        MockNativeWindow *self = getSelf(window);
+        va_list args;
+
+        va_start(args, operation);
+        if(operation == NATIVE_WINDOW_SET_BUFFER_COUNT){
+            self->mBufferCount = va_arg(args, int);
+        }
+        va_end(args);
+        return 0;
+    }
+
+    int mCount;
+    int mBufferCount;
+    int mHead;
+    int mFree;
+    int mErrors;
+    int mQueue[DRM_GRAPHIC_BUFFER_MAX];
+    bool mDequeued[DRM_GRAPHIC_BUFFER_MAX];
+    native_handle_t *mHandles[DRM_GRAPHIC_BUFFER_MAX];
+    sp<GraphicBuffer> mBuffers[DRM_GRAPHIC_BUFFER_MAX];
+};
+
+static buffer_handle_t headerHandle(void *pHeader){
+    return ((android_native_buffer_t*)(((OMX_BUFFERHEADERTYPE*)pHeader)->pAppPrivate))->handle;
+}
+
+static void testTable(){
+    GraphicBufferTable table;
+    native_handle_t *handles[DRM_GRAPHIC_BUFFER_MAX + 1];
+    sp<GraphicBuffer> buffers[DRM_GRAPHIC_BUFFER_MAX + 1];
+    bool ok = true;
+    int i;
+
+    printf("buffer table\n");
+    for (i = 0; i <= DRM_GRAPHIC_BUFFER_MAX; i++){
+        handles[i] = native_handle_create(0, 0);
+        buffers[i] = new GraphicBuffer(TEST_SIZE, TEST_SIZE, HAL_PIXEL_FORMAT_YCbCr_422_I,
+                GRALLOC_USAGE_SW_READ_OFTEN, TEST_SIZE, handles[i], false);
+    }
+
+    for (i = 0; i < DRM_GRAPHIC_BUFFER_MAX; i++){
+        ok = ok && table.add(buffers[i], (GraphicBufferStatus)(i % GRAPHIC_BUFFER_STATUS_COUNT)) == i;
+    }
+    check(ok, "slots given in allocation order");
+    check(table.add(buffers[DRM_GRAPHIC_BUFFER_MAX], WAIT_FOR_PROVIDE) == DRM_GRAPHIC_BUFFER_NONE,
+          "full table refuses a buffer");
+    table.clear();
+    check(table.size() == 0 && table.find(buffers[0]->handle) == DRM_GRAPHIC_BUFFER_NONE,
+          "clear forgets every buffer");
+
+    for (i = 0; i < 8; i++){
+        table.add(buffers[i], WAIT_FOR_PROVIDE);
+    }
+    check(table.add(buffers[3], OWNED_BY_RENDER) == DRM_GRAPHIC_BUFFER_NONE,
+          "a buffer is added once");
+    for (i = 0, ok = true; i < 8; i++){
+        ok = ok && table.find(buffers[i]->handle) == i;
+    }
+    check(ok && table.find(buffers[8]->handle) == DRM_GRAPHIC_BUFFER_NONE, "find by handle");
+
+    table.setStatus(5, OWNED_BY_RENDER);
+    table.setStatus(2, OWNED_BY_RENDER);
+    table.setStatus(0, OWNED_BY_NATIVE_WINDOW);
+    table.setStatus(0, OWNED_BY_NATIVE_WINDOW);
+    check(table.count(WAIT_FOR_PROVIDE) == 5 && table.count(OWNED_BY_RENDER) == 2 &&
+          table.count(OWNED_BY_NATIVE_WINDOW) == 1, "counts follow the status changes");
+    check(table.first(OWNED_BY_RENDER) == 5 && table.next(5) == 2 &&
+          table.next(2) == DRM_GRAPHIC_BUFFER_NONE, "buffers listed in the order they came");
+    check(table.first(WAIT_FOR_PROVIDE) == 1 && table[1].mStatus == WAIT_FOR_PROVIDE,
+          "waiting list skips the moved buffers");
+
+    table.clear();
+    for (i = 0; i <= DRM_GRAPHIC_BUFFER_MAX; i++){
+        buffers[i].clear();
+        native_handle_delete(handles[i]);
+    }
+}
+
+static void testRenderer(int frames){
+    sp<MockNativeWindow> window = new MockNativeWindow(TEST_BUFFERS + TEST_UNDEQUEUED);
+    OMX_BUFFERHEADERTYPE headers[TEST_BUFFERS + TEST_UNDEQUEUED + 1];
+    OMX_BUFFERHEADERTYPE *pBufferQ[TEST_BUFFERS + TEST_UNDEQUEUED + 1];
+    OMX_BUFFERHEADERTYPE *held[TEST_BUFFERS + TEST_UNDEQUEUED];
+    OMX_BUFFERHEADERTYPE foreign;
+    int count = TEST_BUFFERS + TEST_UNDEQUEUED;
+    int allocated = 0, returned = 0;
+    int first = 0, nHeld = 0;
+    void *pHeader;
+    bool ok;
+    int i, f, extra;
+
+    printf("renderer over a mock native window, %d frames\n", frames);
+    DrmPlayerNativeWindowRenderer *render = new DrmPlayerNativeWindowRenderer(0);
+    check(render->init(window) == OK, "init");
+    const GraphicBufferTable &table = render->graphicBuffers();
+
+    check(drmplayer_videorender_allocateGraphicsBuffer(render, TEST_BUFFERS, &allocated,
+          OMX_COLOR_FormatCbYCrY, TEST_SIZE, TEST_SIZE, TEST_SIZE, TEST_SIZE) == 0 &&
+          allocated == count && window->bufferCount() == count, "allocate");
+    check(table.count(WAIT_FOR_PROVIDE) == TEST_BUFFERS &&
+          table.count(OWNED_BY_NATIVE_WINDOW) == TEST_UNDEQUEUED &&
+          window->freeCount() == TEST_UNDEQUEUED, "undequeued buffers back to the window");
+
+    // the component builds its queue in its own order
+    memset(headers, 0, sizeof(headers));
+    for (i = 0; i < count; i++){
+        headers[i].pAppPrivate = window->buffer(count - 1 - i);
+        pBufferQ[i] = &headers[i];
+    }
+
+    for (i = 0, ok = true; i < TEST_BUFFERS; i++){
+        pHeader = NULL;
+        ok = ok && drmplayer_videorender_getProvideGraphicsBuffer(render, count, pBufferQ, &pHeader) == 0 &&
+             pHeader == &headers[count - 1 - i];
+        held[i] = (OMX_BUFFERHEADERTYPE*)pHeader;
+    }
+    nHeld = TEST_BUFFERS;
+    check(ok, "provide finds the header of each buffer");
+    check(drmplayer_videorender_getProvideGraphicsBuffer(render, count, pBufferQ, &pHeader) != 0,
+          "nothing more to provide");
+
+    for (f = 0, ok = true; f < frames && ok; f++){
+        // the component moves its headers around now and then
+        if(f == frames / 2){
+            OMX_BUFFERHEADERTYPE *tmp = pBufferQ[0];
+            pBufferQ[0] = pBufferQ[count - 1];
+            pBufferQ[count - 1] = tmp;
+        }
+
+        drmplayer_videorender(render, NULL, 0, held[first]);
+        first = (first + 1) % count;
+        nHeld--;
+
+        pHeader = NULL;
+        ok = drmplayer_videorender_getNewGraphicsBuffer(render, count, pBufferQ, &pHeader) == 0 &&
+             pHeader != NULL && window->indexOf(headerHandle(pHeader)) >= 0 &&
+             table[table.find(headerHandle(pHeader))].mStatus == OWNED_BY_RENDER;
+        held[(first + nHeld) % count] = (OMX_BUFFERHEADERTYPE*)pHeader;
+        nHeld++;
+
+        ok = ok && table.count(OWNED_BY_RENDER) == TEST_BUFFERS &&
+             table.count(OWNED_BY_NATIVE_WINDOW) == TEST_UNDEQUEUED &&
+             table.count(WAIT_FOR_PROVIDE) == 0 &&
+             window->freeCount() == TEST_UNDEQUEUED;
+    }
+    check(ok && f == frames, "render and get new buffer every frame");
+    check(window->errors() == 0, "window saw no buffer it did not hand out");
+
+    check(drmplayer_videorender_returnAllGraphicsBuffers(render, &returned) == 0 &&
+          returned == TEST_BUFFERS && table.count(WAIT_FOR_PROVIDE) == TEST_BUFFERS,
+          "return all");
+    for (i = 0, ok = true; i < TEST_BUFFERS; i++){
+        pHeader = NULL;
+        ok = ok && drmplayer_videorender_getProvideGraphicsBuffer(render, count, pBufferQ, &pHeader) == 0 &&
+             pHeader == held[(first + i) % count];
+    }
+    check(ok, "provided again in the order the decoder got them");
+
+    // the window hands out a buffer it did not have at allocation
+    extra = window->addBuffer();
+    headers[count].pAppPrivate = window->buffer(extra);
+    pBufferQ[count] = &headers[count];
+    for (i = 0, ok = true; i <= TEST_UNDEQUEUED; i++){
+        pHeader = NULL;
+        ok = ok && drmplayer_videorender_getNewGraphicsBuffer(render, count + 1, pBufferQ, &pHeader) == 0;
+    }
+    check(ok && pHeader == &headers[count] &&
+          table.find(headerHandle(pHeader)) == DRM_GRAPHIC_BUFFER_NONE,
+          "header of a buffer outside the table found by handle");
+
+    memset(&foreign, 0, sizeof(foreign));
+    native_handle_t *foreignHandle = native_handle_create(0, 0);
+    sp<GraphicBuffer> foreignBuffer = new GraphicBuffer(TEST_SIZE, TEST_SIZE, HAL_PIXEL_FORMAT_YCbCr_422_I,
+            GRALLOC_USAGE_SW_READ_OFTEN, TEST_SIZE, foreignHandle, false);
+    foreign.pAppPrivate = foreignBuffer->getNativeBuffer();
+    drmplayer_videorender(render, NULL, 0, &foreign);
+    check(table.count(OWNED_BY_RENDER) == count &&
+          table.count(OWNED_BY_NATIVE_WINDOW) == 0,
+          "unknown buffer leaves the table alone");
+    foreignBuffer.clear();
+    native_handle_delete(foreignHandle);
+
+    // destroyNativeWindow unlocks through gralloc, which the mock buffers never went to
+    delete render;
+}
+
+int main(int argc, char **argv){
+    int frames = TEST_FRAMES;
+
+    if(argc > 1 && atoi(argv[1]) > 0){
+        frames = atoi(argv[1]);
+    }
+
+    testTable();
+    testRenderer(frames);
+
+    printf("%d failed\n", failures);
+    return failures;
+}
@@ -73,3 +73,12 @@ LOCAL_MODULE:= libstagefrighthw
 
 include $(BUILD_SHARED_LIBRARY)
 
+
+# Cost of the physical address lookup of encoder input buffers, on the host
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES := stagefright_mrvl_phy_cache_bench.cpp
+LOCAL_MODULE := stagefright_mrvl_phy_cache_bench
+LOCAL_MODULE_TAGS := optional
+
+include $(BUILD_HOST_EXECUTABLE)
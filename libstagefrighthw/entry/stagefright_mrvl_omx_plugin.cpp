@@ -4,12 +4,14 @@
  *****************************************************************************************/
 
 #include "stagefright_mrvl_omx_plugin.h"
+#include "stagefright_mrvl_phy_cache.h"
 #include <media/stagefright/foundation/ADebug.h> /* Define CHECK_EQ */
 #include "OMX_IppDef.h"
 #include <binder/IMemory.h>
 #include <utils/RefBase.h>
 #include <sys/ioctl.h>
 #include <cutils/properties.h>
+#include <pthread.h>
 #ifdef USE_ION
 #include <linux/ion.h>
 #include <linux/pxa_ion.h>
@@ -37,12 +39,112 @@
 #define DEFAULT_AUDIO_ENCODER_INPUT_BUFFER (1)
 #define DEFAULT_AUDIO_ENCODER_OUTPUT_BUFFER (12)
 
+/* component types, found once from the name at GetHandle */
+#define IPP_OMX_COMP_HW_ENCODER  (1 << 0)   /* takes the physical address of input buffers */
+
 typedef struct{
     OMX_COMPONENTTYPE StandardComp;
     OMX_U8 ComponentName[128];
     OMX_CALLBACKTYPE  InternalCallBack;        
+    OMX_U32 nCompFlags;
+    int ionFd;                          /* ion client for physical addresses, -1 until needed */
+    pthread_mutex_t PhyCacheLock;
+    IppOmxPhyCache_t PhyCache;
 }IppOmxCompomentWrapper_t;
 
+static void IppOMXWrapper_PhyCacheRelease(void *pCtx, IppOmxPhyCacheEntry_t *pEntry){
+   ((android::IMemoryHeap*)pEntry->pKey)->decStrong(pCtx);
+}
+
+/* forget the physical addresses of the input heaps and let the heaps go */
+static void IppOMXWrapper_FlushPhyCache(IppOmxCompomentWrapper_t *pWrapper){
+   if (!(pWrapper->nCompFlags & IPP_OMX_COMP_HW_ENCODER)){
+        return;
+   }
+   pthread_mutex_lock(&pWrapper->PhyCacheLock);
+   MARVELL_LOG("%s: physical address cache hits %lu misses %lu", pWrapper->ComponentName,
+               pWrapper->PhyCache.nHits, pWrapper->PhyCache.nMisses);
+   IppOmxPhyCache_Flush(&pWrapper->PhyCache, IppOMXWrapper_PhyCacheRelease, pWrapper);
+   pthread_mutex_unlock(&pWrapper->PhyCacheLock);
+}
+
+/* physical address of the heap base, 0 if it has none */
+static OMX_U32 IppOMXWrapper_GetHeapPhyBase(IppOmxCompomentWrapper_t *pWrapper,
+        const android::sp<android::IMemoryHeap> &heap){
+   IppOmxPhyCacheEntry_t *pEntry;
+   OMX_U32 nPhyBase = 0;
+   int heapFd = heap->getHeapID();
+
+   pthread_mutex_lock(&pWrapper->PhyCacheLock);
+   pEntry = IppOmxPhyCache_Lookup(&pWrapper->PhyCache, heap.get(), heapFd);
+   if (pEntry){
+       nPhyBase = pEntry->nPhyBase;
+       pthread_mutex_unlock(&pWrapper->PhyCacheLock);
+       return nPhyBase;
+   }
+
+#ifdef USE_ION
+   {
+       struct ion_fd_data req_fd;
+       struct ion_handle_data req;
+       struct ion_custom_data data;
+       struct ion_pxa_region ion_region;
+       int ret;
+
+       if (pWrapper->ionFd < 0){
+           pWrapper->ionFd = open("/dev/ion", O_RDWR);
+           if (pWrapper->ionFd < 0){
+               ALOGE("failed to open /dev/ion, ret:%d", pWrapper->ionFd);
+               goto out;
+           }
+       }
+
+       /* import buffer fd to get handle */
+       memset(&req_fd, 0, sizeof(struct ion_fd_data));
+       req_fd.fd = heapFd;
+       ret = ioctl(pWrapper->ionFd, ION_IOC_IMPORT, &req_fd);
+       if (ret < 0) {
+           ALOGE("failed to import buffer fd:%d, ret:%d", req_fd.fd, ret);
+           goto out;
+       }
+       /* fetch physical address */
+       memset(&ion_region, 0, sizeof(ion_pxa_region));
+       memset(&data, 0, sizeof(struct ion_custom_data));
+       ion_region.handle = req_fd.handle;
+       data.cmd = ION_PXA_PHYS;
+       data.arg = (unsigned long)&ion_region;
+       ret = ioctl(pWrapper->ionFd, ION_IOC_CUSTOM, &data);
+       if (ret < 0) {
+           ALOGE("failed to get physical address from ION, return error:%d", ret);
+       } else {
+           nPhyBase = (OMX_U32)ion_region.addr;
+       }
+       /* the heap keeps the buffer, and so the address, while it is cached */
+       memset(&req, 0, sizeof(struct ion_handle_data));
+       req.handle = req_fd.handle;
+       ioctl(pWrapper->ionFd, ION_IOC_FREE, &req);
+   }
+#else
+   {
+       struct pmem_region region;
+       if (ioctl(heapFd, PMEM_GET_PHYS, &region) == 0) {
+           nPhyBase = (OMX_U32)region.offset;
+       }
+   }
+#endif
+
+   if (nPhyBase){
+       heap->incStrong(pWrapper);
+       IppOmxPhyCache_Add(&pWrapper->PhyCache, heap.get(), heapFd, nPhyBase,
+                          IppOMXWrapper_PhyCacheRelease, pWrapper);
+   }
+#ifdef USE_ION
+out:
+#endif
+   pthread_mutex_unlock(&pWrapper->PhyCacheLock);
+   return nPhyBase;
+}
+
 static OMX_ERRORTYPE IppOMXWrapper_GetParameter(
         OMX_IN  OMX_HANDLETYPE hComponent, 
         OMX_IN  OMX_INDEXTYPE nParamIndex,  
@@ -253,6 +355,7 @@ static OMX_ERRORTYPE IppOMXWrapper_FreeBuffer(
    hWrapperHandle = (OMX_COMPONENTTYPE*)(&(((IppOmxCompomentWrapper_t*)hComponent)->StandardComp));
    
    MARVELL_LOG("%s: OMX_FreeBuffer: port %lu , ptr: %p",((IppOmxCompomentWrapper_t*)hComponent)->ComponentName, nPortIndex,pBuffer->pBuffer);
+   IppOMXWrapper_FlushPhyCache((IppOmxCompomentWrapper_t*)hComponent);
    error = OMX_FreeBuffer(hWrapperHandle->pComponentPrivate, nPortIndex, pBuffer);
    if (error != OMX_ErrorNone){
         ALOGE("%s: OMX_FreeBuffer Failed: port %lu , ptr: %p",((IppOmxCompomentWrapper_t*)hComponent)->ComponentName, nPortIndex, pBuffer->pBuffer);
@@ -268,6 +371,7 @@ static OMX_ERRORTYPE IppOMXWrapper_EmptyThisBuffer(
         OMX_IN  OMX_HANDLETYPE hComponent,
         OMX_IN  OMX_BUFFERHEADERTYPE* pBuffer){
    OMX_COMPONENTTYPE *hWrapperHandle = NULL;
+   IppOmxCompomentWrapper_t *pWrapper = NULL;
    OMX_ERRORTYPE error = OMX_ErrorNone;
 
    if (hComponent == NULL){
@@ -275,83 +379,25 @@ static OMX_ERRORTYPE IppOMXWrapper_EmptyThisBuffer(
    }
    hWrapperHandle = (OMX_COMPONENTTYPE*)(&(((IppOmxCompomentWrapper_t*)hComponent)->StandardComp));
 
-#ifdef USE_ION
-   if (!strcmp((char*)((IppOmxCompomentWrapper_t*)hComponent)->ComponentName, "OMX.MARVELL.VIDEO.VMETAENCODER")  ||
-       !strcmp((char*)((IppOmxCompomentWrapper_t*)hComponent)->ComponentName, "OMX.MARVELL.VIDEO.CODADX8ENCODER")) {
-       if (pBuffer->pInputPortPrivate) {
-           android::IMemory *mem = (android::IMemory*)(pBuffer->pInputPortPrivate);
-           android::sp<android::IMemoryHeap> heap = mem->getMemory();
-           void *va_base = NULL;
-           OMX_S32 offset;
-           int fd, ret;
-           fd = open("/dev/ion", O_RDWR);
-           if (fd < 0) {
-               ALOGE("failed to open /dev/ion, ret:%d", fd);
-               goto out;
-           }
-
-           /* import buffer fd to get handle */
-           struct ion_fd_data req_fd;
-           memset(&req_fd, 0, sizeof(struct ion_fd_data));
-           req_fd.fd = heap->getHeapID();
-           ret = ioctl(fd, ION_IOC_IMPORT, &req_fd);
-           if (ret < 0) {
-               ALOGE("failed to import buffer fd:%d, ret:%d", req_fd.fd, ret);
-               close(fd);
-               goto out;
-           }
-           /* fetch physical address */
-           struct ion_custom_data data;
-           struct ion_pxa_region ion_region;
-           memset(&ion_region, 0, sizeof(ion_pxa_region));
-           memset(&data, 0, sizeof(struct ion_custom_data));
-           ion_region.handle = req_fd.handle;
-           data.cmd = ION_PXA_PHYS;
-           data.arg = (unsigned long)&ion_region;
-           ret = ioctl(fd, ION_IOC_CUSTOM, &data);
-           if (ret < 0) {
-               ALOGE("failed to get physical address from ION, return error:%d", ret);
-               close(fd);
-               goto out;
-           }
-           close(fd);
-           va_base = heap->getBase();
-           offset = pBuffer->pBuffer + pBuffer->nOffset - (OMX_U8*)va_base;
-           ((OMX_BUFFERHEADERTYPE_IPPEXT*)pBuffer)->nPhyAddr = offset + ion_region.addr;
-           ALOGD("%s(%d): nPhyAddr=%p\n", __FUNCTION__, __LINE__, ((OMX_BUFFERHEADERTYPE_IPPEXT*)pBuffer)->nPhyAddr);
+   pWrapper = (IppOmxCompomentWrapper_t*)hComponent;
+   if ((pWrapper->nCompFlags & IPP_OMX_COMP_HW_ENCODER) && pBuffer->pInputPortPrivate) {
+       android::IMemory *mem = (android::IMemory*)(pBuffer->pInputPortPrivate);
+       android::sp<android::IMemoryHeap> heap = mem->getMemory();
+       OMX_U32 nPhyBase = IppOMXWrapper_GetHeapPhyBase(pWrapper, heap);
+       OMX_S32 offset;
+
+       if (nPhyBase) {
+           offset = pBuffer->pBuffer + pBuffer->nOffset - (OMX_U8*)heap->getBase();
+           ((OMX_BUFFERHEADERTYPE_IPPEXT*)pBuffer)->nPhyAddr = offset + nPhyBase;
+       } else {
+           ((OMX_BUFFERHEADERTYPE_IPPEXT*)pBuffer)->nPhyAddr = 0;
+           ALOGE("The Physical address for HW encoder is illegal NULL");
        }
+       MARVELL_LOG("%s(%d): nPhyAddr=%p\n", __FUNCTION__, __LINE__, ((OMX_BUFFERHEADERTYPE_IPPEXT*)pBuffer)->nPhyAddr);
    }
+
+   MARVELL_LOG("%s: OMX_EmptyThisBuffer", pWrapper->ComponentName);
    return OMX_EmptyThisBuffer(hWrapperHandle->pComponentPrivate, pBuffer);
-out:
-   ((OMX_BUFFERHEADERTYPE_IPPEXT*)pBuffer)->nPhyAddr = 0;
-   ALOGE("The Physical address for HW encoder is illegal NULL");
-   return OMX_EmptyThisBuffer(hWrapperHandle->pComponentPrivate, pBuffer);
-#else
-   if (!strcmp((char*)((IppOmxCompomentWrapper_t*)hComponent)->ComponentName, "OMX.MARVELL.VIDEO.VMETAENCODER")  ||
-       !strcmp((char*)((IppOmxCompomentWrapper_t*)hComponent)->ComponentName, "OMX.MARVELL.VIDEO.CODADX8ENCODER")) {
-       if (pBuffer->pInputPortPrivate) {
-           android::IMemory *mem = (android::IMemory*)(pBuffer->pInputPortPrivate);
-           android::sp<android::IMemoryHeap> heap = mem->getMemory();
-           void* va_base;
-           OMX_S32 offset;
-           struct pmem_region region;
-           va_base = heap->getBase();
-           if(ioctl(heap->getHeapID(), PMEM_GET_PHYS, &region) == 0) {
-               offset = pBuffer->pBuffer + pBuffer->nOffset - (OMX_U8*)va_base;
-               ((OMX_BUFFERHEADERTYPE_IPPEXT*)pBuffer)->nPhyAddr = (OMX_U32)(region.offset + offset);
-               //ALOGD("%s(%d): pa_base=%p va_base=%p pBuffer=%p offset=%d\n", __FUNCTION__, __LINE__, region.offset, va_base, pBuffer->pBuffer, offset);
-           } else {
-               ((OMX_BUFFERHEADERTYPE_IPPEXT*)pBuffer)->nPhyAddr = 0;
-               ALOGE("The Physical address for HW encoder is illegal NULL");
-           }
-           ALOGD("%s(%d): nPhyAddr=%p\n", __FUNCTION__, __LINE__, ((OMX_BUFFERHEADERTYPE_IPPEXT*)pBuffer)->nPhyAddr);
-       }
-   }
-  
-   //OMX_GetComponentVersion(hWrapperHandle->pComponentPrivate, ComponentName, &ComponentVersion, &SpecVersion, NULL);
-   MARVELL_ALOG("%s: OMX_EmptyThisBuffer ",((IppOmxCompomentWrapper_t*)hComponent)->ComponentName, );
-   return OMX_EmptyThisBuffer(hWrapperHandle->pComponentPrivate, pBuffer);
-#endif
 }
 
 /** refer to OMX_FillThisBuffer in OMX_core.h or the OMX IL 
@@ -404,6 +450,9 @@ static OMX_ERRORTYPE IppOMXWrapper_SendCommand(
    hWrapperHandle = (OMX_COMPONENTTYPE*)(&(((IppOmxCompomentWrapper_t*)hComponent)->StandardComp));
    
    ALOGD("%s: OMX_SendCommand: cmd: %d, nParam1: %lu ",((IppOmxCompomentWrapper_t*)hComponent)->ComponentName, Cmd, nParam1);
+   if (Cmd == OMX_CommandPortDisable){
+       IppOMXWrapper_FlushPhyCache((IppOmxCompomentWrapper_t*)hComponent);
+   }
    error = OMX_SendCommand(hWrapperHandle->pComponentPrivate, Cmd, nParam1, pCmdData);
    return error;
 }
@@ -574,6 +623,14 @@ static OMX_ERRORTYPE _OMX_MasterGetHandle(
         memset(pWrapperHandle, 0, sizeof(IppOmxCompomentWrapper_t));
         error = OMX_GetHandle(&pOmxInternalHandle, cComponentName, pAppData, &WrapperCallBack);
         if (error == OMX_ErrorNone){
+            if (!strcmp(cComponentName, "OMX.MARVELL.VIDEO.VMETAENCODER") ||
+                !strcmp(cComponentName, "OMX.MARVELL.VIDEO.CODADX8ENCODER")) {
+                pWrapperHandle->nCompFlags |= IPP_OMX_COMP_HW_ENCODER;
+            }
+            pWrapperHandle->ionFd = -1;
+            pthread_mutex_init(&pWrapperHandle->PhyCacheLock, NULL);
+            IppOmxPhyCache_Init(&pWrapperHandle->PhyCache);
+
             *pHandle = (OMX_HANDLETYPE)pWrapperHandle;
             /*override function*/
              pWrapperHandle->StandardComp.GetComponentVersion        = IppOMXWrapper_GetComponentVersion;
@@ -681,8 +738,15 @@ static OMX_ERRORTYPE _OMX_MasterFreeHandle(
     OMX_COMPONENTTYPE *hWrapperHandle = (OMX_COMPONENTTYPE*)(&(((IppOmxCompomentWrapper_t*)hComponent)->StandardComp));
     OMX_ERRORTYPE error = OMX_ErrorNone;
 
-    MARVELL_LOG("OMX_FreeHandle %s", ((IppOmxCompomentWrapper_t*)hComponent)->ComponentName);
+    IppOmxCompomentWrapper_t *pWrapper = (IppOmxCompomentWrapper_t*)hComponent;
+
+    MARVELL_LOG("OMX_FreeHandle %s", pWrapper->ComponentName);
     error = OMX_FreeHandle(hWrapperHandle->pComponentPrivate);
+    IppOMXWrapper_FlushPhyCache(pWrapper);
+    if (pWrapper->ionFd >= 0){
+        close(pWrapper->ionFd);
+    }
+    pthread_mutex_destroy(&pWrapper->PhyCacheLock);
     free(hComponent);
     return error;
     
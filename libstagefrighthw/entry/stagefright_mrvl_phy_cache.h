@@ -0,0 +1,81 @@
+/*****************************************************************************************
+ * Copyright (c) 2009, Marvell International Ltd.
+ * All Rights Reserved.
+ *****************************************************************************************/
+
+#ifndef STAGEFRIGHT_MRVL_PHY_CACHE_H_
+
+#define STAGEFRIGHT_MRVL_PHY_CACHE_H_
+
+#include <string.h>
+
+/* Physical addresses of the input heaps of a hardware encoder. A heap keeps
+ * its physical address for as long as it lives, so it is looked up once and
+ * the owner holds a reference on the heap while it is in the cache. */
+
+#define IPP_PHY_CACHE_SIZE  (32)
+
+typedef struct{
+    const void    *pKey;        /* heap object */
+    int           nFd;          /* buffer fd of the heap */
+    unsigned long nPhyBase;     /* physical address of the heap base */
+}IppOmxPhyCacheEntry_t;
+
+typedef struct{
+    IppOmxPhyCacheEntry_t Entry[IPP_PHY_CACHE_SIZE];
+    int           nCount;
+    int           nVictim;      /* next entry to replace once full */
+    unsigned long nHits;
+    unsigned long nMisses;
+}IppOmxPhyCache_t;
+
+/* called for every entry leaving the cache, to drop the heap reference */
+typedef void (*IppOmxPhyCacheRelease_t)(void *pCtx, IppOmxPhyCacheEntry_t *pEntry);
+
+static inline void IppOmxPhyCache_Init(IppOmxPhyCache_t *pCache){
+    memset(pCache, 0, sizeof(IppOmxPhyCache_t));
+}
+
+static inline IppOmxPhyCacheEntry_t *IppOmxPhyCache_Lookup(IppOmxPhyCache_t *pCache,
+        const void *pKey, int nFd){
+    int i;
+
+    for (i = 0; i < pCache->nCount; i++){
+        if (pCache->Entry[i].pKey == pKey && pCache->Entry[i].nFd == nFd){
+            pCache->nHits++;
+            return &pCache->Entry[i];
+        }
+    }
+    pCache->nMisses++;
+    return NULL;
+}
+
+static inline void IppOmxPhyCache_Add(IppOmxPhyCache_t *pCache,
+        const void *pKey, int nFd, unsigned long nPhyBase,
+        IppOmxPhyCacheRelease_t pfnRelease, void *pCtx){
+    IppOmxPhyCacheEntry_t *pEntry;
+
+    if (pCache->nCount < IPP_PHY_CACHE_SIZE){
+        pEntry = &pCache->Entry[pCache->nCount++];
+    } else {
+        pEntry = &pCache->Entry[pCache->nVictim];
+        pCache->nVictim = (pCache->nVictim + 1) % IPP_PHY_CACHE_SIZE;
+        pfnRelease(pCtx, pEntry);
+    }
+    pEntry->pKey = pKey;
+    pEntry->nFd = nFd;
+    pEntry->nPhyBase = nPhyBase;
+}
+
+static inline void IppOmxPhyCache_Flush(IppOmxPhyCache_t *pCache,
+        IppOmxPhyCacheRelease_t pfnRelease, void *pCtx){
+    int i;
+
+    for (i = 0; i < pCache->nCount; i++){
+        pfnRelease(pCtx, &pCache->Entry[i]);
+    }
+    pCache->nCount = 0;
+    pCache->nVictim = 0;
+}
+
+#endif  // STAGEFRIGHT_MRVL_PHY_CACHE_H_
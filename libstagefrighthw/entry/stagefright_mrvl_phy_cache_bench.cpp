@@ -0,0 +1,165 @@
+/*****************************************************************************************
+ * Copyright (c) 2009, Marvell International Ltd.
+ * All Rights Reserved.
+ *****************************************************************************************/
+
+/* Cost of finding the physical address of an encoder input buffer, per frame:
+ * the former lookup (two name compares, open the ion device, import, query,
+ * close) against the physical address cache. The ion device is faked by a
+ * device node whose ioctls fail straight away, so the figures are a lower
+ * bound of what the real device costs.
+ *
+ * Usage: stagefright_mrvl_phy_cache_bench [-n frames] [-b buffers] [-d device]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/ioctl.h>
+
+#include "stagefright_mrvl_phy_cache.h"
+
+#define FAKE_ION_IOC_IMPORT  _IOWR('I', 5, int)
+#define FAKE_ION_IOC_CUSTOM  _IOWR('I', 6, int)
+#define FAKE_ION_IOC_FREE    _IOWR('I', 1, int)
+
+typedef struct{
+    int           nFd;
+    unsigned long nPhyBase;
+}FakeHeap_t;
+
+static const char *pDevice = "/dev/null";
+static const char *pCompName = "OMX.MARVELL.VIDEO.VMETAENCODER";
+static unsigned long nSyscalls;
+
+static double NowNs(){
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* import, query and free the handle on an open ion client */
+static unsigned long FakeIonPhys(int ionFd, FakeHeap_t *pHeap){
+    int arg = pHeap->nFd;
+
+    ioctl(ionFd, FAKE_ION_IOC_IMPORT, &arg);
+    ioctl(ionFd, FAKE_ION_IOC_CUSTOM, &arg);
+    nSyscalls += 2;
+    return pHeap->nPhyBase;
+}
+
+static unsigned long LegacyLookup(const char *pName, FakeHeap_t *pHeap){
+    unsigned long nPhyBase = 0;
+    int fd;
+
+    if (!strcmp(pName, "OMX.MARVELL.VIDEO.VMETAENCODER") ||
+        !strcmp(pName, "OMX.MARVELL.VIDEO.CODADX8ENCODER")){
+        fd = open(pDevice, O_RDWR);
+        if (fd < 0){
+            return 0;
+        }
+        nPhyBase = FakeIonPhys(fd, pHeap);
+        close(fd);
+        nSyscalls += 2;
+    }
+    return nPhyBase;
+}
+
+static void Release(void *pCtx, IppOmxPhyCacheEntry_t *pEntry){
+}
+
+static unsigned long CachedLookup(IppOmxPhyCache_t *pCache, int ionFd, FakeHeap_t *pHeap){
+    IppOmxPhyCacheEntry_t *pEntry;
+    unsigned long nPhyBase;
+    int arg = 0;
+
+    pEntry = IppOmxPhyCache_Lookup(pCache, pHeap, pHeap->nFd);
+    if (pEntry){
+        return pEntry->nPhyBase;
+    }
+    nPhyBase = FakeIonPhys(ionFd, pHeap);
+    ioctl(ionFd, FAKE_ION_IOC_FREE, &arg);
+    nSyscalls++;
+    IppOmxPhyCache_Add(pCache, pHeap, pHeap->nFd, nPhyBase, Release, NULL);
+    return nPhyBase;
+}
+
+static void Report(const char *pName, double ns, int nFrames){
+    printf("%-28s %8.0f ns/frame %6.2f syscalls/frame\n", pName, ns / nFrames,
+           (double)nSyscalls / nFrames);
+}
+
+int main(int argc, char *argv[]){
+    IppOmxPhyCache_t Cache;
+    FakeHeap_t *pHeaps;
+    unsigned long nSum = 0;
+    int nFrames = 100000, nBuffers = 8;
+    int ionFd, i, opt;
+    double t;
+
+    while ((opt = getopt(argc, argv, "n:b:d:")) != -1){
+        switch (opt){
+        case 'n':
+            nFrames = atoi(optarg);
+            break;
+        case 'b':
+            nBuffers = atoi(optarg);
+            break;
+        case 'd':
+            pDevice = optarg;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-n frames] [-b buffers] [-d device]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (nFrames <= 0){
+        nFrames = 1;
+    }
+    if (nBuffers <= 0 || nBuffers > IPP_PHY_CACHE_SIZE){
+        nBuffers = 8;
+    }
+
+    pHeaps = (FakeHeap_t*)malloc(nBuffers * sizeof(FakeHeap_t));
+    if (pHeaps == NULL){
+        return 1;
+    }
+    for (i = 0; i < nBuffers; i++){
+        pHeaps[i].nFd = 100 + i;
+        pHeaps[i].nPhyBase = 0x10000000 + i * 0x200000;
+    }
+    ionFd = open(pDevice, O_RDWR);
+    if (ionFd < 0){
+        perror(pDevice);
+        return 1;
+    }
+    printf("%d frames over %d buffers, ion device faked by %s\n", nFrames, nBuffers, pDevice);
+
+    nSyscalls = 0;
+    t = NowNs();
+    for (i = 0; i < nFrames; i++){
+        nSum += LegacyLookup(pCompName, &pHeaps[i % nBuffers]);
+    }
+    Report("open/import/query/close", NowNs() - t, nFrames);
+
+    nSyscalls = 0;
+    IppOmxPhyCache_Init(&Cache);
+    t = NowNs();
+    for (i = 0; i < nFrames; i++){
+        nSum -= CachedLookup(&Cache, ionFd, &pHeaps[i % nBuffers]);
+    }
+    Report("cached", NowNs() - t, nFrames);
+    printf("cache hits %lu misses %lu\n", Cache.nHits, Cache.nMisses);
+
+    close(ionFd);
+    free(pHeaps);
+    if (nSum != 0){
+        printf("physical addresses differ\n");
+        return 1;
+    }
+    return 0;
+}
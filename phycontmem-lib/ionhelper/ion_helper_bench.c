@@ -0,0 +1,223 @@
+/*
+ * (C) Copyright 2010 Marvell International Ltd.
+ * All Rights Reserved
+ */
+
+/*
+ * Host bench of ion_helper pooling against a fake ion device.
+ *
+ * ion_helper_lib.c is built with ION_HELPER_DEV pointing at /dev/null and
+ * this file defines ioctl(), so the ION ioctls land here: ALLOC creates a
+ * memfd of the buffer size, SHARE hands out a dup of it to mmap, PHYS
+ * makes up a physical address and FREE closes the memfd. Every other
+ * ioctl goes to the kernel.
+ *
+ * A mix of buffer sizes is allocated and freed with the default pool
+ * watermarks and with pooling disabled, reporting allocs/sec and p50/p99
+ * ion_malloc latency. The fake device is cheaper than a carveout ALLOC on
+ * the target, so the unpooled numbers are a lower bound.
+ *
+ * Build: make -f Makefile_general bench
+ * Usage: ion_helper_bench [-n iterations]
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/ion.h>
+#include <linux/pxa_ion.h>
+
+#include "ion_helper_lib.h"
+#include "../phycontmem/phycontmem.h"
+
+#define BENCH_LIVE_MAX		8	// buffers held at once
+#define BENCH_HANDLE_MAX	256
+
+static const int bench_sizes[] = {
+	4 * 1024, 64 * 1024, 320 * 1024, 1024 * 1024,	// bitstream and scratch
+};
+
+static int fake_memfd[BENCH_HANDLE_MAX];
+static unsigned int fake_next_pa = 0x10000000;
+static unsigned int fake_allocs;
+static int failures;
+
+/* fake ion device, handle n is fake_memfd[n - 1] */
+static int fake_ion(unsigned long req, void *arg)
+{
+	switch (req) {
+	case ION_IOC_ALLOC: {
+		struct ion_allocation_data *data = (struct ion_allocation_data *)arg;
+		int i;
+
+		for (i = 0; i < BENCH_HANDLE_MAX && fake_memfd[i] > 0; i++)
+			;
+		if (i == BENCH_HANDLE_MAX)
+			return -1;
+		fake_memfd[i] = memfd_create("fake_ion", 0);
+		if (fake_memfd[i] < 0 || ftruncate(fake_memfd[i], data->len) < 0)
+			return -1;
+		data->handle = (struct ion_handle *)(unsigned long)(i + 1);
+		fake_allocs++;
+		return 0;
+	}
+	case ION_IOC_SHARE: {
+		struct ion_fd_data *data = (struct ion_fd_data *)arg;
+
+		data->fd = dup(fake_memfd[(unsigned long)data->handle - 1]);
+		return data->fd < 0 ? -1 : 0;
+	}
+	case ION_IOC_FREE: {
+		struct ion_handle_data *data = (struct ion_handle_data *)arg;
+		int i = (unsigned long)data->handle - 1;
+
+		close(fake_memfd[i]);
+		fake_memfd[i] = 0;
+		return 0;
+	}
+	case ION_IOC_CUSTOM: {
+		struct ion_custom_data *data = (struct ion_custom_data *)arg;
+
+		if (data->cmd == ION_PXA_PHYS) {
+			struct ion_pxa_region *region = (struct ion_pxa_region *)data->arg;
+
+			region->addr = fake_next_pa;
+			fake_next_pa += 16 << 20;
+		}
+		return 0;
+	}
+	}
+	return -1;
+}
+
+int ioctl(int fd, unsigned long req, ...)
+{
+	va_list ap;
+	void *arg;
+
+	va_start(ap, req);
+	arg = va_arg(ap, void *);
+	va_end(ap);
+
+	switch (req) {
+	case ION_IOC_ALLOC:
+	case ION_IOC_SHARE:
+	case ION_IOC_FREE:
+	case ION_IOC_CUSTOM:
+		return fake_ion(req, arg);
+	}
+	return syscall(SYS_ioctl, fd, req, arg);
+}
+
+static double now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void check(int ok, const char *what)
+{
+	printf("  %-52s %s\n", what, ok ? "ok" : "FAIL");
+	if (!ok)
+		failures++;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+	double x = *(const double *)a;
+	double y = *(const double *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+/*
+ * keep BENCH_LIVE_MAX buffers live, each iteration frees a random one and
+ * allocates a random size in its place, return the ion device ALLOC count
+ */
+static unsigned int run_alloc(const char *name, int iterations, double *lat)
+{
+	struct ion_args *live[BENCH_LIVE_MAX] = {0};
+	double start, total;
+	int nsizes = sizeof(bench_sizes) / sizeof(bench_sizes[0]);
+	int i;
+
+	srand(1);
+	fake_allocs = 0;
+	total = now_ns();
+	for (i = 0; i < iterations; i++) {
+		int slot = rand() % BENCH_LIVE_MAX;
+		int size = bench_sizes[rand() % nsizes];
+
+		if (live[slot])
+			ion_free(live[slot]);
+		start = now_ns();
+		live[slot] = ion_malloc(size, ION_HELPER_ATTR_CACHED);
+		lat[i] = now_ns() - start;
+		if (!live[slot]) {
+			printf("ion_malloc failed\n");
+			exit(1);
+		}
+		// the mapping is real and as large as asked for
+		((char *)live[slot]->va)[size - 1] = (char)i;
+	}
+	total = now_ns() - total;
+	for (i = 0; i < BENCH_LIVE_MAX; i++)
+		if (live[i])
+			ion_free(live[i]);
+
+	qsort(lat, iterations, sizeof(double), cmp_double);
+	printf("%-10s %10.0f allocs/sec, p50 %8.1f ns, p99 %8.1f ns, %6u device allocs\n",
+	       name, iterations / (total / 1e9), lat[iterations / 2],
+	       lat[(int)(iterations * 0.99)], fake_allocs);
+	return fake_allocs;
+}
+
+int main(int argc, char *argv[])
+{
+	int iterations = 100000;
+	unsigned int pooled, unpooled;
+	double *lat;
+	int opt;
+	int i;
+
+	while ((opt = getopt(argc, argv, "n:")) != -1) {
+		switch (opt) {
+		case 'n':
+			iterations = atoi(optarg);
+			break;
+		default:
+			printf("usage: %s [-n iterations]\n", argv[0]);
+			return 2;
+		}
+	}
+	if (iterations <= 0)
+		iterations = 1;
+	lat = (double *)malloc(iterations * sizeof(double));
+	if (!lat)
+		return 1;
+
+	printf("ion_malloc of 4 KB to 1 MB cached buffers, %d held at once:\n",
+	       BENCH_LIVE_MAX);
+	pooled = run_alloc("pooled", iterations, lat);
+	ion_pool_set_watermark(0, 0);
+	unpooled = run_alloc("unpooled", iterations, lat);
+
+	check(unpooled == (unsigned int)iterations, "unpooled allocs all reach the device");
+	check(pooled < unpooled, "pooled allocs reach the device less often");
+	for (i = 0; i < BENCH_HANDLE_MAX && fake_memfd[i] == 0; i++)
+		;
+	check(i == BENCH_HANDLE_MAX, "no device buffer is left behind");
+
+	free(lat);
+	printf("%d failure(s)\n", failures);
+	return failures ? 1 : 0;
+}
@@ -4,6 +4,9 @@
 #include <sys/stat.h>
 #include <sys/ioctl.h>
 #include <fcntl.h>
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
 #include <linux/ion.h>
 #include <linux/pxa_ion.h>
 
@@ -22,7 +25,93 @@
 #define ALOGE(...)
 #endif
 
-struct ion_args *ion_malloc(int size, int attrs)
+#ifndef ION_HELPER_DEV
+#define ION_HELPER_DEV		MARVELL_IONDEV_NAME
+#endif
+
+#define ION_POOL_MAX_CLASSES	32
+
+/*
+ * what ion_malloc hands out: the public ion_args first, so an ion_args
+ * pointer from ion_malloc is an ion_buffer pointer, then what only the
+ * helper needs, kept out of union mem_args
+ */
+struct ion_buffer {
+	struct ion_args args;
+	int attr;
+};
+#define ION_BUFFER(a)	((struct ion_buffer *)(a))
+
+/* free list of mapped buffers with the same length and cache attribute */
+struct ion_pool_class {
+	unsigned int len;
+	int attr;
+	int count;
+	struct ion_args *head;	/* linked through ion_args->p */
+};
+
+static pthread_mutex_t g_ion_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int g_ion_fd = -1;
+static struct ion_pool_class g_ion_pool[ION_POOL_MAX_CLASSES];
+static int g_ion_pool_class_max = ION_POOL_DEFAULT_CLASS_MAX;
+static int g_ion_pool_total_max = ION_POOL_DEFAULT_TOTAL_MAX;
+static int g_ion_pool_total;
+
+/* one /dev/ion client per process, shared by all buffers */
+static int ion_get_fd(void)
+{
+	int fd;
+
+	pthread_mutex_lock(&g_ion_mutex);
+	if (g_ion_fd < 0) {
+		g_ion_fd = open(ION_HELPER_DEV, O_RDWR);
+		if (g_ion_fd < 0)
+			ALOGE("open %s failure, ret:%d", ION_HELPER_DEV, g_ion_fd);
+	}
+	fd = g_ion_fd;
+	pthread_mutex_unlock(&g_ion_mutex);
+
+	return fd;
+}
+
+/*
+ * Round size up to its size class: page granular up to 16 pages,
+ * then 8 classes per power of two, so at most 12.5% is wasted.
+ */
+static unsigned int ion_size_class(int size)
+{
+	unsigned int len = (size + (PAGE_SIZE - 1)) & ~(PAGE_SIZE - 1);
+	unsigned int step = PAGE_SIZE;
+
+	while ((step << 4) < len)
+		step <<= 1;
+	if (step > PAGE_SIZE)
+		step >>= 1;
+	return (len + step - 1) & ~(step - 1);
+}
+
+/* must hold g_ion_mutex */
+static struct ion_pool_class *ion_pool_find(unsigned int len, int attr,
+						int create)
+{
+	struct ion_pool_class *free_slot = NULL;
+	int i;
+
+	for (i = 0; i < ION_POOL_MAX_CLASSES; i++) {
+		if (g_ion_pool[i].len == len && g_ion_pool[i].attr == attr)
+			return &g_ion_pool[i];
+		if (!free_slot && g_ion_pool[i].count == 0)
+			free_slot = &g_ion_pool[i];
+	}
+	if (create && free_slot) {
+		free_slot->len = len;
+		free_slot->attr = attr;
+		free_slot->head = NULL;
+	}
+	return create ? free_slot : NULL;
+}
+
+static struct ion_args *ion_alloc_buffer(unsigned int len, int attr)
 {
 	struct ion_allocation_data ion_data;
 	struct ion_fd_data fd_data = {0};
@@ -32,41 +121,40 @@ struct ion_args *ion_malloc(int size, int attrs)
 	struct ion_args *ion_args;
 	int ret;
 
-	ALOGI("%s() calling, sz %d, attrs %d\n", __FUNCTION__, size, attrs);
-
-	ion_args = (struct ion_args *)calloc(1, sizeof(struct ion_args));
+	ion_args = (struct ion_args *)calloc(1, sizeof(struct ion_buffer));
 	if (!ion_args) {
 		ALOGE("malloc failure %s, %d\n", __func__, __LINE__);
 		return NULL;
 	}
-	ion_args->fd = open("/dev/ion", O_RDWR);
-	if (ion_args->fd < 0) {
-		ALOGE("open /dev/ion failure, ret:%d", ion_args->fd);
+	ion_args->fd = ion_get_fd();
+	if (ion_args->fd < 0)
 		goto out;
-	}
 
 	memset(&ion_data, 0, sizeof(struct ion_allocation_data));
-	/* align to PAGE_SIZE */
-	ion_data.len = (size + (PAGE_SIZE - 1)) & ~(PAGE_SIZE - 1);
+	ion_data.len = len;
 	ion_data.align = PAGE_SIZE;
     /* ion_data.heap_id_mask = ION_HEAP_TYPE_DMA_MASK; */
     ion_data.heap_id_mask = ION_HEAP_CARVEOUT_MASK;
 	/*
-	 * attrs:
-	 *	(0, nonCacheable & bufferable),
-	 *	(nonzero, Cacheable & bufferable)
+	 * attr:
+	 *	(ION_HELPER_ATTR_CACHED, Cacheable & bufferable),
+	 *	(ION_HELPER_ATTR_WC, nonCacheable & bufferable),
+	 *	(ION_HELPER_ATTR_NONCACHED, nonCacheable & bufferable)
+	 * ion maps every buffer without ION_FLAG_CACHED write-combined,
+	 * the carveout heap has no strongly ordered user mapping.
 	 */
-	if (attrs) {
+	if (attr == ION_HELPER_ATTR_CACHED) {
 		ion_data.flags = ION_FLAG_CACHED;
 		ion_data.flags |= ION_FLAG_CACHED_NEEDS_SYNC;
 	}
 	ret = ioctl(ion_args->fd, ION_IOC_ALLOC, &ion_data);
 	if (ret < 0) {
 		ALOGE("failed to allocate memory, ret:%d", ret);
-		goto out_alloc;
+		goto out;
 	}
 
 	ion_args->size = ion_data.len;
+	ION_BUFFER(ion_args)->attr = attr;
 	ion_args->handle = ion_data.handle;
 	fd_data.handle = ion_data.handle;
 	ret = ioctl(ion_args->fd, ION_IOC_SHARE, &fd_data);
@@ -74,6 +162,7 @@ struct ion_args *ion_malloc(int size, int attrs)
 		ALOGE("failed to share memory, ret:%d", ret);
 		goto out_share;
 	}
+	ion_args->buf_fd = fd_data.fd;
 
 	ion_region.handle = fd_data.handle;
 	data.cmd = ION_PXA_PHYS;
@@ -81,16 +170,15 @@ struct ion_args *ion_malloc(int size, int attrs)
 	ret = ioctl(ion_args->fd, ION_IOC_CUSTOM, &data);
 	if (ret < 0) {
 		ALOGE("failed to get physical address, ret:%d", ret);
-		goto out_share;
+		goto out_phys;
 	}
-	ion_args->buf_fd = fd_data.fd;
 	ion_args->pa = (void*)(ion_region.addr);
 
 	ion_args->va = mmap(NULL, ion_args->size, PROT_READ
 				| PROT_WRITE, MAP_SHARED, fd_data.fd, 0);
 	if (ion_args->va == MAP_FAILED) {
 		ALOGE("failed to maping");
-		goto out_share;
+		goto out_phys;
 	}
 #if 0
 	/*
@@ -100,35 +188,25 @@ struct ion_args *ion_malloc(int size, int attrs)
 	memset(ion_args->va, 0, ion_args->size);
 #endif
 
-	ALOGI("%s() ok, sz %d, va 0x%08x, pa 0x%08x, buf_fd %d, ion_args 0x%08x\n", __FUNCTION__, size, (unsigned int)ion_args->va, (unsigned int)ion_args->pa, ion_args->buf_fd, (unsigned int)ion_args);
-
 	return ion_args;
+out_phys:
+	close(ion_args->buf_fd);
 out_share:
 	memset(&req, 0, sizeof(struct ion_handle_data));
 	req.handle = ion_args->handle;
 	ret = ioctl(ion_args->fd, ION_IOC_FREE, &req);
-	if (ret < 0) {
+	if (ret < 0)
 		ALOGE("Failed to free ION buffer, ret:%d", ret);
-		return NULL;
-	}
-out_alloc:
-	close(ion_args->fd);
 out:
 	free(ion_args);
 	return NULL;
 }
 
-int ion_free(struct ion_args *ion_args)
+static int ion_release_buffer(struct ion_args *ion_args)
 {
 	struct ion_handle_data req = {0};
 	int ret;
 
-	ALOGI("%s() calling, ion_args 0x%08x\n", __FUNCTION__, (unsigned int)ion_args);
-
-	if (!ion_args)
-		return -1;
-	if (ion_args->fd < 0)
-		return -2;
 	munmap(ion_args->va, ion_args->size);
 	req.handle = ion_args->handle;
 	ret = ioctl(ion_args->fd, ION_IOC_FREE, &req);
@@ -140,18 +218,128 @@ int ion_free(struct ion_args *ion_args)
 	}
 	/* close buf_fd to release dmabuf */
 	close(ion_args->buf_fd);
-	close(ion_args->fd);
-	ALOGI("%s() ok before calling free for ion_args 0x%08x\n", __FUNCTION__, (unsigned int)ion_args);
 	free(ion_args);
 
 	return 0;
 }
 
+struct ion_args *ion_malloc(int size, int attrs)
+{
+	struct ion_pool_class *pool;
+	struct ion_args *ion_args = NULL;
+	unsigned int len = ion_size_class(size);
+
+	ALOGI("%s() calling, sz %d, attrs %d\n", __FUNCTION__, size, attrs);
+
+	pthread_mutex_lock(&g_ion_mutex);
+	pool = ion_pool_find(len, attrs, 0);
+	if (pool && pool->head) {
+		ion_args = pool->head;
+		pool->head = ion_args->p;
+		pool->count--;
+		g_ion_pool_total -= ion_args->size;
+		ion_args->p = NULL;
+	}
+	pthread_mutex_unlock(&g_ion_mutex);
+
+	if (!ion_args)
+		ion_args = ion_alloc_buffer(len, attrs);
+	/* the carveout may be full of our own pooled buffers, give them back once */
+	if (!ion_args && ion_pool_trim(0) > 0)
+		ion_args = ion_alloc_buffer(len, attrs);
+	if (!ion_args)
+		return NULL;
+
+	ALOGI("%s() ok, sz %d, va 0x%08x, pa 0x%08x, buf_fd %d, ion_args 0x%08x\n", __FUNCTION__, size, (unsigned int)ion_args->va, (unsigned int)ion_args->pa, ion_args->buf_fd, (unsigned int)ion_args);
+
+	return ion_args;
+}
+
+int ion_free(struct ion_args *ion_args)
+{
+	struct ion_pool_class *pool = NULL;
+
+	ALOGI("%s() calling, ion_args 0x%08x\n", __FUNCTION__, (unsigned int)ion_args);
+
+	if (!ion_args)
+		return -1;
+	if (ion_args->fd < 0)
+		return -2;
+
+	/* keep it mapped for the next ion_malloc of the same class */
+	pthread_mutex_lock(&g_ion_mutex);
+	if (g_ion_pool_total + (int)ion_args->size <= g_ion_pool_total_max)
+		pool = ion_pool_find(ion_args->size, ION_BUFFER(ion_args)->attr, 1);
+	if (pool && pool->count < g_ion_pool_class_max) {
+		ion_args->p = pool->head;
+		pool->head = ion_args;
+		pool->count++;
+		g_ion_pool_total += ion_args->size;
+		pthread_mutex_unlock(&g_ion_mutex);
+		return 0;
+	}
+	pthread_mutex_unlock(&g_ion_mutex);
+
+	return ion_release_buffer(ion_args);
+}
+
+void ion_pool_set_watermark(int class_max, int total_max)
+{
+	pthread_mutex_lock(&g_ion_mutex);
+	g_ion_pool_class_max = class_max < 0 ? 0 : class_max;
+	g_ion_pool_total_max = total_max < 0 ? 0 : total_max;
+	pthread_mutex_unlock(&g_ion_mutex);
+
+	ion_pool_trim(total_max);
+}
+
+int ion_pool_trim(int keep)
+{
+	struct ion_args *list = NULL;
+	struct ion_args *ion_args;
+	int released = 0;
+	int i;
+
+	/* unlink under the lock, release outside of it */
+	pthread_mutex_lock(&g_ion_mutex);
+	for (i = 0; i < ION_POOL_MAX_CLASSES; i++) {
+		struct ion_pool_class *pool = &g_ion_pool[i];
+		while (pool->head && (g_ion_pool_total > keep
+				|| pool->count > g_ion_pool_class_max)) {
+			ion_args = pool->head;
+			pool->head = ion_args->p;
+			pool->count--;
+			g_ion_pool_total -= ion_args->size;
+			released += ion_args->size;
+			ion_args->p = list;
+			list = ion_args;
+		}
+	}
+	pthread_mutex_unlock(&g_ion_mutex);
+
+	while (list) {
+		ion_args = list;
+		list = ion_args->p;
+		ion_release_buffer(ion_args);
+	}
+
+	return released;
+}
+
 void ion_flush_cache(struct ion_args *ion_args, int offset, int size, int dir)
 {
 	struct ion_pxa_cache_region region;
 	struct ion_custom_data data;
 
+	/*
+	 * uncached mappings have nothing to clean or invalidate, only
+	 * order the CPU writes still sitting in the write buffer
+	 */
+	if (ION_BUFFER(ion_args)->attr != ION_HELPER_ATTR_CACHED) {
+		__sync_synchronize();
+		return;
+	}
+
 	memset(&region, 0, sizeof(struct ion_pxa_cache_region));
 	memset(&data, 0, sizeof(struct ion_custom_data));
 	region.handle = ion_args->handle;
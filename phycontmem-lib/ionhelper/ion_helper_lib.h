@@ -6,10 +6,30 @@ extern "C"
 {
 #endif
 
+/* ion_malloc attrs */
+#define ION_HELPER_ATTR_NONCACHED	0
+#define ION_HELPER_ATTR_CACHED		1
+#define ION_HELPER_ATTR_WC		2
 struct ion_args *ion_malloc(int size, int attrs);
+/* ion_free and ion_flush_cache take the pointer ion_malloc returned, not a copy */
 int ion_free(struct ion_args *args);
 void ion_flush_cache(struct ion_args *ion_args, int offset, int size, int dir);
 
+/*
+ * Freed buffers are kept mapped in per size class free lists and handed
+ * out again by ion_malloc, instead of going through ALLOC/SHARE/PHYS/mmap.
+ * class_max: max free buffers kept per size class, 0 disables pooling.
+ * total_max: max bytes kept in all free lists.
+ * The carveout heap is shared by every process, so by default a process
+ * keeps about one 1080p NV12 frame around, and ion_malloc trims the pool
+ * and retries once when the heap is exhausted.
+ */
+#define ION_POOL_DEFAULT_CLASS_MAX	4
+#define ION_POOL_DEFAULT_TOTAL_MAX	(4 << 20)
+void ion_pool_set_watermark(int class_max, int total_max);
+/* release pooled buffers until at most keep bytes stay pooled, return bytes released */
+int ion_pool_trim(int keep);
+
 #ifdef __cplusplus
 }
 #endif
@@ -4,6 +4,8 @@
  */
 
 #include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
 #include <linux/pxa_ion.h>
 #include <fcntl.h>
 #include <sys/mman.h>
@@ -16,33 +18,119 @@
 //for bmm like
 typedef struct phycontmem_node{
 	union mem_args args;
-	struct phycontmem_node* next;
+	/*
+	 * offsets [dirty_start, dirty_end) written by the CPU since the last
+	 * clean, only valid while dirty_tracked: phy_cont_mark_dirty sets it
+	 * and the next clean clears it
+	 */
+	int dirty_tracked;
+	unsigned int dirty_start;
+	unsigned int dirty_end;
 }PHYCONTMEM_NODE;
 
-static PHYCONTMEM_NODE* g_phycontmemlist = NULL;
+/*
+ * Two indexes over the same nodes, sorted by start VA and by start PA.
+ * Regions never overlap, so a range lookup is a binary search for the
+ * last region starting at or below the address.
+ */
+typedef struct phycontmem_index{
+	PHYCONTMEM_NODE** by_va;
+	PHYCONTMEM_NODE** by_pa;
+	int count;
+	int capacity;
+}PHYCONTMEM_INDEX;
+
+static PHYCONTMEM_INDEX g_phycontmemindex = {NULL, NULL, 0, 0};
+
+//lookups share the lock, only malloc/free take it exclusively
+static pthread_rwlock_t g_phycontmemindex_lock = PTHREAD_RWLOCK_INITIALIZER;
+//flushes run under the shared lock, dirty ranges need their own
+static pthread_mutex_t g_phycontmem_dirty_lock = PTHREAD_MUTEX_INITIALIZER;
 
-static pthread_mutex_t g_phycontmemlist_mutex = PTHREAD_MUTEX_INITIALIZER;
+#define NODE_VA(pnode)	((unsigned int)(pnode)->args.mem.va)
+#define NODE_PA(pnode)	((unsigned int)(pnode)->args.mem.pa)
 
-static __inline void list_add_node(PHYCONTMEM_NODE* pnode)
+//return the position of the last region whose start <= addr, or -1
+static int index_search(PHYCONTMEM_NODE** table, int count, unsigned int addr, int by_pa)
 {
-	pnode->next = g_phycontmemlist;
-	g_phycontmemlist = pnode;
-	return;
+	int lo = 0;
+	int hi = count - 1;
+	int pos = -1;
+
+	while(lo <= hi) {
+		int mid = (lo + hi) >> 1;
+		unsigned int start = by_pa ? NODE_PA(table[mid]) : NODE_VA(table[mid]);
+		if(start <= addr) {
+			pos = mid;
+			lo = mid + 1;
+		}else{
+			hi = mid - 1;
+		}
+	}
+	return pos;
+}
+
+static void index_insert(PHYCONTMEM_NODE** table, int count, PHYCONTMEM_NODE* pnode, int by_pa)
+{
+	unsigned int addr = by_pa ? NODE_PA(pnode) : NODE_VA(pnode);
+	int pos = index_search(table, count, addr, by_pa) + 1;
+
+	memmove(&table[pos + 1], &table[pos], (count - pos) * sizeof(PHYCONTMEM_NODE*));
+	table[pos] = pnode;
+}
+
+static void index_remove(PHYCONTMEM_NODE** table, int count, PHYCONTMEM_NODE* pnode, int by_pa)
+{
+	unsigned int addr = by_pa ? NODE_PA(pnode) : NODE_VA(pnode);
+	int pos = index_search(table, count, addr, by_pa);
+
+	if(pos < 0 || table[pos] != pnode) {
+		return;
+	}
+	memmove(&table[pos], &table[pos + 1], (count - pos - 1) * sizeof(PHYCONTMEM_NODE*));
+}
+
+static int list_add_node(PHYCONTMEM_NODE* pnode)
+{
+	PHYCONTMEM_INDEX* pindex = &g_phycontmemindex;
+
+	if(pindex->count == pindex->capacity) {
+		int capacity = pindex->capacity ? pindex->capacity * 2 : 32;
+		PHYCONTMEM_NODE** by_va;
+		PHYCONTMEM_NODE** by_pa;
+
+		by_va = (PHYCONTMEM_NODE**)realloc(pindex->by_va, capacity * sizeof(PHYCONTMEM_NODE*));
+		if(by_va == NULL) {
+			return -1;
+		}
+		pindex->by_va = by_va;
+		by_pa = (PHYCONTMEM_NODE**)realloc(pindex->by_pa, capacity * sizeof(PHYCONTMEM_NODE*));
+		if(by_pa == NULL) {
+			return -1;
+		}
+		pindex->by_pa = by_pa;
+		pindex->capacity = capacity;
+	}
+
+	index_insert(pindex->by_va, pindex->count, pnode, 0);
+	index_insert(pindex->by_pa, pindex->count, pnode, 1);
+	pindex->count++;
+	return 0;
 }
 
 static PHYCONTMEM_NODE* list_find_by_va_range(void* VA)
 {
+	PHYCONTMEM_INDEX* pindex = &g_phycontmemindex;
 	PHYCONTMEM_NODE* pnode;
+	int pos;
 
-	pnode = g_phycontmemlist;
-	while(pnode) {
-		if((unsigned int)VA >= (unsigned int)pnode->args.mem.va
-			&& (unsigned int)VA
-			< (unsigned int)pnode->args.mem.va
-			+ pnode->args.mem.size) {
-			return pnode;
-		}
-		pnode = pnode->next;
+	pos = index_search(pindex->by_va, pindex->count, (unsigned int)VA, 0);
+	if(pos < 0) {
+		return NULL;
+	}
+	pnode = pindex->by_va[pos];
+	if((unsigned int)VA < NODE_VA(pnode) + pnode->args.mem.size) {
+		return pnode;
 	}
 	return NULL;
 }
@@ -50,40 +138,33 @@ static PHYCONTMEM_NODE* list_find_by_va_range(void* VA)
 
 static PHYCONTMEM_NODE* list_find_by_pa_range(unsigned int PA)
 {
+	PHYCONTMEM_INDEX* pindex = &g_phycontmemindex;
 	PHYCONTMEM_NODE* pnode;
+	int pos;
 
-	pnode = g_phycontmemlist;
-	while(pnode) {
-		if(PA >= (unsigned int)pnode->args.mem.pa
-			&& PA < (unsigned int)pnode->args.mem.pa
-			+ (unsigned int)pnode->args.mem.size) {
-			return pnode;
-		}
-		pnode = pnode->next;
+	pos = index_search(pindex->by_pa, pindex->count, PA, 1);
+	if(pos < 0) {
+		return NULL;
+	}
+	pnode = pindex->by_pa[pos];
+	if(PA < NODE_PA(pnode) + pnode->args.mem.size) {
+		return pnode;
 	}
 	return NULL;
 }
 
 static PHYCONTMEM_NODE* list_remove_by_va(void* VA)
 {
-	PHYCONTMEM_NODE* pPrev = NULL;
+	PHYCONTMEM_INDEX* pindex = &g_phycontmemindex;
 	PHYCONTMEM_NODE* pnode;
 
-	pnode = g_phycontmemlist;
-	while(pnode) {
-		if(VA == pnode->args.mem.va) {
-			break;
-		}
-		pPrev = pnode;
-		pnode = pnode->next;
-	}
-	if(pnode != NULL) {
-		if(pPrev) {
-			pPrev->next = pnode->next;
-		}else{
-			g_phycontmemlist = pnode->next;
-		}
+	pnode = list_find_by_va_range(VA);
+	if(pnode == NULL || pnode->args.mem.va != VA) {
+		return NULL;
 	}
+	index_remove(pindex->by_va, pindex->count, pnode, 0);
+	index_remove(pindex->by_pa, pindex->count, pnode, 1);
+	pindex->count--;
 	return pnode;
 }
 
@@ -93,12 +174,18 @@ void* phy_cont_malloc(int size, int attr)
 	void* VA = NULL;
 
 	struct ion_args *args;
-	pnode = (PHYCONTMEM_NODE*)malloc(sizeof(PHYCONTMEM_NODE));
+	pnode = (PHYCONTMEM_NODE*)calloc(1, sizeof(PHYCONTMEM_NODE));
 
 	if(pnode == NULL) {
 		return NULL;
 	}
-	attr = (attr == PHY_CONT_MEM_ATTR_DEFAULT) ? ION_FLAG_CACHED : 0;
+	if(attr == PHY_CONT_MEM_ATTR_DEFAULT) {
+		attr = ION_HELPER_ATTR_CACHED;
+	} else if(attr & PHY_CONT_MEM_ATTR_WC) {
+		attr = ION_HELPER_ATTR_WC;
+	} else {
+		attr = ION_HELPER_ATTR_NONCACHED;
+	}
 	args = ion_malloc(size, attr);
 	if (!args) {
 		free(pnode);
@@ -108,9 +195,14 @@ void* phy_cont_malloc(int size, int attr)
 	pnode->args.ion.p = args;
         VA = pnode->args.ion.va;
 
-	pthread_mutex_lock(&g_phycontmemlist_mutex);
-	list_add_node(pnode);
-	pthread_mutex_unlock(&g_phycontmemlist_mutex);
+	pthread_rwlock_wrlock(&g_phycontmemindex_lock);
+	if(list_add_node(pnode) < 0) {
+		pthread_rwlock_unlock(&g_phycontmemindex_lock);
+		ion_free(args);
+		free(pnode);
+		return NULL;
+	}
+	pthread_rwlock_unlock(&g_phycontmemindex_lock);
 
 	return VA;
 }
@@ -118,9 +210,9 @@ void* phy_cont_malloc(int size, int attr)
 void phy_cont_free(void* VA)
 {
 	PHYCONTMEM_NODE* pnode;
-	pthread_mutex_lock(&g_phycontmemlist_mutex);
+	pthread_rwlock_wrlock(&g_phycontmemindex_lock);
 	pnode = list_remove_by_va(VA);
-	pthread_mutex_unlock(&g_phycontmemlist_mutex);
+	pthread_rwlock_unlock(&g_phycontmemindex_lock);
 	if(pnode) {
 		ion_free(pnode->args.ion.p);
 		free(pnode);
@@ -132,13 +224,13 @@ unsigned int phy_cont_getpa(void* VA)
 {
 	PHYCONTMEM_NODE* pnode;
 	unsigned int PA = 0;
-	pthread_mutex_lock(&g_phycontmemlist_mutex);
+	pthread_rwlock_rdlock(&g_phycontmemindex_lock);
 	pnode = list_find_by_va_range(VA);
 	if(pnode) {
 		PA = ((unsigned int)VA - (unsigned int)pnode->args.mem.va)
 			+ (unsigned int)pnode->args.mem.pa;
 	}
-	pthread_mutex_unlock(&g_phycontmemlist_mutex);
+	pthread_rwlock_unlock(&g_phycontmemindex_lock);
 	return PA;
 }
 
@@ -147,69 +239,187 @@ void* phy_cont_getva(unsigned int PA)
 {
 	PHYCONTMEM_NODE* pnode;
 	void* VA = NULL;
-	pthread_mutex_lock(&g_phycontmemlist_mutex);
+	pthread_rwlock_rdlock(&g_phycontmemindex_lock);
 	pnode = list_find_by_pa_range(PA);
 	if(pnode) {
 		VA = (void*)((PA-(unsigned int)pnode->args.mem.pa)
 			+ (unsigned int)pnode->args.mem.va);
 	}
-	pthread_mutex_unlock(&g_phycontmemlist_mutex);
+	pthread_rwlock_unlock(&g_phycontmemindex_lock);
 	return VA;
 }
 
-void phy_cont_flush_cache(void* VA, int dir)
+static int flush_dir_to_ion(int dir)
 {
-	PHYCONTMEM_NODE* pnode;
-	int ion_dir;
-
 	if (dir == PHY_CONT_MEM_FLUSH_BIDIRECTION) {
-		ion_dir = PXA_DMA_BIDIRECTIONAL;
+		return PXA_DMA_BIDIRECTIONAL;
 	} else if (dir == PHY_CONT_MEM_FLUSH_TO_DEVICE) {
-		ion_dir = PXA_DMA_TO_DEVICE;
+		return PXA_DMA_TO_DEVICE;
 	} else if (dir == PHY_CONT_MEM_FLUSH_FROM_DEVICE) {
-		ion_dir = PXA_DMA_FROM_DEVICE;
-	} else {
-		return;
+		return PXA_DMA_FROM_DEVICE;
+	}
+	return -1;
+}
+
+/*
+ * must hold g_phycontmemindex_lock. A clean right after a mark only
+ * needs the marked part of [offset, offset + size), without a mark
+ * since the last clean it cleans everything; invalidation always needs
+ * the whole range since the device may have written any of it.
+ */
+static void node_flush(PHYCONTMEM_NODE* pnode, unsigned int offset, unsigned int size, int ion_dir)
+{
+	if (ion_dir == PXA_DMA_TO_DEVICE) {
+		unsigned int end = offset + size;
+
+		pthread_mutex_lock(&g_phycontmem_dirty_lock);
+		if (pnode->dirty_tracked) {
+			if (offset < pnode->dirty_start)
+				offset = pnode->dirty_start;
+			if (end > pnode->dirty_end)
+				end = pnode->dirty_end;
+			if (offset > end)
+				end = offset;
+			/*
+			 * the clean uses up the mark, whatever is written after
+			 * it without a new mark gets the full clean again
+			 */
+			pnode->dirty_tracked = 0;
+			pnode->dirty_start = pnode->dirty_end = 0;
+		}
+		pthread_mutex_unlock(&g_phycontmem_dirty_lock);
+		size = end - offset;
+		if (size == 0)
+			return;
+	} else if (ion_dir == PXA_DMA_BIDIRECTIONAL) {
+		//cleans the whole range as well
+		pthread_mutex_lock(&g_phycontmem_dirty_lock);
+		pnode->dirty_tracked = 0;
+		pnode->dirty_start = pnode->dirty_end = 0;
+		pthread_mutex_unlock(&g_phycontmem_dirty_lock);
 	}
-	pthread_mutex_lock(&g_phycontmemlist_mutex);
+	ion_flush_cache(pnode->args.ion.p, offset, size, ion_dir);
+}
+
+void phy_cont_mark_dirty(void* VA, unsigned long size)
+{
+	PHYCONTMEM_NODE* pnode;
+	unsigned int start;
+	unsigned int end;
+
+	pthread_rwlock_rdlock(&g_phycontmemindex_lock);
 	pnode = list_find_by_va_range(VA);
 	if (pnode == NULL) {
-		pthread_mutex_unlock(&g_phycontmemlist_mutex);
+		pthread_rwlock_unlock(&g_phycontmemindex_lock);
 		return;
 	}
-	ion_flush_cache(&pnode->args.ion, 0, pnode->args.ion.size, ion_dir);
-	pthread_mutex_unlock(&g_phycontmemlist_mutex);
+	start = (unsigned int)VA - NODE_VA(pnode);
+	end = (size > pnode->args.ion.size - start) ? pnode->args.ion.size : start + size;
 
-	return;
+	pthread_mutex_lock(&g_phycontmem_dirty_lock);
+	if (!pnode->dirty_tracked || pnode->dirty_start == pnode->dirty_end) {
+		pnode->dirty_start = start;
+		pnode->dirty_end = end;
+	} else {
+		if (start < pnode->dirty_start)
+			pnode->dirty_start = start;
+		if (end > pnode->dirty_end)
+			pnode->dirty_end = end;
+	}
+	pnode->dirty_tracked = 1;
+	pthread_mutex_unlock(&g_phycontmem_dirty_lock);
+	pthread_rwlock_unlock(&g_phycontmemindex_lock);
 }
 
-void phy_cont_flush_cache_range(void* VA, unsigned long size, int dir)
+void phy_cont_flush_cache(void* VA, int dir)
 {
 	PHYCONTMEM_NODE* pnode;
 	int ion_dir;
 
-	if (dir == PHY_CONT_MEM_FLUSH_BIDIRECTION) {
-		ion_dir = PXA_DMA_BIDIRECTIONAL;
-	} else if (dir == PHY_CONT_MEM_FLUSH_TO_DEVICE) {
-		ion_dir = PXA_DMA_TO_DEVICE;
-	} else if (dir == PHY_CONT_MEM_FLUSH_FROM_DEVICE) {
-		ion_dir = PXA_DMA_FROM_DEVICE;
-	} else {
+	ion_dir = flush_dir_to_ion(dir);
+	if (ion_dir < 0) {
 		return;
 	}
-	pthread_mutex_lock(&g_phycontmemlist_mutex);
+	pthread_rwlock_rdlock(&g_phycontmemindex_lock);
 	pnode = list_find_by_va_range(VA);
 	if (pnode == NULL) {
-		pthread_mutex_unlock(&g_phycontmemlist_mutex);
+		pthread_rwlock_unlock(&g_phycontmemindex_lock);
 		return;
 	}
-	if ((unsigned long)VA + size > (unsigned long)(pnode->args.ion.va) +
-		pnode->args.ion.size)
-		size = pnode->args.ion.size + (unsigned long)(pnode->args.ion.va)
-			- (unsigned long)VA;
-	ion_flush_cache(&pnode->args.ion,
-			(unsigned long)VA - (unsigned long)pnode->args.ion.va,
-			size, ion_dir);
-	pthread_mutex_unlock(&g_phycontmemlist_mutex);
+	node_flush(pnode, 0, pnode->args.ion.size, ion_dir);
+	pthread_rwlock_unlock(&g_phycontmemindex_lock);
+
 	return;
 }
+
+void phy_cont_flush_cache_range(void* VA, unsigned long size, int dir)
+{
+	PHY_CONT_FLUSH_REGION region;
+
+	region.VA = VA;
+	region.size = size;
+	region.dir = dir;
+	phy_cont_flush_cache_batch(&region, 1);
+}
+
+void phy_cont_flush_cache_batch(const PHY_CONT_FLUSH_REGION* regions, int count)
+{
+	PHYCONTMEM_NODE* pnode = NULL;
+	unsigned int offset = 0;
+	unsigned int end = 0;
+	int ion_dir = -1;
+	int i;
+
+	pthread_rwlock_rdlock(&g_phycontmemindex_lock);
+	for (i = 0; i < count; i++) {
+		PHYCONTMEM_NODE* pcur;
+		unsigned int cur_offset;
+		unsigned int cur_end;
+		int cur_dir;
+
+		cur_dir = flush_dir_to_ion(regions[i].dir);
+		if (cur_dir < 0) {
+			continue;
+		}
+		pcur = list_find_by_va_range(regions[i].VA);
+		if (pcur == NULL) {
+			continue;
+		}
+		cur_offset = (unsigned int)regions[i].VA - NODE_VA(pcur);
+		if (regions[i].size > pcur->args.ion.size - cur_offset)
+			cur_end = pcur->args.ion.size;
+		else
+			cur_end = cur_offset + regions[i].size;
+
+		//coalesce overlapping or adjacent ranges of one buffer into one sync
+		if (pcur == pnode && cur_dir == ion_dir
+			&& cur_offset <= end && cur_end >= offset) {
+			if (cur_offset < offset)
+				offset = cur_offset;
+			if (cur_end > end)
+				end = cur_end;
+			continue;
+		}
+		if (pnode) {
+			node_flush(pnode, offset, end - offset, ion_dir);
+		}
+		pnode = pcur;
+		offset = cur_offset;
+		end = cur_end;
+		ion_dir = cur_dir;
+	}
+	if (pnode) {
+		node_flush(pnode, offset, end - offset, ion_dir);
+	}
+	pthread_rwlock_unlock(&g_phycontmemindex_lock);
+}
+
+void phy_cont_set_pool_watermark(int class_max, int total_max)
+{
+	ion_pool_set_watermark(class_max, total_max);
+}
+
+int phy_cont_trim(int keep)
+{
+	return ion_pool_trim(keep);
+}
@@ -55,6 +55,20 @@ void* phy_cont_getva(unsigned int PA);		//return virtual address, if the memory
 void phy_cont_flush_cache(void* VA, int dir);		//only for the memory allocated by phy_cont_malloc. dir should be PHY_CONT_MEM_FLUSH_BIDIRECTION, PHY_CONT_MEM_FLUSH_TO_DEVICE or PHY_CONT_MEM_FLUSH_FROM_DEVICE
 void phy_cont_flush_cache_range(void* VA, unsigned long size, int dir);	//only for the memory allocated by phy_cont_malloc. dir should be PHY_CONT_MEM_FLUSH_BIDIRECTION, PHY_CONT_MEM_FLUSH_TO_DEVICE or PHY_CONT_MEM_FLUSH_FROM_DEVICE
 
+typedef struct phy_cont_flush_region {
+	void* VA;
+	unsigned long size;
+	int dir;
+} PHY_CONT_FLUSH_REGION;
+void phy_cont_flush_cache_batch(const PHY_CONT_FLUSH_REGION* regions, int count);	//flush several ranges under one lookup, adjacent ranges of the same buffer and dir are merged into one sync
+
+//the next PHY_CONT_MEM_FLUSH_TO_DEVICE after a mark only cleans the marked bytes, a flush with no mark since the last one cleans the whole range
+void phy_cont_mark_dirty(void* VA, unsigned long size);	//record that the CPU wrote [VA, VA+size) of memory allocated by phy_cont_malloc
+
+//freed memory is kept mapped in size class pools for reuse by phy_cont_malloc
+void phy_cont_set_pool_watermark(int class_max, int total_max);	//class_max: max free buffers kept per size class (0 disables pooling), total_max: max pooled bytes
+int phy_cont_trim(int keep);				//release pooled memory until at most keep bytes stay pooled, return released bytes
+
 
 #ifdef __cplusplus
 }
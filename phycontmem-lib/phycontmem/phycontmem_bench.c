@@ -0,0 +1,313 @@
+/*
+ * (C) Copyright 2010 Marvell International Ltd.
+ * All Rights Reserved
+ */
+
+/*
+ * Host bench of libphycontmem, linked against a fake ion_helper that hands
+ * out anonymous mappings and counts the bytes it is asked to clean.
+ *
+ * dirty: a writer fills a few KB of a large cached bitstream buffer, then
+ * the whole buffer is flushed to the device as a codec does. Without a mark
+ * every flush cleans the whole buffer, with phy_cont_mark_dirty it cleans
+ * only what was written.
+ *
+ * lookup: phy_cont_getpa and phy_cont_getva over 10, 100 and 1000 live
+ * regions, against the former walk of a list with the newest region first
+ * under a mutex.
+ *
+ * phycontmem.c keeps addresses in 32 bits, so on a 64-bit host the fake
+ * buffers are mapped below 4 GB.
+ *
+ * Build: make -f Makefile_general bench
+ * Usage: phycontmem_bench [-n iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <linux/pxa_ion.h>
+
+#include "ion_helper_lib.h"
+#include "phycontmem.h"
+
+#if (defined(__LP64__) || defined(_WIN64)) && !defined(MAP_32BIT)
+#error "phycontmem.c stores addresses in 32 bits, build the bench for a 32-bit target"
+#endif
+
+#ifdef MAP_32BIT
+#define BENCH_MAP_FLAGS		(MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT)
+#else
+#define BENCH_MAP_FLAGS		(MAP_PRIVATE | MAP_ANONYMOUS)
+#endif
+
+#define BENCH_STRM_SIZE		(2 * 1024 * 1024)	// one vmeta stream buffer
+#define BENCH_STRM_NUM		4
+#define BENCH_FRAME_MAX		(16 * 1024)		// bytes written per frame
+#define BENCH_REGION_SIZE	(16 * 1024)
+#define BENCH_REGION_MAX	1000
+
+static unsigned int fake_next_pa = 0x10000000;
+static unsigned long long fake_clean_bytes;
+static unsigned int fake_clean_calls;
+static int failures;
+
+/*
+ * fake ion_helper: a physically contiguous buffer is an anonymous mapping
+ * with a made up physical address, a cache clean is only counted
+ */
+struct ion_args *ion_malloc(int size, int attrs)
+{
+	struct ion_args *args;
+	unsigned int len = (size + 4095) & ~4095;
+
+	(void)attrs;
+	args = (struct ion_args *)calloc(1, sizeof(struct ion_args));
+	if (!args)
+		return NULL;
+	args->va = mmap(NULL, len, PROT_READ | PROT_WRITE, BENCH_MAP_FLAGS, -1, 0);
+	if (args->va == MAP_FAILED) {
+		free(args);
+		return NULL;
+	}
+	args->fd = 0;
+	args->size = len;
+	args->pa = (void *)(unsigned long)fake_next_pa;
+	fake_next_pa += len + 4096;	// leave a hole between regions
+	return args;
+}
+
+int ion_free(struct ion_args *args)
+{
+	munmap(args->va, args->size);
+	free(args);
+	return 0;
+}
+
+void ion_flush_cache(struct ion_args *args, int offset, int size, int dir)
+{
+	(void)args;
+	(void)offset;
+	if (dir == PXA_DMA_TO_DEVICE) {
+		fake_clean_bytes += size;
+		fake_clean_calls++;
+	}
+}
+
+void ion_pool_set_watermark(int class_max, int total_max)
+{
+	(void)class_max;
+	(void)total_max;
+}
+
+int ion_pool_trim(int keep)
+{
+	(void)keep;
+	return 0;
+}
+
+static double now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void check(int ok, const char *what)
+{
+	printf("  %-52s %s\n", what, ok ? "ok" : "FAIL");
+	if (!ok)
+		failures++;
+}
+
+/*
+ * write a frame of 1..BENCH_FRAME_MAX bytes into each stream buffer in
+ * turn, optionally mark it, then flush the whole buffer to the device
+ */
+static unsigned long long run_dirty(const char *name, int mark, int iterations,
+				     unsigned long long *written)
+{
+	char *strm[BENCH_STRM_NUM];
+	double start;
+	int i;
+
+	for (i = 0; i < BENCH_STRM_NUM; i++) {
+		strm[i] = (char *)phy_cont_malloc(BENCH_STRM_SIZE, PHY_CONT_MEM_ATTR_DEFAULT);
+		if (!strm[i]) {
+			printf("phy_cont_malloc failed\n");
+			exit(1);
+		}
+	}
+
+	srand(1);
+	fake_clean_bytes = 0;
+	fake_clean_calls = 0;
+	*written = 0;
+	start = now_ns();
+	for (i = 0; i < iterations; i++) {
+		char *buf = strm[i % BENCH_STRM_NUM];
+		unsigned int len = 1 + rand() % BENCH_FRAME_MAX;
+		unsigned int offset = rand() % (BENCH_STRM_SIZE - len);
+
+		memset(buf + offset, i, len);
+		*written += len;
+		if (mark)
+			phy_cont_mark_dirty(buf + offset, len);
+		phy_cont_flush_cache(buf, PHY_CONT_MEM_FLUSH_TO_DEVICE);
+	}
+	printf("%-10s %8u flushes, %10.1f KB cleaned per flush, %8.1f ns per flush\n",
+	       name, fake_clean_calls,
+	       fake_clean_calls ? fake_clean_bytes / 1024.0 / fake_clean_calls : 0.0,
+	       (now_ns() - start) / iterations);
+
+	for (i = 0; i < BENCH_STRM_NUM; i++)
+		phy_cont_free(strm[i]);
+	return fake_clean_bytes;
+}
+
+static void bench_dirty(int iterations)
+{
+	unsigned long long written;
+	unsigned long long full;
+	unsigned long long marked;
+
+	full = run_dirty("unmarked", 0, iterations, &written);
+	marked = run_dirty("marked", 1, iterations, &written);
+
+	check(full == (unsigned long long)iterations * BENCH_STRM_SIZE,
+	      "unmarked flushes clean the whole buffer");
+	check(marked == written, "marked flushes clean only the written bytes");
+	check(marked < full, "marking cleans fewer bytes");
+}
+
+/* the lookup phycontmem.c did before the VA/PA index */
+typedef struct legacy_node {
+	unsigned int va;
+	unsigned int pa;
+	unsigned int size;
+	struct legacy_node *next;
+} LEGACY_NODE;
+
+static LEGACY_NODE *legacy_list;
+static pthread_mutex_t legacy_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static unsigned int legacy_getpa(void *VA)
+{
+	LEGACY_NODE *pnode;
+	unsigned int PA = 0;
+
+	pthread_mutex_lock(&legacy_mutex);
+	for (pnode = legacy_list; pnode; pnode = pnode->next) {
+		if ((unsigned int)(unsigned long)VA >= pnode->va
+		    && (unsigned int)(unsigned long)VA < pnode->va + pnode->size) {
+			PA = (unsigned int)(unsigned long)VA - pnode->va + pnode->pa;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&legacy_mutex);
+	return PA;
+}
+
+static void bench_lookup(int regions, int iterations)
+{
+	static char *va[BENCH_REGION_MAX];
+	static LEGACY_NODE legacy[BENCH_REGION_MAX];
+	volatile unsigned long sink = 0;
+	double start, getpa_ns, getva_ns, legacy_ns;
+	int bad = 0;
+	int i;
+
+	legacy_list = NULL;
+	for (i = 0; i < regions; i++) {
+		va[i] = (char *)phy_cont_malloc(BENCH_REGION_SIZE, PHY_CONT_MEM_ATTR_DEFAULT);
+		if (!va[i]) {
+			printf("phy_cont_malloc failed\n");
+			exit(1);
+		}
+		legacy[i].va = (unsigned int)(unsigned long)va[i];
+		legacy[i].pa = phy_cont_getpa(va[i]);
+		legacy[i].size = BENCH_REGION_SIZE;
+		legacy[i].next = legacy_list;
+		legacy_list = &legacy[i];
+	}
+
+	// every lookup lands somewhere inside a random live region
+	srand(regions);
+	start = now_ns();
+	for (i = 0; i < iterations; i++) {
+		int r = rand() % regions;
+		sink += phy_cont_getpa(va[r] + (i & (BENCH_REGION_SIZE - 1)));
+	}
+	getpa_ns = (now_ns() - start) / iterations;
+
+	srand(regions);
+	start = now_ns();
+	for (i = 0; i < iterations; i++) {
+		int r = rand() % regions;
+		sink += (unsigned long)phy_cont_getva(legacy[r].pa + (i & (BENCH_REGION_SIZE - 1)));
+	}
+	getva_ns = (now_ns() - start) / iterations;
+
+	srand(regions);
+	start = now_ns();
+	for (i = 0; i < iterations; i++) {
+		int r = rand() % regions;
+		sink += legacy_getpa(va[r] + (i & (BENCH_REGION_SIZE - 1)));
+	}
+	legacy_ns = (now_ns() - start) / iterations;
+
+	printf("%5d regions: getpa %7.1f ns, getva %7.1f ns, list walk %8.1f ns\n",
+	       regions, getpa_ns, getva_ns, legacy_ns);
+
+	for (i = 0; i < regions; i++) {
+		char *p = va[i] + BENCH_REGION_SIZE - 1;
+		if (phy_cont_getpa(p) != legacy_getpa(p)
+		    || phy_cont_getva(phy_cont_getpa(p)) != p)
+			bad++;
+	}
+	// the hole phycontmem_bench leaves after each region maps to nothing
+	if (phy_cont_getva(legacy[0].pa + BENCH_REGION_SIZE) != NULL)
+		bad++;
+	check(bad == 0, "lookups agree with the list walk");
+
+	for (i = 0; i < regions; i++)
+		phy_cont_free(va[i]);
+	check(phy_cont_getpa(va[0]) == 0, "freed regions are not found");
+}
+
+int main(int argc, char *argv[])
+{
+	int iterations = 10000;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:")) != -1) {
+		switch (opt) {
+		case 'n':
+			iterations = atoi(optarg);
+			break;
+		default:
+			printf("usage: %s [-n iterations]\n", argv[0]);
+			return 2;
+		}
+	}
+	if (iterations <= 0)
+		iterations = 1;
+
+	printf("dirty range of %d KB stream buffers, frames of at most %d KB:\n",
+	       BENCH_STRM_SIZE / 1024, BENCH_FRAME_MAX / 1024);
+	bench_dirty(iterations);
+
+	printf("lookups of %d KB regions, %d per count:\n",
+	       BENCH_REGION_SIZE / 1024, iterations * 10);
+	bench_lookup(10, iterations * 10);
+	bench_lookup(100, iterations * 10);
+	bench_lookup(BENCH_REGION_MAX, iterations * 10);
+
+	printf("%d failure(s)\n", failures);
+	return failures ? 1 : 0;
+}
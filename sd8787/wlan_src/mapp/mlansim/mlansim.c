@@ -0,0 +1,1185 @@
+/** @file  mlansim.c
+  *
+  * @brief Userspace MLAN harness. Runs the unmodified MLAN sources
+  * against simulated MOAL callbacks and a simulated SDIO card, driven
+  * by a script, so the Tx/Rx data path can be exercised and measured
+  * without hardware.
+  *
+  * Copyright (C) 2011-2012, Marvell International Ltd.
+  *
+  * This software file (the "File") is distributed by Marvell International
+  * Ltd. under the terms of the GNU General Public License Version 2, June 1991
+  * (the "License").  You may use, redistribute and/or modify this File in
+  * accordance with the terms and conditions of the License, a copy of which
+  * is available by writing to the Free Software Foundation, Inc.,
+  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA or on the
+  * worldwide web at http://www.gnu.org/licenses/old-licenses/gpl-2.0.txt.
+  *
+  * THE FILE IS DISTRIBUTED AS-IS, WITHOUT WARRANTY OF ANY KIND, AND THE
+  * IMPLIED WARRANTIES OF MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE
+  * ARE EXPRESSLY DISCLAIMED.  The License provides additional details about
+  * this warranty disclaimer.
+  *
+  */
+/************************************************************************
+Change log:
+     10/17/2012: initial version
+************************************************************************/
+
+#include    <stddef.h>
+#include    <unistd.h>
+#include    <sys/time.h>
+#include    <time.h>
+
+#include    "mlansim.h"
+
+/** mlansim version number */
+#define MLANSIM_VER "M1.0"
+
+/** Maximum number of arguments of a script command */
+#define MAX_ARGS		8
+/** Maximum script line length */
+#define MAX_LINE		256
+/** Default firmware image size */
+#define DEF_FW_SIZE		(64 * 1024)
+/** Index of the uAP BSS */
+#define UAP_BSS_INDEX		1
+/** Wait timeout for init and shutdown, in msec */
+#define INIT_TIMEOUT		10000
+
+/** Number of elements */
+#define NELEMENTS(x)		(sizeof(x) / sizeof(x[0]))
+
+/** Script command */
+struct command_node {
+	char *name;
+	int (*handler) (int, char **);
+};
+
+/** Counter source */
+typedef enum _stat_src {
+	STAT_HOST,
+	STAT_CARD,
+	STAT_FUNC,
+} stat_src;
+
+/** Named counter */
+struct stat_node {
+	char *name;
+	stat_src src;
+	size_t offset;
+	t_s64(*func) (void);
+};
+
+/********************************************************
+			Local Variables
+********************************************************/
+
+/** Harness MOAL handle */
+static sim_handle *handle;
+/** Simulated card */
+static sim_card *card;
+/** MP-A Tx enabled */
+static t_u8 opt_mpa_tx = MTRUE;
+/** MP-A Rx enabled */
+static t_u8 opt_mpa_rx = MTRUE;
+/** MP-A Rx slicing enabled */
+static t_u8 opt_rx_slice = MFALSE;
+/** Rx work queue enabled */
+static t_u8 opt_rx_work = MFALSE;
+/** Host side multi-command transfers enabled */
+static t_u8 opt_host_multi_cmd = MFALSE;
+/** Tx packets are queued without kicking the main work */
+static t_u8 tx_held;
+/** Jain fairness index of the last fairness command, in 1/1000 */
+static t_u32 fair_jain;
+/** Longest run of MSDUs of other flows a flow waited for */
+static t_u32 fair_max_gap;
+/** Threads are running */
+static t_u8 started;
+/** Next Tx sequence number per station and TID */
+static t_u32 tx_seq[SIM_MAX_STA][SIM_MAX_TID];
+/** Number of failed commands and expectations */
+static int fail_count;
+/** Current script line */
+static int line_no;
+/** Wall clock at bench start */
+static struct timespec bench_wall;
+/** Process CPU time at bench start */
+static struct timespec bench_cpu;
+
+/********************************************************
+			Local Functions
+********************************************************/
+
+/**
+ *  @brief Sum of out of order Rx packets over all flows
+ *
+ *  @return         Count
+ */
+static t_s64
+stat_rx_out_of_order(void)
+{
+	t_s64 sum = 0;
+	int sta, tid;
+
+	for (sta = 0; sta < SIM_MAX_STA; sta++)
+		for (tid = 0; tid < SIM_MAX_TID; tid++)
+			sum += handle->rx_flow[sta][tid].out_of_order;
+	return sum;
+}
+
+/**
+ *  @brief Tx packets handed to MLAN and not completed
+ *
+ *  @return         Count
+ */
+static t_s64
+stat_tx_pending(void)
+{
+	return (t_s64) handle->tx_submitted - handle->tx_done -
+		handle->tx_failed;
+}
+
+/**
+ *  @brief Jain index of the last fairness command
+ *
+ *  @return         Index in 1/1000
+ */
+static t_s64
+stat_tx_jain(void)
+{
+	return fair_jain;
+}
+
+/**
+ *  @brief Longest wait of a flow in the last fairness command
+ *
+ *  @return         MSDUs
+ */
+static t_s64
+stat_tx_max_gap(void)
+{
+	return fair_max_gap;
+}
+
+/**
+ *  @brief mlan_buffers outstanding
+ *
+ *  @return         Count
+ */
+static t_s64
+stat_mbuf_outstanding(void)
+{
+	return handle->mbuf_count;
+}
+
+/**
+ *  @brief Allocations outstanding
+ *
+ *  @return         Count
+ */
+static t_s64
+stat_malloc_outstanding(void)
+{
+	return handle->malloc_count;
+}
+
+/** Counters that can be printed and checked */
+static struct stat_node stat_list[] = {
+	{"tx_submitted", STAT_HOST, offsetof(sim_handle, tx_submitted)},
+	{"tx_done", STAT_HOST, offsetof(sim_handle, tx_done)},
+	{"tx_failed", STAT_HOST, offsetof(sim_handle, tx_failed)},
+	{"tx_pending", STAT_FUNC, 0, stat_tx_pending},
+	{"tx_jain_permille", STAT_FUNC, 0, stat_tx_jain},
+	{"tx_max_gap", STAT_FUNC, 0, stat_tx_max_gap},
+	{"rx_pkts", STAT_HOST, offsetof(sim_handle, rx_pkts)},
+	{"rx_bytes", STAT_HOST, offsetof(sim_handle, rx_bytes)},
+	{"rx_bad", STAT_HOST, offsetof(sim_handle, rx_bad)},
+	{"rx_out_of_order", STAT_FUNC, 0, stat_rx_out_of_order},
+	{"events", STAT_HOST, offsetof(sim_handle, events)},
+	{"ioctls", STAT_HOST, offsetof(sim_handle, ioctls)},
+	{"asserts", STAT_HOST, offsetof(sim_handle, asserts)},
+	{"mbuf_outstanding", STAT_FUNC, 0, stat_mbuf_outstanding},
+	{"malloc_outstanding", STAT_FUNC, 0, stat_malloc_outstanding},
+	{"alloc_failed", STAT_HOST, offsetof(sim_handle, alloc_failed)},
+	{"reorder_events", STAT_HOST, offsetof(sim_handle, reorder_events)},
+	{"reorder_dropped", STAT_HOST, offsetof(sim_handle, reorder_dropped)},
+	{"reorder_mismatch", STAT_HOST,
+	 offsetof(sim_handle, reorder_mismatch)},
+	{"scan_results", STAT_HOST, offsetof(sim_handle, scan_results)},
+	{"scan_mismatch", STAT_HOST, offsetof(sim_handle, scan_mismatch)},
+	{"fw_blocks", STAT_CARD, offsetof(sim_card_stats, fw_blocks)},
+	{"fw_bytes", STAT_CARD, offsetof(sim_card_stats, fw_bytes)},
+	{"fw_crc_retry", STAT_CARD, offsetof(sim_card_stats, fw_crc_retry)},
+	{"cmds", STAT_CARD, offsetof(sim_card_stats, cmds)},
+	{"cmds_dropped", STAT_CARD, offsetof(sim_card_stats, cmds_dropped)},
+	{"cmds_failed", STAT_CARD, offsetof(sim_card_stats, cmds_failed)},
+	{"cmd_batches", STAT_CARD, offsetof(sim_card_stats, cmd_batches)},
+	{"cmds_batched", STAT_CARD, offsetof(sim_card_stats, cmds_batched)},
+	{"cmd_batch_rejected", STAT_CARD,
+	 offsetof(sim_card_stats, cmd_batch_rejected)},
+	{"cmd_seq_err", STAT_CARD, offsetof(sim_card_stats, cmd_seq_err)},
+	{"card_events", STAT_CARD, offsetof(sim_card_stats, events)},
+	{"tx_writes", STAT_CARD, offsetof(sim_card_stats, tx_writes)},
+	{"tx_mpa_writes", STAT_CARD, offsetof(sim_card_stats, tx_mpa_writes)},
+	{"tx_pkts", STAT_CARD, offsetof(sim_card_stats, tx_pkts)},
+	{"tx_amsdu", STAT_CARD, offsetof(sim_card_stats, tx_amsdu)},
+	{"tx_msdus", STAT_CARD, offsetof(sim_card_stats, tx_msdus)},
+	{"tx_bytes", STAT_CARD, offsetof(sim_card_stats, tx_bytes)},
+	{"tx_out_of_order", STAT_CARD,
+	 offsetof(sim_card_stats, tx_out_of_order)},
+	{"tx_bad", STAT_CARD, offsetof(sim_card_stats, tx_bad)},
+	{"rx_reads", STAT_CARD, offsetof(sim_card_stats, rx_reads)},
+	{"rx_mpa_reads", STAT_CARD, offsetof(sim_card_stats, rx_mpa_reads)},
+	{"card_rx_pkts", STAT_CARD, offsetof(sim_card_stats, rx_pkts)},
+	{"int_reads", STAT_CARD, offsetof(sim_card_stats, int_reads)},
+	{"card_errors", STAT_CARD, offsetof(sim_card_stats, errors)},
+};
+
+/**
+ *  @brief Reads a counter
+ *
+ *  @param node     A pointer to stat_node
+ *  @return         Value
+ */
+static t_s64
+stat_read(struct stat_node *node)
+{
+	t_s64 val;
+
+	switch (node->src) {
+	case STAT_HOST:
+		pthread_mutex_lock(&handle->stats_lock);
+		val = *(t_u32 *) ((t_u8 *) handle + node->offset);
+		pthread_mutex_unlock(&handle->stats_lock);
+		break;
+	case STAT_CARD:
+		pthread_mutex_lock(&card->lock);
+		val = *(t_u32 *) ((t_u8 *) & card->stats + node->offset);
+		pthread_mutex_unlock(&card->lock);
+		break;
+	default:
+		pthread_mutex_lock(&handle->stats_lock);
+		val = node->func();
+		pthread_mutex_unlock(&handle->stats_lock);
+		break;
+	}
+	return val;
+}
+
+/**
+ *  @brief Reports a failed command
+ *
+ *  @param msg      Message
+ *  @return         -1
+ */
+static int
+sim_fail(char *msg)
+{
+	printf("mlansim: line %d: %s\n", line_no, msg);
+	fail_count++;
+	return -1;
+}
+
+/**
+ *  @brief Waits for a flag set by a MOAL callback
+ *
+ *  @param flag     A pointer to the flag
+ *  @return         0 or -1 on timeout
+ */
+static int
+sim_wait_flag(t_u8 * flag)
+{
+	int i;
+	t_u8 done;
+
+	for (i = 0; i < INIT_TIMEOUT; i++) {
+		pthread_mutex_lock(&handle->work_lock);
+		done = *flag;
+		pthread_mutex_unlock(&handle->work_lock);
+		if (done)
+			return 0;
+		usleep(1000);
+	}
+	return -1;
+}
+
+/**
+ *  @brief Converts an option value to an MLAN init parameter
+ *
+ *  @param enable   Option value
+ *  @return         MLAN_INIT_PARA_ENABLED or MLAN_INIT_PARA_DISABLED
+ */
+static t_u32
+init_para(t_u8 enable)
+{
+	return enable ? MLAN_INIT_PARA_ENABLED : MLAN_INIT_PARA_DISABLED;
+}
+
+/**
+ *  @brief Process option command
+ *
+ *  @param argc     Number of arguments
+ *  @param argv     A pointer to arguments array
+ *  @return         0 or -1
+ */
+static int
+process_option(int argc, char *argv[])
+{
+	t_u32 val;
+
+	if (argc != 3)
+		return sim_fail("usage: option <name> <value>");
+	val = strtoul(argv[2], NULL, 0);
+	if (!strcmp(argv[1], "mpa_tx"))
+		opt_mpa_tx = !!val;
+	else if (!strcmp(argv[1], "mpa_rx"))
+		opt_mpa_rx = !!val;
+	else if (!strcmp(argv[1], "rx_slice"))
+		opt_rx_slice = !!val;
+	else if (!strcmp(argv[1], "rx_work"))
+		opt_rx_work = !!val;
+	else if (!strcmp(argv[1], "host_multi_cmd"))
+		opt_host_multi_cmd = !!val;
+	else if (!strcmp(argv[1], "multi_cmd"))
+		card->multi_cmd = !!val;
+	else if (!strcmp(argv[1], "multi_cmd_reject"))
+		card->multi_cmd_reject = !!val;
+	else if (!strcmp(argv[1], "seed"))
+		card->seed = val;
+	else if (!strcmp(argv[1], "timer_scale"))
+		handle->timer_scale = val ? val : 1;
+	else if (!strcmp(argv[1], "alloc_fail_size"))
+		handle->alloc_fail_size = val;
+	else
+		return sim_fail("unknown option");
+	return 0;
+}
+
+/**
+ *  @brief Process fw_crc_error command
+ *
+ *  @param argc     Number of arguments
+ *  @param argv     A pointer to arguments array
+ *  @return         0 or -1
+ */
+static int
+process_fw_crc_error(int argc, char *argv[])
+{
+	if (argc != 2)
+		return sim_fail("usage: fw_crc_error <count>");
+	card->fw_crc_err = strtoul(argv[1], NULL, 0);
+	return 0;
+}
+
+/**
+ *  @brief Process init command: register MLAN, download a synthetic
+ *  firmware image and initialize the firmware. With "fail" the
+ *  initialization is expected to fail.
+ *
+ *  @param argc     Number of arguments
+ *  @param argv     A pointer to arguments array
+ *  @return         0 or -1
+ */
+static int
+process_init(int argc, char *argv[])
+{
+	mlan_device device;
+	mlan_fw_image fw;
+	mlan_status status;
+	t_u32 fw_size = DEF_FW_SIZE, i;
+	t_u8 expect_fail = MFALSE;
+	int ret = 0;
+
+	if (started)
+		return sim_fail("already initialized");
+	if (argc > 1 && !strcmp(argv[argc - 1], "fail")) {
+		expect_fail = MTRUE;
+		argc--;
+	}
+	if (argc > 1)
+		fw_size = strtoul(argv[1], NULL, 0);
+
+	memset(&device, 0, sizeof(device));
+	device.pmoal_handle = handle;
+	device.bss_attr[0].bss_type = MLAN_BSS_TYPE_STA;
+	device.bss_attr[0].frame_type = MLAN_DATA_FRAME_TYPE_ETH_II;
+	device.bss_attr[0].active = MTRUE;
+	device.bss_attr[0].bss_priority = 0;
+	device.bss_attr[0].bss_num = 0;
+	device.bss_attr[UAP_BSS_INDEX].bss_type = MLAN_BSS_TYPE_UAP;
+	device.bss_attr[UAP_BSS_INDEX].frame_type =
+		MLAN_DATA_FRAME_TYPE_ETH_II;
+	device.bss_attr[UAP_BSS_INDEX].active = MTRUE;
+	device.bss_attr[UAP_BSS_INDEX].bss_priority = 0;
+	device.bss_attr[UAP_BSS_INDEX].bss_num = 0;
+	memcpy(&device.callbacks, &sim_callbacks, sizeof(mlan_callbacks));
+	device.int_mode = INT_MODE_SDIO;
+#ifdef DEBUG_LEVEL1
+	device.drvdbg = handle->drvdbg;
+#endif
+#ifdef SDIO_MULTI_PORT_TX_AGGR
+	device.mpa_tx_cfg = init_para(opt_mpa_tx);
+#endif
+#ifdef SDIO_MULTI_PORT_RX_AGGR
+	device.mpa_rx_cfg = init_para(opt_mpa_rx);
+	device.mpa_rx_slice_cfg = init_para(opt_rx_slice);
+#endif
+	device.multi_cmd_cfg = init_para(opt_host_multi_cmd);
+	device.auto_ds = MLAN_INIT_PARA_DISABLED;
+	device.ps_mode = MLAN_INIT_PARA_DISABLED;
+#if defined(STA_SUPPORT)
+	device.cfg_11d = MLAN_INIT_PARA_DISABLED;
+#endif
+	device.rx_work = opt_rx_work;
+
+	if (sim_start_threads(handle, opt_rx_work))
+		return sim_fail("cannot start threads");
+	started = MTRUE;
+
+	if (MLAN_STATUS_SUCCESS !=
+	    mlan_register(&device, &handle->pmlan_adapter))
+		return sim_fail("mlan_register failed");
+
+	memset(&fw, 0, sizeof(fw));
+	fw.pfw_buf = malloc(fw_size);
+	if (!fw.pfw_buf)
+		return sim_fail("out of memory");
+	for (i = 0; i < fw_size; i++)
+		fw.pfw_buf[i] = (t_u8) (i * 7);
+	fw.fw_len = fw_size;
+	status = mlan_dnld_fw(handle->pmlan_adapter, &fw);
+	free(fw.pfw_buf);
+	if (status != MLAN_STATUS_SUCCESS)
+		return sim_fail("mlan_dnld_fw failed");
+
+	status = mlan_init_fw(handle->pmlan_adapter);
+	if (status == MLAN_STATUS_PENDING) {
+		if (sim_wait_flag(&handle->init_done))
+			return sim_fail("firmware init timeout");
+		status = handle->init_status;
+	}
+	if (expect_fail && status == MLAN_STATUS_SUCCESS)
+		ret = sim_fail("firmware init did not fail");
+	else if (!expect_fail && status != MLAN_STATUS_SUCCESS)
+		ret = sim_fail("firmware init failed");
+	return ret;
+}
+
+/**
+ *  @brief Process uap_start command
+ *
+ *  @param argc     Number of arguments
+ *  @param argv     A pointer to arguments array
+ *  @return         0 or -1
+ */
+static int
+process_uap_start(int argc, char *argv[])
+{
+	t_u8 ht = (argc > 1 && !strcmp(argv[1], "ht"));
+
+	if (sim_card_bss_start(card, ht))
+		return sim_fail("uap_start failed");
+	return 0;
+}
+
+/**
+ *  @brief Process sta_assoc command
+ *
+ *  @param argc     Number of arguments
+ *  @param argv     A pointer to arguments array
+ *  @return         0 or -1
+ */
+static int
+process_sta_assoc(int argc, char *argv[])
+{
+	t_u8 ht = (argc > 2 && !strcmp(argv[2], "ht"));
+
+	if (argc < 2)
+		return sim_fail("usage: sta_assoc <count> [ht]");
+	if (sim_card_add_sta(card, strtoul(argv[1], NULL, 0), ht))
+		return sim_fail("sta_assoc failed");
+	return 0;
+}
+
+/**
+ *  @brief Process addba command
+ *
+ *  @param argc     Number of arguments
+ *  @param argv     A pointer to arguments array
+ *  @return         0 or -1
+ */
+static int
+process_addba(int argc, char *argv[])
+{
+	t_u16 win_size = MLAN_UAP_AMPDU_DEF_RXWINSIZE;
+
+	if (argc < 3)
+		return sim_fail("usage: addba <sta> <tid> [win_size]");
+	if (argc > 3)
+		win_size = strtoul(argv[3], NULL, 0);
+	if (sim_card_addba(card, strtoul(argv[1], NULL, 0),
+			   strtoul(argv[2], NULL, 0), win_size))
+		return sim_fail("addba failed");
+	return 0;
+}
+
+/**
+ *  @brief Process tx command: hand tagged packets for a station to the
+ *  uAP BSS
+ *
+ *  @param argc     Number of arguments
+ *  @param argv     A pointer to arguments array
+ *  @return         0 or -1
+ */
+static int
+process_tx(int argc, char *argv[])
+{
+	pmlan_buffer pmbuf;
+	sim_payload_tag tag;
+	t_u32 sta, tid, count, len, i;
+	t_u8 *frame;
+
+	if (argc != 5)
+		return sim_fail("usage: tx <sta> <tid> <count> <len>");
+	sta = strtoul(argv[1], NULL, 0);
+	tid = strtoul(argv[2], NULL, 0);
+	count = strtoul(argv[3], NULL, 0);
+	len = strtoul(argv[4], NULL, 0);
+	if (sta >= card->sta_num || tid >= SIM_MAX_TID ||
+	    len < MLAN_MAC_ADDR_LENGTH * 2 + 2 + SIM_PAYLOAD_MIN_LEN ||
+	    len > MLAN_RX_DATA_BUF_SIZE)
+		return sim_fail("invalid tx parameters");
+
+	for (i = 0; i < count; i++) {
+		pmbuf = sim_alloc_tx_buffer(handle, len);
+		if (!pmbuf)
+			return sim_fail("out of memory");
+		frame = pmbuf->pbuf + pmbuf->data_offset;
+		memcpy(frame, card->sta_addr[sta], MLAN_MAC_ADDR_LENGTH);
+		memcpy(frame + MLAN_MAC_ADDR_LENGTH, card->mac_addr,
+		       MLAN_MAC_ADDR_LENGTH);
+		frame[MLAN_MAC_ADDR_LENGTH * 2] = 0x08;
+		frame[MLAN_MAC_ADDR_LENGTH * 2 + 1] = 0x00;
+		tag.magic = SIM_PAYLOAD_MAGIC;
+		tag.flow = (sta << 8) | tid;
+		tag.seq = tx_seq[sta][tid]++;
+		memcpy(frame + MLAN_MAC_ADDR_LENGTH * 2 + 2, &tag, sizeof(tag));
+		pmbuf->bss_index = UAP_BSS_INDEX;
+		pmbuf->priority = tid;
+
+		pthread_mutex_lock(&handle->stats_lock);
+		handle->tx_submitted++;
+		pthread_mutex_unlock(&handle->stats_lock);
+		mlan_send_packet(handle->pmlan_adapter, pmbuf);
+		if (!tx_held)
+			sim_queue_main_work(handle);
+	}
+	return 0;
+}
+
+/**
+ *  @brief Process tx_hold command: while held, tx only queues the
+ *  packets in MLAN, so all flows are backlogged when it is released
+ *
+ *  @param argc     Number of arguments
+ *  @param argv     A pointer to arguments array
+ *  @return         0 or -1
+ */
+static int
+process_tx_hold(int argc, char *argv[])
+{
+	if (argc != 2)
+		return sim_fail("usage: tx_hold <0|1>");
+	tx_held = !!strtoul(argv[1], NULL, 0);
+	if (!tx_held)
+		sim_queue_main_work(handle);
+	return 0;
+}
+
+/**
+ *  @brief Process tx_log command
+ *
+ *  @param argc     Number of arguments
+ *  @param argv     A pointer to arguments array
+ *  @return         0 or -1
+ */
+static int
+process_tx_log(int argc, char *argv[])
+{
+	if (argc != 2)
+		return sim_fail("usage: tx_log <size>");
+	if (sim_card_tx_log(card, strtoul(argv[1], NULL, 0)))
+		return sim_fail("out of memory");
+	return 0;
+}
+
+/**
+ *  @brief Process fairness command: over the first MSDUs of the Tx
+ *  log, prints the share and the longest wait of every flow found in
+ *  the log, and the Jain index of the shares. Run it on a window in
+ *  which all flows were backlogged.
+ *
+ *  @param argc     Number of arguments
+ *  @param argv     A pointer to arguments array
+ *  @return         0 or -1
+ */
+static int
+process_fairness(int argc, char *argv[])
+{
+	static t_u32 cnt[SIM_MAX_STA * SIM_MAX_TID];
+	static t_s32 last[SIM_MAX_STA * SIM_MAX_TID];
+	static t_u32 gap[SIM_MAX_STA * SIM_MAX_TID];
+	static t_u8 seen[SIM_MAX_STA * SIM_MAX_TID];
+	double sum = 0, sum_sq = 0;
+	t_u32 n, i, f, flows = 0;
+
+	if (argc != 2)
+		return sim_fail("usage: fairness <count>");
+	memset(cnt, 0, sizeof(cnt));
+	memset(gap, 0, sizeof(gap));
+	memset(seen, 0, sizeof(seen));
+	for (f = 0; f < NELEMENTS(last); f++)
+		last[f] = -1;
+
+	pthread_mutex_lock(&card->lock);
+	n = strtoul(argv[1], NULL, 0);
+	if (n > card->tx_log_len)
+		n = card->tx_log_len;
+	for (i = 0; i < card->tx_log_len; i++) {
+		f = (card->tx_log[i] >> 8) * SIM_MAX_TID +
+			(card->tx_log[i] & 0xff);
+		seen[f] = MTRUE;
+		if (i >= n)
+			continue;
+		cnt[f]++;
+		if ((t_s32) i - last[f] - 1 > (t_s32) gap[f])
+			gap[f] = i - last[f] - 1;
+		last[f] = i;
+	}
+	pthread_mutex_unlock(&card->lock);
+	if (!n)
+		return sim_fail("tx log is empty");
+
+	fair_max_gap = 0;
+	for (f = 0; f < NELEMENTS(seen); f++) {
+		if (!seen[f])
+			continue;
+		if ((t_s32) n - last[f] - 1 > (t_s32) gap[f])
+			gap[f] = n - last[f] - 1;
+		printf("  flow %2u/%u %8u msdus  max wait %u\n",
+		       f / SIM_MAX_TID, f % SIM_MAX_TID, cnt[f], gap[f]);
+		if (gap[f] > fair_max_gap)
+			fair_max_gap = gap[f];
+		sum += cnt[f];
+		sum_sq += (double)cnt[f] * cnt[f];
+		flows++;
+	}
+	fair_jain = sum_sq ? (t_u32) (sum * sum * 1000 / (flows * sum_sq)) : 0;
+	printf("FAIRNESS: %u msdus, %u flows, jain %u.%03u, max wait %u\n",
+	       n, flows, fair_jain / 1000, fair_jain % 1000, fair_max_gap);
+	return 0;
+}
+
+/**
+ *  @brief Process rx command
+ *
+ *  @param argc     Number of arguments
+ *  @param argv     A pointer to arguments array
+ *  @return         0 or -1
+ */
+static int
+process_rx(int argc, char *argv[])
+{
+	t_u32 shuffle = 0;
+
+	if (argc < 5)
+		return sim_fail("usage: rx <sta> <tid> <count> <len> [shuffle]");
+	if (argc > 5)
+		shuffle = strtoul(argv[5], NULL, 0);
+	if (sim_card_rx(card, strtoul(argv[1], NULL, 0),
+			strtoul(argv[2], NULL, 0), strtoul(argv[3], NULL, 0),
+			strtoul(argv[4], NULL, 0), shuffle))
+		return sim_fail("invalid rx parameters");
+	return 0;
+}
+
+/**
+ *  @brief Process reorder_trace command: build an Rx reorder trace
+ *  for the next reorder_replay, see sim_reorder_trace()
+ *
+ *  @param argc     Number of arguments
+ *  @param argv     A pointer to arguments array
+ *  @return         0 or -1
+ */
+static int
+process_reorder_trace(int argc, char *argv[])
+{
+	t_u8 inorder;
+
+	if (argc < 4)
+		return sim_fail("usage: reorder_trace <peers> <count> "
+				"<inorder|mixed> [seed]");
+	inorder = !strcmp(argv[3], "inorder");
+	if (!inorder && strcmp(argv[3], "mixed"))
+		return sim_fail("unknown trace pattern");
+	if (sim_reorder_trace(handle, card, strtoul(argv[1], NULL, 0),
+			      strtoul(argv[2], NULL, 0), inorder,
+			      (argc > 4) ? strtoul(argv[4], NULL, 0) :
+			      card->seed))
+		return sim_fail("reorder_trace failed");
+	return 0;
+}
+
+/**
+ *  @brief Process reorder_replay command
+ *
+ *  @param argc     Number of arguments
+ *  @param argv     A pointer to arguments array
+ *  @return         0 or -1
+ */
+static int
+process_reorder_replay(int argc, char *argv[])
+{
+	if (sim_reorder_replay(handle, card))
+		return sim_fail("reorder_replay failed");
+	return 0;
+}
+
+/**
+ *  @brief Process scan_trace command: build the scan report events
+ *  for the next scan_replay, see sim_scan_trace()
+ *
+ *  @param argc     Number of arguments
+ *  @param argv     A pointer to arguments array
+ *  @return         0 or -1
+ */
+static int
+process_scan_trace(int argc, char *argv[])
+{
+	if (argc < 4)
+		return sim_fail("usage: scan_trace <bss> <count> <ie_len> "
+				"[grow] [seed]");
+	if (sim_scan_trace(handle, strtoul(argv[1], NULL, 0),
+			   strtoul(argv[2], NULL, 0), strtoul(argv[3], NULL, 0),
+			   (argc > 4) ? strtoul(argv[4], NULL, 0) : 0,
+			   (argc > 5) ? strtoul(argv[5], NULL, 0) :
+			   card->seed))
+		return sim_fail("scan_trace failed");
+	return 0;
+}
+
+/**
+ *  @brief Process scan_replay command
+ *
+ *  @param argc     Number of arguments
+ *  @param argv     A pointer to arguments array
+ *  @return         0 or -1
+ */
+static int
+process_scan_replay(int argc, char *argv[])
+{
+	if (sim_scan_replay(handle))
+		return sim_fail("scan_replay failed");
+	return 0;
+}
+
+/**
+ *  @brief Process event command
+ *
+ *  @param argc     Number of arguments
+ *  @param argv     A pointer to arguments array
+ *  @return         0 or -1
+ */
+static int
+process_event(int argc, char *argv[])
+{
+	if (argc != 2)
+		return sim_fail("usage: event <id>");
+	if (sim_card_event(card, MLAN_BSS_TYPE_UAP, 0,
+			   strtoul(argv[1], NULL, 0), NULL, 0))
+		return sim_fail("event failed");
+	return 0;
+}
+
+/**
+ *  @brief Process cmd_fail command
+ *
+ *  @param argc     Number of arguments
+ *  @param argv     A pointer to arguments array
+ *  @return         0 or -1
+ */
+static int
+process_cmd_fail(int argc, char *argv[])
+{
+	t_u32 result;
+
+	if (argc < 3)
+		return sim_fail("usage: cmd_fail <cmd> <result> [count]");
+	result = strtoul(argv[2], NULL, 0);
+	if (!result)
+		return sim_fail("result must not be 0");
+	if (sim_card_cmd_rule(card, strtoul(argv[1], NULL, 0), result,
+			      (argc > 3) ? strtoul(argv[3], NULL, 0) : 0))
+		return sim_fail("too many command rules");
+	return 0;
+}
+
+/**
+ *  @brief Process cmd_drop command
+ *
+ *  @param argc     Number of arguments
+ *  @param argv     A pointer to arguments array
+ *  @return         0 or -1
+ */
+static int
+process_cmd_drop(int argc, char *argv[])
+{
+	if (argc < 2)
+		return sim_fail("usage: cmd_drop <cmd> [count]");
+	if (sim_card_cmd_rule(card, strtoul(argv[1], NULL, 0), 0,
+			      (argc > 2) ? strtoul(argv[2], NULL, 0) : 0))
+		return sim_fail("too many command rules");
+	return 0;
+}
+
+/**
+ *  @brief Process wait command
+ *
+ *  @param argc     Number of arguments
+ *  @param argv     A pointer to arguments array
+ *  @return         0 or -1
+ */
+static int
+process_wait(int argc, char *argv[])
+{
+	if (!started)
+		return 0;
+	if (sim_wait_idle(handle))
+		return sim_fail("timeout waiting for idle");
+	return 0;
+}
+
+/**
+ *  @brief Process sleep command
+ *
+ *  @param argc     Number of arguments
+ *  @param argv     A pointer to arguments array
+ *  @return         0 or -1
+ */
+static int
+process_sleep(int argc, char *argv[])
+{
+	if (argc != 2)
+		return sim_fail("usage: sleep <msec>");
+	usleep(strtoul(argv[1], NULL, 0) * 1000);
+	return 0;
+}
+
+/**
+ *  @brief Microseconds elapsed since a start time
+ *
+ *  @param clock    Clock id
+ *  @param start    A pointer to the start time
+ *  @return         Microseconds
+ */
+static t_s64
+bench_elapsed_us(clockid_t clock, struct timespec *start)
+{
+	struct timespec now;
+
+	clock_gettime(clock, &now);
+	return (t_s64) (now.tv_sec - start->tv_sec) * 1000000 +
+		(now.tv_nsec - start->tv_nsec) / 1000;
+}
+
+/**
+ *  @brief Process bench command: "bench start" starts the clocks,
+ *  "bench stop <label> [count]" prints the wall clock and the process
+ *  CPU time (all harness threads) since the start, per item when a
+ *  count is given. Run "wait" before stop so the work is finished.
+ *
+ *  @param argc     Number of arguments
+ *  @param argv     A pointer to arguments array
+ *  @return         0 or -1
+ */
+static int
+process_bench(int argc, char *argv[])
+{
+	t_s64 wall, cpu;
+	t_u32 count = 0;
+
+	if (argc == 2 && !strcmp(argv[1], "start")) {
+		clock_gettime(CLOCK_MONOTONIC, &bench_wall);
+		clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &bench_cpu);
+		return 0;
+	}
+	if (argc < 3 || strcmp(argv[1], "stop"))
+		return sim_fail("usage: bench start | bench stop <label> [count]");
+	wall = bench_elapsed_us(CLOCK_MONOTONIC, &bench_wall);
+	cpu = bench_elapsed_us(CLOCK_PROCESS_CPUTIME_ID, &bench_cpu);
+	if (argc > 3)
+		count = strtoul(argv[3], NULL, 0);
+	printf("BENCH: %-20s wall %8lld us  cpu %8lld us", argv[2],
+	       (long long)wall, (long long)cpu);
+	if (count)
+		printf("  %6lld ns/item (cpu)", (long long)cpu * 1000 / count);
+	printf("\n");
+	return 0;
+}
+
+/**
+ *  @brief Process stats command
+ *
+ *  @param argc     Number of arguments
+ *  @param argv     A pointer to arguments array
+ *  @return         0
+ */
+static int
+process_stats(int argc, char *argv[])
+{
+	unsigned int i;
+
+	for (i = 0; i < NELEMENTS(stat_list); i++)
+		printf("  %-20s %lld\n", stat_list[i].name,
+		       (long long)stat_read(&stat_list[i]));
+	pthread_mutex_lock(&card->lock);
+	printf("  %-20s", "tx_mpa_hist");
+	for (i = 1; i <= SIM_MAX_TID; i++)
+		printf(" %u", card->stats.tx_mpa_hist[i]);
+	printf("\n  %-20s", "rx_mpa_hist");
+	for (i = 1; i <= SIM_MAX_TID; i++)
+		printf(" %u", card->stats.rx_mpa_hist[i]);
+	printf("\n");
+	pthread_mutex_unlock(&card->lock);
+	return 0;
+}
+
+/**
+ *  @brief Process expect command
+ *
+ *  @param argc     Number of arguments
+ *  @param argv     A pointer to arguments array
+ *  @return         0 or -1
+ */
+static int
+process_expect(int argc, char *argv[])
+{
+	struct stat_node *node = NULL;
+	char *op = "==";
+	t_s64 val, ref;
+	unsigned int i;
+	int ok;
+
+	if (argc != 3 && argc != 4)
+		return sim_fail("usage: expect <name> [op] <value>");
+	for (i = 0; i < NELEMENTS(stat_list); i++) {
+		if (!strcmp(stat_list[i].name, argv[1])) {
+			node = &stat_list[i];
+			break;
+		}
+	}
+	if (!node)
+		return sim_fail("unknown counter");
+	if (argc == 4)
+		op = argv[2];
+	ref = strtoll(argv[argc - 1], NULL, 0);
+	val = stat_read(node);
+
+	if (!strcmp(op, "=="))
+		ok = (val == ref);
+	else if (!strcmp(op, "!="))
+		ok = (val != ref);
+	else if (!strcmp(op, ">="))
+		ok = (val >= ref);
+	else if (!strcmp(op, "<="))
+		ok = (val <= ref);
+	else if (!strcmp(op, ">"))
+		ok = (val > ref);
+	else if (!strcmp(op, "<"))
+		ok = (val < ref);
+	else
+		return sim_fail("unknown operator");
+
+	printf("%s: %s = %lld, expected %s %lld\n", ok ? "PASS" : "FAIL",
+	       node->name, (long long)val, op, (long long)ref);
+	if (!ok)
+		fail_count++;
+	return ok ? 0 : -1;
+}
+
+/**
+ *  @brief Process shutdown command: shut the firmware down, stop the
+ *  threads and unregister MLAN
+ *
+ *  @param argc     Number of arguments
+ *  @param argv     A pointer to arguments array
+ *  @return         0 or -1
+ */
+static int
+process_shutdown(int argc, char *argv[])
+{
+	mlan_status status;
+	int ret = 0;
+
+	if (!started)
+		return 0;
+	if (handle->pmlan_adapter) {
+		status = mlan_shutdown_fw(handle->pmlan_adapter);
+		if (status == MLAN_STATUS_PENDING) {
+			sim_queue_main_work(handle);
+			if (sim_wait_flag(&handle->shutdown_done))
+				ret = sim_fail("firmware shutdown timeout");
+		}
+	}
+	sim_reorder_free(handle);
+	sim_scan_free(handle);
+	sim_stop_threads(handle);
+	started = MFALSE;
+	if (handle->pmlan_adapter) {
+		mlan_unregister(handle->pmlan_adapter);
+		handle->pmlan_adapter = NULL;
+	}
+	return ret;
+}
+
+/** Script commands */
+static struct command_node command_list[] = {
+	{"option", process_option},
+	{"fw_crc_error", process_fw_crc_error},
+	{"init", process_init},
+	{"uap_start", process_uap_start},
+	{"sta_assoc", process_sta_assoc},
+	{"addba", process_addba},
+	{"tx", process_tx},
+	{"tx_hold", process_tx_hold},
+	{"tx_log", process_tx_log},
+	{"fairness", process_fairness},
+	{"rx", process_rx},
+	{"event", process_event},
+	{"reorder_trace", process_reorder_trace},
+	{"reorder_replay", process_reorder_replay},
+	{"scan_trace", process_scan_trace},
+	{"scan_replay", process_scan_replay},
+	{"cmd_fail", process_cmd_fail},
+	{"cmd_drop", process_cmd_drop},
+	{"wait", process_wait},
+	{"sleep", process_sleep},
+	{"bench", process_bench},
+	{"stats", process_stats},
+	{"expect", process_expect},
+	{"shutdown", process_shutdown},
+};
+
+/**
+ *  @brief Display usage
+ *
+ *  @return         N/A
+ */
+static void
+display_usage(void)
+{
+	fprintf(stderr, "Usage: mlansim [-d <drvdbg>] <script>\n");
+	fprintf(stderr, "       mlansim -v\n");
+}
+
+/**
+ *  @brief Splits a script line and runs it
+ *
+ *  @param line     Script line
+ *  @return         0 or -1
+ */
+static int
+process_line(char *line)
+{
+	char *argv[MAX_ARGS];
+	char *pos;
+	int argc = 0;
+	unsigned int i;
+
+	pos = strchr(line, '#');
+	if (pos)
+		*pos = '\0';
+	for (pos = strtok(line, " \t\r\n"); pos && argc < MAX_ARGS;
+	     pos = strtok(NULL, " \t\r\n"))
+		argv[argc++] = pos;
+	if (!argc)
+		return 0;
+
+	for (i = 0; i < NELEMENTS(command_list); i++) {
+		if (!strcmp(command_list[i].name, argv[0]))
+			return command_list[i].handler(argc, argv);
+	}
+	return sim_fail("unknown command");
+}
+
+/********************************************************
+			Global Functions
+********************************************************/
+
+/**
+ *  @brief Entry function for mlansim
+ *
+ *  @param argc     Number of arguments
+ *  @param argv     A pointer to arguments array
+ *  @return         Number of failures
+ */
+int
+main(int argc, char *argv[])
+{
+	char line[MAX_LINE];
+	t_u32 drvdbg = MMSG | MERROR;
+	FILE *fp;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "d:v")) != -1) {
+		switch (opt) {
+		case 'd':
+			drvdbg = strtoul(optarg, NULL, 0);
+			break;
+		case 'v':
+			fprintf(stdout, "Marvell mlansim version %s\n",
+				MLANSIM_VER);
+			exit(0);
+		default:
+			display_usage();
+			exit(1);
+		}
+	}
+	if (optind != argc - 1) {
+		display_usage();
+		exit(1);
+	}
+	fp = fopen(argv[optind], "r");
+	if (!fp) {
+		fprintf(stderr, "mlansim: Cannot open %s\n", argv[optind]);
+		exit(1);
+	}
+
+	handle = calloc(1, sizeof(sim_handle));
+	card = sim_card_create();
+	if (!handle || !card) {
+		fprintf(stderr, "mlansim: Out of memory\n");
+		exit(1);
+	}
+	handle->card = card;
+	handle->drvdbg = drvdbg;
+	handle->timer_scale = 1;
+	card->raise_irq = sim_irq;
+	card->irq_ctx = handle;
+
+	while (fgets(line, sizeof(line), fp)) {
+		line_no++;
+		process_line(line);
+	}
+	fclose(fp);
+
+	/* Scripts normally end with shutdown */
+	process_shutdown(0, NULL);
+	sim_card_free(card);
+	free(handle);
+
+	printf("mlansim: %d failure(s)\n", fail_count);
+	return fail_count;
+}
@@ -0,0 +1,390 @@
+/** @file  mlansim.h
+  *
+  * @brief This file contains definitions for the userspace MLAN harness
+  *
+  * Copyright (C) 2011-2012, Marvell International Ltd.
+  *
+  * This software file (the "File") is distributed by Marvell International
+  * Ltd. under the terms of the GNU General Public License Version 2, June 1991
+  * (the "License").  You may use, redistribute and/or modify this File in
+  * accordance with the terms and conditions of the License, a copy of which
+  * is available by writing to the Free Software Foundation, Inc.,
+  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA or on the
+  * worldwide web at http://www.gnu.org/licenses/old-licenses/gpl-2.0.txt.
+  *
+  * THE FILE IS DISTRIBUTED AS-IS, WITHOUT WARRANTY OF ANY KIND, AND THE
+  * IMPLIED WARRANTIES OF MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE
+  * ARE EXPRESSLY DISCLAIMED.  The License provides additional details about
+  * this warranty disclaimer.
+  *
+  */
+/************************************************************************
+Change log:
+     10/17/2012: initial version
+************************************************************************/
+
+#ifndef _MLANSIM_H_
+#define _MLANSIM_H_
+
+#include    <stdio.h>
+#include    <stdlib.h>
+#include    <string.h>
+#include    <pthread.h>
+
+#include    "mlan.h"
+
+/** Number of stations the firmware simulator can associate */
+#define SIM_MAX_STA             64
+/** Number of TIDs */
+#define SIM_MAX_TID             8
+/** Number of commands that can be failed or dropped */
+#define SIM_MAX_CMD_RULE        8
+
+/** Magic word at the start of every harness generated payload */
+#define SIM_PAYLOAD_MAGIC       0x4d4c5349
+/** Minimum payload length carrying the harness tag */
+#define SIM_PAYLOAD_MIN_LEN     12
+
+/** Payload tag written after the Ethernet header */
+typedef struct _sim_payload_tag {
+    /** SIM_PAYLOAD_MAGIC */
+	t_u32 magic;
+    /** Flow: station index << 8 | tid */
+	t_u32 flow;
+    /** Per flow sequence number */
+	t_u32 seq;
+} sim_payload_tag;
+
+/** Per flow ordering state */
+typedef struct _sim_flow {
+    /** Next expected sequence number */
+	t_u32 next_seq;
+    /** Packets seen */
+	t_u32 pkts;
+    /** Packets seen out of order */
+	t_u32 out_of_order;
+} sim_flow;
+
+/** Command response rule */
+typedef struct _sim_cmd_rule {
+    /** Command code */
+	t_u16 cmd;
+    /** Result code to return, 0 to drop the command */
+	t_u16 result;
+    /** Remaining hits, 0 for always */
+	t_u32 count;
+} sim_cmd_rule;
+
+/** Firmware simulator counters */
+typedef struct _sim_card_stats {
+    /** Firmware download blocks */
+	t_u32 fw_blocks;
+    /** Firmware download bytes */
+	t_u32 fw_bytes;
+    /** Firmware download CRC retries */
+	t_u32 fw_crc_retry;
+    /** Commands received */
+	t_u32 cmds;
+    /** Commands dropped */
+	t_u32 cmds_dropped;
+    /** Commands failed */
+	t_u32 cmds_failed;
+    /** Multi-command transfers received */
+	t_u32 cmd_batches;
+    /** Commands received in multi-command transfers */
+	t_u32 cmds_batched;
+    /** Multi-command transfers rejected */
+	t_u32 cmd_batch_rejected;
+    /** Commands received out of sequence */
+	t_u32 cmd_seq_err;
+    /** Events uploaded */
+	t_u32 events;
+    /** Data write transactions */
+	t_u32 tx_writes;
+    /** Data write transactions carrying an MP-A aggregate */
+	t_u32 tx_mpa_writes;
+    /** MP-A Tx aggregate histogram, by number of packets */
+	t_u32 tx_mpa_hist[SIM_MAX_TID + 1];
+    /** Data packets received from host */
+	t_u32 tx_pkts;
+    /** AMSDU packets received from host */
+	t_u32 tx_amsdu;
+    /** MSDUs received from host */
+	t_u32 tx_msdus;
+    /** Payload bytes received from host */
+	t_u32 tx_bytes;
+    /** MSDUs received out of order */
+	t_u32 tx_out_of_order;
+    /** Malformed packets */
+	t_u32 tx_bad;
+    /** Data read transactions */
+	t_u32 rx_reads;
+    /** Data read transactions carrying an MP-A aggregate */
+	t_u32 rx_mpa_reads;
+    /** MP-A Rx aggregate histogram, by number of packets */
+	t_u32 rx_mpa_hist[SIM_MAX_TID + 1];
+    /** Data packets uploaded to host */
+	t_u32 rx_pkts;
+    /** Register block reads, i.e. interrupts serviced */
+	t_u32 int_reads;
+    /** Protocol errors detected by the simulator */
+	t_u32 errors;
+} sim_card_stats;
+
+/** Upload queued in the firmware simulator */
+typedef struct _sim_upld {
+    /** Next upload */
+	struct _sim_upld *pnext;
+    /** Upload length including SDIO header */
+	t_u32 len;
+    /** Upload data */
+	t_u8 buf[0];
+} sim_upld;
+
+/** Upload queue */
+typedef struct _sim_upld_q {
+    /** Head */
+	sim_upld *phead;
+    /** Tail */
+	sim_upld *ptail;
+    /** Length */
+	t_u32 count;
+} sim_upld_q;
+
+/** Firmware state */
+typedef enum _sim_fw_state {
+	SIM_FW_BOOT = 0,
+	SIM_FW_DNLD,
+	SIM_FW_READY,
+} sim_fw_state;
+
+/** Simulated SDIO card and firmware */
+typedef struct _sim_card {
+    /** Lock protecting the card state */
+	pthread_mutex_t lock;
+    /** Function 1 register file */
+	t_u8 regs[256];
+    /** I/O port base */
+	t_u32 ioport;
+    /** Firmware state */
+	sim_fw_state fw_state;
+    /** Firmware block size requested from the helper */
+	t_u32 fw_chunk;
+    /** CRC errors still to be reported during download */
+	t_u32 fw_crc_err;
+    /** Next firmware block is a resend after a CRC error */
+	t_u8 fw_resend;
+    /** Valid end port reported in GET_HW_SPEC */
+	t_u16 mp_end_port;
+    /** Host interrupt status */
+	t_u8 int_status;
+    /** Ports the host may write */
+	t_u16 wr_bitmap;
+    /** Ports holding an upload */
+	t_u16 rd_bitmap;
+    /** Next data port to fill */
+	t_u8 curr_rd_port;
+    /** Upload held by each port */
+	sim_upld *port_upld[16];
+    /** Command responses and events */
+	sim_upld_q ctrl_q;
+    /** Data uploads */
+	sim_upld_q data_q;
+    /** MAC address */
+	t_u8 mac_addr[MLAN_MAC_ADDR_LENGTH];
+    /** Associated station MAC addresses */
+	t_u8 sta_addr[SIM_MAX_STA][MLAN_MAC_ADDR_LENGTH];
+    /** Number of stations */
+	t_u32 sta_num;
+    /** Tx ordering per station and TID */
+	sim_flow tx_flow[SIM_MAX_STA][SIM_MAX_TID];
+    /** Next Rx sequence number per station and TID, the 802.11
+	sequence number is its low 12 bits */
+	t_u32 rx_next[SIM_MAX_STA][SIM_MAX_TID];
+    /** Random seed for Rx shuffling */
+	t_u32 seed;
+    /** Command rules */
+	sim_cmd_rule cmd_rule[SIM_MAX_CMD_RULE];
+    /** Advertise multi-command support */
+	t_u8 multi_cmd;
+    /** Reject multi-command transfers although advertised */
+	t_u8 multi_cmd_reject;
+    /** Sequence number of the last command */
+	t_u16 cmd_seq;
+    /** cmd_seq is valid */
+	t_u8 cmd_seq_valid;
+    /** Counters */
+	sim_card_stats stats;
+    /** Flow of every MSDU written, while logging */
+	t_u32 *tx_log;
+    /** Entries in tx_log */
+	t_u32 tx_log_len;
+    /** Size of tx_log, 0 when not logging */
+	t_u32 tx_log_size;
+    /** Interrupt callback */
+	void (*raise_irq) (void *ctx);
+    /** Interrupt callback context */
+	void *irq_ctx;
+} sim_card;
+
+/** MOAL handle of the harness */
+typedef struct _sim_handle {
+    /** MLAN adapter */
+	t_void *pmlan_adapter;
+    /** Card */
+	sim_card *card;
+    /** Work lock */
+	pthread_mutex_t work_lock;
+    /** Signals the work threads */
+	pthread_cond_t work_cond;
+    /** Signals threads waiting for idle */
+	pthread_cond_t idle_cond;
+    /** Main work thread */
+	pthread_t main_thread;
+    /** Rx work thread */
+	pthread_t rx_thread;
+    /** Main work queued */
+	t_u8 main_work;
+    /** Interrupt pending */
+	t_u8 irq_pending;
+    /** Main work running */
+	t_u8 main_busy;
+    /** Rx work queued */
+	t_u8 rx_work;
+    /** Rx work running */
+	t_u8 rx_busy;
+    /** Stop work threads */
+	t_u8 stop;
+    /** Firmware init done */
+	t_u8 init_done;
+    /** Firmware init status */
+	mlan_status init_status;
+    /** Shutdown done */
+	t_u8 shutdown_done;
+    /** Stats lock */
+	pthread_mutex_t stats_lock;
+    /** Tx packets handed to MLAN */
+	t_u32 tx_submitted;
+    /** Tx packets completed successfully */
+	t_u32 tx_done;
+    /** Tx packets completed with failure */
+	t_u32 tx_failed;
+    /** Rx packets delivered */
+	t_u32 rx_pkts;
+    /** Rx bytes delivered */
+	t_u32 rx_bytes;
+    /** Rx packets without a valid harness tag */
+	t_u32 rx_bad;
+    /** Rx ordering per station and TID */
+	sim_flow rx_flow[SIM_MAX_STA][SIM_MAX_TID];
+    /** Events delivered */
+	t_u32 events;
+    /** Ioctls completed */
+	t_u32 ioctls;
+    /** mlan_buffers outstanding */
+	t_s32 mbuf_count;
+    /** Allocations outstanding */
+	t_s32 malloc_count;
+    /** mlan_buffer allocations of at least this size fail, 0 for none */
+	t_u32 alloc_fail_size;
+    /** mlan_buffer allocations failed on purpose */
+	t_u32 alloc_failed;
+    /** Tag sequence numbers of delivered packets are logged here */
+	t_u32 *rx_log;
+    /** Entries in rx_log */
+	t_u32 rx_log_len;
+    /** Size of rx_log */
+	t_u32 rx_log_size;
+    /** Rx reorder trace events replayed */
+	t_u32 reorder_events;
+    /** Rx reorder packets dropped */
+	t_u32 reorder_dropped;
+    /** Rx reorder replay differences to the reference model */
+	t_u32 reorder_mismatch;
+    /** Scan results replayed */
+	t_u32 scan_results;
+    /** Scan table differences after a replayed round */
+	t_u32 scan_mismatch;
+    /** Assertion failures */
+	t_u32 asserts;
+    /** Print level mask */
+	t_u32 drvdbg;
+    /** Timer durations are divided by this */
+	t_u32 timer_scale;
+} sim_handle;
+
+/** Callback table of the harness */
+extern mlan_callbacks sim_callbacks;
+
+/** Start the harness work threads */
+int sim_start_threads(sim_handle * handle, t_u8 rx_work);
+/** Stop the harness work threads */
+void sim_stop_threads(sim_handle * handle);
+/** Queue the main work */
+void sim_queue_main_work(sim_handle * handle);
+/** Card interrupt */
+void sim_irq(void *ctx);
+/** Wait until MLAN and the card are quiescent */
+int sim_wait_idle(sim_handle * handle);
+/** Allocate a Tx packet */
+pmlan_buffer sim_alloc_tx_buffer(sim_handle * handle, t_u32 len);
+/** Hold the timers, or let them expire again */
+void sim_hold_timers(t_u8 hold);
+/** Expire an armed timer now */
+int sim_fire_timer(t_void * ptimer);
+
+/** Build an Rx reorder trace and its expected dispatch order */
+int sim_reorder_trace(sim_handle * handle, sim_card * card, t_u32 peers,
+		      t_u32 count, t_u8 inorder, t_u32 seed);
+/** Replay the Rx reorder trace */
+int sim_reorder_replay(sim_handle * handle, sim_card * card);
+/** Free the Rx reorder state */
+void sim_reorder_free(sim_handle * handle);
+
+/** Build the scan report events of the next scan replay */
+int sim_scan_trace(sim_handle * handle, t_u32 bss, t_u32 count,
+		   t_u32 ie_len, t_u32 grow, t_u32 seed);
+/** Replay the scan report events */
+int sim_scan_replay(sim_handle * handle);
+/** Free the scan report events */
+void sim_scan_free(sim_handle * handle);
+
+/** Create the card */
+sim_card *sim_card_create(void);
+/** Free the card */
+void sim_card_free(sim_card * card);
+/** Register read */
+mlan_status sim_card_read_reg(sim_card * card, t_u32 reg, t_u32 * data);
+/** Register write */
+mlan_status sim_card_write_reg(sim_card * card, t_u32 reg, t_u32 data);
+/** CMD53 write */
+mlan_status sim_card_write_data(sim_card * card, pmlan_buffer pmbuf,
+				t_u32 port);
+/** CMD53 read */
+mlan_status sim_card_read_data(sim_card * card, pmlan_buffer pmbuf,
+			       t_u32 port);
+/** Queue a firmware event */
+int sim_card_event(sim_card * card, t_u8 bss_type, t_u8 bss_num,
+		   t_u16 event_id, t_u8 * body, t_u32 body_len);
+/** Queue Rx data packets */
+int sim_card_rx(sim_card * card, t_u32 sta, t_u8 tid, t_u32 count,
+		t_u32 len, t_u32 shuffle);
+/** Add associated stations */
+int sim_card_add_sta(sim_card * card, t_u32 count, t_u8 ht);
+/** Start the uAP BSS */
+int sim_card_bss_start(sim_card * card, t_u8 ht);
+/** Peer initiated block ack */
+int sim_card_addba(sim_card * card, t_u32 sta, t_u8 tid, t_u16 win_size);
+/** Start or stop the Tx MSDU log */
+int sim_card_tx_log(sim_card * card, t_u32 size);
+/** Add a command rule */
+int sim_card_cmd_rule(sim_card * card, t_u16 cmd, t_u16 result, t_u32 count);
+/** Whether the card has uploads the host has not read */
+int sim_card_busy(sim_card * card);
+
+/** Read a tag from a payload */
+int sim_get_tag(t_u8 * payload, t_u32 len, sim_payload_tag * tag);
+/** Check a tag against the flow state */
+void sim_flow_check(sim_flow * flow, t_u32 seq);
+
+#endif /* _MLANSIM_H_ */
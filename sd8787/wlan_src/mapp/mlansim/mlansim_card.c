@@ -0,0 +1,1252 @@
+/** @file  mlansim_card.c
+  *
+  * @brief This file contains the simulated SDIO card and firmware of the
+  * userspace MLAN harness. It answers register and CMD53 accesses the
+  * way the SD8787 function 1 does, downloads the firmware image, echoes
+  * host commands, uploads events and data, and checks the ordering of
+  * the data written by the host.
+  *
+  * Copyright (C) 2011-2012, Marvell International Ltd.
+  *
+  * This software file (the "File") is distributed by Marvell International
+  * Ltd. under the terms of the GNU General Public License Version 2, June 1991
+  * (the "License").  You may use, redistribute and/or modify this File in
+  * accordance with the terms and conditions of the License, a copy of which
+  * is available by writing to the Free Software Foundation, Inc.,
+  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA or on the
+  * worldwide web at http://www.gnu.org/licenses/old-licenses/gpl-2.0.txt.
+  *
+  * THE FILE IS DISTRIBUTED AS-IS, WITHOUT WARRANTY OF ANY KIND, AND THE
+  * IMPLIED WARRANTIES OF MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE
+  * ARE EXPRESSLY DISCLAIMED.  The License provides additional details about
+  * this warranty disclaimer.
+  *
+  */
+/************************************************************************
+Change log:
+     10/17/2012: initial version
+************************************************************************/
+
+#include    "mlansim.h"
+
+#include    "mlan_join.h"
+#include    "mlan_util.h"
+#include    "mlan_fw.h"
+#include    "mlan_main.h"
+#include    "mlan_11n_rxreorder.h"
+#include    "mlan_sdio.h"
+
+/* mlan_main.h wraps these around the MOAL callbacks */
+#undef memset
+#undef memcpy
+#undef memmove
+#undef memcmp
+
+/********************************************************
+		Local Variables
+********************************************************/
+
+/** I/O port base reported in IO_PORT_0..2 */
+#define SIM_IOPORT		0x10000
+/** Firmware block size requested from the helper */
+#define SIM_FW_CHUNK		2048
+/** Region code reported in GET_HW_SPEC, FCC */
+#define SIM_REGION_CODE		0x10
+/** Firmware capability reported in GET_HW_SPEC, B/G/GN */
+#define SIM_FW_CAP_INFO		0x00000b00
+/** 11n capability reported in GET_HW_SPEC */
+#define SIM_DOT_11N_DEV_CAP	0x0c000000
+/** MCS support reported in GET_HW_SPEC, 1x1 */
+#define SIM_DEV_MCS_SUPPORT	0x11
+
+/** Round up to a whole number of SDIO blocks */
+#define SIM_BLK_ALIGN(len)	\
+	(((len) + MLAN_SDIO_BLOCK_SIZE - 1) & ~(MLAN_SDIO_BLOCK_SIZE - 1))
+
+/** MAC address of the card */
+static const t_u8 sim_mac_addr[MLAN_MAC_ADDR_LENGTH] =
+	{ 0x00, 0x50, 0x43, 0x21, 0x00, 0x01 };
+
+/********************************************************
+		Local Functions
+********************************************************/
+
+/**
+ *  @brief This function allocates an upload
+ *
+ *  @param type		SDIO upload type
+ *  @param len		Length after the SDIO header
+ *
+ *  @return		A pointer to sim_upld or NULL
+ */
+static sim_upld *
+sim_upld_alloc(t_u16 type, t_u32 len)
+{
+	sim_upld *u;
+
+	u = calloc(1, sizeof(sim_upld) + INTF_HEADER_LEN + len);
+	if (!u)
+		return NULL;
+	u->len = INTF_HEADER_LEN + len;
+	*(t_u16 *) & u->buf[0] = wlan_cpu_to_le16((t_u16) u->len);
+	*(t_u16 *) & u->buf[2] = wlan_cpu_to_le16(type);
+	return u;
+}
+
+/**
+ *  @brief This function appends an upload to a queue
+ *
+ *  @param q		A pointer to sim_upld_q
+ *  @param u		A pointer to sim_upld
+ *
+ *  @return		N/A
+ */
+static void
+sim_upld_enqueue(sim_upld_q * q, sim_upld * u)
+{
+	u->pnext = NULL;
+	if (q->ptail)
+		q->ptail->pnext = u;
+	else
+		q->phead = u;
+	q->ptail = u;
+	q->count++;
+}
+
+/**
+ *  @brief This function removes the first upload of a queue
+ *
+ *  @param q		A pointer to sim_upld_q
+ *
+ *  @return		A pointer to sim_upld or NULL
+ */
+static sim_upld *
+sim_upld_dequeue(sim_upld_q * q)
+{
+	sim_upld *u = q->phead;
+
+	if (!u)
+		return NULL;
+	q->phead = u->pnext;
+	if (!q->phead)
+		q->ptail = NULL;
+	q->count--;
+	return u;
+}
+
+/**
+ *  @brief This function frees every upload of a queue
+ *
+ *  @param q		A pointer to sim_upld_q
+ *
+ *  @return		N/A
+ */
+static void
+sim_upld_purge(sim_upld_q * q)
+{
+	sim_upld *u;
+
+	while ((u = sim_upld_dequeue(q)))
+		free(u);
+}
+
+/**
+ *  @brief This function moves queued uploads to free read ports. The
+ *  control port takes command responses and events, data ports are
+ *  filled in sequence the way the host walks them.
+ *
+ *  @param card		A pointer to sim_card
+ *
+ *  @return		N/A
+ */
+static void
+sim_card_fill_ports(sim_card * card)
+{
+	t_u8 port;
+
+	if (card->fw_state != SIM_FW_READY)
+		return;
+	if (!card->port_upld[CTRL_PORT] && card->ctrl_q.phead) {
+		card->port_upld[CTRL_PORT] = sim_upld_dequeue(&card->ctrl_q);
+		card->rd_bitmap |= CTRL_PORT_MASK;
+		card->int_status |= UP_LD_HOST_INT_STATUS;
+	}
+	while (card->data_q.phead) {
+		port = card->curr_rd_port;
+		if (card->port_upld[port])
+			break;
+		card->port_upld[port] = sim_upld_dequeue(&card->data_q);
+		card->rd_bitmap |= (1 << port);
+		card->int_status |= UP_LD_HOST_INT_STATUS;
+		if (++card->curr_rd_port == MAX_PORT)
+			card->curr_rd_port = 1;
+	}
+}
+
+/**
+ *  @brief This function releases the card lock and raises the host
+ *  interrupt if an unmasked interrupt is pending
+ *
+ *  @param card		A pointer to sim_card
+ *
+ *  @return		N/A
+ */
+static void
+sim_card_unlock(sim_card * card)
+{
+	t_u8 pending;
+
+	sim_card_fill_ports(card);
+	pending = card->int_status & card->regs[HOST_INT_MASK_REG];
+	pthread_mutex_unlock(&card->lock);
+	if (pending && card->raise_irq)
+		card->raise_irq(card->irq_ctx);
+}
+
+/**
+ *  @brief This function builds the register block read on interrupt
+ *
+ *  @param card		A pointer to sim_card
+ *  @param pbuf		Buffer to fill
+ *  @param len		Buffer length
+ *
+ *  @return		N/A
+ */
+static void
+sim_card_read_regs(sim_card * card, t_u8 * pbuf, t_u32 len)
+{
+	t_u8 regs[MAX_MP_REGS];
+	t_u32 port, upld_len;
+
+	memset(regs, 0, sizeof(regs));
+	regs[HOST_INT_STATUS_REG] = card->int_status;
+	regs[RD_BITMAP_L] = (t_u8) card->rd_bitmap;
+	regs[RD_BITMAP_U] = (t_u8) (card->rd_bitmap >> 8);
+	regs[WR_BITMAP_L] = (t_u8) card->wr_bitmap;
+	regs[WR_BITMAP_U] = (t_u8) (card->wr_bitmap >> 8);
+	for (port = 0; port < MAX_PORT; port++) {
+		upld_len = card->port_upld[port] ? card->port_upld[port]->len : 0;
+		regs[RD_LEN_P0_L + (port << 1)] = (t_u8) upld_len;
+		regs[RD_LEN_P0_U + (port << 1)] = (t_u8) (upld_len >> 8);
+	}
+	regs[CARD_TO_HOST_EVENT_REG] = CARD_IO_READY | DN_LD_CARD_RDY;
+	memcpy(pbuf, regs, MIN(len, sizeof(regs)));
+
+	/* Host interrupt status is read to clear */
+	card->int_status = 0;
+	card->stats.int_reads++;
+}
+
+/**
+ *  @brief This function reads a single port upload
+ *
+ *  @param card		A pointer to sim_card
+ *  @param port		Port
+ *  @param pbuf		Buffer to fill
+ *  @param len		Buffer length
+ *
+ *  @return		Bytes filled or -1
+ */
+static int
+sim_card_read_port(sim_card * card, t_u8 port, t_u8 * pbuf, t_u32 len)
+{
+	sim_upld *u = card->port_upld[port];
+	t_u32 blk_len;
+
+	if (!u) {
+		printf("mlansim: card: read of empty port %d\n", port);
+		return -1;
+	}
+	blk_len = SIM_BLK_ALIGN(u->len);
+	if (blk_len > len) {
+		printf("mlansim: card: port %d read of %d bytes, upload %d\n",
+		       port, len, u->len);
+		return -1;
+	}
+	memcpy(pbuf, u->buf, u->len);
+	memset(pbuf + u->len, 0, blk_len - u->len);
+	card->port_upld[port] = NULL;
+	card->rd_bitmap &= ~(1 << port);
+	if (port != CTRL_PORT)
+		card->stats.rx_pkts++;
+	free(u);
+	return blk_len;
+}
+
+/**
+ *  @brief This function checks an MSDU written by the host
+ *
+ *  @param card		A pointer to sim_card
+ *  @param payload	Payload after the Ethernet or LLC/SNAP header
+ *  @param len		Payload length
+ *
+ *  @return		N/A
+ */
+static void
+sim_card_tx_msdu(sim_card * card, t_u8 * payload, t_u32 len)
+{
+	sim_payload_tag tag;
+	t_u32 sta, tid, ooo;
+
+	card->stats.tx_msdus++;
+	card->stats.tx_bytes += len;
+	if (sim_get_tag(payload, len, &tag)) {
+		card->stats.tx_bad++;
+		return;
+	}
+	sta = tag.flow >> 8;
+	tid = tag.flow & 0xff;
+	if (sta >= SIM_MAX_STA || tid >= SIM_MAX_TID) {
+		card->stats.tx_bad++;
+		return;
+	}
+	ooo = card->tx_flow[sta][tid].out_of_order;
+	sim_flow_check(&card->tx_flow[sta][tid], tag.seq);
+	card->stats.tx_out_of_order +=
+		card->tx_flow[sta][tid].out_of_order - ooo;
+	if (card->tx_log_len < card->tx_log_size)
+		card->tx_log[card->tx_log_len++] = tag.flow;
+}
+
+/**
+ *  @brief This function parses a data packet written by the host
+ *
+ *  @param card		A pointer to sim_card
+ *  @param pkt		Packet, starting with the SDIO header
+ *  @param len		Length of the packet
+ *
+ *  @return		0 or -1
+ */
+static int
+sim_card_tx_pkt(sim_card * card, t_u8 * pkt, t_u32 len)
+{
+	TxPD *ptx_pd = (TxPD *) (pkt + INTF_HEADER_LEN);
+	t_u16 pkt_len, pkt_offset, pkt_type, sub_len;
+	t_u8 *frame;
+	t_s32 left;
+
+	if (len < INTF_HEADER_LEN + sizeof(TxPD) ||
+	    wlan_le16_to_cpu(*(t_u16 *) & pkt[2]) != MLAN_TYPE_DATA) {
+		card->stats.tx_bad++;
+		return -1;
+	}
+	pkt_len = wlan_le16_to_cpu(ptx_pd->tx_pkt_length);
+	pkt_offset = wlan_le16_to_cpu(ptx_pd->tx_pkt_offset);
+	pkt_type = wlan_le16_to_cpu(ptx_pd->tx_pkt_type);
+	if (INTF_HEADER_LEN + pkt_offset + pkt_len > len) {
+		card->stats.tx_bad++;
+		return -1;
+	}
+	card->stats.tx_pkts++;
+	frame = (t_u8 *) ptx_pd + pkt_offset;
+
+	if (pkt_type != PKT_TYPE_AMSDU) {
+		if (pkt_len < MLAN_MAC_ADDR_LENGTH * 2 + 2) {
+			card->stats.tx_bad++;
+			return -1;
+		}
+		sim_card_tx_msdu(card, frame + MLAN_MAC_ADDR_LENGTH * 2 + 2,
+				 pkt_len - MLAN_MAC_ADDR_LENGTH * 2 - 2);
+		return 0;
+	}
+
+	/* A-MSDU subframes: DA, SA, length, LLC/SNAP, payload, pad to 4 */
+	card->stats.tx_amsdu++;
+	left = pkt_len;
+	while (left >= MLAN_MAC_ADDR_LENGTH * 2 + 2) {
+		sub_len = mlan_ntohs(*(t_u16 *) (frame +
+						 MLAN_MAC_ADDR_LENGTH * 2));
+		if (sub_len < LLC_SNAP_LEN ||
+		    MLAN_MAC_ADDR_LENGTH * 2 + 2 + sub_len > left) {
+			card->stats.tx_bad++;
+			return -1;
+		}
+		sim_card_tx_msdu(card,
+				 frame + MLAN_MAC_ADDR_LENGTH * 2 + 2 +
+				 LLC_SNAP_LEN, sub_len - LLC_SNAP_LEN);
+		sub_len = (MLAN_MAC_ADDR_LENGTH * 2 + 2 + sub_len + 3) & ~3;
+		frame += sub_len;
+		left -= sub_len;
+	}
+	return 0;
+}
+
+/**
+ *  @brief This function applies the command rules
+ *
+ *  @param card		A pointer to sim_card
+ *  @param cmd		Command code
+ *  @param result	A pointer to the result to return
+ *
+ *  @return		MTRUE to drop the command
+ */
+static int
+sim_card_cmd_apply_rule(sim_card * card, t_u16 cmd, t_u16 * result)
+{
+	sim_cmd_rule *rule;
+	int i;
+
+	for (i = 0; i < SIM_MAX_CMD_RULE; i++) {
+		rule = &card->cmd_rule[i];
+		if (!rule->cmd || rule->cmd != cmd)
+			continue;
+		*result = rule->result;
+		if (rule->count && !--rule->count)
+			rule->cmd = 0;
+		if (!*result) {
+			card->stats.cmds_dropped++;
+			return MTRUE;
+		}
+		card->stats.cmds_failed++;
+		return MFALSE;
+	}
+	return MFALSE;
+}
+
+/**
+ *  @brief This function executes a host command and queues the
+ *  response. Commands are echoed with the response bit set, the
+ *  few the host parses for state get a response built for them.
+ *
+ *  @param card		A pointer to sim_card
+ *  @param cmd		Command, starting with the GEN header
+ *  @param size		Size of the command
+ *
+ *  @return		0 or -1
+ */
+static int
+sim_card_run_cmd(sim_card * card, HostCmd_DS_COMMAND * cmd, t_u16 size)
+{
+	HostCmd_DS_COMMAND *resp;
+	HostCmd_DS_11N_ADDBA_REQ *padd_ba_req;
+	HostCmd_DS_11N_ADDBA_RSP *padd_ba_rsp;
+	HostCmd_DS_GET_HW_SPEC *hw_spec;
+	sim_upld *u;
+	t_u16 command, seq, result = 0;
+
+	command = wlan_le16_to_cpu(cmd->command);
+	seq = HostCmd_GET_SEQ_NO(wlan_le16_to_cpu(cmd->seq_num));
+	if (card->cmd_seq_valid && seq != ((card->cmd_seq + 1) & 0xff))
+		card->stats.cmd_seq_err++;
+	card->cmd_seq = seq;
+	card->cmd_seq_valid = MTRUE;
+
+	card->stats.cmds++;
+	if (sim_card_cmd_apply_rule(card, command, &result))
+		return 0;
+	if (command == HostCmd_CMD_11N_ADDBA_REQ && !result)
+		u = sim_upld_alloc(MLAN_TYPE_CMD,
+				   S_DS_GEN + sizeof(HostCmd_DS_11N_ADDBA_RSP));
+	else
+		u = sim_upld_alloc(MLAN_TYPE_CMD, size);
+	if (!u) {
+		card->stats.errors++;
+		return -1;
+	}
+	resp = (HostCmd_DS_COMMAND *) (u->buf + INTF_HEADER_LEN);
+	memcpy(resp, cmd, MIN(size, u->len - INTF_HEADER_LEN));
+	resp->command = wlan_cpu_to_le16(command | HostCmd_RET_BIT);
+	resp->result = wlan_cpu_to_le16(result);
+
+	if (!result) {
+		switch (command) {
+		case HostCmd_CMD_GET_HW_SPEC:
+			hw_spec = &resp->params.hw_spec;
+			memset(hw_spec, 0, size - S_DS_GEN);
+			hw_spec->hw_if_version = wlan_cpu_to_le16(1);
+			hw_spec->version = wlan_cpu_to_le16(1);
+			hw_spec->num_of_mcast_adr = wlan_cpu_to_le16(32);
+			memcpy(hw_spec->permanent_addr, card->mac_addr,
+			       MLAN_MAC_ADDR_LENGTH);
+			hw_spec->region_code = wlan_cpu_to_le16(SIM_REGION_CODE);
+			hw_spec->number_of_antenna = wlan_cpu_to_le16(1);
+			hw_spec->fw_release_number = wlan_cpu_to_le32(0x0e2600);
+			hw_spec->fw_cap_info =
+				wlan_cpu_to_le32(SIM_FW_CAP_INFO |
+						 (card->multi_cmd ?
+						  FW_MULTI_CMD_SUPPORT : 0));
+			hw_spec->dot_11n_dev_cap =
+				wlan_cpu_to_le32(SIM_DOT_11N_DEV_CAP);
+			hw_spec->dev_mcs_support = SIM_DEV_MCS_SUPPORT;
+			hw_spec->mp_end_port =
+				wlan_cpu_to_le16(card->mp_end_port);
+			break;
+		case HostCmd_CMD_RECONFIGURE_TX_BUFF:
+			resp->params.tx_buf.mp_end_port =
+				wlan_cpu_to_le16(card->mp_end_port);
+			break;
+		case HostCmd_CMD_11N_ADDBA_REQ:
+			padd_ba_req = &cmd->params.add_ba_req;
+			padd_ba_rsp = &resp->params.add_ba_rsp;
+			memset(padd_ba_rsp, 0, sizeof(*padd_ba_rsp));
+			resp->size = wlan_cpu_to_le16(S_DS_GEN +
+						      sizeof(*padd_ba_rsp));
+			memcpy(padd_ba_rsp->peer_mac_addr,
+			       padd_ba_req->peer_mac_addr,
+			       MLAN_MAC_ADDR_LENGTH);
+			padd_ba_rsp->dialog_token = padd_ba_req->dialog_token;
+			padd_ba_rsp->status_code =
+				wlan_cpu_to_le16(ADDBA_RSP_STATUS_ACCEPT);
+			padd_ba_rsp->block_ack_param_set =
+				padd_ba_req->block_ack_param_set;
+			padd_ba_rsp->block_ack_tmo = padd_ba_req->block_ack_tmo;
+			padd_ba_rsp->ssn = padd_ba_req->ssn;
+			break;
+		default:
+			break;
+		}
+	}
+	sim_upld_enqueue(&card->ctrl_q, u);
+	return 0;
+}
+
+/**
+ *  @brief This function executes a multi-command transfer. Each
+ *  command inside gets its own response, a response to the container
+ *  itself rejects the whole transfer.
+ *
+ *  @param card		A pointer to sim_card
+ *  @param cmd		Container, starting with the GEN header
+ *  @param size		Size of the container
+ *
+ *  @return		0 or -1
+ */
+static int
+sim_card_multi_cmd(sim_card * card, HostCmd_DS_COMMAND * cmd, t_u16 size)
+{
+	HostCmd_DS_MULTI_CMD *pmulti_cmd =
+		(HostCmd_DS_MULTI_CMD *) ((t_u8 *) cmd + S_DS_GEN);
+	HostCmd_DS_GEN *resp;
+	HostCmd_DS_COMMAND *pcmd;
+	sim_upld *u;
+	t_u32 offset = S_DS_GEN + sizeof(HostCmd_DS_MULTI_CMD);
+	t_u16 num, i, cmd_size;
+	int ret = 0;
+
+	if (size < offset) {
+		card->stats.errors++;
+		return -1;
+	}
+	if (!card->multi_cmd || card->multi_cmd_reject) {
+		card->stats.cmd_batch_rejected++;
+		/* The host renumbers the commands it sends again */
+		card->cmd_seq_valid = MFALSE;
+		u = sim_upld_alloc(MLAN_TYPE_CMD, S_DS_GEN);
+		if (!u) {
+			card->stats.errors++;
+			return -1;
+		}
+		resp = (HostCmd_DS_GEN *) (u->buf + INTF_HEADER_LEN);
+		memcpy(resp, cmd, S_DS_GEN);
+		resp->command = wlan_cpu_to_le16(HostCmd_CMD_MULTI_CMD |
+						 HostCmd_RET_BIT);
+		resp->size = wlan_cpu_to_le16(S_DS_GEN);
+		resp->result = wlan_cpu_to_le16(HostCmd_RESULT_ERROR);
+		sim_upld_enqueue(&card->ctrl_q, u);
+		return 0;
+	}
+
+	num = wlan_le16_to_cpu(pmulti_cmd->num_cmd);
+	if (!num || num > MRVDRV_MAX_CMD_BATCH) {
+		card->stats.errors++;
+		return -1;
+	}
+	card->stats.cmd_batches++;
+	for (i = 0; i < num && !ret; i++) {
+		if (offset + S_DS_GEN > size) {
+			ret = -1;
+			break;
+		}
+		pcmd = (HostCmd_DS_COMMAND *) ((t_u8 *) cmd + offset);
+		cmd_size = wlan_le16_to_cpu(pcmd->size);
+		if (cmd_size < S_DS_GEN || offset + cmd_size > size ||
+		    wlan_le16_to_cpu(pcmd->command) == HostCmd_CMD_MULTI_CMD) {
+			ret = -1;
+			break;
+		}
+		card->stats.cmds_batched++;
+		ret = sim_card_run_cmd(card, pcmd, cmd_size);
+		offset += cmd_size;
+	}
+	if (!ret && offset != size)
+		ret = -1;
+	if (ret)
+		card->stats.errors++;
+	return ret;
+}
+
+/**
+ *  @brief This function takes a command transfer
+ *
+ *  @param card		A pointer to sim_card
+ *  @param pkt		Command, starting with the SDIO header
+ *  @param len		Length of the command
+ *
+ *  @return		0 or -1
+ */
+static int
+sim_card_cmd(sim_card * card, t_u8 * pkt, t_u32 len)
+{
+	HostCmd_DS_COMMAND *cmd =
+		(HostCmd_DS_COMMAND *) (pkt + INTF_HEADER_LEN);
+	t_u16 size;
+
+	if (len < INTF_HEADER_LEN + S_DS_GEN ||
+	    wlan_le16_to_cpu(*(t_u16 *) & pkt[2]) != MLAN_TYPE_CMD) {
+		card->stats.errors++;
+		return -1;
+	}
+	size = wlan_le16_to_cpu(cmd->size);
+	if (size < S_DS_GEN || INTF_HEADER_LEN + size > len) {
+		card->stats.errors++;
+		return -1;
+	}
+	if (wlan_le16_to_cpu(cmd->command) == HostCmd_CMD_MULTI_CMD)
+		return sim_card_multi_cmd(card, cmd, size);
+	return sim_card_run_cmd(card, cmd, size);
+}
+
+/**
+ *  @brief This function takes a firmware download block
+ *
+ *  @param card		A pointer to sim_card
+ *  @param len		Length of the block
+ *
+ *  @return		N/A
+ */
+static void
+sim_card_fw_block(sim_card * card, t_u32 len)
+{
+	if (card->fw_state == SIM_FW_BOOT)
+		card->fw_state = SIM_FW_DNLD;
+	if (card->fw_resend) {
+		card->fw_resend = MFALSE;
+		card->stats.fw_crc_retry++;
+		return;
+	}
+	card->stats.fw_blocks++;
+	card->stats.fw_bytes += len;
+}
+
+/**
+ *  @brief This function shuffles packets within windows of win_size,
+ *  the way a lossy air interface with retries reorders an A-MPDU
+ *
+ *  @param card		A pointer to sim_card
+ *  @param pkts		Array of uploads
+ *  @param count	Number of uploads
+ *  @param win_size	Window size
+ *
+ *  @return		N/A
+ */
+static void
+sim_card_shuffle(sim_card * card, sim_upld ** pkts, t_u32 count,
+		 t_u32 win_size)
+{
+	sim_upld *tmp;
+	t_u32 base, n, i, j;
+
+	for (base = 0; base < count; base += win_size) {
+		n = MIN(win_size, count - base);
+		for (i = n - 1; i > 0; i--) {
+			card->seed = card->seed * 1103515245 + 12345;
+			j = ((card->seed >> 16) & 0x7fff) % (i + 1);
+			tmp = pkts[base + i];
+			pkts[base + i] = pkts[base + j];
+			pkts[base + j] = tmp;
+		}
+	}
+}
+
+/********************************************************
+		Global Functions
+********************************************************/
+
+/**
+ *  @brief This function creates the card in its boot state
+ *
+ *  @return		A pointer to sim_card or NULL
+ */
+sim_card *
+sim_card_create(void)
+{
+	sim_card *card;
+
+	card = calloc(1, sizeof(sim_card));
+	if (!card)
+		return NULL;
+	pthread_mutex_init(&card->lock, NULL);
+	card->ioport = SIM_IOPORT;
+	card->fw_state = SIM_FW_BOOT;
+	card->fw_chunk = SIM_FW_CHUNK;
+	card->mp_end_port = MAX_PORT;
+	card->wr_bitmap = 0xffff;
+	card->curr_rd_port = 1;
+	card->seed = 1;
+	memcpy(card->mac_addr, sim_mac_addr, MLAN_MAC_ADDR_LENGTH);
+	return card;
+}
+
+/**
+ *  @brief This function frees the card and any uploads left
+ *
+ *  @param card		A pointer to sim_card
+ *
+ *  @return		N/A
+ */
+void
+sim_card_free(sim_card * card)
+{
+	int port;
+
+	if (!card)
+		return;
+	for (port = 0; port < MAX_PORT; port++)
+		free(card->port_upld[port]);
+	sim_upld_purge(&card->ctrl_q);
+	sim_upld_purge(&card->data_q);
+	pthread_mutex_destroy(&card->lock);
+	free(card->tx_log);
+	free(card);
+}
+
+/**
+ *  @brief This function reads a function 1 register
+ *
+ *  @param card		A pointer to sim_card
+ *  @param reg		Register offset
+ *  @param data		A pointer to the value
+ *
+ *  @return		MLAN_STATUS_SUCCESS or MLAN_STATUS_FAILURE
+ */
+mlan_status
+sim_card_read_reg(sim_card * card, t_u32 reg, t_u32 * data)
+{
+	t_u32 len;
+
+	if (reg >= sizeof(card->regs))
+		return MLAN_STATUS_FAILURE;
+	pthread_mutex_lock(&card->lock);
+	switch (reg) {
+	case HOST_INT_STATUS_REG:
+		*data = card->int_status;
+		card->int_status = 0;
+		break;
+	case CARD_TO_HOST_EVENT_REG:
+		*data = CARD_IO_READY | DN_LD_CARD_RDY;
+		break;
+	case READ_BASE_0_REG:
+		len = card->fw_chunk;
+		if (card->fw_state != SIM_FW_READY && card->fw_crc_err &&
+		    card->stats.fw_blocks && !card->fw_resend) {
+			card->fw_crc_err--;
+			card->fw_resend = MTRUE;
+			len |= MBIT(0);
+		}
+		*data = len & 0xff;
+		break;
+	case READ_BASE_1_REG:
+		*data = (card->fw_chunk >> 8) & 0xff;
+		break;
+	case CARD_FW_STATUS0_REG:
+		/* The firmware comes up once the host polls after download */
+		if (card->fw_state == SIM_FW_DNLD) {
+			card->fw_state = SIM_FW_READY;
+			card->int_status |= DN_LD_HOST_INT_STATUS;
+		}
+		*data = (card->fw_state == SIM_FW_READY) ?
+			(FIRMWARE_READY & 0xff) : 0;
+		break;
+	case CARD_FW_STATUS1_REG:
+		*data = (card->fw_state == SIM_FW_READY) ?
+			(FIRMWARE_READY >> 8) : 0;
+		break;
+	case IO_PORT_0_REG:
+		*data = card->ioport & 0xff;
+		break;
+	case IO_PORT_1_REG:
+		*data = (card->ioport >> 8) & 0xff;
+		break;
+	case IO_PORT_2_REG:
+		*data = (card->ioport >> 16) & 0xff;
+		break;
+	default:
+		*data = card->regs[reg];
+		break;
+	}
+	sim_card_unlock(card);
+	return MLAN_STATUS_SUCCESS;
+}
+
+/**
+ *  @brief This function writes a function 1 register
+ *
+ *  @param card		A pointer to sim_card
+ *  @param reg		Register offset
+ *  @param data		Value
+ *
+ *  @return		MLAN_STATUS_SUCCESS or MLAN_STATUS_FAILURE
+ */
+mlan_status
+sim_card_write_reg(sim_card * card, t_u32 reg, t_u32 data)
+{
+	if (reg >= sizeof(card->regs))
+		return MLAN_STATUS_FAILURE;
+	pthread_mutex_lock(&card->lock);
+	if (reg == HOST_TO_CARD_EVENT_REG && (data & HOST_TERM_CMD53))
+		card->stats.errors++;
+	card->regs[reg] = (t_u8) data;
+	sim_card_unlock(card);
+	return MLAN_STATUS_SUCCESS;
+}
+
+/**
+ *  @brief This function takes a CMD53 write: a firmware block before
+ *  the firmware is up, then commands on the control port and data,
+ *  single or MP-A aggregated, on the data ports
+ *
+ *  @param card		A pointer to sim_card
+ *  @param pmbuf	A pointer to mlan_buffer
+ *  @param port		Port address
+ *
+ *  @return		MLAN_STATUS_SUCCESS or MLAN_STATUS_FAILURE
+ */
+mlan_status
+sim_card_write_data(sim_card * card, pmlan_buffer pmbuf, t_u32 port)
+{
+	t_u8 *pkt = pmbuf->pbuf + pmbuf->data_offset;
+	t_u32 addr = port & 0xfffff;
+	t_u32 len = pmbuf->data_len;
+	t_u32 off, ports, i, cnt = 0, pkt_len;
+	int ret = 0;
+
+	pthread_mutex_lock(&card->lock);
+	if (card->fw_state != SIM_FW_READY) {
+		sim_card_fw_block(card, len);
+		sim_card_unlock(card);
+		return MLAN_STATUS_SUCCESS;
+	}
+	if (addr < card->ioport) {
+		card->stats.errors++;
+		sim_card_unlock(card);
+		return MLAN_STATUS_FAILURE;
+	}
+	off = addr - card->ioport;
+
+	if (off == CTRL_PORT) {
+		ret = sim_card_cmd(card, pkt, len);
+	} else if (off & SDIO_MPA_ADDR_BASE) {
+		ports = (off >> 4) & 0xff;
+		card->stats.tx_writes++;
+		card->stats.tx_mpa_writes++;
+		for (i = 0; i < 8 && !ret; i++) {
+			if (!(ports & (1 << i)))
+				continue;
+			if (len < INTF_HEADER_LEN) {
+				ret = -1;
+				break;
+			}
+			pkt_len = wlan_le16_to_cpu(*(t_u16 *) pkt);
+			if (!pkt_len || SIM_BLK_ALIGN(pkt_len) > len) {
+				ret = -1;
+				break;
+			}
+			ret = sim_card_tx_pkt(card, pkt, pkt_len);
+			pkt += SIM_BLK_ALIGN(pkt_len);
+			len -= SIM_BLK_ALIGN(pkt_len);
+			cnt++;
+		}
+		card->stats.tx_mpa_hist[MIN(cnt, SIM_MAX_TID)]++;
+	} else {
+		card->stats.tx_writes++;
+		pkt_len = wlan_le16_to_cpu(*(t_u16 *) pkt);
+		if (pkt_len > len)
+			ret = -1;
+		else
+			ret = sim_card_tx_pkt(card, pkt, pkt_len);
+	}
+	if (ret)
+		card->stats.errors++;
+	/* Every port is free again as soon as it is written */
+	card->int_status |= DN_LD_HOST_INT_STATUS;
+	sim_card_unlock(card);
+	return MLAN_STATUS_SUCCESS;
+}
+
+/**
+ *  @brief This function takes a CMD53 read: the register block, a
+ *  single port or an MP-A aggregate of data ports
+ *
+ *  @param card		A pointer to sim_card
+ *  @param pmbuf	A pointer to mlan_buffer
+ *  @param port		Port address
+ *
+ *  @return		MLAN_STATUS_SUCCESS or MLAN_STATUS_FAILURE
+ */
+mlan_status
+sim_card_read_data(sim_card * card, pmlan_buffer pmbuf, t_u32 port)
+{
+	t_u8 *pbuf = pmbuf->pbuf + pmbuf->data_offset;
+	t_u32 addr = port & 0xfffff;
+	t_u32 len = pmbuf->data_len;
+	t_u32 off, ports, start, i, cnt = 0;
+	t_u8 p;
+	int n = 0;
+
+	pthread_mutex_lock(&card->lock);
+	if (addr < card->ioport) {
+		sim_card_read_regs(card, pbuf, len);
+		sim_card_unlock(card);
+		return MLAN_STATUS_SUCCESS;
+	}
+	off = addr - card->ioport;
+
+	if (off & SDIO_MPA_ADDR_BASE) {
+		ports = (off >> 4) & 0xff;
+		start = off & 0xf;
+		card->stats.rx_reads++;
+		card->stats.rx_mpa_reads++;
+		for (i = 0; i < 8; i++) {
+			if (!(ports & (1 << i)))
+				continue;
+			p = (start + i) % MAX_PORT;
+			if (p == CTRL_PORT) {
+				n = -1;
+				break;
+			}
+			n = sim_card_read_port(card, p, pbuf, len);
+			if (n < 0)
+				break;
+			pbuf += n;
+			len -= n;
+			cnt++;
+		}
+		card->stats.rx_mpa_hist[MIN(cnt, SIM_MAX_TID)]++;
+	} else {
+		if (off != CTRL_PORT)
+			card->stats.rx_reads++;
+		n = sim_card_read_port(card, (t_u8) (off & 0xf), pbuf, len);
+	}
+	if (n < 0)
+		card->stats.errors++;
+	sim_card_unlock(card);
+	return (n < 0) ? MLAN_STATUS_FAILURE : MLAN_STATUS_SUCCESS;
+}
+
+/**
+ *  @brief This function queues a firmware event
+ *
+ *  @param card		A pointer to sim_card
+ *  @param bss_type	BSS type
+ *  @param bss_num	BSS number
+ *  @param event_id	Event ID
+ *  @param body		Event body, after the event cause
+ *  @param body_len	Length of the event body
+ *
+ *  @return		0 or -1
+ */
+int
+sim_card_event(sim_card * card, t_u8 bss_type, t_u8 bss_num,
+	       t_u16 event_id, t_u8 * body, t_u32 body_len)
+{
+	sim_upld *u;
+	t_u32 cause;
+
+	u = sim_upld_alloc(MLAN_TYPE_EVENT, sizeof(t_u32) + body_len);
+	if (!u)
+		return -1;
+	cause = event_id | ((bss_num & BSS_NUM_MASK) << 16) |
+		(bss_type << 24);
+	*(t_u32 *) & u->buf[INTF_HEADER_LEN] = wlan_cpu_to_le32(cause);
+	if (body_len)
+		memcpy(u->buf + MLAN_EVENT_HEADER_LEN, body, body_len);
+
+	pthread_mutex_lock(&card->lock);
+	sim_upld_enqueue(&card->ctrl_q, u);
+	card->stats.events++;
+	sim_card_unlock(card);
+	return 0;
+}
+
+/**
+ *  @brief This function queues data packets from a station to the
+ *  uAP. Each packet carries a tag with its flow and sequence number,
+ *  and can be shuffled within windows of shuffle packets.
+ *
+ *  @param card		A pointer to sim_card
+ *  @param sta		Station index
+ *  @param tid		TID
+ *  @param count	Number of packets
+ *  @param len		Ethernet frame length
+ *  @param shuffle	Shuffle window, 0 or 1 to keep the order
+ *
+ *  @return		0 or -1
+ */
+int
+sim_card_rx(sim_card * card, t_u32 sta, t_u8 tid, t_u32 count,
+	    t_u32 len, t_u32 shuffle)
+{
+	sim_upld **pkts;
+	sim_upld *u;
+	UapRxPD *prx_pd;
+	sim_payload_tag tag;
+	t_u8 *frame;
+	t_u32 i, j, seq;
+
+	if (sta >= card->sta_num || tid >= SIM_MAX_TID ||
+	    len < MLAN_MAC_ADDR_LENGTH * 2 + 2 + SIM_PAYLOAD_MIN_LEN ||
+	    SIM_BLK_ALIGN(INTF_HEADER_LEN + sizeof(UapRxPD) + len) >
+	    ALLOC_BUF_SIZE)
+		return -1;
+	pkts = calloc(count, sizeof(sim_upld *));
+	if (!pkts)
+		return -1;
+
+	pthread_mutex_lock(&card->lock);
+	seq = card->rx_next[sta][tid];
+	card->rx_next[sta][tid] += count;
+	pthread_mutex_unlock(&card->lock);
+
+	for (i = 0; i < count; i++) {
+		u = sim_upld_alloc(MLAN_TYPE_DATA, sizeof(UapRxPD) + len);
+		if (!u) {
+			while (i)
+				free(pkts[--i]);
+			free(pkts);
+			return -1;
+		}
+		prx_pd = (UapRxPD *) (u->buf + INTF_HEADER_LEN);
+		prx_pd->bss_type = MLAN_BSS_TYPE_UAP;
+		prx_pd->bss_num = 0;
+		prx_pd->rx_pkt_length = wlan_cpu_to_le16(len);
+		prx_pd->rx_pkt_offset = wlan_cpu_to_le16(sizeof(UapRxPD));
+		prx_pd->seq_num = wlan_cpu_to_le16((seq + i) & 0xfff);
+		prx_pd->priority = tid;
+
+		frame = (t_u8 *) (prx_pd + 1);
+		memcpy(frame, card->mac_addr, MLAN_MAC_ADDR_LENGTH);
+		memcpy(frame + MLAN_MAC_ADDR_LENGTH, card->sta_addr[sta],
+		       MLAN_MAC_ADDR_LENGTH);
+		frame[MLAN_MAC_ADDR_LENGTH * 2] = 0x08;
+		frame[MLAN_MAC_ADDR_LENGTH * 2 + 1] = 0x00;
+		tag.magic = SIM_PAYLOAD_MAGIC;
+		tag.flow = (sta << 8) | tid;
+		tag.seq = seq + i;
+		frame += MLAN_MAC_ADDR_LENGTH * 2 + 2;
+		memcpy(frame, &tag, sizeof(tag));
+		for (j = sizeof(tag);
+		     j < len - MLAN_MAC_ADDR_LENGTH * 2 - 2; j++)
+			frame[j] = (t_u8) j;
+		pkts[i] = u;
+	}
+
+	pthread_mutex_lock(&card->lock);
+	if (shuffle > 1)
+		sim_card_shuffle(card, pkts, count, shuffle);
+	for (i = 0; i < count; i++)
+		sim_upld_enqueue(&card->data_q, pkts[i]);
+	sim_card_unlock(card);
+	free(pkts);
+	return 0;
+}
+
+/**
+ *  @brief This function associates stations with the uAP
+ *
+ *  @param card		A pointer to sim_card
+ *  @param count	Number of stations to add
+ *  @param ht		Stations advertise HT capability
+ *
+ *  @return		0 or -1
+ */
+int
+sim_card_add_sta(sim_card * card, t_u32 count, t_u8 ht)
+{
+	t_u8 body[2 + MLAN_MAC_ADDR_LENGTH + sizeof(MrvlIEtypesHeader_t) +
+		  sizeof(IEEEtypes_FrameCtl_t) + sizeof(IEEEtypes_AssocRqst_t) +
+		  sizeof(IEEEtypes_HTCap_t)];
+	MrvlIEtypesHeader_t *tlv;
+	IEEEtypes_HTCap_t *pht_cap;
+	t_u8 *pos;
+	t_u32 i, sta;
+
+	for (i = 0; i < count; i++) {
+		pthread_mutex_lock(&card->lock);
+		if (card->sta_num >= SIM_MAX_STA) {
+			pthread_mutex_unlock(&card->lock);
+			return -1;
+		}
+		sta = card->sta_num++;
+		card->sta_addr[sta][0] = 0x00;
+		card->sta_addr[sta][1] = 0x50;
+		card->sta_addr[sta][2] = 0x43;
+		card->sta_addr[sta][3] = 0x20;
+		card->sta_addr[sta][4] = 0x00;
+		card->sta_addr[sta][5] = (t_u8) (sta + 1);
+		pthread_mutex_unlock(&card->lock);
+
+		/* Body: reserved, station MAC, then the assoc request in a
+		   management frame TLV */
+		memset(body, 0, sizeof(body));
+		pos = body + 2;
+		memcpy(pos, card->sta_addr[sta], MLAN_MAC_ADDR_LENGTH);
+		pos += MLAN_MAC_ADDR_LENGTH;
+		tlv = (MrvlIEtypesHeader_t *) pos;
+		tlv->type = wlan_cpu_to_le16(TLV_TYPE_UAP_MGMT_FRAME);
+		tlv->len = sizeof(IEEEtypes_FrameCtl_t) +
+			sizeof(IEEEtypes_AssocRqst_t);
+		pos += sizeof(MrvlIEtypesHeader_t) +
+			sizeof(IEEEtypes_FrameCtl_t) +
+			sizeof(IEEEtypes_AssocRqst_t);
+		if (ht) {
+			pht_cap = (IEEEtypes_HTCap_t *) pos;
+			pht_cap->ieee_hdr.element_id = HT_CAPABILITY;
+			pht_cap->ieee_hdr.len = sizeof(HTCap_t);
+			tlv->len += sizeof(IEEEtypes_HTCap_t);
+			pos += sizeof(IEEEtypes_HTCap_t);
+		}
+		tlv->len = wlan_cpu_to_le16(tlv->len);
+		if (sim_card_event(card, MLAN_BSS_TYPE_UAP, 0,
+				   EVENT_MICRO_AP_STA_ASSOC, body, pos - body))
+			return -1;
+	}
+	return 0;
+}
+
+/**
+ *  @brief This function starts the uAP BSS
+ *
+ *  @param card		A pointer to sim_card
+ *  @param ht		BSS is 11n
+ *
+ *  @return		0 or -1
+ */
+int
+sim_card_bss_start(sim_card * card, t_u8 ht)
+{
+	t_u8 body[2 + MLAN_MAC_ADDR_LENGTH + sizeof(MrvlIEtypesHeader_t) +
+		  sizeof(HTCap_t)];
+	MrvlIEtypesHeader_t *tlv;
+	t_u32 len = 2 + MLAN_MAC_ADDR_LENGTH;
+
+	memset(body, 0, sizeof(body));
+	memcpy(body + 2, card->mac_addr, MLAN_MAC_ADDR_LENGTH);
+	if (ht) {
+		tlv = (MrvlIEtypesHeader_t *) (body + len);
+		tlv->type = wlan_cpu_to_le16(HT_CAPABILITY);
+		tlv->len = wlan_cpu_to_le16(sizeof(HTCap_t));
+		len += sizeof(MrvlIEtypesHeader_t) + sizeof(HTCap_t);
+	}
+	if (sim_card_event(card, MLAN_BSS_TYPE_UAP, 0,
+			   EVENT_MICRO_AP_BSS_START, body, len))
+		return -1;
+	return sim_card_event(card, MLAN_BSS_TYPE_UAP, 0,
+			      EVENT_MICRO_AP_BSS_ACTIVE, body,
+			      2 + MLAN_MAC_ADDR_LENGTH);
+}
+
+/**
+ *  @brief This function requests a block ack agreement from a station
+ *
+ *  @param card		A pointer to sim_card
+ *  @param sta		Station index
+ *  @param tid		TID
+ *  @param win_size	Window size requested
+ *
+ *  @return		0 or -1
+ */
+int
+sim_card_addba(sim_card * card, t_u32 sta, t_u8 tid, t_u16 win_size)
+{
+	HostCmd_DS_11N_ADDBA_REQ addba;
+
+	if (sta >= card->sta_num || tid >= SIM_MAX_TID)
+		return -1;
+	memset(&addba, 0, sizeof(addba));
+	memcpy(addba.peer_mac_addr, card->sta_addr[sta], MLAN_MAC_ADDR_LENGTH);
+	addba.dialog_token = 1;
+	addba.block_ack_param_set =
+		wlan_cpu_to_le16((tid << BLOCKACKPARAM_TID_POS) |
+				 (win_size << BLOCKACKPARAM_WINSIZE_POS));
+	pthread_mutex_lock(&card->lock);
+	addba.ssn = wlan_cpu_to_le16(card->rx_next[sta][tid] & 0xfff);
+	pthread_mutex_unlock(&card->lock);
+	return sim_card_event(card, MLAN_BSS_TYPE_UAP, 0, EVENT_ADDBA,
+			      (t_u8 *) & addba, sizeof(addba));
+}
+
+/**
+ *  @brief This function starts logging the flow of every MSDU the
+ *  host writes, dropping the previous log
+ *
+ *  @param card		A pointer to sim_card
+ *  @param size		Number of MSDUs to log, 0 to stop logging
+ *
+ *  @return		0 or -1
+ */
+int
+sim_card_tx_log(sim_card * card, t_u32 size)
+{
+	t_u32 *log = NULL;
+
+	if (size) {
+		log = calloc(size, sizeof(t_u32));
+		if (!log)
+			return -1;
+	}
+	pthread_mutex_lock(&card->lock);
+	free(card->tx_log);
+	card->tx_log = log;
+	card->tx_log_len = 0;
+	card->tx_log_size = size;
+	pthread_mutex_unlock(&card->lock);
+	return 0;
+}
+
+/**
+ *  @brief This function adds a command rule
+ *
+ *  @param card		A pointer to sim_card
+ *  @param cmd		Command code
+ *  @param result	Result to return, 0 to drop the command
+ *  @param count	Number of commands to apply it to, 0 for all
+ *
+ *  @return		0 or -1
+ */
+int
+sim_card_cmd_rule(sim_card * card, t_u16 cmd, t_u16 result, t_u32 count)
+{
+	int i, ret = -1;
+
+	pthread_mutex_lock(&card->lock);
+	for (i = 0; i < SIM_MAX_CMD_RULE; i++) {
+		if (!card->cmd_rule[i].cmd) {
+			card->cmd_rule[i].cmd = cmd;
+			card->cmd_rule[i].result = result;
+			card->cmd_rule[i].count = count;
+			ret = 0;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&card->lock);
+	return ret;
+}
+
+/**
+ *  @brief This function checks whether the card holds uploads the host
+ *  has not read yet
+ *
+ *  @param card		A pointer to sim_card
+ *
+ *  @return		MTRUE or MFALSE
+ */
+int
+sim_card_busy(sim_card * card)
+{
+	int busy;
+
+	pthread_mutex_lock(&card->lock);
+	busy = card->rd_bitmap || card->ctrl_q.count || card->data_q.count;
+	pthread_mutex_unlock(&card->lock);
+	return busy;
+}
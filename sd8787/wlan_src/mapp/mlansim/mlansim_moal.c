@@ -0,0 +1,1322 @@
+/** @file  mlansim_moal.c
+  *
+  * @brief This file contains the simulated MOAL callbacks of the
+  * userspace MLAN harness. Locks, timers and work queues are built on
+  * pthreads, buffers on malloc.
+  *
+  * Copyright (C) 2011-2012, Marvell International Ltd.
+  *
+  * This software file (the "File") is distributed by Marvell International
+  * Ltd. under the terms of the GNU General Public License Version 2, June 1991
+  * (the "License").  You may use, redistribute and/or modify this File in
+  * accordance with the terms and conditions of the License, a copy of which
+  * is available by writing to the Free Software Foundation, Inc.,
+  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA or on the
+  * worldwide web at http://www.gnu.org/licenses/old-licenses/gpl-2.0.txt.
+  *
+  * THE FILE IS DISTRIBUTED AS-IS, WITHOUT WARRANTY OF ANY KIND, AND THE
+  * IMPLIED WARRANTIES OF MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE
+  * ARE EXPRESSLY DISCLAIMED.  The License provides additional details about
+  * this warranty disclaimer.
+  *
+  */
+/************************************************************************
+Change log:
+     10/17/2012: initial version
+************************************************************************/
+
+#include    <stdarg.h>
+#include    <errno.h>
+#include    <unistd.h>
+#include    <time.h>
+#include    <sys/time.h>
+
+#include    "mlansim.h"
+
+/********************************************************
+		Local Variables
+********************************************************/
+
+/** Simulated timer */
+typedef struct _sim_timer {
+    /** Next timer */
+	struct _sim_timer *pnext;
+    /** Timer function */
+	t_void(*callback) (t_void * pcontext);
+    /** Timer function context */
+	t_void *pcontext;
+    /** Expiry time */
+	struct timespec expires;
+    /** Period in msec */
+	t_u32 msec;
+    /** Periodic timer */
+	t_u8 periodic;
+    /** Timer armed */
+	t_u8 active;
+} sim_timer;
+
+/** Timer list lock */
+static pthread_mutex_t timer_lock = PTHREAD_MUTEX_INITIALIZER;
+/** Signals the timer thread */
+static pthread_cond_t timer_cond;
+/** Timer list */
+static sim_timer *timer_list;
+/** Timer whose callback is running */
+static sim_timer *timer_running;
+/** Timer thread */
+static pthread_t timer_thread;
+/** Stop the timer thread */
+static t_u8 timer_stop;
+/** Timer durations are divided by this */
+static t_u32 timer_scale = 1;
+/** Timers only expire through sim_fire_timer */
+static t_u8 timer_hold;
+
+/** Wait idle timeout in msec */
+#define SIM_IDLE_TIMEOUT	10000
+
+/********************************************************
+		Local Functions
+********************************************************/
+
+/**
+ *  @brief This function gets the monotonic time msec from now
+ *
+ *  @param ts		A pointer to timespec to fill
+ *  @param msec		Offset in msec
+ *
+ *  @return		N/A
+ */
+static void
+sim_time_after(struct timespec *ts, t_u32 msec)
+{
+	clock_gettime(CLOCK_MONOTONIC, ts);
+	ts->tv_sec += msec / 1000;
+	ts->tv_nsec += (long)(msec % 1000) * 1000000;
+	if (ts->tv_nsec >= 1000000000) {
+		ts->tv_sec++;
+		ts->tv_nsec -= 1000000000;
+	}
+}
+
+/**
+ *  @brief This function compares two times
+ *
+ *  @param a		A pointer to timespec
+ *  @param b		A pointer to timespec
+ *
+ *  @return		MTRUE if a is before or equal to b
+ */
+static int
+sim_time_before(struct timespec *a, struct timespec *b)
+{
+	if (a->tv_sec != b->tv_sec)
+		return a->tv_sec < b->tv_sec;
+	return a->tv_nsec <= b->tv_nsec;
+}
+
+/**
+ *  @brief This function initializes a condition variable on the
+ *  monotonic clock
+ *
+ *  @param cond		A pointer to pthread_cond_t
+ *
+ *  @return		N/A
+ */
+static void
+sim_cond_init(pthread_cond_t * cond)
+{
+	pthread_condattr_t attr;
+
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(cond, &attr);
+	pthread_condattr_destroy(&attr);
+}
+
+/**
+ *  @brief The timer thread, runs expired timer functions
+ *
+ *  @param arg		Not used
+ *
+ *  @return		NULL
+ */
+static void *
+sim_timer_thread(void *arg)
+{
+	sim_timer *ptimer, *pfirst;
+	struct timespec now;
+
+	pthread_mutex_lock(&timer_lock);
+	while (!timer_stop) {
+		pfirst = NULL;
+		for (ptimer = timer_list; ptimer; ptimer = ptimer->pnext) {
+			if (ptimer->active && (!pfirst ||
+					       sim_time_before(&ptimer->expires,
+							       &pfirst->
+							       expires)))
+				pfirst = ptimer;
+		}
+		if (!pfirst || timer_hold) {
+			pthread_cond_wait(&timer_cond, &timer_lock);
+			continue;
+		}
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		if (!sim_time_before(&pfirst->expires, &now)) {
+			pthread_cond_timedwait(&timer_cond, &timer_lock,
+					       &pfirst->expires);
+			continue;
+		}
+		if (pfirst->periodic)
+			sim_time_after(&pfirst->expires, pfirst->msec);
+		else
+			pfirst->active = MFALSE;
+		timer_running = pfirst;
+		pthread_mutex_unlock(&timer_lock);
+		pfirst->callback(pfirst->pcontext);
+		pthread_mutex_lock(&timer_lock);
+		timer_running = NULL;
+		pthread_cond_broadcast(&timer_cond);
+	}
+	pthread_mutex_unlock(&timer_lock);
+	return NULL;
+}
+
+/**
+ *  @brief The main work thread, the equivalent of the MOAL main
+ *  work queue plus the SDIO interrupt handler
+ *
+ *  @param arg		A pointer to sim_handle
+ *
+ *  @return		NULL
+ */
+static void *
+sim_main_thread(void *arg)
+{
+	sim_handle *handle = (sim_handle *) arg;
+	t_u8 irq;
+
+	pthread_mutex_lock(&handle->work_lock);
+	while (MTRUE) {
+		while (!handle->stop && !handle->irq_pending &&
+		       !handle->main_work)
+			pthread_cond_wait(&handle->work_cond,
+					  &handle->work_lock);
+		if (handle->stop)
+			break;
+		irq = handle->irq_pending;
+		handle->irq_pending = MFALSE;
+		handle->main_work = MFALSE;
+		handle->main_busy = MTRUE;
+		pthread_mutex_unlock(&handle->work_lock);
+
+		if (irq)
+			mlan_interrupt(handle->pmlan_adapter);
+		mlan_main_process(handle->pmlan_adapter);
+
+		pthread_mutex_lock(&handle->work_lock);
+		handle->main_busy = MFALSE;
+		pthread_cond_broadcast(&handle->idle_cond);
+	}
+	pthread_mutex_unlock(&handle->work_lock);
+	return NULL;
+}
+
+/**
+ *  @brief The Rx work thread, the equivalent of the MOAL Rx work queue
+ *
+ *  @param arg		A pointer to sim_handle
+ *
+ *  @return		NULL
+ */
+static void *
+sim_rx_thread(void *arg)
+{
+	sim_handle *handle = (sim_handle *) arg;
+
+	pthread_mutex_lock(&handle->work_lock);
+	while (MTRUE) {
+		while (!handle->stop && !handle->rx_work)
+			pthread_cond_wait(&handle->work_cond,
+					  &handle->work_lock);
+		if (handle->stop)
+			break;
+		handle->rx_work = MFALSE;
+		handle->rx_busy = MTRUE;
+		pthread_mutex_unlock(&handle->work_lock);
+
+		mlan_rx_process(handle->pmlan_adapter);
+
+		pthread_mutex_lock(&handle->work_lock);
+		handle->rx_busy = MFALSE;
+		pthread_cond_broadcast(&handle->idle_cond);
+	}
+	pthread_mutex_unlock(&handle->work_lock);
+	return NULL;
+}
+
+/**
+ *  @brief This function queues the Rx work
+ *
+ *  @param handle	A pointer to sim_handle
+ *
+ *  @return		N/A
+ */
+static void
+sim_queue_rx_work(sim_handle * handle)
+{
+	pthread_mutex_lock(&handle->work_lock);
+	handle->rx_work = MTRUE;
+	pthread_cond_broadcast(&handle->work_cond);
+	pthread_mutex_unlock(&handle->work_lock);
+}
+
+/**
+ *  @brief This function waits for queued Rx work to finish
+ *
+ *  @param handle	A pointer to sim_handle
+ *
+ *  @return		N/A
+ */
+static void
+sim_flush_rx_work(sim_handle * handle)
+{
+	if (pthread_equal(pthread_self(), handle->rx_thread))
+		return;
+	pthread_mutex_lock(&handle->work_lock);
+	while (!handle->stop && (handle->rx_work || handle->rx_busy))
+		pthread_cond_wait(&handle->idle_cond, &handle->work_lock);
+	pthread_mutex_unlock(&handle->work_lock);
+}
+
+/**
+ *  @brief This function checks whether MLAN has work in progress
+ *
+ *  @param handle	A pointer to sim_handle
+ *
+ *  @return		MTRUE or MFALSE
+ */
+static int
+sim_work_pending(sim_handle * handle)
+{
+	return handle->irq_pending || handle->main_work || handle->main_busy
+		|| handle->rx_work || handle->rx_busy;
+}
+
+/********************************************************
+		MOAL callbacks
+********************************************************/
+
+/**
+ *  @brief This function gets firmware data. The harness always passes
+ *  the image to mlan_dnld_fw, so this is never called.
+ *
+ *  @param pmoal_handle Pointer to the MOAL context
+ *  @param offset	Offset
+ *  @param len		Length
+ *  @param pbuf		Buffer to fill
+ *
+ *  @return		MLAN_STATUS_FAILURE
+ */
+static mlan_status
+sim_get_fw_data(IN t_void * pmoal_handle,
+		IN t_u32 offset, IN t_u32 len, OUT t_u8 * pbuf)
+{
+	return MLAN_STATUS_FAILURE;
+}
+
+/**
+ *  @brief This function records firmware init completion
+ *
+ *  @param pmoal_handle Pointer to the MOAL context
+ *  @param status	Init status
+ *
+ *  @return		MLAN_STATUS_SUCCESS
+ */
+static mlan_status
+sim_init_fw_complete(IN t_void * pmoal_handle, IN mlan_status status)
+{
+	sim_handle *handle = (sim_handle *) pmoal_handle;
+
+	pthread_mutex_lock(&handle->work_lock);
+	handle->init_status = status;
+	handle->init_done = MTRUE;
+	pthread_cond_broadcast(&handle->idle_cond);
+	pthread_mutex_unlock(&handle->work_lock);
+	return MLAN_STATUS_SUCCESS;
+}
+
+/**
+ *  @brief This function records firmware shutdown completion
+ *
+ *  @param pmoal_handle Pointer to the MOAL context
+ *  @param status	Shutdown status
+ *
+ *  @return		MLAN_STATUS_SUCCESS
+ */
+static mlan_status
+sim_shutdown_fw_complete(IN t_void * pmoal_handle, IN mlan_status status)
+{
+	sim_handle *handle = (sim_handle *) pmoal_handle;
+
+	pthread_mutex_lock(&handle->work_lock);
+	handle->shutdown_done = MTRUE;
+	pthread_cond_broadcast(&handle->idle_cond);
+	pthread_mutex_unlock(&handle->work_lock);
+	return MLAN_STATUS_SUCCESS;
+}
+
+/**
+ *  @brief This function completes a Tx packet and frees it
+ *
+ *  @param pmoal_handle Pointer to the MOAL context
+ *  @param pmbuf	Pointer to the mlan buffer structure
+ *  @param status	The status code for mlan_send_packet request
+ *
+ *  @return		MLAN_STATUS_SUCCESS
+ */
+static mlan_status
+sim_send_packet_complete(IN t_void * pmoal_handle,
+			 IN pmlan_buffer pmbuf, IN mlan_status status)
+{
+	sim_handle *handle = (sim_handle *) pmoal_handle;
+
+	if (!pmbuf)
+		return MLAN_STATUS_SUCCESS;
+	pthread_mutex_lock(&handle->stats_lock);
+	if (status == MLAN_STATUS_SUCCESS)
+		handle->tx_done++;
+	else
+		handle->tx_failed++;
+	handle->mbuf_count--;
+	pthread_mutex_unlock(&handle->stats_lock);
+	free(pmbuf);
+	return MLAN_STATUS_SUCCESS;
+}
+
+/**
+ *  @brief This function is called on USB receive completion, it is
+ *  not used over SDIO
+ *
+ *  @param pmoal_handle Pointer to the MOAL context
+ *  @param pmbuf	Pointer to the mlan buffer structure
+ *  @param port		Port number
+ *  @param status	The status code
+ *
+ *  @return		MLAN_STATUS_SUCCESS
+ */
+static mlan_status
+sim_recv_complete(IN t_void * pmoal_handle,
+		  IN pmlan_buffer pmbuf, IN t_u32 port, IN mlan_status status)
+{
+	return MLAN_STATUS_SUCCESS;
+}
+
+/**
+ *  @brief This function consumes a received packet and checks its
+ *  ordering within its flow. MLAN frees the buffer.
+ *
+ *  @param pmoal_handle Pointer to the MOAL context
+ *  @param pmbuf	Pointer to the mlan buffer structure
+ *
+ *  @return		MLAN_STATUS_SUCCESS
+ */
+static mlan_status
+sim_recv_packet(IN t_void * pmoal_handle, IN pmlan_buffer pmbuf)
+{
+	sim_handle *handle = (sim_handle *) pmoal_handle;
+	sim_payload_tag tag;
+	t_u8 *frame;
+	t_u32 sta, tid;
+
+	if (!pmbuf)
+		return MLAN_STATUS_FAILURE;
+	frame = pmbuf->pbuf + pmbuf->data_offset;
+
+	pthread_mutex_lock(&handle->stats_lock);
+	handle->rx_pkts++;
+	handle->rx_bytes += pmbuf->data_len;
+	if (pmbuf->data_len < MLAN_MAC_ADDR_LENGTH * 2 + 2 ||
+	    sim_get_tag(frame + MLAN_MAC_ADDR_LENGTH * 2 + 2,
+			pmbuf->data_len - MLAN_MAC_ADDR_LENGTH * 2 - 2, &tag)) {
+		handle->rx_bad++;
+	} else {
+		sta = tag.flow >> 8;
+		tid = tag.flow & 0xff;
+		if (sta < SIM_MAX_STA && tid < SIM_MAX_TID)
+			sim_flow_check(&handle->rx_flow[sta][tid], tag.seq);
+		else
+			handle->rx_bad++;
+		if (handle->rx_log && handle->rx_log_len < handle->rx_log_size)
+			handle->rx_log[handle->rx_log_len++] = tag.seq;
+	}
+	pthread_mutex_unlock(&handle->stats_lock);
+	return MLAN_STATUS_SUCCESS;
+}
+
+/**
+ *  @brief This function handles MLAN events
+ *
+ *  @param pmoal_handle Pointer to the MOAL context
+ *  @param pmevent	Pointer to the mlan event structure
+ *
+ *  @return		MLAN_STATUS_SUCCESS
+ */
+static mlan_status
+sim_recv_event(IN t_void * pmoal_handle, IN pmlan_event pmevent)
+{
+	sim_handle *handle = (sim_handle *) pmoal_handle;
+
+	switch (pmevent->event_id) {
+	case MLAN_EVENT_ID_DRV_DEFER_HANDLING:
+		sim_queue_main_work(handle);
+		break;
+	case MLAN_EVENT_ID_DRV_DEFER_RX_WORK:
+		sim_queue_rx_work(handle);
+		break;
+	case MLAN_EVENT_ID_DRV_FLUSH_RX_WORK:
+		sim_flush_rx_work(handle);
+		break;
+	default:
+		pthread_mutex_lock(&handle->stats_lock);
+		handle->events++;
+		pthread_mutex_unlock(&handle->stats_lock);
+		if (handle->drvdbg & MEVENT)
+			printf("mlansim: event 0x%x bss %d len %d\n",
+			       pmevent->event_id, pmevent->bss_index,
+			       pmevent->event_len);
+		break;
+	}
+	return MLAN_STATUS_SUCCESS;
+}
+
+/**
+ *  @brief This function records ioctl completion
+ *
+ *  @param pmoal_handle Pointer to the MOAL context
+ *  @param pioctl_req	Pointer to the ioctl request
+ *  @param status	The status code
+ *
+ *  @return		MLAN_STATUS_SUCCESS
+ */
+static mlan_status
+sim_ioctl_complete(IN t_void * pmoal_handle,
+		   IN pmlan_ioctl_req pioctl_req, IN mlan_status status)
+{
+	sim_handle *handle = (sim_handle *) pmoal_handle;
+
+	pthread_mutex_lock(&handle->stats_lock);
+	handle->ioctls++;
+	pthread_mutex_unlock(&handle->stats_lock);
+	return MLAN_STATUS_SUCCESS;
+}
+
+/**
+ *  @brief This function allocates an mlan_buffer with a separate data
+ *  buffer, the pdesc stands in for the skb
+ *
+ *  @param pmoal_handle Pointer to the MOAL context
+ *  @param size		Data buffer size
+ *  @param pmbuf	Pointer to the allocated mlan_buffer
+ *
+ *  @return		MLAN_STATUS_SUCCESS or MLAN_STATUS_FAILURE
+ */
+static mlan_status
+sim_alloc_mlan_buffer(IN t_void * pmoal_handle,
+		      IN t_u32 size, OUT pmlan_buffer * pmbuf)
+{
+	sim_handle *handle = (sim_handle *) pmoal_handle;
+	pmlan_buffer mbuf;
+
+	if (handle->alloc_fail_size && size >= handle->alloc_fail_size) {
+		pthread_mutex_lock(&handle->stats_lock);
+		handle->alloc_failed++;
+		pthread_mutex_unlock(&handle->stats_lock);
+		return MLAN_STATUS_FAILURE;
+	}
+	mbuf = calloc(1, sizeof(mlan_buffer));
+	if (!mbuf)
+		return MLAN_STATUS_FAILURE;
+	mbuf->pdesc = malloc(size);
+	if (!mbuf->pdesc) {
+		free(mbuf);
+		return MLAN_STATUS_FAILURE;
+	}
+	mbuf->pbuf = mbuf->pdesc;
+	*pmbuf = mbuf;
+	pthread_mutex_lock(&handle->stats_lock);
+	handle->mbuf_count++;
+	pthread_mutex_unlock(&handle->stats_lock);
+	return MLAN_STATUS_SUCCESS;
+}
+
+/**
+ *  @brief This function frees an mlan_buffer
+ *
+ *  @param pmoal_handle Pointer to the MOAL context
+ *  @param pmbuf	Pointer to the mlan_buffer
+ *
+ *  @return		MLAN_STATUS_SUCCESS or MLAN_STATUS_FAILURE
+ */
+static mlan_status
+sim_free_mlan_buffer(IN t_void * pmoal_handle, IN pmlan_buffer pmbuf)
+{
+	sim_handle *handle = (sim_handle *) pmoal_handle;
+
+	if (!pmbuf)
+		return MLAN_STATUS_FAILURE;
+	free(pmbuf->pdesc);
+	free(pmbuf);
+	pthread_mutex_lock(&handle->stats_lock);
+	handle->mbuf_count--;
+	pthread_mutex_unlock(&handle->stats_lock);
+	return MLAN_STATUS_SUCCESS;
+}
+
+/**
+ *  @brief This function writes a card register
+ *
+ *  @param pmoal_handle Pointer to the MOAL context
+ *  @param reg		Register offset
+ *  @param data		Value
+ *
+ *  @return		MLAN_STATUS_SUCCESS or MLAN_STATUS_FAILURE
+ */
+static mlan_status
+sim_write_reg(IN t_void * pmoal_handle, IN t_u32 reg, IN t_u32 data)
+{
+	return sim_card_write_reg(((sim_handle *) pmoal_handle)->card, reg,
+				  data);
+}
+
+/**
+ *  @brief This function reads a card register
+ *
+ *  @param pmoal_handle Pointer to the MOAL context
+ *  @param reg		Register offset
+ *  @param data		Pointer to the value
+ *
+ *  @return		MLAN_STATUS_SUCCESS or MLAN_STATUS_FAILURE
+ */
+static mlan_status
+sim_read_reg(IN t_void * pmoal_handle, IN t_u32 reg, OUT t_u32 * data)
+{
+	return sim_card_read_reg(((sim_handle *) pmoal_handle)->card, reg,
+				 data);
+}
+
+/**
+ *  @brief This function writes a buffer to the card
+ *
+ *  @param pmoal_handle Pointer to the MOAL context
+ *  @param pmbuf	Pointer to the mlan buffer structure
+ *  @param port		Port number
+ *  @param timeout	Not used
+ *
+ *  @return		MLAN_STATUS_SUCCESS or MLAN_STATUS_FAILURE
+ */
+static mlan_status
+sim_write_data_sync(IN t_void * pmoal_handle,
+		    IN pmlan_buffer pmbuf, IN t_u32 port, IN t_u32 timeout)
+{
+	return sim_card_write_data(((sim_handle *) pmoal_handle)->card,
+				   pmbuf, port);
+}
+
+/**
+ *  @brief This function reads a buffer from the card
+ *
+ *  @param pmoal_handle Pointer to the MOAL context
+ *  @param pmbuf	Pointer to the mlan buffer structure
+ *  @param port		Port number
+ *  @param timeout	Not used
+ *
+ *  @return		MLAN_STATUS_SUCCESS or MLAN_STATUS_FAILURE
+ */
+static mlan_status
+sim_read_data_sync(IN t_void * pmoal_handle,
+		   IN OUT pmlan_buffer pmbuf, IN t_u32 port, IN t_u32 timeout)
+{
+	return sim_card_read_data(((sim_handle *) pmoal_handle)->card,
+				  pmbuf, port);
+}
+
+/**
+ *  @brief This function allocates memory
+ *
+ *  @param pmoal_handle Pointer to the MOAL context
+ *  @param size		Size
+ *  @param flag		Not used
+ *  @param ppbuf	Pointer to the allocated buffer
+ *
+ *  @return		MLAN_STATUS_SUCCESS or MLAN_STATUS_FAILURE
+ */
+static mlan_status
+sim_malloc(IN t_void * pmoal_handle,
+	   IN t_u32 size, IN t_u32 flag, OUT t_u8 ** ppbuf)
+{
+	sim_handle *handle = (sim_handle *) pmoal_handle;
+
+	*ppbuf = malloc(size);
+	if (!*ppbuf)
+		return MLAN_STATUS_FAILURE;
+	pthread_mutex_lock(&handle->stats_lock);
+	handle->malloc_count++;
+	pthread_mutex_unlock(&handle->stats_lock);
+	return MLAN_STATUS_SUCCESS;
+}
+
+/**
+ *  @brief This function frees memory
+ *
+ *  @param pmoal_handle Pointer to the MOAL context
+ *  @param pbuf		Buffer to free
+ *
+ *  @return		MLAN_STATUS_SUCCESS or MLAN_STATUS_FAILURE
+ */
+static mlan_status
+sim_mfree(IN t_void * pmoal_handle, IN t_u8 * pbuf)
+{
+	sim_handle *handle = (sim_handle *) pmoal_handle;
+
+	if (!pbuf)
+		return MLAN_STATUS_FAILURE;
+	free(pbuf);
+	pthread_mutex_lock(&handle->stats_lock);
+	handle->malloc_count--;
+	pthread_mutex_unlock(&handle->stats_lock);
+	return MLAN_STATUS_SUCCESS;
+}
+
+/**
+ *  @brief This function allocates virtual memory
+ *
+ *  @param pmoal_handle Pointer to the MOAL context
+ *  @param size		Size
+ *  @param ppbuf	Pointer to the allocated buffer
+ *
+ *  @return		MLAN_STATUS_SUCCESS or MLAN_STATUS_FAILURE
+ */
+static mlan_status
+sim_vmalloc(IN t_void * pmoal_handle, IN t_u32 size, OUT t_u8 ** ppbuf)
+{
+	return sim_malloc(pmoal_handle, size, MLAN_MEM_DEF, ppbuf);
+}
+
+/**
+ *  @brief This function frees virtual memory
+ *
+ *  @param pmoal_handle Pointer to the MOAL context
+ *  @param pbuf		Buffer to free
+ *
+ *  @return		MLAN_STATUS_SUCCESS or MLAN_STATUS_FAILURE
+ */
+static mlan_status
+sim_vfree(IN t_void * pmoal_handle, IN t_u8 * pbuf)
+{
+	return sim_mfree(pmoal_handle, pbuf);
+}
+
+/** memset callback */
+static t_void *
+sim_memset(IN t_void * pmoal_handle,
+	   IN t_void * pmem, IN t_u8 byte, IN t_u32 num)
+{
+	return memset(pmem, byte, num);
+}
+
+/** memcpy callback */
+static t_void *
+sim_memcpy(IN t_void * pmoal_handle,
+	   IN t_void * pdest, IN const t_void * psrc, IN t_u32 num)
+{
+	return memcpy(pdest, psrc, num);
+}
+
+/** memmove callback */
+static t_void *
+sim_memmove(IN t_void * pmoal_handle,
+	    IN t_void * pdest, IN const t_void * psrc, IN t_u32 num)
+{
+	return memmove(pdest, psrc, num);
+}
+
+/** memcmp callback */
+static t_s32
+sim_memcmp(IN t_void * pmoal_handle,
+	   IN const t_void * pmem1, IN const t_void * pmem2, IN t_u32 num)
+{
+	return memcmp(pmem1, pmem2, num);
+}
+
+/**
+ *  @brief This function delays. The simulated card answers every
+ *  access synchronously, so polling delays are not modelled.
+ *
+ *  @param pmoal_handle Pointer to the MOAL context
+ *  @param delay	Delay in usec
+ *
+ *  @return		N/A
+ */
+static t_void
+sim_udelay(IN t_void * pmoal_handle, IN t_u32 delay)
+{
+	return;
+}
+
+/**
+ *  @brief This function gets the system time
+ *
+ *  @param pmoal_handle Pointer to the MOAL context
+ *  @param psec		Pointer to seconds
+ *  @param pusec	Pointer to microseconds
+ *
+ *  @return		MLAN_STATUS_SUCCESS
+ */
+static mlan_status
+sim_get_system_time(IN t_void * pmoal_handle,
+		    OUT t_u32 * psec, OUT t_u32 * pusec)
+{
+	struct timeval t;
+
+	gettimeofday(&t, NULL);
+	*psec = (t_u32) t.tv_sec;
+	*pusec = (t_u32) t.tv_usec;
+	return MLAN_STATUS_SUCCESS;
+}
+
+/**
+ *  @brief This function creates a timer
+ *
+ *  @param pmoal_handle Pointer to the MOAL context
+ *  @param pptimer	Pointer to the timer
+ *  @param callback	Timer function
+ *  @param pcontext	Timer function context
+ *
+ *  @return		MLAN_STATUS_SUCCESS or MLAN_STATUS_FAILURE
+ */
+static mlan_status
+sim_init_timer(IN t_void * pmoal_handle,
+	       OUT t_void ** pptimer,
+	       IN t_void(*callback) (t_void * pcontext), IN t_void * pcontext)
+{
+	sim_timer *ptimer;
+
+	ptimer = calloc(1, sizeof(sim_timer));
+	if (!ptimer)
+		return MLAN_STATUS_FAILURE;
+	ptimer->callback = callback;
+	ptimer->pcontext = pcontext;
+	pthread_mutex_lock(&timer_lock);
+	ptimer->pnext = timer_list;
+	timer_list = ptimer;
+	pthread_mutex_unlock(&timer_lock);
+	*pptimer = ptimer;
+	return MLAN_STATUS_SUCCESS;
+}
+
+/**
+ *  @brief This function frees a timer, waiting for its function if
+ *  it is running
+ *
+ *  @param pmoal_handle Pointer to the MOAL context
+ *  @param ptimer	Pointer to the timer
+ *
+ *  @return		MLAN_STATUS_SUCCESS
+ */
+static mlan_status
+sim_free_timer(IN t_void * pmoal_handle, IN t_void * ptimer)
+{
+	sim_timer **pprev;
+
+	if (!ptimer)
+		return MLAN_STATUS_SUCCESS;
+	pthread_mutex_lock(&timer_lock);
+	while (timer_running == ptimer &&
+	       !pthread_equal(pthread_self(), timer_thread))
+		pthread_cond_wait(&timer_cond, &timer_lock);
+	for (pprev = &timer_list; *pprev; pprev = &(*pprev)->pnext) {
+		if (*pprev == ptimer) {
+			*pprev = ((sim_timer *) ptimer)->pnext;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&timer_lock);
+	free(ptimer);
+	return MLAN_STATUS_SUCCESS;
+}
+
+/**
+ *  @brief This function arms a timer
+ *
+ *  @param pmoal_handle Pointer to the MOAL context
+ *  @param ptimer	Pointer to the timer
+ *  @param periodic	Periodic timer
+ *  @param msec		Timeout in msec
+ *
+ *  @return		MLAN_STATUS_SUCCESS
+ */
+static mlan_status
+sim_start_timer(IN t_void * pmoal_handle,
+		IN t_void * ptimer, IN t_u8 periodic, IN t_u32 msec)
+{
+	sim_timer *t = (sim_timer *) ptimer;
+
+	pthread_mutex_lock(&timer_lock);
+	t->msec = msec / timer_scale;
+	t->periodic = periodic;
+	sim_time_after(&t->expires, t->msec);
+	t->active = MTRUE;
+	pthread_cond_broadcast(&timer_cond);
+	pthread_mutex_unlock(&timer_lock);
+	return MLAN_STATUS_SUCCESS;
+}
+
+/**
+ *  @brief This function disarms a timer
+ *
+ *  @param pmoal_handle Pointer to the MOAL context
+ *  @param ptimer	Pointer to the timer
+ *
+ *  @return		MLAN_STATUS_SUCCESS
+ */
+static mlan_status
+sim_stop_timer(IN t_void * pmoal_handle, IN t_void * ptimer)
+{
+	pthread_mutex_lock(&timer_lock);
+	((sim_timer *) ptimer)->active = MFALSE;
+	pthread_mutex_unlock(&timer_lock);
+	return MLAN_STATUS_SUCCESS;
+}
+
+/**
+ *  @brief This function creates a lock
+ *
+ *  @param pmoal_handle Pointer to the MOAL context
+ *  @param pplock	Pointer to the lock
+ *
+ *  @return		MLAN_STATUS_SUCCESS or MLAN_STATUS_FAILURE
+ */
+static mlan_status
+sim_init_lock(IN t_void * pmoal_handle, OUT t_void ** pplock)
+{
+	pthread_mutex_t *plock;
+
+	plock = malloc(sizeof(pthread_mutex_t));
+	if (!plock)
+		return MLAN_STATUS_FAILURE;
+	pthread_mutex_init(plock, NULL);
+	*pplock = plock;
+	return MLAN_STATUS_SUCCESS;
+}
+
+/**
+ *  @brief This function frees a lock
+ *
+ *  @param pmoal_handle Pointer to the MOAL context
+ *  @param plock	Pointer to the lock
+ *
+ *  @return		MLAN_STATUS_SUCCESS
+ */
+static mlan_status
+sim_free_lock(IN t_void * pmoal_handle, IN t_void * plock)
+{
+	if (plock) {
+		pthread_mutex_destroy(plock);
+		free(plock);
+	}
+	return MLAN_STATUS_SUCCESS;
+}
+
+/** spin_lock callback */
+static mlan_status
+sim_spin_lock(IN t_void * pmoal_handle, IN t_void * plock)
+{
+	if (plock)
+		pthread_mutex_lock(plock);
+	return MLAN_STATUS_SUCCESS;
+}
+
+/** spin_unlock callback */
+static mlan_status
+sim_spin_unlock(IN t_void * pmoal_handle, IN t_void * plock)
+{
+	if (plock)
+		pthread_mutex_unlock(plock);
+	return MLAN_STATUS_SUCCESS;
+}
+
+/**
+ *  @brief This function prints MLAN debug messages enabled in drvdbg
+ *
+ *  @param pmoal_handle Pointer to the MOAL context
+ *  @param level	Debug level
+ *  @param pformat	Format string
+ *
+ *  @return		N/A
+ */
+static t_void
+sim_print(IN t_void * pmoal_handle, IN t_u32 level, IN char *pformat, IN ...)
+{
+	sim_handle *handle = (sim_handle *) pmoal_handle;
+	va_list args;
+	t_u8 *buf;
+	int len, i;
+
+	if (!handle || !(handle->drvdbg & level & ~MHEX_DUMP))
+		return;
+	va_start(args, pformat);
+	if (level & MHEX_DUMP) {
+		buf = va_arg(args, t_u8 *);
+		len = va_arg(args, int);
+		printf("%s", pformat);
+		for (i = 0; i < len; i++)
+			printf("%s%02x", (i % 16) ? " " : "\n", buf[i]);
+		printf("\n");
+	} else {
+		vprintf(pformat, args);
+	}
+	va_end(args);
+}
+
+/** print_netintf callback */
+static t_void
+sim_print_netintf(IN t_void * pmoal_handle, IN t_u32 bss_index,
+		  IN t_u32 level)
+{
+	return;
+}
+
+/**
+ *  @brief This function counts failed MLAN assertions
+ *
+ *  @param pmoal_handle Pointer to the MOAL context
+ *  @param cond		Condition
+ *
+ *  @return		N/A
+ */
+static t_void
+sim_assert(IN t_void * pmoal_handle, IN t_u32 cond)
+{
+	sim_handle *handle = (sim_handle *) pmoal_handle;
+
+	if (cond)
+		return;
+	printf("mlansim: MLAN assertion failed\n");
+	if (handle) {
+		pthread_mutex_lock(&handle->stats_lock);
+		handle->asserts++;
+		pthread_mutex_unlock(&handle->stats_lock);
+	}
+}
+
+/** tcp_ack_tx_ind callback */
+static t_void
+sim_tcp_ack_tx_ind(IN t_void * pmoal_handle, IN pmlan_buffer pmbuf)
+{
+	return;
+}
+
+/********************************************************
+		Global Variables
+********************************************************/
+
+/** Callback table of the harness */
+mlan_callbacks sim_callbacks = {
+	.moal_get_fw_data = sim_get_fw_data,
+	.moal_init_fw_complete = sim_init_fw_complete,
+	.moal_shutdown_fw_complete = sim_shutdown_fw_complete,
+	.moal_send_packet_complete = sim_send_packet_complete,
+	.moal_recv_complete = sim_recv_complete,
+	.moal_recv_packet = sim_recv_packet,
+	.moal_recv_event = sim_recv_event,
+	.moal_ioctl_complete = sim_ioctl_complete,
+	.moal_alloc_mlan_buffer = sim_alloc_mlan_buffer,
+	.moal_free_mlan_buffer = sim_free_mlan_buffer,
+
+	.moal_write_reg = sim_write_reg,
+	.moal_read_reg = sim_read_reg,
+	.moal_write_data_sync = sim_write_data_sync,
+	.moal_read_data_sync = sim_read_data_sync,
+	.moal_malloc = sim_malloc,
+	.moal_mfree = sim_mfree,
+	.moal_vmalloc = sim_vmalloc,
+	.moal_vfree = sim_vfree,
+	.moal_memset = sim_memset,
+	.moal_memcpy = sim_memcpy,
+	.moal_memmove = sim_memmove,
+	.moal_memcmp = sim_memcmp,
+	.moal_udelay = sim_udelay,
+	.moal_get_system_time = sim_get_system_time,
+	.moal_init_timer = sim_init_timer,
+	.moal_free_timer = sim_free_timer,
+	.moal_start_timer = sim_start_timer,
+	.moal_stop_timer = sim_stop_timer,
+	.moal_init_lock = sim_init_lock,
+	.moal_free_lock = sim_free_lock,
+	.moal_spin_lock = sim_spin_lock,
+	.moal_spin_unlock = sim_spin_unlock,
+	.moal_print = sim_print,
+	.moal_print_netintf = sim_print_netintf,
+	.moal_assert = sim_assert,
+	.moal_tcp_ack_tx_ind = sim_tcp_ack_tx_ind,
+};
+
+/********************************************************
+		Global Functions
+********************************************************/
+
+/**
+ *  @brief This function starts the timer and work threads
+ *
+ *  @param handle	A pointer to sim_handle
+ *  @param rx_work	Start the Rx work thread
+ *
+ *  @return		0 or -1
+ */
+int
+sim_start_threads(sim_handle * handle, t_u8 rx_work)
+{
+	pthread_mutex_init(&handle->work_lock, NULL);
+	pthread_mutex_init(&handle->stats_lock, NULL);
+	sim_cond_init(&handle->work_cond);
+	sim_cond_init(&handle->idle_cond);
+	sim_cond_init(&timer_cond);
+	if (handle->timer_scale)
+		timer_scale = handle->timer_scale;
+
+	timer_stop = MFALSE;
+	if (pthread_create(&timer_thread, NULL, sim_timer_thread, NULL))
+		return -1;
+	if (pthread_create(&handle->main_thread, NULL, sim_main_thread,
+			   handle))
+		return -1;
+	if (rx_work &&
+	    pthread_create(&handle->rx_thread, NULL, sim_rx_thread, handle))
+		return -1;
+	return 0;
+}
+
+/**
+ *  @brief This function stops the timer and work threads
+ *
+ *  @param handle	A pointer to sim_handle
+ *
+ *  @return		N/A
+ */
+void
+sim_stop_threads(sim_handle * handle)
+{
+	pthread_mutex_lock(&handle->work_lock);
+	handle->stop = MTRUE;
+	pthread_cond_broadcast(&handle->work_cond);
+	pthread_cond_broadcast(&handle->idle_cond);
+	pthread_mutex_unlock(&handle->work_lock);
+	pthread_join(handle->main_thread, NULL);
+	if (handle->rx_thread)
+		pthread_join(handle->rx_thread, NULL);
+
+	pthread_mutex_lock(&timer_lock);
+	timer_stop = MTRUE;
+	pthread_cond_broadcast(&timer_cond);
+	pthread_mutex_unlock(&timer_lock);
+	pthread_join(timer_thread, NULL);
+}
+
+/**
+ *  @brief This function queues the main work
+ *
+ *  @param handle	A pointer to sim_handle
+ *
+ *  @return		N/A
+ */
+void
+sim_queue_main_work(sim_handle * handle)
+{
+	pthread_mutex_lock(&handle->work_lock);
+	handle->main_work = MTRUE;
+	pthread_cond_broadcast(&handle->work_cond);
+	pthread_mutex_unlock(&handle->work_lock);
+}
+
+/**
+ *  @brief The card interrupt, the main work thread reads the
+ *  interrupt status before running MLAN
+ *
+ *  @param ctx		A pointer to sim_handle
+ *
+ *  @return		N/A
+ */
+void
+sim_irq(void *ctx)
+{
+	sim_handle *handle = (sim_handle *) ctx;
+
+	pthread_mutex_lock(&handle->work_lock);
+	handle->irq_pending = MTRUE;
+	pthread_cond_broadcast(&handle->work_cond);
+	pthread_mutex_unlock(&handle->work_lock);
+}
+
+/**
+ *  @brief This function waits until the work threads are idle, the
+ *  card has nothing left to upload and every Tx packet is completed
+ *
+ *  @param handle	A pointer to sim_handle
+ *
+ *  @return		0 or -1 on timeout
+ */
+int
+sim_wait_idle(sim_handle * handle)
+{
+	struct timespec deadline, ts;
+	int tx_pending;
+
+	sim_time_after(&deadline, SIM_IDLE_TIMEOUT);
+	while (MTRUE) {
+		pthread_mutex_lock(&handle->work_lock);
+		while (sim_work_pending(handle) && !handle->stop) {
+			if (pthread_cond_timedwait(&handle->idle_cond,
+						   &handle->work_lock,
+						   &deadline) == ETIMEDOUT)
+				break;
+		}
+		pthread_mutex_unlock(&handle->work_lock);
+
+		pthread_mutex_lock(&handle->stats_lock);
+		tx_pending = handle->tx_submitted !=
+			handle->tx_done + handle->tx_failed;
+		pthread_mutex_unlock(&handle->stats_lock);
+
+		if (!tx_pending && !sim_card_busy(handle->card)) {
+			pthread_mutex_lock(&handle->work_lock);
+			if (!sim_work_pending(handle)) {
+				pthread_mutex_unlock(&handle->work_lock);
+				return 0;
+			}
+			pthread_mutex_unlock(&handle->work_lock);
+		}
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		if (sim_time_before(&deadline, &ts))
+			return -1;
+		usleep(1000);
+	}
+}
+
+/**
+ *  @brief This function allocates a Tx packet the way MOAL lays out
+ *  an skb, with the mlan_buffer and the Tx headroom in front of the data
+ *
+ *  @param handle	A pointer to sim_handle
+ *  @param len		Packet length
+ *
+ *  @return		A pointer to mlan_buffer or NULL
+ */
+pmlan_buffer
+sim_alloc_tx_buffer(sim_handle * handle, t_u32 len)
+{
+	pmlan_buffer pmbuf;
+
+	pmbuf = calloc(1, sizeof(mlan_buffer) + MLAN_MIN_DATA_HEADER_LEN +
+		       DMA_ALIGNMENT + len);
+	if (!pmbuf)
+		return NULL;
+	pmbuf->pdesc = pmbuf;
+	pmbuf->pbuf = (t_u8 *) (pmbuf + 1);
+	pmbuf->data_offset = MLAN_MIN_DATA_HEADER_LEN;
+	pmbuf->data_len = len;
+	pmbuf->buf_type = MLAN_BUF_TYPE_DATA;
+	pthread_mutex_lock(&handle->stats_lock);
+	handle->mbuf_count++;
+	pthread_mutex_unlock(&handle->stats_lock);
+	return pmbuf;
+}
+
+/**
+ *  @brief This function holds the timers, or lets them expire again.
+ *  A held timer stays armed until sim_fire_timer runs it.
+ *
+ *  @param hold		MTRUE to hold
+ *
+ *  @return		N/A
+ */
+void
+sim_hold_timers(t_u8 hold)
+{
+	pthread_mutex_lock(&timer_lock);
+	timer_hold = hold;
+	pthread_cond_broadcast(&timer_cond);
+	pthread_mutex_unlock(&timer_lock);
+}
+
+/**
+ *  @brief This function runs the function of an armed timer now, in
+ *  the context of the caller, as if it had expired
+ *
+ *  @param ptimer	Pointer to the timer
+ *
+ *  @return		MTRUE if the timer was armed
+ */
+int
+sim_fire_timer(t_void * ptimer)
+{
+	sim_timer *t = (sim_timer *) ptimer;
+
+	if (!t)
+		return MFALSE;
+	pthread_mutex_lock(&timer_lock);
+	if (!t->active) {
+		pthread_mutex_unlock(&timer_lock);
+		return MFALSE;
+	}
+	if (t->periodic)
+		sim_time_after(&t->expires, t->msec);
+	else
+		t->active = MFALSE;
+	timer_running = t;
+	pthread_mutex_unlock(&timer_lock);
+	t->callback(t->pcontext);
+	pthread_mutex_lock(&timer_lock);
+	timer_running = NULL;
+	pthread_cond_broadcast(&timer_cond);
+	pthread_mutex_unlock(&timer_lock);
+	return MTRUE;
+}
+
+/**
+ *  @brief This function reads the harness tag from a payload
+ *
+ *  @param payload	A pointer to the payload
+ *  @param len		Payload length
+ *  @param tag		A pointer to the tag to fill
+ *
+ *  @return		0 or -1 if there is no tag
+ */
+int
+sim_get_tag(t_u8 * payload, t_u32 len, sim_payload_tag * tag)
+{
+	if (len < SIM_PAYLOAD_MIN_LEN)
+		return -1;
+	memcpy(tag, payload, sizeof(sim_payload_tag));
+	if (tag->magic != SIM_PAYLOAD_MAGIC)
+		return -1;
+	return 0;
+}
+
+/**
+ *  @brief This function checks a sequence number against the flow
+ *
+ *  @param flow		A pointer to sim_flow
+ *  @param seq		Sequence number of the packet
+ *
+ *  @return		N/A
+ */
+void
+sim_flow_check(sim_flow * flow, t_u32 seq)
+{
+	flow->pkts++;
+	if (seq != flow->next_seq)
+		flow->out_of_order++;
+	if (seq >= flow->next_seq)
+		flow->next_seq = seq + 1;
+}
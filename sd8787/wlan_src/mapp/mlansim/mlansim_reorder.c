@@ -0,0 +1,630 @@
+/** @file  mlansim_reorder.c
+  *
+  * @brief Rx reorder replay for the userspace MLAN harness. Sequence
+  * number traces are handed to mlan_11n_rxreorder_pkt() directly and
+  * the dispatch order is checked against a reference model: the plain
+  * slot by slot window, rotated on every advance, that the driver used
+  * before its table lookup was hashed and its window made circular.
+  *
+  * Copyright (C) 2011-2012, Marvell International Ltd.
+  *
+  * This software file (the "File") is distributed by Marvell International
+  * Ltd. under the terms of the GNU General Public License Version 2, June 1991
+  * (the "License").  You may use, redistribute and/or modify this File in
+  * accordance with the terms and conditions of the License, a copy of which
+  * is available by writing to the Free Software Foundation, Inc.,
+  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA or on the
+  * worldwide web at http://www.gnu.org/licenses/old-licenses/gpl-2.0.txt.
+  *
+  * THE FILE IS DISTRIBUTED AS-IS, WITHOUT WARRANTY OF ANY KIND, AND THE
+  * IMPLIED WARRANTIES OF MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE
+  * ARE EXPRESSLY DISCLAIMED.  The License provides additional details about
+  * this warranty disclaimer.
+  *
+  */
+/************************************************************************
+Change log:
+     10/17/2012: initial version
+************************************************************************/
+
+#include    "mlansim.h"
+
+#include    "mlan_join.h"
+#include    "mlan_util.h"
+#include    "mlan_fw.h"
+#include    "mlan_main.h"
+#include    "mlan_11n_rxreorder.h"
+
+/* mlan_main.h wraps these around the MOAL callbacks */
+#undef memset
+#undef memcpy
+#undef memmove
+#undef memcmp
+
+/** Trace event: data packet */
+#define SIM_REORDER_PKT		0
+/** Trace event: block ack request */
+#define SIM_REORDER_BAR		1
+/** Trace event: reorder flush timer expiry */
+#define SIM_REORDER_TIMER	2
+
+/** Ethernet frame length of the replayed packets */
+#define SIM_REORDER_FRAME_LEN	64
+
+/** Reference reorder table of a flow */
+typedef struct _sim_ref_tbl {
+    /** Block ack agreement requested */
+	t_u8 setup;
+    /** Driver accepted the agreement, packets are reordered */
+	t_u8 valid;
+    /** Flush timer armed */
+	t_u8 timer_set;
+    /** Window start */
+	int start_win;
+    /** Window size */
+	int win_size;
+    /** Event index + 1 buffered in each slot, 0 for a hole */
+	t_u32 *slot;
+    /** Next new sequence number of the trace generator */
+	int next;
+} sim_ref_tbl;
+
+/** Trace event */
+typedef struct _sim_reorder_event {
+    /** Station index */
+	t_u8 sta;
+    /** TID */
+	t_u8 tid;
+    /** SIM_REORDER_PKT, SIM_REORDER_BAR or SIM_REORDER_TIMER */
+	t_u8 type;
+    /** Sequence number */
+	t_u16 seq;
+    /** Payload, NULL for a timer */
+	pmlan_buffer pmbuf;
+} sim_reorder_event;
+
+/********************************************************
+			Local Variables
+********************************************************/
+
+/** Reference tables */
+static sim_ref_tbl ref_tbl[SIM_MAX_STA][SIM_MAX_TID];
+/** Trace of the next replay */
+static sim_reorder_event *trace;
+/** Number of events in the trace */
+static t_u32 trace_len;
+/** Event indexes in the order the model dispatches them */
+static t_u32 *expect_log;
+/** Number of entries in expect_log */
+static t_u32 expect_len;
+/** Packets the model drops */
+static t_u32 expect_dropped;
+
+/********************************************************
+			Local Functions
+********************************************************/
+
+/**
+ *  @brief Records a packet the model hands to the host
+ *
+ *  @param id		Event index + 1
+ *
+ *  @return		N/A
+ */
+static void
+ref_dispatch(t_u32 id)
+{
+	expect_log[expect_len++] = id - 1;
+}
+
+/**
+ *  @brief Model of wlan_11n_dispatch_pkt_until_start_win()
+ *
+ *  @param tbl		A pointer to sim_ref_tbl
+ *  @param start_win	New window start
+ *
+ *  @return		N/A
+ */
+static void
+ref_dispatch_until(sim_ref_tbl * tbl, int start_win)
+{
+	int n, i;
+
+	n = (start_win > tbl->start_win) ?
+		MIN(start_win - tbl->start_win, tbl->win_size) : tbl->win_size;
+	for (i = 0; i < n; i++) {
+		if (tbl->slot[i])
+			ref_dispatch(tbl->slot[i]);
+	}
+	memmove(tbl->slot, tbl->slot + n,
+		(tbl->win_size - n) * sizeof(tbl->slot[0]));
+	memset(tbl->slot + tbl->win_size - n, 0, n * sizeof(tbl->slot[0]));
+	tbl->start_win = start_win;
+}
+
+/**
+ *  @brief Model of wlan_11n_scan_and_dispatch()
+ *
+ *  @param tbl		A pointer to sim_ref_tbl
+ *
+ *  @return		N/A
+ */
+static void
+ref_scan_and_dispatch(sim_ref_tbl * tbl)
+{
+	int i;
+
+	for (i = 0; i < tbl->win_size && tbl->slot[i]; i++)
+		ref_dispatch(tbl->slot[i]);
+	memmove(tbl->slot, tbl->slot + i,
+		(tbl->win_size - i) * sizeof(tbl->slot[0]));
+	memset(tbl->slot + tbl->win_size - i, 0, i * sizeof(tbl->slot[0]));
+	tbl->start_win = (tbl->start_win + i) & (MAX_TID_VALUE - 1);
+}
+
+/**
+ *  @brief Model of wlan_flush_data()
+ *
+ *  @param tbl		A pointer to sim_ref_tbl
+ *
+ *  @return		N/A
+ */
+static void
+ref_flush(sim_ref_tbl * tbl)
+{
+	int last;
+
+	for (last = tbl->win_size - 1; last >= 0 && !tbl->slot[last]; last--)
+		;
+	if (last >= 0)
+		ref_dispatch_until(tbl, (tbl->start_win + last + 1) &
+				   (MAX_TID_VALUE - 1));
+}
+
+/**
+ *  @brief Model of mlan_11n_rxreorder_pkt() for a table created by
+ *  ADDBA, with no previous sequence number and no forced delivery
+ *
+ *  @param tbl		A pointer to sim_ref_tbl
+ *  @param seq_num	Sequence number
+ *  @param bar		Block ack request
+ *  @param id		Event index + 1
+ *
+ *  @return		0, or -1 when the packet is dropped
+ */
+static int
+ref_rxreorder_pkt(sim_ref_tbl * tbl, int seq_num, t_u8 bar, t_u32 id)
+{
+	int start_win, end_win, win_size, slot;
+	int ret = 0;
+
+	if (!tbl->valid) {
+		if (!bar)
+			ref_dispatch(id);
+		return 0;
+	}
+	start_win = tbl->start_win;
+	win_size = tbl->win_size;
+	end_win = ((start_win + win_size) - 1) & (MAX_TID_VALUE - 1);
+
+	if (!bar) {
+		if ((start_win + TWOPOW11) > (MAX_TID_VALUE - 1)) {
+			if (seq_num >= ((start_win + TWOPOW11) &
+					(MAX_TID_VALUE - 1)) &&
+			    seq_num < start_win) {
+				ret = -1;
+				goto done;
+			}
+		} else if (seq_num < start_win ||
+			   seq_num > start_win + TWOPOW11) {
+			ret = -1;
+			goto done;
+		}
+	}
+	if (bar)
+		seq_num = ((seq_num + win_size) - 1) & (MAX_TID_VALUE - 1);
+
+	if (((end_win < start_win) &&
+	     (seq_num < start_win) && (seq_num > end_win))
+	    || ((end_win > start_win) &&
+		((seq_num > end_win) || (seq_num < start_win)))) {
+		end_win = seq_num;
+		if (((seq_num - win_size) + 1) >= 0)
+			start_win = (end_win - win_size) + 1;
+		else
+			start_win = (MAX_TID_VALUE - (win_size - seq_num)) + 1;
+		ref_dispatch_until(tbl, start_win);
+	}
+
+	if (!bar) {
+		if (seq_num >= start_win)
+			slot = seq_num - start_win;
+		else
+			slot = (seq_num + MAX_TID_VALUE) - start_win;
+		if (tbl->slot[slot]) {
+			ret = -1;
+			goto done;
+		}
+		tbl->slot[slot] = id;
+	}
+	ref_scan_and_dispatch(tbl);
+done:
+	tbl->timer_set = MTRUE;
+	return ret;
+}
+
+/**
+ *  @brief Allocates the payload of a replayed packet: a uAP RxPD and
+ *  a frame to the uAP carrying the harness tag
+ *
+ *  @param pmadapter	A pointer to mlan_adapter
+ *  @param priv		A pointer to the uAP mlan_private
+ *  @param card		A pointer to sim_card
+ *  @param ev		A pointer to the trace event
+ *  @param id		Event index, the tag sequence number
+ *
+ *  @return		A pointer to mlan_buffer or MNULL
+ */
+static pmlan_buffer
+sim_reorder_payload(mlan_adapter * pmadapter, mlan_private * priv,
+		    sim_card * card, sim_reorder_event * ev, t_u32 id)
+{
+	pmlan_buffer pmbuf;
+	UapRxPD *prx_pd;
+	sim_payload_tag tag;
+	t_u8 *frame;
+
+	pmbuf = wlan_alloc_mlan_buffer(pmadapter,
+				       sizeof(UapRxPD) + SIM_REORDER_FRAME_LEN,
+				       0, MOAL_ALLOC_MLAN_BUFFER);
+	if (!pmbuf)
+		return MNULL;
+	pmbuf->bss_index = priv->bss_index;
+	pmbuf->buf_type = MLAN_BUF_TYPE_DATA;
+	pmbuf->priority = ev->tid;
+	pmbuf->data_len = sizeof(UapRxPD) + SIM_REORDER_FRAME_LEN;
+
+	prx_pd = (UapRxPD *) (pmbuf->pbuf + pmbuf->data_offset);
+	memset(prx_pd, 0, pmbuf->data_len);
+	prx_pd->bss_type = MLAN_BSS_TYPE_UAP;
+	prx_pd->rx_pkt_length = SIM_REORDER_FRAME_LEN;
+	prx_pd->rx_pkt_offset = sizeof(UapRxPD);
+	prx_pd->seq_num = ev->seq;
+	prx_pd->priority = ev->tid;
+	if (ev->type == SIM_REORDER_BAR)
+		prx_pd->rx_pkt_type = PKT_TYPE_BAR;
+
+	frame = (t_u8 *) (prx_pd + 1);
+	memcpy(frame, card->mac_addr, MLAN_MAC_ADDR_LENGTH);
+	memcpy(frame + MLAN_MAC_ADDR_LENGTH,
+	       card->sta_addr[ev->sta], MLAN_MAC_ADDR_LENGTH);
+	frame[MLAN_MAC_ADDR_LENGTH * 2] = 0x08;
+	frame[MLAN_MAC_ADDR_LENGTH * 2 + 1] = 0x00;
+	tag.magic = SIM_PAYLOAD_MAGIC;
+	tag.flow = (ev->sta << 8) | ev->tid;
+	tag.seq = id;
+	memcpy(frame + MLAN_MAC_ADDR_LENGTH * 2 + 2, &tag,
+	       sizeof(tag));
+	return pmbuf;
+}
+
+/**
+ *  @brief Requests block ack for the flows of the first peers that
+ *  have not asked for it yet, then sets up their reference tables
+ *  from the tables the driver created
+ *
+ *  @param handle	A pointer to sim_handle
+ *  @param card		A pointer to sim_card
+ *  @param priv		A pointer to the uAP mlan_private
+ *  @param peers	Number of peers
+ *
+ *  @return		0 or -1
+ */
+static int
+sim_reorder_setup(sim_handle * handle, sim_card * card,
+		  mlan_private * priv, t_u32 peers)
+{
+	RxReorderTbl *rx_reor_tbl_ptr;
+	sim_ref_tbl *tbl;
+	t_u32 sta, tid, ssn;
+
+	for (sta = 0; sta < peers; sta++) {
+		for (tid = 0; tid < SIM_MAX_TID; tid++) {
+			if (ref_tbl[sta][tid].setup)
+				continue;
+			/* Start close to the wrap of the sequence space */
+			ssn = MAX_TID_VALUE - 96 + (sta * SIM_MAX_TID + tid) % 64;
+			pthread_mutex_lock(&card->lock);
+			card->rx_next[sta][tid] = ssn;
+			pthread_mutex_unlock(&card->lock);
+			if (sim_card_addba(card, sta, tid, 0))
+				return -1;
+		}
+	}
+	if (sim_wait_idle(handle))
+		return -1;
+
+	for (sta = 0; sta < peers; sta++) {
+		for (tid = 0; tid < SIM_MAX_TID; tid++) {
+			tbl = &ref_tbl[sta][tid];
+			if (tbl->setup)
+				continue;
+			tbl->setup = MTRUE;
+			tbl->next = card->rx_next[sta][tid];
+			rx_reor_tbl_ptr = wlan_11n_get_rxreorder_tbl(priv, tid,
+								     card->
+								     sta_addr
+								     [sta]);
+			if (!rx_reor_tbl_ptr)
+				continue;
+			tbl->slot = calloc(rx_reor_tbl_ptr->win_size,
+					   sizeof(tbl->slot[0]));
+			if (!tbl->slot)
+				return -1;
+			tbl->valid = MTRUE;
+			tbl->start_win = rx_reor_tbl_ptr->start_win;
+			tbl->win_size = rx_reor_tbl_ptr->win_size;
+		}
+	}
+	return 0;
+}
+
+/**
+ *  @brief Frees the trace and the payloads not replayed
+ *
+ *  @param pmadapter	A pointer to mlan_adapter
+ *
+ *  @return		N/A
+ */
+static void
+sim_reorder_free_trace(mlan_adapter * pmadapter)
+{
+	t_u32 i;
+
+	for (i = 0; i < trace_len; i++) {
+		if (trace[i].pmbuf)
+			wlan_free_mlan_buffer(pmadapter, trace[i].pmbuf);
+	}
+	free(trace);
+	free(expect_log);
+	trace = NULL;
+	expect_log = NULL;
+	trace_len = expect_len = expect_dropped = 0;
+}
+
+/********************************************************
+			Global Functions
+********************************************************/
+
+/**
+ *  @brief This function builds a trace for the next replay and runs it
+ *  through the reference model. Block ack is requested for the flows
+ *  of the first peers, all TIDs, then events go to random flows: in
+ *  order, swapped with the next, after a loss, late or duplicate,
+ *  beyond the window, block ack requests and flush timer expiries.
+ *  With inorder every event is the next packet of its flow. The trace
+ *  ends with a timer expiry on every flow so nothing stays buffered.
+ *
+ *  @param handle	A pointer to sim_handle
+ *  @param card		A pointer to sim_card
+ *  @param peers	Number of peers
+ *  @param count	Number of events before the final expiries
+ *  @param inorder	Only in order packets
+ *  @param seed		Random seed
+ *
+ *  @return		0 or -1
+ */
+int
+sim_reorder_trace(sim_handle * handle, sim_card * card, t_u32 peers,
+		  t_u32 count, t_u8 inorder, t_u32 seed)
+{
+	mlan_adapter *pmadapter = (mlan_adapter *) handle->pmlan_adapter;
+	mlan_private *priv;
+	sim_reorder_event *ev;
+	sim_ref_tbl *tbl;
+	t_u32 i, sta, tid, total, r;
+
+	if (!pmadapter || !peers || peers > card->sta_num)
+		return -1;
+	priv = wlan_get_priv(pmadapter, MLAN_BSS_ROLE_UAP);
+	if (!priv)
+		return -1;
+	sim_reorder_free_trace(pmadapter);
+	if (sim_reorder_setup(handle, card, priv, peers))
+		return -1;
+
+	total = count + peers * SIM_MAX_TID;
+	trace = calloc(total, sizeof(sim_reorder_event));
+	expect_log = calloc(total, sizeof(t_u32));
+	if (!trace || !expect_log) {
+		sim_reorder_free_trace(pmadapter);
+		return -1;
+	}
+
+	for (i = 0; i < total; i++) {
+		ev = &trace[i];
+		if (i < count) {
+			r = rand_r(&seed);
+			sta = (r >> 8) % peers;
+			tid = (r >> 16) % SIM_MAX_TID;
+			r = inorder ? 0 : (r & 0xff) % 100;
+		} else {
+			sta = (i - count) / SIM_MAX_TID;
+			tid = (i - count) % SIM_MAX_TID;
+			r = 100;
+		}
+		tbl = &ref_tbl[sta][tid];
+		ev->sta = sta;
+		ev->tid = tid;
+		ev->type = SIM_REORDER_PKT;
+		if (r < 55) {
+			/* next in order */
+			ev->seq = tbl->next++;
+		} else if (r < 67 && i + 1 < count) {
+			/* the next one arrived first */
+			ev->seq = tbl->next + 1;
+			trace[i + 1] = *ev;
+			trace[i + 1].seq = tbl->next;
+			tbl->next += 2;
+			i++;
+		} else if (r < 75) {
+			/* after lost packets */
+			tbl->next += 1 + rand_r(&seed) % 4;
+			ev->seq = tbl->next++;
+		} else if (r < 83) {
+			/* late or duplicate, possibly behind the window */
+			ev->seq = tbl->next - 1 - rand_r(&seed) % 48;
+		} else if (r < 88) {
+			/* beyond the window */
+			tbl->next += 16 + rand_r(&seed) % 64;
+			ev->seq = tbl->next++;
+		} else if (r < 93) {
+			/* block ack request for what was sent */
+			ev->type = SIM_REORDER_BAR;
+			ev->seq = tbl->next - rand_r(&seed) % 4;
+		} else {
+			ev->type = SIM_REORDER_TIMER;
+		}
+		tbl->next &= MAX_TID_VALUE - 1;
+	}
+	trace_len = total;
+
+	for (i = 0; i < trace_len; i++) {
+		ev = &trace[i];
+		ev->seq &= MAX_TID_VALUE - 1;
+		if (ev->type == SIM_REORDER_TIMER)
+			continue;
+		ev->pmbuf = sim_reorder_payload(pmadapter, priv, card, ev, i);
+		if (!ev->pmbuf) {
+			sim_reorder_free_trace(pmadapter);
+			return -1;
+		}
+	}
+
+	/* What the driver must do with it */
+	for (i = 0; i < trace_len; i++) {
+		ev = &trace[i];
+		tbl = &ref_tbl[ev->sta][ev->tid];
+		if (ev->type == SIM_REORDER_TIMER) {
+			if (tbl->valid && tbl->timer_set) {
+				tbl->timer_set = MFALSE;
+				ref_flush(tbl);
+			}
+		} else if (ref_rxreorder_pkt(tbl, ev->seq,
+					     ev->type == SIM_REORDER_BAR,
+					     i + 1)) {
+			expect_dropped++;
+		}
+	}
+	return 0;
+}
+
+/**
+ *  @brief This function replays the trace through
+ *  mlan_11n_rxreorder_pkt(), firing the flush timers where the trace
+ *  says, and counts the events and the differences to the model
+ *
+ *  @param handle	A pointer to sim_handle
+ *  @param card		A pointer to sim_card
+ *
+ *  @return		0 or -1
+ */
+int
+sim_reorder_replay(sim_handle * handle, sim_card * card)
+{
+	mlan_adapter *pmadapter = (mlan_adapter *) handle->pmlan_adapter;
+	mlan_private *priv;
+	RxReorderTbl *rx_reor_tbl_ptr;
+	sim_reorder_event *ev;
+	mlan_status status;
+	t_u32 i, dropped = 0, mismatch = 0;
+	t_u32 *log;
+
+	if (!pmadapter || !trace_len)
+		return -1;
+	priv = wlan_get_priv(pmadapter, MLAN_BSS_ROLE_UAP);
+	log = calloc(trace_len, sizeof(t_u32));
+	if (!priv || !log) {
+		free(log);
+		return -1;
+	}
+
+	pthread_mutex_lock(&handle->stats_lock);
+	handle->rx_log = log;
+	handle->rx_log_len = 0;
+	handle->rx_log_size = trace_len;
+	pthread_mutex_unlock(&handle->stats_lock);
+	sim_hold_timers(MTRUE);
+
+	for (i = 0; i < trace_len; i++) {
+		ev = &trace[i];
+		if (ev->type == SIM_REORDER_TIMER) {
+			rx_reor_tbl_ptr =
+				wlan_11n_get_rxreorder_tbl(priv, ev->tid,
+							   card->
+							   sta_addr[ev->sta]);
+			if (rx_reor_tbl_ptr)
+				sim_fire_timer(rx_reor_tbl_ptr->timer_context.
+					       timer);
+			continue;
+		}
+		status = mlan_11n_rxreorder_pkt(priv, ev->seq, ev->tid,
+						card->sta_addr[ev->sta],
+						(ev->type == SIM_REORDER_BAR) ?
+						PKT_TYPE_BAR : 0, ev->pmbuf);
+		if (status != MLAN_STATUS_SUCCESS)
+			dropped++;
+		/* The Rx path frees what is dropped and every BAR */
+		if (status != MLAN_STATUS_SUCCESS ||
+		    ev->type == SIM_REORDER_BAR)
+			wlan_free_mlan_buffer(pmadapter, ev->pmbuf);
+		ev->pmbuf = MNULL;
+	}
+
+	sim_hold_timers(MFALSE);
+	pthread_mutex_lock(&handle->stats_lock);
+	handle->rx_log = NULL;
+	if (handle->rx_log_len != expect_len)
+		mismatch++;
+	for (i = 0; i < MIN(handle->rx_log_len, expect_len); i++) {
+		if (log[i] != expect_log[i]) {
+			if (!mismatch)
+				printf("mlansim: reorder: dispatch %u is event "
+				       "%u, expected %u\n", i, log[i],
+				       expect_log[i]);
+			mismatch++;
+		}
+	}
+	if (dropped != expect_dropped)
+		mismatch++;
+	handle->reorder_events += trace_len;
+	handle->reorder_dropped += dropped;
+	handle->reorder_mismatch += mismatch;
+	pthread_mutex_unlock(&handle->stats_lock);
+
+	free(log);
+	sim_reorder_free_trace(pmadapter);
+	return 0;
+}
+
+/**
+ *  @brief This function frees the trace and the reference tables
+ *
+ *  @param handle	A pointer to sim_handle
+ *
+ *  @return		N/A
+ */
+void
+sim_reorder_free(sim_handle * handle)
+{
+	t_u32 sta, tid;
+
+	if (handle->pmlan_adapter)
+		sim_reorder_free_trace((mlan_adapter *) handle->pmlan_adapter);
+	for (sta = 0; sta < SIM_MAX_STA; sta++) {
+		for (tid = 0; tid < SIM_MAX_TID; tid++) {
+			free(ref_tbl[sta][tid].slot);
+			memset(&ref_tbl[sta][tid], 0, sizeof(sim_ref_tbl));
+		}
+	}
+}
@@ -0,0 +1,438 @@
+/** @file  mlansim_scan.c
+  *
+  * @brief Scan table replay for the userspace MLAN harness. Large
+  * extended scan reports are built up front and handed to
+  * wlan_handle_event_ext_scan_report() directly, round after round for
+  * the same BSSes, and every entry is looked up again afterwards.
+  *
+  * Copyright (C) 2011-2012, Marvell International Ltd.
+  *
+  * This software file (the "File") is distributed by Marvell International
+  * Ltd. under the terms of the GNU General Public License Version 2, June 1991
+  * (the "License").  You may use, redistribute and/or modify this File in
+  * accordance with the terms and conditions of the License, a copy of which
+  * is available by writing to the Free Software Foundation, Inc.,
+  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA or on the
+  * worldwide web at http://www.gnu.org/licenses/old-licenses/gpl-2.0.txt.
+  *
+  * THE FILE IS DISTRIBUTED AS-IS, WITHOUT WARRANTY OF ANY KIND, AND THE
+  * IMPLIED WARRANTIES OF MERCHANTABILITY OR FITNESS FOR A PARTICULAR PURPOSE
+  * ARE EXPRESSLY DISCLAIMED.  The License provides additional details about
+  * this warranty disclaimer.
+  *
+  */
+/************************************************************************
+Change log:
+     10/17/2012: initial version
+************************************************************************/
+
+#include    "mlansim.h"
+
+#include    "mlan_join.h"
+#include    "mlan_util.h"
+#include    "mlan_fw.h"
+#include    "mlan_main.h"
+
+/* mlan_main.h wraps these around the MOAL callbacks */
+#undef memset
+#undef memcpy
+#undef memmove
+#undef memcmp
+
+/** BSSes sharing one SSID */
+#define SIM_SCAN_BSS_PER_SSID	4
+/** Beacon fixed fields: time stamp, beacon interval and capability */
+#define SIM_SCAN_FIXED_LEN	12
+/** Vendor IE header after the IE header: OUI and type */
+#define SIM_SCAN_VENDOR_HDR	4
+/** Largest vendor IE body after the OUI and type */
+#define SIM_SCAN_MAX_PAD	(255 - SIM_SCAN_VENDOR_HDR)
+
+/********************************************************
+			Local Variables
+********************************************************/
+
+/** Supported rates of every BSS */
+static const t_u8 sim_scan_rates[] =
+	{ 0x82, 0x84, 0x8b, 0x96, 0x0c, 0x12, 0x18, 0x24 };
+
+/** Scan report events, one per round */
+static pmlan_buffer *rounds;
+/** Number of rounds */
+static t_u32 round_num;
+/** BSSes in every round */
+static t_u32 bss_num;
+/** Vendor IE body length of every BSS */
+static t_u32 pad_len;
+/** Vendor IE growth of every other BSS, alternating between rounds */
+static t_u32 pad_grow;
+
+/********************************************************
+			Local Functions
+********************************************************/
+
+/**
+ *  @brief Returns the BSSID of a BSS
+ *
+ *  @param i		BSS index
+ *  @param bssid	Buffer for the BSSID
+ *
+ *  @return		N/A
+ */
+static void
+sim_scan_bssid(t_u32 i, t_u8 * bssid)
+{
+	bssid[0] = 0x00;
+	bssid[1] = 0x50;
+	bssid[2] = 0x43;
+	bssid[3] = 0x5c;
+	bssid[4] = (i >> 8) & 0xff;
+	bssid[5] = i & 0xff;
+}
+
+/**
+ *  @brief Returns the SSID of a BSS
+ *
+ *  @param i		BSS index
+ *  @param ssid		A pointer to mlan_802_11_ssid
+ *
+ *  @return		N/A
+ */
+static void
+sim_scan_ssid(t_u32 i, mlan_802_11_ssid * ssid)
+{
+	memset(ssid, 0, sizeof(*ssid));
+	ssid->ssid_len = snprintf((char *)ssid->ssid, sizeof(ssid->ssid),
+				  "mlansim-%03u", i / SIM_SCAN_BSS_PER_SSID);
+}
+
+/**
+ *  @brief Returns the vendor IE body length of a BSS in a round
+ *
+ *  @param r		Round
+ *  @param i		BSS index
+ *
+ *  @return		Length
+ */
+static t_u32
+sim_scan_pad_len(t_u32 r, t_u32 i)
+{
+	return pad_len + (((r + i) & 1) ? pad_grow : 0);
+}
+
+/**
+ *  @brief Returns the vendor IE fill byte of a BSS in a round
+ *
+ *  @param r		Round
+ *  @param i		BSS index
+ *
+ *  @return		Fill byte
+ */
+static t_u8
+sim_scan_pad_byte(t_u32 r, t_u32 i)
+{
+	return (t_u8) (r * 31 + i);
+}
+
+/**
+ *  @brief Returns the beacon length of a BSS in a round, after the BSSID
+ *
+ *  @param r		Round
+ *  @param i		BSS index
+ *
+ *  @return		Length
+ */
+static t_u32
+sim_scan_beacon_len(t_u32 r, t_u32 i)
+{
+	mlan_802_11_ssid ssid;
+
+	sim_scan_ssid(i, &ssid);
+	return SIM_SCAN_FIXED_LEN +
+		sizeof(IEEEtypes_Header_t) + ssid.ssid_len +
+		sizeof(IEEEtypes_DsParamSet_t) +
+		sizeof(IEEEtypes_Header_t) + sizeof(sim_scan_rates) +
+		sizeof(IEEEtypes_Header_t) + SIM_SCAN_VENDOR_HDR +
+		sim_scan_pad_len(r, i);
+}
+
+/**
+ *  @brief Writes the BSS response and BSS info TLVs of a BSS
+ *
+ *  @param pos		Where to write
+ *  @param r		Round
+ *  @param i		BSS index
+ *
+ *  @return		A pointer past the TLVs
+ */
+static t_u8 *
+sim_scan_write_bss(t_u8 * pos, t_u32 r, t_u32 i)
+{
+	MrvlIEtypesHeader_t *tlv = (MrvlIEtypesHeader_t *) pos;
+	MrvlIEtypes_Bss_Scan_Info_t *info;
+	mlan_802_11_ssid ssid;
+	t_u16 interval = wlan_cpu_to_le16(100);
+	t_u16 cap = wlan_cpu_to_le16(0x0401);
+	t_u64 tsf = wlan_cpu_to_le64(((t_u64) r << 32) | i);
+	t_u8 channel = 1 + i % 11;
+	t_u32 len = sim_scan_pad_len(r, i);
+
+	sim_scan_ssid(i, &ssid);
+	tlv->type = wlan_cpu_to_le16(TLV_TYPE_BSS_SCAN_RSP);
+	tlv->len = wlan_cpu_to_le16(MLAN_MAC_ADDR_LENGTH +
+				    sim_scan_beacon_len(r, i));
+	pos += sizeof(MrvlIEtypesHeader_t);
+	sim_scan_bssid(i, pos);
+	pos += MLAN_MAC_ADDR_LENGTH;
+
+	memcpy(pos, &tsf, sizeof(tsf));
+	memcpy(pos + 8, &interval, sizeof(interval));
+	memcpy(pos + 10, &cap, sizeof(cap));
+	pos += SIM_SCAN_FIXED_LEN;
+
+	*pos++ = SSID;
+	*pos++ = ssid.ssid_len;
+	memcpy(pos, ssid.ssid, ssid.ssid_len);
+	pos += ssid.ssid_len;
+	*pos++ = DS_PARAM_SET;
+	*pos++ = 1;
+	*pos++ = channel;
+	*pos++ = SUPPORTED_RATES;
+	*pos++ = sizeof(sim_scan_rates);
+	memcpy(pos, sim_scan_rates, sizeof(sim_scan_rates));
+	pos += sizeof(sim_scan_rates);
+	/* Vendor IE the driver does not know, last so its body ends the
+	   stored beacon */
+	*pos++ = VENDOR_SPECIFIC_221;
+	*pos++ = SIM_SCAN_VENDOR_HDR + len;
+	*pos++ = 0x00;
+	*pos++ = 0x50;
+	*pos++ = 0x43;
+	*pos++ = 0xfe;
+	memset(pos, sim_scan_pad_byte(r, i), len);
+	pos += len;
+
+	info = (MrvlIEtypes_Bss_Scan_Info_t *) pos;
+	memset(info, 0, sizeof(*info));
+	info->header.type = wlan_cpu_to_le16(TLV_TYPE_BSS_SCAN_INFO);
+	info->header.len = wlan_cpu_to_le16(sizeof(*info) -
+					    sizeof(MrvlIEtypesHeader_t));
+	info->rssi = wlan_cpu_to_le16(40 + i % 50);
+	info->channel = channel;
+	info->tsf = tsf;
+	return pos + sizeof(*info);
+}
+
+/**
+ *  @brief Checks every BSS of a round against the scan table: found by
+ *  BSSID and by SSID at the same index, with the beacon of the round
+ *
+ *  @param priv		A pointer to the STA mlan_private
+ *  @param r		Round
+ *
+ *  @return		Number of differences
+ */
+static t_u32
+sim_scan_check(mlan_private * priv, t_u32 r)
+{
+	mlan_adapter *pmadapter = priv->adapter;
+	BSSDescriptor_t *pbss;
+	mlan_802_11_ssid ssid;
+	t_u8 bssid[MLAN_MAC_ADDR_LENGTH];
+	t_u32 i, j, len, mismatch = 0;
+	t_s32 idx;
+	t_u8 *pad;
+
+	if (pmadapter->num_in_scan_table != bss_num)
+		mismatch++;
+	for (i = 0; i < bss_num; i++) {
+		sim_scan_bssid(i, bssid);
+		sim_scan_ssid(i, &ssid);
+		idx = wlan_find_bssid_in_list(priv, bssid, MLAN_BSS_MODE_AUTO);
+		if (idx < 0 ||
+		    wlan_find_ssid_in_list(priv, &ssid, bssid,
+					   MLAN_BSS_MODE_AUTO) != idx) {
+			if (!mismatch)
+				printf("mlansim: scan: round %u, BSS %u not "
+				       "found\n", r, i);
+			mismatch++;
+			continue;
+		}
+		pbss = &pmadapter->pscan_table[idx];
+		len = sim_scan_pad_len(r, i);
+		pad = pbss->pbeacon_buf + pbss->beacon_buf_size - len;
+		for (j = 0; j < len && pad[j] == sim_scan_pad_byte(r, i); j++) ;
+		if (wlan_ssid_cmp(pmadapter, &pbss->ssid, &ssid) ||
+		    pbss->beacon_buf_size != sim_scan_beacon_len(r, i) ||
+		    j != len) {
+			if (!mismatch)
+				printf("mlansim: scan: round %u, BSS %u at %d "
+				       "has a stale beacon\n", r, i, idx);
+			mismatch++;
+		}
+	}
+	return mismatch;
+}
+
+/**
+ *  @brief Frees the scan report events
+ *
+ *  @param pmadapter	A pointer to mlan_adapter
+ *
+ *  @return		N/A
+ */
+static void
+sim_scan_free_rounds(mlan_adapter * pmadapter)
+{
+	t_u32 r;
+
+	for (r = 0; r < round_num; r++) {
+		if (rounds[r])
+			wlan_free_mlan_buffer(pmadapter, rounds[r]);
+	}
+	free(rounds);
+	rounds = NULL;
+	round_num = 0;
+}
+
+/********************************************************
+			Global Functions
+********************************************************/
+
+/**
+ *  @brief This function builds the scan report events of the next
+ *  replay. Every round reports the same BSSes in a random order, in
+ *  one event. Every other BSS sends a beacon larger by grow bytes than
+ *  in the round before, the others a smaller one.
+ *
+ *  @param handle	A pointer to sim_handle
+ *  @param bss		Number of BSSes
+ *  @param count	Number of rounds
+ *  @param ie_len	Vendor IE body length
+ *  @param grow		Vendor IE growth
+ *  @param seed		Random seed
+ *
+ *  @return		0 or -1
+ */
+int
+sim_scan_trace(sim_handle * handle, t_u32 bss, t_u32 count, t_u32 ie_len,
+	       t_u32 grow, t_u32 seed)
+{
+	mlan_adapter *pmadapter = (mlan_adapter *) handle->pmlan_adapter;
+	mlan_event_scan_result *pevent;
+	t_u32 *order = NULL;
+	t_u32 r, i, j, tmp, size;
+	t_u8 *pos;
+
+	if (!pmadapter || !bss || bss > MRVDRV_MAX_BSSID_LIST || !count ||
+	    ie_len + grow > SIM_SCAN_MAX_PAD)
+		return -1;
+	sim_scan_free_rounds(pmadapter);
+	bss_num = bss;
+	pad_len = ie_len;
+	pad_grow = grow;
+
+	rounds = calloc(count, sizeof(pmlan_buffer));
+	order = calloc(bss, sizeof(t_u32));
+	if (!rounds || !order)
+		goto fail;
+	round_num = count;
+
+	for (r = 0; r < count; r++) {
+		size = sizeof(mlan_event_scan_result);
+		for (i = 0; i < bss; i++)
+			size += sizeof(MrvlIEtypesHeader_t) +
+				MLAN_MAC_ADDR_LENGTH +
+				sim_scan_beacon_len(r, i) +
+				sizeof(MrvlIEtypes_Bss_Scan_Info_t);
+		if (size - sizeof(mlan_event_scan_result) > 0xffff)
+			goto fail;
+		rounds[r] = wlan_alloc_mlan_buffer(pmadapter, size, 0,
+						   MOAL_ALLOC_MLAN_BUFFER);
+		if (!rounds[r])
+			goto fail;
+		rounds[r]->data_len = size;
+
+		for (i = 0; i < bss; i++)
+			order[i] = i;
+		for (i = bss - 1; i > 0; i--) {
+			j = rand_r(&seed) % (i + 1);
+			tmp = order[i];
+			order[i] = order[j];
+			order[j] = tmp;
+		}
+
+		pevent = (mlan_event_scan_result *) (rounds[r]->pbuf +
+						     rounds[r]->data_offset);
+		memset(pevent, 0, sizeof(*pevent));
+		pevent->event_id = wlan_cpu_to_le16(EVENT_EXT_SCAN_REPORT);
+		pevent->bss_type = MLAN_BSS_TYPE_STA;
+		pevent->buf_size = wlan_cpu_to_le16(size -
+						    sizeof
+						    (mlan_event_scan_result));
+		pevent->num_of_set = bss;
+		pos = (t_u8 *) (pevent + 1);
+		for (i = 0; i < bss; i++)
+			pos = sim_scan_write_bss(pos, r, order[i]);
+	}
+	free(order);
+	return 0;
+
+fail:
+	free(order);
+	sim_scan_free_rounds(pmadapter);
+	return -1;
+}
+
+/**
+ *  @brief This function replays the scan report events through
+ *  wlan_handle_event_ext_scan_report() on an empty scan table, and
+ *  checks the table after every round
+ *
+ *  @param handle	A pointer to sim_handle
+ *
+ *  @return		0 or -1
+ */
+int
+sim_scan_replay(sim_handle * handle)
+{
+	mlan_adapter *pmadapter = (mlan_adapter *) handle->pmlan_adapter;
+	mlan_private *priv;
+	t_u32 r, mismatch = 0;
+
+	if (!pmadapter || !round_num)
+		return -1;
+	priv = wlan_get_priv(pmadapter, MLAN_BSS_ROLE_STA);
+	if (!priv)
+		return -1;
+
+	wlan_flush_scan_table(pmadapter);
+	for (r = 0; r < round_num; r++) {
+		if (wlan_handle_event_ext_scan_report(priv, rounds[r]) !=
+		    MLAN_STATUS_SUCCESS)
+			mismatch++;
+		mismatch += sim_scan_check(priv, r);
+	}
+
+	pthread_mutex_lock(&handle->stats_lock);
+	handle->scan_results += round_num * bss_num;
+	handle->scan_mismatch += mismatch;
+	pthread_mutex_unlock(&handle->stats_lock);
+
+	sim_scan_free_rounds(pmadapter);
+	return 0;
+}
+
+/**
+ *  @brief This function frees the scan report events
+ *
+ *  @param handle	A pointer to sim_handle
+ *
+ *  @return		N/A
+ */
+void
+sim_scan_free(sim_handle * handle)
+{
+	if (handle->pmlan_adapter)
+		sim_scan_free_rounds((mlan_adapter *) handle->pmlan_adapter);
+}
@@ -4445,6 +4445,7 @@ process_tcpackenh(int argc, char *argv[])
 	t_u8 *buffer = NULL;
 	struct eth_priv_cmd *cmd = NULL;
 	struct ifreq ifr;
+	t_u32 hold_time = 0;
 
 	/* Initialize buffer */
 	buffer = (t_u8 *) malloc(BUFFER_LENGTH);
@@ -4488,6 +4489,8 @@ process_tcpackenh(int argc, char *argv[])
 		printf("enabled.\n");
 	else
 		printf("disabled.\n");
+	memcpy(&hold_time, cmd->buf + 1, sizeof(hold_time));
+	printf("TCP Ack hold time: %u ms\n", hold_time);
 
 	if (buffer)
 		free(buffer);
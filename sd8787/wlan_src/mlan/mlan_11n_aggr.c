@@ -409,6 +409,7 @@ wlan_11n_aggregate_pkt(mlan_private * priv, raListTbl * pra_list,
 					  &pra_list->buf_head, MNULL, MNULL);
 
 		pra_list->total_pkts--;
+		wlan_wmm_update_ralist_active(priv, pra_list);
 
 		/* decrement for every PDU taken from the list */
 		priv->wmm.pkts_queued[ptrindex]--;
@@ -497,6 +498,7 @@ wlan_11n_aggregate_pkt(mlan_private * priv, raListTbl * pra_list,
 				       MNULL);
 
 		pra_list->total_pkts++;
+		wlan_wmm_update_ralist_active(priv, pra_list);
 
 		/* add back only one: aggregated packet is requeued as one */
 		priv->wmm.pkts_queued[ptrindex]++;
@@ -530,7 +532,7 @@ wlan_11n_aggregate_pkt(mlan_private * priv, raListTbl * pra_list,
 						    priv->wmm.ra_list_spinlock);
 		if (wlan_is_ralist_valid(priv, pra_list, ptrindex)) {
 			priv->wmm.packets_out[ptrindex]++;
-			priv->wmm.tid_tbl_ptr[ptrindex].ra_list_curr = pra_list;
+			wlan_wmm_rotate_ralist(priv, pra_list);
 		}
 		pmadapter->bssprio_tbl[priv->bss_priority].bssprio_cur =
 			pmadapter->bssprio_tbl[priv->bss_priority].bssprio_cur->
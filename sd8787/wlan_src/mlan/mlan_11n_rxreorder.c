@@ -44,6 +44,87 @@ Change log:
 /********************************************************
 			Local Functions
 ********************************************************/
+/**
+ *  @brief This function returns the rx_reorder_hash bucket
+ *  		of a TA/TID pair
+ *
+ *  @param ta       ta of the reordering table entry
+ *  @param tid      tid of the reordering table entry
+ *
+ *  @return         Bucket index
+ */
+static INLINE t_u32
+wlan_11n_rxreorder_hash(t_u8 * ta, int tid)
+{
+	t_u32 key = ((t_u32) ta[3] << 19) | ((t_u32) ta[4] << 11) |
+		((t_u32) ta[5] << 3) | (tid & 7);
+
+	return (key ^ (key >> 6) ^ (key >> 12)) & (RX_REORDER_HASH_SIZE - 1);
+}
+
+/**
+ *  @brief This function finds the first slot in [from, to) of the
+ *  		reorder window which is busy (or free)
+ *
+ *  @param rx_reor_tbl_ptr  A pointer to structure RxReorderTbl
+ *  @param from             First slot to check
+ *  @param to               End of the slot range
+ *  @param busy             MTRUE to find a busy slot, MFALSE a free one
+ *
+ *  @return                 Slot index, or to if there is none
+ */
+static int
+wlan_11n_rxreorder_find_slot(RxReorderTbl * rx_reor_tbl_ptr, int from,
+			     int to, t_u8 busy)
+{
+	t_u32 flip = busy ? 0 : 0xffffffff;
+	t_u32 word;
+	int i;
+
+	if (from >= to)
+		return to;
+	i = from >> 5;
+	word = (rx_reor_tbl_ptr->rx_reorder_bitmap[i] ^ flip) &
+		(0xffffffff << (from & 31));
+	while (!word) {
+		if ((++i << 5) >= to)
+			return to;
+		word = rx_reor_tbl_ptr->rx_reorder_bitmap[i] ^ flip;
+	}
+	from = (i << 5) + util_ffs32(word);
+	return MIN(from, to);
+}
+
+/**
+ *  @brief This function removes the packet of a slot from the
+ *  		reorder window
+ *
+ *  @param pmpriv           A pointer to mlan_private
+ *  @param rx_reor_tbl_ptr  A pointer to structure RxReorderTbl
+ *  @param slot             Slot index
+ *
+ *  @return                 The packet, or MNULL if the slot is free
+ */
+static t_void *
+wlan_11n_rxreorder_take_slot(mlan_private * pmpriv,
+			     RxReorderTbl * rx_reor_tbl_ptr, int slot)
+{
+	t_void *rx_tmp_ptr = MNULL;
+
+	pmpriv->adapter->callbacks.moal_spin_lock(pmpriv->adapter->pmoal_handle,
+						  pmpriv->rx_pkt_lock);
+	if (RX_REORDER_SLOT_BUSY(rx_reor_tbl_ptr, slot)) {
+		rx_tmp_ptr = rx_reor_tbl_ptr->rx_reorder_ptr[slot];
+		rx_reor_tbl_ptr->rx_reorder_ptr[slot] = MNULL;
+		rx_reor_tbl_ptr->rx_reorder_bitmap[slot >> 5] &=
+			~(1U << (slot & 31));
+	}
+	pmpriv->adapter->callbacks.moal_spin_unlock(pmpriv->adapter->
+						    pmoal_handle,
+						    pmpriv->rx_pkt_lock);
+	return rx_tmp_ptr;
+}
+
 /**
  *  @brief This function will dispatch amsdu packet and
  *  		forward it to kernel/upper layer
@@ -169,7 +250,7 @@ wlan_11n_dispatch_pkt_until_start_win(t_void * priv,
 				      RxReorderTbl * rx_reor_tbl_ptr,
 				      int start_win)
 {
-	int no_pkt_to_send, i, xchg;
+	int no_pkt_to_send, slot, end, wrap;
 	mlan_status ret = MLAN_STATUS_SUCCESS;
 	void *rx_tmp_ptr = MNULL;
 	mlan_private *pmpriv = (mlan_private *) priv;
@@ -180,36 +261,44 @@ wlan_11n_dispatch_pkt_until_start_win(t_void * priv,
 		MIN((start_win - rx_reor_tbl_ptr->start_win),
 		    rx_reor_tbl_ptr->win_size) : rx_reor_tbl_ptr->win_size;
 
-	for (i = 0; i < no_pkt_to_send; ++i) {
-		pmpriv->adapter->callbacks.moal_spin_lock(pmpriv->adapter->
-							  pmoal_handle,
-							  pmpriv->rx_pkt_lock);
-		rx_tmp_ptr = MNULL;
-		if (rx_reor_tbl_ptr->rx_reorder_ptr[i]) {
-			rx_tmp_ptr = rx_reor_tbl_ptr->rx_reorder_ptr[i];
-			rx_reor_tbl_ptr->rx_reorder_ptr[i] = MNULL;
-		}
-		pmpriv->adapter->callbacks.moal_spin_unlock(pmpriv->adapter->
-							    pmoal_handle,
-							    pmpriv->
-							    rx_pkt_lock);
+	/*
+	 * The circular window covers at most two slot ranges, only
+	 * visit the busy slots of each
+	 */
+	end = rx_reor_tbl_ptr->win_head + no_pkt_to_send;
+	wrap = 0;
+	if (end > rx_reor_tbl_ptr->win_size) {
+		wrap = end - rx_reor_tbl_ptr->win_size;
+		end = rx_reor_tbl_ptr->win_size;
+	}
+	for (slot = wlan_11n_rxreorder_find_slot(rx_reor_tbl_ptr,
+						  rx_reor_tbl_ptr->win_head,
+						  end, MTRUE);
+	     slot < end;
+	     slot = wlan_11n_rxreorder_find_slot(rx_reor_tbl_ptr, slot + 1,
+						  end, MTRUE)) {
+		rx_tmp_ptr = wlan_11n_rxreorder_take_slot(pmpriv,
+							  rx_reor_tbl_ptr,
+							  slot);
+		if (rx_tmp_ptr)
+			wlan_11n_dispatch_pkt(priv, rx_tmp_ptr);
+	}
+	for (slot = wlan_11n_rxreorder_find_slot(rx_reor_tbl_ptr, 0, wrap,
+						  MTRUE);
+	     slot < wrap;
+	     slot = wlan_11n_rxreorder_find_slot(rx_reor_tbl_ptr, slot + 1,
+						  wrap, MTRUE)) {
+		rx_tmp_ptr = wlan_11n_rxreorder_take_slot(pmpriv,
+							  rx_reor_tbl_ptr,
+							  slot);
 		if (rx_tmp_ptr)
 			wlan_11n_dispatch_pkt(priv, rx_tmp_ptr);
 	}
 
 	pmpriv->adapter->callbacks.moal_spin_lock(pmpriv->adapter->pmoal_handle,
 						  pmpriv->rx_pkt_lock);
-	/*
-	 * We don't have a circular buffer, hence use rotation to simulate
-	 * circular buffer
-	 */
-	xchg = rx_reor_tbl_ptr->win_size - no_pkt_to_send;
-	for (i = 0; i < xchg; ++i) {
-		rx_reor_tbl_ptr->rx_reorder_ptr[i] =
-			rx_reor_tbl_ptr->rx_reorder_ptr[no_pkt_to_send + i];
-		rx_reor_tbl_ptr->rx_reorder_ptr[no_pkt_to_send + i] = MNULL;
-	}
-
+	rx_reor_tbl_ptr->win_head =
+		wlan_11n_rxreorder_slot(rx_reor_tbl_ptr, no_pkt_to_send);
 	rx_reor_tbl_ptr->start_win = start_win;
 	pmpriv->adapter->callbacks.moal_spin_unlock(pmpriv->adapter->
 						    pmoal_handle,
@@ -252,49 +341,41 @@ wlan_11n_display_tbl_ptr(pmlan_adapter pmadapter,
 static mlan_status
 wlan_11n_scan_and_dispatch(t_void * priv, RxReorderTbl * rx_reor_tbl_ptr)
 {
-	int i, j, xchg;
+	int i, hole, count;
 	mlan_status ret = MLAN_STATUS_SUCCESS;
 	void *rx_tmp_ptr = MNULL;
 	mlan_private *pmpriv = (mlan_private *) priv;
 
 	ENTER();
 
-	for (i = 0; i < rx_reor_tbl_ptr->win_size; ++i) {
-		pmpriv->adapter->callbacks.moal_spin_lock(pmpriv->adapter->
-							  pmoal_handle,
-							  pmpriv->rx_pkt_lock);
-		if (!rx_reor_tbl_ptr->rx_reorder_ptr[i]) {
-			pmpriv->adapter->callbacks.moal_spin_unlock(pmpriv->
-								    adapter->
-								    pmoal_handle,
-								    pmpriv->
-								    rx_pkt_lock);
+	/* Find the first hole from start_win with the occupancy bitmap */
+	pmpriv->adapter->callbacks.moal_spin_lock(pmpriv->adapter->pmoal_handle,
+						  pmpriv->rx_pkt_lock);
+	hole = wlan_11n_rxreorder_find_slot(rx_reor_tbl_ptr,
+					    rx_reor_tbl_ptr->win_head,
+					    rx_reor_tbl_ptr->win_size, MFALSE);
+	if (hole == rx_reor_tbl_ptr->win_size)
+		hole += wlan_11n_rxreorder_find_slot(rx_reor_tbl_ptr, 0,
+						     rx_reor_tbl_ptr->win_head,
+						     MFALSE);
+	count = hole - rx_reor_tbl_ptr->win_head;
+	pmpriv->adapter->callbacks.moal_spin_unlock(pmpriv->adapter->
+						    pmoal_handle,
+						    pmpriv->rx_pkt_lock);
+
+	for (i = 0; i < count; ++i) {
+		rx_tmp_ptr = wlan_11n_rxreorder_take_slot(pmpriv,
+							  rx_reor_tbl_ptr,
+							  wlan_11n_rxreorder_slot
+							  (rx_reor_tbl_ptr, i));
+		if (!rx_tmp_ptr)
 			break;
-		}
-		rx_tmp_ptr = rx_reor_tbl_ptr->rx_reorder_ptr[i];
-		rx_reor_tbl_ptr->rx_reorder_ptr[i] = MNULL;
-		pmpriv->adapter->callbacks.moal_spin_unlock(pmpriv->adapter->
-							    pmoal_handle,
-							    pmpriv->
-							    rx_pkt_lock);
 		wlan_11n_dispatch_pkt(priv, rx_tmp_ptr);
 	}
 
 	pmpriv->adapter->callbacks.moal_spin_lock(pmpriv->adapter->pmoal_handle,
 						  pmpriv->rx_pkt_lock);
-	/*
-	 * We don't have a circular buffer, hence use rotation to simulate
-	 * circular buffer
-	 */
-	if (i > 0) {
-		xchg = rx_reor_tbl_ptr->win_size - i;
-		for (j = 0; j < xchg; ++j) {
-			rx_reor_tbl_ptr->rx_reorder_ptr[j] =
-				rx_reor_tbl_ptr->rx_reorder_ptr[i + j];
-			rx_reor_tbl_ptr->rx_reorder_ptr[i + j] = MNULL;
-		}
-	}
-
+	rx_reor_tbl_ptr->win_head = wlan_11n_rxreorder_slot(rx_reor_tbl_ptr, i);
 	rx_reor_tbl_ptr->start_win = (rx_reor_tbl_ptr->start_win + i)
 		& (MAX_TID_VALUE - 1);
 
@@ -319,6 +400,7 @@ wlan_11n_delete_rxreorder_tbl_entry(mlan_private * priv,
 				    RxReorderTbl * rx_reor_tbl_ptr)
 {
 	pmlan_adapter pmadapter = priv->adapter;
+	RxReorderTbl **pprev;
 
 	ENTER();
 
@@ -360,12 +442,24 @@ wlan_11n_delete_rxreorder_tbl_entry(mlan_private * priv,
 	}
 
 	PRINTM(MDAT_D, "Delete rx_reor_tbl_ptr: %p\n", rx_reor_tbl_ptr);
+	pmadapter->callbacks.moal_spin_lock(pmadapter->pmoal_handle,
+					    priv->rx_reorder_tbl_ptr.plock);
+	pprev = &priv->rx_reorder_hash[wlan_11n_rxreorder_hash
+					(rx_reor_tbl_ptr->ta,
+					 rx_reor_tbl_ptr->tid)];
+	while (*pprev && (*pprev != rx_reor_tbl_ptr))
+		pprev = &(*pprev)->hnext;
+	if (*pprev)
+		*pprev = rx_reor_tbl_ptr->hnext;
+	pmadapter->callbacks.moal_spin_unlock(pmadapter->pmoal_handle,
+					      priv->rx_reorder_tbl_ptr.plock);
 	util_unlink_list(pmadapter->pmoal_handle,
 			 &priv->rx_reorder_tbl_ptr,
 			 (pmlan_linked_list) rx_reor_tbl_ptr,
 			 pmadapter->callbacks.moal_spin_lock,
 			 pmadapter->callbacks.moal_spin_unlock);
 
+	/* rx_reorder_bitmap shares the allocation of rx_reorder_ptr */
 	pmadapter->callbacks.moal_mfree(pmadapter->pmoal_handle,
 					(t_u8 *) rx_reor_tbl_ptr->
 					rx_reorder_ptr);
@@ -390,17 +484,24 @@ wlan_11n_delete_rxreorder_tbl_entry(mlan_private * priv,
 static int
 wlan_11n_find_last_seqnum(RxReorderTbl * rx_reorder_tbl_ptr)
 {
-	int i;
+	int slot, offset, last = -1;
 
 	ENTER();
-	for (i = (rx_reorder_tbl_ptr->win_size - 1); i >= 0; --i) {
-		if (rx_reorder_tbl_ptr->rx_reorder_ptr[i]) {
-			LEAVE();
-			return i;
-		}
+	for (slot = wlan_11n_rxreorder_find_slot(rx_reorder_tbl_ptr, 0,
+						  rx_reorder_tbl_ptr->win_size,
+						  MTRUE);
+	     slot < rx_reorder_tbl_ptr->win_size;
+	     slot = wlan_11n_rxreorder_find_slot(rx_reorder_tbl_ptr, slot + 1,
+						  rx_reorder_tbl_ptr->win_size,
+						  MTRUE)) {
+		offset = slot - rx_reorder_tbl_ptr->win_head;
+		if (offset < 0)
+			offset += rx_reorder_tbl_ptr->win_size;
+		if (offset > last)
+			last = offset;
 	}
 	LEAVE();
-	return -1;
+	return last;
 }
 
 /**
@@ -458,6 +559,7 @@ wlan_11n_create_rxreorder_tbl(mlan_private * priv, t_u8 * ta, int tid,
 	RxReorderTbl *rx_reor_tbl_ptr, *new_node;
 	sta_node *sta_ptr = MNULL;
 	t_u16 last_seq = 0;
+	t_u32 hash;
 
 	ENTER();
 
@@ -502,9 +604,12 @@ wlan_11n_create_rxreorder_tbl(mlan_private * priv, t_u8 * ta, int tid,
 		new_node->force_no_drop = MFALSE;
 		new_node->check_start_win = MTRUE;
 
+		/* The occupancy bitmap follows the packet pointers */
 		if (pmadapter->callbacks.
 		    moal_malloc(pmadapter->pmoal_handle,
-				sizeof(t_void *) * win_size, MLAN_MEM_DEF,
+				sizeof(t_void *) * win_size +
+				sizeof(t_u32) *
+				RX_REORDER_BITMAP_WORDS(win_size), MLAN_MEM_DEF,
 				(t_u8 **) & new_node->rx_reorder_ptr)) {
 			PRINTM(MERROR,
 			       "Rx reorder table memory allocation" "failed\n");
@@ -530,12 +635,26 @@ wlan_11n_create_rxreorder_tbl(mlan_private * priv, t_u8 * ta, int tid,
 
 		for (i = 0; i < win_size; ++i)
 			new_node->rx_reorder_ptr[i] = MNULL;
+		new_node->rx_reorder_bitmap =
+			(t_u32 *) (new_node->rx_reorder_ptr + win_size);
+		memset(pmadapter, new_node->rx_reorder_bitmap, 0,
+		       sizeof(t_u32) * RX_REORDER_BITMAP_WORDS(win_size));
+		new_node->win_head = 0;
 
 		util_enqueue_list_tail(pmadapter->pmoal_handle,
 				       &priv->rx_reorder_tbl_ptr,
 				       (pmlan_linked_list) new_node,
 				       pmadapter->callbacks.moal_spin_lock,
 				       pmadapter->callbacks.moal_spin_unlock);
+		hash = wlan_11n_rxreorder_hash(ta, tid);
+		pmadapter->callbacks.moal_spin_lock(pmadapter->pmoal_handle,
+						    priv->rx_reorder_tbl_ptr.
+						    plock);
+		new_node->hnext = priv->rx_reorder_hash[hash];
+		priv->rx_reorder_hash[hash] = new_node;
+		pmadapter->callbacks.moal_spin_unlock(pmadapter->pmoal_handle,
+						      priv->rx_reorder_tbl_ptr.
+						      plock);
 	}
 
 	LEAVE();
@@ -563,26 +682,17 @@ wlan_11n_get_rxreorder_tbl(mlan_private * priv, int tid, t_u8 * ta)
 	ENTER();
 
 	rx_reor_tbl_ptr =
-		(RxReorderTbl *) util_peek_list(priv->adapter->pmoal_handle,
-						&priv->rx_reorder_tbl_ptr,
-						priv->adapter->callbacks.
-						moal_spin_lock,
-						priv->adapter->callbacks.
-						moal_spin_unlock);
-	if (!rx_reor_tbl_ptr) {
-		LEAVE();
-		return MNULL;
-	}
-
-	while (rx_reor_tbl_ptr != (RxReorderTbl *) & priv->rx_reorder_tbl_ptr) {
-		if ((!memcmp
+		priv->rx_reorder_hash[wlan_11n_rxreorder_hash(ta, tid)];
+	while (rx_reor_tbl_ptr) {
+		if ((rx_reor_tbl_ptr->tid == tid) &&
+		    (!memcmp
 		     (priv->adapter, rx_reor_tbl_ptr->ta, ta,
-		      MLAN_MAC_ADDR_LENGTH)) && (rx_reor_tbl_ptr->tid == tid)) {
+		      MLAN_MAC_ADDR_LENGTH))) {
 			LEAVE();
 			return rx_reor_tbl_ptr;
 		}
 
-		rx_reor_tbl_ptr = rx_reor_tbl_ptr->pnext;
+		rx_reor_tbl_ptr = rx_reor_tbl_ptr->hnext;
 	}
 
 	LEAVE();
@@ -761,7 +871,7 @@ mlan_11n_rxreorder_pkt(void *priv, t_u16 seq_num, t_u16 tid,
 		       t_u8 * ta, t_u8 pkt_type, void *payload)
 {
 	RxReorderTbl *rx_reor_tbl_ptr;
-	int prev_start_win, start_win, end_win, win_size;
+	int prev_start_win, start_win, end_win, win_size, slot;
 	mlan_status ret = MLAN_STATUS_SUCCESS;
 	pmlan_adapter pmadapter = ((mlan_private *) priv)->adapter;
 
@@ -906,35 +1016,23 @@ mlan_11n_rxreorder_pkt(void *priv, t_u16 seq_num, t_u16 tid,
 		PRINTM(MDAT_D, "3:seq_num %d start_win %d win_size %d"
 		       " end_win %d\n", seq_num, start_win, win_size, end_win);
 		if (pkt_type != PKT_TYPE_BAR) {
-			if (seq_num >= start_win) {
-				if (rx_reor_tbl_ptr->rx_reorder_ptr[seq_num
-								    -
-								    start_win])
-				{
-					PRINTM(MDAT_D, "Drop Duplicate Pkt\n");
-					ret = MLAN_STATUS_FAILURE;
-					goto done;
-				}
-				rx_reor_tbl_ptr->rx_reorder_ptr[seq_num
-								- start_win] =
-					payload;
-			} else {	/* Wrap condition */
-				if (rx_reor_tbl_ptr->rx_reorder_ptr[(seq_num
-								     +
-								     (MAX_TID_VALUE))
-								    -
-								    start_win])
-				{
-					PRINTM(MDAT_D, "Drop Duplicate Pkt\n");
-					ret = MLAN_STATUS_FAILURE;
-					goto done;
-				}
-				rx_reor_tbl_ptr->rx_reorder_ptr[(seq_num
-								 +
-								 (MAX_TID_VALUE))
-								- start_win] =
-					payload;
+			if (seq_num >= start_win)
+				slot = wlan_11n_rxreorder_slot(rx_reor_tbl_ptr,
+							       seq_num -
+							       start_win);
+			else	/* Wrap condition */
+				slot = wlan_11n_rxreorder_slot(rx_reor_tbl_ptr,
+							       (seq_num +
+								(MAX_TID_VALUE))
+							       - start_win);
+			if (RX_REORDER_SLOT_BUSY(rx_reor_tbl_ptr, slot)) {
+				PRINTM(MDAT_D, "Drop Duplicate Pkt\n");
+				ret = MLAN_STATUS_FAILURE;
+				goto done;
 			}
+			rx_reor_tbl_ptr->rx_reorder_ptr[slot] = payload;
+			rx_reor_tbl_ptr->rx_reorder_bitmap[slot >> 5] |=
+				1U << (slot & 31);
 		}
 
 		wlan_11n_display_tbl_ptr(pmadapter, rx_reor_tbl_ptr);
@@ -1139,6 +1237,8 @@ wlan_11n_cleanup_reorder_tbl(mlan_private * priv)
 	}
 
 	util_init_list((pmlan_linked_list) & priv->rx_reorder_tbl_ptr);
+	memset(priv->adapter, priv->rx_reorder_hash, 0,
+	       sizeof(priv->rx_reorder_hash));
 
 	memset(priv->adapter, priv->rx_seq, 0xff, sizeof(priv->rx_seq));
 	LEAVE();
@@ -74,6 +74,31 @@ Change log:
 /** Indicate packet has been dropped in FW */
 #define RX_PKT_DROPPED_IN_FW             0xffffffff
 
+/** Number of 32-bit words in the occupancy bitmap of a reorder window */
+#define RX_REORDER_BITMAP_WORDS(win_size)	(((win_size) + 31) >> 5)
+/** Check if a slot of the reorder window holds a packet */
+#define RX_REORDER_SLOT_BUSY(tbl, slot) \
+	((tbl)->rx_reorder_bitmap[(slot) >> 5] & (1U << ((slot) & 31)))
+
+/**
+ *  @brief This function maps an offset from start_win to
+ *  		the rx_reorder_ptr slot holding it
+ *
+ *  @param rx_reor_tbl_ptr  A pointer to structure RxReorderTbl
+ *  @param offset           Offset from start_win (0 - win_size-1)
+ *
+ *  @return                 Slot index
+ */
+static INLINE int
+wlan_11n_rxreorder_slot(RxReorderTbl * rx_reor_tbl_ptr, int offset)
+{
+	int slot = rx_reor_tbl_ptr->win_head + offset;
+
+	if (slot >= rx_reor_tbl_ptr->win_size)
+		slot -= rx_reor_tbl_ptr->win_size;
+	return slot;
+}
+
 mlan_status mlan_11n_rxreorder_pkt(void *priv, t_u16 seqNum, t_u16 tid,
 				   t_u8 * ta, t_u8 pkttype, void *payload);
 void mlan_11n_delete_bastream_tbl(mlan_private * priv, int Tid,
@@ -211,6 +211,18 @@ wlan_dump_info(mlan_adapter * pmadapter, t_u8 reason)
 		PRINTM(MERROR, "0x%x ", pmadapter->dbg.last_cmd_resp_id[i]);
 	}
 	PRINTM(MERROR, "\n");
+	PRINTM(MERROR, "last_cmd_resp_lat = ");
+	for (i = 0; i < DBG_CMD_NUM; i++) {
+		PRINTM(MERROR, "%d ", pmadapter->dbg.last_cmd_resp_lat[i]);
+	}
+	PRINTM(MERROR, "\n");
+	PRINTM(MERROR, "max_cmd_resp_lat = %d usec, cmd 0x%x\n",
+	       pmadapter->dbg.max_cmd_resp_lat, pmadapter->dbg.max_lat_cmd_id);
+	PRINTM(MERROR, "num_cmd_batch = %d, num_cmd_batched = %d\n",
+	       pmadapter->dbg.num_cmd_batch, pmadapter->dbg.num_cmd_batched);
+	if (pmadapter->cmd_batch_num)
+		PRINTM(MERROR, "multi-command in flight: %d of %d answered\n",
+		       pmadapter->cmd_batch_done, pmadapter->cmd_batch_num);
 	PRINTM(MERROR, "last_event_index = %d\n",
 	       pmadapter->dbg.last_event_index);
 	PRINTM(MERROR, "last_event = ");
@@ -683,6 +695,103 @@ wlan_cmd_host_cmd(IN pmlan_private pmpriv,
 	return MLAN_STATUS_SUCCESS;
 }
 
+/**
+ *  @brief This function stamps a command with the next sequence number
+ *  		and its download time before it is sent to firmware.
+ *
+ *  @param pmadapter    A pointer to mlan_adapter structure
+ *  @param pcmd_node    A pointer to cmd_ctrl_node structure
+ *
+ *  @return             A pointer to the command
+ */
+static HostCmd_DS_COMMAND *
+wlan_prepare_cmd_dnld(mlan_adapter * pmadapter, cmd_ctrl_node * pcmd_node)
+{
+	HostCmd_DS_COMMAND *pcmd;
+#ifdef DEBUG_LEVEL1
+	t_u32 sec = 0, usec = 0;
+#endif
+
+	ENTER();
+
+	pcmd = (HostCmd_DS_COMMAND *) (pcmd_node->cmdbuf->pbuf +
+				       pcmd_node->cmdbuf->data_offset);
+
+	/* Set command sequence number */
+	pmadapter->seq_num++;
+	pcmd->seq_num =
+		wlan_cpu_to_le16(HostCmd_SET_SEQ_NO_BSS_INFO
+				 (pmadapter->seq_num, pcmd_node->priv->bss_num,
+				  pcmd_node->priv->bss_type));
+	pcmd_node->seq_num = wlan_le16_to_cpu(pcmd->seq_num);
+	pcmd_node->cmdbuf->data_len = wlan_le16_to_cpu(pcmd->size);
+	pmadapter->callbacks.moal_get_system_time(pmadapter->pmoal_handle,
+						  &pcmd_node->dnld_sec,
+						  &pcmd_node->dnld_usec);
+
+	PRINTM_GET_SYS_TIME(MCMND, &sec, &usec);
+	PRINTM_NETINTF(MCMND, pcmd_node->priv);
+	PRINTM(MCMND,
+	       "DNLD_CMD (%lu.%06lu): 0x%x, act 0x%x, len %d, seqno 0x%x\n",
+	       sec, usec, wlan_le16_to_cpu(pcmd->command),
+	       wlan_le16_to_cpu(*(t_u16 *) ((t_u8 *) pcmd + S_DS_GEN)),
+	       wlan_le16_to_cpu(pcmd->size), wlan_le16_to_cpu(pcmd->seq_num));
+	DBG_HEXDUMP(MCMD_D, "DNLD_CMD", (t_u8 *) pcmd,
+		    wlan_le16_to_cpu(pcmd->size));
+
+	LEAVE();
+	return pcmd;
+}
+
+/**
+ *  @brief This function saves the id and action of a command sent to
+ *  		firmware to the debug log.
+ *
+ *  @param pmadapter    A pointer to mlan_adapter structure
+ *  @param pcmd         A pointer to HostCmd_DS_COMMAND structure
+ *
+ *  @return             N/A
+ */
+static t_void
+wlan_save_cmd_dbg(mlan_adapter * pmadapter, HostCmd_DS_COMMAND * pcmd)
+{
+	pmadapter->dbg.last_cmd_index =
+		(pmadapter->dbg.last_cmd_index + 1) % DBG_CMD_NUM;
+	pmadapter->dbg.last_cmd_id[pmadapter->dbg.last_cmd_index] =
+		wlan_le16_to_cpu(pcmd->command);
+	pmadapter->dbg.last_cmd_act[pmadapter->dbg.last_cmd_index] =
+		wlan_le16_to_cpu(*(t_u16 *) ((t_u8 *) pcmd + S_DS_GEN));
+}
+
+/**
+ *  @brief This function records the time from download to response
+ *  		of the current command.
+ *
+ *  @param pmadapter    A pointer to mlan_adapter structure
+ *  @param cmd_id       Command ID of the response
+ *
+ *  @return             N/A
+ */
+static t_void
+wlan_save_cmd_resp_lat(mlan_adapter * pmadapter, t_u16 cmd_id)
+{
+	cmd_ctrl_node *pcmd_node = pmadapter->curr_cmd;
+	t_u32 sec = 0, usec = 0;
+	t_u32 lat;
+
+	pmadapter->callbacks.moal_get_system_time(pmadapter->pmoal_handle,
+						  &sec, &usec);
+	lat = (sec - pcmd_node->dnld_sec) * 1000000 + usec -
+		pcmd_node->dnld_usec;
+	pmadapter->dbg.last_cmd_resp_lat[pmadapter->dbg.last_cmd_resp_index] =
+		(t_u16) MIN(lat / 1000, 0xffff);
+	if (lat > pmadapter->dbg.max_cmd_resp_lat) {
+		pmadapter->dbg.max_cmd_resp_lat = lat;
+		pmadapter->dbg.max_lat_cmd_id = cmd_id;
+	}
+	PRINTM(MCMND, "CMD_RESP: 0x%x latency %u usec\n", cmd_id, lat);
+}
+
 /**
  *  @brief This function downloads a command to firmware.
  *
@@ -701,11 +810,7 @@ wlan_dnld_cmd_to_fw(IN mlan_private * pmpriv, IN cmd_ctrl_node * pcmd_node)
 	HostCmd_DS_COMMAND *pcmd;
 	mlan_ioctl_req *pioctl_buf = MNULL;
 	t_u16 cmd_code;
-	t_u16 cmd_size;
 	t_u32 age_ts_usec;
-#ifdef DEBUG_LEVEL1
-	t_u32 sec = 0, usec = 0;
-#endif
 
 	ENTER();
 
@@ -734,30 +839,13 @@ wlan_dnld_cmd_to_fw(IN mlan_private * pmpriv, IN cmd_ctrl_node * pcmd_node)
 		goto done;
 	}
 
-	/* Set command sequence number */
-	pmadapter->seq_num++;
-	pcmd->seq_num =
-		wlan_cpu_to_le16(HostCmd_SET_SEQ_NO_BSS_INFO
-				 (pmadapter->seq_num, pcmd_node->priv->bss_num,
-				  pcmd_node->priv->bss_type));
+	wlan_prepare_cmd_dnld(pmadapter, pcmd_node);
 
 	wlan_request_cmd_lock(pmadapter);
 	pmadapter->curr_cmd = pcmd_node;
 	wlan_release_cmd_lock(pmadapter);
 
 	cmd_code = wlan_le16_to_cpu(pcmd->command);
-	cmd_size = wlan_le16_to_cpu(pcmd->size);
-
-	pcmd_node->cmdbuf->data_len = cmd_size;
-
-	PRINTM_GET_SYS_TIME(MCMND, &sec, &usec);
-	PRINTM_NETINTF(MCMND, pmpriv);
-	PRINTM(MCMND,
-	       "DNLD_CMD (%lu.%06lu): 0x%x, act 0x%x, len %d, seqno 0x%x\n",
-	       sec, usec, cmd_code,
-	       wlan_le16_to_cpu(*(t_u16 *) ((t_u8 *) pcmd + S_DS_GEN)),
-	       cmd_size, wlan_le16_to_cpu(pcmd->seq_num));
-	DBG_HEXDUMP(MCMD_D, "DNLD_CMD", (t_u8 *) pcmd, cmd_size);
 
 	/* Send the command to lower layer */
 
@@ -785,11 +873,7 @@ wlan_dnld_cmd_to_fw(IN mlan_private * pmpriv, IN cmd_ctrl_node * pcmd_node)
 	}
 
 	/* Save the last command id and action to debug log */
-	pmadapter->dbg.last_cmd_index =
-		(pmadapter->dbg.last_cmd_index + 1) % DBG_CMD_NUM;
-	pmadapter->dbg.last_cmd_id[pmadapter->dbg.last_cmd_index] = cmd_code;
-	pmadapter->dbg.last_cmd_act[pmadapter->dbg.last_cmd_index] =
-		wlan_le16_to_cpu(*(t_u16 *) ((t_u8 *) pcmd + S_DS_GEN));
+	wlan_save_cmd_dbg(pmadapter, pcmd);
 
 	/* Clear BSS_NO_BITS from HostCmd */
 	cmd_code &= HostCmd_CMD_ID_MASK;
@@ -825,6 +909,531 @@ done:
 	return ret;
 }
 
+/**
+ *  @brief This function checks whether a command may share a
+ *  		multi-command transfer with other commands. Commands that
+ *  		change the host interface or the power state, or start a
+ *  		procedure completed by an event, are sent alone.
+ *
+ *  @param pcmd_node    A pointer to cmd_ctrl_node structure
+ *
+ *  @return             MTRUE or MFALSE
+ */
+static t_u8
+wlan_is_cmd_batchable(cmd_ctrl_node * pcmd_node)
+{
+	HostCmd_DS_COMMAND *pcmd;
+	t_u8 ret = MTRUE;
+
+	ENTER();
+
+	if (pcmd_node->cmd_flag & CMD_F_HOSTCMD) {
+		LEAVE();
+		return MFALSE;
+	}
+	pcmd = (HostCmd_DS_COMMAND *) (pcmd_node->cmdbuf->pbuf +
+				       pcmd_node->cmdbuf->data_offset);
+	if (pcmd->size == 0) {
+		LEAVE();
+		return MFALSE;
+	}
+	switch (wlan_le16_to_cpu(pcmd->command) & HostCmd_CMD_ID_MASK) {
+	case HostCmd_CMD_GET_HW_SPEC:
+	case HostCmd_CMD_FUNC_INIT:
+	case HostCmd_CMD_FUNC_SHUTDOWN:
+	case HostCmd_CMD_SOFT_RESET:
+	case HostCmd_CMD_RECONFIGURE_TX_BUFF:
+	case HostCmd_CMD_802_11_PS_MODE_ENH:
+	case HostCmd_CMD_802_11_HS_CFG_ENH:
+	case HostCmd_CMD_802_11_SCAN:
+	case HostCmd_CMD_802_11_BG_SCAN_QUERY:
+	case HostCmd_CMD_802_11_ASSOCIATE:
+	case HostCmd_CMD_802_11_AD_HOC_START:
+	case HostCmd_CMD_802_11_AD_HOC_JOIN:
+#ifdef UAP_SUPPORT
+	case HOST_CMD_APCMD_SYS_RESET:
+	case HOST_CMD_APCMD_BSS_START:
+	case HOST_CMD_APCMD_BSS_STOP:
+#endif
+		ret = MFALSE;
+		break;
+	default:
+		break;
+	}
+
+	LEAVE();
+	return ret;
+}
+
+/**
+ *  @brief This function counts the commands at the head of the pending
+ *  		queue that fit in one multi-command transfer. The caller
+ *  		holds the command lock.
+ *
+ *  @param pmadapter    A pointer to mlan_adapter structure
+ *
+ *  @return             Number of commands
+ */
+static t_u8
+wlan_get_cmd_batch_num(mlan_adapter * pmadapter)
+{
+	mlan_callbacks *pcb = (mlan_callbacks *) & pmadapter->callbacks;
+	cmd_ctrl_node *pcmd_node;
+	HostCmd_DS_COMMAND *pcmd;
+	t_u32 len = INTF_HEADER_LEN + S_DS_GEN + sizeof(HostCmd_DS_MULTI_CMD);
+	t_u8 num = 0;
+
+	if (!pmadapter->cmd_batch_enabled)
+		return 0;
+	pcmd_node = (cmd_ctrl_node *) util_peek_list(pmadapter->pmoal_handle,
+						     &pmadapter->cmd_pending_q,
+						     pcb->moal_spin_lock,
+						     pcb->moal_spin_unlock);
+	if (!pcmd_node)
+		return 0;
+	while (pcmd_node != (cmd_ctrl_node *) & pmadapter->cmd_pending_q &&
+	       num < MRVDRV_MAX_CMD_BATCH) {
+		if (!wlan_is_cmd_batchable(pcmd_node))
+			break;
+		pcmd = (HostCmd_DS_COMMAND *) (pcmd_node->cmdbuf->pbuf +
+					       pcmd_node->cmdbuf->data_offset);
+		len += wlan_le16_to_cpu(pcmd->size);
+		if (len > MRVDRV_SIZE_OF_CMD_BUFFER)
+			break;
+		num++;
+		pcmd_node = pcmd_node->pnext;
+	}
+	return num;
+}
+
+/**
+ *  @brief This function fails the commands of the batch in flight.
+ *
+ *  @param pmadapter    A pointer to mlan_adapter structure
+ *  @param status_code  Status code for the ioctls of the commands
+ *
+ *  @return             N/A
+ */
+static t_void
+wlan_flush_cmd_batch(mlan_adapter * pmadapter, t_u32 status_code)
+{
+	mlan_callbacks *pcb = (mlan_callbacks *) & pmadapter->callbacks;
+	cmd_ctrl_node *pcmd_node;
+	mlan_ioctl_req *pioctl_buf;
+
+	ENTER();
+
+	wlan_request_cmd_lock(pmadapter);
+	pcmd_node = pmadapter->curr_cmd;
+	pmadapter->curr_cmd = MNULL;
+	pmadapter->cmd_batch_num = 0;
+	pmadapter->cmd_batch_done = 0;
+	wlan_release_cmd_lock(pmadapter);
+
+	while (pcmd_node) {
+		pioctl_buf = (mlan_ioctl_req *) pcmd_node->pioctl_buf;
+		if (pioctl_buf)
+			pioctl_buf->status_code = status_code;
+		wlan_insert_cmd_to_free_q(pmadapter, pcmd_node);
+		pcmd_node = (cmd_ctrl_node *)
+			util_dequeue_list(pmadapter->pmoal_handle,
+					  &pmadapter->cmd_batch_q,
+					  pcb->moal_spin_lock,
+					  pcb->moal_spin_unlock);
+	}
+
+	LEAVE();
+}
+
+/**
+ *  @brief This function sends the commands at the head of the pending
+ *  		queue to firmware in one HostCmd_CMD_MULTI_CMD transfer.
+ *  		The first command becomes curr_cmd, the others wait in
+ *  		cmd_batch_q for their responses, which arrive in order.
+ *
+ *  @param pmadapter    A pointer to mlan_adapter structure
+ *
+ *  @return             MLAN_STATUS_SUCCESS or MLAN_STATUS_FAILURE
+ */
+static mlan_status
+wlan_dnld_cmd_batch(mlan_adapter * pmadapter)
+{
+	mlan_callbacks *pcb = (mlan_callbacks *) & pmadapter->callbacks;
+	mlan_buffer *pmbuf = pmadapter->pcmd_batch_buf;
+	HostCmd_DS_COMMAND *pbatch;
+	HostCmd_DS_COMMAND *pcmd;
+	HostCmd_DS_MULTI_CMD *pmulti_cmd;
+	cmd_ctrl_node *pcmd_node;
+	mlan_status ret = MLAN_STATUS_SUCCESS;
+	t_u32 offset = S_DS_GEN + sizeof(HostCmd_DS_MULTI_CMD);
+	t_u32 age_ts_usec;
+	t_u16 cmd_size;
+	t_u8 num = 0;
+
+	ENTER();
+
+	pbatch = (HostCmd_DS_COMMAND *) (pmbuf->pbuf + INTF_HEADER_LEN);
+	memset(pmadapter, pbatch, 0, offset);
+
+	wlan_request_cmd_lock(pmadapter);
+	while (num < MRVDRV_MAX_CMD_BATCH) {
+		pcmd_node = (cmd_ctrl_node *)
+			util_peek_list(pmadapter->pmoal_handle,
+				       &pmadapter->cmd_pending_q,
+				       pcb->moal_spin_lock,
+				       pcb->moal_spin_unlock);
+		if (!pcmd_node || !wlan_is_cmd_batchable(pcmd_node))
+			break;
+		pcmd = (HostCmd_DS_COMMAND *) (pcmd_node->cmdbuf->pbuf +
+					       pcmd_node->cmdbuf->data_offset);
+		cmd_size = wlan_le16_to_cpu(pcmd->size);
+		if (INTF_HEADER_LEN + offset + cmd_size >
+		    MRVDRV_SIZE_OF_CMD_BUFFER)
+			break;
+		util_unlink_list(pmadapter->pmoal_handle,
+				 &pmadapter->cmd_pending_q,
+				 (pmlan_linked_list) pcmd_node,
+				 pcb->moal_spin_lock, pcb->moal_spin_unlock);
+		wlan_prepare_cmd_dnld(pmadapter, pcmd_node);
+		memcpy(pmadapter, (t_u8 *) pbatch + offset, pcmd, cmd_size);
+		offset += cmd_size;
+		/* Leave the node as a single download would */
+		pcmd_node->cmdbuf->data_offset -= INTF_HEADER_LEN;
+		pcmd_node->cmdbuf->data_len += INTF_HEADER_LEN;
+		pcmd_node->cmd_flag |= CMD_F_BATCH;
+		if (!num)
+			pmadapter->curr_cmd = pcmd_node;
+		else
+			util_enqueue_list_tail(pmadapter->pmoal_handle,
+					       &pmadapter->cmd_batch_q,
+					       (pmlan_linked_list) pcmd_node,
+					       pcb->moal_spin_lock,
+					       pcb->moal_spin_unlock);
+		num++;
+	}
+	pmadapter->cmd_batch_num = num;
+	pmadapter->cmd_batch_done = 0;
+	wlan_release_cmd_lock(pmadapter);
+
+	if (!num)
+		goto done;
+
+	pbatch->command = wlan_cpu_to_le16(HostCmd_CMD_MULTI_CMD);
+	pbatch->size = wlan_cpu_to_le16((t_u16) offset);
+	pbatch->seq_num = wlan_cpu_to_le16(pmadapter->curr_cmd->seq_num);
+	pmulti_cmd = (HostCmd_DS_MULTI_CMD *) ((t_u8 *) pbatch + S_DS_GEN);
+	pmulti_cmd->num_cmd = wlan_cpu_to_le16(num);
+
+	pmbuf->buf_type = MLAN_BUF_TYPE_CMD;
+	pmbuf->data_offset = 0;
+	pmbuf->data_len = INTF_HEADER_LEN + offset;
+
+	PRINTM(MCMND, "DNLD_CMD: multi-command, %d commands, len %d\n", num,
+	       offset);
+	ret = wlan_sdio_host_to_card(pmadapter, MLAN_TYPE_CMD, pmbuf, MNULL);
+	if (ret == MLAN_STATUS_FAILURE) {
+		PRINTM(MERROR, "DNLD_CMD: Host to Card Failed\n");
+		pmadapter->dbg.num_cmd_host_to_card_failure++;
+		wlan_flush_cmd_batch(pmadapter, MLAN_ERROR_CMD_DNLD_FAIL);
+		goto done;
+	}
+
+	/* Save the command ids and actions to debug log */
+	pmadapter->dbg.num_cmd_batch++;
+	pmadapter->dbg.num_cmd_batched += num;
+	pcmd_node = pmadapter->curr_cmd;
+	while (pcmd_node != (cmd_ctrl_node *) & pmadapter->cmd_batch_q) {
+		pcmd = (HostCmd_DS_COMMAND *) (pcmd_node->cmdbuf->pbuf +
+					       pcmd_node->cmdbuf->data_offset +
+					       INTF_HEADER_LEN);
+		wlan_save_cmd_dbg(pmadapter, pcmd);
+		if (pcmd_node == pmadapter->curr_cmd)
+			pcmd_node = (cmd_ctrl_node *) pmadapter->cmd_batch_q.pnext;
+		else
+			pcmd_node = pcmd_node->pnext;
+	}
+
+	pcb->moal_get_system_time(pmadapter->pmoal_handle,
+				  &pmadapter->dnld_cmd_in_secs, &age_ts_usec);
+	/* Setup the timer after transmit command */
+	pcb->moal_start_timer(pmadapter->pmoal_handle,
+			      pmadapter->pmlan_cmd_timer, MFALSE,
+			      MRVDRV_TIMER_10S * 2);
+	pmadapter->cmd_timer_is_set = MTRUE;
+
+done:
+	LEAVE();
+	return ret;
+}
+
+/**
+ *  @brief This function fails a command of the batch in flight that
+ *  		firmware did not answer.
+ *
+ *  @param pmadapter    A pointer to mlan_adapter structure
+ *  @param pcmd_node    A pointer to cmd_ctrl_node structure
+ *
+ *  @return             N/A
+ */
+static t_void
+wlan_skip_batch_cmd(mlan_adapter * pmadapter, cmd_ctrl_node * pcmd_node)
+{
+	HostCmd_DS_COMMAND *pcmd;
+	mlan_ioctl_req *pioctl_buf = (mlan_ioctl_req *) pcmd_node->pioctl_buf;
+
+	pcmd = (HostCmd_DS_COMMAND *) (pcmd_node->cmdbuf->pbuf +
+				       pcmd_node->cmdbuf->data_offset +
+				       INTF_HEADER_LEN);
+	PRINTM(MERROR, "CMD_RESP: no response to 0x%x, seqno 0x%x\n",
+	       wlan_le16_to_cpu(pcmd->command), pcmd_node->seq_num);
+	if (pioctl_buf)
+		pioctl_buf->status_code = MLAN_ERROR_CMD_RESP_FAIL;
+	pmadapter->cmd_batch_done++;
+	wlan_insert_cmd_to_free_q(pmadapter, pcmd_node);
+}
+
+/**
+ *  @brief This function puts the commands of a batch firmware rejected
+ *  		back to the head of the pending queue, in order, so they
+ *  		are sent again one by one.
+ *
+ *  @param pmadapter    A pointer to mlan_adapter structure
+ *
+ *  @return             N/A
+ */
+static t_void
+wlan_requeue_cmd_batch(mlan_adapter * pmadapter)
+{
+	mlan_callbacks *pcb = (mlan_callbacks *) & pmadapter->callbacks;
+	cmd_ctrl_node *pcmd_list[MRVDRV_MAX_CMD_BATCH];
+	cmd_ctrl_node *pcmd_node;
+	int num = 0;
+
+	ENTER();
+
+	wlan_request_cmd_lock(pmadapter);
+	pcmd_node = pmadapter->curr_cmd;
+	while (pcmd_node && num < MRVDRV_MAX_CMD_BATCH) {
+		if (pcmd_node->respbuf) {
+			wlan_free_mlan_buffer(pmadapter, pcmd_node->respbuf);
+			pcmd_node->respbuf = MNULL;
+		}
+		pcmd_node->cmd_flag &= ~CMD_F_BATCH;
+		pcmd_node->cmdbuf->data_offset += INTF_HEADER_LEN;
+		pcmd_list[num++] = pcmd_node;
+		pcmd_node = (cmd_ctrl_node *)
+			util_dequeue_list(pmadapter->pmoal_handle,
+					  &pmadapter->cmd_batch_q,
+					  pcb->moal_spin_lock,
+					  pcb->moal_spin_unlock);
+	}
+	while (num--)
+		util_enqueue_list_head(pmadapter->pmoal_handle,
+				       &pmadapter->cmd_pending_q,
+				       (pmlan_linked_list) pcmd_list[num],
+				       pcb->moal_spin_lock,
+				       pcb->moal_spin_unlock);
+	pmadapter->curr_cmd = MNULL;
+	pmadapter->cmd_batch_num = 0;
+	pmadapter->cmd_batch_done = 0;
+	wlan_release_cmd_lock(pmadapter);
+
+	LEAVE();
+}
+
+/**
+ *  @brief This function matches a response to the batch in flight.
+ *  		Responses arrive in order, so a response to a later command
+ *  		means firmware dropped the ones before it; they are failed
+ *  		and the later command becomes curr_cmd.
+ *
+ *  @param pmadapter    A pointer to mlan_adapter structure
+ *  @param resp         A pointer to the response, in firmware byte order
+ *
+ *  @return             MLAN_STATUS_SUCCESS if curr_cmd owns the response,
+ *                      otherwise MLAN_STATUS_FAILURE
+ */
+static mlan_status
+wlan_match_batch_cmdresp(mlan_adapter * pmadapter, HostCmd_DS_COMMAND * resp)
+{
+	mlan_callbacks *pcb = (mlan_callbacks *) & pmadapter->callbacks;
+	cmd_ctrl_node *pcmd_node;
+	cmd_ctrl_node *pfree_node;
+	t_u16 command = wlan_le16_to_cpu(resp->command);
+	t_u16 seq_num = wlan_le16_to_cpu(resp->seq_num);
+	mlan_status ret = MLAN_STATUS_SUCCESS;
+
+	ENTER();
+
+	if ((command & HostCmd_CMD_ID_MASK) == HostCmd_CMD_MULTI_CMD) {
+		PRINTM(MERROR,
+		       "CMD_RESP: multi-command rejected, result %d, "
+		       "sending %d commands one by one\n",
+		       wlan_le16_to_cpu(resp->result),
+		       pmadapter->cmd_batch_num - pmadapter->cmd_batch_done);
+		pmadapter->cmd_batch_enabled = MFALSE;
+		wlan_requeue_cmd_batch(pmadapter);
+		ret = MLAN_STATUS_FAILURE;
+		goto done;
+	}
+	if (HostCmd_GET_SEQ_NO(seq_num) ==
+	    HostCmd_GET_SEQ_NO(pmadapter->curr_cmd->seq_num))
+		goto done;
+
+	wlan_request_cmd_lock(pmadapter);
+	pcmd_node = (cmd_ctrl_node *) util_peek_list(pmadapter->pmoal_handle,
+						     &pmadapter->cmd_batch_q,
+						     pcb->moal_spin_lock,
+						     pcb->moal_spin_unlock);
+	while (pcmd_node &&
+	       pcmd_node != (cmd_ctrl_node *) & pmadapter->cmd_batch_q) {
+		if (HostCmd_GET_SEQ_NO(pcmd_node->seq_num) ==
+		    HostCmd_GET_SEQ_NO(seq_num))
+			break;
+		pcmd_node = pcmd_node->pnext;
+	}
+	if (!pcmd_node ||
+	    pcmd_node == (cmd_ctrl_node *) & pmadapter->cmd_batch_q) {
+		wlan_release_cmd_lock(pmadapter);
+		PRINTM(MERROR,
+		       "CMD_RESP: 0x%x, seqno 0x%x matches no command in flight\n",
+		       command, seq_num);
+		wlan_free_mlan_buffer(pmadapter, pmadapter->curr_cmd->respbuf);
+		pmadapter->curr_cmd->respbuf = MNULL;
+		/* Keep waiting for the response of curr_cmd */
+		pcb->moal_start_timer(pmadapter->pmoal_handle,
+				      pmadapter->pmlan_cmd_timer, MFALSE,
+				      MRVDRV_TIMER_10S * 2);
+		pmadapter->cmd_timer_is_set = MTRUE;
+		ret = MLAN_STATUS_FAILURE;
+		goto done;
+	}
+	pcmd_node->respbuf = pmadapter->curr_cmd->respbuf;
+	pmadapter->curr_cmd->respbuf = MNULL;
+	pfree_node = pmadapter->curr_cmd;
+	pmadapter->curr_cmd = MNULL;
+	wlan_release_cmd_lock(pmadapter);
+
+	/* Fail the commands firmware skipped */
+	while (pfree_node != pcmd_node) {
+		wlan_skip_batch_cmd(pmadapter, pfree_node);
+		pfree_node = (cmd_ctrl_node *)
+			util_dequeue_list(pmadapter->pmoal_handle,
+					  &pmadapter->cmd_batch_q,
+					  pcb->moal_spin_lock,
+					  pcb->moal_spin_unlock);
+	}
+	wlan_request_cmd_lock(pmadapter);
+	pmadapter->curr_cmd = pcmd_node;
+	wlan_release_cmd_lock(pmadapter);
+
+	if (pmadapter->hw_status == WlanHardwareStatusInitializing) {
+		/* Initialization failed, drop the rest of the init commands */
+		PRINTM(MERROR, "command skipped during initialization\n");
+		wlan_flush_cmd_batch(pmadapter, MLAN_ERROR_CMD_RESP_FAIL);
+		wlan_cancel_all_pending_cmd(pmadapter);
+		wlan_init_fw_complete(pmadapter);
+		ret = MLAN_STATUS_FAILURE;
+	}
+
+done:
+	LEAVE();
+	return ret;
+}
+
+/**
+ *  @brief This function makes the next command of the batch in flight
+ *  		curr_cmd once the current one is answered, and restarts the
+ *  		command timer for it.
+ *
+ *  @param pmadapter    A pointer to mlan_adapter structure
+ *
+ *  @return             N/A
+ */
+static t_void
+wlan_next_batch_cmd(mlan_adapter * pmadapter)
+{
+	mlan_callbacks *pcb = (mlan_callbacks *) & pmadapter->callbacks;
+	cmd_ctrl_node *pcmd_node = MNULL;
+
+	ENTER();
+
+	wlan_request_cmd_lock(pmadapter);
+	if (!pmadapter->cmd_batch_num || pmadapter->curr_cmd) {
+		wlan_release_cmd_lock(pmadapter);
+		LEAVE();
+		return;
+	}
+	pmadapter->cmd_batch_done++;
+	pcmd_node = (cmd_ctrl_node *) util_dequeue_list(pmadapter->pmoal_handle,
+							&pmadapter->cmd_batch_q,
+							pcb->moal_spin_lock,
+							pcb->moal_spin_unlock);
+	pmadapter->curr_cmd = pcmd_node;
+	if (!pcmd_node) {
+		pmadapter->cmd_batch_num = 0;
+		pmadapter->cmd_batch_done = 0;
+	}
+	wlan_release_cmd_lock(pmadapter);
+
+	if (pcmd_node) {
+		pcb->moal_start_timer(pmadapter->pmoal_handle,
+				      pmadapter->pmlan_cmd_timer, MFALSE,
+				      MRVDRV_TIMER_10S * 2);
+		pmadapter->cmd_timer_is_set = MTRUE;
+	}
+
+	LEAVE();
+}
+
+/**
+ *  @brief This function cancels the ioctls of the commands waiting in
+ *  		the batch in flight. The commands stay in flight and are
+ *  		freed when their responses arrive. The caller holds the
+ *  		command lock.
+ *
+ *  @param pmadapter    A pointer to mlan_adapter structure
+ *  @param pioctl_req   The ioctl to cancel, MNULL to cancel by BSS
+ *  @param bss_index    BSS index, MLAN_MAX_BSS_NUM for all
+ *
+ *  @return             MTRUE if a command was cancelled
+ */
+static t_u8
+wlan_cancel_batch_cmd(pmlan_adapter pmadapter, pmlan_ioctl_req pioctl_req,
+		      t_u32 bss_index)
+{
+	mlan_callbacks *pcb = (mlan_callbacks *) & pmadapter->callbacks;
+	cmd_ctrl_node *pcmd_node;
+	mlan_ioctl_req *pioctl_buf;
+	t_u8 find = MFALSE;
+
+	pcmd_node = (cmd_ctrl_node *) util_peek_list(pmadapter->pmoal_handle,
+						     &pmadapter->cmd_batch_q,
+						     pcb->moal_spin_lock,
+						     pcb->moal_spin_unlock);
+	while (pcmd_node &&
+	       pcmd_node != (cmd_ctrl_node *) & pmadapter->cmd_batch_q) {
+		pioctl_buf = (mlan_ioctl_req *) pcmd_node->pioctl_buf;
+		if (pioctl_buf &&
+		    (pioctl_req ? (pioctl_buf == pioctl_req) :
+		     (bss_index == MLAN_MAX_BSS_NUM ||
+		      pioctl_buf->bss_index == bss_index))) {
+			pcmd_node->pioctl_buf = MNULL;
+			pcmd_node->cmd_flag |= CMD_F_CANCELED;
+			find = MTRUE;
+			if (!pioctl_req) {
+				pioctl_buf->status_code = MLAN_ERROR_CMD_CANCEL;
+				pcb->moal_ioctl_complete(pmadapter->
+							 pmoal_handle,
+							 pioctl_buf,
+							 MLAN_STATUS_FAILURE);
+			}
+		}
+		pcmd_node = pcmd_node->pnext;
+	}
+	return find;
+}
+
 /**
  *  @brief This function sends sleep confirm command to firmware.
  *
@@ -993,6 +1602,18 @@ wlan_alloc_cmd_buffer(IN mlan_adapter * pmadapter)
 		}
 	}
 
+	/* Allocate the multi-command transfer buffer */
+	pmadapter->pcmd_batch_buf = wlan_alloc_mlan_buffer(pmadapter,
+							   MRVDRV_SIZE_OF_CMD_BUFFER,
+							   0,
+							   MOAL_MALLOC_BUFFER);
+	if (!pmadapter->pcmd_batch_buf) {
+		PRINTM(MERROR,
+		       "ALLOC_CMD_BUF: Failed to allocate multi-command buffer\n");
+		ret = MLAN_STATUS_FAILURE;
+		goto done;
+	}
+
 	for (i = 0; i < MRVDRV_NUM_OF_CMD_BUFFER; i++) {
 		wlan_insert_cmd_to_free_q(pmadapter, &pcmd_array[i]);
 	}
@@ -1038,6 +1659,10 @@ wlan_free_cmd_buffer(IN mlan_adapter * pmadapter)
 			pcmd_array[i].respbuf = MNULL;
 		}
 	}
+	if (pmadapter->pcmd_batch_buf) {
+		wlan_free_mlan_buffer(pmadapter, pmadapter->pcmd_batch_buf);
+		pmadapter->pcmd_batch_buf = MNULL;
+	}
 	/* Release cmd_ctrl_node */
 	if (pmadapter->cmd_pool) {
 		PRINTM(MINFO, "Free command pool.\n");
@@ -1443,13 +2068,18 @@ wlan_exec_next_cmd(mlan_adapter * pmadapter)
 			goto done;
 		}
 
-		util_unlink_list(pmadapter->pmoal_handle,
-				 &pmadapter->cmd_pending_q,
-				 (pmlan_linked_list) pcmd_node,
-				 pmadapter->callbacks.moal_spin_lock,
-				 pmadapter->callbacks.moal_spin_unlock);
-		wlan_release_cmd_lock(pmadapter);
-		ret = wlan_dnld_cmd_to_fw(priv, pcmd_node);
+		if (wlan_get_cmd_batch_num(pmadapter) > 1) {
+			wlan_release_cmd_lock(pmadapter);
+			ret = wlan_dnld_cmd_batch(pmadapter);
+		} else {
+			util_unlink_list(pmadapter->pmoal_handle,
+					 &pmadapter->cmd_pending_q,
+					 (pmlan_linked_list) pcmd_node,
+					 pmadapter->callbacks.moal_spin_lock,
+					 pmadapter->callbacks.moal_spin_unlock);
+			wlan_release_cmd_lock(pmadapter);
+			ret = wlan_dnld_cmd_to_fw(priv, pcmd_node);
+		}
 		priv = wlan_get_priv(pmadapter, MLAN_BSS_ROLE_ANY);
 		/* Any command sent to the firmware when host is in sleep mode,
 		   should de-configure host sleep */
@@ -1535,6 +2165,14 @@ wlan_process_cmdresp(mlan_adapter * pmadapter)
 	resp = (HostCmd_DS_COMMAND *) (pmadapter->curr_cmd->respbuf->pbuf +
 				       pmadapter->curr_cmd->respbuf->
 				       data_offset);
+	if (pmadapter->curr_cmd->cmd_flag & CMD_F_BATCH) {
+		if (wlan_match_batch_cmdresp(pmadapter, resp) !=
+		    MLAN_STATUS_SUCCESS) {
+			ret = MLAN_STATUS_FAILURE;
+			goto done;
+		}
+		pioctl_buf = (mlan_ioctl_req *) pmadapter->curr_cmd->pioctl_buf;
+	}
 	wlan_request_cmd_lock(pmadapter);
 	if (pmadapter->curr_cmd->cmd_flag & CMD_F_CANCELED) {
 		cmd_ctrl_node *free_cmd = pmadapter->curr_cmd;
@@ -1576,6 +2214,7 @@ wlan_process_cmdresp(mlan_adapter * pmadapter)
 		(pmadapter->dbg.last_cmd_resp_index + 1) % DBG_CMD_NUM;
 	pmadapter->dbg.last_cmd_resp_id[pmadapter->dbg.last_cmd_resp_index] =
 		orig_cmdresp_no;
+	wlan_save_cmd_resp_lat(pmadapter, cmdresp_no);
 
 	PRINTM_GET_SYS_TIME(MCMND, &sec, &usec);
 	PRINTM_NETINTF(MCMND, pmadapter->curr_cmd->priv);
@@ -1687,6 +2326,7 @@ wlan_process_cmdresp(mlan_adapter * pmadapter)
 	}
 
 done:
+	wlan_next_batch_cmd(pmadapter);
 	LEAVE();
 	return ret;
 }
@@ -1703,6 +2343,8 @@ wlan_cmd_timeout_func(t_void * function_context)
 {
 	mlan_adapter *pmadapter = (mlan_adapter *) function_context;
 	cmd_ctrl_node *pcmd_node = MNULL;
+	cmd_ctrl_node *pnext_node = MNULL;
+	HostCmd_DS_COMMAND *pcmd;
 	mlan_ioctl_req *pioctl_buf = MNULL;
 #ifdef DEBUG_LEVEL1
 	t_u32 sec = 0, usec = 0;
@@ -1729,6 +2371,34 @@ wlan_cmd_timeout_func(t_void * function_context)
 		pmadapter->dbg.last_cmd_id[pmadapter->dbg.last_cmd_index];
 	pmadapter->dbg.timeout_cmd_act =
 		pmadapter->dbg.last_cmd_act[pmadapter->dbg.last_cmd_index];
+	if (pcmd_node->cmd_flag & CMD_F_BATCH) {
+		/* The oldest unanswered command of the batch is stuck */
+		pcmd = (HostCmd_DS_COMMAND *) (pcmd_node->cmdbuf->pbuf +
+					       pcmd_node->cmdbuf->data_offset +
+					       INTF_HEADER_LEN);
+		pmadapter->dbg.timeout_cmd_id =
+			wlan_le16_to_cpu(pcmd->command);
+		pmadapter->dbg.timeout_cmd_act =
+			wlan_le16_to_cpu(*(t_u16 *) ((t_u8 *) pcmd + S_DS_GEN));
+		PRINTM(MERROR,
+		       "Timeout in multi-command: command %d of %d, seqno 0x%x\n",
+		       pmadapter->cmd_batch_done + 1, pmadapter->cmd_batch_num,
+		       pcmd_node->seq_num);
+		wlan_request_cmd_lock(pmadapter);
+		pnext_node = (cmd_ctrl_node *)
+			util_peek_list(pmadapter->pmoal_handle,
+				       &pmadapter->cmd_batch_q,
+				       pmadapter->callbacks.moal_spin_lock,
+				       pmadapter->callbacks.moal_spin_unlock);
+		while (pnext_node &&
+		       pnext_node != (cmd_ctrl_node *) & pmadapter->cmd_batch_q) {
+			if (pnext_node->pioctl_buf)
+				((mlan_ioctl_req *) pnext_node->pioctl_buf)->
+					status_code = MLAN_ERROR_CMD_TIMEOUT;
+			pnext_node = pnext_node->pnext;
+		}
+		wlan_release_cmd_lock(pmadapter);
+	}
 	PRINTM_GET_SYS_TIME(MERROR, &sec, &usec);
 	PRINTM(MERROR, "Timeout cmd id (%lu.%06lu) = 0x%x, act = 0x%x \n", sec,
 	       usec, pmadapter->dbg.timeout_cmd_id,
@@ -1907,9 +2577,11 @@ wlan_cancel_all_pending_cmd(pmlan_adapter pmadapter)
 		pioctl_buf->status_code = MLAN_ERROR_CMD_CANCEL;
 		pcb->moal_ioctl_complete(pmadapter->pmoal_handle, pioctl_buf,
 					 MLAN_STATUS_FAILURE);
-	} else {
-		wlan_release_cmd_lock(pmadapter);
+		wlan_request_cmd_lock(pmadapter);
 	}
+	/* Cancel the rest of the batch in flight */
+	wlan_cancel_batch_cmd(pmadapter, MNULL, MLAN_MAX_BSS_NUM);
+	wlan_release_cmd_lock(pmadapter);
 	/* Cancel all pending command */
 	while ((pcmd_node =
 		(cmd_ctrl_node *) util_peek_list(pmadapter->pmoal_handle,
@@ -1987,6 +2659,7 @@ wlan_cancel_bss_pending_cmd(pmlan_adapter pmadapter, t_u32 bss_index)
 						 MLAN_STATUS_FAILURE);
 		}
 	}
+	wlan_cancel_batch_cmd(pmadapter, MNULL, bss_index);
 	while ((pcmd_node =
 		wlan_get_bss_pending_ioctl_cmd(pmadapter,
 					       bss_index)) != MNULL) {
@@ -2056,6 +2729,8 @@ wlan_cancel_pending_ioctl(pmlan_adapter pmadapter, pmlan_ioctl_req pioctl_req)
 		pcmd_node->cmd_flag |= CMD_F_CANCELED;
 		find = MTRUE;
 	}
+	if (wlan_cancel_batch_cmd(pmadapter, pioctl_req, MLAN_MAX_BSS_NUM))
+		find = MTRUE;
 
 	while ((pcmd_node =
 		wlan_get_pending_ioctl_cmd(pmadapter, pioctl_req)) != MNULL) {
@@ -3291,6 +3966,11 @@ wlan_ret_get_hw_spec(IN pmlan_private pmpriv,
 	ENTER();
 
 	pmadapter->fw_cap_info = wlan_le32_to_cpu(hw_spec->fw_cap_info);
+	pmadapter->cmd_batch_enabled =
+		(pmadapter->init_para.multi_cmd_cfg == MLAN_INIT_PARA_ENABLED &&
+		 IS_SUPPORT_MULTI_CMD(pmadapter)) ? MTRUE : MFALSE;
+	PRINTM(MCMND, "GET_HW_SPEC: multi-command %s\n",
+	       pmadapter->cmd_batch_enabled ? "enabled" : "disabled");
 #ifdef STA_SUPPORT
 	if (IS_SUPPORT_MULTI_BANDS(pmadapter)) {
 		pmadapter->fw_bands = (t_u8) GET_FW_DEFAULT_BANDS(pmadapter);
@@ -113,6 +113,15 @@ typedef MLAN_PACK_START struct {
 #define GET_FW_DEFAULT_BANDS(_adapter)  \
 	((_adapter->fw_cap_info >> 8) & ALL_802_11_BANDS)
 
+/** Firmware accepts HostCmd_CMD_MULTI_CMD. No shipping firmware
+ *  implements it or sets this bit, only the mlansim firmware does, so
+ *  do not enable the multi_cmd module parameter on real hardware. The
+ *  host ignores the bit unless multi_cmd_cfg enables batching. */
+#define FW_MULTI_CMD_SUPPORT    MBIT(20)
+/** Check if multiple commands per transfer are supported by firmware */
+#define IS_SUPPORT_MULTI_CMD(_adapter)  \
+	(_adapter->fw_cap_info & FW_MULTI_CMD_SUPPORT)
+
 extern t_u8 SupportedRates_B[B_SUPPORTED_RATES];
 extern t_u8 SupportedRates_G[G_SUPPORTED_RATES];
 extern t_u8 SupportedRates_BG[BG_SUPPORTED_RATES];
@@ -947,6 +956,10 @@ typedef enum _WLAN_802_11_WEP_STATUS {
 /** Host Command ID: reject addba request */
 #define HostCmd_CMD_REJECT_ADDBA_REQ         0x0119
 
+/** Host Command ID: multiple commands in one transfer. Proposed, no
+ *  shipping firmware implements it, see FW_MULTI_CMD_SUPPORT */
+#define HostCmd_CMD_MULTI_CMD                0x011a
+
 /** Enhanced PS modes */
 typedef enum _ENH_PS_MODES {
 	GET_PS = 0,
@@ -1048,6 +1061,11 @@ typedef enum _ENH_PS_MODES {
 #define CMD_F_HOSTCMD           (1 << 0)
 /** command cancel flag in command */
 #define CMD_F_CANCELED          (1 << 1)
+/** command sent in a HostCmd_CMD_MULTI_CMD batch */
+#define CMD_F_BATCH             (1 << 2)
+
+/** Maximum number of commands in a HostCmd_CMD_MULTI_CMD batch */
+#define MRVDRV_MAX_CMD_BATCH            8
 
 /** Host Command ID bit mask (bit 11:0) */
 #define HostCmd_CMD_ID_MASK             0x0fff
@@ -2218,6 +2236,16 @@ typedef MLAN_PACK_START struct _HostCmd_DS_GET_HW_SPEC {
 	t_u16 mgmt_buf_count;
 } MLAN_PACK_END HostCmd_DS_GET_HW_SPEC;
 
+/** HostCmd_DS_MULTI_CMD (proposed, see FW_MULTI_CMD_SUPPORT): the
+ *  commands follow back to back, each with
+ *  its own HostCmd_DS_GEN header. Firmware runs them in order and sends
+ *  one response per command; a response to HostCmd_CMD_MULTI_CMD itself
+ *  means the whole batch was rejected and nothing was run. */
+typedef MLAN_PACK_START struct _HostCmd_DS_MULTI_CMD {
+    /** Number of commands */
+	t_u16 num_cmd;
+} MLAN_PACK_END HostCmd_DS_MULTI_CMD;
+
 /**  HostCmd_DS_802_11_CFG_DATA */
 typedef MLAN_PACK_START struct _HostCmd_DS_802_11_CFG_DATA {
     /** Action */
@@ -1418,6 +1418,8 @@ typedef struct _BSSDescriptor_t {
 	t_u32 beacon_buf_size;
     /** Max allocated size for updated scan response */
 	t_u32 beacon_buf_size_max;
+    /** System time (seconds) this entry was last updated by a scan */
+	t_u32 age_in_secs;
 
 } BSSDescriptor_t, *pBSSDescriptor_t;
 
@@ -462,6 +462,11 @@ wlan_init_adapter(pmlan_adapter pmadapter)
 		pmadapter->mpa_rx.enabled = MTRUE;
 	}
 	pmadapter->mpa_rx.pkt_aggr_limit = SDIO_MP_AGGR_DEF_PKT_LIMIT;
+	/* copy is the default, slicing only when asked for */
+	if (pmadapter->init_para.mpa_rx_slice_cfg == MLAN_INIT_PARA_ENABLED)
+		pmadapter->mpa_rx.slice = MTRUE;
+	else
+		pmadapter->mpa_rx.slice = MFALSE;
 #endif /* SDIO_MULTI_PORT_RX_AGGR */
 
 	pmadapter->cmd_resp_received = MFALSE;
@@ -497,15 +502,10 @@ wlan_init_adapter(pmlan_adapter pmadapter)
 	pmadapter->active_scan_time = MRVDRV_ACTIVE_SCAN_CHAN_TIME;
 	pmadapter->passive_scan_time = MRVDRV_PASSIVE_SCAN_CHAN_TIME;
 
-	pmadapter->num_in_scan_table = 0;
-	memset(pmadapter, pmadapter->pscan_table, 0,
-	       (sizeof(BSSDescriptor_t) * MRVDRV_MAX_BSSID_LIST));
+	wlan_flush_scan_table(pmadapter);
 	pmadapter->ext_scan = 0;
 	pmadapter->scan_probes = DEFAULT_PROBES;
 
-	memset(pmadapter, pmadapter->bcn_buf, 0, pmadapter->bcn_buf_size);
-	pmadapter->pbcn_buf_end = pmadapter->bcn_buf;
-
 	pmadapter->radio_on = RADIO_ON;
 	pmadapter->multiple_dtim = MRVDRV_DEFAULT_MULTIPLE_DTIM;
 
@@ -597,6 +597,9 @@ wlan_init_adapter(pmlan_adapter pmadapter)
 	pmadapter->pscan_channels = MNULL;
 	pmadapter->fw_release_number = 0;
 	pmadapter->fw_cap_info = 0;
+	pmadapter->cmd_batch_enabled = MFALSE;
+	pmadapter->cmd_batch_num = 0;
+	pmadapter->cmd_batch_done = 0;
 	memset(pmadapter, &pmadapter->upld_buf, 0, sizeof(pmadapter->upld_buf));
 	pmadapter->upld_len = 0;
 	pmadapter->event_cause = 0;
@@ -667,6 +670,15 @@ wlan_init_lock_list(IN pmlan_adapter pmadapter)
 		ret = MLAN_STATUS_FAILURE;
 		goto error;
 	}
+#ifdef SDIO_MULTI_PORT_RX_AGGR
+	if (pcb->
+	    moal_init_lock(pmadapter->pmoal_handle,
+			   &pmadapter->mpa_rx.slice_lock)
+	    != MLAN_STATUS_SUCCESS) {
+		ret = MLAN_STATUS_FAILURE;
+		goto error;
+	}
+#endif
 	for (i = 0; i < pmadapter->priv_num; i++) {
 		if (pmadapter->priv[i]) {
 			priv = pmadapter->priv[i];
@@ -711,6 +723,10 @@ wlan_init_lock_list(IN pmlan_adapter pmadapter)
 	util_init_list_head((t_void *) pmadapter->pmoal_handle,
 			    &pmadapter->cmd_pending_q, MTRUE,
 			    pmadapter->callbacks.moal_init_lock);
+	/* Initialize cmd_batch_q */
+	util_init_list_head((t_void *) pmadapter->pmoal_handle,
+			    &pmadapter->cmd_batch_q, MTRUE,
+			    pmadapter->callbacks.moal_init_lock);
 	/* Initialize scan_pending_q */
 	util_init_list_head((t_void *) pmadapter->pmoal_handle,
 			    &pmadapter->scan_pending_q, MTRUE,
@@ -733,6 +749,12 @@ wlan_init_lock_list(IN pmlan_adapter pmadapter)
 						    ra_list, MTRUE,
 						    priv->adapter->callbacks.
 						    moal_init_lock);
+				util_init_list_head((t_void *) pmadapter->
+						    pmoal_handle,
+						    &priv->wmm.tid_tbl_ptr[j].
+						    active_ra, MFALSE,
+						    priv->adapter->callbacks.
+						    moal_init_lock);
 			}
 			util_init_list_head((t_void *) pmadapter->pmoal_handle,
 					    &priv->tx_ba_stream_tbl_ptr, MTRUE,
@@ -801,6 +823,11 @@ wlan_free_lock_list(IN pmlan_adapter pmadapter)
 	if (pmadapter->pmlan_cmd_lock)
 		pcb->moal_free_lock(pmadapter->pmoal_handle,
 				    pmadapter->pmlan_cmd_lock);
+#ifdef SDIO_MULTI_PORT_RX_AGGR
+	if (pmadapter->mpa_rx.slice_lock)
+		pcb->moal_free_lock(pmadapter->pmoal_handle,
+				    pmadapter->mpa_rx.slice_lock);
+#endif
 
 	for (i = 0; i < pmadapter->priv_num; i++) {
 		if (pmadapter->priv[i]) {
@@ -834,6 +861,10 @@ wlan_free_lock_list(IN pmlan_adapter pmadapter)
 			    &pmadapter->cmd_pending_q,
 			    pmadapter->callbacks.moal_free_lock);
 
+	util_free_list_head((t_void *) pmadapter->pmoal_handle,
+			    &pmadapter->cmd_batch_q,
+			    pmadapter->callbacks.moal_free_lock);
+
 	util_free_list_head((t_void *) pmadapter->pmoal_handle,
 			    &pmadapter->scan_pending_q,
 			    pmadapter->callbacks.moal_free_lock);
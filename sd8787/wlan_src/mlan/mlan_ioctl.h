@@ -1441,6 +1441,16 @@ typedef struct _mlan_debug_info {
 	t_u16 last_event_index;
     /** Number of no free command node */
 	t_u16 num_no_cmd_node;
+    /** List of last command response latencies in msec */
+	t_u16 last_cmd_resp_lat[DBG_CMD_NUM];
+    /** Longest command response latency in usec */
+	t_u32 max_cmd_resp_lat;
+    /** ID of the command with the longest response latency */
+	t_u16 max_lat_cmd_id;
+    /** Number of multi-command transfers */
+	t_u32 num_cmd_batch;
+    /** Number of commands sent in multi-command transfers */
+	t_u32 num_cmd_batched;
     /** pending command id */
 	t_u16 pending_cmd;
     /** time stamp for dnld last cmd */
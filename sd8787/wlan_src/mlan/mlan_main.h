@@ -408,6 +408,11 @@ do {                                    \
  */
 #define SCAN_BEACON_ENTRY_PAD          6
 
+/** Number of hash buckets indexing the scan table by BSSID and by SSID */
+#define SCAN_TABLE_HASH_SIZE           64
+/** End of a scan table hash chain */
+#define SCAN_TABLE_IDX_NONE            (-1)
+
 /** Scan time specified in the channel TLV for each channel for passive scans */
 #define MRVDRV_PASSIVE_SCAN_CHAN_TIME       200
 
@@ -526,6 +531,16 @@ typedef struct _wlan_dbg {
 	t_u16 last_event_index;
     /** Number of no free command node */
 	t_u16 num_no_cmd_node;
+    /** List of last command response latencies in msec */
+	t_u16 last_cmd_resp_lat[DBG_CMD_NUM];
+    /** Longest command response latency in usec */
+	t_u32 max_cmd_resp_lat;
+    /** ID of the command with the longest response latency */
+	t_u16 max_lat_cmd_id;
+    /** Number of multi-command transfers */
+	t_u32 num_cmd_batch;
+    /** Number of commands sent in multi-command transfers */
+	t_u32 num_cmd_batched;
 } wlan_dbg;
 
 /** Hardware status codes */
@@ -563,6 +578,12 @@ typedef enum _PS_STATE {
 /** Minimum flush timer for win size of 1 is 15 ms */
 #define MIN_FLUSH_TIMER_15_MS 15
 
+/** Number of (TA, TID) buckets of the RX reorder table, power of 2 */
+#define RX_REORDER_HASH_SIZE	64
+
+/** RX reorder table */
+typedef struct _RxReorderTbl RxReorderTbl;
+
 /** Tx BA stream table */
 typedef struct _TxBAStreamTbl TxBAStreamTbl;
 
@@ -593,6 +614,19 @@ typedef struct _txAggr_t {
 /** RA list table */
 typedef struct _raListTbl raListTbl;
 
+/** RA list active ring node */
+typedef struct _ralist_active_node ralist_active_node;
+
+/** RA list active ring node */
+struct _ralist_active_node {
+    /** Pointer to previous node */
+	ralist_active_node *pprev;
+    /** Pointer to next node */
+	ralist_active_node *pnext;
+    /** Pointer to the RA list */
+	raListTbl *ra_list;
+};
+
 /** RA list table */
 struct _raListTbl {
     /** Pointer to previous node */
@@ -615,6 +649,14 @@ struct _raListTbl {
 	t_u16 max_amsdu;
 	/** tx_pause flag */
 	t_u8 tx_pause;
+	/** TID of this RA list */
+	t_u8 tid;
+	/** RA list is linked in the TID's active ring */
+	t_u8 active;
+	/** Node in the TID's active ring */
+	ralist_active_node active_node;
+	/** Next RA list in the same hash bucket */
+	raListTbl *hnext;
 };
 
 /** TID table */
@@ -623,8 +665,13 @@ typedef struct _tidTbl {
 	mlan_list_head ra_list;
     /** Current RA list */
 	raListTbl *ra_list_curr;
+    /** Ring of RA lists with unpaused packets, in round robin order */
+	mlan_list_head active_ra;
 } tid_tbl_t;
 
+/** Number of RA list hash buckets, must be a power of 2 */
+#define WMM_RALIST_HASH_SIZE	64
+
 /** Highest priority setting for a packet (uses voice AC) */
 #define WMM_HIGHEST_PRIORITY  7
 /** Highest priority TID  */
@@ -665,6 +712,10 @@ typedef struct _wmm_desc {
 	mlan_scalar tx_pkts_queued;
     /** Tracks highest priority with a packet queued */
 	mlan_scalar highest_queued_prio;
+    /** Bitmap of TIDs whose active ring is not empty */
+	t_u8 tid_active_bitmap;
+    /** RA lists hashed on RA and TID */
+	raListTbl *ralist_hash[WMM_RALIST_HASH_SIZE];
 } wmm_desc_t;
 
 /** Security structure */
@@ -1062,6 +1113,8 @@ typedef struct _mlan_private {
 	t_u16 rx_seq[MAX_NUM_TID];
     /** Pointer to the Receive Reordering table*/
 	mlan_list_head rx_reorder_tbl_ptr;
+    /** Receive Reordering table entries hashed on (TA, TID) */
+	RxReorderTbl *rx_reorder_hash[RX_REORDER_HASH_SIZE];
     /** Lock for Rx packets */
 	t_void *rx_pkt_lock;
 
@@ -1131,9 +1184,6 @@ struct _TxBAStreamTbl {
 	t_u8 amsdu;
 };
 
-/** RX reorder table */
-typedef struct _RxReorderTbl RxReorderTbl;
-
 typedef struct {
     /** Timer for flushing */
 	t_void *timer;
@@ -1163,6 +1213,12 @@ struct _RxReorderTbl {
 	int win_size;
     /** Pointer to pointer to RxReorderTbl */
 	t_void **rx_reorder_ptr;
+    /** Occupancy bitmap of rx_reorder_ptr, one bit per slot */
+	t_u32 *rx_reorder_bitmap;
+    /** Slot of start_win in rx_reorder_ptr, the window is circular */
+	int win_head;
+    /** Next entry in the same rx_reorder_hash bucket */
+	RxReorderTbl *hnext;
     /** Timer context */
 	reorder_tmr_cnxt_t timer_context;
     /** BA stream status */
@@ -1223,6 +1279,12 @@ struct _cmd_ctrl_node {
 	t_void *pioctl_buf;
     /** pre_allocated mlan_buffer for cmd */
 	mlan_buffer *pmbuf;
+    /** Sequence number the command was sent with */
+	t_u16 seq_num;
+    /** Download time stamp, seconds */
+	t_u32 dnld_sec;
+    /** Download time stamp, micro seconds */
+	t_u32 dnld_usec;
 };
 
 /** station node */
@@ -1441,6 +1503,10 @@ typedef struct _sdio_mpa_rx {
 	t_u32 buf_size;
 	/** multiport rx aggregation pkt aggr limit */
 	t_u32 pkt_aggr_limit;
+	/** deaggregate by slicing the aggregate instead of copying */
+	t_u8 slice;
+	/** lock protecting the use_count of slice parents */
+	t_void *slice_lock;
 } sdio_mpa_rx;
 #endif /* SDIO_MULTI_PORT_RX_AGGR */
 
@@ -1461,7 +1527,11 @@ typedef struct _mlan_init_para {
 #ifdef SDIO_MULTI_PORT_RX_AGGR
     /** SDIO MPA Rx */
 	t_u32 mpa_rx_cfg;
+    /** SDIO MPA Rx slice deaggregation */
+	t_u32 mpa_rx_slice_cfg;
 #endif
+    /** Multi-command transfers */
+	t_u32 multi_cmd_cfg;
     /** Auto deep sleep */
 	t_u32 auto_ds;
     /** IEEE PS mode */
@@ -1650,12 +1720,22 @@ typedef struct _mlan_adapter {
 	t_u8 cmd_timer_is_set;
     /** time stamp for command dnld */
 	t_u32 dnld_cmd_in_secs;
+    /** Multi-command transfers enabled */
+	t_u8 cmd_batch_enabled;
+    /** Commands in the batch in flight */
+	t_u8 cmd_batch_num;
+    /** Commands of the batch in flight answered so far */
+	t_u8 cmd_batch_done;
+    /** Buffer for multi-command transfers */
+	mlan_buffer *pcmd_batch_buf;
 
     /** Command Queues */
     /** Free command buffers */
 	mlan_list_head cmd_free_q;
     /** Pending command buffers */
 	mlan_list_head cmd_pending_q;
+    /** Commands of the batch in flight, waiting behind curr_cmd */
+	mlan_list_head cmd_batch_q;
     /** Command queue for scanning */
 	mlan_list_head scan_pending_q;
     /** mlan_processing */
@@ -1699,6 +1779,14 @@ typedef struct _mlan_adapter {
 
     /** Number of records in the scan table */
 	t_u32 num_in_scan_table;
+    /** Scan table entries hashed by BSSID, each chain in table order */
+	t_s16 scan_bssid_hash[SCAN_TABLE_HASH_SIZE];
+    /** Next entry in the same BSSID hash chain */
+	t_s16 scan_bssid_next[MRVDRV_MAX_BSSID_LIST];
+    /** Scan table entries hashed by SSID, each chain in table order */
+	t_s16 scan_ssid_hash[SCAN_TABLE_HASH_SIZE];
+    /** Next entry in the same SSID hash chain */
+	t_s16 scan_ssid_next[MRVDRV_MAX_BSSID_LIST];
     /** Scan probes */
 	t_u16 scan_probes;
 
@@ -1978,6 +2066,11 @@ mlan_status wlan_alloc_sdio_mpa_buffers(IN mlan_adapter * pmadapter,
 mlan_status wlan_free_sdio_mpa_buffers(IN mlan_adapter * pmadapter);
 #endif
 
+#ifdef SDIO_MULTI_PORT_RX_AGGR
+/** Drop the reference an Rx slice holds on its aggregate */
+t_void wlan_release_rx_slice(mlan_adapter * pmadapter, pmlan_buffer pmbuf);
+#endif
+
 /** Process write data complete */
 mlan_status wlan_write_data_complete(pmlan_adapter pmlan_adapter,
 				     pmlan_buffer pmbuf, mlan_status status);
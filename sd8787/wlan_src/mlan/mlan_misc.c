@@ -448,6 +448,13 @@ wlan_get_info_debug_info(IN pmlan_adapter pmadapter,
 		       sizeof(pmadapter->dbg.last_event));
 		pmadapter->dbg.last_event_index = debug_info->last_event_index;
 		pmadapter->dbg.num_no_cmd_node = debug_info->num_no_cmd_node;
+		memcpy(pmadapter, pmadapter->dbg.last_cmd_resp_lat,
+		       debug_info->last_cmd_resp_lat,
+		       sizeof(pmadapter->dbg.last_cmd_resp_lat));
+		pmadapter->dbg.max_cmd_resp_lat = debug_info->max_cmd_resp_lat;
+		pmadapter->dbg.max_lat_cmd_id = debug_info->max_lat_cmd_id;
+		pmadapter->dbg.num_cmd_batch = debug_info->num_cmd_batch;
+		pmadapter->dbg.num_cmd_batched = debug_info->num_cmd_batched;
 		pmadapter->dnld_cmd_in_secs = debug_info->dnld_cmd_in_secs;
 		pmadapter->data_sent = debug_info->data_sent;
 		pmadapter->cmd_sent = debug_info->cmd_sent;
@@ -549,6 +556,13 @@ wlan_get_info_debug_info(IN pmlan_adapter pmadapter,
 		       sizeof(pmadapter->dbg.last_event));
 		debug_info->last_event_index = pmadapter->dbg.last_event_index;
 		debug_info->num_no_cmd_node = pmadapter->dbg.num_no_cmd_node;
+		memcpy(pmadapter, debug_info->last_cmd_resp_lat,
+		       pmadapter->dbg.last_cmd_resp_lat,
+		       sizeof(pmadapter->dbg.last_cmd_resp_lat));
+		debug_info->max_cmd_resp_lat = pmadapter->dbg.max_cmd_resp_lat;
+		debug_info->max_lat_cmd_id = pmadapter->dbg.max_lat_cmd_id;
+		debug_info->num_cmd_batch = pmadapter->dbg.num_cmd_batch;
+		debug_info->num_cmd_batched = pmadapter->dbg.num_cmd_batched;
 		debug_info->pending_cmd =
 			(pmadapter->curr_cmd) ? pmadapter->dbg.
 			last_cmd_id[pmadapter->dbg.last_cmd_index] : 0;
@@ -883,6 +897,10 @@ wlan_free_mlan_buffer(mlan_adapter * pmadapter, pmlan_buffer pmbuf)
 	if (pcb && pmbuf) {
 		if (pmbuf->flags & MLAN_BUF_FLAG_BRIDGE_BUF)
 			pmadapter->pending_bridge_pkts--;
+#ifdef SDIO_MULTI_PORT_RX_AGGR
+		if (pmbuf->flags & MLAN_BUF_FLAG_RX_SLICE)
+			wlan_release_rx_slice(pmadapter, pmbuf);
+#endif
 		if (pmbuf->flags & MLAN_BUF_FLAG_MALLOC_BUF)
 			pcb->moal_mfree(pmadapter->pmoal_handle,
 					(t_u8 *) pmbuf);
@@ -277,12 +277,257 @@ radio_type_to_band(t_u8 radio_type)
 	return ret_band;
 }
 
+/**
+ *  @brief Hash a BSSID into a scan table hash bucket
+ *
+ *  @param bssid      A pointer to the BSSID
+ *
+ *  @return           Bucket index
+ */
+static t_u32
+wlan_scan_bssid_hash(IN t_u8 * bssid)
+{
+	t_u32 hash = 0;
+	t_u32 i;
+
+	for (i = 0; i < MLAN_MAC_ADDR_LENGTH; i++)
+		hash = hash * 31 + bssid[i];
+
+	return hash & (SCAN_TABLE_HASH_SIZE - 1);
+}
+
+/**
+ *  @brief Hash an SSID into a scan table hash bucket
+ *
+ *  @param pssid      A pointer to the SSID
+ *
+ *  @return           Bucket index
+ */
+static t_u32
+wlan_scan_ssid_hash(IN mlan_802_11_ssid * pssid)
+{
+	t_u32 hash = pssid->ssid_len;
+	t_u32 i;
+
+	for (i = 0; i < pssid->ssid_len && i < MLAN_MAX_SSID_LENGTH; i++)
+		hash = hash * 31 + pssid->ssid[i];
+
+	return hash & (SCAN_TABLE_HASH_SIZE - 1);
+}
+
+/**
+ *  @brief Link a scan table index into a hash chain
+ *
+ *  Chains are kept in ascending table order so that lookups visit entries
+ *    in the same order as a linear walk of the table.
+ *
+ *  @param phead      A pointer to the chain head
+ *  @param pnext      The next-index array of the chain
+ *  @param idx        Scan table index to link
+ *
+ *  @return           N/A
+ */
+static t_void
+wlan_scan_chain_insert(IN t_s16 * phead, IN t_s16 * pnext, IN t_s16 idx)
+{
+	while (*phead != SCAN_TABLE_IDX_NONE && *phead < idx)
+		phead = &pnext[*phead];
+	pnext[idx] = *phead;
+	*phead = idx;
+}
+
+/**
+ *  @brief Unlink a scan table index from a hash chain
+ *
+ *  @param phead      A pointer to the chain head
+ *  @param pnext      The next-index array of the chain
+ *  @param idx        Scan table index to unlink; nothing is done if the
+ *                    index is not in the chain
+ *
+ *  @return           N/A
+ */
+static t_void
+wlan_scan_chain_remove(IN t_s16 * phead, IN t_s16 * pnext, IN t_s16 idx)
+{
+	while (*phead != SCAN_TABLE_IDX_NONE) {
+		if (*phead == idx) {
+			*phead = pnext[idx];
+			break;
+		}
+		phead = &pnext[*phead];
+	}
+}
+
+/**
+ *  @brief Add a scan table entry to the BSSID and SSID indexes
+ *
+ *  @param pmadapter  A pointer to mlan_adapter structure
+ *  @param idx        Scan table index of the entry
+ *
+ *  @return           N/A
+ */
+static t_void
+wlan_scan_index_entry(IN mlan_adapter * pmadapter, IN t_u32 idx)
+{
+	BSSDescriptor_t *pbss = &pmadapter->pscan_table[idx];
+
+	wlan_scan_chain_insert(&pmadapter->
+			       scan_bssid_hash[wlan_scan_bssid_hash
+					       (pbss->mac_address)],
+			       pmadapter->scan_bssid_next, (t_s16) idx);
+	wlan_scan_chain_insert(&pmadapter->
+			       scan_ssid_hash[wlan_scan_ssid_hash(&pbss->ssid)],
+			       pmadapter->scan_ssid_next, (t_s16) idx);
+}
+
+/**
+ *  @brief Remove a scan table entry from the BSSID and SSID indexes
+ *
+ *  Must be called before the entry's BSSID or SSID is overwritten.
+ *
+ *  @param pmadapter  A pointer to mlan_adapter structure
+ *  @param idx        Scan table index of the entry
+ *
+ *  @return           N/A
+ */
+static t_void
+wlan_scan_unindex_entry(IN mlan_adapter * pmadapter, IN t_u32 idx)
+{
+	BSSDescriptor_t *pbss = &pmadapter->pscan_table[idx];
+
+	wlan_scan_chain_remove(&pmadapter->
+			       scan_bssid_hash[wlan_scan_bssid_hash
+					       (pbss->mac_address)],
+			       pmadapter->scan_bssid_next, (t_s16) idx);
+	wlan_scan_chain_remove(&pmadapter->
+			       scan_ssid_hash[wlan_scan_ssid_hash(&pbss->ssid)],
+			       pmadapter->scan_ssid_next, (t_s16) idx);
+}
+
+/**
+ *  @brief Rebuild the BSSID and SSID indexes from the scan table
+ *
+ *  @param pmadapter  A pointer to mlan_adapter structure
+ *
+ *  @return           N/A
+ */
+static t_void
+wlan_scan_rebuild_index(IN mlan_adapter * pmadapter)
+{
+	t_u32 i;
+
+	for (i = 0; i < SCAN_TABLE_HASH_SIZE; i++) {
+		pmadapter->scan_bssid_hash[i] = SCAN_TABLE_IDX_NONE;
+		pmadapter->scan_ssid_hash[i] = SCAN_TABLE_IDX_NONE;
+	}
+	/* Walk backwards so every insert lands at the chain head */
+	for (i = pmadapter->num_in_scan_table; i > 0; i--)
+		wlan_scan_index_entry(pmadapter, i - 1);
+}
+
+/**
+ *  @brief Find the scan table entry a new scan result replaces
+ *
+ *  An entry is a duplicate of the new result if it has the same BSSID and
+ *    either the same SSID or a NULL (hidden) SSID.
+ *
+ *  @param pmadapter    A pointer to mlan_adapter structure
+ *  @param pbss_entry   A pointer to the new scan result
+ *  @param num_of_ent   Number of entries currently in the table
+ *
+ *  @return             Index of the duplicate, or num_of_ent if none
+ */
+static t_u32
+wlan_scan_find_dup_entry(IN mlan_adapter * pmadapter,
+			 IN BSSDescriptor_t * pbss_entry, IN t_u32 num_of_ent)
+{
+	t_u8 null_ssid[MLAN_MAX_SSID_LENGTH] = { 0 };
+	BSSDescriptor_t *pbss;
+	t_s16 idx;
+
+	for (idx = pmadapter->
+	     scan_bssid_hash[wlan_scan_bssid_hash(pbss_entry->mac_address)];
+	     idx != SCAN_TABLE_IDX_NONE; idx = pmadapter->scan_bssid_next[idx]) {
+		pbss = &pmadapter->pscan_table[idx];
+		if (memcmp(pmadapter, pbss_entry->mac_address,
+			   pbss->mac_address, sizeof(pbss->mac_address)))
+			continue;
+		/*
+		 * If the SSID matches as well, or the stored SSID is NULL,
+		 *   replace the old contents of this entry
+		 */
+		if (!wlan_ssid_cmp(pmadapter, &pbss_entry->ssid, &pbss->ssid) ||
+		    !memcmp(pmadapter, pbss->ssid.ssid, null_ssid,
+			    pbss->ssid.ssid_len)) {
+			PRINTM(MINFO, "Scan: Duplicate of index: %d\n", idx);
+			return (t_u32) idx;
+		}
+	}
+
+	return num_of_ent;
+}
+
+/**
+ *  @brief Check if a scan table entry ranks ahead of another by RSSI
+ *
+ *  Ties go to the lower table index, matching a linear walk of the table.
+ *
+ *  @param pmadapter  A pointer to mlan_adapter structure
+ *  @param a          Scan table index
+ *  @param b          Scan table index
+ *
+ *  @return           MTRUE if a ranks ahead of b, otherwise MFALSE
+ */
+static t_u8
+wlan_scan_rssi_before(IN mlan_adapter * pmadapter, IN t_u16 a, IN t_u16 b)
+{
+	t_s32 rssi_a = SCAN_RSSI(pmadapter->pscan_table[a].rssi);
+	t_s32 rssi_b = SCAN_RSSI(pmadapter->pscan_table[b].rssi);
+
+	return (rssi_a > rssi_b || (rssi_a == rssi_b && a < b)) ? MTRUE : MFALSE;
+}
+
+/**
+ *  @brief Restore the RSSI max-heap property below a heap position
+ *
+ *  @param pmadapter  A pointer to mlan_adapter structure
+ *  @param pheap      Heap of scan table indexes
+ *  @param count      Number of indexes in the heap
+ *  @param pos        Heap position to sift down from
+ *
+ *  @return           N/A
+ */
+static t_void
+wlan_scan_heap_sift_down(IN mlan_adapter * pmadapter,
+			 IN t_u16 * pheap, IN t_u32 count, IN t_u32 pos)
+{
+	t_u32 child;
+	t_u16 tmp;
+
+	while ((child = 2 * pos + 1) < count) {
+		if (child + 1 < count &&
+		    wlan_scan_rssi_before(pmadapter, pheap[child + 1],
+					  pheap[child]))
+			child++;
+		if (!wlan_scan_rssi_before(pmadapter, pheap[child], pheap[pos]))
+			break;
+		tmp = pheap[pos];
+		pheap[pos] = pheap[child];
+		pheap[child] = tmp;
+		pos = child;
+	}
+}
+
 /**
  *  @brief This function finds the best SSID in the Scan List
  *
  *  Search the scan table for the best SSID that also matches the current
  *   adapter network preference (infrastructure or adhoc)
  *
+ *  Entries are taken from an RSSI max-heap so the (comparatively costly)
+ *   compatibility check only runs on the strongest networks until one
+ *   passes, instead of on every entry in the table.
+ *
  *  @param pmpriv       A pointer to mlan_private structure
  *  @return             index in BSSID list
  */
@@ -291,37 +536,35 @@ wlan_find_best_network_in_list(IN mlan_private * pmpriv)
 {
 	mlan_adapter *pmadapter = pmpriv->adapter;
 	t_u32 mode = pmpriv->bss_mode;
+	t_u16 heap[MRVDRV_MAX_BSSID_LIST];
+	t_u32 count;
 	t_s32 best_net = -1;
-	t_s32 best_rssi = 0;
 	t_u32 i;
 
 	ENTER();
 
 	PRINTM(MINFO, "Num of BSSIDs = %d\n", pmadapter->num_in_scan_table);
 
-	for (i = 0; i < pmadapter->num_in_scan_table; i++) {
+	count = pmadapter->num_in_scan_table;
+	for (i = 0; i < count; i++)
+		heap[i] = (t_u16) i;
+	for (i = count / 2; i > 0; i--)
+		wlan_scan_heap_sift_down(pmadapter, heap, count, i - 1);
+
+	while (count && best_net < 0) {
+		i = heap[0];
+		heap[0] = heap[--count];
+		wlan_scan_heap_sift_down(pmadapter, heap, count, 0);
+
 		switch (mode) {
 		case MLAN_BSS_MODE_INFRA:
 		case MLAN_BSS_MODE_IBSS:
-			if (wlan_is_network_compatible(pmpriv, i, mode) >= 0) {
-				if (SCAN_RSSI(pmadapter->pscan_table[i].rssi) >
-				    best_rssi) {
-					best_rssi =
-						SCAN_RSSI(pmadapter->
-							  pscan_table[i].rssi);
-					best_net = i;
-				}
-			}
+			if (wlan_is_network_compatible(pmpriv, i, mode) >= 0)
+				best_net = i;
 			break;
 		case MLAN_BSS_MODE_AUTO:
 		default:
-			if (SCAN_RSSI(pmadapter->pscan_table[i].rssi) >
-			    best_rssi) {
-				best_rssi =
-					SCAN_RSSI(pmadapter->pscan_table[i].
-						  rssi);
-				best_net = i;
-			}
+			best_net = i;
 			break;
 		}
 	}
@@ -1883,6 +2126,189 @@ wlan_adjust_ie_in_bss_entry(IN mlan_private * pmpriv,
 	return;
 }
 
+/**
+ *  @brief Get the beacon buffer space a repack would leave in use
+ *
+ *  @param pmpriv       A pointer to mlan_private structure
+ *  @param num_of_ent   Number of entries currently in the table
+ *
+ *  @return             Number of bytes
+ */
+static t_u32
+wlan_scan_packed_bcn_size(IN mlan_private * pmpriv, IN t_u32 num_of_ent)
+{
+	mlan_adapter *pmadapter = pmpriv->adapter;
+	BSSDescriptor_t *pbss;
+	t_u32 packed = 0;
+	t_u32 i;
+
+	for (i = 0; i < num_of_ent; i++) {
+		pbss = &pmadapter->pscan_table[i];
+		if (pbss->pbeacon_buf)
+			packed += pbss->beacon_buf_size + SCAN_BEACON_ENTRY_PAD;
+	}
+	for (i = 0; i < pmadapter->priv_num; i++) {
+		if (!pmadapter->priv[i])
+			continue;
+		pbss = &pmadapter->priv[i]->curr_bss_params.bss_descriptor;
+		if (pbss->pbeacon_buf >= pmadapter->bcn_buf &&
+		    pbss->pbeacon_buf < pmadapter->pbcn_buf_end)
+			packed += pbss->beacon_buf_size;
+	}
+
+	return packed;
+}
+
+/**
+ *  @brief Repack the beacon buffer into a new allocation
+ *
+ *  Copy the beacon storage of every scan table entry, and of any current
+ *    BSS beacon restored into the buffer, back to back into a new buffer of
+ *    new_size bytes, trimming each entry back to SCAN_BEACON_ENTRY_PAD bytes
+ *    of pad.  Space left behind by deleted, relocated and shrunk entries is
+ *    reclaimed here in one pass rather than by shifting the buffer each time
+ *    an entry is removed or changes size.
+ *
+ *  @param pmpriv       A pointer to mlan_private structure
+ *  @param num_of_ent   Number of entries currently in the table
+ *  @param new_size     Size of the new beacon buffer
+ *
+ *  @return             MLAN_STATUS_SUCCESS or MLAN_STATUS_FAILURE
+ */
+static mlan_status
+wlan_scan_repack_bcn_buf(IN mlan_private * pmpriv,
+			 IN t_u32 num_of_ent, IN t_u32 new_size)
+{
+	mlan_adapter *pmadapter = pmpriv->adapter;
+	mlan_callbacks *pcb = (pmlan_callbacks) & pmadapter->callbacks;
+	mlan_status ret = MLAN_STATUS_SUCCESS;
+	BSSDescriptor_t *pbss;
+	mlan_private *priv;
+	t_u8 *tmp_buf = MNULL;
+	t_u8 *pend;
+	t_u32 i;
+
+	ENTER();
+
+	if (pcb->moal_vmalloc && pcb->moal_vfree)
+		ret = pcb->moal_vmalloc(pmadapter->pmoal_handle, new_size,
+					(t_u8 **) & tmp_buf);
+	else
+		ret = pcb->moal_malloc(pmadapter->pmoal_handle, new_size,
+				       MLAN_MEM_DEF, (t_u8 **) & tmp_buf);
+	if (ret != MLAN_STATUS_SUCCESS || !tmp_buf) {
+		PRINTM(MERROR, "Repack Beacon buffer: alloc %d failed\n",
+		       new_size);
+		LEAVE();
+		return MLAN_STATUS_FAILURE;
+	}
+
+	PRINTM(MCMND, "Repack Beacon buffer, old size=%d, new_size=%d, "
+	       "used=%d\n", pmadapter->bcn_buf_size, new_size,
+	       (pmadapter->pbcn_buf_end - pmadapter->bcn_buf));
+
+	pend = tmp_buf;
+	for (i = 0; i < num_of_ent; i++) {
+		pbss = &pmadapter->pscan_table[i];
+		if (!pbss->pbeacon_buf)
+			continue;
+		memcpy(pmadapter, pend, pbss->pbeacon_buf,
+		       pbss->beacon_buf_size);
+		pbss->pbeacon_buf = pend;
+		pbss->beacon_buf_size_max =
+			pbss->beacon_buf_size + SCAN_BEACON_ENTRY_PAD;
+		wlan_adjust_ie_in_bss_entry(pmpriv, pbss);
+		pend += pbss->beacon_buf_size_max;
+	}
+
+	/* A restored current BSS beacon is not owned by a table entry */
+	for (i = 0; i < pmadapter->priv_num; i++) {
+		priv = pmadapter->priv[i];
+		if (!priv)
+			continue;
+		pbss = &priv->curr_bss_params.bss_descriptor;
+		if (pbss->pbeacon_buf < pmadapter->bcn_buf ||
+		    pbss->pbeacon_buf >= pmadapter->pbcn_buf_end)
+			continue;
+		pcb->moal_spin_lock(pmadapter->pmoal_handle,
+				    priv->curr_bcn_buf_lock);
+		memcpy(pmadapter, pend, pbss->pbeacon_buf,
+		       pbss->beacon_buf_size);
+		pbss->pbeacon_buf = pend;
+		wlan_adjust_ie_in_bss_entry(pmpriv, pbss);
+		pend += pbss->beacon_buf_size;
+		pcb->moal_spin_unlock(pmadapter->pmoal_handle,
+				      priv->curr_bcn_buf_lock);
+	}
+
+	if (pcb->moal_vmalloc && pcb->moal_vfree)
+		pcb->moal_vfree(pmadapter->pmoal_handle,
+				(t_u8 *) pmadapter->bcn_buf);
+	else
+		pcb->moal_mfree(pmadapter->pmoal_handle,
+				(t_u8 *) pmadapter->bcn_buf);
+	pmadapter->bcn_buf = tmp_buf;
+	pmadapter->bcn_buf_size = (t_u16) new_size;
+	pmadapter->pbcn_buf_end = pend;
+
+	LEAVE();
+	return MLAN_STATUS_SUCCESS;
+}
+
+/**
+ *  @brief Make room at the end of the beacon buffer
+ *
+ *  If size bytes do not fit after the current end of the buffer, repack
+ *    it.  The buffer is also grown by DEFAULT_SCAN_BEACON_BUFFER, while it is
+ *    below MAX_SCAN_BEACON_BUFFER, when repacking alone would leave less than
+ *    half of that free, so a nearly full buffer is not repacked for every
+ *    new entry.
+ *
+ *  The beacon of the entry at beacon_idx is about to be replaced, so a
+ *    repack drops it rather than keeping space for both the old and the new
+ *    beacon.  If size bytes cannot be made to fit, nothing is changed.
+ *
+ *  @param pmpriv       A pointer to mlan_private structure
+ *  @param num_of_ent   Number of entries currently in the table
+ *  @param beacon_idx   Index of the entry the space is for
+ *  @param size         Number of bytes needed
+ *
+ *  @return             MTRUE if size bytes fit after pbcn_buf_end,
+ *                      otherwise MFALSE
+ */
+static t_u8
+wlan_scan_reserve_bcn_buf(IN mlan_private * pmpriv,
+			  IN t_u32 num_of_ent, IN t_u32 beacon_idx,
+			  IN t_u32 size)
+{
+	mlan_adapter *pmadapter = pmpriv->adapter;
+	BSSDescriptor_t *pbss = &pmadapter->pscan_table[beacon_idx];
+	t_u32 new_size = pmadapter->bcn_buf_size;
+	t_u8 *pold_bcn;
+	t_u32 packed;
+
+	if (pmadapter->pbcn_buf_end + size <
+	    pmadapter->bcn_buf + pmadapter->bcn_buf_size)
+		return MTRUE;
+
+	/* Hide the old beacon from the repack */
+	pold_bcn = pbss->pbeacon_buf;
+	pbss->pbeacon_buf = MNULL;
+
+	packed = wlan_scan_packed_bcn_size(pmpriv, num_of_ent);
+	if ((packed + size + DEFAULT_SCAN_BEACON_BUFFER / 2 >= new_size) &&
+	    (pmadapter->bcn_buf_size < MAX_SCAN_BEACON_BUFFER))
+		new_size += DEFAULT_SCAN_BEACON_BUFFER;
+	if ((packed + size >= new_size) ||
+	    (wlan_scan_repack_bcn_buf(pmpriv, num_of_ent, new_size) !=
+	     MLAN_STATUS_SUCCESS)) {
+		pbss->pbeacon_buf = pold_bcn;
+		return MFALSE;
+	}
+
+	return MTRUE;
+}
+
 /**
  *  @brief Store a beacon or probe response for a BSS returned in the scan
  *
@@ -1890,9 +2316,11 @@ wlan_adjust_ie_in_bss_entry(IN mlan_private * pmpriv,
  *    entries need to verify that they do not exceed the total amount of
  *    memory allocated for the table.
 
- *  Replacement entries need to take into consideration the amount of space
- *    currently allocated for the beacon/probe response and adjust the entry
- *    as needed.
+ *  Replacement entries reuse the space currently allocated for the
+ *    beacon/probe response when the new one fits.  A larger replacement is
+ *    grown in place if it is the last entry in the buffer, otherwise it is
+ *    moved to the end of the buffer and its old space is reclaimed by the
+ *    next repack.  No other entry is moved.
  *
  *  A small amount of extra pad (SCAN_BEACON_ENTRY_PAD) is generally reserved
  *    for an entry in case it is a beacon since a probe response for the
@@ -1919,11 +2347,6 @@ wlan_ret_802_11_scan_store_beacon(IN mlan_private * pmpriv,
 	t_u32 new_bcn_size;
 	t_u32 old_bcn_size;
 	t_u32 bcn_space;
-	t_u32 adj_idx;
-	mlan_status ret = MLAN_STATUS_SUCCESS;
-	t_u8 *tmp_buf;
-	t_u16 bcn_size = 0;
-	t_u32 bcn_offset = 0;
 
 	ENTER();
 
@@ -1940,99 +2363,24 @@ wlan_ret_802_11_scan_store_beacon(IN mlan_private * pmpriv,
 		   below */
 		pnew_beacon->beacon_buf_size_max = bcn_space;
 
-		if (new_bcn_size == old_bcn_size) {
-			/*
-			 * Beacon is the same size as the previous entry.
-			 *   Replace the previous contents with the scan result
-			 */
-			memcpy(pmadapter, pbcn_store,
-			       pnew_beacon->pbeacon_buf,
-			       pnew_beacon->beacon_buf_size);
-
-		} else if (new_bcn_size <= bcn_space) {
+		if (new_bcn_size <= bcn_space) {
 			/*
 			 * New beacon size will fit in the amount of space
-			 *   we have previously allocated for it
+			 *   we have previously allocated for it.  Any space
+			 *   it does not use stays with the entry as pad.
 			 */
-
-			/* Copy the new beacon buffer entry over the old one */
 			memcpy(pmadapter, pbcn_store, pnew_beacon->pbeacon_buf,
 			       new_bcn_size);
 
+		} else if ((pbcn_store + bcn_space == pmadapter->pbcn_buf_end)
+			   && (pmadapter->pbcn_buf_end +
+			       (new_bcn_size - bcn_space)
+			       < (pmadapter->bcn_buf +
+				  pmadapter->bcn_buf_size))) {
 			/*
-			 *  If the old beacon size was less than the maximum
-			 *  we had allotted for the entry, and the new entry
-			 *  is even smaller, reset the max size to the old beacon
-			 *  entry and compress the storage space (leaving a new
-			 *  pad space of (old_bcn_size - new_bcn_size).
-			 */
-			if (old_bcn_size < bcn_space &&
-			    new_bcn_size <= old_bcn_size) {
-				/*
-				 * Old Beacon size is smaller than the allotted storage size.
-				 *   Shrink the allotted storage space.
-				 */
-				PRINTM(MINFO,
-				       "AppControl: Smaller Duplicate Beacon (%d), "
-				       "old = %d, new = %d, space = %d, left = %d\n",
-				       beacon_idx, old_bcn_size, new_bcn_size,
-				       bcn_space,
-				       (pmadapter->bcn_buf_size -
-					(pmadapter->pbcn_buf_end -
-					 pmadapter->bcn_buf)));
-
-				/*
-				 *  memmove (since the memory overlaps) the data
-				 *  after the beacon we just stored to the end of
-				 *  the current beacon.  This cleans up any unused
-				 *  space the old larger beacon was using in the buffer
-				 */
-				memmove(pmadapter,
-					(void *)((t_ptr) pbcn_store +
-						 (t_ptr) old_bcn_size),
-					(void *)((t_ptr) pbcn_store +
-						 (t_ptr) bcn_space),
-					(t_u32) ((t_ptr) pmadapter->
-						 pbcn_buf_end -
-						 ((t_ptr) pbcn_store +
-						  (t_ptr) bcn_space)));
-
-				/*
-				 * Decrement the end pointer by the difference between
-				 *  the old larger size and the new smaller size since
-				 *  we are using less space due to the new beacon being
-				 *  smaller
-				 */
-				pmadapter->pbcn_buf_end -=
-					(bcn_space - old_bcn_size);
-
-				/* Set the maximum storage size to the old
-				   beacon size */
-				pnew_beacon->beacon_buf_size_max = old_bcn_size;
-
-				/* Adjust beacon buffer pointers that are past
-				   the current */
-				for (adj_idx = 0; adj_idx < num_of_ent;
-				     adj_idx++) {
-					if (pmadapter->pscan_table[adj_idx].
-					    pbeacon_buf > pbcn_store) {
-						pmadapter->pscan_table[adj_idx].
-							pbeacon_buf -=
-							(bcn_space -
-							 old_bcn_size);
-						wlan_adjust_ie_in_bss_entry
-							(pmpriv,
-							 &pmadapter->
-							 pscan_table[adj_idx]);
-					}
-				}
-			}
-		} else if (pmadapter->pbcn_buf_end + (new_bcn_size - bcn_space)
-			   < (pmadapter->bcn_buf + pmadapter->bcn_buf_size)) {
-			/*
-			 * Beacon is larger than space previously allocated (bcn_space)
-			 *   and there is enough space left in the beaconBuffer to store
-			 *   the additional data
+			 * Beacon is larger than space previously allocated
+			 *   (bcn_space), but it is the last entry in the buffer
+			 *   and there is room to grow it in place
 			 */
 			PRINTM(MINFO,
 			       "AppControl: Larger Duplicate Beacon (%d), "
@@ -2043,52 +2391,37 @@ wlan_ret_802_11_scan_store_beacon(IN mlan_private * pmpriv,
 				(pmadapter->pbcn_buf_end -
 				 pmadapter->bcn_buf)));
 
-			/*
-			 * memmove (since the memory overlaps) the data
-			 *  after the beacon we just stored to the end of
-			 *  the current beacon.  This moves the data for
-			 *  the beacons after this further in memory to
-			 *  make space for the new larger beacon we are
-			 *  about to copy in.
-			 */
-			memmove(pmadapter,
-				(void *)((t_ptr) pbcn_store +
-					 (t_ptr) new_bcn_size),
-				(void *)((t_ptr) pbcn_store +
-					 (t_ptr) bcn_space),
-				(t_u32) ((t_ptr) pmadapter->pbcn_buf_end -
-					 ((t_ptr) pbcn_store +
-					  (t_ptr) bcn_space)));
-
-			/* Copy the new beacon buffer entry over the old one */
 			memcpy(pmadapter, pbcn_store, pnew_beacon->pbeacon_buf,
 			       new_bcn_size);
-
-			/* Move the beacon end pointer by the amount of new
-			   beacon data we are adding */
 			pmadapter->pbcn_buf_end += (new_bcn_size - bcn_space);
+			pnew_beacon->beacon_buf_size_max = new_bcn_size;
 
+		} else if (wlan_scan_reserve_bcn_buf(pmpriv, num_of_ent,
+						     beacon_idx,
+						     new_bcn_size +
+						     SCAN_BEACON_ENTRY_PAD)) {
 			/*
-			 * This entry is bigger than the allotted max space
-			 *  previously reserved.  Increase the max space to
-			 *  be equal to the new beacon size
+			 * Beacon is larger than space previously allocated;
+			 *   move it to the end of the buffer and leave its old
+			 *   space to be reclaimed by the next repack
 			 */
-			pnew_beacon->beacon_buf_size_max = new_bcn_size;
+			PRINTM(MINFO,
+			       "AppControl: Moved Larger Duplicate Beacon (%d), "
+			       "old = %d, new = %d, space = %d, left = %d\n",
+			       beacon_idx, old_bcn_size, new_bcn_size,
+			       bcn_space,
+			       (pmadapter->bcn_buf_size -
+				(pmadapter->pbcn_buf_end -
+				 pmadapter->bcn_buf)));
+
+			pbcn_store = pmadapter->pbcn_buf_end;
+			memcpy(pmadapter, pbcn_store, pnew_beacon->pbeacon_buf,
+			       new_bcn_size);
+			pnew_beacon->beacon_buf_size_max =
+				new_bcn_size + SCAN_BEACON_ENTRY_PAD;
+			pmadapter->pbcn_buf_end +=
+				pnew_beacon->beacon_buf_size_max;
 
-			/* Adjust beacon buffer pointers that are past the
-			   current */
-			for (adj_idx = 0; adj_idx < num_of_ent; adj_idx++) {
-				if (pmadapter->pscan_table[adj_idx].
-				    pbeacon_buf > pbcn_store) {
-					pmadapter->pscan_table[adj_idx].
-						pbeacon_buf +=
-						(new_bcn_size - bcn_space);
-					wlan_adjust_ie_in_bss_entry(pmpriv,
-								    &pmadapter->
-								    pscan_table
-								    [adj_idx]);
-				}
-			}
 		} else {
 			/*
 			 * Beacon is larger than the previously allocated space, but
@@ -2142,79 +2475,13 @@ wlan_ret_802_11_scan_store_beacon(IN mlan_private * pmpriv,
 		pnew_beacon->pbeacon_buf = pbcn_store;
 		wlan_adjust_ie_in_bss_entry(pmpriv, pnew_beacon);
 	} else {
-		if ((pmadapter->pbcn_buf_end + pnew_beacon->beacon_buf_size +
-		     SCAN_BEACON_ENTRY_PAD > (pmadapter->bcn_buf +
-					      pmadapter->bcn_buf_size)) &&
-		    (pmadapter->bcn_buf_size < MAX_SCAN_BEACON_BUFFER)) {
-			/* no space for this entry, realloc bcn buffer */
-			if (pmadapter->callbacks.moal_vmalloc &&
-			    pmadapter->callbacks.moal_vfree)
-				ret = pmadapter->callbacks.
-					moal_vmalloc(pmadapter->pmoal_handle,
-						     pmadapter->bcn_buf_size +
-						     DEFAULT_SCAN_BEACON_BUFFER,
-						     (t_u8 **) & tmp_buf);
-			else
-				ret = pmadapter->callbacks.
-					moal_malloc(pmadapter->pmoal_handle,
-						    pmadapter->bcn_buf_size +
-						    DEFAULT_SCAN_BEACON_BUFFER,
-						    MLAN_MEM_DEF,
-						    (t_u8 **) & tmp_buf);
-
-			if ((ret == MLAN_STATUS_SUCCESS) && (tmp_buf)) {
-				PRINTM(MCMND,
-				       "Realloc Beacon buffer, old size=%d, new_size=%d\n",
-				       pmadapter->bcn_buf_size,
-				       pmadapter->bcn_buf_size +
-				       DEFAULT_SCAN_BEACON_BUFFER);
-				bcn_size =
-					pmadapter->pbcn_buf_end -
-					pmadapter->bcn_buf;
-				memcpy(pmadapter, tmp_buf, pmadapter->bcn_buf,
-				       bcn_size);
-				/* Adjust beacon buffer pointers that are past
-				   the current */
-				for (adj_idx = 0; adj_idx < num_of_ent;
-				     adj_idx++) {
-					bcn_offset =
-						pmadapter->pscan_table[adj_idx].
-						pbeacon_buf -
-						pmadapter->bcn_buf;
-					pmadapter->pscan_table[adj_idx].
-						pbeacon_buf =
-						tmp_buf + bcn_offset;
-					wlan_adjust_ie_in_bss_entry(pmpriv,
-								    &pmadapter->
-								    pscan_table
-								    [adj_idx]);
-				}
-				pmadapter->pbcn_buf_end = tmp_buf + bcn_size;
-				if (pmadapter->callbacks.moal_vmalloc &&
-				    pmadapter->callbacks.moal_vfree)
-					pmadapter->callbacks.
-						moal_vfree(pmadapter->
-							   pmoal_handle,
-							   (t_u8 *) pmadapter->
-							   bcn_buf);
-				else
-					pmadapter->callbacks.
-						moal_mfree(pmadapter->
-							   pmoal_handle,
-							   (t_u8 *) pmadapter->
-							   bcn_buf);
-				pmadapter->bcn_buf = tmp_buf;
-				pmadapter->bcn_buf_size +=
-					DEFAULT_SCAN_BEACON_BUFFER;
-			}
-		}
 		/*
 		 * No existing beacon data exists for this entry, check to see
 		 *   if we can fit it in the remaining space
 		 */
-		if (pmadapter->pbcn_buf_end + pnew_beacon->beacon_buf_size +
-		    SCAN_BEACON_ENTRY_PAD < (pmadapter->bcn_buf +
-					     pmadapter->bcn_buf_size)) {
+		if (wlan_scan_reserve_bcn_buf(pmpriv, num_of_ent, beacon_idx,
+					      pnew_beacon->beacon_buf_size +
+					      SCAN_BEACON_ENTRY_PAD)) {
 
 			/*
 			 * Copy the beacon buffer data from the local entry to the
@@ -2462,8 +2729,9 @@ wlan_scan_process_results(IN mlan_private * pmpriv)
  *  @brief Delete a specific indexed entry from the scan table.
  *
  *  Delete the scan table entry indexed by table_idx.  Compact the remaining
- *    entries and adjust any buffering of beacon/probe response data
- *    if needed.
+ *    entries.  The entry's beacon/probe response space is released at once
+ *    if it is the last one in the beacon buffer, otherwise it is reclaimed
+ *    by the next repack of the buffer.
  *
  *  @param pmpriv       A pointer to mlan_private structure
  *  @param table_idx    Scan table entry index to delete from the table
@@ -2482,12 +2750,6 @@ wlan_scan_delete_table_entry(IN mlan_private * pmpriv, IN t_s32 table_idx)
 
 	ENTER();
 
-	/*
-	 * Shift the saved beacon buffer data for the scan table back over the
-	 *   entry being removed.  Update the end of buffer pointer.  Save the
-	 *   deleted buffer allocation size for pointer adjustments for entries
-	 *   compacted after the deleted index.
-	 */
 	beacon_buf_adj = pmadapter->pscan_table[table_idx].beacon_buf_size_max;
 
 	PRINTM(MINFO,
@@ -2497,137 +2759,22 @@ wlan_scan_delete_table_entry(IN mlan_private * pmpriv, IN t_s32 table_idx)
 	/* Check if the table entry had storage allocated for its beacon */
 	if (beacon_buf_adj) {
 		pbeacon_buf = pmadapter->pscan_table[table_idx].pbeacon_buf;
-
-		/*
-		 * Remove the entry's buffer space, decrement the table end pointer
-		 *   by the amount we are removing
-		 */
-		pmadapter->pbcn_buf_end -= beacon_buf_adj;
-
-		PRINTM(MINFO,
-		       "Scan: Delete Entry %d, compact data: %p <- %p (sz = %d)\n",
-		       table_idx,
-		       pbeacon_buf,
-		       pbeacon_buf + beacon_buf_adj,
-		       pmadapter->pbcn_buf_end - pbeacon_buf);
-
-		/*
-		 * Compact data storage.  Copy all data after the deleted entry's
-		 *   end address (pbeacon_buf + beacon_buf_adj) back to the original
-		 *   start address (pbeacon_buf).
-		 *
-		 * Scan table entries affected by the move will have their entry
-		 *   pointer adjusted below.
-		 *
-		 * Use memmove since the dest/src memory regions overlap.
-		 */
-		memmove(pmadapter, pbeacon_buf,
-			(void *)((t_ptr) pbeacon_buf + (t_ptr) beacon_buf_adj),
-			(t_u32) ((t_ptr) pmadapter->pbcn_buf_end -
-				 (t_ptr) pbeacon_buf));
+		if (pbeacon_buf + beacon_buf_adj == pmadapter->pbcn_buf_end)
+			pmadapter->pbcn_buf_end -= beacon_buf_adj;
 	}
 
 	PRINTM(MINFO, "Scan: Delete Entry %d, num_in_scan_table = %d\n",
 	       table_idx, pmadapter->num_in_scan_table);
 
 	/* Shift all of the entries after the table_idx back by one, compacting
-	   the table and removing the requested entry */
+	   the table and removing the requested entry.  Beacon storage is not
+	   moved, so the entries' beacon and IE pointers stay valid */
 	for (del_idx = table_idx; (del_idx + 1) < pmadapter->num_in_scan_table;
 	     del_idx++) {
 		/* Copy the next entry over this one */
 		memcpy(pmadapter, pmadapter->pscan_table + del_idx,
 		       pmadapter->pscan_table + del_idx + 1,
 		       sizeof(BSSDescriptor_t));
-
-		/*
-		 * Adjust this entry's pointer to its beacon buffer based on the
-		 *   removed/compacted entry from the deleted index.  Don't decrement
-		 *   if the buffer pointer is MNULL (no data stored for this entry).
-		 */
-		if (pmadapter->pscan_table[del_idx].pbeacon_buf) {
-			pmadapter->pscan_table[del_idx].pbeacon_buf -=
-				beacon_buf_adj;
-			if (pmadapter->pscan_table[del_idx].pwpa_ie) {
-				pmadapter->pscan_table[del_idx].pwpa_ie =
-					(IEEEtypes_VendorSpecific_t *)
-					(pmadapter->pscan_table[del_idx].
-					 pbeacon_buf +
-					 pmadapter->pscan_table[del_idx].
-					 wpa_offset);
-			}
-			if (pmadapter->pscan_table[del_idx].prsn_ie) {
-				pmadapter->pscan_table[del_idx].prsn_ie =
-					(IEEEtypes_Generic_t *)
-					(pmadapter->pscan_table[del_idx].
-					 pbeacon_buf +
-					 pmadapter->pscan_table[del_idx].
-					 rsn_offset);
-			}
-			if (pmadapter->pscan_table[del_idx].pwapi_ie) {
-				pmadapter->pscan_table[del_idx].pwapi_ie =
-					(IEEEtypes_Generic_t *)
-					(pmadapter->pscan_table[del_idx].
-					 pbeacon_buf +
-					 pmadapter->pscan_table[del_idx].
-					 wapi_offset);
-			}
-			if (pmadapter->pscan_table[del_idx].pht_cap) {
-				pmadapter->pscan_table[del_idx].pht_cap =
-					(IEEEtypes_HTCap_t *) (pmadapter->
-							       pscan_table
-							       [del_idx].
-							       pbeacon_buf +
-							       pmadapter->
-							       pscan_table
-							       [del_idx].
-							       ht_cap_offset);
-			}
-
-			if (pmadapter->pscan_table[del_idx].pht_info) {
-				pmadapter->pscan_table[del_idx].pht_info =
-					(IEEEtypes_HTInfo_t *) (pmadapter->
-								pscan_table
-								[del_idx].
-								pbeacon_buf +
-								pmadapter->
-								pscan_table
-								[del_idx].
-								ht_info_offset);
-			}
-			if (pmadapter->pscan_table[del_idx].pbss_co_2040) {
-				pmadapter->pscan_table[del_idx].pbss_co_2040 =
-					(IEEEtypes_2040BSSCo_t *) (pmadapter->
-								   pscan_table
-								   [del_idx].
-								   pbeacon_buf +
-								   pmadapter->
-								   pscan_table
-								   [del_idx].
-								   bss_co_2040_offset);
-			}
-			if (pmadapter->pscan_table[del_idx].pext_cap) {
-				pmadapter->pscan_table[del_idx].pext_cap =
-					(IEEEtypes_ExtCap_t *) (pmadapter->
-								pscan_table
-								[del_idx].
-								pbeacon_buf +
-								pmadapter->
-								pscan_table
-								[del_idx].
-								ext_cap_offset);
-			}
-			if (pmadapter->pscan_table[del_idx].
-			    poverlap_bss_scan_param) {
-				pmadapter->pscan_table[del_idx].
-					poverlap_bss_scan_param =
-					(IEEEtypes_OverlapBSSScanParam_t
-					 *) (pmadapter->pscan_table[del_idx].
-					     pbeacon_buf +
-					     pmadapter->pscan_table[del_idx].
-					     overlap_bss_offset);
-			}
-
-		}
 	}
 
 	/* The last entry is invalid now that it has been deleted or moved back
@@ -2638,6 +2785,9 @@ wlan_scan_delete_table_entry(IN mlan_private * pmpriv, IN t_s32 table_idx)
 
 	pmadapter->num_in_scan_table--;
 
+	/* Table indexes after table_idx have changed */
+	wlan_scan_rebuild_index(pmadapter);
+
 	LEAVE();
 }
 
@@ -3010,6 +3160,8 @@ wlan_flush_scan_table(IN pmlan_adapter pmadapter)
 	memset(pmadapter, pmadapter->bcn_buf, 0, pmadapter->bcn_buf_size);
 	pmadapter->pbcn_buf_end = pmadapter->bcn_buf;
 
+	wlan_scan_rebuild_index(pmadapter);
+
 	LEAVE();
 	return MLAN_STATUS_SUCCESS;
 }
@@ -3109,12 +3261,8 @@ wlan_scan_networks(IN mlan_private * pmpriv,
 		keep_previous_scan = puser_scan_in->keep_previous_scan;
 	}
 
-	if (keep_previous_scan == MFALSE) {
-		memset(pmadapter, pmadapter->pscan_table, 0x00,
-		       sizeof(BSSDescriptor_t) * MRVDRV_MAX_BSSID_LIST);
-		pmadapter->num_in_scan_table = 0;
-		pmadapter->pbcn_buf_end = pmadapter->bcn_buf;
-	}
+	if (keep_previous_scan == MFALSE)
+		wlan_flush_scan_table(pmadapter);
 
 	ret = wlan_scan_channel_list(pmpriv,
 				     pioctl_buf,
@@ -3257,7 +3405,6 @@ wlan_ret_802_11_scan(IN mlan_private * pmpriv,
 	t_u8 band;
 	t_u8 is_bgscan_resp;
 	t_u32 age_ts_usec;
-	t_u8 null_ssid[MLAN_MAX_SSID_LENGTH] = { 0 };
 	t_u32 status_code = 0;
 	pmlan_ioctl_req pscan_ioctl_req = MNULL;
 
@@ -3340,6 +3487,11 @@ wlan_ret_802_11_scan(IN mlan_private * pmpriv,
 		goto done;
 	}
 
+	/* Update the age_in_second; entries stored below are stamped with it */
+	pmadapter->callbacks.moal_get_system_time(pmadapter->pmoal_handle,
+						  &pmadapter->age_in_secs,
+						  &age_ts_usec);
+
 	for (idx = 0; idx < pscan_rsp->number_of_sets && bytes_left; idx++) {
 		/* Zero out the bss_new_entry we are about to store info in */
 		memset(pmadapter, bss_new_entry, 0x00, sizeof(BSSDescriptor_t));
@@ -3393,50 +3545,9 @@ wlan_ret_802_11_scan(IN mlan_private * pmpriv,
 			/*
 			 * Search the scan table for the same bssid
 			 */
-			for (bss_idx = 0; bss_idx < num_in_table; bss_idx++) {
-				if (!memcmp
-				    (pmadapter, bss_new_entry->mac_address,
-				     pmadapter->pscan_table[bss_idx].
-				     mac_address,
-				     sizeof(bss_new_entry->mac_address))) {
-					/*
-					 * If the SSID matches as well, it is a duplicate of
-					 *   this entry.  Keep the bss_idx set to this
-					 *   entry so we replace the old contents in the table
-					 */
-					if ((bss_new_entry->ssid.ssid_len ==
-					     pmadapter->pscan_table[bss_idx].
-					     ssid.ssid_len)
-					    &&
-					    (!memcmp
-					     (pmadapter,
-					      bss_new_entry->ssid.ssid,
-					      pmadapter->pscan_table[bss_idx].
-					      ssid.ssid,
-					      bss_new_entry->ssid.ssid_len))) {
-						PRINTM(MINFO,
-						       "SCAN_RESP: Duplicate of index: %d\n",
-						       bss_idx);
-
-						break;
-					}
-					/*
-					 * If the SSID is NULL for same BSSID keep the bss_idx set
-					 * to this entry so we replace the old contents in the table
-					 */
-					if (!memcmp
-					    (pmadapter,
-					     pmadapter->pscan_table[bss_idx].
-					     ssid.ssid, null_ssid,
-					     pmadapter->pscan_table[bss_idx].
-					     ssid.ssid_len)) {
-						PRINTM(MINFO,
-						       "SCAN_RESP: Duplicate of index: %d\n",
-						       bss_idx);
-						break;
-					}
-				}
-			}
+			bss_idx = wlan_scan_find_dup_entry(pmadapter,
+							   bss_new_entry,
+							   num_in_table);
 			/*
 			 * If the bss_idx is equal to the number of entries in the table,
 			 *   the new entry was not a duplicate; append it to the scan
@@ -3464,6 +3575,7 @@ wlan_ret_802_11_scan(IN mlan_private * pmpriv,
 			if (bss_new_entry->pbeacon_buf == MNULL) {
 				PRINTM(MCMND,
 				       "No space for beacon, drop this entry\n");
+				wlan_scan_unindex_entry(pmadapter, bss_idx);
 				num_in_table--;
 				continue;
 			}
@@ -3483,11 +3595,15 @@ wlan_ret_802_11_scan(IN mlan_private * pmpriv,
 				       sizeof(bss_new_entry->network_tsf));
 			}
 
+			bss_new_entry->age_in_secs = pmadapter->age_in_secs;
+
 			/* Copy the locally created bss_new_entry to the scan
-			   table */
+			   table, re-indexing it under its new BSSID and SSID */
+			wlan_scan_unindex_entry(pmadapter, bss_idx);
 			memcpy(pmadapter, &pmadapter->pscan_table[bss_idx],
 			       bss_new_entry,
 			       sizeof(pmadapter->pscan_table[bss_idx]));
+			wlan_scan_index_entry(pmadapter, bss_idx);
 
 		} else {
 			/* Error parsing/interpreting the scan response,
@@ -3503,10 +3619,6 @@ wlan_ret_802_11_scan(IN mlan_private * pmpriv,
 
 	/* Update the total number of BSSIDs in the scan table */
 	pmadapter->num_in_scan_table = num_in_table;
-	/* Update the age_in_second */
-	pmadapter->callbacks.moal_get_system_time(pmadapter->pmoal_handle,
-						  &pmadapter->age_in_secs,
-						  &age_ts_usec);
 	if (is_bgscan_resp)
 		goto done;
 	if (!util_peek_list
@@ -3677,7 +3789,6 @@ wlan_parse_ext_scan_result(IN mlan_private * pmpriv,
 	MrvlIEtypes_Bss_Scan_Info_t *pscan_info_tlv = MNULL;
 	t_u8 band;
 	t_u32 age_ts_usec;
-	t_u8 null_ssid[MLAN_MAX_SSID_LENGTH] = { 0 };
 
 	ENTER();
 	pcb = (pmlan_callbacks) & pmadapter->callbacks;
@@ -3713,6 +3824,11 @@ wlan_parse_ext_scan_result(IN mlan_private * pmpriv,
 		goto done;
 	}
 
+	/* Update the age_in_second; entries stored below are stamped with it */
+	pmadapter->callbacks.moal_get_system_time(pmadapter->pmoal_handle,
+						  &pmadapter->age_in_secs,
+						  &age_ts_usec);
+
 	for (idx = 0; idx < number_of_sets && bytes_left >
 	     sizeof(MrvlIEtypesHeader_t); idx++) {
 		tlv_type = wlan_le16_to_cpu(ptlv->header.type);
@@ -3842,49 +3958,9 @@ wlan_parse_ext_scan_result(IN mlan_private * pmpriv,
 			/*
 			 * Search the scan table for the same bssid
 			 */
-			for (bss_idx = 0; bss_idx < num_in_table; bss_idx++) {
-				if (!memcmp
-				    (pmadapter, bss_new_entry->mac_address,
-				     pmadapter->pscan_table[bss_idx].
-				     mac_address,
-				     sizeof(bss_new_entry->mac_address))) {
-					/*
-					 * If the SSID matches as well, it is a duplicate of
-					 *   this entry.  Keep the bss_idx set to this
-					 *   entry so we replace the old contents in the table
-					 */
-					if ((bss_new_entry->ssid.ssid_len ==
-					     pmadapter->pscan_table[bss_idx].
-					     ssid.ssid_len)
-					    &&
-					    (!memcmp
-					     (pmadapter,
-					      bss_new_entry->ssid.ssid,
-					      pmadapter->pscan_table[bss_idx].
-					      ssid.ssid,
-					      bss_new_entry->ssid.ssid_len))) {
-						PRINTM(MINFO,
-						       "EXT_SCAN: Duplicate of index: %d\n",
-						       bss_idx);
-						break;
-					}
-					/*
-					 * If the SSID is NULL for same BSSID keep the bss_idx set
-					 * to this entry so we replace the old contents in the table
-					 */
-					if (!memcmp
-					    (pmadapter,
-					     pmadapter->pscan_table[bss_idx].
-					     ssid.ssid, null_ssid,
-					     pmadapter->pscan_table[bss_idx].
-					     ssid.ssid_len)) {
-						PRINTM(MINFO,
-						       "EXT_SCAN: Duplicate of index: %d\n",
-						       bss_idx);
-						break;
-					}
-				}
-			}
+			bss_idx = wlan_scan_find_dup_entry(pmadapter,
+							   bss_new_entry,
+							   num_in_table);
 			/*
 			 * If the bss_idx is equal to the number of entries in the table,
 			 *   the new entry was not a duplicate; append it to the scan
@@ -3912,15 +3988,20 @@ wlan_parse_ext_scan_result(IN mlan_private * pmpriv,
 			if (bss_new_entry->pbeacon_buf == MNULL) {
 				PRINTM(MCMND,
 				       "No space for beacon, drop this entry\n");
+				wlan_scan_unindex_entry(pmadapter, bss_idx);
 				num_in_table--;
 				continue;
 			}
 
+			bss_new_entry->age_in_secs = pmadapter->age_in_secs;
+
 			/* Copy the locally created bss_new_entry to the scan
-			   table */
+			   table, re-indexing it under its new BSSID and SSID */
+			wlan_scan_unindex_entry(pmadapter, bss_idx);
 			memcpy(pmadapter, &pmadapter->pscan_table[bss_idx],
 			       bss_new_entry,
 			       sizeof(pmadapter->pscan_table[bss_idx]));
+			wlan_scan_index_entry(pmadapter, bss_idx);
 		} else {
 			/* Error parsing/interpreting the scan response,
 			   skipped */
@@ -3935,10 +4016,6 @@ wlan_parse_ext_scan_result(IN mlan_private * pmpriv,
 
 	/* Update the total number of BSSIDs in the scan table */
 	pmadapter->num_in_scan_table = num_in_table;
-	/* Update the age_in_second */
-	pmadapter->callbacks.moal_get_system_time(pmadapter->pmoal_handle,
-						  &pmadapter->age_in_secs,
-						  &age_ts_usec);
 
 done:
 	if (bss_new_entry)
@@ -4576,6 +4653,7 @@ wlan_find_ssid_in_list(IN mlan_private * pmpriv,
 	mlan_adapter *pmadapter = pmpriv->adapter;
 	t_s32 net = -1, j;
 	t_u8 best_rssi = 0;
+	t_s16 idx;
 	t_u32 i;
 
 	ENTER();
@@ -4583,12 +4661,14 @@ wlan_find_ssid_in_list(IN mlan_private * pmpriv,
 	       pmadapter->num_in_scan_table);
 
 	/*
-	 * Loop through the table until the maximum is reached or until a match
-	 *   is found based on the bssid field comparison
+	 * Loop through the entries with this SSID hash until the end of the
+	 *   chain is reached or until a match is found based on the bssid
+	 *   field comparison
 	 */
-	for (i = 0;
-	     i < pmadapter->num_in_scan_table && (!bssid || (bssid && net < 0));
-	     i++) {
+	for (idx = pmadapter->scan_ssid_hash[wlan_scan_ssid_hash(ssid)];
+	     idx != SCAN_TABLE_IDX_NONE && (!bssid || (bssid && net < 0));
+	     idx = pmadapter->scan_ssid_next[idx]) {
+		i = (t_u32) idx;
 		if (!wlan_ssid_cmp
 		    (pmadapter, &pmadapter->pscan_table[i].ssid, ssid) &&
 		    (!bssid ||
@@ -4660,6 +4740,7 @@ wlan_find_bssid_in_list(IN mlan_private * pmpriv,
 {
 	mlan_adapter *pmadapter = pmpriv->adapter;
 	t_s32 net = -1;
+	t_s16 idx;
 	t_u32 i;
 
 	ENTER();
@@ -4673,13 +4754,17 @@ wlan_find_bssid_in_list(IN mlan_private * pmpriv,
 	       pmadapter->num_in_scan_table);
 
 	/*
-	 * Look through the scan table for a compatible match. The ret return
-	 *   variable will be equal to the index in the scan table (greater
-	 *   than zero) if the network is compatible.  The loop will continue
+	 * Look through the entries with this BSSID hash for a compatible
+	 *   match. The ret return variable will be equal to the index in
+	 *   the scan table (greater than zero) if the network is
+	 *   compatible.  The loop will continue
 	 *   past a matched bssid that is not compatible in case there is an
 	 *   AP with multiple SSIDs assigned to the same BSSID
 	 */
-	for (i = 0; net < 0 && i < pmadapter->num_in_scan_table; i++) {
+	for (idx = pmadapter->scan_bssid_hash[wlan_scan_bssid_hash(bssid)];
+	     net < 0 && idx != SCAN_TABLE_IDX_NONE;
+	     idx = pmadapter->scan_bssid_next[idx]) {
+		i = (t_u32) idx;
 		if (!memcmp
 		    (pmadapter, pmadapter->pscan_table[i].mac_address, bssid,
 		     MLAN_MAC_ADDR_LENGTH)) {
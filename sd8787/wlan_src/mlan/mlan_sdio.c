@@ -788,9 +788,102 @@ wlan_decode_rx_packet(mlan_adapter * pmadapter, mlan_buffer * pmbuf,
 }
 
 #ifdef SDIO_MULTI_PORT_RX_AGGR
+/**
+ *  @brief This function allocates a slice descriptor for an MP-A packet.
+ *  The descriptor owns no data; pbuf is pointed into the aggregate
+ *  buffer once the aggregate has been read.
+ *
+ *  @param pmadapter A pointer to mlan_adapter structure
+ *  @return 	     A pointer to mlan_buffer or MNULL
+ */
+static pmlan_buffer
+wlan_alloc_rx_slice(mlan_adapter * pmadapter)
+{
+	pmlan_callbacks pcb = &pmadapter->callbacks;
+	pmlan_buffer pmbuf = MNULL;
+
+	ENTER();
+
+	if (MLAN_STATUS_SUCCESS !=
+	    pcb->moal_malloc(pmadapter->pmoal_handle, sizeof(mlan_buffer),
+			     MLAN_MEM_DEF, (t_u8 **) & pmbuf) || !pmbuf) {
+		PRINTM(MERROR, "Failed to allocate Rx slice\n");
+		LEAVE();
+		return MNULL;
+	}
+	memset(pmadapter, pmbuf, 0, sizeof(mlan_buffer));
+	pmbuf->flags = MLAN_BUF_FLAG_MALLOC_BUF | MLAN_BUF_FLAG_RX_SLICE;
+
+	LEAVE();
+	return pmbuf;
+}
+
+/**
+ *  @brief This function drops the reference an Rx slice holds on its
+ *  aggregate buffer, and frees the aggregate with the last slice.
+ *  The slice descriptor itself is freed by the caller.
+ *
+ *  @param pmadapter A pointer to mlan_adapter structure
+ *  @param pmbuf     A pointer to the slice mlan_buffer
+ *  @return 	     N/A
+ */
+t_void
+wlan_release_rx_slice(mlan_adapter * pmadapter, pmlan_buffer pmbuf)
+{
+	pmlan_callbacks pcb = &pmadapter->callbacks;
+	pmlan_buffer pmbuf_aggr = pmbuf->pslice_parent;
+	t_u32 use_count;
+
+	ENTER();
+
+	pmbuf->pslice_parent = MNULL;
+	if (!pmbuf_aggr) {
+		LEAVE();
+		return;
+	}
+
+	pcb->moal_spin_lock(pmadapter->pmoal_handle,
+			    pmadapter->mpa_rx.slice_lock);
+	use_count = --pmbuf_aggr->use_count;
+	pcb->moal_spin_unlock(pmadapter->pmoal_handle,
+			      pmadapter->mpa_rx.slice_lock);
+	if (!use_count)
+		wlan_free_mlan_buffer(pmadapter, pmbuf_aggr);
+
+	LEAVE();
+	return;
+}
+
+/**
+ *  @brief This function frees the buffers of a pending Rx aggregate
+ *  and resets it.
+ *
+ *  @param pmadapter A pointer to mlan_adapter structure
+ *  @return 	     N/A
+ */
+static t_void
+wlan_drop_mp_aggr_buf(mlan_adapter * pmadapter)
+{
+	t_u32 pind;
+
+	for (pind = 0; pind < pmadapter->mpa_rx.pkt_cnt; pind++) {
+		wlan_free_mlan_buffer(pmadapter,
+				      pmadapter->mpa_rx.mbuf_arr[pind]);
+		pmadapter->mpa_rx.mbuf_arr[pind] = MNULL;
+	}
+	MP_RX_AGGR_BUF_RESET(pmadapter);
+}
+
 /**
  *  @brief This function receives data from the card in aggregate mode.
  *
+ *  In slice mode the aggregate is read into a freshly allocated
+ *  mlan_buffer and every packet is handed up as a slice of it,
+ *  so no data is copied; the aggregate is freed with its last slice.
+ *  Otherwise, or when the aggregate buffer cannot be allocated, the
+ *  aggregate is read into mpa_rx.buf and each packet is copied into
+ *  its own buffer.
+ *
  *  @param pmadapter A pointer to mlan_adapter structure
  *  @return 	     MLAN_STATUS_SUCCESS or MLAN_STATUS_FAILURE
  */
@@ -800,6 +893,7 @@ wlan_receive_mp_aggr_buf(mlan_adapter * pmadapter)
 	mlan_status ret = MLAN_STATUS_SUCCESS;
 	pmlan_callbacks pcb = &pmadapter->callbacks;
 	mlan_buffer mbuf_aggr;
+	mlan_buffer *pmbuf_aggr = MNULL;
 	mlan_buffer *mbuf_deaggr;
 	t_u32 pind = 0;
 	t_u32 pkt_len, pkt_type = 0;
@@ -810,24 +904,43 @@ wlan_receive_mp_aggr_buf(mlan_adapter * pmadapter)
 	PRINTM(MINFO, "do_rx_aggr: num of packets: %d\n",
 	       pmadapter->mpa_rx.pkt_cnt);
 
-	memset(pmadapter, &mbuf_aggr, 0, sizeof(mlan_buffer));
-
-	mbuf_aggr.pbuf = (t_u8 *) pmadapter->mpa_rx.buf;
-	mbuf_aggr.data_len = pmadapter->mpa_rx.buf_len;
+	if (pmadapter->mpa_rx.slice) {
+		pmbuf_aggr = wlan_alloc_mlan_buffer(pmadapter,
+						    pmadapter->mpa_rx.buf_len,
+						    0, MOAL_ALLOC_MLAN_BUFFER);
+		if (pmbuf_aggr)
+			pmbuf_aggr->data_len = pmadapter->mpa_rx.buf_len;
+		else
+			PRINTM(MWARN,
+			       "No MP-A Rx buffer, copy the aggregate\n");
+	}
+	if (!pmbuf_aggr) {
+		memset(pmadapter, &mbuf_aggr, 0, sizeof(mlan_buffer));
+		mbuf_aggr.pbuf = (t_u8 *) pmadapter->mpa_rx.buf;
+		mbuf_aggr.data_len = pmadapter->mpa_rx.buf_len;
+		pmbuf_aggr = &mbuf_aggr;
+	}
 
 	cmd53_port = (pmadapter->ioport | SDIO_MPA_ADDR_BASE |
 		      (pmadapter->mpa_rx.ports << 4)) +
 		pmadapter->mpa_rx.start_port;
 	if (MLAN_STATUS_SUCCESS !=
-	    pcb->moal_read_data_sync(pmadapter->pmoal_handle, &mbuf_aggr,
+	    pcb->moal_read_data_sync(pmadapter->pmoal_handle, pmbuf_aggr,
 				     cmd53_port, 0)) {
+		if (pmbuf_aggr != &mbuf_aggr)
+			wlan_free_mlan_buffer(pmadapter, pmbuf_aggr);
+		wlan_drop_mp_aggr_buf(pmadapter);
 		ret = MLAN_STATUS_FAILURE;
 		goto done;
 	}
-	DBG_HEXDUMP(MIF_D, "SDIO MP-A Blk Rd", pmadapter->mpa_rx.buf,
+	curr_ptr = pmbuf_aggr->pbuf + pmbuf_aggr->data_offset;
+	DBG_HEXDUMP(MIF_D, "SDIO MP-A Blk Rd", curr_ptr,
 		    MIN(pmadapter->mpa_rx.buf_len, MAX_DATA_DUMP_LEN));
 
-	curr_ptr = pmadapter->mpa_rx.buf;
+	/* Every slice holds a reference until it is freed, whether it is
+	   handed up or dropped below */
+	if (pmbuf_aggr != &mbuf_aggr)
+		pmbuf_aggr->use_count = pmadapter->mpa_rx.pkt_cnt;
 
 	for (pind = 0; pind < pmadapter->mpa_rx.pkt_cnt; pind++) {
 
@@ -838,13 +951,38 @@ wlan_receive_mp_aggr_buf(mlan_adapter * pmadapter)
 		PRINTM(MINFO, "RX: [%d] pktlen: %d pkt_type: 0x%x\n", pind,
 		       pkt_len, pkt_type);
 
-		/* copy pkt to deaggr buf */
 		mbuf_deaggr = pmadapter->mpa_rx.mbuf_arr[pind];
+		if (pmbuf_aggr != &mbuf_aggr) {
+			/* point the slice at its packet in the aggregate */
+			mbuf_deaggr->pslice_parent = pmbuf_aggr;
+			mbuf_deaggr->pbuf = pmbuf_aggr->pbuf;
+			mbuf_deaggr->data_offset =
+				(t_u32) (curr_ptr - pmbuf_aggr->pbuf);
+			mbuf_deaggr->data_len = pmadapter->mpa_rx.len_arr[pind];
+		} else if (mbuf_deaggr->flags & MLAN_BUF_FLAG_RX_SLICE) {
+			/* the slice has no data of its own to copy into */
+			wlan_free_mlan_buffer(pmadapter, mbuf_deaggr);
+			mbuf_deaggr =
+				wlan_alloc_mlan_buffer(pmadapter,
+						       pmadapter->mpa_rx.
+						       len_arr[pind],
+						       MLAN_RX_HEADER_LEN,
+						       MOAL_ALLOC_MLAN_BUFFER);
+			if (!mbuf_deaggr) {
+				PRINTM(MERROR,
+				       "Failed to allocate 'mlan_buffer'\n");
+				curr_ptr += pmadapter->mpa_rx.len_arr[pind];
+				continue;
+			}
+		}
 		if ((pkt_type == MLAN_TYPE_DATA) &&
 		    (pkt_len <= pmadapter->mpa_rx.len_arr[pind])) {
-			memcpy(pmadapter,
-			       mbuf_deaggr->pbuf + mbuf_deaggr->data_offset,
-			       curr_ptr, pkt_len);
+			/* copy pkt to deaggr buf */
+			if (pmbuf_aggr == &mbuf_aggr)
+				memcpy(pmadapter,
+				       mbuf_deaggr->pbuf +
+				       mbuf_deaggr->data_offset, curr_ptr,
+				       pkt_len);
 			pmadapter->upld_len = pkt_len;
 			/* Process de-aggr packet */
 			wlan_decode_rx_packet(pmadapter, mbuf_deaggr, pkt_type);
@@ -880,7 +1018,6 @@ wlan_sdio_card_to_host_mp_aggr(mlan_adapter * pmadapter, mlan_buffer
 	t_s32 f_do_rx_aggr = 0;
 	t_s32 f_do_rx_cur = 0;
 	t_s32 f_aggr_cur = 0;
-	t_u32 pind = 0;
 	t_u32 pkt_type = 0;
 
 	ENTER();
@@ -939,6 +1076,14 @@ wlan_sdio_card_to_host_mp_aggr(mlan_adapter * pmadapter, mlan_buffer
 
 	if (f_aggr_cur) {
 		PRINTM(MINFO, "Current packet aggregation.\n");
+		if (!pmbuf) {
+			/* Only a descriptor is needed for a slice */
+			pmbuf = wlan_alloc_rx_slice(pmadapter);
+			if (!pmbuf) {
+				ret = MLAN_STATUS_FAILURE;
+				goto done;
+			}
+		}
 		/* Curr pkt can be aggregated */
 		MP_RX_AGGR_SETUP(pmadapter, pmbuf, port, rx_len);
 
@@ -963,6 +1108,19 @@ rx_curr_single:
 		PRINTM(MINFO, "RX: f_do_rx_cur: port: %d rx_len: %d\n", port,
 		       rx_len);
 
+		if (!pmbuf) {
+			/* Allocation was deferred in slice mode */
+			pmbuf = wlan_alloc_mlan_buffer(pmadapter, rx_len,
+						       MLAN_RX_HEADER_LEN,
+						       MOAL_ALLOC_MLAN_BUFFER);
+			if (!pmbuf) {
+				PRINTM(MERROR,
+				       "Failed to allocate 'mlan_buffer'\n");
+				ret = MLAN_STATUS_FAILURE;
+				goto done;
+			}
+		}
+
 		if (MLAN_STATUS_SUCCESS !=
 		    wlan_sdio_card_to_host(pmadapter, &pkt_type,
 					   (t_u32 *) & pmadapter->upld_len,
@@ -991,12 +1149,7 @@ done:
 	if (ret == MLAN_STATUS_FAILURE) {
 		if (MP_RX_AGGR_IN_PROGRESS(pmadapter)) {
 			/* MP-A transfer failed - cleanup */
-			for (pind = 0; pind < pmadapter->mpa_rx.pkt_cnt; pind++) {
-				wlan_free_mlan_buffer(pmadapter,
-						      pmadapter->mpa_rx.
-						      mbuf_arr[pind]);
-			}
-			MP_RX_AGGR_BUF_RESET(pmadapter);
+			wlan_drop_mp_aggr_buf(pmadapter);
 		}
 
 		if (f_do_rx_cur) {
@@ -1549,12 +1702,17 @@ wlan_process_int_status(mlan_adapter * pmadapter)
 				pmbuf = wlan_alloc_mlan_buffer(pmadapter,
 							       rx_len, 0,
 							       MOAL_MALLOC_BUFFER);
+			else if (MP_RX_AGGR_DEFER_ALLOC(pmadapter, port))
+				/* wlan_sdio_card_to_host_mp_aggr allocates
+				   a slice or a full buffer as needed */
+				pmbuf = MNULL;
 			else
 				pmbuf = wlan_alloc_mlan_buffer(pmadapter,
 							       rx_len,
 							       MLAN_RX_HEADER_LEN,
 							       MOAL_ALLOC_MLAN_BUFFER);
-			if (pmbuf == MNULL) {
+			if ((pmbuf == MNULL) &&
+			    !MP_RX_AGGR_DEFER_ALLOC(pmadapter, port)) {
 				PRINTM(MERROR,
 				       "Failed to allocate 'mlan_buffer'\n");
 				ret = MLAN_STATUS_FAILURE;
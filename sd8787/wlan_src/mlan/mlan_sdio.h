@@ -293,6 +293,15 @@ Change log:
 	a->mpa_rx.start_port = 0;                \
 } while (0);
 
+/** Data port buffer is allocated by the Rx aggregation path ? */
+#define MP_RX_AGGR_DEFER_ALLOC(a, port) (((port) != CTRL_PORT) && \
+			a->mpa_rx.enabled && a->mpa_rx.slice)
+
+#else
+
+/** Data port buffer is allocated by the Rx aggregation path ? */
+#define MP_RX_AGGR_DEFER_ALLOC(a, port) MFALSE
+
 #endif /* SDIO_MULTI_PORT_RX_AGGR */
 
 /** Enable host interrupt */
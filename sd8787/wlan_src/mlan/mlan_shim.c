@@ -259,7 +259,9 @@ mlan_register(IN pmlan_device pmdevice, OUT t_void ** ppmlan_adapter)
 #endif
 #ifdef SDIO_MULTI_PORT_RX_AGGR
 	pmadapter->init_para.mpa_rx_cfg = pmdevice->mpa_rx_cfg;
+	pmadapter->init_para.mpa_rx_slice_cfg = pmdevice->mpa_rx_slice_cfg;
 #endif
+	pmadapter->init_para.multi_cmd_cfg = pmdevice->multi_cmd_cfg;
 	pmadapter->init_para.auto_ds = pmdevice->auto_ds;
 	pmadapter->init_para.ps_mode = pmdevice->ps_mode;
 	if (pmdevice->max_tx_buf == MLAN_TX_DATA_BUF_SIZE_2K ||
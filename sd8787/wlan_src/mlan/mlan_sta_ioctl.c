@@ -5212,11 +5212,7 @@ start_config:
 			if (pmadapter->bgscan_reported) {
 				pmadapter->bgscan_reported = MFALSE;
 				/* Clear the previous scan result */
-				memset(pmadapter, pmadapter->pscan_table, 0x00,
-				       sizeof(BSSDescriptor_t) *
-				       MRVDRV_MAX_BSSID_LIST);
-				pmadapter->num_in_scan_table = 0;
-				pmadapter->pbcn_buf_end = pmadapter->bcn_buf;
+				wlan_flush_scan_table(pmadapter);
 				status = wlan_prepare_cmd(pmpriv,
 							  HostCmd_CMD_802_11_BG_SCAN_QUERY,
 							  HostCmd_ACT_GEN_GET,
@@ -552,6 +552,47 @@ wlan_process_uap_rx_packet(IN mlan_private * priv, IN pmlan_buffer pmbuf)
 			/* Forwarding Intra-BSS packet */
 			pmbuf->data_len -= prx_pd->rx_pkt_offset;
 			pmbuf->data_offset += prx_pd->rx_pkt_offset;
+			if (pmbuf->flags & MLAN_BUF_FLAG_RX_SLICE) {
+				/* The UapTxPD would overwrite the previous
+				   packet of the MP-A aggregate, forward a copy */
+				if (pmbuf->data_len + sizeof(UapTxPD) +
+				    INTF_HEADER_LEN + DMA_ALIGNMENT >
+				    MLAN_TX_DATA_BUF_SIZE_2K) {
+					PRINTM(MERROR,
+					       "Drop Intra-BSS pkt: len=%d\n",
+					       pmbuf->data_len);
+					pmbuf->status_code =
+						MLAN_ERROR_PKT_SIZE_INVALID;
+					wlan_free_mlan_buffer(pmadapter, pmbuf);
+					goto done;
+				}
+				newbuf = wlan_alloc_mlan_buffer(pmadapter,
+								MLAN_TX_DATA_BUF_SIZE_2K,
+								0,
+								MOAL_MALLOC_BUFFER);
+				if (!newbuf) {
+					pmbuf->status_code =
+						MLAN_ERROR_PKT_INVALID;
+					wlan_free_mlan_buffer(pmadapter, pmbuf);
+					goto done;
+				}
+				newbuf->bss_index = pmbuf->bss_index;
+				newbuf->buf_type = pmbuf->buf_type;
+				newbuf->priority = pmbuf->priority;
+				newbuf->in_ts_sec = pmbuf->in_ts_sec;
+				newbuf->in_ts_usec = pmbuf->in_ts_usec;
+				newbuf->data_offset =
+					(sizeof(UapTxPD) + INTF_HEADER_LEN +
+					 DMA_ALIGNMENT);
+				memcpy(pmadapter,
+				       (t_u8 *) newbuf->pbuf +
+				       newbuf->data_offset,
+				       pmbuf->pbuf + pmbuf->data_offset,
+				       pmbuf->data_len);
+				newbuf->data_len = pmbuf->data_len;
+				wlan_free_mlan_buffer(pmadapter, pmbuf);
+				pmbuf = newbuf;
+			}
 			pmbuf->flags |= MLAN_BUF_FLAG_BRIDGE_BUF;
 			pmadapter->pending_bridge_pkts++;
 			wlan_wmm_add_buf_txqueue(pmadapter, pmbuf);
@@ -519,4 +519,23 @@ util_scalar_conditional_write(t_void * pmoal_handle,
 	return (update) ? MTRUE : MFALSE;
 }
 
+/**
+ *  @brief This function returns the index of the lowest set bit
+ *         of a word
+ *
+ *  @param word				Word to scan, must not be 0
+ *
+ *  @return					Bit index (0 - 31)
+ */
+static INLINE t_u32
+util_ffs32(t_u32 word)
+{
+	static const t_u8 debruijn_pos[32] = {
+		0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8,
+		31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9
+	};
+
+	return debruijn_pos[((word & (~word + 1)) * 0x077CB531U) >> 27];
+}
+
 #endif /* !_MLAN_UTIL_H_ */
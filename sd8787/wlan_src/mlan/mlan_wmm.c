@@ -209,6 +209,63 @@ done:
 	return ra_list;
 }
 
+/**
+ *  @brief Get the RA list hash bucket of a receiver address and TID
+ *
+ *  @param ra       Receiver address
+ *  @param tid      TID
+ *
+ *  @return         Bucket index
+ */
+static INLINE t_u32
+wlan_wmm_ralist_hash(t_u8 * ra, t_u8 tid)
+{
+	return ((ra[3] ^ ra[4] ^ ra[5]) + (tid * 13)) &
+		(WMM_RALIST_HASH_SIZE - 1);
+}
+
+/**
+ *  @brief Add an RA list to the RA list hash table
+ *
+ *  @param priv     Pointer to the mlan_private driver data struct
+ *  @param ra_list  Pointer to raListTbl
+ *
+ *  @return         N/A
+ */
+static INLINE void
+wlan_wmm_ralist_hash_insert(pmlan_private priv, raListTbl * ra_list)
+{
+	t_u32 idx = wlan_wmm_ralist_hash(ra_list->ra, ra_list->tid);
+
+	ra_list->hnext = priv->wmm.ralist_hash[idx];
+	priv->wmm.ralist_hash[idx] = ra_list;
+}
+
+/**
+ *  @brief Remove an RA list from the RA list hash table
+ *
+ *  @param priv     Pointer to the mlan_private driver data struct
+ *  @param ra_list  Pointer to raListTbl
+ *
+ *  @return         N/A
+ */
+static INLINE void
+wlan_wmm_ralist_hash_remove(pmlan_private priv, raListTbl * ra_list)
+{
+	raListTbl **pprev =
+		&priv->wmm.ralist_hash[wlan_wmm_ralist_hash(ra_list->ra,
+							    ra_list->tid)];
+
+	while (*pprev) {
+		if (*pprev == ra_list) {
+			*pprev = ra_list->hnext;
+			break;
+		}
+		pprev = &(*pprev)->hnext;
+	}
+	ra_list->hnext = MNULL;
+}
+
 /**
  * @brief Map ACs to TID
  *
@@ -373,6 +430,7 @@ wlan_wmm_del_pkts_in_ralist_node(pmlan_private priv, raListTbl * ra_list)
 				 (pmlan_linked_list) pmbuf, MNULL, MNULL);
 		wlan_write_data_complete(pmadapter, pmbuf, MLAN_STATUS_FAILURE);
 	}
+	wlan_wmm_update_ralist_active(priv, ra_list);
 	util_free_list_head((t_void *) pmadapter->pmoal_handle,
 			    &ra_list->buf_head,
 			    pmadapter->callbacks.moal_free_lock);
@@ -469,8 +527,13 @@ wlan_wmm_delete_all_ralist(pmlan_private priv)
 
 		util_init_list((pmlan_linked_list)
 			       & priv->wmm.tid_tbl_ptr[i].ra_list);
+		util_init_list((pmlan_linked_list)
+			       & priv->wmm.tid_tbl_ptr[i].active_ra);
 		priv->wmm.tid_tbl_ptr[i].ra_list_curr = MNULL;
 	}
+	priv->wmm.tid_active_bitmap = 0;
+	memset(pmadapter, priv->wmm.ralist_hash, 0,
+	       sizeof(priv->wmm.ralist_hash));
 
 	LEAVE();
 }
@@ -600,7 +663,7 @@ wlan_wmm_get_highest_priolist_ptr(pmlan_adapter pmadapter,
 				  pmlan_private * priv, int *tid)
 {
 	pmlan_private priv_tmp;
-	raListTbl *ptr, *head;
+	raListTbl *ptr;
 	mlan_bssprio_node *bssprio_node, *bssprio_head;
 	tid_tbl_t *tid_ptr;
 	int i, j;
@@ -650,77 +713,54 @@ wlan_wmm_get_highest_priolist_ptr(pmlan_adapter pmadapter,
 						  MNULL); i >= LOW_PRIO_TID;
 			     --i) {
 
-				tid_ptr =
-					&(priv_tmp)->wmm.
-					tid_tbl_ptr[tos_to_tid[i]];
-				if (!util_peek_list
-				    (pmadapter->pmoal_handle, &tid_ptr->ra_list,
-				     MNULL, MNULL))
+				/* Skip TIDs without an RA list ready to send */
+				if (!(priv_tmp->wmm.tid_active_bitmap &
+				      MBIT(tos_to_tid[i])))
 					continue;
 
 				/*
-				 * Always choose the next ra we transmitted
-				 * last time, this way we pick the ra's in
-				 * round robin fashion.
+				 * The head of the active ring is the next ra
+				 * in round robin order; an ra that transmits
+				 * is moved to the tail.
 				 */
-				head = ptr = tid_ptr->ra_list_curr->pnext;
-				if (ptr == (raListTbl *) & tid_ptr->ra_list)
-					head = ptr = ptr->pnext;
-
-				do {
-					if (!ptr->tx_pause &&
-					    util_peek_list(pmadapter->
-							   pmoal_handle,
-							   &ptr->buf_head,
-							   MNULL, MNULL)) {
-
-						/* Because WMM only support
-						   BK/BE/VI/VO, we have 8 tid
-						   We should balance the
-						   traffic of the same AC */
-						if (i % 2)
-							next_prio = i - 1;
-						else
-							next_prio = i + 1;
-						next_tid =
-							tos_to_tid[next_prio];
-						if (priv_tmp->wmm.
-						    pkts_queued[next_tid])
-							util_scalar_write
-								(pmadapter->
-								 pmoal_handle,
-								 &priv_tmp->wmm.
-								 highest_queued_prio,
-								 next_prio,
-								 MNULL, MNULL);
-						else
-							/* if
-							   highest_queued_prio
-							   > i, set it to i */
-							util_scalar_conditional_write
-								(pmadapter->
-								 pmoal_handle,
-								 &priv_tmp->wmm.
-								 highest_queued_prio,
-								 MLAN_SCALAR_COND_GREATER_THAN,
-								 i, i, MNULL,
-								 MNULL);
-						*priv = priv_tmp;
-						*tid = tos_to_tid[i];
-						/* hold priv->ra_list_spinlock
-						   to maintain ptr */
-						PRINTM(MDAT_D,
-						       "get highest prio ptr %p, tid %d\n",
-						       ptr, *tid);
-						LEAVE();
-						return ptr;
-					}
-
-					ptr = ptr->pnext;
-					if (ptr ==
-					    (raListTbl *) & tid_ptr->ra_list)
-						ptr = ptr->pnext;
-				} while (ptr != head);
+				tid_ptr =
+					&(priv_tmp)->wmm.
+					tid_tbl_ptr[tos_to_tid[i]];
+				ptr = ((ralist_active_node *) tid_ptr->
+				       active_ra.pnext)->ra_list;
+
+				/* Because WMM only support BK/BE/VI/VO, we
+				   have 8 tid We should balance the traffic of
+				   the same AC */
+				if (i % 2)
+					next_prio = i - 1;
+				else
+					next_prio = i + 1;
+				next_tid = tos_to_tid[next_prio];
+				if (priv_tmp->wmm.pkts_queued[next_tid])
+					util_scalar_write(pmadapter->
+							  pmoal_handle,
+							  &priv_tmp->wmm.
+							  highest_queued_prio,
+							  next_prio, MNULL,
+							  MNULL);
+				else
+					/* if highest_queued_prio > i, set it
+					   to i */
+					util_scalar_conditional_write
+						(pmadapter->pmoal_handle,
+						 &priv_tmp->wmm.
+						 highest_queued_prio,
+						 MLAN_SCALAR_COND_GREATER_THAN,
+						 i, i, MNULL, MNULL);
+				*priv = priv_tmp;
+				*tid = tos_to_tid[i];
+				/* hold priv->ra_list_spinlock to maintain ptr */
+				PRINTM(MDAT_D,
+				       "get highest prio ptr %p, tid %d\n", ptr,
+				       *tid);
+				LEAVE();
+				return ptr;
 			}
 
 			/* No packet at any TID for this priv.  Mark as such to
@@ -807,6 +847,7 @@ wlan_send_single_packet(pmlan_private priv, raListTbl * ptr, int ptrindex)
 		util_scalar_decrement(pmadapter->pmoal_handle,
 				      &priv->wmm.tx_pkts_queued, MNULL, MNULL);
 		ptr->total_pkts--;
+		wlan_wmm_update_ralist_active(priv, ptr);
 		pmbuf_next =
 			(pmlan_buffer) util_peek_list(pmadapter->pmoal_handle,
 						      &ptr->buf_head, MNULL,
@@ -850,6 +891,7 @@ wlan_send_single_packet(pmlan_private priv, raListTbl * ptr, int ptrindex)
 					       MNULL);
 
 			ptr->total_pkts++;
+			wlan_wmm_update_ralist_active(priv, ptr);
 			pmbuf->flags |= MLAN_BUF_FLAG_REQUEUED_PKT;
 			pmadapter->callbacks.moal_spin_unlock(pmadapter->
 							      pmoal_handle,
@@ -862,8 +904,7 @@ wlan_send_single_packet(pmlan_private priv, raListTbl * ptr, int ptrindex)
 							    ra_list_spinlock);
 			if (wlan_is_ralist_valid(priv, ptr, ptrindex)) {
 				priv->wmm.packets_out[ptrindex]++;
-				priv->wmm.tid_tbl_ptr[ptrindex].ra_list_curr =
-					ptr;
+				wlan_wmm_rotate_ralist(priv, ptr);
 			}
 			pmadapter->bssprio_tbl[priv->bss_priority].bssprio_cur =
 				pmadapter->bssprio_tbl[priv->bss_priority].
@@ -925,6 +966,7 @@ wlan_send_processed_packet(pmlan_private priv, raListTbl * ptr, int ptrindex)
 	pmbuf = (pmlan_buffer) util_dequeue_list(pmadapter->pmoal_handle,
 						 &ptr->buf_head, MNULL, MNULL);
 	if (pmbuf) {
+		wlan_wmm_update_ralist_active(priv, ptr);
 		pmbuf_next =
 			(pmlan_buffer) util_peek_list(pmadapter->pmoal_handle,
 						      &ptr->buf_head, MNULL,
@@ -960,6 +1002,7 @@ wlan_send_processed_packet(pmlan_private priv, raListTbl * ptr, int ptrindex)
 					       &ptr->buf_head,
 					       (pmlan_linked_list) pmbuf,
 					       MNULL, MNULL);
+			wlan_wmm_update_ralist_active(priv, ptr);
 
 			pmbuf->flags |= MLAN_BUF_FLAG_REQUEUED_PKT;
 			pmadapter->callbacks.moal_spin_unlock(pmadapter->
@@ -994,8 +1037,7 @@ wlan_send_processed_packet(pmlan_private priv, raListTbl * ptr, int ptrindex)
 							    ra_list_spinlock);
 			if (wlan_is_ralist_valid(priv, ptr, ptrindex)) {
 				priv->wmm.packets_out[ptrindex]++;
-				priv->wmm.tid_tbl_ptr[ptrindex].ra_list_curr =
-					ptr;
+				wlan_wmm_rotate_ralist(priv, ptr);
 				ptr->total_pkts--;
 			}
 			pmadapter->bssprio_tbl[priv->bss_priority].bssprio_cur =
@@ -1145,6 +1187,7 @@ wlan_update_ralist_tx_pause(pmlan_private priv, t_u8 * mac, t_u8 tx_pause)
 		if (ra_list) {
 			pkt_cnt += ra_list->total_pkts;
 			ra_list->tx_pause = tx_pause;
+			wlan_wmm_update_ralist_active(priv, ra_list);
 		}
 	}
 	if (pkt_cnt) {
@@ -1463,10 +1506,14 @@ wlan_ralist_add(mlan_private * priv, t_u8 * ra)
 				wlan_get_random_ba_threshold(pmadapter);
 		}
 
+		ra_list->tid = (t_u8) i;
+		ra_list->active = MFALSE;
+		ra_list->active_node.ra_list = ra_list;
 		util_enqueue_list_tail(pmadapter->pmoal_handle,
 				       &priv->wmm.tid_tbl_ptr[i].ra_list,
 				       (pmlan_linked_list) ra_list, MNULL,
 				       MNULL);
+		wlan_wmm_ralist_hash_insert(priv, ra_list);
 
 		if (!priv->wmm.tid_tbl_ptr[i].ra_list_curr)
 			priv->wmm.tid_tbl_ptr[i].ra_list_curr = ra_list;
@@ -1641,24 +1688,88 @@ wlan_wmm_get_ralist_node(pmlan_private priv, t_u8 tid, t_u8 * ra_addr)
 {
 	raListTbl *ra_list;
 	ENTER();
-	ra_list =
-		(raListTbl *) util_peek_list(priv->adapter->pmoal_handle,
-					     &priv->wmm.tid_tbl_ptr[tid].
-					     ra_list, MNULL, MNULL);
-	while (ra_list && (ra_list != (raListTbl *)
-			   & priv->wmm.tid_tbl_ptr[tid].ra_list)) {
-		if (!memcmp
-		    (priv->adapter, ra_list->ra, ra_addr,
-		     MLAN_MAC_ADDR_LENGTH)) {
+	ra_list = priv->wmm.ralist_hash[wlan_wmm_ralist_hash(ra_addr, tid)];
+	while (ra_list) {
+		if ((ra_list->tid == tid) &&
+		    !memcmp(priv->adapter, ra_list->ra, ra_addr,
+			    MLAN_MAC_ADDR_LENGTH)) {
 			LEAVE();
 			return ra_list;
 		}
-		ra_list = ra_list->pnext;
+		ra_list = ra_list->hnext;
 	}
 	LEAVE();
 	return MNULL;
 }
 
+/**
+ *  @brief Link or unlink an RA list in its TID's active ring, so that the
+ *         ring holds exactly the RA lists with unpaused packets queued.
+ *         Must be called with ra_list_spinlock held after the RA list's
+ *         buffer queue or tx_pause flag changes.
+ *
+ *  @param priv     Pointer to the mlan_private driver data struct
+ *  @param ra_list  Pointer to raListTbl
+ *
+ *  @return         N/A
+ */
+t_void
+wlan_wmm_update_ralist_active(pmlan_private priv, raListTbl * ra_list)
+{
+	tid_tbl_t *tid_ptr = &priv->wmm.tid_tbl_ptr[ra_list->tid];
+	t_u8 ready;
+
+	ready = !ra_list->tx_pause &&
+		util_peek_list(priv->adapter->pmoal_handle, &ra_list->buf_head,
+			       MNULL, MNULL);
+	if (ready && !ra_list->active) {
+		util_enqueue_list_tail(priv->adapter->pmoal_handle,
+				       &tid_ptr->active_ra,
+				       (pmlan_linked_list) & ra_list->
+				       active_node, MNULL, MNULL);
+		ra_list->active = MTRUE;
+		priv->wmm.tid_active_bitmap |= (t_u8) MBIT(ra_list->tid);
+	} else if (!ready && ra_list->active) {
+		util_unlink_list(priv->adapter->pmoal_handle,
+				 &tid_ptr->active_ra,
+				 (pmlan_linked_list) & ra_list->active_node,
+				 MNULL, MNULL);
+		ra_list->active = MFALSE;
+		if (!util_peek_list(priv->adapter->pmoal_handle,
+				    &tid_ptr->active_ra, MNULL, MNULL))
+			priv->wmm.tid_active_bitmap &=
+				(t_u8) ~MBIT(ra_list->tid);
+	}
+}
+
+/**
+ *  @brief Record that an RA list transmitted, moving it to the end of its
+ *         TID's active ring so the other RAs are served first.
+ *         Must be called with ra_list_spinlock held.
+ *
+ *  @param priv     Pointer to the mlan_private driver data struct
+ *  @param ra_list  Pointer to raListTbl
+ *
+ *  @return         N/A
+ */
+t_void
+wlan_wmm_rotate_ralist(pmlan_private priv, raListTbl * ra_list)
+{
+	tid_tbl_t *tid_ptr = &priv->wmm.tid_tbl_ptr[ra_list->tid];
+
+	tid_ptr->ra_list_curr = ra_list;
+	if (ra_list->active) {
+		util_unlink_list(priv->adapter->pmoal_handle,
+				 &tid_ptr->active_ra,
+				 (pmlan_linked_list) & ra_list->active_node,
+				 MNULL, MNULL);
+		util_enqueue_list_tail(priv->adapter->pmoal_handle,
+				       &tid_ptr->active_ra,
+				       (pmlan_linked_list) & ra_list->
+				       active_node, MNULL, MNULL);
+	}
+}
+
 /**
  *   @brief Check if RA list is valid or not
  *
@@ -1732,8 +1843,10 @@ wlan_ralist_update(mlan_private * priv, t_u8 * old_ra, t_u8 * new_ra)
 			       "\n", ra_list, ra_list->is_11n_enabled,
 			       MAC2STR(ra_list->ra), MAC2STR(new_ra));
 
+			wlan_wmm_ralist_hash_remove(priv, ra_list);
 			memcpy(priv->adapter, ra_list->ra, new_ra,
 			       MLAN_MAC_ADDR_LENGTH);
+			wlan_wmm_ralist_hash_insert(priv, ra_list);
 		}
 	}
 
@@ -1823,6 +1936,7 @@ wlan_wmm_add_buf_txqueue(pmlan_adapter pmadapter, pmlan_buffer pmbuf)
 	       pmbuf, pmbuf->priority, tid_down, ra_list);
 	util_enqueue_list_tail(pmadapter->pmoal_handle, &ra_list->buf_head,
 			       (pmlan_linked_list) pmbuf, MNULL, MNULL);
+	wlan_wmm_update_ralist_active(priv, ra_list);
 
 	ra_list->total_pkts++;
 	ra_list->packet_count++;
@@ -2239,6 +2353,7 @@ wlan_del_tx_pkts_in_ralist(pmlan_private priv,
 				priv->wmm.pkts_queued[tid]--;
 				priv->num_drop_pkts++;
 				ra_list->total_pkts--;
+				wlan_wmm_update_ralist_active(priv, ra_list);
 				if (!ra_list->tx_pause)
 					util_scalar_decrement(pmadapter->
 							      pmoal_handle,
@@ -2313,6 +2428,7 @@ wlan_wmm_delete_peer_ralist(pmlan_private priv, t_u8 * mac)
 				pkt_cnt += ra_list->total_pkts;
 			wlan_wmm_del_pkts_in_ralist_node(priv, ra_list);
 
+			wlan_wmm_ralist_hash_remove(priv, ra_list);
 			util_unlink_list(pmadapter->pmoal_handle,
 					 &priv->wmm.tid_tbl_ptr[i].ra_list,
 					 (pmlan_linked_list) ra_list, MNULL,
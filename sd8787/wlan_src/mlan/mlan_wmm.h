@@ -93,6 +93,10 @@ int wlan_is_ralist_valid(mlan_private * priv, raListTbl * ra_list, int tid);
 
 raListTbl *wlan_wmm_get_ralist_node(pmlan_private priv, t_u8 tid,
 				    t_u8 * ra_addr);
+/** Sync an RA list's membership in its TID's active ring */
+t_void wlan_wmm_update_ralist_active(pmlan_private priv, raListTbl * ra_list);
+/** Move an RA list that just transmitted to the end of its active ring */
+t_void wlan_wmm_rotate_ralist(pmlan_private priv, raListTbl * ra_list);
 t_u8 wlan_get_random_ba_threshold(pmlan_adapter pmadapter);
 
 /** Compute driver packet delay */
@@ -260,6 +260,8 @@ typedef t_u8 mlan_802_11_mac_addr[MLAN_MAC_ADDR_LENGTH];
 
 /** Buffer flag for bridge packet */
 #define MLAN_BUF_FLAG_BRIDGE_BUF        MBIT(3)
+/** Buffer flag for a slice of an SDIO MP-A Rx aggregate */
+#define MLAN_BUF_FLAG_RX_SLICE          MBIT(4)
 
 #define MLAN_BUF_FLAG_TCP_ACK		MBIT(9)
 
@@ -542,6 +544,8 @@ typedef struct _mlan_buffer {
 	struct _mlan_buffer *pparent;
     /** Use count for this buffer */
 	t_u32 use_count;
+    /** Aggregate buffer holding the data of an Rx slice */
+	struct _mlan_buffer *pslice_parent;
 } mlan_buffer, *pmlan_buffer;
 
 /** mlan_bss_attr data structure */
@@ -844,7 +848,11 @@ typedef struct _mlan_device {
 #ifdef SDIO_MULTI_PORT_RX_AGGR
     /** SDIO MPA Rx */
 	t_u32 mpa_rx_cfg;
+    /** SDIO MPA Rx deaggregation by slicing instead of copying */
+	t_u32 mpa_rx_slice_cfg;
 #endif
+    /** Multi-command transfers, used only when enabled here */
+	t_u32 multi_cmd_cfg;
     /** Auto deep sleep */
 	t_u32 auto_ds;
     /** IEEE PS mode */
@@ -139,6 +139,20 @@ static struct debug_data items[] = {
 	{"num_no_cmd_node", item_size(num_no_cmd_node),
 	 item_addr(num_no_cmd_node)}
 	,
+	{"last_cmd_resp_lat", item_size(last_cmd_resp_lat),
+	 item_addr(last_cmd_resp_lat)}
+	,
+	{"max_cmd_resp_lat", item_size(max_cmd_resp_lat),
+	 item_addr(max_cmd_resp_lat)}
+	,
+	{"max_lat_cmd_id", item_size(max_lat_cmd_id),
+	 item_addr(max_lat_cmd_id)}
+	,
+	{"num_cmd_batch", item_size(num_cmd_batch), item_addr(num_cmd_batch)}
+	,
+	{"num_cmd_batched", item_size(num_cmd_batched),
+	 item_addr(num_cmd_batched)}
+	,
 	{"num_cmd_h2c_fail", item_size(num_cmd_host_to_card_failure),
 	 item_addr(num_cmd_host_to_card_failure)}
 	,
@@ -326,6 +340,20 @@ static struct debug_data uap_items[] = {
 	{"num_no_cmd_node", item_size(num_no_cmd_node),
 	 item_addr(num_no_cmd_node)}
 	,
+	{"last_cmd_resp_lat", item_size(last_cmd_resp_lat),
+	 item_addr(last_cmd_resp_lat)}
+	,
+	{"max_cmd_resp_lat", item_size(max_cmd_resp_lat),
+	 item_addr(max_cmd_resp_lat)}
+	,
+	{"max_lat_cmd_id", item_size(max_lat_cmd_id),
+	 item_addr(max_lat_cmd_id)}
+	,
+	{"num_cmd_batch", item_size(num_cmd_batch), item_addr(num_cmd_batch)}
+	,
+	{"num_cmd_batched", item_size(num_cmd_batched),
+	 item_addr(num_cmd_batched)}
+	,
 	{"num_cmd_h2c_fail", item_size(num_cmd_host_to_card_failure),
 	 item_addr(num_cmd_host_to_card_failure)}
 	,
@@ -512,6 +540,10 @@ woal_debug_read(struct seq_file *sfp, void *data)
 #endif
 	seq_printf(sfp, "tcp_ack_drop_cnt=%d\n", priv->tcp_ack_drop_cnt);
 	seq_printf(sfp, "tcp_ack_cnt=%d\n", priv->tcp_ack_cnt);
+	seq_printf(sfp, "tcp_sess_num=%d\n", priv->tcp_sess_num);
+	seq_printf(sfp, "tcp_sess_evict=%d\n", priv->tcp_sess_evict);
+	seq_printf(sfp, "tcp_ack_hold_expire=%d\n", priv->tcp_ack_hold_expire);
+	seq_printf(sfp, "tcp_ack_hold_time=%d\n", priv->tcp_ack_hold_time);
 #if LINUX_VERSION_CODE > KERNEL_VERSION(2, 6, 29)
 	for (i = 0; i < 4; i++)
 		seq_printf(sfp, "wmm_tx_pending[%d]:%d\n", i,
@@ -2667,7 +2667,7 @@ done:
 int
 woal_priv_setgettcpackenh(moal_private * priv, t_u8 * respbuf, t_u32 respbuflen)
 {
-	t_u32 data[1];
+	t_u32 data[2];
 	int ret = 0;
 	int user_data_len = 0;
 
@@ -2685,12 +2685,18 @@ woal_priv_setgettcpackenh(moal_private * priv, t_u8 * respbuf, t_u32 respbuflen)
 				ARRAY_SIZE(data), &user_data_len);
 	}
 
-	if (user_data_len >= 2) {
+	if (user_data_len > 2) {
 		PRINTM(MERROR, "Too many arguments\n");
 		ret = -EINVAL;
 		goto done;
 	}
 
+	if (user_data_len == 2 && !data[1]) {
+		PRINTM(MERROR, "Invalid hold time = %u\n", data[1]);
+		ret = -EINVAL;
+		goto done;
+	}
+
 	if (user_data_len == 0) {
 		/* get operation */
 		respbuf[0] = priv->enable_tcp_ack_enh;
@@ -2709,9 +2715,12 @@ woal_priv_setgettcpackenh(moal_private * priv, t_u8 * respbuf, t_u32 respbuflen)
 			ret = -EINVAL;
 			goto done;
 		}
+		if (user_data_len == 2)
+			priv->tcp_ack_hold_time = data[1];
 		respbuf[0] = priv->enable_tcp_ack_enh;
 	}
-	ret = 1;
+	memcpy(respbuf + 1, &priv->tcp_ack_hold_time, sizeof(t_u32));
+	ret = 1 + sizeof(t_u32);
 
 done:
 	LEAVE();
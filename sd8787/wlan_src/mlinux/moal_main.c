@@ -156,6 +156,16 @@ int wq_sched_prio;
 int wq_sched_policy = SCHED_NORMAL;
 /** rx_work flag */
 int rx_work;
+#ifdef SDIO_MULTI_PORT_RX_AGGR
+/** MP-A Rx slice deaggregation */
+int mpa_rx_slice;
+#endif
+/** Multi-command transfers. No shipping firmware implements
+ *  HostCmd_CMD_MULTI_CMD, only mlansim does, so leave it off on real
+ *  hardware */
+int multi_cmd;
+/** TCP ACK hold time in milliseconds */
+int tcp_ack_hold = DEF_TCP_ACK_HOLD_TIME;
 
 int hw_test;
 
@@ -900,6 +910,11 @@ woal_init_sw(moal_handle * handle)
 #endif
 #endif
 
+#ifdef SDIO_MULTI_PORT_RX_AGGR
+	device.mpa_rx_slice_cfg = mpa_rx_slice;
+#endif
+	device.multi_cmd_cfg = multi_cmd;
+
 	if (rx_work == MLAN_INIT_PARA_ENABLED)
 		device.rx_work = MTRUE;
 	else if (rx_work == MLAN_INIT_PARA_DISABLED)
@@ -2100,8 +2115,7 @@ woal_add_interface(moal_handle * handle, t_u8 bss_index, t_u8 bss_type)
 		priv->bss_role = MLAN_BSS_ROLE_STA;
 #endif
 
-	INIT_LIST_HEAD(&priv->tcp_sess_queue);
-	spin_lock_init(&priv->tcp_sess_lock);
+	woal_init_tcp_sess_queue(priv);
 
 #if LINUX_VERSION_CODE < KERNEL_VERSION(2, 6, 24)
 	SET_MODULE_OWNER(dev);
@@ -2267,7 +2281,7 @@ woal_remove_interface(moal_handle * handle, t_u8 bss_index)
 		}
 #endif
 	}
-	woal_flush_tcp_sess_queue(priv);
+	woal_deinit_tcp_sess_queue(priv);
 
 #ifdef CONFIG_PROC_FS
 #ifdef PROC_DEBUG
@@ -2830,6 +2844,88 @@ woal_select_queue(struct net_device * dev, struct sk_buff * skb)
 }
 #endif
 
+/**
+ *  @brief This function releases a tcp session back to the pool
+ *
+ *  @param priv      A pointer to moal_private structure
+ *  @param tcp_sess  A pointer to the tcp session
+ *
+ *  @return          N/A
+ */
+static inline void
+woal_free_tcp_sess(moal_private * priv, struct tcp_sess *tcp_sess)
+{
+	list_del(&tcp_sess->hash_link);
+	list_move_tail(&tcp_sess->link, &priv->tcp_sess_free_q);
+	priv->tcp_sess_num--;
+}
+
+/**
+ *  @brief TCP ACK hold timer function. Sessions whose ACK has been
+ *  queued longer than the hold time stop absorbing newer ACKs, so the
+ *  next ACK of the flow is sent on its own.
+ *
+ *  @param context   A pointer to moal_private structure
+ *
+ *  @return          N/A
+ */
+static void
+woal_tcp_ack_timer_func(void *context)
+{
+	moal_private *priv = (moal_private *) context;
+	struct tcp_sess *tcp_sess = NULL, *tmp_node;
+	unsigned long hold = msecs_to_jiffies(priv->tcp_ack_hold_time);
+	unsigned long flags;
+
+	ENTER();
+
+	spin_lock_irqsave(&priv->tcp_sess_lock, flags);
+	list_for_each_entry_safe(tcp_sess, tmp_node, &priv->tcp_sess_queue,
+				 link) {
+		if (time_after_eq(jiffies, tcp_sess->start_time + hold)) {
+			woal_free_tcp_sess(priv, tcp_sess);
+			priv->tcp_ack_hold_expire++;
+		}
+	}
+	if (priv->tcp_sess_num)
+		woal_mod_timer(&priv->tcp_ack_timer, priv->tcp_ack_hold_time);
+	else
+		priv->is_tcp_ack_timer_set = MFALSE;
+	spin_unlock_irqrestore(&priv->tcp_sess_lock, flags);
+
+	LEAVE();
+}
+
+/**
+ *  @brief This function initializes the tcp session queue
+ *
+ *  @param priv      A pointer to moal_private structure
+ *
+ *  @return          N/A
+ */
+void
+woal_init_tcp_sess_queue(moal_private * priv)
+{
+	int i;
+
+	spin_lock_init(&priv->tcp_sess_lock);
+	INIT_LIST_HEAD(&priv->tcp_sess_queue);
+	INIT_LIST_HEAD(&priv->tcp_sess_free_q);
+	for (i = 0; i < TCP_SESS_HASH_SIZE; i++)
+		INIT_LIST_HEAD(&priv->tcp_sess_hash[i]);
+	for (i = 0; i < MAX_TCP_SESS; i++) {
+		INIT_LIST_HEAD(&priv->tcp_sess_pool[i].hash_link);
+		list_add_tail(&priv->tcp_sess_pool[i].link,
+			      &priv->tcp_sess_free_q);
+	}
+	priv->tcp_sess_num = 0;
+	priv->tcp_ack_hold_time =
+		(tcp_ack_hold > 0) ? tcp_ack_hold : DEF_TCP_ACK_HOLD_TIME;
+	woal_initialize_timer(&priv->tcp_ack_timer, woal_tcp_ack_timer_func,
+			      priv);
+	priv->is_tcp_ack_timer_set = MFALSE;
+}
+
 /**
  *  @brief This function flush tcp session queue
  *
@@ -2842,18 +2938,55 @@ woal_flush_tcp_sess_queue(moal_private * priv)
 {
 	struct tcp_sess *tcp_sess = NULL, *tmp_node;
 	unsigned long flags;
+
 	spin_lock_irqsave(&priv->tcp_sess_lock, flags);
 	list_for_each_entry_safe(tcp_sess, tmp_node, &priv->tcp_sess_queue,
 				 link) {
-		list_del(&tcp_sess->link);
-		kfree(tcp_sess);
+		woal_free_tcp_sess(priv, tcp_sess);
 	}
-	INIT_LIST_HEAD(&priv->tcp_sess_queue);
 	priv->tcp_ack_drop_cnt = 0;
 	priv->tcp_ack_cnt = 0;
+	priv->tcp_ack_hold_expire = 0;
+	priv->tcp_sess_evict = 0;
 	spin_unlock_irqrestore(&priv->tcp_sess_lock, flags);
 }
 
+/**
+ *  @brief This function flush tcp session queue and stops the hold
+ *  timer before the interface goes away
+ *
+ *  @param priv      A pointer to moal_private structure
+ *
+ *  @return          N/A
+ */
+void
+woal_deinit_tcp_sess_queue(moal_private * priv)
+{
+	woal_flush_tcp_sess_queue(priv);
+	woal_cancel_timer(&priv->tcp_ack_timer);
+	priv->is_tcp_ack_timer_set = MFALSE;
+}
+
+/**
+ *  @brief This function gets the hash bucket of a tcp session
+ *
+ *  @param priv      A pointer to moal_private structure
+ *  @param src_ip    IP address of the device
+ *  @param src_port  TCP port of the device
+ *  @param dst_ip    IP address of the client
+ *  @param dst_port  TCP port of the client
+ *
+ *  @return          A pointer to the hash bucket
+ */
+static inline struct list_head *
+woal_tcp_sess_bucket(moal_private * priv,
+		     t_u32 src_ip, t_u16 src_port, t_u32 dst_ip, t_u16 dst_port)
+{
+	t_u32 hash = jhash_3words(src_ip, dst_ip,
+				  ((t_u32) src_port << 16) | dst_port, 0);
+	return &priv->tcp_sess_hash[hash & (TCP_SESS_HASH_SIZE - 1)];
+}
+
 /**
  *  @brief This function gets tcp session from the tcp session queue
  *
@@ -2871,9 +3004,12 @@ woal_get_tcp_sess(moal_private * priv,
 		  t_u32 src_ip, t_u16 src_port, t_u32 dst_ip, t_u16 dst_port)
 {
 	struct tcp_sess *tcp_sess = NULL;
+	struct list_head *bucket;
 	ENTER();
 
-	list_for_each_entry(tcp_sess, &priv->tcp_sess_queue, link) {
+	bucket = woal_tcp_sess_bucket(priv, src_ip, src_port, dst_ip,
+				      dst_port);
+	list_for_each_entry(tcp_sess, bucket, hash_link) {
 		if ((tcp_sess->src_ip_addr == src_ip) &&
 		    (tcp_sess->src_tcp_port == src_port) &&
 		    (tcp_sess->dst_ip_addr == dst_ip) &&
@@ -2886,6 +3022,33 @@ woal_get_tcp_sess(moal_private * priv,
 	return NULL;
 }
 
+/**
+ *  @brief This function gets a tcp session from the pool, evicting the
+ *  least recently used one when the pool is empty
+ *
+ *  @param priv      A pointer to moal_private structure
+ *
+ *  @return          A pointer to the tcp session data structure
+ */
+static inline struct tcp_sess *
+woal_alloc_tcp_sess(moal_private * priv)
+{
+	struct tcp_sess *tcp_sess;
+
+	if (list_empty(&priv->tcp_sess_free_q)) {
+		/* The evicted ACK is still sent, it just stops absorbing */
+		tcp_sess = list_first_entry(&priv->tcp_sess_queue,
+					    struct tcp_sess, link);
+		woal_free_tcp_sess(priv, tcp_sess);
+		priv->tcp_sess_evict++;
+	}
+	tcp_sess = list_first_entry(&priv->tcp_sess_free_q, struct tcp_sess,
+				    link);
+	list_del(&tcp_sess->link);
+	priv->tcp_sess_num++;
+	return tcp_sess;
+}
+
 /**
  *  @brief This function free the tcp ack session node
  *
@@ -2897,18 +3060,21 @@ woal_get_tcp_sess(moal_private * priv,
 void
 woal_tcp_ack_tx_indication(moal_private * priv, mlan_buffer * pmbuf)
 {
-	struct tcp_sess *tcp_sess = NULL, *tmp = NULL;
+	struct sk_buff *skb = (struct sk_buff *)pmbuf->pdesc;
+	struct tcp_sess *tcp_sess = NULL;
+	struct iphdr *iph;
+	struct tcphdr *tcph;
 	unsigned long flags;
 	ENTER();
 
+	/* The skb still holds the Ethernet frame the session was found by */
+	iph = (struct iphdr *)(skb->data + sizeof(struct ethhdr));
+	tcph = (struct tcphdr *)((t_u8 *) iph + iph->ihl * 4);
 	spin_lock_irqsave(&priv->tcp_sess_lock, flags);
-	list_for_each_entry_safe(tcp_sess, tmp, &priv->tcp_sess_queue, link) {
-		if (tcp_sess->ack_skb == pmbuf->pdesc) {
-			list_del(&tcp_sess->link);
-			kfree(tcp_sess);
-			break;
-		}
-	}
+	tcp_sess = woal_get_tcp_sess(priv, iph->saddr, tcph->source,
+				     iph->daddr, tcph->dest);
+	if (tcp_sess && tcp_sess->ack_skb == skb)
+		woal_free_tcp_sess(priv, tcp_sess);
 	spin_unlock_irqrestore(&priv->tcp_sess_lock, flags);
 
 	LEAVE();
@@ -2964,21 +3130,26 @@ woal_process_tcp_ack(moal_private * priv, mlan_buffer * pmbuf)
 						tcph->source, iph->daddr,
 						tcph->dest);
 		if (!tcp_session) {
-			tcp_session =
-				kmalloc(sizeof(struct tcp_sess), GFP_ATOMIC);
-			if (!tcp_session) {
-				PRINTM(MERROR, "Fail to allocate tcp_sess.\n");
-				goto done;
-			}
+			tcp_session = woal_alloc_tcp_sess(priv);
 			tcp_session->ack_skb = pmbuf->pdesc;
 			tcp_session->src_ip_addr = iph->saddr;
 			tcp_session->dst_ip_addr = iph->daddr;
 			tcp_session->src_tcp_port = tcph->source;
 			tcp_session->dst_tcp_port = tcph->dest;
 			tcp_session->ack_seq = ntohl(tcph->ack_seq);
+			tcp_session->start_time = jiffies;
 			list_add_tail(&tcp_session->link,
 				      &priv->tcp_sess_queue);
+			list_add(&tcp_session->hash_link,
+				 woal_tcp_sess_bucket(priv, iph->saddr,
+						      tcph->source, iph->daddr,
+						      tcph->dest));
 			pmbuf->flags |= MLAN_BUF_FLAG_TCP_ACK;
+			if (!priv->is_tcp_ack_timer_set) {
+				woal_mod_timer(&priv->tcp_ack_timer,
+					       priv->tcp_ack_hold_time);
+				priv->is_tcp_ack_timer_set = MTRUE;
+			}
 			spin_unlock_irqrestore(&priv->tcp_sess_lock, flags);
 			LEAVE();
 			return ret;
@@ -2990,6 +3161,8 @@ woal_process_tcp_ack(moal_private * priv, mlan_buffer * pmbuf)
 			memcpy(skb->data, pmbuf->pbuf + pmbuf->data_offset,
 			       pmbuf->data_len);
 			tcp_session->ack_seq = ack_seq;
+			list_move_tail(&tcp_session->link,
+				       &priv->tcp_sess_queue);
 			ret = 1;
 			spin_unlock_irqrestore(&priv->tcp_sess_lock, flags);
 			skb = (struct sk_buff *)pmbuf->pdesc;
@@ -3001,7 +3174,6 @@ woal_process_tcp_ack(moal_private * priv, mlan_buffer * pmbuf)
 			return ret;
 		}
 	}
-done:
 	LEAVE();
 	return ret;
 }
@@ -5878,6 +6050,17 @@ MODULE_PARM_DESC(wq_sched_policy,
 module_param(rx_work, int, 0);
 MODULE_PARM_DESC(rx_work,
 		 "0: default; 1: Enable rx_work_queue; 2: Disable rx_work_queue");
+#ifdef SDIO_MULTI_PORT_RX_AGGR
+module_param(mpa_rx_slice, int, 0);
+MODULE_PARM_DESC(mpa_rx_slice,
+		 "0: default (copy); 1: Enable MP-A Rx slicing; 2: Disable MP-A Rx slicing (copy)");
+#endif
+module_param(multi_cmd, int, 0);
+MODULE_PARM_DESC(multi_cmd,
+		 "0: default (disabled); 1: Enable multi-command transfers if firmware advertises them, no shipping firmware does; 2: Disable");
+module_param(tcp_ack_hold, int, 0);
+MODULE_PARM_DESC(tcp_ack_hold,
+		 "Time in msec a queued TCP ACK may absorb newer ACKs (20)");
 MODULE_DESCRIPTION("M-WLAN Driver");
 MODULE_AUTHOR("Marvell International Ltd.");
 MODULE_VERSION(MLAN_RELEASE_VERSION);
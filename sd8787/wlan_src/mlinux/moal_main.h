@@ -86,6 +86,7 @@ Change log:
 #include        <net/arp.h>
 #include        <linux/rtnetlink.h>
 #include        <linux/inetdevice.h>
+#include        <linux/jhash.h>
 
 #include	<linux/firmware.h>
 
@@ -764,8 +765,18 @@ struct debug_data_priv {
 /** IP address operation: Remove */
 #define IPADDR_OP_REMOVE        0
 
+/** Number of TCP sessions tracked per interface */
+#define MAX_TCP_SESS            64
+/** Number of TCP session hash buckets, power of 2 */
+#define TCP_SESS_HASH_SIZE      64
+/** Default time a TCP ACK may absorb newer ACKs, in milliseconds */
+#define DEF_TCP_ACK_HOLD_TIME   20
+
 struct tcp_sess {
+    /** LRU list, or free list when unused */
 	struct list_head link;
+    /** Hash bucket list */
+	struct list_head hash_link;
     /** tcp session info */
 	t_u32 src_ip_addr;
 	t_u32 dst_ip_addr;
@@ -775,6 +786,8 @@ struct tcp_sess {
 	t_u32 ack_seq;
 	/** tcp ack buffer */
 	void *ack_skb;
+    /** jiffies when ack_skb was queued */
+	unsigned long start_time;
 };
 
 /** Private structure for MOAL */
@@ -799,6 +812,10 @@ struct _moal_private {
 	t_u32 tcp_ack_drop_cnt;
 	/** Statistics of tcp ack tx in total from kernel */
 	t_u32 tcp_ack_cnt;
+	/** Statistics of tcp sessions released by the hold timer */
+	t_u32 tcp_ack_hold_expire;
+	/** Statistics of tcp sessions evicted for a new one */
+	t_u32 tcp_sess_evict;
 #ifdef UAP_SUPPORT
 	/** uAP started or not */
 	BOOLEAN bss_started;
@@ -965,12 +982,26 @@ struct _moal_private {
 	struct debug_data_priv items_priv;
 #endif
 
-    /** tcp session queue */
+    /** tcp session queue, least recently used first */
 	struct list_head tcp_sess_queue;
+    /** tcp session hash table */
+	struct list_head tcp_sess_hash[TCP_SESS_HASH_SIZE];
+    /** free tcp sessions */
+	struct list_head tcp_sess_free_q;
+    /** tcp session pool */
+	struct tcp_sess tcp_sess_pool[MAX_TCP_SESS];
+    /** Number of tcp sessions in use */
+	t_u32 tcp_sess_num;
     /** TCP Ack enhance flag */
 	t_u8 enable_tcp_ack_enh;
     /** TCP session spin lock */
 	spinlock_t tcp_sess_lock;
+    /** Time a TCP ACK may absorb newer ACKs, in milliseconds */
+	t_u32 tcp_ack_hold_time;
+    /** TCP ACK hold timer */
+	moal_drv_timer tcp_ack_timer __ATTRIB_ALIGN__;
+    /** TCP ACK hold timer set flag */
+	t_u8 is_tcp_ack_timer_set;
 
 #if LINUX_VERSION_CODE > KERNEL_VERSION(2, 6, 29)
 	atomic_t wmm_tx_pending[4];
@@ -1883,7 +1914,9 @@ mlan_status woal_request_bgscan(moal_private * priv, t_u8 wait_option,
 				wlan_bgscan_cfg * scan_cfg);
 #endif
 
+void woal_init_tcp_sess_queue(moal_private * priv);
 void woal_flush_tcp_sess_queue(moal_private * priv);
+void woal_deinit_tcp_sess_queue(moal_private * priv);
 void wlan_scan_create_brief_table_entry(t_u8 ** ppbuffer,
 					BSSDescriptor_t * pbss_desc);
 int wlan_get_scan_table_ret_entry(BSSDescriptor_t * pbss_desc, t_u8 ** ppbuffer,
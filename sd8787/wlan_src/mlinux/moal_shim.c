@@ -828,6 +828,28 @@ moal_recv_packet(IN t_void * pmoal_handle, IN pmlan_buffer pmbuf)
 				pmbuf->pdesc = NULL;
 				pmbuf->pbuf = NULL;
 				pmbuf->data_offset = pmbuf->data_len = 0;
+			} else if ((pmbuf->flags & MLAN_BUF_FLAG_RX_SLICE) &&
+				   pmbuf->pslice_parent &&
+				   pmbuf->pslice_parent->pdesc) {
+				/* Share the MP-A aggregate skb data */
+				skb = skb_clone((struct sk_buff *)pmbuf->
+						pslice_parent->pdesc,
+						GFP_ATOMIC);
+				if (!skb) {
+					PRINTM(MERROR, "%s fail to clone skb\n",
+					       __FUNCTION__);
+					status = MLAN_STATUS_FAILURE;
+					priv->stats.rx_dropped++;
+					goto done;
+				}
+				skb_reserve(skb,
+					    pmbuf->pbuf + pmbuf->data_offset -
+					    skb->data);
+				skb_put(skb, pmbuf->data_len);
+				/* A clone is charged the whole aggregate,
+				   charge the slice for its share only */
+				skb->truesize = SKB_DATA_ALIGN(pmbuf->data_len)
+					+ sizeof(struct sk_buff);
 			} else {
 				PRINTM(MERROR, "%s without skb attach!!!\n",
 				       __FUNCTION__);
@@ -793,8 +793,7 @@ woal_alloc_virt_interface(moal_handle * handle, t_u8 bss_index, t_u8 bss_type,
 	priv->bss_type = bss_type;
 	priv->bss_role = MLAN_BSS_ROLE_STA;
 
-	INIT_LIST_HEAD(&priv->tcp_sess_queue);
-	spin_lock_init(&priv->tcp_sess_lock);
+	woal_init_tcp_sess_queue(priv);
 
 #if LINUX_VERSION_CODE < KERNEL_VERSION(2, 6, 24)
 	SET_MODULE_OWNER(dev);
@@ -1040,6 +1039,7 @@ woal_cfg80211_del_virt_if(struct wiphy *wiphy, struct net_device *dev)
 		woal_clear_all_mgmt_ies(vir_priv);
 		woal_cfg80211_deinit_p2p(vir_priv);
 		woal_bss_remove(vir_priv);
+		woal_deinit_tcp_sess_queue(vir_priv);
 #ifdef CONFIG_PROC_FS
 #ifdef PROC_DEBUG
 		/* Remove proc debug */
@@ -1085,6 +1085,7 @@ woal_remove_virtual_interface(moal_handle * handle)
 				PRINTM(MCMND, "Remove virtual interface %s\n",
 				       priv->netdev->name);
 				netif_device_detach(priv->netdev);
+				woal_deinit_tcp_sess_queue(priv);
 				if (priv->netdev->reg_state ==
 				    NETREG_REGISTERED)
 					unregister_netdevice(priv->netdev);
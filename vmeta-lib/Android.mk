@@ -29,7 +29,10 @@ LOCAL_CFLAGS += -DNEW_POWEROPT_SOLUTION
 endif
 
 LOCAL_SRC_FILES := \
-	vmeta_lib.c
+	vmeta_lib.c \
+	vmeta_log.c \
+	vmeta_lock.c \
+	vmeta_watch.c
 
 LOCAL_PRELINK_MODULE := false
 
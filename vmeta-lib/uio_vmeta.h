@@ -25,6 +25,24 @@ typedef enum _VMETA_LOCK_FLAG{
 	VMETA_LOCK_FORCE_INIT
 }VMETA_LOCK_FLAG;
 
+#define VMETA_LOCK_QUEUE_SIZE	64	/* tickets waiting at once, power of 2 */
+#define VMETA_LOCK_SLICE_MS	100	/* hold time before yielding to waiters */
+
+typedef enum _VMETA_TICKET_STATE{
+	VMETA_TICKET_WAIT = 0,
+	VMETA_TICKET_GRANTED,
+	VMETA_TICKET_CANCELED
+}VMETA_TICKET_STATE;
+
+/* A ticket of the lock queue, kept in slot ticket % VMETA_LOCK_QUEUE_SIZE */
+typedef struct _lock_ticket
+{
+	volatile unsigned int	ticket;
+	volatile int			state;
+	int						user_id;
+	pid_t					pid;
+}lock_ticket;
+
 /* This struct should be aligned with user space API */
 typedef struct _kernel_share
 {
@@ -33,6 +51,11 @@ typedef struct _kernel_share
 	int active_user_id;
 	struct timeval lock_start_tv;
 	id_instance user_id_list[MAX_VMETA_INSTANCE];
+	/* ticket lock, maintained by user space only */
+	volatile unsigned int lock_next_ticket;
+	volatile unsigned int lock_serving;
+	volatile unsigned int lock_start_ms;
+	lock_ticket lock_queue[VMETA_LOCK_QUEUE_SIZE];
 }kernel_share;
 
 #define IOP_MAGIC	'v'
@@ -133,6 +133,7 @@ void vdec_os_api_vfree(void *ptr);
 UNSG32 vdec_os_api_get_va(UNSG32 paddr);
 UNSG32 vdec_os_api_get_pa(UNSG32 vaddr);
 UNSG32 vdec_os_api_flush_cache(UNSG32 vaddr, UNSG32 size, enum dma_data_direction direction);
+void vdec_os_api_mark_dirty(UNSG32 vaddr, UNSG32 size);		// CPU wrote [vaddr, vaddr+size), the next DMA_TO_DEVICE flush only cleans marked bytes
 
 //---------------------------------------------------------------------------
 // Mem/IO R/W API
@@ -47,6 +47,7 @@
 #define LOGI(...)
 #define LOGW(...)
 #define LOGE(...)
+#define ALOGD(...)
 #endif
 
 #ifdef NEW_POWEROPT_SOLUTION
@@ -62,7 +63,18 @@
 
 // these APIs are used for vmeta driver only, not for export purpose.
 #define VMETA_PRIVATE_LOCK_HANDLE "vmeta_private_lock"
-#define NEED_MONITOR 0
+/*
+ * The last clean keeps the uio fd and mappings for the next init, so a
+ * player that seeks through short clips does not reopen and remap uio0 for
+ * each of them. Nothing the kernel tracks hangs on the fd once clean is
+ * done: clock and power are already off, the user ids and the lock live
+ * in the kernel share page and the watcher is stopped.
+ * vdec_os_driver_set_uio() drops the kept mappings, 0 never keeps them.
+ */
+#ifndef VMETA_KEEP_MAPPINGS
+#define VMETA_KEEP_MAPPINGS 1
+#endif
+#define VMETA_WATCH_FLAGS 0	// VMETA_WATCH_THREADS to reclaim users of exited threads
 
 static SIGN32 vmeta_private_lock();
 static SIGN32 vmeta_private_unlock();
@@ -70,9 +82,26 @@ static SIGN32 vdec_os_api_get_ks(kernel_share **pp_ks);	//get kernel shared reso
 
 // global variable
 vdec_os_driver_cb_t *vdec_iface = NULL;
-UNSG32 globalDbgLevel = VDEC_DEBUG_NONE;
+UNSG32 globalDbgLevel = VDEC_DEBUG_NONE;	// set directly or with vmeta_log_set_level()
 UNSG32 syncTimeout = 500;
 pthread_mutex_t pmt = PTHREAD_MUTEX_INITIALIZER;
+static vdec_os_driver_cb_t *vdec_iface_idle = NULL;	// unused, still mapped
+static int vdec_obj_kept = 0;	// vdec_obj_va was mapped for an earlier instance
+
+// uio topology, read from sysfs once per process
+typedef struct {
+	UNSG32 addr;
+	UNSG32 size;
+} uio_map_info;
+
+static struct {
+	int valid;
+	int kern_ver;
+	uio_map_info map[UIO_IO_MAP_NUM];
+} uio_topo;
+
+static char uio_dev_path[128] = UIO_DEV;
+static char uio_sysfs_path[128] = UIO_SYSFS_DIR;
 
 #define INVALID_SOCKET_NO (-1)
 #define SOCKET_RETRY_TIMES 5
@@ -86,26 +115,19 @@ static inline int get_bit(int nr, unsigned int *addr)
 	return ((*addr) & mask) != 0;
 }
 
+// atomic, the share page status is also cleared by vmeta_watch of other processes
 static inline int set_bit(int nr, unsigned int *addr)
 {
 	unsigned int mask = 1 << nr;
-	unsigned int old;
-
-	old = *addr;
-	*addr = old | mask;
 
-	return (old & mask) != 0;
+	return (__sync_fetch_and_or(addr, mask) & mask) != 0;
 }
 
 static inline int clear_bit(int nr, unsigned int *addr)
 {
 	unsigned int mask = 1 << nr;
-	unsigned int old;
 
-	old = *addr;
-	*addr = old & ~mask;
-
-	return (old & mask) != 0;
+	return (__sync_fetch_and_and(addr, ~mask) & mask) != 0;
 }
 
 //Add for hal mmap
@@ -283,11 +305,11 @@ void *vdec_os_api_dma_alloc_writecombine(UNSG32 size, UNSG32 align,
 		return NULL;
 
 	dbg_printf(VDEC_DEBUG_MEM,
-		   "vdec_os_api_dma_alloc_cached -> size: 0x%x\n", size);
+		   "vdec_os_api_dma_alloc_writecombine -> size: 0x%x\n", size);
 
 	align = ALIGN(align, PAGE_SIZE);
 	size = ALIGN(size, align);
-	ptr = phy_cont_malloc(size, PHY_CONT_MEM_ATTR_DEFAULT);
+	ptr = phy_cont_malloc(size, PHY_CONT_MEM_ATTR_WC);
 	if (!ptr) {
 		dbg_printf(VDEC_DEBUG_MEM, "\tno enough memory\n");
 		return NULL;
@@ -331,6 +353,17 @@ UNSG32 vdec_os_api_flush_cache(UNSG32 vaddr, UNSG32 size,
 	return 0;
 }
 
+/*
+ * A writer that fills part of a cached stream buffer marks what it wrote,
+ * so the whole-buffer DMA_TO_DEVICE flush the codec does before decoding
+ * cleans only those bytes. Harmless on uncached buffers.
+ */
+void vdec_os_api_mark_dirty(UNSG32 vaddr, UNSG32 size)
+{
+	if (0 < size)
+		phy_cont_mark_dirty((void *)vaddr, size);
+}
+
 // enable vmeta interrupt
 void vdec_os_api_irq_enable(void)
 {
@@ -370,16 +403,114 @@ SIGN32 vdec_os_api_sync_event()
 //End of mem mmap
 #define VMETA_VERSION_PREFIX "build-"
 
+static int uio_read(int dirfd, const char *name, char *buf, int size)
+{
+	int fd, n;
+
+	fd = openat(dirfd, name, O_RDONLY);
+	if (fd < 0)
+		return -1;
+	n = read(fd, buf, size - 1);
+	close(fd);
+	if (n <= 0)
+		return -1;
+	buf[n] = '\0';
+	return 0;
+}
+
+/*
+ * Read the version and the address and size of every map in one pass over
+ * the uio sysfs directory. Called with pmt held; the result is kept for
+ * the life of the process once it is usable.
+ */
+static SIGN32 uio_topo_load(void)
+{
+	char name[32], buf[32];
+	int dirfd, i;
+
+	if (uio_topo.valid)
+		return VDEC_OS_DRIVER_OK;
+
+	dirfd = open(uio_sysfs_path, O_RDONLY | O_DIRECTORY);
+	if (dirfd < 0) {
+		dbg_printf(VDEC_DEBUG_ALL, "Error: uio_topo_load -> open %s failed\n",
+			   uio_sysfs_path);
+		return -VDEC_OS_DRIVER_OPEN_FAIL;
+	}
+
+	memset(&uio_topo, 0, sizeof(uio_topo));
+	if (uio_read(dirfd, "version", buf, sizeof(buf)) != 0 ||
+	    sscanf(buf, VMETA_VERSION_PREFIX "%d", &uio_topo.kern_ver) != 1)
+		uio_topo.kern_ver = -1;
+	for (i = 0; i < UIO_IO_MAP_NUM; i++) {
+		snprintf(name, sizeof(name), "maps/map%d/addr", i);
+		if (uio_read(dirfd, name, buf, sizeof(buf)) == 0)
+			uio_topo.map[i].addr = strtoul(buf, NULL, 16);
+		snprintf(name, sizeof(name), "maps/map%d/size", i);
+		if (uio_read(dirfd, name, buf, sizeof(buf)) == 0)
+			uio_topo.map[i].size = strtoul(buf, NULL, 16);
+	}
+	close(dirfd);
+
+	if (uio_topo.kern_ver < VMETA_KERN_MIN_VER)
+		return -VDEC_OS_DRIVER_VER_FAIL;
+	if (uio_topo.map[UIO_IO_MEM_INDEX].size == 0 ||
+	    uio_topo.map[UIO_IO_MEM_INDEX].addr == 0)
+		return -VDEC_OS_DRIVER_MMAP_FAIL;
+	uio_topo.valid = 1;
+	return VDEC_OS_DRIVER_OK;
+}
+
+/*
+ * Find the value of one of the uio sysfs files in the topology. Returns 0
+ * if msg is not one of them or the topology cannot be read.
+ */
+static int uio_topo_find(const char *msg, UNSG32 *val)
+{
+	char path[160];
+	int i, found = 0;
+
+	pthread_mutex_lock(&pmt);
+	if (uio_topo_load() == VDEC_OS_DRIVER_OK) {
+		snprintf(path, sizeof(path), "%s/version", uio_sysfs_path);
+		if (strcmp(msg, path) == 0) {
+			*val = uio_topo.kern_ver;
+			found = 1;
+		}
+		for (i = 0; !found && i < UIO_IO_MAP_NUM; i++) {
+			snprintf(path, sizeof(path), "%s/maps/map%d/addr",
+				 uio_sysfs_path, i);
+			if (strcmp(msg, path) == 0) {
+				*val = uio_topo.map[i].addr;
+				found = 1;
+			}
+			snprintf(path, sizeof(path), "%s/maps/map%d/size",
+				 uio_sysfs_path, i);
+			if (strcmp(msg, path) == 0) {
+				*val = uio_topo.map[i].size;
+				found = 1;
+			}
+		}
+	}
+	pthread_mutex_unlock(&pmt);
+	return found;
+}
+
+/* the uio sysfs files come from the cached topology, any other file is read */
 int get_version(char *msg)
 {
 	int ret;
 	int version;
+	UNSG32 val;
+	FILE *file;
 
-	FILE *file = fopen(msg, "r");
+	if (uio_topo_find(msg, &val))
+		return (int)val;
 
+	file = fopen(msg, "r");
 	if (!file) {
 		dbg_printf(VDEC_DEBUG_ALL,
-			   "Error: get_mem_size -> fopen failed\n");
+			   "Error: get_version -> fopen failed\n");
 		return -1;
 	}
 
@@ -394,22 +525,26 @@ int get_version(char *msg)
 	return version;
 }
 
-UNSG32 get_mem_size(char *msg)
+static UNSG32 get_mem_value(char *msg, const char *what)
 {
 	int ret;
 	UNSG32 result;
-	FILE *file = fopen(msg, "r");
+	FILE *file;
+
+	if (uio_topo_find(msg, &result))
+		return result;
 
+	file = fopen(msg, "r");
 	if (!file) {
 		dbg_printf(VDEC_DEBUG_ALL,
-			   "Error: get_mem_size -> fopen failed\n");
+			   "Error: %s -> fopen failed\n", what);
 		return -VDEC_OS_DRIVER_OPEN_FAIL;
 	}
 
 	ret = fscanf(file, "0x%x", &result);
 	if (ret < 0) {
 		dbg_printf(VDEC_DEBUG_ALL,
-			   "Error: get_mem_size -> fscanf failed\n");
+			   "Error: %s -> fscanf failed\n", what);
 		result = 0;
 	}
 
@@ -417,27 +552,69 @@ UNSG32 get_mem_size(char *msg)
 	return result;
 }
 
+UNSG32 get_mem_size(char *msg)
+{
+	return get_mem_value(msg, "get_mem_size");
+}
+
 UNSG32 get_mem_addr(char *msg)
 {
-	UNSG32 result;
-	int ret;
-	FILE *file = fopen(msg, "r");
+	return get_mem_value(msg, "get_mem_addr");
+}
 
-	if (!file) {
-		dbg_printf(VDEC_DEBUG_ALL,
-			   "Error: get_mem_addr -> fopen failed\n");
-		return -VDEC_OS_DRIVER_OPEN_FAIL;
+static void vdec_iface_release(vdec_os_driver_cb_t *p_cb)
+{
+	// unmap memory area
+	if (p_cb->io_mem_virt_addr > 0) {
+		dbg_printf(VDEC_DEBUG_MEM,
+			   "munmap with io_mem_virt_addr = 0x%x\n",
+			   p_cb->io_mem_virt_addr);
+		munmap((void *)p_cb->io_mem_virt_addr, p_cb->io_mem_size);
+		p_cb->io_mem_virt_addr = p_cb->io_mem_size = 0;
 	}
 
-	ret = fscanf(file, "0x%x", &result);
-	if (ret < 0) {
-		dbg_printf(VDEC_DEBUG_ALL,
-			   "Error: get_mem_addr -> fscanf failed\n");
-		result = 0;
+	if (p_cb->kernel_share_va > 0) {
+		dbg_printf(VDEC_DEBUG_MEM,
+			   "munmap with kernel_share_va = 0x%x size=%d\n",
+			   p_cb->kernel_share_va, p_cb->kernel_share_size);
+		munmap((void *)p_cb->kernel_share_va, p_cb->kernel_share_size);
+		p_cb->kernel_share_va = p_cb->kernel_share_size = 0;
 	}
 
-	fclose(file);
-	return result;
+	if (p_cb->vdec_obj_va > 0) {
+		dbg_printf(VDEC_DEBUG_MEM,
+			   "munmap with vdec_obj_va = 0x%x size=%d\n",
+			   p_cb->vdec_obj_va, p_cb->vdec_obj_size);
+		munmap((void *)p_cb->vdec_obj_va, p_cb->vdec_obj_size);
+		p_cb->vdec_obj_va = p_cb->vdec_obj_size = 0;
+	}
+	// close fd
+	if (p_cb->uiofd > 0) {
+		close(p_cb->uiofd);
+		dbg_printf(VDEC_DEBUG_ALL, "uio close\n");
+	}
+
+	free((void *)p_cb);
+	dbg_printf(VDEC_DEBUG_ALL, "free vdec_iface\n");
+}
+
+SIGN32 vdec_os_driver_set_uio(const char *dev, const char *sysfs_dir)
+{
+	pthread_mutex_lock(&pmt);
+	if (vdec_iface != NULL) {
+		pthread_mutex_unlock(&pmt);
+		return -VDEC_OS_DRIVER_ALREADY_INIT_FAIL;
+	}
+	if (vdec_iface_idle != NULL) {
+		vdec_iface_release(vdec_iface_idle);
+		vdec_iface_idle = NULL;
+	}
+	snprintf(uio_dev_path, sizeof(uio_dev_path), "%s", dev ? dev : UIO_DEV);
+	snprintf(uio_sysfs_path, sizeof(uio_sysfs_path), "%s",
+		 sysfs_dir ? sysfs_dir : UIO_SYSFS_DIR);
+	uio_topo.valid = 0;
+	pthread_mutex_unlock(&pmt);
+	return VDEC_OS_DRIVER_OK;
 }
 
 // init vdec os driver
@@ -457,6 +634,17 @@ SIGN32 vdec_os_driver_init(void)
 		pthread_mutex_unlock(&pmt);
 		return ret;
 	}
+	if (vdec_iface_idle != NULL) {	// mapped by an earlier instance
+		vdec_iface = vdec_iface_idle;
+		vdec_iface_idle = NULL;
+		vdec_iface->refcount = 1;
+		vdec_obj_kept = vdec_iface->vdec_obj_va > 0;
+		vdec_iface->curr_op = VMETA_OP_INVALID;
+		dbg_printf(VDEC_DEBUG_ALL, "vdec os driver reuses uiofd=%d\n",
+			   vdec_iface->uiofd);
+		pthread_mutex_unlock(&pmt);
+		return ret;
+	}
 	/*set all the vmeta_socket[] to INVALID_SOCKET_NO*/
 	for(i= 0; i < MAX_VMETA_INSTANCE; i++) {
 		if(0 == vmeta_socket[i])
@@ -485,40 +673,29 @@ SIGN32 vdec_os_driver_init(void)
 	// initialize reference count
 	vdec_iface->refcount++;
 
+	ret = uio_topo_load();
+	if (ret != VDEC_OS_DRIVER_OK)
+		goto err_open_fail;
+
 	// Open the vdec uio driver
-	vdec_iface->uiofd = open(UIO_DEV, O_RDWR);
+	vdec_iface->uiofd = open(uio_dev_path, O_RDWR);
 	if (vdec_iface->uiofd < 0) {
 		ret = -VDEC_OS_DRIVER_OPEN_FAIL;
 		goto err_open_fail;
 	}
 	dbg_printf(VDEC_DEBUG_ALL, "vdec os driver open: %s uiofd=%d\n",
-		   UIO_DEV, vdec_iface->uiofd);
+		   uio_dev_path, vdec_iface->uiofd);
 
-	vdec_iface->kern_ver = get_version(UIO_IO_VERSION);
-	if (vdec_iface->kern_ver < VMETA_KERN_MIN_VER) {
-		ret = -VDEC_OS_DRIVER_VER_FAIL;
-		goto err_open_fail;
-	}
+	vdec_iface->kern_ver = uio_topo.kern_ver;
 	dbg_printf(VDEC_DEBUG_VER, "vdec os driver kern=%d user=%s\n",
 		   vdec_iface->kern_ver, VMETA_USER_VER);
 
-	// Get the IO mem size of vPro's register
-	vdec_iface->io_mem_size = get_mem_size(UIO_IO_MEM_SIZE);
-	if (vdec_iface->io_mem_size <= 0) {
-		ret = -VDEC_OS_DRIVER_MMAP_FAIL;
-		goto err_mmap_fail;
-	}
-	dbg_printf(VDEC_DEBUG_MEM, "vdec os driver io mem size: 0x%x\n",
-		   vdec_iface->io_mem_size);
-
-	// Get the IO mem phy addr
-	vdec_iface->io_mem_phy_addr = get_mem_addr(UIO_IO_MEM_ADDR);
-	if (vdec_iface->io_mem_phy_addr <= 0) {
-		ret = -VDEC_OS_DRIVER_MMAP_FAIL;
-		goto err_mmap_fail;
-	}
-	dbg_printf(VDEC_DEBUG_MEM, "vdec os driver io mem phy addr: 0x%x\n",
-		   vdec_iface->io_mem_phy_addr);
+	// the IO mem size and phy addr of vPro's register
+	vdec_iface->io_mem_size = uio_topo.map[UIO_IO_MEM_INDEX].size;
+	vdec_iface->io_mem_phy_addr = uio_topo.map[UIO_IO_MEM_INDEX].addr;
+	dbg_printf(VDEC_DEBUG_MEM,
+		   "vdec os driver io mem size: 0x%x phy addr: 0x%x\n",
+		   vdec_iface->io_mem_size, vdec_iface->io_mem_phy_addr);
 
 	// mmap the io mem area
 	vdec_iface->io_mem_virt_addr =
@@ -575,98 +752,19 @@ SIGN32 vdec_os_driver_clean(void)
 		dbg_printf(VDEC_DEBUG_ALL,
 			   "close vmeta power and clock in case app doesn't close\n");
 	}
-	// unmap memory area
-	if (vdec_iface->io_mem_virt_addr > 0) {
-		dbg_printf(VDEC_DEBUG_MEM,
-			   "munmap with io_mem_virt_addr = 0x%x\n",
-			   vdec_iface->io_mem_virt_addr);
-		munmap((void *)vdec_iface->io_mem_virt_addr,
-		       vdec_iface->io_mem_size);
-		vdec_iface->io_mem_virt_addr = vdec_iface->io_mem_size = 0;
-	}
-
-	if (vdec_iface->kernel_share_va > 0) {
-		dbg_printf(VDEC_DEBUG_MEM,
-			   "munmap with kernel_share_va = 0x%x size=%d\n",
-			   vdec_iface->kernel_share_va,
-			   vdec_iface->kernel_share_size);
-		munmap((void *)vdec_iface->kernel_share_va,
-		       vdec_iface->kernel_share_size);
-		vdec_iface->kernel_share_va = vdec_iface->kernel_share_size = 0;
-	}
-
-	if (vdec_iface->vdec_obj_va > 0) {
-		dbg_printf(VDEC_DEBUG_MEM,
-			   "munmap with vdec_obj_va = 0x%x size=%d\n",
-			   vdec_iface->vdec_obj_va, vdec_iface->vdec_obj_size);
-		munmap((void *)vdec_iface->vdec_obj_va,
-		       vdec_iface->vdec_obj_size);
-		vdec_iface->vdec_obj_va = vdec_iface->vdec_obj_size = 0;
-	}
-	// close fd
-	if (vdec_iface->uiofd > 0) {
-		close(vdec_iface->uiofd);
-		dbg_printf(VDEC_DEBUG_ALL, "uio close\n");
-	}
-	// free vdec_iface
-	if (vdec_iface != NULL) {
-		free((void *)vdec_iface);
-		dbg_printf(VDEC_DEBUG_ALL, "free vdec_iface\n");
-		vdec_iface = NULL;
-	}
-
-	dbg_printf(VDEC_DEBUG_ALL, "vmeta clean done\n");
-	pthread_mutex_unlock(&pmt);
-	return 0;
-}
-
-/* display debug message */
-int dbg_printf(UNSG32 dbglevel, const char *format, ...)
-{
-	char dbgBuf[256] = { '\0' };
-	va_list var;
-#if VMETA_LOG_ON
-	FILE *fp_log = fopen(VMETA_LOG_FILE, "a+");
-	if (fp_log == NULL) {
-		return -1;
-	}
-#endif
+	// stopped before the share page can be unmapped
+	vmeta_watch_stop();
 
-	if (VDEC_DEBUG_NONE == globalDbgLevel)
-		goto DBG_EXIT;
-	else {
-		va_start(var, format);
-		vsprintf(dbgBuf, format, var);
-		va_end(var);
-
-		if (VDEC_DEBUG_ALL & globalDbgLevel)
-			goto DBG_PRINT;
-		else if ((VDEC_DEBUG_MEM & globalDbgLevel)
-			 && (dbglevel == VDEC_DEBUG_MEM))
-			goto DBG_PRINT;
-		else if ((VDEC_DEBUG_LOCK & globalDbgLevel)
-			 && (dbglevel == VDEC_DEBUG_LOCK))
-			goto DBG_PRINT;
-		else if ((VDEC_DEBUG_VER & globalDbgLevel)
-			 && (dbglevel == VDEC_DEBUG_VER))
-			goto DBG_PRINT;
-		else if ((VDEC_DEBUG_POWER & globalDbgLevel)
-			 && (dbglevel == VDEC_DEBUG_POWER))
-			goto DBG_PRINT;
-		else
-			goto DBG_EXIT;
-	}
-DBG_PRINT:
-#if VMETA_LOG_ON
-	fprintf(fp_log, "%s", dbgBuf);
+#if VMETA_KEEP_MAPPINGS
+	// the next instance, often right behind, skips the open and mmaps
+	vdec_iface_idle = vdec_iface;
 #else
-	printf("%s", dbgBuf);
+	vdec_iface_release(vdec_iface);
 #endif
+	vdec_iface = NULL;
 
-DBG_EXIT:
-#if VMETA_LOG_ON
-	fclose(fp_log);
-#endif
+	dbg_printf(VDEC_DEBUG_ALL, "vmeta clean done\n");
+	pthread_mutex_unlock(&pmt);
 	return 0;
 }
 
@@ -683,21 +781,30 @@ SIGN32 vdec_os_api_get_hw_obj_addr(UNSG32 *vaddr, UNSG32 size)
 	UNSG32 ret = VDEC_OS_DRIVER_OK;
 
 	if (vdec_iface->vdec_obj_va > 0) {
-		dbg_printf(VDEC_DEBUG_MEM, "Already get vdec obj\n");
-		*vaddr = vdec_iface->vdec_obj_va;
-		return VDEC_OS_DRIVER_OK;
+		// this instance may already use it, only a kept one can move
+		if (!vdec_obj_kept || vdec_iface->vdec_obj_size >= size) {
+			dbg_printf(VDEC_DEBUG_MEM, "Already get vdec obj\n");
+			vdec_obj_kept = 0;
+			*vaddr = vdec_iface->vdec_obj_va;
+			return VDEC_OS_DRIVER_OK;
+		}
+		// kept from an instance that needed less
+		munmap((void *)vdec_iface->vdec_obj_va,
+		       vdec_iface->vdec_obj_size);
+		vdec_iface->vdec_obj_va = vdec_iface->vdec_obj_size = 0;
+		vdec_obj_kept = 0;
 	}
 
-	io_mem_size = get_mem_size(UIO_IO_VMETA_OBJ_SIZE);
+	io_mem_size = uio_topo.map[UIO_IO_VMETA_OBJ_INDEX].size;
 	if (io_mem_size <= 0 || io_mem_size < size) {
 		ret = -VDEC_OS_DRIVER_MMAP_FAIL;
 		dbg_printf(VDEC_DEBUG_MEM,
-			   "vdec_os_api_get_hw_obj_addr error: get_mem_size io_mem_size=%d, requested size=%d!!!\n",
+			   "vdec_os_api_get_hw_obj_addr error: map size=%d, requested size=%d!!!\n",
 			   io_mem_size, size);
 		goto get_vdec_obj_fail;
 	}
 	dbg_printf(VDEC_DEBUG_MEM,
-		   "vdec_os_api_get_hw_obj_addr: get_mem_size io_mem_size=%d, requested size=%d\n",
+		   "vdec_os_api_get_hw_obj_addr: map size=%d, requested size=%d\n",
 		   io_mem_size, size);
 
 	io_mem_virt_addr = (SIGN32) mmap(NULL, size,
@@ -738,23 +845,23 @@ SIGN32 vdec_os_api_get_hw_context_addr(UNSG32 *paddr, UNSG32 *vaddr,
 		return VDEC_OS_DRIVER_OK;
 	}
 
-	io_mem_size = get_mem_size(UIO_IO_HW_CONTEXT_SIZE);
+	io_mem_size = uio_topo.map[UIO_IO_HW_CONTEXT_INDEX].size;
 	if (io_mem_size <= 0 || io_mem_size < size) {
 		ret = -VDEC_OS_DRIVER_MMAP_FAIL;
 		dbg_printf(VDEC_DEBUG_MEM,
-			   "vdec_os_api_get_hw_context_addr error: get_mem_size io_mem_size=%d, requested size=%d!!!\n",
+			   "vdec_os_api_get_hw_context_addr error: map size=%d, requested size=%d!!!\n",
 			   io_mem_size, size);
 		goto get_hw_context_fail;
 	}
 	dbg_printf(VDEC_DEBUG_MEM,
-		   "vdec_os_api_get_hw_context_addr: get_mem_size io_mem_size=%d, requested size=%d\n",
+		   "vdec_os_api_get_hw_context_addr: map size=%d, requested size=%d\n",
 		   io_mem_size, size);
 
-	io_mem_addr = get_mem_addr(UIO_IO_HW_CONTEXT_ADDR);
+	io_mem_addr = uio_topo.map[UIO_IO_HW_CONTEXT_INDEX].addr;
 	if (io_mem_addr <= 0) {
 		ret = -VDEC_OS_DRIVER_MMAP_FAIL;
 		dbg_printf(VDEC_DEBUG_MEM,
-			   "vdec_os_api_get_hw_context_addr: get_mem_addr error\n");
+			   "vdec_os_api_get_hw_context_addr: no map addr\n");
 		goto get_hw_context_fail;
 	}
 
@@ -780,15 +887,22 @@ SIGN32 vdec_os_api_get_ks(kernel_share **pp_ks)
 		return 0;
 	}
 
-	io_mem_size = get_mem_size(UIO_IO_KERNEL_SHARE_SIZE);
+	io_mem_size = uio_topo.map[UIO_IO_KERNEL_SHARE_INDEX].size;
 	if (io_mem_size <= 0) {
 		ret = -VDEC_OS_DRIVER_MMAP_FAIL;
 		dbg_printf(VDEC_DEBUG_MEM,
-			   "vdec_os_api_get_ks: get_mem_size error\n");
+			   "vdec_os_api_get_ks: no map size\n");
+		goto get_vos_fail;
+	}
+	if (io_mem_size < sizeof(kernel_share)) {
+		ret = -VDEC_OS_DRIVER_MMAP_FAIL;
+		dbg_printf(VDEC_DEBUG_MEM,
+			   "vdec_os_api_get_ks: kernel share %d smaller than %d\n",
+			   io_mem_size, sizeof(kernel_share));
 		goto get_vos_fail;
 	}
 	dbg_printf(VDEC_DEBUG_MEM,
-		   "vdec_os_api_get_ks: get_mem_size io_mem_size=%d\n",
+		   "vdec_os_api_get_ks: map size=%d\n",
 		   io_mem_size);
 
 	io_mem_virt_addr = (SIGN32) mmap(NULL, io_mem_size,
@@ -873,6 +987,9 @@ SIGN32 vdec_os_api_get_user_id(void)
 	if (ret < 0) {
 		dbg_printf(VDEC_DEBUG_ALL,
 			   "vdec_os_api_get_user_id: find_user_id error\n");
+	} else {
+		// owned by this process until registered by one of its threads
+		p_ks->user_id_list[ret].pid = getpid();
 	}
 	vmeta_private_unlock();
 
@@ -898,8 +1015,10 @@ SIGN32 vdec_os_api_free_user_id(SIGN32 user_id)
 	}
 	p_ks = (kernel_share *) p_cb->kernel_share_va;
 
+	vmeta_watch_remove(user_id);
 	vmeta_private_lock();
 
+	p_ks->user_id_list[user_id].pid = 0;
 	clear_bit(VMETA_STATUS_BIT_REGISTED,
 		  &(p_ks->user_id_list[user_id].status));
 	clear_bit(VMETA_STATUS_BIT_USED, &(p_ks->user_id_list[user_id].status));
@@ -909,122 +1028,40 @@ SIGN32 vdec_os_api_free_user_id(SIGN32 user_id)
 	return VDEC_OS_DRIVER_OK;
 }
 
-#if NEED_MONITOR
-void *vmeta_thread_monitor(void *pmd)
+/*
+ * Called by the watcher for a user whose process is gone, or, with
+ * VMETA_WATCH_THREADS, whose registering thread is gone. The lock it may
+ * hold is given back and the next locker gets LOCK_RET_FORCE_INIT, as the
+ * hardware state is unknown.
+ */
+static void vmeta_reclaim_user(kernel_share *p_ks, SIGN32 user_id, pid_t pid,
+			       SIGN32 own)
 {
-	kernel_share *p_ks;
-	vdec_os_driver_cb_t *p_cb = vdec_driver_get_cb();
-	pthread_attr_t pat;
-	int detach_attr;
-	struct monitor_data *p_md = NULL;
-
-	pthread_mutex_lock(&pmt);
-
-	if (p_cb->kernel_share_va == 0 || pmd == NULL) {
-		dbg_printf(VDEC_DEBUG_ALL,
-			   "vdec_os_api_free_user_id error: not init yet\n");
-		free(pmd);
-		pthread_detach(pthread_self());
-		pthread_mutex_unlock(&pmt);
-		return (void *)-1;
-	}
-
-	p_md = malloc(sizeof(struct monitor_data));
-	if (p_md == NULL) {
-		free(pmd);
-		pthread_detach(pthread_self());
-		pthread_mutex_unlock(&pmt);
-		return (void *)-1;
-	}
-
-	memcpy(p_md, pmd, sizeof(struct monitor_data));
-	dbg_printf(VDEC_DEBUG_LOCK, "ori 0x%x 0x%x pt=0x%x user_id=0x%x\n",
-		   ((struct monitor_data *)pmd)->pt,
-		   ((struct monitor_data *)pmd)->user_id, p_md->pt,
-		   p_md->user_id);
-
-	p_ks = (kernel_share *) p_cb->kernel_share_va;
-
-	if (pthread_getattr_np(p_md->pt, &pat) != 0) {
-		dbg_printf(VDEC_DEBUG_LOCK, "get thread attr failed\n");
-		goto tag_monitor_fail;
-	}
-
-	if (pthread_attr_getdetachstate(&pat, &detach_attr) != 0) {
-		dbg_printf(VDEC_DEBUG_LOCK, "get detach attr failed\n");
-		goto tag_monitor_fail;
-	}
+	dbg_printf(VDEC_DEBUG_LOCK,
+		   "vmeta user exit abnormally, instance id=%d pid=%d lock flag=%d\n",
+		   user_id, pid, p_ks->lock_flag);
 
-	if (detach_attr == PTHREAD_CREATE_DETACHED) {
-		dbg_printf(VDEC_DEBUG_LOCK,
-			   "The thread is a detached thread, cannot join\nexit monitor!\n");
-		goto tag_monitor_fail;
+	if (own && p_ks->active_user_id == user_id &&
+	    p_ks->lock_flag == VMETA_LOCK_ON) {
+		// our pid is alive, vmeta_lock_acquire never passes this ticket over
+		vdec_os_api_unlock(user_id);
+		p_ks->lock_flag = VMETA_LOCK_FORCE_INIT;
+		return;
 	}
 
-	dbg_printf(VDEC_DEBUG_LOCK, "wait for pt=0x%x\n", p_md->pt);
-	pthread_mutex_unlock(&pmt);
-
-	pthread_join(p_md->pt, NULL);
-	dbg_printf(VDEC_DEBUG_LOCK, "pt=0x%x is killed user_id(%d)\n", p_md->pt,
-		   p_md->user_id);
-
-	pthread_mutex_lock(&pmt);
-	p_cb = vdec_driver_get_cb();
-
-	if (p_cb) {
-		if (p_cb->kernel_share_va) {
-			p_ks = (kernel_share *) p_cb->kernel_share_va;
-			if (p_md->user_id == p_ks->active_user_id) {
-				dbg_printf(VDEC_DEBUG_LOCK,
-					   "vmeta thread exit abnormally, instance id=%d lock flag=%d\n",
-					   p_md->user_id, p_ks->lock_flag);
-				if (p_ks->lock_flag == VMETA_LOCK_ON) {
-					vdec_os_api_unlock(p_md->user_id);
-					p_ks->lock_flag = VMETA_LOCK_FORCE_INIT;
-				}
-				p_ks->active_user_id = MAX_VMETA_INSTANCE;
-			}
-
-			if (p_ks->user_id_list[p_md->user_id].status != 0) {
-				dbg_printf(VDEC_DEBUG_LOCK,
-					   "vmeta thread exit abnormally, clear instance(%d)\n",
-					   p_md->user_id);
-				memset(&(p_ks->user_id_list[p_md->user_id]),
-				       0x0, sizeof(id_instance));
-				p_ks->ref_count--;
-			}
-		}
+	// the lock of a dead process is passed over by vmeta_lock_acquire
+	vmeta_private_lock();
+	if (p_ks->active_user_id == user_id) {
+		p_ks->active_user_id = MAX_VMETA_INSTANCE;
+		p_ks->lock_flag = VMETA_LOCK_FORCE_INIT;
 	}
-
-	free(p_md);
-	free(pmd);
-	pthread_attr_destroy(&pat);
-
-	dbg_printf(VDEC_DEBUG_MEM, "thread monitor exit\n");
-	pthread_detach(pthread_self());
-	pthread_mutex_unlock(&pmt);
-	return (void *)0;
-
-tag_monitor_fail:
-	pthread_mutex_unlock(&pmt);
-	free(p_md);
-	free(pmd);
-	pthread_detach(pthread_self());
-
-	pthread_attr_destroy(&pat);
-	return (void *)-1;
-
+	vmeta_private_unlock();
 }
-#endif
 
 SIGN32 vdec_os_api_register_user_id(SIGN32 user_id)
 {
 	kernel_share *p_ks;
 	vdec_os_driver_cb_t *p_cb = vdec_driver_get_cb();
-	pthread_t tmp;
-	#if NEED_MONITOR
-	struct monitor_data *p_md;
-	#endif
 
 	if (user_id >= MAX_VMETA_INSTANCE || user_id < 0) {
 		dbg_printf(VDEC_DEBUG_ALL,
@@ -1049,22 +1086,11 @@ SIGN32 vdec_os_api_register_user_id(SIGN32 user_id)
 			   "vdec_os_api_register_user_id error: user id has already been registered\n");
 		return VDEC_OS_DRIVER_USER_ID_FAIL;
 	}
-	#if NEED_MONITOR
-	p_md = (struct monitor_data *)malloc(sizeof(struct monitor_data));	//This is freed monitor function
-	if (p_md == NULL) {
-		dbg_printf(VDEC_DEBUG_ALL,
-			   "vdec_os_api_register_user_id error: OOM\n");
-		return VDEC_OS_DRIVER_USER_ID_FAIL;
-	}
-	#endif
-	p_ks->ref_count++;
+	__sync_fetch_and_add(&p_ks->ref_count, 1);
 	p_ks->user_id_list[user_id].pid = getpid();
 	p_ks->user_id_list[user_id].pt = (unsigned int)pthread_self();
-	#if NEED_MONITOR
-	p_md->pt = pthread_self();
-	p_md->user_id = user_id;
-	pthread_create(&tmp, NULL, vmeta_thread_monitor, p_md);
-	#endif
+	vmeta_watch_start(p_ks, vmeta_reclaim_user, VMETA_WATCH_FLAGS);
+	vmeta_watch_add(user_id);
 	ioctl(p_cb->uiofd, VMETA_CMD_REG_UNREG, (unsigned long)user_id);
 
 	dbg_printf(VDEC_DEBUG_LOCK,
@@ -1104,7 +1130,8 @@ SIGN32 vdec_os_api_unregister_user_id(SIGN32 user_id)
 		return VDEC_OS_DRIVER_USER_ID_FAIL;
 	}
 
-	p_ks->ref_count--;
+	__sync_fetch_and_sub(&p_ks->ref_count, 1);
+	vmeta_watch_remove(user_id);
 	ioctl(p_cb->uiofd, VMETA_CMD_REG_UNREG, (unsigned long)user_id);
 	return VDEC_OS_DRIVER_OK;
 }
@@ -1153,6 +1180,7 @@ SIGN32 vdec_os_api_lock(SIGN32 user_id, UNSG32 to_ms)
 	vdec_os_driver_cb_t *p_cb = vdec_driver_get_cb();
 	kernel_share *p_ks;
 	SIGN32 ret;
+	SIGN32 dead_user_id;
 	struct timeval tv;
 	struct timezone tz;
 
@@ -1167,35 +1195,29 @@ SIGN32 vdec_os_api_lock(SIGN32 user_id, UNSG32 to_ms)
 		dbg_printf(VDEC_DEBUG_LOCK,
 			   "lock same user=%d, lock_flag=%d,ref_count=%d\n",
 			   user_id, p_ks->lock_flag, p_ks->ref_count);
-		return LOCK_RET_ME;	//just return since they are the same caller
-	} else if (p_ks->lock_flag == VMETA_LOCK_ON) {	/*Here, we can handle the second lock is not released by the first one */
-		gettimeofday(&tv, &tz);
-		vmeta_private_lock();
-		if (tv.tv_sec > p_ks->lock_start_tv.tv_sec + 3) {
-			dbg_printf(VDEC_DEBUG_LOCK, "force lock to others\n");
-			dbg_printf(VDEC_DEBUG_LOCK, "interval sec=%ld us=%ld\n",
-				   tv.tv_sec - p_ks->lock_start_tv.tv_sec,
-				   tv.tv_usec - p_ks->lock_start_tv.tv_usec);
-			p_ks->lock_start_tv.tv_sec = tv.tv_sec;
-			p_ks->lock_start_tv.tv_usec = tv.tv_usec;
-			vmeta_private_unlock();
-
-			vdec_os_api_unregister_user_id(p_ks->active_user_id);
-			vdec_os_api_free_user_id(p_ks->active_user_id);
-
-			vmeta_private_lock();
-			p_ks->active_user_id = user_id;
-			vmeta_private_unlock();
-
-			return LOCK_RET_FORCE_TO_OTHERS;
-		}
+		if (!vmeta_lock_yield_due(p_ks))
+			return LOCK_RET_ME;	//just return since they are the same caller
+		/* time slice used up with others waiting: go to the back of the queue */
+		dbg_printf(VDEC_DEBUG_LOCK, "user=%d yields the lock\n", user_id);
+		vdec_os_api_unlock(user_id);
+	}
 
-		vmeta_private_unlock();
+	/* wait for our turn; an owner is only passed over once its process is gone */
+	if (vmeta_lock_acquire(p_ks, user_id, to_ms, &dead_user_id) != 0) {
+		dbg_printf(VDEC_DEBUG_LOCK, "lock timeout\n");
+		return LOCK_RET_ERROR_TIMEOUT;
+	}
+	if (dead_user_id >= 0) {
+		dbg_printf(VDEC_DEBUG_LOCK, "owner user=%d is gone\n",
+			   dead_user_id);
+		vdec_os_api_unregister_user_id(dead_user_id);
+		vdec_os_api_free_user_id(dead_user_id);
 	}
 
 	ret = ioctl(vdec_iface->uiofd, VMETA_CMD_LOCK, (unsigned long)to_ms);
 	if (ret != 0) {
 		dbg_printf(VDEC_DEBUG_LOCK, "lock timeout\n");
+		vmeta_lock_release(p_ks, user_id);
 		return LOCK_RET_ERROR_TIMEOUT;
 	}
 
@@ -1244,6 +1266,7 @@ SIGN32 vdec_os_api_unlock(SIGN32 user_id)
 	vmeta_private_unlock();
 
 	ret = ioctl(vdec_iface->uiofd, VMETA_CMD_UNLOCK);
+	vmeta_lock_release(p_ks, user_id);
 	dbg_printf(VDEC_DEBUG_LOCK, "ID: %d after unlock\n", user_id);
 	if (ret != 0) {
 		dbg_printf(VDEC_DEBUG_LOCK, "vdec_os_api_unlock ioctl error\n");
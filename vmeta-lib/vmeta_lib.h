@@ -18,12 +18,16 @@ extern "C"
 #define VDEC_DEBUG_NONE 0x0
 
 #define UIO_DEV "/dev/uio0"
+#define UIO_SYSFS_DIR "/sys/class/uio/uio0"
+#define UIO_IO_MAP_NUM 4
+#define UIO_IO_MEM_INDEX 0
 #define UIO_IO_MEM_SIZE "/sys/class/uio/uio0/maps/map0/size"
 #define UIO_IO_MEM_ADDR "/sys/class/uio/uio0/maps/map0/addr"
 #define UIO_IO_VERSION "/sys/class/uio/uio0/version"
 
 #define UIO_IO_HW_CONTEXT_SIZE "/sys/class/uio/uio0/maps/map1/size"
 #define UIO_IO_HW_CONTEXT_ADDR "/sys/class/uio/uio0/maps/map1/addr"
+#define UIO_IO_HW_CONTEXT_INDEX 1
 
 #define UIO_IO_VMETA_OBJ_SIZE "/sys/class/uio/uio0/maps/map2/size"
 #define UIO_IO_VMETA_OBJ_ADDR "/sys/class/uio/uio0/maps/map2/addr"
@@ -82,6 +86,15 @@ typedef enum _VPRO_CODEC_ERROR_CODE_ {
 #define VMETA_LOG_ON 1
 #define VMETA_LOG_FILE "/data/vmeta_dbg.log"
 int dbg_printf(UNSG32 dbglevel, const char* format, ...);
+void vmeta_log_set_level(UNSG32 dbglevel);
+void vmeta_log_set_file(const char *path, UNSG32 max_size);
+void vmeta_log_flush(void);
+
+/* fair lock kept in the kernel share page */
+SIGN32 vmeta_lock_acquire(kernel_share *p_ks, SIGN32 user_id, UNSG32 to_ms,
+			  SIGN32 *dead_user_id);
+void vmeta_lock_release(kernel_share *p_ks, SIGN32 user_id);
+SIGN32 vmeta_lock_yield_due(kernel_share *p_ks);
 
 typedef sem_t lock_t;
 //---------------------------------------------------------------------------
@@ -103,14 +116,24 @@ typedef struct vdec_os_driver_cb_s
 	SIGN32 curr_op;
 } vdec_os_driver_cb_t;
 
-struct monitor_data{
-	pthread_t pt;
-	SIGN32 user_id;
-};
+/* liveness watcher of the users in the kernel share page */
+#define VMETA_WATCH_NO_PIDFD	(1 << 0)	// sweep /proc only
+#define VMETA_WATCH_THREADS	(1 << 1)	// a user dies with the thread that registered it
+typedef void (*vmeta_watch_reclaim_fn)(kernel_share *p_ks, SIGN32 user_id,
+				       pid_t pid, SIGN32 own);
+SIGN32 vmeta_watch_start(kernel_share *p_ks, vmeta_watch_reclaim_fn reclaim,
+			 UNSG32 flags);
+void vmeta_watch_stop(void);
+void vmeta_watch_add(SIGN32 user_id);
+void vmeta_watch_remove(SIGN32 user_id);
+SIGN32 vmeta_watch_sweep(void);
 
 /* vdec driver get cb */
 vdec_os_driver_cb_t *vdec_driver_get_cb(void);
 
+/* use another uio device and sysfs directory, NULL for the default; for tests */
+SIGN32 vdec_os_driver_set_uio(const char *dev, const char *sysfs_dir);
+
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,252 @@
+/*
+ *  vmeta_lock.c
+ *
+ *  Fair lock of the vmeta engine between processes. Users take tickets
+ *  from the kernel share page and are served in ticket order; an owner is
+ *  only ever skipped once its process is gone, and a busy owner hands the
+ *  engine over after a time slice when others are waiting.
+ *
+ * Copyright (C) 2009 Marvell International Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <signal.h>
+#include <time.h>
+#include <errno.h>
+#include <limits.h>
+#include <linux/futex.h>
+
+#include "vmeta_lib.h"
+
+#define VMETA_LOCK_POLL_US	1000	// wait step without futex
+#define VMETA_LOCK_STALE_MS	1000	// ticket taken but never filled in
+
+#define TICKET_SLOT(p_ks, t) \
+	(&(p_ks)->lock_queue[(t) & (VMETA_LOCK_QUEUE_SIZE - 1)])
+
+// the share page may be a mapping futex does not support
+static volatile int lock_futex_ok = 1;
+
+static UNSG32 lock_now_ms(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static int lock_pid_alive(pid_t pid)
+{
+	return pid <= 0 || kill(pid, 0) == 0 || errno != ESRCH;
+}
+
+/* sleep until lock_serving moves away from serving or ms have passed */
+static void lock_wait(kernel_share *p_ks, UNSG32 serving, UNSG32 ms)
+{
+	struct timespec ts;
+
+	if (lock_futex_ok) {
+		ts.tv_sec = ms / 1000;
+		ts.tv_nsec = (ms % 1000) * 1000000;
+		if (syscall(__NR_futex, &p_ks->lock_serving, FUTEX_WAIT,
+			    serving, &ts, NULL, 0) == 0 ||
+		    errno == EAGAIN || errno == EINTR || errno == ETIMEDOUT)
+			return;
+		dbg_printf(VDEC_DEBUG_LOCK,
+			   "lock: futex error %d, polling instead\n", errno);
+		lock_futex_ok = 0;
+	}
+	if (ms > VMETA_LOCK_POLL_US / 1000)
+		ms = VMETA_LOCK_POLL_US / 1000;
+	usleep(ms * 1000);
+}
+
+static void lock_wake(kernel_share *p_ks)
+{
+	if (lock_futex_ok)
+		syscall(__NR_futex, &p_ks->lock_serving, FUTEX_WAKE, INT_MAX,
+			NULL, NULL, 0);
+}
+
+/*
+ * Serve the ticket after serving, skipping canceled ones. Nothing happens
+ * if somebody else moved lock_serving on already.
+ */
+static void lock_advance(kernel_share *p_ks, UNSG32 serving)
+{
+	lock_ticket *slot;
+
+	while (__sync_bool_compare_and_swap(&p_ks->lock_serving, serving,
+					    serving + 1)) {
+		serving++;
+		slot = TICKET_SLOT(p_ks, serving);
+		__sync_synchronize();
+		if (slot->ticket != serving ||
+		    slot->state != VMETA_TICKET_CANCELED)
+			break;
+	}
+	lock_wake(p_ks);
+}
+
+/*
+ * The ticket being served belongs to a process that is gone: take it out
+ * of the queue so the next one gets its turn. Returns the user id it held
+ * the engine for, or -1 when it never got the engine.
+ */
+static SIGN32 lock_skip_dead(kernel_share *p_ks, UNSG32 serving)
+{
+	lock_ticket *slot = TICKET_SLOT(p_ks, serving);
+	SIGN32 user_id = -1;
+
+	if (slot->state == VMETA_TICKET_GRANTED)
+		user_id = slot->user_id;
+	if (p_ks->lock_serving != serving)
+		return -1;
+	dbg_printf(VDEC_DEBUG_LOCK,
+		   "lock: ticket %u of dead pid %d, user id %d skipped\n",
+		   serving, slot->pid, slot->user_id);
+	if (user_id >= 0) {
+		// the engine is in an unknown state
+		p_ks->lock_flag = VMETA_LOCK_FORCE_INIT;
+		if (p_ks->active_user_id == user_id)
+			p_ks->active_user_id = MAX_VMETA_INSTANCE;
+	}
+	lock_advance(p_ks, serving);
+	return user_id;
+}
+
+/*
+ * Take a ticket and wait for it to be served, at most to_ms. Returns 0
+ * once the caller owns the lock, -1 on timeout. *dead_user_id is set to
+ * the user id of an owner whose process was found gone on the way, -1
+ * otherwise.
+ */
+SIGN32 vmeta_lock_acquire(kernel_share *p_ks, SIGN32 user_id, UNSG32 to_ms,
+			  SIGN32 *dead_user_id)
+{
+	UNSG32 start = lock_now_ms(), elapsed, wait;
+	UNSG32 t, serving, stale_ms = 0;
+	lock_ticket *slot;
+	SIGN32 dead;
+
+	*dead_user_id = -1;
+
+	// room in the queue: a waiter that timed out may leave a ticket behind
+	for (;;) {
+		t = p_ks->lock_next_ticket;
+		serving = p_ks->lock_serving;
+		if (t - serving < VMETA_LOCK_QUEUE_SIZE) {
+			if (__sync_bool_compare_and_swap(&p_ks->lock_next_ticket,
+							 t, t + 1))
+				break;
+			continue;
+		}
+		elapsed = lock_now_ms() - start;
+		if (elapsed >= to_ms)
+			return -1;
+		lock_wait(p_ks, serving, to_ms - elapsed);
+	}
+
+	slot = TICKET_SLOT(p_ks, t);
+	slot->user_id = user_id;
+	slot->pid = getpid();
+	slot->state = VMETA_TICKET_WAIT;
+	__sync_synchronize();
+	slot->ticket = t;
+	__sync_synchronize();
+	dbg_printf(VDEC_DEBUG_LOCK, "lock: user id %d ticket %u, serving %u\n",
+		   user_id, t, p_ks->lock_serving);
+
+	for (;;) {
+		serving = p_ks->lock_serving;
+		if (serving == t &&
+		    __sync_bool_compare_and_swap(&slot->state,
+						 VMETA_TICKET_WAIT,
+						 VMETA_TICKET_GRANTED))
+			break;
+
+		// whoever is next in line watches the one being served
+		if (serving + 1 == t) {
+			lock_ticket *head = TICKET_SLOT(p_ks, serving);
+
+			if (head->ticket != serving) {
+				if (!stale_ms) {
+					stale_ms = lock_now_ms() | 1;
+				} else if (lock_now_ms() - stale_ms >=
+					   VMETA_LOCK_STALE_MS) {
+					lock_advance(p_ks, serving);
+					continue;
+				}
+			} else if (!lock_pid_alive(head->pid)) {
+				dead = lock_skip_dead(p_ks, serving);
+				if (dead >= 0)
+					*dead_user_id = dead;
+				continue;
+			}
+		}
+
+		elapsed = lock_now_ms() - start;
+		if (elapsed >= to_ms) {
+			if (__sync_bool_compare_and_swap(&slot->state,
+							 VMETA_TICKET_WAIT,
+							 VMETA_TICKET_CANCELED)) {
+				// served meanwhile, pass the turn on
+				if (p_ks->lock_serving == t)
+					lock_advance(p_ks, t);
+				dbg_printf(VDEC_DEBUG_LOCK,
+					   "lock: user id %d ticket %u timeout\n",
+					   user_id, t);
+				return -1;
+			}
+			break;	// granted just now
+		}
+		wait = to_ms - elapsed;
+		if (wait > VMETA_LOCK_SLICE_MS)
+			wait = VMETA_LOCK_SLICE_MS;
+		lock_wait(p_ks, serving, wait);
+	}
+
+	p_ks->lock_start_ms = lock_now_ms();
+	return 0;
+}
+
+/* give the lock to the next ticket */
+void vmeta_lock_release(kernel_share *p_ks, SIGN32 user_id)
+{
+	UNSG32 serving = p_ks->lock_serving;
+	lock_ticket *slot = TICKET_SLOT(p_ks, serving);
+
+	if (slot->ticket != serving || slot->user_id != user_id ||
+	    slot->state != VMETA_TICKET_GRANTED) {
+		dbg_printf(VDEC_DEBUG_LOCK,
+			   "lock: user id %d releases ticket %u it does not hold\n",
+			   user_id, serving);
+		return;
+	}
+	lock_advance(p_ks, serving);
+}
+
+/* the owner has used up its time slice and others are waiting */
+SIGN32 vmeta_lock_yield_due(kernel_share *p_ks)
+{
+	return p_ks->lock_next_ticket - p_ks->lock_serving > 1 &&
+	    lock_now_ms() - p_ks->lock_start_ms >= VMETA_LOCK_SLICE_MS;
+}
@@ -0,0 +1,330 @@
+/*
+ *  vmeta_lock_stress.c
+ *
+ *  Runs the vmeta lock of vmeta_lock.c between processes over a simulated
+ *  kernel share page: heavy contention, an owner slower than the old
+ *  3 second steal, owners and waiters that die, and a user that never
+ *  unlocks. Exits with the number of failed checks.
+ *
+ *  Build: cc -O2 -o vmeta_lock_stress vmeta_lock_stress.c vmeta_lock.c
+ *         vmeta_log.c -lpthread
+ *  Usage: vmeta_lock_stress [-p processes] [-n locks per process]
+ *
+ * Copyright (C) 2009 Marvell International Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <signal.h>
+#include <string.h>
+#include <sched.h>
+#include <time.h>
+
+#include "vmeta_lib.h"
+
+#define STRESS_MAX_PROCS	MAX_VMETA_INSTANCE
+
+UNSG32 globalDbgLevel = VDEC_DEBUG_NONE;
+
+// shared by all processes, next to the simulated kernel share page
+typedef struct {
+	volatile SIGN32 holder;		// user id inside the lock, -1 if none
+	volatile UNSG32 last_ticket;	// ticket served last
+	volatile UNSG32 overlaps;	// two users inside at once
+	volatile UNSG32 out_of_order;	// ticket served before an older one
+	volatile UNSG32 grants;
+	volatile UNSG32 timeouts;
+	volatile UNSG32 max_wait_ms;
+	volatile UNSG32 yields;
+	volatile SIGN32 dead_seen;	// user id reported gone
+} stress_stats;
+
+static kernel_share *ks;
+static stress_stats *st;
+static int failures;
+
+static UNSG32 now_ms(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void check(int ok, const char *what)
+{
+	printf("  %-52s %s\n", what, ok ? "ok" : "FAIL");
+	if (!ok)
+		failures++;
+}
+
+static void reset(void)
+{
+	memset(ks, 0, sizeof(*ks));
+	ks->active_user_id = MAX_VMETA_INSTANCE;
+	memset(st, 0, sizeof(*st));
+	st->holder = -1;
+	st->dead_seen = -1;
+}
+
+/* acquire, and account for what the lock promises */
+static int stress_lock(SIGN32 id, UNSG32 to_ms)
+{
+	UNSG32 start = now_ms(), waited, m;
+	SIGN32 dead;
+
+	if (vmeta_lock_acquire(ks, id, to_ms, &dead) != 0) {
+		__sync_fetch_and_add(&st->timeouts, 1);
+		return -1;
+	}
+	if (!__sync_bool_compare_and_swap(&st->holder, -1, id))
+		__sync_fetch_and_add(&st->overlaps, 1);
+	if (st->grants && (int)(ks->lock_serving - st->last_ticket) <= 0)
+		st->out_of_order++;
+	st->last_ticket = ks->lock_serving;
+	st->grants++;
+	if (dead >= 0)
+		st->dead_seen = dead;
+	waited = now_ms() - start;
+	while ((m = st->max_wait_ms) < waited &&
+	       !__sync_bool_compare_and_swap(&st->max_wait_ms, m, waited))
+		;
+	return 0;
+}
+
+static void stress_unlock(SIGN32 id)
+{
+	__sync_bool_compare_and_swap(&st->holder, id, -1);
+	vmeta_lock_release(ks, id);
+}
+
+static pid_t spawn(void (*fn)(SIGN32, int), SIGN32 id, int arg)
+{
+	pid_t pid = fork();
+
+	if (pid == 0) {
+		fn(id, arg);
+		_exit(0);
+	}
+	return pid;
+}
+
+static void reap(pid_t pid)
+{
+	waitpid(pid, NULL, 0);
+}
+
+static void worker(SIGN32 id, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++) {
+		if (stress_lock(id, 10000) != 0)
+			continue;
+		usleep(100);
+		stress_unlock(id);
+		if (i & 1)
+			sched_yield();
+	}
+}
+
+static void slow_owner(SIGN32 id, int hold_ms)
+{
+	if (stress_lock(id, 1000) != 0)
+		return;
+	usleep(hold_ms * 1000);
+	stress_unlock(id);
+}
+
+static void impatient(SIGN32 id, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++)
+		if (stress_lock(id, 300) == 0)
+			stress_unlock(id);
+}
+
+static void crash_owner(SIGN32 id, int unused)
+{
+	(void)unused;
+	// dies holding the lock
+	stress_lock(id, 1000);
+}
+
+/* never unlocks, but gives way whenever its slice is up */
+static void hog(SIGN32 id, int run_ms)
+{
+	UNSG32 end = now_ms() + run_ms;
+
+	if (stress_lock(id, 1000) != 0)
+		return;
+	while (now_ms() < end) {
+		usleep(1000);
+		if (vmeta_lock_yield_due(ks)) {
+			__sync_fetch_and_add(&st->yields, 1);
+			stress_unlock(id);
+			if (stress_lock(id, 10000) != 0)
+				return;
+		}
+	}
+	stress_unlock(id);
+}
+
+static void test_contention(int procs, int count)
+{
+	pid_t pids[STRESS_MAX_PROCS];
+	int i;
+
+	printf("contention: %d processes, %d locks each\n", procs, count);
+	reset();
+	for (i = 0; i < procs; i++)
+		pids[i] = spawn(worker, i, count);
+	for (i = 0; i < procs; i++)
+		reap(pids[i]);
+	printf("  max wait %u ms\n", st->max_wait_ms);
+	check(st->grants == (UNSG32)(procs * count), "every lock granted");
+	check(st->overlaps == 0, "one owner at a time");
+	check(st->out_of_order == 0, "served in ticket order");
+	check(ks->lock_next_ticket == ks->lock_serving, "queue empty");
+}
+
+static void test_slow_owner(void)
+{
+	pid_t owner, waiters[4];
+	int i;
+
+	printf("slow owner: held 3.5 s, waiters time out after 300 ms\n");
+	reset();
+	owner = spawn(slow_owner, 0, 3500);
+	usleep(50000);
+	for (i = 0; i < 4; i++)
+		waiters[i] = spawn(impatient, i + 1, 15);
+	for (i = 0; i < 4; i++)
+		reap(waiters[i]);
+	reap(owner);
+	check(st->overlaps == 0, "lock never taken away from a live owner");
+	check(st->timeouts > 0, "waiters time out instead");
+	check(st->dead_seen < 0, "no owner reported gone");
+	check(ks->lock_next_ticket == ks->lock_serving, "queue empty");
+
+	// canceled tickets must not wedge the queue
+	check(stress_lock(9, 100) == 0, "lock free afterwards");
+	stress_unlock(9);
+}
+
+static void test_dead_owner(void)
+{
+	pid_t pid, waiter;
+	UNSG32 start, grants;
+
+	printf("dead owner and dead waiter\n");
+	reset();
+	pid = spawn(crash_owner, 3, 0);
+	reap(pid);
+	start = now_ms();
+	check(stress_lock(4, 2000) == 0, "lock recovered from a dead owner");
+	check(st->dead_seen == 3, "dead owner reported");
+	check(ks->lock_flag == VMETA_LOCK_FORCE_INIT, "engine marked for init");
+	printf("  recovered in %u ms\n", now_ms() - start);
+
+	// a waiter killed in the queue is skipped
+	st->dead_seen = -1;
+	grants = st->grants;
+	waiter = spawn(worker, 5, 1);
+	usleep(50000);
+	kill(waiter, SIGKILL);
+	reap(waiter);
+	pid = spawn(worker, 6, 1);
+	usleep(50000);
+	stress_unlock(4);
+	reap(pid);
+	check(st->grants == grants + 1, "waiter behind a dead one served");
+	check(st->dead_seen < 0, "dead waiter never owned the engine");
+	check(ks->lock_next_ticket == ks->lock_serving, "queue empty");
+}
+
+static void test_time_slice(int procs)
+{
+	pid_t h, pids[STRESS_MAX_PROCS];
+	int i;
+
+	printf("time slice: a user that never unlocks, %d others\n", procs);
+	reset();
+	h = spawn(hog, 0, 2000);
+	usleep(20000);
+	for (i = 0; i < procs; i++)
+		pids[i] = spawn(worker, i + 1, 3);
+	for (i = 0; i < procs; i++)
+		reap(pids[i]);
+	reap(h);
+	printf("  %u yields, max wait %u ms\n", st->yields, st->max_wait_ms);
+	check(st->grants >= (UNSG32)(3 * procs + 1), "others served meanwhile");
+	check(st->yields > 0, "owner yields after its slice");
+	check(st->max_wait_ms < 2 * VMETA_LOCK_SLICE_MS + 500,
+	      "wait bounded by the slice");
+	check(st->overlaps == 0, "one owner at a time");
+}
+
+int main(int argc, char *argv[])
+{
+	int procs = 8, count = 500;
+	int opt;
+	void *p;
+
+	while ((opt = getopt(argc, argv, "p:n:")) != -1) {
+		switch (opt) {
+		case 'p':
+			procs = atoi(optarg);
+			break;
+		case 'n':
+			count = atoi(optarg);
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-p processes] [-n locks]\n",
+				argv[0]);
+			return 1;
+		}
+	}
+	if (procs < 2)
+		procs = 2;
+	if (procs > STRESS_MAX_PROCS - 1)
+		procs = STRESS_MAX_PROCS - 1;
+	if (count <= 0)
+		count = 1;
+
+	p = mmap(NULL, sizeof(kernel_share) + sizeof(stress_stats),
+		 PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (p == MAP_FAILED) {
+		perror("mmap");
+		return 1;
+	}
+	ks = (kernel_share *)p;
+	st = (stress_stats *)(ks + 1);
+
+	test_contention(procs, count);
+	test_slow_owner();
+	test_dead_owner();
+	test_time_slice(procs);
+
+	printf("%d failed\n", failures);
+	return failures;
+}
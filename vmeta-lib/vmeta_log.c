@@ -0,0 +1,399 @@
+/*
+ *  vmeta_log.c
+ *
+ *  Asynchronous debug log of the vmeta library. Each thread formats its
+ *  messages into a ring of its own, without taking any lock, and a
+ *  background thread drains the rings to the log file in large writes.
+ *
+ * Copyright (C) 2009 Marvell International Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+
+#include "vmeta_lib.h"
+
+#define VMETA_LOG_RING_SIZE	(16*1024)	// per thread, power of 2
+#define VMETA_LOG_MSG_SIZE	256		// longest message
+#define VMETA_LOG_WRITE_SIZE	(64*1024)	// drain buffer
+#define VMETA_LOG_DRAIN_MS	100		// drain period
+#define VMETA_LOG_MAX_SIZE	(4*1024*1024)	// rotate the file beyond this
+
+// messages of one thread, single producer single consumer
+typedef struct vmeta_log_ring_s {
+	struct vmeta_log_ring_s *next;
+	volatile UNSG32 head;		// written by the owner thread
+	volatile UNSG32 tail;		// written by the drain thread
+	volatile UNSG32 dropped;	// messages lost to a full ring
+	UNSG32 dropped_seen;
+	volatile SIGN32 dead;		// owner thread exited
+	char buf[VMETA_LOG_RING_SIZE];
+} vmeta_log_ring_t;
+
+extern UNSG32 globalDbgLevel;
+
+static pthread_once_t log_once = PTHREAD_ONCE_INIT;
+static pthread_key_t log_key;
+static pthread_mutex_t log_list_lock = PTHREAD_MUTEX_INITIALIZER;
+static vmeta_log_ring_t *log_rings = NULL;
+static pthread_t log_thread;
+static int log_thread_ok = 0;
+static volatile int log_thread_start = 0;	// next message starts the drain thread
+static sem_t log_wake;
+static volatile int log_stop = 0;
+
+static pthread_mutex_t log_file_lock = PTHREAD_MUTEX_INITIALIZER;
+static char log_path[128] = VMETA_LOG_FILE;
+static UNSG32 log_max_size = VMETA_LOG_MAX_SIZE;
+static int log_fd = -1;
+static UNSG32 log_size = 0;
+static char log_wbuf[VMETA_LOG_WRITE_SIZE];
+static UNSG32 log_wlen = 0;
+
+static inline UNSG32 log_load_acquire(volatile UNSG32 *p)
+{
+	UNSG32 v = *p;
+
+	__sync_synchronize();
+	return v;
+}
+
+static inline void log_store_release(volatile UNSG32 *p, UNSG32 v)
+{
+	__sync_synchronize();
+	*p = v;
+}
+
+/* open the log file, with log_file_lock held */
+static void log_file_open(void)
+{
+#if VMETA_LOG_ON
+	struct stat st;
+
+	log_fd = open(log_path, O_WRONLY | O_CREAT | O_APPEND, 0666);
+	if (log_fd >= 0 && fstat(log_fd, &st) == 0)
+		log_size = st.st_size;
+	else
+		log_size = 0;
+#else
+	log_fd = STDOUT_FILENO;
+	log_size = 0;
+#endif
+}
+
+/* write the drain buffer out, rotating the file when it gets too big */
+static void log_file_write(void)
+{
+#if VMETA_LOG_ON
+	char old_path[sizeof(log_path) + 2];
+#endif
+	UNSG32 off = 0;
+	ssize_t n;
+
+	if (!log_wlen)
+		return;
+	pthread_mutex_lock(&log_file_lock);
+	if (log_fd < 0)
+		log_file_open();
+#if VMETA_LOG_ON
+	if (log_fd >= 0 && log_max_size && log_size + log_wlen > log_max_size) {
+		close(log_fd);
+		snprintf(old_path, sizeof(old_path), "%s.1", log_path);
+		rename(log_path, old_path);
+		log_file_open();
+	}
+#endif
+	while (log_fd >= 0 && off < log_wlen) {
+		n = write(log_fd, log_wbuf + off, log_wlen - off);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			break;
+		off += n;
+	}
+	log_size += off;
+	pthread_mutex_unlock(&log_file_lock);
+	log_wlen = 0;
+}
+
+/* append to the drain buffer */
+static void log_buf_append(const char *data, UNSG32 len)
+{
+	UNSG32 n;
+
+	while (len) {
+		n = VMETA_LOG_WRITE_SIZE - log_wlen;
+		if (n > len)
+			n = len;
+		memcpy(log_wbuf + log_wlen, data, n);
+		log_wlen += n;
+		data += n;
+		len -= n;
+		if (log_wlen == VMETA_LOG_WRITE_SIZE)
+			log_file_write();
+	}
+}
+
+/* move everything a ring holds to the drain buffer */
+static void log_ring_drain(vmeta_log_ring_t *ring)
+{
+	char note[64];
+	UNSG32 head, tail, off, n;
+
+	head = log_load_acquire(&ring->head);
+	tail = ring->tail;
+	while (tail != head) {
+		off = tail & (VMETA_LOG_RING_SIZE - 1);
+		n = head - tail;
+		if (n > VMETA_LOG_RING_SIZE - off)
+			n = VMETA_LOG_RING_SIZE - off;
+		log_buf_append(ring->buf + off, n);
+		tail += n;
+	}
+	log_store_release(&ring->tail, tail);
+
+	n = ring->dropped;
+	if (n != ring->dropped_seen) {
+		snprintf(note, sizeof(note), "vmeta_log: %u messages dropped\n",
+			 n - ring->dropped_seen);
+		log_buf_append(note, strlen(note));
+		ring->dropped_seen = n;
+	}
+}
+
+/* drain every ring once, freeing the ones of exited threads */
+static void log_drain_all(void)
+{
+	vmeta_log_ring_t **pp, *ring;
+
+	pthread_mutex_lock(&log_list_lock);
+	pp = &log_rings;
+	while ((ring = *pp) != NULL) {
+		if (ring->dead) {
+			__sync_synchronize();
+			log_ring_drain(ring);
+			*pp = ring->next;
+			free(ring);
+			continue;
+		}
+		log_ring_drain(ring);
+		pp = &ring->next;
+	}
+	log_file_write();
+	pthread_mutex_unlock(&log_list_lock);
+}
+
+static void *log_thread_func(void *arg)
+{
+	struct timespec ts;
+
+	(void)arg;
+
+	while (!log_stop) {
+		clock_gettime(CLOCK_REALTIME, &ts);
+		ts.tv_nsec += VMETA_LOG_DRAIN_MS * 1000000;
+		if (ts.tv_nsec >= 1000000000) {
+			ts.tv_sec++;
+			ts.tv_nsec -= 1000000000;
+		}
+		sem_timedwait(&log_wake, &ts);
+		log_drain_all();
+	}
+	return NULL;
+}
+
+/* thread exit: the drain thread frees the ring once it is empty */
+static void log_ring_release(void *arg)
+{
+	vmeta_log_ring_t *ring = (vmeta_log_ring_t *)arg;
+
+	__sync_synchronize();
+	ring->dead = 1;
+}
+
+static void log_exit(void)
+{
+	if (log_thread_ok) {
+		log_stop = 1;
+		sem_post(&log_wake);
+		pthread_join(log_thread, NULL);
+		log_thread_ok = 0;
+	}
+	log_drain_all();
+}
+
+/* start the drain thread if asked to, after log_init or a fork */
+static void log_start(void)
+{
+	pthread_mutex_lock(&log_list_lock);
+	if (log_thread_start) {
+		if (pthread_create(&log_thread, NULL, log_thread_func, NULL) == 0)
+			log_thread_ok = 1;
+		log_thread_start = 0;
+	}
+	pthread_mutex_unlock(&log_list_lock);
+}
+
+/*
+ * The drain thread does not survive fork, and the child has only the
+ * forking thread. Drop the rings of the other threads and what the parent
+ * has not written yet, the parent writes it, and start draining again on
+ * the child's next message.
+ */
+static void log_atfork_child(void)
+{
+	vmeta_log_ring_t *ring, *own;
+
+	pthread_mutex_init(&log_list_lock, NULL);
+	pthread_mutex_init(&log_file_lock, NULL);
+	sem_init(&log_wake, 0, 0);
+	own = (vmeta_log_ring_t *)pthread_getspecific(log_key);
+	while ((ring = log_rings) != NULL) {
+		log_rings = ring->next;
+		if (ring != own)
+			free(ring);
+	}
+	if (own) {
+		own->next = NULL;
+		own->head = own->tail = 0;
+		own->dropped = own->dropped_seen = 0;
+		log_rings = own;
+	}
+	log_wlen = 0;
+	log_thread_ok = 0;
+	log_stop = 0;
+	log_thread_start = 1;
+}
+
+static void log_init(void)
+{
+	pthread_key_create(&log_key, log_ring_release);
+	sem_init(&log_wake, 0, 0);
+	log_thread_start = 1;
+	atexit(log_exit);
+	pthread_atfork(NULL, NULL, log_atfork_child);
+}
+
+/* ring of the calling thread, created on its first message */
+static vmeta_log_ring_t *log_get_ring(void)
+{
+	vmeta_log_ring_t *ring;
+
+	pthread_once(&log_once, log_init);
+	if (log_thread_start)
+		log_start();
+	ring = (vmeta_log_ring_t *)pthread_getspecific(log_key);
+	if (ring)
+		return ring;
+
+	ring = (vmeta_log_ring_t *)calloc(1, sizeof(vmeta_log_ring_t));
+	if (!ring)
+		return NULL;
+	pthread_setspecific(log_key, ring);
+	pthread_mutex_lock(&log_list_lock);
+	ring->next = log_rings;
+	log_rings = ring;
+	pthread_mutex_unlock(&log_list_lock);
+	return ring;
+}
+
+/* display debug message */
+int dbg_printf(UNSG32 dbglevel, const char *format, ...)
+{
+	char msg[VMETA_LOG_MSG_SIZE];
+	vmeta_log_ring_t *ring;
+	va_list var;
+	UNSG32 level = globalDbgLevel;
+	UNSG32 head, used, off, n;
+	int len;
+
+	if (!(dbglevel & level) && !(level & VDEC_DEBUG_ALL))
+		return 0;
+
+	ring = log_get_ring();
+	if (!ring)
+		return -1;
+
+	va_start(var, format);
+	len = vsnprintf(msg, sizeof(msg), format, var);
+	va_end(var);
+	if (len < 0)
+		return -1;
+	if (len >= (int)sizeof(msg))
+		len = sizeof(msg) - 1;
+
+	head = ring->head;
+	used = head - log_load_acquire(&ring->tail);
+	if (VMETA_LOG_RING_SIZE - used < (UNSG32)len) {
+		ring->dropped++;
+		return -1;
+	}
+	off = head & (VMETA_LOG_RING_SIZE - 1);
+	n = VMETA_LOG_RING_SIZE - off;
+	if (n > (UNSG32)len)
+		n = len;
+	memcpy(ring->buf + off, msg, n);
+	memcpy(ring->buf, msg + n, len - n);
+	log_store_release(&ring->head, head + len);
+
+	// wake the drain thread early once the ring is half full
+	if (used < VMETA_LOG_RING_SIZE / 2 &&
+	    used + len >= VMETA_LOG_RING_SIZE / 2)
+		sem_post(&log_wake);
+	return 0;
+}
+
+/* set the debug levels to log, takes effect immediately */
+void vmeta_log_set_level(UNSG32 dbglevel)
+{
+	globalDbgLevel = dbglevel;
+	__sync_synchronize();
+}
+
+/* change the log file and the size it is rotated at, 0 to never rotate */
+void vmeta_log_set_file(const char *path, UNSG32 max_size)
+{
+	pthread_mutex_lock(&log_file_lock);
+	if (path) {
+		strncpy(log_path, path, sizeof(log_path) - 1);
+		log_path[sizeof(log_path) - 1] = '\0';
+#if VMETA_LOG_ON
+		if (log_fd >= 0)
+			close(log_fd);
+		log_fd = -1;
+#endif
+	}
+	log_max_size = max_size;
+	pthread_mutex_unlock(&log_file_lock);
+}
+
+/* write out everything logged so far */
+void vmeta_log_flush(void)
+{
+	log_drain_all();
+}
@@ -0,0 +1,172 @@
+/*
+ *  vmeta_log_bench.c
+ *
+ *  Measures the per-call cost of dbg_printf: the asynchronous logger of
+ *  vmeta_log.c against the former implementation, which opened, wrote
+ *  and closed the log file on every call.
+ *
+ *  Build: cc -O2 -o vmeta_log_bench vmeta_log_bench.c vmeta_log.c -lpthread
+ *  Usage: vmeta_log_bench [-n calls] [-f log file]
+ *
+ * Copyright (C) 2009 Marvell International Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+
+#include "vmeta_lib.h"
+
+// lock, unlock, power and clock calls the decoder makes per frame
+#define BENCH_CALLS_PER_FRAME	16
+#define BENCH_FPS		60
+#define BENCH_CALLS_PER_SEC	(BENCH_CALLS_PER_FRAME * BENCH_FPS)
+
+UNSG32 globalDbgLevel = VDEC_DEBUG_NONE;
+
+static const char *bench_path = "vmeta_log_bench.log";
+
+/* dbg_printf as it was before the asynchronous logger */
+static int legacy_dbg_printf(UNSG32 dbglevel, const char *format, ...)
+{
+	char dbgBuf[256] = { '\0' };
+	va_list var;
+	FILE *fp_log = fopen(bench_path, "a+");
+	if (fp_log == NULL) {
+		return -1;
+	}
+
+	if (VDEC_DEBUG_NONE == globalDbgLevel)
+		goto DBG_EXIT;
+	else {
+		va_start(var, format);
+		vsprintf(dbgBuf, format, var);
+		va_end(var);
+
+		if (VDEC_DEBUG_ALL & globalDbgLevel)
+			goto DBG_PRINT;
+		else if ((VDEC_DEBUG_MEM & globalDbgLevel)
+			 && (dbglevel == VDEC_DEBUG_MEM))
+			goto DBG_PRINT;
+		else if ((VDEC_DEBUG_LOCK & globalDbgLevel)
+			 && (dbglevel == VDEC_DEBUG_LOCK))
+			goto DBG_PRINT;
+		else if ((VDEC_DEBUG_VER & globalDbgLevel)
+			 && (dbglevel == VDEC_DEBUG_VER))
+			goto DBG_PRINT;
+		else if ((VDEC_DEBUG_POWER & globalDbgLevel)
+			 && (dbglevel == VDEC_DEBUG_POWER))
+			goto DBG_PRINT;
+		else
+			goto DBG_EXIT;
+	}
+DBG_PRINT:
+	fprintf(fp_log, "%s", dbgBuf);
+
+DBG_EXIT:
+	fclose(fp_log);
+	return 0;
+}
+
+static double now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void report(const char *name, double ns, int calls)
+{
+	double per_call = ns / calls;
+
+	printf("%-30s %10.0f ns/call %8.3f%% CPU at 1080p60\n", name,
+	       per_call, per_call * BENCH_CALLS_PER_SEC / 1e7);
+}
+
+static void run_legacy(const char *name, UNSG32 level, int calls)
+{
+	double t;
+	int i;
+
+	globalDbgLevel = level;
+	t = now_ns();
+	for (i = 0; i < calls; i++)
+		legacy_dbg_printf(VDEC_DEBUG_LOCK, "lock: id %d frame %d\n",
+				  i & 7, i / BENCH_CALLS_PER_FRAME);
+	report(name, now_ns() - t, calls);
+}
+
+static void run_async(const char *name, UNSG32 level, int calls)
+{
+	double t, ns = 0;
+	int i, j, n;
+
+	vmeta_log_set_level(level);
+	for (i = 0; i < calls; i += n) {
+		n = calls - i;
+		if (n > BENCH_CALLS_PER_SEC / 10)
+			n = BENCH_CALLS_PER_SEC / 10;
+		t = now_ns();
+		for (j = i; j < i + n; j++)
+			dbg_printf(VDEC_DEBUG_LOCK, "lock: id %d frame %d\n",
+				   j & 7, j / BENCH_CALLS_PER_FRAME);
+		ns += now_ns() - t;
+		// the rest of the 100 ms of decoding the drain thread runs in
+		usleep(1000);
+	}
+	report(name, ns, calls);
+	vmeta_log_flush();
+}
+
+int main(int argc, char *argv[])
+{
+	int calls = 20000;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:f:")) != -1) {
+		switch (opt) {
+		case 'n':
+			calls = atoi(optarg);
+			break;
+		case 'f':
+			bench_path = optarg;
+			break;
+		default:
+			fprintf(stderr,
+				"usage: %s [-n calls] [-f log file]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (calls <= 0)
+		calls = 1;
+
+	vmeta_log_set_file(bench_path, 0);
+	printf("%d calls, %d calls/s at 1080p60\n", calls,
+	       BENCH_CALLS_PER_SEC);
+	run_legacy("legacy, level none", VDEC_DEBUG_NONE, calls);
+	run_legacy("legacy, level lock", VDEC_DEBUG_LOCK, calls);
+	run_async("async, level none", VDEC_DEBUG_NONE, calls);
+	run_async("async, level power (filtered)", VDEC_DEBUG_POWER, calls);
+	run_async("async, level lock", VDEC_DEBUG_LOCK, calls);
+	unlink(bench_path);
+	return 0;
+}
@@ -0,0 +1,369 @@
+/*
+ *  vmeta_open_bench.c
+ *
+ *  Measures the cost of opening the vmeta driver as a player prepare does:
+ *  init, hardware object, hardware context and kernel share page, then
+ *  clean. Runs against a fake uio device and sysfs tree in a temporary
+ *  directory, and compares the former discovery, which read each sysfs
+ *  value through its own fopen/fscanf/fclose, with the cached topology,
+ *  with and without the mappings kept between instances. vmeta_lib.c keeps
+ *  its mapping addresses in 32 bits, so the bench only builds for 32-bit
+ *  targets.
+ *
+ *  Build: cc -m32 -O2 -I../phycontmem-lib/phycontmem
+ *         -o vmeta_open_bench vmeta_open_bench.c vmeta_lib.c vmeta_lock.c
+ *         vmeta_log.c vmeta_watch.c -lpthread
+ *  Usage: vmeta_open_bench [-n opens] [-d temp dir]
+ *
+ * Copyright (C) 2009 Marvell International Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <sys/stat.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+
+#include "vmeta_lib.h"
+
+#if defined(__LP64__) || defined(_WIN64)
+#error "vmeta_lib.c stores mapping addresses in SIGN32, build the bench for a 32-bit target"
+#endif
+
+#ifndef VMETA_KEEP_MAPPINGS
+#define VMETA_KEEP_MAPPINGS 1
+#endif
+
+#define BENCH_OBJ_SIZE		(512 * 1024)	// hardware object a decoder asks for
+#define BENCH_DEV_SIZE		(4 * 1024 * 1024)
+
+static const UNSG32 bench_map_addr[UIO_IO_MAP_NUM] = {
+	0xd420d000, 0x0a000000, 0x0b000000, 0x0c000000
+};
+static const UNSG32 bench_map_size[UIO_IO_MAP_NUM] = {
+	0x1000, 0x100000, 0x100000, 0x1000
+};
+
+// exported by vmeta_lib.c without a declaration in vmeta_lib.h
+int get_version(char *msg);
+UNSG32 get_mem_size(char *msg);
+UNSG32 get_mem_addr(char *msg);
+
+static char bench_dir[256];
+static char bench_dev[300];
+static char bench_sysfs[300];
+static int failures;
+
+/*
+ * The driver talks to libphycontmem for frame buffers only, which opening
+ * the driver never allocates.
+ */
+void *phy_cont_malloc(int size, int attr)
+{
+	return NULL;
+}
+
+void phy_cont_free(void *VA)
+{
+}
+
+unsigned int phy_cont_getpa(void *VA)
+{
+	return 0;
+}
+
+void *phy_cont_getva(unsigned int PA)
+{
+	return NULL;
+}
+
+void phy_cont_flush_cache(void *VA, int dir)
+{
+}
+
+void phy_cont_flush_cache_range(void *VA, unsigned long size, int dir)
+{
+}
+
+void phy_cont_mark_dirty(void *VA, unsigned long size)
+{
+}
+
+static double now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void check(int ok, const char *what)
+{
+	printf("  %-52s %s\n", what, ok ? "ok" : "FAIL");
+	if (!ok)
+		failures++;
+}
+
+static int write_file(const char *dir, const char *name, const char *fmt,
+		      UNSG32 val)
+{
+	char path[400];
+	FILE *fp;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, name);
+	fp = fopen(path, "w");
+	if (!fp)
+		return -1;
+	fprintf(fp, fmt, val);
+	fprintf(fp, "\n");
+	fclose(fp);
+	return 0;
+}
+
+/* uio0 as the vmeta kernel driver lays it out, backed by a plain file */
+static int make_tree(const char *tmp)
+{
+	char path[400];
+	int fd, i, ret = 0;
+
+	snprintf(bench_dir, sizeof(bench_dir), "%s/vmeta_uio.XXXXXX", tmp);
+	if (!mkdtemp(bench_dir))
+		return -1;
+	snprintf(bench_dev, sizeof(bench_dev), "%s/uio0", bench_dir);
+	snprintf(bench_sysfs, sizeof(bench_sysfs), "%s/sysfs", bench_dir);
+
+	fd = open(bench_dev, O_RDWR | O_CREAT, 0600);
+	if (fd < 0 || ftruncate(fd, BENCH_DEV_SIZE) != 0)
+		ret = -1;
+	if (fd >= 0)
+		close(fd);
+
+	snprintf(path, sizeof(path), "%s/maps", bench_sysfs);
+	if (mkdir(bench_sysfs, 0700) != 0 || mkdir(path, 0700) != 0)
+		return -1;
+	ret |= write_file(bench_sysfs, "version", "build-%d", 6);
+	for (i = 0; i < UIO_IO_MAP_NUM; i++) {
+		snprintf(path, sizeof(path), "%s/maps/map%d", bench_sysfs, i);
+		if (mkdir(path, 0700) != 0)
+			return -1;
+		ret |= write_file(path, "addr", "0x%08x", bench_map_addr[i]);
+		ret |= write_file(path, "size", "0x%08x", bench_map_size[i]);
+	}
+	return ret;
+}
+
+static void remove_tree(void)
+{
+	char path[400];
+	int i;
+
+	for (i = 0; i < UIO_IO_MAP_NUM; i++) {
+		snprintf(path, sizeof(path), "%s/maps/map%d/addr", bench_sysfs, i);
+		unlink(path);
+		snprintf(path, sizeof(path), "%s/maps/map%d/size", bench_sysfs, i);
+		unlink(path);
+		snprintf(path, sizeof(path), "%s/maps/map%d", bench_sysfs, i);
+		rmdir(path);
+	}
+	snprintf(path, sizeof(path), "%s/maps", bench_sysfs);
+	rmdir(path);
+	snprintf(path, sizeof(path), "%s/version", bench_sysfs);
+	unlink(path);
+	rmdir(bench_sysfs);
+	unlink(bench_dev);
+	rmdir(bench_dir);
+}
+
+/* get_mem_size/get_mem_addr/get_version as they were before the cache */
+static UNSG32 legacy_get_mem(const char *fmt, int map, const char *what)
+{
+	char path[400];
+	UNSG32 result;
+	FILE *file;
+
+	snprintf(path, sizeof(path), fmt, bench_sysfs, map, what);
+	file = fopen(path, "r");
+	if (!file)
+		return -VDEC_OS_DRIVER_OPEN_FAIL;
+	if (fscanf(file, "0x%x", &result) < 0)
+		result = 0;
+	fclose(file);
+	return result;
+}
+
+static int legacy_get_version(void)
+{
+	char path[400];
+	int version;
+	FILE *file;
+
+	snprintf(path, sizeof(path), "%s/version", bench_sysfs);
+	file = fopen(path, "r");
+	if (!file)
+		return -1;
+	if (fscanf(file, "build-%d", &version) < 0)
+		version = -1;
+	fclose(file);
+	return version;
+}
+
+/* the sysfs reads of one driver open before the cache */
+static UNSG32 legacy_discovery(void)
+{
+	const char *fmt = "%s/maps/map%d/%s";
+	UNSG32 sum = legacy_get_version();
+
+	sum += legacy_get_mem(fmt, UIO_IO_MEM_INDEX, "size");
+	sum += legacy_get_mem(fmt, UIO_IO_MEM_INDEX, "addr");
+	sum += legacy_get_mem(fmt, UIO_IO_VMETA_OBJ_INDEX, "size");
+	sum += legacy_get_mem(fmt, UIO_IO_HW_CONTEXT_INDEX, "size");
+	sum += legacy_get_mem(fmt, UIO_IO_HW_CONTEXT_INDEX, "addr");
+	sum += legacy_get_mem(fmt, UIO_IO_KERNEL_SHARE_INDEX, "size");
+	return sum;
+}
+
+/* what a player prepare and release ask of the driver */
+static int driver_open(void)
+{
+	UNSG32 obj_va, ctx_pa, ctx_va;
+
+	if (vdec_os_driver_init() != 0)
+		return -1;
+	if (vdec_os_api_get_hw_obj_addr(&obj_va, BENCH_OBJ_SIZE) != 0 ||
+	    vdec_os_api_get_hw_context_addr(&ctx_pa, &ctx_va,
+					    bench_map_size[1], 0) != 0 ||
+	    vdec_os_api_get_user_count() != 0) {
+		vdec_os_driver_clean();
+		return -1;
+	}
+	return vdec_os_driver_clean();
+}
+
+static void report(const char *name, double ns, int opens)
+{
+	printf("%-36s %10.0f ns/open\n", name, ns / opens);
+}
+
+static double run_legacy(int opens)
+{
+	volatile UNSG32 sink = 0;
+	double t;
+	int i;
+
+	t = now_ns();
+	for (i = 0; i < opens; i++)
+		sink += legacy_discovery();
+	t = now_ns() - t;
+	report("sysfs reads only, stdio per value", t, opens);
+	return t;
+}
+
+static double run_open(const char *name, int cached, int opens)
+{
+	double t, ns = 0;
+	int i, bad = 0;
+
+	for (i = 0; i < opens; i++) {
+		// dropping the cache also drops the kept mappings
+		if (!cached || i == 0)
+			vdec_os_driver_set_uio(bench_dev, bench_sysfs);
+		t = now_ns();
+		bad += driver_open() != 0;
+		ns += now_ns() - t;
+	}
+	report(name, ns, opens);
+	check(bad == 0, "every open succeeded");
+	return ns;
+}
+
+int main(int argc, char *argv[])
+{
+	const char *tmp = getenv("TMPDIR");
+	double legacy, cold, warm;
+	UNSG32 obj_va, obj_grown;
+	char path[400];
+	int opens = 2000;
+	int ok;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:d:")) != -1) {
+		switch (opt) {
+		case 'n':
+			opens = atoi(optarg);
+			break;
+		case 'd':
+			tmp = optarg;
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-n opens] [-d temp dir]\n",
+				argv[0]);
+			return 1;
+		}
+	}
+	if (opens <= 0)
+		opens = 1;
+
+	if (make_tree(tmp ? tmp : "/tmp") != 0) {
+		perror("fake uio tree");
+		remove_tree();
+		return 1;
+	}
+	printf("%d opens against %s, mappings %s between instances\n", opens,
+	       bench_dir, VMETA_KEEP_MAPPINGS ? "kept" : "dropped");
+
+	legacy = run_legacy(opens);
+	cold = run_open("open, topology and mappings dropped", 0, opens);
+	warm = run_open("open, back to back", 1, opens);
+	printf("back to back: %.1fx faster than a cold open, sysfs reads alone"
+	       " were %.1fx\n", cold / warm, legacy / warm);
+
+	snprintf(path, sizeof(path), "%s/maps/map%d/size", bench_sysfs,
+		 UIO_IO_HW_CONTEXT_INDEX);
+	ok = get_mem_size(path) == bench_map_size[UIO_IO_HW_CONTEXT_INDEX];
+	snprintf(path, sizeof(path), "%s/maps/map%d/addr", bench_sysfs,
+		 UIO_IO_HW_CONTEXT_INDEX);
+	ok = ok && get_mem_addr(path) == bench_map_addr[UIO_IO_HW_CONTEXT_INDEX];
+	snprintf(path, sizeof(path), "%s/version", bench_sysfs);
+	check(ok && get_version(path) == 6, "exported getters read the topology");
+
+	// a live instance keeps what it was handed, a kept object can grow
+	vdec_os_driver_set_uio(bench_dev, bench_sysfs);
+	ok = vdec_os_driver_init() == 0 &&
+	     vdec_os_api_get_hw_obj_addr(&obj_va, BENCH_OBJ_SIZE / 2) == 0 &&
+	     vdec_os_api_get_hw_obj_addr(&obj_grown, BENCH_OBJ_SIZE) == 0 &&
+	     obj_grown == obj_va;
+	vdec_os_driver_clean();
+	check(ok, "a live instance keeps its hardware object");
+	ok = vdec_os_driver_init() == 0 &&
+	     vdec_os_api_get_hw_obj_addr(&obj_grown, BENCH_OBJ_SIZE) == 0 &&
+	     vdec_driver_get_cb()->vdec_obj_size == BENCH_OBJ_SIZE;
+	vdec_os_driver_clean();
+	check(ok, "a kept hardware object is remapped when too small");
+
+	check(vdec_os_driver_init() == 0 &&
+	      vdec_os_driver_set_uio(NULL, NULL) != 0 &&
+	      vdec_os_driver_clean() == 0, "device kept while in use");
+	// the kept mappings go with the cache
+	check(vdec_os_driver_set_uio(NULL, NULL) == 0, "cache dropped when idle");
+
+	remove_tree();
+	printf("%d failed\n", failures);
+	return failures;
+}
@@ -0,0 +1,432 @@
+/*
+ *  vmeta_watch.c
+ *
+ *  Liveness watcher of the vmeta users. One thread per process looks after
+ *  every entry of kernel_share->user_id_list. An entry whose process is
+ *  gone is handed to the reclaim callback and cleared. With
+ *  VMETA_WATCH_THREADS, the users of this process are also reclaimed when
+ *  the thread that registered them exits, even though other threads of the
+ *  process may still use the engine. Exits are seen through pidfds in an
+ *  epoll set when the kernel has them, and by a periodic /proc sweep
+ *  otherwise.
+ *
+ * Copyright (C) 2009 Marvell International Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+
+#include "vmeta_lib.h"
+
+#ifndef __NR_pidfd_open
+#define __NR_pidfd_open		434
+#endif
+#ifndef PIDFD_THREAD
+#define PIDFD_THREAD		O_EXCL
+#endif
+
+#define VMETA_WATCH_POLL_MS	500	// sweep period, also finds new users of other processes
+#define WATCH_WAKE		MAX_VMETA_INSTANCE	// epoll tag of the wake-up eventfd
+
+typedef struct {
+	pid_t pid;	// process or thread watched, 0 if none
+	int own;	// pid is a thread of this process
+	int fd;		// pidfd, -1 when checked through /proc
+} watch_target;
+
+static struct {
+	pthread_mutex_t lock;
+	pthread_t thread;
+	int running;
+	int epfd;
+	int wakefd;
+	UNSG32 flags;
+	kernel_share *p_ks;
+	vmeta_watch_reclaim_fn reclaim;
+	pid_t owner_tid[MAX_VMETA_INSTANCE];	// thread that registered each of our users
+	watch_target target[MAX_VMETA_INSTANCE];
+} watch = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.epfd = -1,
+	.wakefd = -1,
+};
+
+// what the kernel turned out to support
+static int watch_pidfd_ok = 1;
+static int watch_thread_pidfd_ok = 1;
+static int watch_atfork_set;
+
+static pid_t watch_gettid(void)
+{
+	return (pid_t)syscall(__NR_gettid);
+}
+
+static int watch_pidfd(pid_t pid, int own)
+{
+	int fd;
+
+	if ((watch.flags & VMETA_WATCH_NO_PIDFD) || !watch_pidfd_ok ||
+	    (own && !watch_thread_pidfd_ok))
+		return -1;
+	fd = syscall(__NR_pidfd_open, pid, own ? PIDFD_THREAD : 0);
+	if (fd >= 0) {
+		fcntl(fd, F_SETFD, FD_CLOEXEC);
+		return fd;
+	}
+	if (errno == ENOSYS) {
+		dbg_printf(VDEC_DEBUG_LOCK, "watch: no pidfd, polling /proc\n");
+		watch_pidfd_ok = 0;
+	} else if (own && errno == EINVAL) {
+		dbg_printf(VDEC_DEBUG_LOCK,
+			   "watch: no thread pidfd, polling /proc\n");
+		watch_thread_pidfd_ok = 0;
+	}
+	return -1;
+}
+
+/* gone, or exited and not reaped yet */
+static int watch_proc_dead(pid_t pid, int own)
+{
+	char path[64], buf[256], *state;
+	int fd, n;
+
+	if (own)
+		snprintf(path, sizeof(path), "/proc/self/task/%d/stat", pid);
+	else
+		snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return errno == ENOENT || errno == ESRCH;
+	n = read(fd, buf, sizeof(buf) - 1);
+	close(fd);
+	if (n <= 0)
+		return n == 0 || errno == ESRCH;
+	buf[n] = '\0';
+
+	// the state follows the command name, which may hold anything
+	state = strrchr(buf, ')');
+	return state && state[1] == ' ' && (state[2] == 'Z' || state[2] == 'X');
+}
+
+static int watch_dead(watch_target *t)
+{
+	struct pollfd pfd;
+
+	if (t->fd < 0)
+		return watch_proc_dead(t->pid, t->own);
+	pfd.fd = t->fd;
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+	return poll(&pfd, 1, 0) > 0;
+}
+
+static void watch_set_target(SIGN32 user_id, pid_t pid, int own)
+{
+	watch_target *t = &watch.target[user_id];
+	struct epoll_event ev;
+
+	if (t->pid == pid && t->own == own)
+		return;
+	if (t->fd >= 0) {
+		if (watch.epfd >= 0)
+			epoll_ctl(watch.epfd, EPOLL_CTL_DEL, t->fd, &ev);
+		close(t->fd);
+	}
+	t->pid = pid;
+	t->own = own;
+	t->fd = -1;
+	if (!pid)
+		return;
+
+	t->fd = watch_pidfd(pid, own);
+	if (t->fd >= 0 && watch.epfd >= 0) {
+		memset(&ev, 0, sizeof(ev));
+		ev.events = EPOLLIN;
+		ev.data.u32 = user_id;
+		if (epoll_ctl(watch.epfd, EPOLL_CTL_ADD, t->fd, &ev) != 0) {
+			close(t->fd);
+			t->fd = -1;
+		}
+	}
+}
+
+/* same as vmeta_lib.c, only one of unregister and the watchers sees it set */
+static inline int clear_bit(int nr, unsigned int *addr)
+{
+	unsigned int mask = 1 << nr;
+
+	return (__sync_fetch_and_and(addr, ~mask) & mask) != 0;
+}
+
+/*
+ * The user's thread or process is gone. Whoever swaps the pid out of the
+ * entry first reclaims it, so watchers of several processes seeing the
+ * same death clean up once.
+ */
+static SIGN32 watch_claim(SIGN32 user_id, pid_t pid, int own)
+{
+	kernel_share *p_ks = watch.p_ks;
+	id_instance *p = &p_ks->user_id_list[user_id];
+
+	if (!__sync_bool_compare_and_swap(&p->pid, pid, 0))
+		return 0;
+	dbg_printf(VDEC_DEBUG_LOCK, "watch: %s %d of user id %d is gone\n",
+		   own ? "thread" : "pid", own ? watch.target[user_id].pid : pid,
+		   user_id);
+
+	if (watch.reclaim)
+		watch.reclaim(p_ks, user_id, pid, own);
+	if (clear_bit(VMETA_STATUS_BIT_REGISTED, &p->status) == 1)
+		__sync_fetch_and_sub(&p_ks->ref_count, 1);
+	memset(&p->info, 0, sizeof(p->info));
+	p->frame_rate = 0;
+	p->pt = 0;
+	__sync_synchronize();
+	p->status = 0;
+
+	watch.owner_tid[user_id] = 0;
+	watch_set_target(user_id, 0, 0);
+	return 1;
+}
+
+/* bring the targets in line with the share page and reclaim the dead */
+static SIGN32 watch_sweep_locked(void)
+{
+	kernel_share *p_ks = watch.p_ks;
+	pid_t self = getpid();
+	SIGN32 i, reclaimed = 0;
+	id_instance *p;
+	pid_t pid;
+
+	if (!p_ks)
+		return 0;
+	for (i = 0; i < MAX_VMETA_INSTANCE; i++) {
+		p = &p_ks->user_id_list[i];
+		pid = p->pid;
+		if (!p->status || !pid) {
+			watch.owner_tid[i] = 0;
+			watch_set_target(i, 0, 0);
+			continue;
+		}
+		if (pid == self) {
+			// our own users live as long as we do, or as their thread
+			if (watch.flags & VMETA_WATCH_THREADS)
+				watch_set_target(i, watch.owner_tid[i], 1);
+			else
+				watch_set_target(i, 0, 0);
+		} else {
+			watch.owner_tid[i] = 0;
+			watch_set_target(i, pid, 0);
+		}
+		if (watch.target[i].pid && watch_dead(&watch.target[i]))
+			reclaimed += watch_claim(i, pid, pid == self);
+	}
+	return reclaimed;
+}
+
+static void watch_wake(void)
+{
+	eventfd_t one = 1;
+
+	if (watch.wakefd >= 0 && write(watch.wakefd, &one, sizeof(one)) < 0)
+		dbg_printf(VDEC_DEBUG_LOCK, "watch: wake error %d\n", errno);
+}
+
+static void *watch_thread(void *arg)
+{
+	struct epoll_event ev[8];
+	eventfd_t v;
+	int n, i;
+
+	pthread_mutex_lock(&watch.lock);
+	while (watch.running) {
+		watch_sweep_locked();
+		pthread_mutex_unlock(&watch.lock);
+
+		if (watch.epfd >= 0) {
+			n = epoll_wait(watch.epfd, ev, 8, VMETA_WATCH_POLL_MS);
+			for (i = 0; i < n; i++)
+				if (ev[i].data.u32 == WATCH_WAKE &&
+				    read(watch.wakefd, &v, sizeof(v)) < 0)
+					break;
+		} else {
+			usleep(VMETA_WATCH_POLL_MS * 1000);
+		}
+
+		pthread_mutex_lock(&watch.lock);
+	}
+	pthread_mutex_unlock(&watch.lock);
+	return arg;
+}
+
+static void watch_close_locked(void)
+{
+	SIGN32 i;
+
+	for (i = 0; i < MAX_VMETA_INSTANCE; i++) {
+		watch_set_target(i, 0, 0);
+		watch.owner_tid[i] = 0;
+	}
+	if (watch.epfd >= 0)
+		close(watch.epfd);
+	if (watch.wakefd >= 0)
+		close(watch.wakefd);
+	watch.epfd = watch.wakefd = -1;
+	watch.p_ks = NULL;
+	watch.reclaim = NULL;
+}
+
+/*
+ * The watcher thread does not survive fork. The epoll set is shared with
+ * the parent, so it is closed before the pidfds to leave the parent's
+ * set alone.
+ */
+static void watch_atfork_child(void)
+{
+	pthread_mutex_init(&watch.lock, NULL);
+	watch.running = 0;
+	if (watch.epfd >= 0)
+		close(watch.epfd);
+	watch.epfd = -1;
+	watch_close_locked();
+}
+
+/*
+ * Start the watcher of this process over p_ks, if not started yet.
+ * reclaim is called for every user found gone, before its entry is
+ * cleared.
+ */
+SIGN32 vmeta_watch_start(kernel_share *p_ks, vmeta_watch_reclaim_fn reclaim,
+			 UNSG32 flags)
+{
+	struct epoll_event ev;
+	SIGN32 i;
+
+	pthread_mutex_lock(&watch.lock);
+	if (watch.running) {
+		pthread_mutex_unlock(&watch.lock);
+		return 0;
+	}
+	if (!watch_atfork_set) {
+		pthread_atfork(NULL, NULL, watch_atfork_child);
+		watch_atfork_set = 1;
+	}
+
+	watch.p_ks = p_ks;
+	watch.reclaim = reclaim;
+	watch.flags = flags;
+	for (i = 0; i < MAX_VMETA_INSTANCE; i++) {
+		watch.target[i].pid = 0;
+		watch.target[i].own = 0;
+		watch.target[i].fd = -1;
+	}
+
+	watch.epfd = epoll_create(MAX_VMETA_INSTANCE + 1);
+	watch.wakefd = eventfd(0, 0);
+	if (watch.epfd >= 0) {
+		fcntl(watch.epfd, F_SETFD, FD_CLOEXEC);
+		memset(&ev, 0, sizeof(ev));
+		ev.events = EPOLLIN;
+		ev.data.u32 = WATCH_WAKE;
+		if (watch.wakefd < 0 ||
+		    epoll_ctl(watch.epfd, EPOLL_CTL_ADD, watch.wakefd, &ev) != 0) {
+			// no way to wake the thread early, it still sweeps
+			if (watch.wakefd >= 0)
+				close(watch.wakefd);
+			watch.wakefd = -1;
+		}
+	}
+	if (watch.wakefd >= 0)
+		fcntl(watch.wakefd, F_SETFD, FD_CLOEXEC);
+
+	watch.running = 1;
+	if (pthread_create(&watch.thread, NULL, watch_thread, NULL) != 0) {
+		dbg_printf(VDEC_DEBUG_LOCK, "watch: no thread\n");
+		watch.running = 0;
+		watch_close_locked();
+		pthread_mutex_unlock(&watch.lock);
+		return -1;
+	}
+	pthread_mutex_unlock(&watch.lock);
+	return 0;
+}
+
+/* stop the watcher thread; the share page may go away after this */
+void vmeta_watch_stop(void)
+{
+	pthread_mutex_lock(&watch.lock);
+	if (!watch.running) {
+		pthread_mutex_unlock(&watch.lock);
+		return;
+	}
+	watch.running = 0;
+	watch_wake();
+	pthread_mutex_unlock(&watch.lock);
+
+	pthread_join(watch.thread, NULL);
+
+	pthread_mutex_lock(&watch.lock);
+	watch_close_locked();
+	pthread_mutex_unlock(&watch.lock);
+}
+
+/*
+ * user_id was registered by the calling thread: with VMETA_WATCH_THREADS,
+ * reclaim it if the thread exits
+ */
+void vmeta_watch_add(SIGN32 user_id)
+{
+	if (user_id < 0 || user_id >= MAX_VMETA_INSTANCE)
+		return;
+	pthread_mutex_lock(&watch.lock);
+	watch.owner_tid[user_id] = watch_gettid();
+	watch_wake();
+	pthread_mutex_unlock(&watch.lock);
+}
+
+/* user_id was unregistered by its owner */
+void vmeta_watch_remove(SIGN32 user_id)
+{
+	if (user_id < 0 || user_id >= MAX_VMETA_INSTANCE)
+		return;
+	pthread_mutex_lock(&watch.lock);
+	watch.owner_tid[user_id] = 0;
+	if (watch.running)
+		watch_set_target(user_id, 0, 0);
+	pthread_mutex_unlock(&watch.lock);
+}
+
+/* one sweep right now, returns the number of users reclaimed */
+SIGN32 vmeta_watch_sweep(void)
+{
+	SIGN32 reclaimed;
+
+	pthread_mutex_lock(&watch.lock);
+	reclaimed = watch.running ? watch_sweep_locked() : 0;
+	pthread_mutex_unlock(&watch.lock);
+	return reclaimed;
+}
@@ -0,0 +1,400 @@
+/*
+ *  vmeta_watch_stress.c
+ *
+ *  Injects crashes under the user watcher of vmeta_watch.c over a simulated
+ *  kernel share page: killed processes, zombies nobody reaped, threads that
+ *  exit without unregistering (reclaimed with VMETA_WATCH_THREADS only),
+ *  and several watchers racing for the same dead users. Runs with pidfds and with the /proc sweep. Exits with the
+ *  number of failed checks.
+ *
+ *  Build: cc -O2 -o vmeta_watch_stress vmeta_watch_stress.c vmeta_watch.c
+ *         vmeta_log.c -lpthread
+ *  Usage: vmeta_watch_stress [-w watchers] [-n users]
+ *
+ * Copyright (C) 2009 Marvell International Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <signal.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "vmeta_lib.h"
+
+#define STRESS_MAX_WATCHERS	8
+#define STRESS_WAIT_MS		3000	// longest wait for a reclaim
+
+UNSG32 globalDbgLevel = VDEC_DEBUG_NONE;
+
+// shared by all processes, next to the simulated kernel share page
+typedef struct {
+	volatile UNSG32 reclaims;
+	volatile UNSG32 reclaimed[MAX_VMETA_INSTANCE];	// per user id
+	volatile UNSG32 own;				// reclaims of own threads
+	volatile SIGN32 ref_at_reclaim;	// ref_count seen by the last reclaim
+} stress_stats;
+
+static kernel_share *ks;
+static stress_stats *st;
+static UNSG32 watch_flags;
+static int failures;
+
+static UNSG32 now_ms(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void check(int ok, const char *what)
+{
+	printf("  %-52s %s\n", what, ok ? "ok" : "FAIL");
+	if (!ok)
+		failures++;
+}
+
+static void reset(void)
+{
+	memset(ks, 0, sizeof(*ks));
+	ks->active_user_id = MAX_VMETA_INSTANCE;
+	memset(st, 0, sizeof(*st));
+}
+
+static void reclaim(kernel_share *p_ks, SIGN32 user_id, pid_t pid, SIGN32 own)
+{
+	(void)pid;
+	__sync_fetch_and_add(&st->reclaims, 1);
+	__sync_fetch_and_add(&st->reclaimed[user_id], 1);
+	if (own)
+		__sync_fetch_and_add(&st->own, 1);
+	st->ref_at_reclaim = p_ks->ref_count;
+}
+
+/* what vdec_os_api_get_user_id and vdec_os_api_register_user_id leave */
+static void stress_register(SIGN32 id)
+{
+	id_instance *p = &ks->user_id_list[id];
+
+	p->pid = getpid();
+	p->pt = (unsigned int)pthread_self();
+	__sync_fetch_and_add(&ks->ref_count, 1);
+	__sync_fetch_and_or(&p->status, (1 << VMETA_STATUS_BIT_USED) |
+			    (1 << VMETA_STATUS_BIT_REGISTED));
+	vmeta_watch_add(id);
+}
+
+/* and what vdec_os_api_unregister_user_id and vdec_os_api_free_user_id do */
+static void stress_unregister(SIGN32 id)
+{
+	id_instance *p = &ks->user_id_list[id];
+
+	__sync_fetch_and_and(&p->status, ~(1 << VMETA_STATUS_BIT_REGISTED));
+	__sync_fetch_and_sub(&ks->ref_count, 1);
+	vmeta_watch_remove(id);
+	p->pid = 0;
+	__sync_fetch_and_and(&p->status, ~(1 << VMETA_STATUS_BIT_USED));
+}
+
+/* wait until count users are reclaimed, returns the time it took */
+static UNSG32 wait_reclaims(UNSG32 count)
+{
+	UNSG32 start = now_ms();
+
+	while (st->reclaims < count && now_ms() - start < STRESS_WAIT_MS)
+		usleep(1000);
+	return now_ms() - start;
+}
+
+static int user_free(SIGN32 id)
+{
+	return ks->user_id_list[id].status == 0 &&
+	    ks->user_id_list[id].pid == 0;
+}
+
+static pid_t spawn(void (*fn)(SIGN32, int), SIGN32 id, int arg)
+{
+	pid_t pid = fork();
+
+	if (pid == 0) {
+		fn(id, arg);
+		_exit(0);
+	}
+	return pid;
+}
+
+static void reap(pid_t pid)
+{
+	waitpid(pid, NULL, 0);
+}
+
+/* registers users id .. id + count - 1, then waits to be killed */
+static void victim(SIGN32 id, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++)
+		stress_register(id + i);
+	for (;;)
+		pause();
+}
+
+/* registers a user and exits without unregistering it */
+static void quitter(SIGN32 id, int unused)
+{
+	(void)unused;
+	stress_register(id);
+}
+
+/* watches until the users id .. id + count - 1 are gone */
+static void watcher(SIGN32 id, int count)
+{
+	UNSG32 start = now_ms();
+	int i, left;
+
+	vmeta_watch_start(ks, reclaim, watch_flags);
+	do {
+		usleep(1000);
+		for (i = left = 0; i < count; i++)
+			left += !user_free(id + i);
+	} while (left && now_ms() - start < STRESS_WAIT_MS);
+	vmeta_watch_stop();
+}
+
+static void test_dead_process(void)
+{
+	pid_t killed, zombie, alive;
+	UNSG32 ms;
+
+	printf("dead processes\n");
+	reset();
+	vmeta_watch_start(ks, reclaim, watch_flags);
+
+	killed = spawn(victim, 0, 2);
+	alive = spawn(victim, 2, 1);
+	usleep(20000);
+	kill(killed, SIGKILL);
+	ms = wait_reclaims(2);
+	printf("  killed process reclaimed in %u ms\n", ms);
+	check(st->reclaimed[0] == 1 && st->reclaimed[1] == 1,
+	      "users of a killed process reclaimed");
+	check(user_free(0) && user_free(1), "their entries cleared");
+	check(st->ref_at_reclaim >= 1, "reclaim sees the entry still counted");
+
+	// exited, not waited for: the pid stays taken until reaped
+	zombie = spawn(quitter, 3, 0);
+	ms = wait_reclaims(3);
+	printf("  zombie reclaimed in %u ms\n", ms);
+	check(st->reclaimed[3] == 1 && user_free(3),
+	      "user of an unreaped process reclaimed");
+
+	check(st->reclaimed[2] == 0 && !user_free(2),
+	      "user of a live process kept");
+	check(ks->ref_count == 1, "ref_count counts the live user only");
+	check(st->own == 0, "none taken for own threads");
+
+	kill(alive, SIGKILL);
+	reap(alive);
+	reap(killed);
+	reap(zombie);
+	wait_reclaims(4);
+	check(ks->ref_count == 0, "ref_count back to 0");
+	vmeta_watch_stop();
+}
+
+static void *thread_quit(void *arg)
+{
+	stress_register((SIGN32)(long)arg);
+	return NULL;
+}
+
+static void *thread_clean(void *arg)
+{
+	stress_register((SIGN32)(long)arg);
+	stress_unregister((SIGN32)(long)arg);
+	return NULL;
+}
+
+static int hold_pipe[2];
+
+static void *thread_hold(void *arg)
+{
+	char c;
+
+	stress_register((SIGN32)(long)arg);
+	if (read(hold_pipe[0], &c, 1) < 0)
+		return NULL;
+	stress_unregister((SIGN32)(long)arg);
+	return NULL;
+}
+
+static void test_dead_thread(void)
+{
+	pthread_attr_t attr;
+	pthread_t t, held;
+	UNSG32 ms;
+
+	printf("dead threads of this process, threads watched\n");
+	reset();
+	vmeta_watch_start(ks, reclaim, watch_flags | VMETA_WATCH_THREADS);
+	if (pipe(hold_pipe) != 0) {
+		check(0, "pipe");
+		return;
+	}
+
+	pthread_create(&held, NULL, thread_hold, (void *)4L);
+	pthread_create(&t, NULL, thread_clean, (void *)5L);
+	pthread_join(t, NULL);
+
+	pthread_create(&t, NULL, thread_quit, (void *)6L);
+	pthread_join(t, NULL);
+	ms = wait_reclaims(1);
+	printf("  exited thread reclaimed in %u ms\n", ms);
+	check(st->reclaimed[6] == 1 && user_free(6),
+	      "user of an exited thread reclaimed");
+
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	pthread_create(&t, &attr, thread_quit, (void *)7L);
+	pthread_attr_destroy(&attr);
+	ms = wait_reclaims(2);
+	printf("  detached thread reclaimed in %u ms\n", ms);
+	check(st->reclaimed[7] == 1 && user_free(7),
+	      "user of a detached thread reclaimed");
+	check(st->own == 2, "both taken as own threads");
+
+	// one more sweep period for anything wrongly taken
+	usleep(600 * 1000);
+	check(st->reclaimed[5] == 0 && user_free(5),
+	      "cleanly unregistered user left alone");
+	check(st->reclaimed[4] == 0 && !user_free(4),
+	      "user of a live thread kept");
+	check(ks->ref_count == 1, "ref_count counts the live user only");
+
+	if (write(hold_pipe[1], "", 1) != 1)
+		check(0, "pipe write");
+	pthread_join(held, NULL);
+	close(hold_pipe[0]);
+	close(hold_pipe[1]);
+	check(st->reclaims == 2 && ks->ref_count == 0,
+	      "unregistered on its own, ref_count back to 0");
+	vmeta_watch_stop();
+}
+
+/* by default a user lives as long as its process, whatever its thread does */
+static void test_thread_default(void)
+{
+	pthread_t t;
+
+	printf("dead threads of this process, process watched\n");
+	reset();
+	vmeta_watch_start(ks, reclaim, watch_flags);
+
+	pthread_create(&t, NULL, thread_quit, (void *)8L);
+	pthread_join(t, NULL);
+	// one more sweep period for anything wrongly taken
+	usleep(600 * 1000);
+	vmeta_watch_sweep();
+	check(st->reclaims == 0 && !user_free(8),
+	      "user of an exited thread kept");
+	check(ks->ref_count == 1, "ref_count still counts it");
+
+	stress_unregister(8);
+	check(ks->ref_count == 0 && user_free(8), "unregistered by another thread");
+	vmeta_watch_stop();
+}
+
+static void test_race(int watchers, int users)
+{
+	pid_t w[STRESS_MAX_WATCHERS], v;
+	int i, once = 1;
+
+	printf("%d watchers racing for %d dead users\n", watchers, users);
+	reset();
+	v = spawn(victim, 0, users);
+	usleep(20000);
+	for (i = 0; i < watchers; i++)
+		w[i] = spawn(watcher, 0, users);
+	usleep(50000);
+	kill(v, SIGKILL);
+	for (i = 0; i < watchers; i++)
+		reap(w[i]);
+	reap(v);
+
+	for (i = 0; i < users; i++)
+		once = once && st->reclaimed[i] == 1 && user_free(i);
+	check(once, "every user reclaimed exactly once");
+	check(st->reclaims == (UNSG32)users, "no extra reclaims");
+	check(ks->ref_count == 0, "ref_count back to 0");
+}
+
+int main(int argc, char *argv[])
+{
+	int watchers = 4, users = MAX_VMETA_INSTANCE;
+	int opt, mode;
+	void *p;
+
+	while ((opt = getopt(argc, argv, "w:n:")) != -1) {
+		switch (opt) {
+		case 'w':
+			watchers = atoi(optarg);
+			break;
+		case 'n':
+			users = atoi(optarg);
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-w watchers] [-n users]\n",
+				argv[0]);
+			return 1;
+		}
+	}
+	if (watchers < 2)
+		watchers = 2;
+	if (watchers > STRESS_MAX_WATCHERS)
+		watchers = STRESS_MAX_WATCHERS;
+	if (users < 1)
+		users = 1;
+	if (users > MAX_VMETA_INSTANCE)
+		users = MAX_VMETA_INSTANCE;
+
+	p = mmap(NULL, sizeof(kernel_share) + sizeof(stress_stats),
+		 PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (p == MAP_FAILED) {
+		perror("mmap");
+		return 1;
+	}
+	ks = (kernel_share *)p;
+	st = (stress_stats *)(ks + 1);
+
+	for (mode = 0; mode < 2; mode++) {
+		watch_flags = mode ? VMETA_WATCH_NO_PIDFD : 0;
+		printf("== %s\n", mode ? "/proc sweep" : "pidfd");
+		test_dead_process();
+		test_dead_thread();
+		test_thread_default();
+		test_race(watchers, users);
+	}
+
+	printf("%d failed\n", failures);
+	return failures;
+}